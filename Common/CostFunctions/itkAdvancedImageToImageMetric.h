@@ -37,6 +37,9 @@
 #include "itkAdvancedCombinationTransform.h"
 
 #include "itkMultiThreader.h"
+#include "itkWorkerThreadPool.h"
+#include "itkRegistrationProfiler.h"
+#include "itkImageSampleCache.h"
 
 namespace itk
 {
@@ -144,6 +147,7 @@ public:
   typedef typename ImageSamplerType::Pointer                      ImageSamplerPointer;
   typedef typename ImageSamplerType::OutputVectorContainerType    ImageSampleContainerType;
   typedef typename ImageSamplerType::OutputVectorContainerPointer ImageSampleContainerPointer;
+  typedef typename ImageSamplerType::ImageSampleBlockType         ImageSampleBlockType;
 
   /** Typedefs for Limiter support. */
   typedef LimiterFunctionBase< RealType, FixedImageDimension >  FixedImageLimiterType;
@@ -283,6 +287,37 @@ public:
   itkGetConstReferenceMacro( UseMultiThread, bool );
   itkBooleanMacro( UseMultiThread );
 
+  /** Select the use of the persistent WorkerThreadPool for multi-threading.
+   * If false, every threaded computation creates and joins new threads. */
+  itkSetMacro( UseThreadPool, bool );
+  itkGetConstReferenceMacro( UseThreadPool, bool );
+  itkBooleanMacro( UseThreadPool );
+
+  /** Select whether the multi-threaded implementations process the samples
+   * in blocks, see EvaluateSampleBlock(), instead of one at a time.
+   * Only metrics that implement a block path use this; default false. */
+  itkSetMacro( UseSampleBlocks, bool );
+  itkGetConstReferenceMacro( UseSampleBlocks, bool );
+  itkBooleanMacro( UseSampleBlocks );
+
+  /** Set/Get the profiler that records the time spent in sampling, transform
+   * evaluation, interpolation, Jacobian products and derivative accumulation.
+   * The transform evaluation and interpolation are only recorded separately
+   * when UseSampleBlocks is on. Default NULL: no profiling. */
+  itkSetObjectMacro( Profiler, RegistrationProfiler );
+  itkGetObjectMacro( Profiler, RegistrationProfiler );
+
+  /** Set/Get the cache for quantities per sample that do not change during
+   * a resolution. It is only used with a deterministic image sampler, see
+   * ImageSampleCache, and is cleared in Initialize(). Several metrics may
+   * share a cache. Default NULL: no caching. */
+  itkSetObjectMacro( SampleCache, ImageSampleCache );
+  itkGetObjectMacro( SampleCache, ImageSampleCache );
+
+  /** Set/Get the number of samples in a block; default 64. */
+  itkSetClampMacro( SampleBlockSize, unsigned int, 1, NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( SampleBlockSize, unsigned int );
+
   /** Contains calls from GetValueAndDerivative that are thread-unsafe,
    * together with preparation for multi-threading.
    * Note that the only reason why this function is not protected, is
@@ -401,10 +436,15 @@ protected:
   /** AccumulateDerivatives threader callback function. */
   static ITK_THREAD_RETURN_TYPE AccumulateDerivativesThreaderCallback( void * arg );
 
+  /** Execute a threader callback using the number of threads of m_Threader,
+   * either on the WorkerThreadPool or on newly spawned threads. */
+  void ExecuteThreaderCallback( ThreadFunctionType callback, void * userData ) const;
+
   /** Variables for multi-threading. */
   bool m_UseMetricSingleThreaded;
   bool m_UseMultiThread;
   bool m_UseOpenMP;
+  bool m_UseThreadPool;
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -458,6 +498,38 @@ protected:
   /** Initialize some multi-threading related parameters. */
   virtual void InitializeThreadingParameters( void ) const;
 
+  /** Variables for the evaluation of blocks of samples. */
+  bool         m_UseSampleBlocks;
+  unsigned int m_SampleBlockSize;
+
+  /** The profiler, if any. */
+  RegistrationProfiler::Pointer m_Profiler;
+
+  /** The sample cache, if any. */
+  ImageSampleCache::Pointer m_SampleCache;
+
+  /** Get the key of a cached quantity for the current sample set: the name
+   * of the quantity, the signature of the sample set, and the settings
+   * that the quantity depends on. Returns false if there is no cache, or
+   * if the image sampler does not support caching.
+   */
+  bool GetSampleCacheKey( const std::string & quantity,
+    const std::string & settings, std::string & key ) const;
+
+  /** The moving image side of a block of samples, see EvaluateSampleBlock().
+   * Every quantity is stored in its own array, with one entry per sample of
+   * the fixed image block. st_Valid is 1 for samples that map inside the
+   * moving mask and image buffer, and 0 otherwise, such that it can be used
+   * as a weight in loops over the block.
+   */
+  struct MovingImageSampleBlockType
+  {
+    std::vector< MovingImagePointType >      st_MappedPoints;
+    std::vector< RealType >                  st_MovingImageValues;
+    std::vector< MovingImageDerivativeType > st_MovingImageDerivatives;
+    std::vector< RealType >                  st_Valid;
+  };
+
   /** Protected methods ************** */
 
   /** Methods for image sampler support **********/
@@ -502,6 +574,19 @@ protected:
     const MovingImageDerivativeType & movingImageDerivative,
     DerivativeType & imageJacobian ) const;
 
+  /** Evaluate a block of samples: map all fixed image points with one call to
+   * AdvancedTransform::TransformPoints(), check the moving mask, and evaluate
+   * the moving image value and, if requested, the moving image derivative.
+   * The choice of interpolation method is made once per block instead of once
+   * per sample. Gives the same results as calling TransformPoint(),
+   * IsInsideMovingMask() and EvaluateMovingImageValueAndDerivative() for
+   * every sample, and returns the number of valid samples.
+   */
+  virtual SizeValueType EvaluateSampleBlock(
+    const ImageSampleBlockType & fixedBlock,
+    MovingImageSampleBlockType & movingBlock,
+    const bool computeDerivative ) const;
+
   /** Methods to support transforms with sparse Jacobians, like the BSplineTransform **********/
 
   /** Check if the transform is an AdvancedTransform. Called by Initialize.
@@ -87,8 +87,14 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   /** Threading related variables. */
   this->m_UseMetricSingleThreaded = true;
   this->m_UseMultiThread = false;
-  this->m_Threader->SetUseThreadPool( false ); // setting to true makes elastix hang
-                                               // at a WaitForSingleMethodThread()
+  this->m_UseThreadPool = true;
+  this->m_UseSampleBlocks = false;
+  this->m_SampleBlockSize = 64;
+  this->m_Profiler        = NULL;
+  this->m_SampleCache     = NULL;
+  this->m_Threader->SetUseThreadPool( false ); // the ITK pool makes elastix hang at a
+                                               // WaitForSingleMethodThread(), see
+                                               // itk::WorkerThreadPool instead
 
   /** OpenMP related. Switch to on when available */
 #ifdef ELASTIX_USE_OPENMP
@@ -170,6 +176,12 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   /** Check if the transform is a B-spline transform. */
   this->CheckForBSplineTransform();
 
+  /** The cached quantities of the previous resolution are not needed anymore. */
+  if( this->m_SampleCache.IsNotNull() )
+  {
+    this->m_SampleCache->Clear();
+  }
+
   /** Initialize some threading related parameters. */
   if( this->m_UseMultiThread )
   {
@@ -684,6 +696,116 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end EvaluateMovingImageValueAndDerivative()
 
 
+/**
+ * ******************* EvaluateSampleBlock ******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+SizeValueType
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::EvaluateSampleBlock(
+  const ImageSampleBlockType & fixedBlock,
+  MovingImageSampleBlockType & movingBlock,
+  const bool computeDerivative ) const
+{
+  const SizeValueType blockSize = fixedBlock.Size();
+  if( movingBlock.st_Valid.size() < blockSize )
+  {
+    movingBlock.st_MappedPoints.resize( blockSize );
+    movingBlock.st_MovingImageValues.resize( blockSize );
+    movingBlock.st_MovingImageDerivatives.resize( blockSize );
+    movingBlock.st_Valid.resize( blockSize );
+  }
+  if( blockSize == 0 ) { return 0; }
+
+  /** Map all points of the block with a single (virtual) call. */
+  {
+    RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::TransformEvaluation );
+    this->m_AdvancedTransform->TransformPoints(
+      &fixedBlock.m_ImageCoordinates[ 0 ], &movingBlock.st_MappedPoints[ 0 ], blockSize );
+  }
+  RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::Interpolation );
+
+  /** Check the moving mask. */
+  const bool useMovingMask = this->m_MovingImageMask.IsNotNull();
+  for( SizeValueType i = 0; i < blockSize; ++i )
+  {
+    movingBlock.st_Valid[ i ] = ( !useMovingMask
+      || this->m_MovingImageMask->IsInside( movingBlock.st_MappedPoints[ i ] ) ) ? 1.0 : 0.0;
+  }
+
+  /** Select the interpolation method once for the block. The general per-sample
+   * function handles the cases that need more than the interpolator.
+   */
+  const bool useInterpolatorDerivative = computeDerivative
+    && !this->GetComputeGradient() && !this->m_UseMovingImageDerivativeScales;
+  const bool useLinear        = useInterpolatorDerivative && this->m_InterpolatorIsLinear;
+  const bool useBSpline       = useInterpolatorDerivative && this->m_InterpolatorIsBSpline;
+  const bool useBSplineFloat  = useInterpolatorDerivative && this->m_InterpolatorIsBSplineFloat;
+  const bool useGeneralMethod = computeDerivative && !useLinear && !useBSpline && !useBSplineFloat;
+
+  /** The values of invalid samples are set to zero, so that loops over
+   * the block can use st_Valid as a weight without branches.
+   */
+  MovingImageContinuousIndexType cindex;
+  SizeValueType                  numberOfValidSamples = 0;
+  for( SizeValueType i = 0; i < blockSize; ++i )
+  {
+    const MovingImagePointType & mappedPoint      = movingBlock.st_MappedPoints[ i ];
+    RealType &                   movingImageValue = movingBlock.st_MovingImageValues[ i ];
+    movingImageValue = NumericTraits< RealType >::Zero;
+    if( movingBlock.st_Valid[ i ] == 0.0 ) { continue; }
+
+    bool sampleOk = false;
+    if( useGeneralMethod )
+    {
+      sampleOk = this->EvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, &movingBlock.st_MovingImageDerivatives[ i ] );
+    }
+    else
+    {
+      this->m_Interpolator->ConvertPointToContinuousIndex( mappedPoint, cindex );
+      sampleOk = this->m_Interpolator->IsInsideBuffer( cindex );
+      if( sampleOk )
+      {
+        if( useLinear )
+        {
+          this->m_LinearInterpolator->EvaluateValueAndDerivativeAtContinuousIndex(
+            cindex, movingImageValue, movingBlock.st_MovingImageDerivatives[ i ] );
+        }
+        else if( useBSpline )
+        {
+          this->m_BSplineInterpolator->EvaluateValueAndDerivativeAtContinuousIndex(
+            cindex, movingImageValue, movingBlock.st_MovingImageDerivatives[ i ] );
+        }
+        else if( useBSplineFloat )
+        {
+          this->m_BSplineInterpolatorFloat->EvaluateValueAndDerivativeAtContinuousIndex(
+            cindex, movingImageValue, movingBlock.st_MovingImageDerivatives[ i ] );
+        }
+        else
+        {
+          movingImageValue = this->m_Interpolator->EvaluateAtContinuousIndex( cindex );
+        }
+      }
+    }
+
+    if( sampleOk )
+    {
+      ++numberOfValidSamples;
+    }
+    else
+    {
+      movingImageValue          = NumericTraits< RealType >::Zero;
+      movingBlock.st_Valid[ i ] = 0.0;
+    }
+  }
+
+  return numberOfValidSamples;
+
+} // end EvaluateSampleBlock()
+
+
 /**
  * *************** EvaluateTransformJacobianInnerProduct ****************
  */
@@ -852,6 +974,7 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     this->SetTransformParameters( parameters );
     if( this->m_UseImageSampler )
     {
+      RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::Sampling );
       this->GetImageSampler()->Update();
     }
   }
@@ -859,6 +982,27 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end BeforeThreadedGetValueAndDerivative()
 
 
+/**
+ * *********************** GetSampleCacheKey ***********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::GetSampleCacheKey( const std::string & quantity,
+  const std::string & settings, std::string & key ) const
+{
+  if( this->m_SampleCache.IsNull() || !this->m_UseImageSampler ) { return false; }
+
+  std::string signature;
+  if( !this->GetImageSampler()->GetSampleSetSignature( signature ) ) { return false; }
+
+  key = quantity + "|" + signature + "|" + settings;
+  return true;
+
+} // end GetSampleCacheKey()
+
+
 /**
  * **************** GetValueThreaderCallback *******
  */
@@ -890,12 +1034,9 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueThreaderCallback,
-    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-
   /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  this->ExecuteThreaderCallback( this->GetValueThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
 } // end LaunchGetValueThreaderCallback()
 
@@ -931,16 +1072,38 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueAndDerivativeThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueAndDerivativeThreaderCallback,
-    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-
   /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  this->ExecuteThreaderCallback( this->GetValueAndDerivativeThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
 } // end LaunchGetValueAndDerivativeThreaderCallback()
 
 
+/**
+ * *********************** ExecuteThreaderCallback***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::ExecuteThreaderCallback( ThreadFunctionType callback, void * userData ) const
+{
+  if( this->m_UseThreadPool )
+  {
+    /** Reuse the persistent worker threads. */
+    WorkerThreadPool::GetInstance()->Execute( callback, userData,
+      this->m_Threader->GetNumberOfThreads() );
+  }
+  else
+  {
+    /** Spawn new threads. */
+    this->m_Threader->SetSingleMethod( callback, userData );
+    this->m_Threader->SingleMethodExecute();
+  }
+
+} // end ExecuteThreaderCallback()
+
+
 /**
  *********** AccumulateDerivativesThreaderCallback *************
  */
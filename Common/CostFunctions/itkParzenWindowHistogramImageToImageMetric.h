@@ -161,6 +161,12 @@ public:
   void GetValueAndDerivative( const ParametersType & parameters,
     MeasureType & value, DerivativeType & derivative ) const;
 
+  /** Calls the superclass' implementation, and looks up or computes the
+   * fixed image Parzen windows of the samples if a sample cache is set.
+   */
+  virtual void BeforeThreadedGetValueAndDerivative(
+    const TransformParametersType & parameters ) const;
+
   /** Number of bins to use for the fixed image in the histogram.
    * Typical value is 32.  The minimum value is 4 due to the padding
    * required by the Parzen windowing with a cubic B-spline kernel. Note
@@ -196,6 +202,20 @@ public:
   itkGetConstReferenceMacro( UseExplicitPDFDerivatives, bool );
   itkBooleanMacro( UseExplicitPDFDerivatives );
 
+  /** Option to store the explicit PDF derivatives sparsely. Instead of the
+   * dense (parameters x moving bins x fixed bins) image, the contribution of
+   * each sample is stored as a block: its Parzen window position, the
+   * derivative Parzen values in the window, and its image Jacobian at the
+   * nonzero Jacobian indices. The memory then scales with the number of
+   * samples times the number of nonzero Jacobian indices (the support of a
+   * B-spline), instead of with the number of parameters times the number of
+   * bins. Only used when UseExplicitPDFDerivatives is true.
+   * This option should be set before calling Initialize(); Default: false.
+   */
+  itkSetMacro( UseSparsePDFDerivatives, bool );
+  itkGetConstReferenceMacro( UseSparsePDFDerivatives, bool );
+  itkBooleanMacro( UseSparsePDFDerivatives );
+
   /** Whether you plan to call the GetDerivative/GetValueAndDerivative method or not.
    * This option should be set before calling Initialize(); Default: false.
    */
@@ -215,6 +235,30 @@ public:
   itkSetMacro( FiniteDifferencePerturbation, double );
   itkGetConstMacro( FiniteDifferencePerturbation, double );
 
+  /** The ways to accumulate the joint histogram over the threads:
+   * \li PerThreadCopy: every thread fills its own copy of the joint
+   *   histogram, and the copies are summed by a single thread afterwards.
+   * \li ParallelReduction: as PerThreadCopy, but the summation of the
+   *   copies is distributed over the threads, each thread summing the
+   *   copies for its own range of fixed image bins.
+   * \li BinSharded: no copies of the joint histogram are made. The threads
+   *   first compute the image values of their samples. Then each thread adds
+   *   the Parzen window contributions of all samples to its own range of
+   *   fixed image bins, which requires no locks and no summation.
+   */
+  typedef enum {
+    PerThreadCopy,
+    ParallelReduction,
+    BinSharded
+  } JointPDFAccumulationMethodType;
+
+  /** Select the way to accumulate the joint histogram in the multi-threaded
+   * ComputePDFs(). This option should be set before calling Initialize();
+   * Default: PerThreadCopy.
+   */
+  itkSetMacro( JointPDFAccumulationMethod, JointPDFAccumulationMethodType );
+  itkGetConstMacro( JointPDFAccumulationMethod, JointPDFAccumulationMethodType );
+
 protected:
 
   /** The constructor. */
@@ -278,6 +322,16 @@ protected:
   mutable MarginalPDFType       m_MovingImageMarginalPDF;
   JointPDFPointer               m_JointPDF;
   JointPDFDerivativesPointer    m_JointPDFDerivatives;
+
+  /** The sparse joint pdf derivatives, see UseSparsePDFDerivatives.
+   * Per valid sample are stored: the index of the Parzen window in the joint
+   * pdf (moving, fixed), the derivative Parzen values in the window, and the
+   * image Jacobian values with their nonzero Jacobian indices.
+   */
+  mutable std::vector< OffsetValueType >        m_SparsePDFDerivativesWindowIndices;
+  mutable std::vector< PDFDerivativeValueType > m_SparsePDFDerivativesParzenValues;
+  mutable std::vector< PDFDerivativeValueType > m_SparsePDFDerivativesImageJacobians;
+  mutable std::vector< unsigned int >           m_SparsePDFDerivativesNonZeroJacobianIndices;
   JointPDFDerivativesPointer    m_IncrementalJointPDFRight;
   JointPDFDerivativesPointer    m_IncrementalJointPDFLeft;
   IncrementalMarginalPDFPointer m_FixedIncrementalMarginalPDFRight;
@@ -300,6 +354,18 @@ protected:
   /** Threading related parameters. */
   mutable std::vector< JointPDFPointer > m_ThreaderJointPDFs;
 
+  /** The limited fixed and moving image values of the valid samples,
+   * stored as pairs, used by the BinSharded accumulation. The valid samples
+   * of each thread are stored at the start of the range of its samples.
+   */
+  mutable std::vector< PDFValueType > m_ParzenSampleValues;
+
+  /** The fixed image Parzen windows of the samples, see GetSampleCache().
+   * Per sample the index of the window and its Parzen values are stored.
+   * NULL if the windows are not cached.
+   */
+  mutable ImageSampleCache::EntryConstPointer m_FixedParzenWindowCacheEntry;
+
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
    */
@@ -336,6 +402,38 @@ protected:
   /** Helper function to launch the threads. */
   void LaunchComputePDFsThreaderCallback( void ) const;
 
+  /** Get the range of samples [begin, end) of a thread. */
+  void GetThreadSampleRange( ThreadIdType threadId,
+    unsigned long & pos_begin, unsigned long & pos_end ) const;
+
+  /** Get the range of fixed image bins [begin, end) owned by a thread,
+   * when the work on the joint histogram is divided over the threads.
+   */
+  void GetThreadFixedBinRange( ThreadIdType threadId,
+    OffsetValueType & bin_begin, OffsetValueType & bin_end ) const;
+
+  /** Multi-threaded summation of the per-thread joint histograms,
+   * used by the ParallelReduction accumulation.
+   */
+  inline void ThreadedReduceJointPDFs( ThreadIdType threadId ) const;
+
+  /** Multi-threaded computation of the sample values,
+   * used by the BinSharded accumulation.
+   */
+  inline void ThreadedComputeParzenSampleValues( ThreadIdType threadId );
+
+  /** Multi-threaded accumulation of a range of fixed image bins,
+   * used by the BinSharded accumulation.
+   */
+  inline void ThreadedAccumulateJointPDFShard( ThreadIdType threadId ) const;
+
+  /** Helper functions to launch the threads. */
+  static ITK_THREAD_RETURN_TYPE ReduceJointPDFsThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE ComputeParzenSampleValuesThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE AccumulateJointPDFShardThreaderCallback( void * arg );
+
   /** Compute the Parzen values given an image value and a starting histogram index
    * Compute the values at (parzenWindowIndex - parzenWindowTerm + k) for
    * k = 0 ... kernelsize-1
@@ -357,6 +455,31 @@ protected:
     const NonZeroJacobianIndicesType * nzji,
     JointPDFType * jointPDF ) const;
 
+  /** As above, with a precomputed fixed image Parzen window. */
+  void UpdateJointPDFAndDerivatives(
+    const OffsetValueType fixedImageParzenWindowIndex,
+    const ParzenValueContainerType & fixedParzenValues,
+    const RealType & movingImageValue,
+    const DerivativeType * imageJacobian,
+    const NonZeroJacobianIndicesType * nzji,
+    JointPDFType * jointPDF ) const;
+
+  /** Get the fixed image Parzen window of a sample: the lowest fixed bin
+   * number affected by the sample, and the Parzen values. The fixed image
+   * value is the value before limiting. With a sample cache the window is
+   * not computed, and parzenValues refers to the cached values.
+   */
+  void ComputeFixedParzenWindow(
+    const unsigned long sampleNumber,
+    const RealType & fixedImageValue,
+    OffsetValueType & parzenWindowIndex,
+    ParzenValueContainerType & parzenValues ) const;
+
+  /** Look up or compute the fixed image Parzen windows of the current
+   * samples in the sample cache, see ComputeFixedParzenWindow().
+   */
+  void UpdateFixedParzenWindowCache( void ) const;
+
   /** Update the joint PDF and the incremental pdfs.
    * The input is a pixel pair (fixed, moving, moving mask) and
    * a set of moving image/mask values when using mu+delta*e_k, for
@@ -385,6 +508,26 @@ protected:
     const DerivativeType & imageJacobian,
     const NonZeroJacobianIndicesType & nzji ) const;
 
+  /** Store the pdf derivatives of one sample in the sparse representation.
+   * This function should only be called from UpdateJointPDFAndDerivatives.
+   */
+  void UpdateSparseJointPDFDerivatives(
+    const JointPDFIndexType & pdfWindowIndex,
+    const ParzenValueContainerType & fixedParzenValues,
+    const ParzenValueContainerType & derivativeMovingParzenValues,
+    double factor,
+    const DerivativeType & imageJacobian,
+    const NonZeroJacobianIndicesType & nzji ) const;
+
+  /** Contract the sparse pdf derivatives with a weight per joint pdf bin:
+   * derivative[ mu ] -= sum_bins dh( mu, bin ) * binWeights[ bin ],
+   * where dh is the (unnormalized) joint histogram derivative, and bin is
+   * the offset in the joint pdf buffer: fixedBin * nrOfMovingBins + movingBin.
+   * Only the bins and parameters touched by a sample are visited.
+   */
+  void ContractSparseJointPDFDerivatives(
+    const double * binWeights, DerivativeType & derivative ) const;
+
   /** Multiply the pdf entries by the given normalization factor. */
   virtual void NormalizeJointPDF(
     JointPDFType * pdf, const double & factor ) const;
@@ -495,9 +638,12 @@ private:
   unsigned int  m_MovingKernelBSplineOrder;
   bool          m_UseDerivative;
   bool          m_UseExplicitPDFDerivatives;
+  bool          m_UseSparsePDFDerivatives;
   bool          m_UseFiniteDifferenceDerivative;
   double        m_FiniteDifferencePerturbation;
 
+  JointPDFAccumulationMethodType m_JointPDFAccumulationMethod;
+
 };
 
 } // end namespace itk
@@ -26,6 +26,10 @@
 #include "itkImageScanlineIterator.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 namespace itk
 {
 
@@ -68,6 +72,8 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   this->SetUseMovingImageLimiter( true );
 
   this->m_UseExplicitPDFDerivatives = true;
+  this->m_UseSparsePDFDerivatives   = false;
+  this->m_JointPDFAccumulationMethod = PerThreadCopy;
 
   /** Initialize the m_ParzenWindowHistogramThreaderParameters */
   this->m_ParzenWindowHistogramThreaderParameters.m_Metric = this;
@@ -112,6 +118,8 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
      << this->m_FixedKernelBSplineOrder << std::endl;
   os << indent << "MovingKernelBSplineOrder: "
      << this->m_MovingKernelBSplineOrder << std::endl;
+  os << indent << "JointPDFAccumulationMethod: "
+     << this->m_JointPDFAccumulationMethod << std::endl;
 
   /*double m_MovingImageNormalizedMin;
   double m_FixedImageNormalizedMin;
@@ -147,6 +155,9 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   /** Set up the Parzen windows. */
   this->InitializeKernels();
 
+  /** The cached fixed image Parzen windows belong to the previous resolution. */
+  this->m_FixedParzenWindowCacheEntry = NULL;
+
   /** If the user plans to use a finite difference derivative,
    * allocate some memory for the perturbed alpha variables.
    */
@@ -164,6 +175,26 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end Initialize()
 
 
+/**
+ * ******************* BeforeThreadedGetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::BeforeThreadedGetValueAndDerivative( const TransformParametersType & parameters ) const
+{
+  this->Superclass::BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** The samples are only updated here if m_UseMetricSingleThreaded is true. */
+  if( this->m_UseMetricSingleThreaded )
+  {
+    this->UpdateFixedParzenWindowCache();
+  }
+
+} // end BeforeThreadedGetValueAndDerivative()
+
+
 /**
  * ****************** InitializeHistograms *****************************
  */
@@ -329,7 +360,16 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
     } // end if this->GetUseFiniteDifferenceDerivative()
     else
     {
-      if( this->m_UseExplicitPDFDerivatives )
+      if( this->m_UseExplicitPDFDerivatives && this->m_UseSparsePDFDerivatives )
+      {
+        /** The sparse representation grows with the samples, so
+         * the dense derivatives are not allocated at all.
+         */
+        this->m_IncrementalJointPDFRight = 0;
+        this->m_IncrementalJointPDFLeft  = 0;
+        this->m_JointPDFDerivatives      = 0;
+      }
+      else if( this->m_UseExplicitPDFDerivatives )
       {
         this->m_IncrementalJointPDFRight = 0;
         this->m_IncrementalJointPDFLeft  = 0;
@@ -485,8 +525,15 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   {
     this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted = NumericTraits< SizeValueType >::Zero;
 
-    // Initialize the joint pdf
+    /** The BinSharded accumulation does not need per-thread joint pdfs. */
     JointPDFPointer & jointPDF = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDF;
+    if( this->m_JointPDFAccumulationMethod == BinSharded )
+    {
+      jointPDF = 0;
+      continue;
+    }
+
+    // Initialize the joint pdf
     if( jointPDF.IsNull() ) { jointPDF = JointPDFType::New(); }
     if( jointPDF->GetLargestPossibleRegion() != jointPDFRegion )
     {
@@ -566,28 +613,56 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   const NonZeroJacobianIndicesType * nzji,
   JointPDFType * jointPDF ) const
 {
-  typedef ImageScanlineIterator< JointPDFType > PDFIteratorType;
-
   /** Determine Parzen window arguments (see eq. 6 of Mattes paper [2]). */
   const double fixedImageParzenWindowTerm
     = fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
-  const double movingImageParzenWindowTerm
-    = movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
 
-  /** The lowest bin numbers affected by this pixel: */
+  /** The lowest bin number affected by this pixel: */
   const OffsetValueType fixedImageParzenWindowIndex
     = static_cast< OffsetValueType >( vcl_floor(
     fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset ) );
-  const OffsetValueType movingImageParzenWindowIndex
-    = static_cast< OffsetValueType >( vcl_floor(
-    movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset ) );
 
   /** The Parzen values. */
   ParzenValueContainerType fixedParzenValues( this->m_JointPDFWindow.GetSize()[ 1 ] );
-  ParzenValueContainerType movingParzenValues( this->m_JointPDFWindow.GetSize()[ 0 ] );
   this->EvaluateParzenValues(
     fixedImageParzenWindowTerm, fixedImageParzenWindowIndex,
     this->m_FixedKernel, fixedParzenValues );
+
+  this->UpdateJointPDFAndDerivatives(
+    fixedImageParzenWindowIndex, fixedParzenValues,
+    movingImageValue, imageJacobian, nzji, jointPDF );
+
+} // end UpdateJointPDFAndDerivatives()
+
+
+/**
+ * ********************** UpdateJointPDFAndDerivatives ***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::UpdateJointPDFAndDerivatives(
+  const OffsetValueType fixedImageParzenWindowIndex,
+  const ParzenValueContainerType & fixedParzenValues,
+  const RealType & movingImageValue,
+  const DerivativeType * imageJacobian,
+  const NonZeroJacobianIndicesType * nzji,
+  JointPDFType * jointPDF ) const
+{
+  typedef ImageScanlineIterator< JointPDFType > PDFIteratorType;
+
+  /** Determine Parzen window arguments (see eq. 6 of Mattes paper [2]). */
+  const double movingImageParzenWindowTerm
+    = movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+
+  /** The lowest bin number affected by this pixel: */
+  const OffsetValueType movingImageParzenWindowIndex
+    = static_cast< OffsetValueType >( vcl_floor(
+    movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset ) );
+
+  /** The Parzen values. */
+  ParzenValueContainerType movingParzenValues( this->m_JointPDFWindow.GetSize()[ 0 ] );
   this->EvaluateParzenValues(
     movingImageParzenWindowTerm, movingImageParzenWindowIndex,
     this->m_MovingKernel, movingParzenValues );
@@ -629,6 +704,28 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 
     const double et = static_cast< double >( this->m_MovingImageBinSize );
 
+    /** With sparse pdf derivatives, the derivatives of this sample are
+     * stored as one block, and only the joint pdf is updated here.
+     */
+    if( this->m_UseSparsePDFDerivatives )
+    {
+      this->UpdateSparseJointPDFDerivatives( pdfWindowIndex,
+        fixedParzenValues, derivativeMovingParzenValues, 1.0 / et,
+        *imageJacobian, *nzji );
+
+      for( unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f )
+      {
+        const double fv = fixedParzenValues[ f ];
+        for( unsigned int m = 0; m < movingParzenValues.GetSize(); ++m )
+        {
+          it.Value() += static_cast< PDFValueType >( fv * movingParzenValues[ m ] );
+          ++it;
+        }
+        it.NextLine();
+      }
+      return;
+    }
+
     /** Loop over the Parzen window region and increment the values
      * Also update the pdf derivatives.
      */
@@ -651,6 +748,104 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end UpdateJointPDFAndDerivatives()
 
 
+/**
+ * ********************** ComputeFixedParzenWindow ***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeFixedParzenWindow(
+  const unsigned long sampleNumber,
+  const RealType & fixedImageValue,
+  OffsetValueType & parzenWindowIndex,
+  ParzenValueContainerType & parzenValues ) const
+{
+  const unsigned int windowSize = this->m_JointPDFWindow.GetSize()[ 1 ];
+
+  /** Refer to the cached window, without copying it. */
+  if( this->m_FixedParzenWindowCacheEntry.IsNotNull() )
+  {
+    parzenWindowIndex = this->m_FixedParzenWindowCacheEntry->GetIndex( sampleNumber );
+    parzenValues.SetData( const_cast< PDFValueType * >(
+      this->m_FixedParzenWindowCacheEntry->GetValues( sampleNumber ) ), windowSize, false );
+    return;
+  }
+
+  /** Make sure the value falls within the histogram range. */
+  const RealType limitedFixedImageValue
+    = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
+
+  /** Determine the Parzen window (see UpdateJointPDFAndDerivatives()). */
+  const double fixedImageParzenWindowTerm
+    = limitedFixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+  parzenWindowIndex = static_cast< OffsetValueType >( vcl_floor(
+    fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset ) );
+
+  parzenValues.SetSize( windowSize );
+  this->EvaluateParzenValues(
+    fixedImageParzenWindowTerm, parzenWindowIndex,
+    this->m_FixedKernel, parzenValues );
+
+} // end ComputeFixedParzenWindow()
+
+
+/**
+ * ********************** UpdateFixedParzenWindowCache ***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::UpdateFixedParzenWindowCache( void ) const
+{
+  this->m_FixedParzenWindowCacheEntry = NULL;
+
+  /** The window depends on the histogram settings, the kernel and the limiter. */
+  std::ostringstream settings;
+  settings << std::setprecision( 17 )
+           << this->m_FixedImageBinSize << ';'
+           << this->m_FixedImageNormalizedMin << ';'
+           << this->m_FixedParzenTermToIndexOffset << ';'
+           << this->m_FixedKernelBSplineOrder << ';'
+           << this->m_JointPDFWindow.GetSize()[ 1 ] << ';'
+           << this->GetFixedImageLimiter() << '@'
+           << this->GetFixedImageLimiter()->GetMTime();
+  std::string key;
+  if( !this->GetSampleCacheKey( "FixedParzenWindow", settings.str(), key ) )
+  {
+    return;
+  }
+
+  /** Another metric, or a previous iteration, may have computed the windows. */
+  ImageSampleCache::EntryConstPointer entry = this->m_SampleCache->GetEntry( key );
+  if( entry.IsNull() )
+  {
+    ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+    const unsigned long         numberOfSamples = sampleContainer->Size();
+    const unsigned int          windowSize      = this->m_JointPDFWindow.GetSize()[ 1 ];
+
+    ImageSampleCache::EntryPointer newEntry = ImageSampleCache::EntryType::New();
+    newEntry->Allocate( numberOfSamples, windowSize );
+
+    ParzenValueContainerType parzenValues;
+    for( unsigned long i = 0; i < numberOfSamples; ++i )
+    {
+      const RealType fixedImageValue
+        = static_cast< RealType >( sampleContainer->ElementAt( i ).m_ImageValue );
+      this->ComputeFixedParzenWindow( i, fixedImageValue, newEntry->GetIndex( i ), parzenValues );
+      std::copy( parzenValues.begin(), parzenValues.end(), newEntry->GetValues( i ) );
+    }
+
+    this->m_SampleCache->SetEntry( key, newEntry );
+    entry = newEntry;
+  }
+
+  this->m_FixedParzenWindowCacheEntry = entry;
+
+} // end UpdateFixedParzenWindowCache()
+
+
 /**
  * *************** UpdateJointPDFDerivatives ***************************
  */
@@ -694,25 +889,127 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 
 
 /**
- * *********************** NormalizeJointPDF ***********************
+ * *************** UpdateSparseJointPDFDerivatives ***************************
  */
 
 template< class TFixedImage, class TMovingImage >
 void
 ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
-::NormalizeJointPDF( JointPDFType * pdf, const double & factor ) const
+::UpdateSparseJointPDFDerivatives(
+  const JointPDFIndexType & pdfWindowIndex,
+  const ParzenValueContainerType & fixedParzenValues,
+  const ParzenValueContainerType & derivativeMovingParzenValues,
+  double factor,
+  const DerivativeType & imageJacobian,
+  const NonZeroJacobianIndicesType & nzji ) const
 {
-  typedef ImageScanlineIterator< JointPDFType > JointPDFIteratorType;
-  JointPDFIteratorType it( pdf, pdf->GetBufferedRegion() );
-  const PDFValueType   castfac = static_cast< PDFValueType >( factor );
-  while( !it.IsAtEnd() )
+  /** The window position. */
+  this->m_SparsePDFDerivativesWindowIndices.push_back( pdfWindowIndex[ 0 ] );
+  this->m_SparsePDFDerivativesWindowIndices.push_back( pdfWindowIndex[ 1 ] );
+
+  /** The derivative Parzen values in the window, in the same order as in
+   * UpdateJointPDFAndDerivatives: moving bins run fastest.
+   */
+  for( unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f )
   {
-    while( !it.IsAtEndOfLine() )
+    const double fv = fixedParzenValues[ f ] * factor;
+    for( unsigned int m = 0; m < derivativeMovingParzenValues.GetSize(); ++m )
     {
-      it.Value() *= castfac;
-      ++it;
+      this->m_SparsePDFDerivativesParzenValues.push_back(
+        static_cast< PDFDerivativeValueType >( fv * derivativeMovingParzenValues[ m ] ) );
     }
-    it.NextLine();
+  }
+
+  /** The image Jacobian at the nonzero Jacobian indices. */
+  for( unsigned int i = 0; i < imageJacobian.GetSize(); ++i )
+  {
+    this->m_SparsePDFDerivativesImageJacobians.push_back(
+      static_cast< PDFDerivativeValueType >( imageJacobian[ i ] ) );
+    this->m_SparsePDFDerivativesNonZeroJacobianIndices.push_back( nzji[ i ] );
+  }
+
+} // end UpdateSparseJointPDFDerivatives()
+
+
+/**
+ * *************** ContractSparseJointPDFDerivatives ***************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ContractSparseJointPDFDerivatives(
+  const double * binWeights, DerivativeType & derivative ) const
+{
+  const std::size_t numberOfSamples = this->m_SparsePDFDerivativesWindowIndices.size() / 2;
+  if( numberOfSamples == 0 ) { return; }
+
+  const unsigned int windowMovingSize = this->m_JointPDFWindow.GetSize()[ 0 ];
+  const unsigned int windowFixedSize  = this->m_JointPDFWindow.GetSize()[ 1 ];
+  const unsigned int windowSize       = windowMovingSize * windowFixedSize;
+  const std::size_t  numberOfNonZeros
+    = this->m_SparsePDFDerivativesImageJacobians.size() / numberOfSamples;
+  const OffsetValueType nrOfMovingBins
+    = static_cast< OffsetValueType >( this->m_NumberOfMovingHistogramBins );
+
+  const OffsetValueType *        windowIndices = &this->m_SparsePDFDerivativesWindowIndices[ 0 ];
+  const PDFDerivativeValueType * parzenValues  = &this->m_SparsePDFDerivativesParzenValues[ 0 ];
+  const PDFDerivativeValueType * imageJacobian = &this->m_SparsePDFDerivativesImageJacobians[ 0 ];
+  const unsigned int *           nzji          = &this->m_SparsePDFDerivativesNonZeroJacobianIndices[ 0 ];
+
+  for( std::size_t s = 0; s < numberOfSamples; ++s )
+  {
+    /** The derivative of the joint histogram of this sample is the outer
+     * product of -imageJacobian and the derivative Parzen values. Hence, its
+     * contraction with the weights reduces to one sum over the window.
+     */
+    const double * weights = binWeights
+      + windowIndices[ 1 ] * nrOfMovingBins + windowIndices[ 0 ];
+    double weightedSum = 0.0;
+    for( unsigned int f = 0; f < windowFixedSize; ++f )
+    {
+      for( unsigned int m = 0; m < windowMovingSize; ++m )
+      {
+        weightedSum += parzenValues[ m ] * weights[ m ];
+      }
+      parzenValues += windowMovingSize;
+      weights      += nrOfMovingBins;
+    }
+
+    if( weightedSum != 0.0 )
+    {
+      for( std::size_t i = 0; i < numberOfNonZeros; ++i )
+      {
+        derivative[ nzji[ i ] ] += imageJacobian[ i ] * weightedSum;
+      }
+    }
+
+    windowIndices += 2;
+    imageJacobian += numberOfNonZeros;
+    nzji          += numberOfNonZeros;
+  }
+
+} // end ContractSparseJointPDFDerivatives()
+
+
+/**
+ * *********************** NormalizeJointPDF ***********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::NormalizeJointPDF( JointPDFType * pdf, const double & factor ) const
+{
+  /** The pdf buffer is contiguous, so a plain loop over it suffices.
+   * Contrary to an iterator loop, compilers vectorize this loop.
+   */
+  PDFValueType *      pdfPtr       = pdf->GetBufferPointer();
+  const SizeValueType numberOfBins = pdf->GetBufferedRegion().GetNumberOfPixels();
+  const PDFValueType  castfac      = static_cast< PDFValueType >( factor );
+  for( SizeValueType i = 0; i < numberOfBins; ++i )
+  {
+    pdfPtr[ i ] *= castfac;
   }
 
 } // end NormalizeJointPDF()
@@ -727,17 +1024,13 @@ void
 ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 ::NormalizeJointPDFDerivatives( JointPDFDerivativesType * pdf, const double & factor ) const
 {
-  typedef ImageScanlineIterator< JointPDFDerivativesType > JointPDFDerivativesIteratorType;
-  JointPDFDerivativesIteratorType it( pdf, pdf->GetBufferedRegion() );
-  const PDFValueType              castfac = static_cast< PDFValueType >( factor );
-  while( !it.IsAtEnd() )
+  /** See NormalizeJointPDF(). */
+  PDFDerivativeValueType *     pdfPtr       = pdf->GetBufferPointer();
+  const SizeValueType          numberOfBins = pdf->GetBufferedRegion().GetNumberOfPixels();
+  const PDFDerivativeValueType castfac      = static_cast< PDFDerivativeValueType >( factor );
+  for( SizeValueType i = 0; i < numberOfBins; ++i )
   {
-    while( !it.IsAtEndOfLine() )
-    {
-      it.Value() *= castfac;
-      ++it;
-    }
-    it.NextLine();
+    pdfPtr[ i ] *= castfac;
   }
 
 } // end NormalizeJointPDFDerivatives()
@@ -1053,6 +1346,13 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
   typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
 
+  /** The fixed image Parzen window of a sample. */
+  OffsetValueType          fixedParzenWindowIndex = 0;
+  ParzenValueContainerType fixedParzenValues;
+
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for( fiter = fbegin; fiter != fend; ++fiter )
   {
@@ -1062,7 +1362,9 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if point is inside mask. */
     if( sampleOk )
@@ -1078,21 +1380,23 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, 0 );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
       this->m_NumberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      /** Get the fixed image Parzen window, possibly from the sample cache. */
+      const RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      this->ComputeFixedParzenWindow( fiter.Index(), fixedImageValue,
+        fixedParzenWindowIndex, fixedParzenValues );
 
       /** Make sure the values fall within the histogram range. */
-      fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
       movingImageValue = this->GetMovingImageLimiter()->Evaluate( movingImageValue );
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, 0, 0, this->m_JointPDF.GetPointer() );
+      this->UpdateJointPDFAndDerivatives( fixedParzenWindowIndex, fixedParzenValues,
+        movingImageValue, 0, 0, this->m_JointPDF.GetPointer() );
     }
 
   } // end iterating over fixed image spatial sample container for loop
@@ -1136,8 +1440,20 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
    */
   this->BeforeThreadedGetValueAndDerivative( parameters );
 
-  /** Launch multi-threading JointPDF computation. */
-  this->LaunchComputePDFsThreaderCallback();
+  /** Launch multi-threading JointPDF computation. With the BinSharded
+   * accumulation the threads only compute the sample values here.
+   */
+  if( this->m_JointPDFAccumulationMethod == BinSharded )
+  {
+    this->m_ParzenSampleValues.resize( 2 * this->GetImageSampler()->GetOutput()->Size() );
+    this->ExecuteThreaderCallback( this->ComputeParzenSampleValuesThreaderCallback,
+      const_cast< void * >( static_cast< const void * >(
+        &this->m_ParzenWindowHistogramThreaderParameters ) ) );
+  }
+  else
+  {
+    this->LaunchComputePDFsThreaderCallback();
+  }
 
   /** Gather the results from all threads. */
   this->AfterThreadedComputePDFs();
@@ -1162,18 +1478,11 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   jointPDF->FillBuffer( NumericTraits< PDFValueType >::ZeroValue() );
 
   /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
   /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( this->m_NumberOfThreads ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+  unsigned long pos_begin, pos_end;
+  this->GetThreadSampleRange( threadId, pos_begin, pos_end );
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -1185,6 +1494,13 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
 
+  /** The fixed image Parzen window of a sample. */
+  OffsetValueType          fixedParzenWindowIndex = 0;
+  ParzenValueContainerType fixedParzenValues;
+
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for( fiter = fbegin; fiter != fend; ++fiter )
   {
@@ -1194,7 +1510,9 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if point is inside mask. */
     if( sampleOk )
@@ -1210,22 +1528,23 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, 0 );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
       numberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      /** Get the fixed image Parzen window, possibly from the sample cache. */
+      const RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      this->ComputeFixedParzenWindow( fiter.Index(), fixedImageValue,
+        fixedParzenWindowIndex, fixedParzenValues );
 
       /** Make sure the values fall within the histogram range. */
-      fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
       movingImageValue = this->GetMovingImageLimiter()->Evaluate( movingImageValue );
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, 0, 0,
-        jointPDF.GetPointer() );
+      this->UpdateJointPDFAndDerivatives( fixedParzenWindowIndex, fixedParzenValues,
+        movingImageValue, 0, 0, jointPDF.GetPointer() );
     }
   } // end iterating over fixed image spatial sample container for loop
 
@@ -1264,8 +1583,21 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   /** Compute alpha. */
   this->m_Alpha = 1.0 / static_cast< double >( this->m_NumberOfPixelsCounted );
 
+  /** Accumulate joint histogram, each thread updating only a part of it. */
+  if( this->m_JointPDFAccumulationMethod != PerThreadCopy )
+  {
+    ThreadFunctionType callback = &Self::ReduceJointPDFsThreaderCallback;
+    if( this->m_JointPDFAccumulationMethod == BinSharded )
+    {
+      callback = &Self::AccumulateJointPDFShardThreaderCallback;
+    }
+    this->ExecuteThreaderCallback( callback,
+      const_cast< void * >( static_cast< const void * >(
+        &this->m_ParzenWindowHistogramThreaderParameters ) ) );
+    return;
+  }
+
   /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
   typedef ImageScanlineIterator< JointPDFType > JointPDFIteratorType;
   JointPDFIteratorType                it( this->m_JointPDF, this->m_JointPDF->GetBufferedRegion() );
   std::vector< JointPDFIteratorType > itT( this->m_NumberOfThreads );
@@ -1300,6 +1632,317 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end AfterThreadedComputePDFs()
 
 
+/**
+ * ******************* GetThreadSampleRange *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::GetThreadSampleRange( ThreadIdType threadId,
+  unsigned long & pos_begin, unsigned long & pos_end ) const
+{
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->m_NumberOfThreads ) ) );
+
+  pos_begin = nrOfSamplesPerThreads * threadId;
+  pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+} // end GetThreadSampleRange()
+
+
+/**
+ * ******************* GetThreadFixedBinRange *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::GetThreadFixedBinRange( ThreadIdType threadId,
+  OffsetValueType & bin_begin, OffsetValueType & bin_end ) const
+{
+  const OffsetValueType nrOfFixedBins = static_cast< OffsetValueType >(
+    this->m_NumberOfFixedHistogramBins );
+  const OffsetValueType nrOfThreads = static_cast< OffsetValueType >(
+    this->m_NumberOfThreads );
+
+  bin_begin = ( nrOfFixedBins * threadId ) / nrOfThreads;
+  bin_end   = ( nrOfFixedBins * ( threadId + 1 ) ) / nrOfThreads;
+
+} // end GetThreadFixedBinRange()
+
+
+/**
+ * ******************* ThreadedReduceJointPDFs *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedReduceJointPDFs( ThreadIdType threadId ) const
+{
+  /** This thread sums the rows [bin_begin, bin_end) of all copies. */
+  OffsetValueType bin_begin, bin_end;
+  this->GetThreadFixedBinRange( threadId, bin_begin, bin_end );
+  if( bin_begin >= bin_end ) { return; }
+
+  const OffsetValueType nrOfMovingBins = static_cast< OffsetValueType >(
+    this->m_NumberOfMovingHistogramBins );
+  const OffsetValueType offset = bin_begin * nrOfMovingBins;
+  const OffsetValueType size   = ( bin_end - bin_begin ) * nrOfMovingBins;
+
+  PDFValueType * jointPDFPtr = this->m_JointPDF->GetBufferPointer() + offset;
+  const PDFValueType * threadPDFPtr
+    = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ 0 ].st_JointPDF->GetBufferPointer() + offset;
+  std::copy( threadPDFPtr, threadPDFPtr + size, jointPDFPtr );
+
+  for( ThreadIdType i = 1; i < this->m_NumberOfThreads; ++i )
+  {
+    threadPDFPtr = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDF->GetBufferPointer() + offset;
+    for( OffsetValueType j = 0; j < size; ++j )
+    {
+      jointPDFPtr[ j ] += threadPDFPtr[ j ];
+    }
+  }
+
+} // end ThreadedReduceJointPDFs()
+
+
+/**
+ * ******************* ThreadedComputeParzenSampleValues *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedComputeParzenSampleValues( ThreadIdType threadId )
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+  /** Get the samples for this thread. */
+  unsigned long pos_begin, pos_end;
+  this->GetThreadSampleRange( threadId, pos_begin, pos_end );
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator fiter;
+  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
+  fbegin                                                 += (int)pos_begin;
+  fend                                                   += (int)pos_end;
+
+  /** The valid samples are stored consecutively, from the start of the range. */
+  unsigned long numberOfPixelsCounted = 0;
+  if( pos_begin >= pos_end )
+  {
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = 0;
+    return;
+  }
+  PDFValueType * sampleValues = &this->m_ParzenSampleValues[ 0 ] + 2 * pos_begin;
+
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
+  /** Loop over sample container and compute the limited image values. */
+  for( fiter = fbegin; fiter != fend; ++fiter )
+  {
+    /** Read fixed coordinates and initialize some variables. */
+    const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
+    RealType                    movingImageValue;
+    MovingImagePointType        mappedPoint;
+
+    /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
+    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
+
+    /** Check if point is inside mask. */
+    if( sampleOk )
+    {
+      sampleOk = this->IsInsideMovingMask( mappedPoint );
+    }
+
+    /** Compute the moving image value and check if the point is
+     * inside the moving image buffer.
+     */
+    if( sampleOk )
+    {
+      sampleOk = this->EvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, 0 );
+    }
+    phaseTimes.Stop();
+
+    if( sampleOk )
+    {
+      /** Get the fixed image value. */
+      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+
+      /** Make sure the values fall within the histogram range. */
+      sampleValues[ 2 * numberOfPixelsCounted ]
+        = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
+      sampleValues[ 2 * numberOfPixelsCounted + 1 ]
+        = this->GetMovingImageLimiter()->Evaluate( movingImageValue );
+      numberOfPixelsCounted++;
+    }
+  } // end iterating over fixed image spatial sample container for loop
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+
+} // end ThreadedComputeParzenSampleValues()
+
+
+/**
+ * ******************* ThreadedAccumulateJointPDFShard *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedAccumulateJointPDFShard( ThreadIdType threadId ) const
+{
+  /** This thread owns the rows [bin_begin, bin_end) of the joint pdf. */
+  OffsetValueType bin_begin, bin_end;
+  this->GetThreadFixedBinRange( threadId, bin_begin, bin_end );
+  if( bin_begin >= bin_end ) { return; }
+
+  const OffsetValueType nrOfMovingBins = static_cast< OffsetValueType >(
+    this->m_NumberOfMovingHistogramBins );
+  PDFValueType * jointPDFPtr = this->m_JointPDF->GetBufferPointer();
+  std::fill( jointPDFPtr + bin_begin * nrOfMovingBins,
+    jointPDFPtr + bin_end * nrOfMovingBins, NumericTraits< PDFValueType >::ZeroValue() );
+
+  /** The Parzen values. */
+  const OffsetValueType    fixedWindowSize  = this->m_JointPDFWindow.GetSize()[ 1 ];
+  const OffsetValueType    movingWindowSize = this->m_JointPDFWindow.GetSize()[ 0 ];
+  ParzenValueContainerType fixedParzenValues( fixedWindowSize );
+  ParzenValueContainerType movingParzenValues( movingWindowSize );
+
+  /** Loop over the valid samples of all threads. */
+  for( ThreadIdType t = 0; t < this->m_NumberOfThreads; ++t )
+  {
+    unsigned long pos_begin, pos_end;
+    this->GetThreadSampleRange( t, pos_begin, pos_end );
+    const unsigned long numberOfPixelsCounted
+      = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ t ].st_NumberOfPixelsCounted;
+    if( numberOfPixelsCounted == 0 ) { continue; }
+    const PDFValueType * sampleValues = &this->m_ParzenSampleValues[ 0 ] + 2 * pos_begin;
+
+    for( unsigned long s = 0; s < numberOfPixelsCounted; ++s )
+    {
+      /** Determine the fixed Parzen window (see UpdateJointPDFAndDerivatives()). */
+      const double fixedImageParzenWindowTerm
+        = sampleValues[ 2 * s ] / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+      const OffsetValueType fixedImageParzenWindowIndex
+        = static_cast< OffsetValueType >( vcl_floor(
+        fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset ) );
+
+      /** Skip the samples that do not touch the rows of this thread. */
+      const OffsetValueType f_begin = std::max( fixedImageParzenWindowIndex, bin_begin );
+      const OffsetValueType f_end   = std::min( fixedImageParzenWindowIndex + fixedWindowSize, bin_end );
+      if( f_begin >= f_end ) { continue; }
+
+      /** Determine the moving Parzen window. */
+      const double movingImageParzenWindowTerm
+        = sampleValues[ 2 * s + 1 ] / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+      const OffsetValueType movingImageParzenWindowIndex
+        = static_cast< OffsetValueType >( vcl_floor(
+        movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset ) );
+
+      this->EvaluateParzenValues(
+        fixedImageParzenWindowTerm, fixedImageParzenWindowIndex,
+        this->m_FixedKernel, fixedParzenValues );
+      this->EvaluateParzenValues(
+        movingImageParzenWindowTerm, movingImageParzenWindowIndex,
+        this->m_MovingKernel, movingParzenValues );
+
+      /** Increment the values in the rows of this thread. */
+      for( OffsetValueType f = f_begin; f < f_end; ++f )
+      {
+        const double   fv     = fixedParzenValues[ f - fixedImageParzenWindowIndex ];
+        PDFValueType * rowPtr = jointPDFPtr + f * nrOfMovingBins + movingImageParzenWindowIndex;
+        for( OffsetValueType m = 0; m < movingWindowSize; ++m )
+        {
+          rowPtr[ m ] += static_cast< PDFValueType >( fv * movingParzenValues[ m ] );
+        }
+      }
+    }
+  }
+
+} // end ThreadedAccumulateJointPDFShard()
+
+
+/**
+ * **************** ReduceJointPDFsThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ReduceJointPDFsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp
+    = static_cast< ParzenWindowHistogramMultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedReduceJointPDFs( threadId );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ReduceJointPDFsThreaderCallback()
+
+
+/**
+ * **************** ComputeParzenSampleValuesThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeParzenSampleValuesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp
+    = static_cast< ParzenWindowHistogramMultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedComputeParzenSampleValues( threadId );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeParzenSampleValuesThreaderCallback()
+
+
+/**
+ * **************** AccumulateJointPDFShardThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::AccumulateJointPDFShardThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp
+    = static_cast< ParzenWindowHistogramMultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedAccumulateJointPDFShard( threadId );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateJointPDFShardThreaderCallback()
+
+
 /**
  * **************** ComputePDFsThreaderCallback *******
  */
@@ -1331,14 +1974,11 @@ void
 ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchComputePDFsThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputePDFsThreaderCallback,
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->ComputePDFsThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_ParzenWindowHistogramThreaderParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputePDFsThreaderCallback()
 
 
@@ -1353,7 +1993,20 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 {
   /** Initialize some variables. */
   this->m_JointPDF->FillBuffer( 0.0 );
-  this->m_JointPDFDerivatives->FillBuffer( 0.0 );
+  if( this->m_UseSparsePDFDerivatives )
+  {
+    /** Clearing keeps the capacity, so after the first iteration no
+     * reallocations are needed.
+     */
+    this->m_SparsePDFDerivativesWindowIndices.clear();
+    this->m_SparsePDFDerivativesParzenValues.clear();
+    this->m_SparsePDFDerivativesImageJacobians.clear();
+    this->m_SparsePDFDerivativesNonZeroJacobianIndices.clear();
+  }
+  else
+  {
+    this->m_JointPDFDerivatives->FillBuffer( 0.0 );
+  }
   this->m_Alpha                 = 0.0;
   this->m_NumberOfPixelsCounted = 0;
 
@@ -1385,6 +2038,13 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
   typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
 
+  /** The fixed image Parzen window of a sample. */
+  OffsetValueType          fixedParzenWindowIndex = 0;
+  ParzenValueContainerType fixedParzenValues;
+
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for( fiter = fbegin; fiter != fend; ++fiter )
   {
@@ -1395,7 +2055,9 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if point is inside mask. */
     if( sampleOk )
@@ -1411,19 +2073,23 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, &movingImageDerivative );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
       this->m_NumberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      /** Get the fixed image Parzen window, possibly from the sample cache. */
+      const RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      this->ComputeFixedParzenWindow( fiter.Index(), fixedImageValue,
+        fixedParzenWindowIndex, fixedParzenValues );
 
       /** Make sure the values fall within the histogram range. */
-      fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(
         movingImageValue, movingImageDerivative );
 
+      phaseTimes.Start( RegistrationProfiler::JacobianProduct );
+
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
 
@@ -1432,8 +2098,9 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
         jacobian, movingImageDerivative, imageJacobian );
 
       /** Update the joint pdf and the joint pdf derivatives. */
-      this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, &imageJacobian, &nzji, this->m_JointPDF.GetPointer() );
+      this->UpdateJointPDFAndDerivatives( fixedParzenWindowIndex, fixedParzenValues,
+        movingImageValue, &imageJacobian, &nzji, this->m_JointPDF.GetPointer() );
+      phaseTimes.Stop();
 
     } //end if-block check sampleOk
   }   // end iterating over fixed image spatial sample container for loop
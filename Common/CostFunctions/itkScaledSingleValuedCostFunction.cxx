@@ -20,6 +20,7 @@
 #define __itkScaledSingleValuedCostFunction_cxx
 
 #include "itkScaledSingleValuedCostFunction.h"
+#include "itkParameterVectorOperations.h"
 #include "vnl/vnl_math.h"
 
 namespace itk
@@ -35,6 +36,7 @@ ScaledSingleValuedCostFunction
   this->m_UnscaledCostFunction = 0;
   this->m_UseScales            = false;
   this->m_NegateCostFunction   = false;
+  this->m_Profiler             = 0;
 
 } // end Constructor
 
@@ -48,6 +50,7 @@ ScaledSingleValuedCostFunction
 ::GetValue( const ParametersType & parameters ) const
 {
   /** F(y)= f(y/s) */
+  RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::MetricEvaluation );
 
   /** This function also checks if the UnscaledCostFunction has been set */
   const unsigned int numberOfParameters = this->GetNumberOfParameters();
@@ -88,6 +91,7 @@ ScaledSingleValuedCostFunction
   DerivativeType & derivative ) const
 {
   /** dF/dy(y)= 1/s * df/dx(y/s) */
+  RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::MetricEvaluation );
 
   /** This function also checks if the UnscaledCostFunction has been set */
   const unsigned int numberOfParameters = this->GetNumberOfParameters();
@@ -102,11 +106,7 @@ ScaledSingleValuedCostFunction
     this->ConvertScaledToUnscaledParameters( scaledParameters );
     this->m_UnscaledCostFunction->GetDerivative( scaledParameters, derivative );
 
-    const ScalesType & scales = this->GetScales();
-    for( unsigned int i = 0; i < numberOfParameters; ++i )
-    {
-      derivative[ i ] /= scales[ i ];
-    }
+    ParameterVectorOperations::Divide( derivative, this->GetScales(), derivative );
   }
   else
   {
@@ -115,7 +115,7 @@ ScaledSingleValuedCostFunction
 
   if( this->GetNegateCostFunction() )
   {
-    derivative = -derivative;
+    ParameterVectorOperations::Scale( -1.0, derivative );
   }
 
 } // end GetDerivative()
@@ -133,6 +133,7 @@ ScaledSingleValuedCostFunction
 {
   /** F(y)= f(y/s) */
   /** dF/dy(y)= 1/s * df/dx(y/s) */
+  RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::MetricEvaluation );
 
   /** This function also checks if the UnscaledCostFunction has been set */
   const unsigned int numberOfParameters = this->GetNumberOfParameters();
@@ -148,11 +149,7 @@ ScaledSingleValuedCostFunction
     this->ConvertScaledToUnscaledParameters( scaledParameters );
     this->m_UnscaledCostFunction->GetValueAndDerivative( scaledParameters, value, derivative );
 
-    const ScalesType & scales = this->GetScales();
-    for( unsigned int i = 0; i < numberOfParameters; ++i )
-    {
-      derivative[ i ] /= scales[ i ];
-    }
+    ParameterVectorOperations::Divide( derivative, this->GetScales(), derivative );
   }
   else
   {
@@ -162,7 +159,7 @@ ScaledSingleValuedCostFunction
   if( this->GetNegateCostFunction() )
   {
     value      = -value;
-    derivative = -derivative;
+    ParameterVectorOperations::Scale( -1.0, derivative );
   }
 
 } // end GetValueAndDerivative()
@@ -242,10 +239,7 @@ ScaledSingleValuedCostFunction
       itkExceptionMacro( << "Number of scales is not correct." );
     }
 
-    for( unsigned int i = 0; i < numberOfParameters; ++i )
-    {
-      parameters[ i ] /= scales[ i ];
-    }
+    ParameterVectorOperations::Divide( parameters, scales, parameters );
 
   } // end if use scales
 
@@ -269,10 +263,7 @@ ScaledSingleValuedCostFunction
       itkExceptionMacro( << "Number of scales is not correct." );
     }
 
-    for( unsigned int i = 0; i < numberOfParameters; ++i )
-    {
-      parameters[ i ] *= scales[ i ];
-    }
+    ParameterVectorOperations::Multiply( parameters, scales, parameters );
 
   } // end if use scales
 
@@ -21,6 +21,7 @@
 
 #include "itkSingleValuedCostFunction.h"
 #include "itkIntTypes.h" //temp, needed for IdentifierType
+#include "itkRegistrationProfiler.h"
 
 namespace itk
 {
@@ -120,6 +121,11 @@ public:
   /** Get the flag to negate the cost function or not. */
   itkGetConstMacro( NegateCostFunction, bool );
 
+  /** Set/Get the profiler that records the time spent in the cost function
+   * as the MetricEvaluation phase. Default NULL: no profiling. */
+  itkSetObjectMacro( Profiler, RegistrationProfiler );
+  itkGetObjectMacro( Profiler, RegistrationProfiler );
+
   /** Convert the parameters from scaled to unscaled: x = y/s. */
   virtual void ConvertScaledToUnscaledParameters( ParametersType & parameters ) const;
 
@@ -149,6 +155,7 @@ private:
   SingleValuedCostFunctionPointer m_UnscaledCostFunction;
   bool                            m_UseScales;
   bool                            m_NegateCostFunction;
+  RegistrationProfiler::Pointer   m_Profiler;
 
 };
 
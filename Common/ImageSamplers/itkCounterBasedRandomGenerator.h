@@ -0,0 +1,119 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __CounterBasedRandomGenerator_h
+#define __CounterBasedRandomGenerator_h
+
+#include "itkIntTypes.h"
+
+namespace itk
+{
+
+/** \class CounterBasedRandomGenerator
+ *
+ * \brief A stateless random number generator: the random number is a
+ * function of a key, a counter and a stream number.
+ *
+ * Contrary to a sequential generator such as the Mersenne Twister, the
+ * n-th random number can be computed without computing the previous ones.
+ * Threads can therefore draw random numbers concurrently, without locking,
+ * and the random number belonging to for example the n-th sample does not
+ * depend on the number of threads. The stream number gives independent
+ * random numbers for the same counter, for example one per dimension.
+ *
+ * The bits are generated by hashing the key, stream and counter with the
+ * SplitMix64 finalizer, which passes the common statistical test suites.
+ * The key is typically drawn from a seeded sequential generator, so that the
+ * results are reproducible for a fixed seed.
+ *
+ * \ingroup ImageSamplers
+ */
+
+class CounterBasedRandomGenerator
+{
+public:
+
+  typedef uint64_t KeyType;
+  typedef uint64_t CounterType;
+
+  CounterBasedRandomGenerator() : m_Key( 0 ) {}
+  CounterBasedRandomGenerator( const KeyType key ) : m_Key( key ) {}
+  ~CounterBasedRandomGenerator() {}
+
+  /** Set/Get the key. */
+  void SetKey( const KeyType key ) { this->m_Key = key; }
+  KeyType GetKey( void ) const { return this->m_Key; }
+
+  /** Get 64 random bits. */
+  uint64_t GetRandomBits( const CounterType counter, const CounterType stream = 0 ) const
+  {
+    const uint64_t streamKey = Mix( this->m_Key ^ Mix( stream * GoldenGamma() + 1 ) );
+    return Mix( streamKey + ( counter + 1 ) * GoldenGamma() );
+  }
+
+
+  /** Get a random number in the range [0,1). */
+  double GetVariate( const CounterType counter, const CounterType stream = 0 ) const
+  {
+    /** Use the upper 53 bits, the precision of a double. */
+    return static_cast< double >( this->GetRandomBits( counter, stream ) >> 11 )
+           * ( 1.0 / 9007199254740992.0 );
+  }
+
+
+  /** Get a random number in the range [a,b). */
+  double GetUniformVariate( const double a, const double b,
+    const CounterType counter, const CounterType stream = 0 ) const
+  {
+    return a + ( b - a ) * this->GetVariate( counter, stream );
+  }
+
+
+  /** Get a random integer in the range [0,n]. */
+  unsigned long GetIntegerVariate( const unsigned long n,
+    const CounterType counter, const CounterType stream = 0 ) const
+  {
+    const double        range  = static_cast< double >( n ) + 1.0;
+    const unsigned long result = static_cast< unsigned long >( range * this->GetVariate( counter, stream ) );
+    return result > n ? n : result;
+  }
+
+
+  /** The SplitMix64 finalizer: a bijective mixing function of 64 bits. */
+  static uint64_t Mix( uint64_t z )
+  {
+    z = ( z ^ ( z >> 30 ) ) * ( ( static_cast< uint64_t >( 0xBF58476DUL ) << 32 ) | 0x1CE4E5B9UL );
+    z = ( z ^ ( z >> 27 ) ) * ( ( static_cast< uint64_t >( 0x94D049BBUL ) << 32 ) | 0x133111EBUL );
+    return z ^ ( z >> 31 );
+  }
+
+
+  /** The 64 bit golden ratio, used to space consecutive counters. */
+  static uint64_t GoldenGamma( void )
+  {
+    return ( static_cast< uint64_t >( 0x9E3779B9UL ) << 32 ) | 0x7F4A7C15UL;
+  }
+
+
+private:
+
+  KeyType m_Key;
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __CounterBasedRandomGenerator_h
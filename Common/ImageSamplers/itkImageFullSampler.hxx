@@ -22,6 +22,8 @@
 
 #include "itkImageRegionConstIteratorWithIndex.h"
 
+#include <sstream>
+
 namespace itk
 {
 
@@ -228,6 +230,24 @@ ImageFullSampler< TInputImage >
 } // end ThreadedGenerateData()
 
 
+/**
+ * ******************* GetSampleSetSignature *******************
+ */
+
+template< class TInputImage >
+bool
+ImageFullSampler< TInputImage >
+::GetSampleSetSignature( std::string & signature ) const
+{
+  std::ostringstream os;
+  os << "ImageFullSampler;";
+  this->WriteSampleSetSignature( os );
+  signature = os.str();
+  return true;
+
+} // end GetSampleSetSignature()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -131,6 +131,10 @@ public:
   }
 
 
+  /** The samples only depend on the input, see GetSampleSetSignature(). */
+  virtual bool GetSampleSetSignature( std::string & signature ) const;
+
+
 protected:
 
   /** The constructor. */
@@ -22,6 +22,8 @@
 
 #include "itkImageRegionConstIteratorWithIndex.h"
 
+#include <sstream>
+
 namespace itk
 {
 
@@ -279,6 +281,25 @@ ImageGridSampler< TInputImage >
 } // end SetNumberOfSamples()
 
 
+/**
+ * ******************* GetSampleSetSignature *******************
+ */
+
+template< class TInputImage >
+bool
+ImageGridSampler< TInputImage >
+::GetSampleSetSignature( std::string & signature ) const
+{
+  std::ostringstream os;
+  os << "ImageGridSampler;";
+  os << "SampleGridSpacing:" << this->m_SampleGridSpacing << ';';
+  this->WriteSampleSetSignature( os );
+  signature = os.str();
+  return true;
+
+} // end GetSampleSetSignature()
+
+
 /**
  * ******************* PrintSelf *******************
  */
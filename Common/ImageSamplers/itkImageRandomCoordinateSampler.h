@@ -21,7 +21,7 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkInterpolateImageFunction.h"
 #include "itkBSplineInterpolateImageFunction.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkThreadRandomGenerator.h"
 
 namespace itk
 {
@@ -127,6 +127,8 @@ protected:
     const InputImageRegionType & inputRegionForThread,
     ThreadIdType threadId );
 
+  virtual void AfterThreadedGenerateData( void );
+
   /** Generate a point randomly in a bounding box. */
   virtual void GenerateRandomCoordinate(
     const InputImageContinuousIndexType & smallestContIndex,
@@ -137,6 +139,12 @@ protected:
   RandomGeneratorPointer m_RandomGenerator;
   InputImageSpacingType  m_SampleRegionSize;
 
+  /** Variables shared by the threads: the bounding box in which the random
+   * coordinates are generated, and the number of requested samples. */
+  InputImageContinuousIndexType m_ThreaderSmallestContIndex;
+  InputImageContinuousIndexType m_ThreaderLargestContIndex;
+  unsigned long                 m_ThreaderNumberOfRequestedSamples;
+
   /** Generate the two corners of a sampling region, given the two corners
   * of an image. If UseRandomSampleRegion=false, the smallesPoint and largestPoint
   * are just copies of the smallestImagePoint and largestImagePoint
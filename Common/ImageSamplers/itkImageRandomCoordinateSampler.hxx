@@ -39,11 +39,13 @@ ImageRandomCoordinateSampler< TInputImage >
   this->m_Interpolator = bsplineInterpolator;
 
   /** Setup random generator. */
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+  this->m_RandomGenerator = ThreadRandomGenerator::GetInstance();
 
   this->m_UseRandomSampleRegion = false;
   this->m_SampleRegionSize.Fill( 1.0 );
 
+  this->m_ThreaderNumberOfRequestedSamples = 0;
+
 } // end Constructor
 
 
@@ -56,9 +58,9 @@ void
 ImageRandomCoordinateSampler< TInputImage >
 ::GenerateData( void )
 {
-  /** Get a handle to the mask. If there was no mask supplied we exercise a multi-threaded version. */
+  /** If desired we exercise a multi-threaded version, also when a mask is supplied. */
   typename MaskType::ConstPointer mask = this->GetMask();
-  if( mask.IsNull() && this->m_UseMultiThread )
+  if( this->m_UseMultiThread )
   {
     /** Calls ThreadedGenerateData(). */
     return Superclass::GenerateData();
@@ -182,9 +184,12 @@ ImageRandomCoordinateSampler< TInputImage >
   typename InterpolatorType::Pointer interpolator = this->GetInterpolator();
   interpolator->SetInputImage( this->GetInput() ); // only once per resolution?
 
-  /** Clear the random number list. */
-  this->m_RandomNumberList.resize( 0 );
-  this->m_RandomNumberList.reserve( this->m_NumberOfSamples * InputImageDimension );
+  /** Update the mask. */
+  typename MaskType::ConstPointer mask = this->GetMask();
+  if( mask.IsNotNull() && mask->GetSource() )
+  {
+    mask->GetSource()->Update();
+  }
 
   /** Convert inputImageRegion to bounding box in physical space. */
   InputImageSizeType  unitSize; unitSize.Fill( 1 );
@@ -194,19 +199,14 @@ ImageRandomCoordinateSampler< TInputImage >
     = smallestIndex + this->GetCroppedInputImageRegion().GetSize() - unitSize;
   InputImageContinuousIndexType smallestImageCIndex( smallestIndex );
   InputImageContinuousIndexType largestImageCIndex( largestIndex );
-  InputImageContinuousIndexType smallestCIndex, largestCIndex, randomCIndex;
   this->GenerateSampleRegion( smallestImageCIndex, largestImageCIndex,
-    smallestCIndex, largestCIndex );
+    this->m_ThreaderSmallestContIndex, this->m_ThreaderLargestContIndex );
 
-  /** Fill the list with random numbers. */
-  for( unsigned long i = 0; i < this->m_NumberOfSamples; i++ )
-  {
-    this->GenerateRandomCoordinate( smallestCIndex, largestCIndex, randomCIndex );
-    for( unsigned int j = 0; j < InputImageDimension; ++j )
-    {
-      this->m_RandomNumberList.push_back( randomCIndex[ j ] );
-    }
-  }
+  /** The random coordinates are generated by the threads themselves, so only
+   * draw a new key for the counter-based random generator here.
+   */
+  this->InitializeThreaderRandomGenerator();
+  this->m_ThreaderNumberOfRequestedSamples = this->GetNumberOfSamples();
 
   /** Initialize variables needed for threads. */
   this->m_ThreaderSampleContainer.clear();
@@ -228,27 +228,22 @@ void
 ImageRandomCoordinateSampler< TInputImage >
 ::ThreadedGenerateData( const InputImageRegionType &, ThreadIdType threadId )
 {
-  /** Sanity check. */
-  typename MaskType::ConstPointer mask = this->GetMask();
-  if( mask.IsNotNull() )
-  {
-    itkExceptionMacro( << "ERROR: do not call this function when a mask is supplied." );
-  }
-
-  /** Get handle to the input image. */
-  InputImageConstPointer inputImage = this->GetInput();
+  /** Get handles to the input image, mask and interpolator. */
+  InputImageConstPointer          inputImage   = this->GetInput();
+  typename MaskType::ConstPointer mask         = this->GetMask();
+  InterpolatorType *              interpolator = this->GetInterpolator();
 
   /** Figure out which samples to process. */
-  unsigned long chunkSize   = this->GetNumberOfSamples() / this->GetNumberOfThreads();
-  unsigned long sampleStart = threadId * chunkSize * InputImageDimension;
+  const unsigned long numberOfSamples = this->m_ThreaderNumberOfRequestedSamples;
+  unsigned long       chunkSize       = numberOfSamples / this->GetNumberOfThreads();
+  const unsigned long sampleStart     = threadId * chunkSize;
   if( threadId == this->GetNumberOfThreads() - 1 )
   {
-    chunkSize = this->GetNumberOfSamples()
-      - ( ( this->GetNumberOfThreads() - 1 ) * chunkSize );
+    chunkSize = numberOfSamples - ( ( this->GetNumberOfThreads() - 1 ) * chunkSize );
   }
 
   /** Get a reference to the output and reserve memory for it. */
-  ImageSampleContainerPointer & sampleContainerThisThread // & ???
+  ImageSampleContainerPointer & sampleContainerThisThread
     = this->m_ThreaderSampleContainer[ threadId ];
   sampleContainerThisThread->Reserve( chunkSize );
 
@@ -256,33 +251,87 @@ ImageRandomCoordinateSampler< TInputImage >
   typename ImageSampleContainerType::Iterator iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
-  /** Fill the local sample container. */
+  /** Set up a variable that is used to make sure we are not forever
+   * walking around on this image, trying to look for valid samples. */
+  unsigned long       numberOfSamplesTried        = 0;
+  const unsigned long maximumNumberOfSamplesToTry = 10 * chunkSize;
+
+  /** Fill the local sample container. Sample i uses counter i of the random
+   * generator, and stream a * InputImageDimension + j for dimension j of
+   * attempt a, so that the samples do not depend on the number of threads.
+   */
   InputImageContinuousIndexType sampleCIndex;
   unsigned long                 sampleId = sampleStart;
-  for( iter = sampleContainerThisThread->Begin(); iter != end; ++iter )
+  for( iter = sampleContainerThisThread->Begin(); iter != end; ++iter, ++sampleId )
   {
-    /** Create a random point out of InputImageDimension random numbers. */
-    for( unsigned int j = 0; j < InputImageDimension; ++j, sampleId++ )
-    {
-      sampleCIndex[ j ] = this->m_RandomNumberList[ sampleId ];
-    }
-
     /** Make a reference to the current sample in the container. */
     InputImagePointType &  samplePoint = ( *iter ).Value().m_ImageCoordinates;
     ImageSampleValueType & sampleValue = ( *iter ).Value().m_ImageValue;
 
-    /** Convert to point */
-    inputImage->TransformContinuousIndexToPhysicalPoint( sampleCIndex, samplePoint );
+    /** Walk over the image until we find a valid point. */
+    for( unsigned long attempt = 0;; ++attempt )
+    {
+      /** Check if we are not trying eternally to find a valid point. */
+      ++numberOfSamplesTried;
+      if( numberOfSamplesTried > maximumNumberOfSamplesToTry )
+      {
+        /** Squeeze the sample container to the size that is still valid.
+         * AfterThreadedGenerateData() reports the error.
+         */
+        typename ImageSampleContainerType::iterator stlnow = sampleContainerThisThread->begin();
+        stlnow += iter.Index();
+        sampleContainerThisThread->erase( stlnow, sampleContainerThisThread->end() );
+        return;
+      }
+
+      /** Create a random point out of InputImageDimension random numbers. */
+      for( unsigned int j = 0; j < InputImageDimension; ++j )
+      {
+        sampleCIndex[ j ] = static_cast< InputImagePointValueType >(
+          this->m_ThreaderRandomGenerator.GetUniformVariate(
+          this->m_ThreaderSmallestContIndex[ j ], this->m_ThreaderLargestContIndex[ j ],
+          sampleId, attempt * InputImageDimension + j ) );
+      }
+
+      /** Convert to point */
+      inputImage->TransformContinuousIndexToPhysicalPoint( sampleCIndex, samplePoint );
+
+      if( mask.IsNull() ) { break; }
+      if( interpolator->IsInsideBuffer( sampleCIndex ) && mask->IsInside( samplePoint ) ) { break; }
+    }
 
     /** Compute the value at the contindex. */
     sampleValue = static_cast< ImageSampleValueType >(
-      this->m_Interpolator->EvaluateAtContinuousIndex( sampleCIndex ) );
+      interpolator->EvaluateAtContinuousIndex( sampleCIndex ) );
 
   } // end for loop
 
 } // end ThreadedGenerateData()
 
 
+/**
+ * ******************* AfterThreadedGenerateData *******************
+ */
+
+template< class TInputImage >
+void
+ImageRandomCoordinateSampler< TInputImage >
+::AfterThreadedGenerateData( void )
+{
+  /** Combine the results of all threads. */
+  Superclass::AfterThreadedGenerateData();
+
+  /** A thread could not find enough valid samples within the mask. */
+  if( this->GetNumberOfSamples() < this->m_ThreaderNumberOfRequestedSamples )
+  {
+    this->m_NumberOfSamples = this->m_ThreaderNumberOfRequestedSamples;
+    itkExceptionMacro( << "Could not find enough image samples within "
+                       << "reasonable time. Probably the mask is too small" );
+  }
+
+} // end AfterThreadedGenerateData()
+
+
 /**
  * ******************* GenerateRandomCoordinate *******************
  */
@@ -91,6 +91,11 @@ protected:
     const InputImageRegionType & inputRegionForThread,
     ThreadIdType threadId );
 
+  /** Translate a position in the cropped input image region to an index,
+   * like the ImageRandomConstIteratorWithIndex does.
+   */
+  void PositionToIndex( unsigned long position, InputImageIndexType & index ) const;
+
 private:
 
   /** The private constructor. */
@@ -19,6 +19,7 @@
 #define __ImageRandomSamplerBase_h
 
 #include "itkImageSamplerBase.h"
+#include "itkCounterBasedRandomGenerator.h"
 
 namespace itk
 {
@@ -85,9 +86,21 @@ protected:
   /** PrintSelf. */
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
+  /** Draw a new key for the m_ThreaderRandomGenerator from the global
+   * Mersenne Twister, so that every update gives new samples, while the
+   * samples are still reproducible for a fixed seed.
+   */
+  virtual void InitializeThreaderRandomGenerator( void );
+
   /** Member variable used when threading. */
   std::vector< double > m_RandomNumberList;
 
+  /** A counter-based random generator, that the threads can use
+   * concurrently. Counter i gives the random numbers of sample i,
+   * independent of the number of threads.
+   */
+  CounterBasedRandomGenerator m_ThreaderRandomGenerator;
+
 private:
 
   /** The private constructor. */
@@ -20,8 +20,7 @@
 
 #include "itkImageRandomSamplerBase.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
-#include "itkImageRandomConstIteratorWithIndex.h"
+#include "itkThreadRandomGenerator.h"
 
 namespace itk
 {
@@ -48,9 +47,9 @@ void
 ImageRandomSamplerBase< TInputImage >
 ::BeforeThreadedGenerateData( void )
 {
-  /** Create a random number generator. Also used in the ImageRandomConstIteratorWithIndex. */
+  /** Get the random number generator of the session. */
   typedef typename Statistics::MersenneTwisterRandomVariateGenerator::Pointer GeneratorPointer;
-  GeneratorPointer localGenerator = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  GeneratorPointer localGenerator = ThreadRandomGenerator::GetInstance();
   // \todo: should probably be global?
 
   /** Clear the random number list. */
@@ -74,6 +73,27 @@ ImageRandomSamplerBase< TInputImage >
 } // end BeforeThreadedGenerateData()
 
 
+/**
+ * ******************* InitializeThreaderRandomGenerator *******************
+ */
+
+template< class TInputImage >
+void
+ImageRandomSamplerBase< TInputImage >
+::InitializeThreaderRandomGenerator( void )
+{
+  typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  typedef CounterBasedRandomGenerator::KeyType              KeyType;
+  GeneratorType::Pointer localGenerator = ThreadRandomGenerator::GetInstance();
+
+  /** Combine two 32 bit integers into a 64 bit key. */
+  const KeyType high = static_cast< KeyType >( localGenerator->GetIntegerVariate() );
+  const KeyType low  = static_cast< KeyType >( localGenerator->GetIntegerVariate() );
+  this->m_ThreaderRandomGenerator.SetKey( ( high << 32 ) | low );
+
+} // end InitializeThreaderRandomGenerator()
+
+
 /**
  * ******************* PrintSelf *******************
  */
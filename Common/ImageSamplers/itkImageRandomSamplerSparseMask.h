@@ -19,7 +19,7 @@
 #define __ImageRandomSamplerSparseMask_h
 
 #include "itkImageRandomSamplerBase.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkThreadRandomGenerator.h"
 #include "itkImageFullSampler.h"
 
 namespace itk
@@ -32,7 +32,7 @@ ImageRandomSamplerSparseMask< TInputImage >
 ::ImageRandomSamplerSparseMask()
 {
   /** Setup random generator. */
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+  this->m_RandomGenerator = ThreadRandomGenerator::GetInstance();
 
   this->m_InternalFullSampler = InternalFullSamplerType::New();
 
@@ -68,6 +68,8 @@ ImageRandomSamplerSparseMask< TInputImage >
   this->m_InternalFullSampler->SetInput( inputImage );
   this->m_InternalFullSampler->SetMask( mask );
   this->m_InternalFullSampler->SetInputImageRegion( this->GetCroppedInputImageRegion() );
+  this->m_InternalFullSampler->SetUseMultiThread( this->m_UseMultiThread );
+  this->m_InternalFullSampler->SetNumberOfThreads( this->GetNumberOfThreads() );
 
   /** Use try/catch, since the full sampler may crash, due to insufficient memory. */
   try
@@ -127,21 +129,10 @@ void
 ImageRandomSamplerSparseMask< TInputImage >
 ::BeforeThreadedGenerateData( void )
 {
-  /** Clear the random number list. */
-  this->m_RandomNumberList.resize( 0 );
-  this->m_RandomNumberList.reserve( this->m_NumberOfSamples );
-
-  /** Get a handle to the full sampler output size. */
-  const unsigned long numberOfValidSamples
-    = this->m_InternalFullSampler->GetOutput()->Size();
-
-  /** Fill the list with random numbers. */
-  for( unsigned int i = 0; i < this->GetNumberOfSamples(); ++i )
-  {
-    unsigned long randomIndex
-      = this->m_RandomGenerator->GetIntegerVariate( numberOfValidSamples - 1 );
-    this->m_RandomNumberList.push_back( randomIndex );
-  }
+  /** The random indices are generated by the threads themselves, so only
+   * draw a new key for the counter-based random generator here.
+   */
+  this->InitializeThreaderRandomGenerator();
 
   /** Initialize variables needed for threads. */
   this->m_ThreaderSampleContainer.clear();
@@ -166,6 +157,7 @@ ImageRandomSamplerSparseMask< TInputImage >
   /** Get a handle to the full sampler output. */
   typename ImageSampleContainerType::Pointer allValidSamples
     = this->m_InternalFullSampler->GetOutput();
+  const unsigned long numberOfValidSamples = allValidSamples->Size();
 
   /** Figure out which samples to process. */
   unsigned long chunkSize   = this->GetNumberOfSamples() / this->GetNumberOfThreads();
@@ -185,11 +177,14 @@ ImageRandomSamplerSparseMask< TInputImage >
   typename ImageSampleContainerType::Iterator iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
-  /** Take random samples from the allValidSamples-container. */
+  /** Take random samples from the allValidSamples-container. Sample i uses
+   * counter i of the random generator, independent of the number of threads.
+   */
   unsigned long sampleId = sampleStart;
   for( iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++ )
   {
-    unsigned long randomIndex = static_cast< unsigned long >( this->m_RandomNumberList[ sampleId ] );
+    const unsigned long randomIndex
+      = this->m_ThreaderRandomGenerator.GetIntegerVariate( numberOfValidSamples - 1, sampleId );
     ( *iter ).Value() = allValidSamples->ElementAt( randomIndex );
   }
 
@@ -0,0 +1,91 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __ImageSampleBlock_h
+#define __ImageSampleBlock_h
+
+#include "itkImageSample.h"
+#include "itkIntTypes.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class ImageSampleBlock
+ *
+ * \brief A block of consecutive image samples, stored as a structure of
+ * arrays: the coordinates of all samples are stored contiguously, and so
+ * are the values.
+ *
+ * An ImageSample stores the point and the value of one sample next to each
+ * other. Metrics that process the samples one at a time need that layout,
+ * but a block of samples can be passed at once to, for example,
+ * AdvancedTransform::TransformPoints(), and loops over the values of a block
+ * can be vectorized by the compiler.
+ *
+ * The block is filled by ImageSamplerBase::GetOutputBlock(). The memory is
+ * reused when the block is filled again with the same or a smaller number
+ * of samples.
+ */
+
+template< class TImage >
+class ImageSampleBlock
+{
+public:
+
+  ImageSampleBlock() : m_Size( 0 ) {}
+  ~ImageSampleBlock() {}
+
+  /** Typedef's. */
+  typedef TImage                                    ImageType;
+  typedef ImageSample< ImageType >                  ImageSampleType;
+  typedef typename ImageSampleType::PointType       PointType;
+  typedef typename ImageSampleType::RealType        RealType;
+  typedef std::vector< PointType >                  PointContainerType;
+  typedef std::vector< RealType >                   ValueContainerType;
+
+  /** Set the number of samples in the block. Does not shrink the memory. */
+  void SetSize( const SizeValueType size )
+  {
+    if( size > this->m_ImageCoordinates.size() )
+    {
+      this->m_ImageCoordinates.resize( size );
+      this->m_ImageValues.resize( size );
+    }
+    this->m_Size = size;
+  }
+
+
+  /** Get the number of samples in the block. */
+  SizeValueType Size( void ) const
+  {
+    return this->m_Size;
+  }
+
+
+  /** Member variables. Only the first Size() entries are valid. */
+  PointContainerType m_ImageCoordinates;
+  ValueContainerType m_ImageValues;
+
+private:
+
+  SizeValueType m_Size;
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __ImageSampleBlock_h
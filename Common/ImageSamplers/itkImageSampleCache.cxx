@@ -0,0 +1,124 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkImageSampleCache_cxx
+#define __itkImageSampleCache_cxx
+
+#include "itkImageSampleCache.h"
+#include "itkMutexLockHolder.h"
+
+namespace itk
+{
+
+/**
+ * ****************** GetEntry *********************************
+ */
+
+ImageSampleCache::EntryConstPointer
+ImageSampleCache
+::GetEntry( const std::string & key ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  EntryMapType::const_iterator it = this->m_Entries.find( key );
+  if( it == this->m_Entries.end() ) { return NULL; }
+  return it->second;
+
+} // end GetEntry()
+
+
+/**
+ * ****************** SetEntry *********************************
+ */
+
+void
+ImageSampleCache
+::SetEntry( const std::string & key, const EntryType * entry )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  this->m_Entries[ key ] = entry;
+
+} // end SetEntry()
+
+
+/**
+ * ****************** Clear *********************************
+ */
+
+void
+ImageSampleCache
+::Clear( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  this->m_Entries.clear();
+
+} // end Clear()
+
+
+/**
+ * ****************** GetNumberOfEntries *********************************
+ */
+
+SizeValueType
+ImageSampleCache
+::GetNumberOfEntries( void ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  return static_cast< SizeValueType >( this->m_Entries.size() );
+
+} // end GetNumberOfEntries()
+
+
+/**
+ * ****************** GetMemorySize *********************************
+ */
+
+SizeValueType
+ImageSampleCache
+::GetMemorySize( void ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  SizeValueType memorySize = 0;
+  for( EntryMapType::const_iterator it = this->m_Entries.begin();
+    it != this->m_Entries.end(); ++it )
+  {
+    memorySize += it->second->GetMemorySize();
+  }
+  return memorySize;
+
+} // end GetMemorySize()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+ImageSampleCache
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfEntries: " << this->GetNumberOfEntries() << std::endl;
+  os << indent << "MemorySize: " << this->GetMemorySize() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkImageSampleCache_cxx
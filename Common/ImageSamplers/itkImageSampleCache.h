@@ -0,0 +1,212 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageSampleCache_h
+#define __itkImageSampleCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ImageSampleCacheEntry
+ *
+ * \brief Per-sample quantities of one sample set, stored as one integer
+ * index and a fixed number of values per sample.
+ *
+ * An entry is filled once, and is not modified after it has been stored
+ * in an ImageSampleCache, so that it can be read by several threads.
+ *
+ * \ingroup ImageSamplers
+ */
+
+class ImageSampleCacheEntry : public LightObject
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ImageSampleCacheEntry      Self;
+  typedef LightObject                Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkSimpleNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageSampleCacheEntry, LightObject );
+
+  /** Allocate the storage for a number of samples. */
+  void Allocate( const SizeValueType numberOfSamples,
+    const unsigned int numberOfValuesPerSample )
+  {
+    this->m_NumberOfValuesPerSample = numberOfValuesPerSample;
+    this->m_Indices.assign( numberOfSamples, 0 );
+    this->m_Values.assign( numberOfSamples * numberOfValuesPerSample, 0.0 );
+  }
+
+
+  /** Get the number of samples and values per sample. */
+  SizeValueType GetNumberOfSamples( void ) const
+  {
+    return static_cast< SizeValueType >( this->m_Indices.size() );
+  }
+
+
+  unsigned int GetNumberOfValuesPerSample( void ) const
+  {
+    return this->m_NumberOfValuesPerSample;
+  }
+
+
+  /** Access to the index and the values of a sample. */
+  OffsetValueType & GetIndex( const SizeValueType sample )
+  {
+    return this->m_Indices[ sample ];
+  }
+
+
+  OffsetValueType GetIndex( const SizeValueType sample ) const
+  {
+    return this->m_Indices[ sample ];
+  }
+
+
+  double * GetValues( const SizeValueType sample )
+  {
+    return &this->m_Values[ 0 ] + sample * this->m_NumberOfValuesPerSample;
+  }
+
+
+  const double * GetValues( const SizeValueType sample ) const
+  {
+    return &this->m_Values[ 0 ] + sample * this->m_NumberOfValuesPerSample;
+  }
+
+
+  /** Get the size of the stored data in bytes. */
+  SizeValueType GetMemorySize( void ) const
+  {
+    return static_cast< SizeValueType >( this->m_Indices.size() * sizeof( OffsetValueType )
+           + this->m_Values.size() * sizeof( double ) );
+  }
+
+
+protected:
+
+  ImageSampleCacheEntry() : m_NumberOfValuesPerSample( 0 ) {}
+  virtual ~ImageSampleCacheEntry() {}
+
+private:
+
+  ImageSampleCacheEntry( const Self & ); // purposely not implemented
+  void operator=( const Self & );        // purposely not implemented
+
+  std::vector< OffsetValueType > m_Indices;
+  std::vector< double >          m_Values;
+  unsigned int                   m_NumberOfValuesPerSample;
+
+};
+
+/** \class ImageSampleCache
+ *
+ * \brief Stores quantities per sample that do not change between the
+ * iterations of a resolution, such as the fixed image Parzen window of
+ * a sample.
+ *
+ * This only makes sense for deterministic samplers, that return the same
+ * samples in every iteration: the ImageFullSampler and the ImageGridSampler.
+ * These samplers describe their sample set with a signature, see
+ * ImageSamplerBase::GetSampleSetSignature(). An entry is stored under a key
+ * that combines the name of the quantity, the signature of the sample set,
+ * and the settings that the quantity depends on. Metrics that use the same
+ * sample set and settings, for example the sub-metrics of a
+ * CombinationImageToImageMetric, can therefore share an entry.
+ *
+ * Getting and storing entries is thread safe. Entries are computed outside
+ * the lock; if two metrics compute the same entry at once, the last one is
+ * kept, which is harmless since the entries are equal.
+ *
+ * \ingroup ImageSamplers
+ */
+
+class ImageSampleCache : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ImageSampleCache           Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageSampleCache, Object );
+
+  /** Typedefs. */
+  typedef ImageSampleCacheEntry        EntryType;
+  typedef EntryType::Pointer           EntryPointer;
+  typedef EntryType::ConstPointer      EntryConstPointer;
+
+  /** Get the entry stored under a key; NULL if there is none. */
+  EntryConstPointer GetEntry( const std::string & key ) const;
+
+  /** Store an entry under a key, replacing a previous one. */
+  void SetEntry( const std::string & key, const EntryType * entry );
+
+  /** Remove all entries. Typically called at the start of a resolution. */
+  void Clear( void );
+
+  /** Get the number of entries. */
+  SizeValueType GetNumberOfEntries( void ) const;
+
+  /** Get the size of the stored data of all entries in bytes. */
+  SizeValueType GetMemorySize( void ) const;
+
+protected:
+
+  ImageSampleCache() {}
+  virtual ~ImageSampleCache() {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  ImageSampleCache( const Self & ); // purposely not implemented
+  void operator=( const Self & );   // purposely not implemented
+
+  typedef std::map< std::string, EntryConstPointer > EntryMapType;
+
+  EntryMapType                m_Entries;
+  mutable SimpleFastMutexLock m_Mutex;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkImageSampleCache_h
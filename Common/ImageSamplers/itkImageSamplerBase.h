@@ -20,9 +20,12 @@
 
 #include "itkImageToVectorContainerFilter.h"
 #include "itkImageSample.h"
+#include "itkImageSampleBlock.h"
 #include "itkVectorDataContainer.h"
 #include "itkSpatialObject.h"
 
+#include <string>
+
 namespace itk
 {
 /** \class ImageSamplerBase
@@ -76,6 +79,7 @@ public:
   /** Other typdefs. */
   typedef ImageSample< InputImageType >                         ImageSampleType;
   typedef VectorDataContainer< unsigned long, ImageSampleType > ImageSampleContainerType;
+  typedef ImageSampleBlock< InputImageType >                    ImageSampleBlockType;
   typedef typename ImageSampleContainerType::Pointer            ImageSampleContainerPointer;
   typedef typename InputImageType::SizeType                     InputImageSizeType;
   typedef typename InputImageType::IndexType                    InputImageIndexType;
@@ -170,6 +174,26 @@ public:
   /** \todo: Temporary, should think about interface. */
   itkSetMacro( UseMultiThread, bool );
 
+  /** Copy the samples [first, first + count) of the output into a block,
+   * which stores the coordinates and the values in separate arrays.
+   * The range is clipped to the number of samples in the output; the size
+   * of the block is set to the number of copied samples.
+   */
+  void GetOutputBlock( const unsigned long first, const unsigned long count,
+    ImageSampleBlockType & block );
+
+  /** Get a signature of the current sample set: a string that is equal for
+   * two samplers, or two updates of a sampler, if and only if they produce
+   * the same samples in the same order. Only deterministic samplers can
+   * provide one; for the others this function returns false.
+   * Should be called after Update(). See ImageSampleCache.
+   */
+  virtual bool GetSampleSetSignature( std::string & itkNotUsed( signature ) ) const
+  {
+    return false;
+  }
+
+
 protected:
 
   /** The constructor. */
@@ -198,6 +222,12 @@ protected:
   /** Compute the intersection of the InputImageRegion and the bounding box of the mask. */
   void CropInputImageRegion( void );
 
+  /** Write the input image, the masks, the cropped input image region and
+   * the number of samples to a signature, see GetSampleSetSignature().
+   * The images and masks are identified by their address and modification time.
+   */
+  void WriteSampleSetSignature( std::ostream & os ) const;
+
   /** Multi-threaded function that does the work. */
   virtual void BeforeThreadedGenerateData( void );
 
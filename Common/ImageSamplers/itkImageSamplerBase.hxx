@@ -458,6 +458,61 @@ ImageSamplerBase< TInputImage >
 } // end AfterThreadedGenerateData()
 
 
+/**
+ * ******************* GetOutputBlock *******************
+ */
+
+template< class TInputImage >
+void
+ImageSamplerBase< TInputImage >
+::GetOutputBlock( const unsigned long first, const unsigned long count,
+  ImageSampleBlockType & block )
+{
+  /** Clip the range to the output. */
+  const ImageSampleContainerType * sampleContainer = this->GetOutput();
+  const unsigned long              size            = sampleContainer->Size();
+  const unsigned long              begin           = first < size ? first : size;
+  const unsigned long              end             = count < size - begin ? begin + count : size;
+  block.SetSize( end - begin );
+
+  /** Copy, in separate loops for the coordinates and the values. */
+  for( unsigned long i = begin; i < end; ++i )
+  {
+    block.m_ImageCoordinates[ i - begin ] = sampleContainer->ElementAt( i ).m_ImageCoordinates;
+  }
+  for( unsigned long i = begin; i < end; ++i )
+  {
+    block.m_ImageValues[ i - begin ] = sampleContainer->ElementAt( i ).m_ImageValue;
+  }
+
+} // end GetOutputBlock()
+
+
+/**
+ * ******************* WriteSampleSetSignature *******************
+ */
+
+template< class TInputImage >
+void
+ImageSamplerBase< TInputImage >
+::WriteSampleSetSignature( std::ostream & os ) const
+{
+  const InputImageType * inputImage = this->GetInput();
+  os << "Input:" << inputImage << '@'
+     << ( inputImage ? inputImage->GetMTime() : 0 ) << ';';
+  for( unsigned int i = 0; i < this->m_MaskVector.size(); ++i )
+  {
+    const MaskType * mask = this->m_MaskVector[ i ].GetPointer();
+    os << "Mask" << i << ':' << mask << '@' << ( mask ? mask->GetMTime() : 0 ) << ';';
+  }
+  os << "Region:" << this->m_CroppedInputImageRegion.GetIndex()
+     << this->m_CroppedInputImageRegion.GetSize() << ';';
+  os << "NumberOfSamples:"
+     << const_cast< Self * >( this )->GetOutput()->Size() << ';';
+
+} // end WriteSampleSetSignature()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -19,6 +19,7 @@
 #define __itkImageToVectorContainerFilter_h
 
 #include "itkVectorContainerSource.h"
+#include "itkWorkerThreadPool.h"
 
 namespace itk
 {
@@ -80,6 +81,12 @@ public:
   /** Prepare the output. */
   //virtual void GenerateOutputInformation( void );
 
+  /** Select the use of the persistent WorkerThreadPool for the threaded
+   * GenerateData(); default true. If false, the ITK MultiThreader is used. */
+  itkSetMacro( UseThreadPool, bool );
+  itkGetConstMacro( UseThreadPool, bool );
+  itkBooleanMacro( UseThreadPool );
+
   /** A version of GenerateData() specific for image processing
    * filters.  This implementation will split the processing across
    * multiple threads. The buffer is allocated by this method. Then
@@ -176,6 +183,8 @@ protected:
   /** PrintSelf. */
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
+  bool m_UseThreadPool;
+
 private:
 
   /** The private constructor. */
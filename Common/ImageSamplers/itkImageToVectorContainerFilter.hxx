@@ -41,6 +41,8 @@ ImageToVectorContainerFilter< TInputImage, TOutputVectorContainer >
   this->ProcessObject::SetNumberOfRequiredOutputs( 1 );
   this->ProcessObject::SetNthOutput( 0, output.GetPointer() );
 
+  this->m_UseThreadPool = true;
+
 } // end Constructor
 
 
@@ -136,6 +138,8 @@ ImageToVectorContainerFilter< TInputImage, TOutputVectorContainer >
 ::PrintSelf( std::ostream & os, Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
+
+  os << indent << "UseThreadPool: " << this->m_UseThreadPool << std::endl;
 } // end PrintSelf()
 
 
@@ -228,10 +232,18 @@ ImageToVectorContainerFilter< TInputImage, TOutputVectorContainer >
   str.Filter = this;
 
   this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
-  this->GetMultiThreader()->SetSingleMethod( this->ThreaderCallback, &str );
 
   // multithread the execution
-  this->GetMultiThreader()->SingleMethodExecute();
+  if( this->m_UseThreadPool )
+  {
+    WorkerThreadPool::GetInstance()->Execute( this->ThreaderCallback, &str,
+      this->GetMultiThreader()->GetNumberOfThreads() );
+  }
+  else
+  {
+    this->GetMultiThreader()->SetSingleMethod( this->ThreaderCallback, &str );
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
 
   // Call a method that can be overridden by a subclass to perform
   // some calculations after all the threads have completed
@@ -21,6 +21,7 @@
 
 #include "itkLineSearchOptimizer.h"
 #include "itkNumericTraits.h"
+#include "itkParameterVectorOperations.h"
 
 namespace itk
 {
@@ -57,14 +58,8 @@ LineSearchOptimizer
 
   this->m_CurrentStepLength = step;
 
-  ParametersType         newPosition        =  this->GetInitialPosition();
-  const unsigned int     numberOfParameters = newPosition.GetSize();
-  const ParametersType & LSD                = this->GetLineSearchDirection();
-
-  for( unsigned int i = 0; i < numberOfParameters; ++i )
-  {
-    newPosition[ i ] += ( step * LSD[ i ] );
-  }
+  ParametersType newPosition = this->GetInitialPosition();
+  ParameterVectorOperations::Axpy( step, this->GetLineSearchDirection(), newPosition );
 
   this->SetCurrentPosition( newPosition );
 
@@ -81,8 +76,7 @@ double
 LineSearchOptimizer
 ::DirectionalDerivative( const DerivativeType & derivative ) const
 {
-  /** Easy, thanks to the functions defined in vnl_vector.h */
-  return inner_product( derivative, this->GetLineSearchDirection() );
+  return ParameterVectorOperations::Dot( derivative, this->GetLineSearchDirection() );
 
 } // end DirectionalDerivative()
 
@@ -241,6 +241,12 @@ public:
     ParameterIndexArrayType & indices,
     bool & inside ) const;
 
+  /** Transform a contiguous block of points. The weights and indices
+   * buffers are allocated only once for the whole block.
+   */
+  virtual void TransformPoints( const InputPointType * inputPoints,
+    OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const;
+
   /** Get number of weights. */
   unsigned long GetNumberOfWeights( void ) const
   {
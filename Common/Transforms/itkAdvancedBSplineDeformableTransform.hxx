@@ -337,6 +337,34 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
 }
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::TransformPoints( const InputPointType * inputPoints,
+  OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const
+{
+  /** Allocate memory on the stack, once for all points. */
+  const unsigned long numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray[ numberOfWeights ];
+  typename ParameterIndexArrayType::ValueType indicesArray[ numberOfWeights ];
+  WeightsType             weights( weightsArray, numberOfWeights, false );
+  ParameterIndexArrayType indices( indicesArray, numberOfWeights, false );
+
+  bool inside;
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    /** Copy the input point, to support in-place transformation. */
+    const InputPointType point = inputPoints[ i ];
+    this->TransformPoint( point, outputPoints[ i ], weights, indices, inside );
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ********************* GetNumberOfAffectedWeights ****************************
  */
@@ -162,6 +162,13 @@ public:
   /**  Method to transform a point. */
   virtual OutputPointType TransformPoint( const InputPointType  & point ) const;
 
+  /** Method to transform a contiguous block of points. The batch is
+   * forwarded to the TransformPoints() of the initial and current
+   * transform, so that their batch implementations are used.
+   */
+  virtual void TransformPoints( const InputPointType * inputPoints,
+    OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const;
+
   /** ITK4 change:
    * The following pure virtual functions must be overloaded.
    * For now just throw an exception, since these are not used in elastix.
@@ -1613,6 +1613,67 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end TransformPoint()
 
 
+/**
+ * ****************** TransformPoints ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::TransformPoints( const InputPointType * inputPoints,
+  OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const
+{
+  if( numberOfPoints == 0 ) { return; }
+
+  /** Follow the same selection as UpdateCombinationMethod(). */
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( this->m_InitialTransform.IsNull() )
+  {
+    this->m_CurrentTransform->TransformPoints(
+      inputPoints, outputPoints, numberOfPoints );
+  }
+  else if( this->m_UseAddition )
+  {
+    /** T(x) = T0(x) + T1(x) - x. Store T0(x) - x first, since the
+     * input and output may be the same buffer.
+     */
+    std::vector< OutputPointType > out0( numberOfPoints );
+    this->m_InitialTransform->TransformPoints(
+      inputPoints, &out0[ 0 ], numberOfPoints );
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      for( unsigned int j = 0; j < SpaceDimension; ++j )
+      {
+        out0[ i ][ j ] -= inputPoints[ i ][ j ];
+      }
+    }
+
+    this->m_CurrentTransform->TransformPoints(
+      inputPoints, outputPoints, numberOfPoints );
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      for( unsigned int j = 0; j < SpaceDimension; ++j )
+      {
+        outputPoints[ i ][ j ] += out0[ i ][ j ];
+      }
+    }
+  }
+  else
+  {
+    /** T(x) = T1( T0(x) ), computed in place in the output buffer. */
+    this->m_InitialTransform->TransformPoints(
+      inputPoints, outputPoints, numberOfPoints );
+    this->m_CurrentTransform->TransformPoints(
+      outputPoints, outputPoints, numberOfPoints );
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ****************** GetJacobian ****************************
  */
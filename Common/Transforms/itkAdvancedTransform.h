@@ -37,6 +37,7 @@
 #include "itkTransform.h"
 #include "itkMatrix.h"
 #include "itkFixedArray.h"
+#include "itkWorkerThreadPool.h"
 
 namespace itk
 {
@@ -158,6 +159,32 @@ public:
   typedef OutputCovariantVectorType                   MovingImageGradientType;
   typedef typename MovingImageGradientType::ValueType MovingImageGradientValueType;
 
+  /** Containers for batched point transformation. */
+  typedef std::vector< InputPointType >  InputPointContainerType;
+  typedef std::vector< OutputPointType > OutputPointContainerType;
+
+  /** Transform a contiguous block of points.
+   * The default implementation calls TransformPoint() for every point.
+   * Derived classes may override it, to hoist the per-call work out of
+   * the loop over the points. In-place transformation (inputPoints ==
+   * outputPoints) must be supported by overriding implementations.
+   */
+  virtual void TransformPoints( const InputPointType * inputPoints,
+    OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const;
+
+  /** Transform all points of a container, by splitting it in contiguous
+   * blocks that are transformed by TransformPoints() in parallel, using
+   * the WorkerThreadPool. The output container is resized when needed.
+   * This requires TransformPoint() to be thread-safe: it may not build
+   * caches lazily or change any other member. This holds for all elastix
+   * transforms, which only read their parameters, coefficient images and
+   * sub transforms in TransformPoint(). The result equals that of calling
+   * TransformPoint() for every point, see TransformPointsMultiThreadedTest.
+   */
+  void TransformPointsMultiThreaded( const InputPointContainerType & inputPoints,
+    OutputPointContainerType & outputPoints,
+    const ThreadIdType numberOfThreads ) const;
+
   /** Get the number of nonzero Jacobian indices. By default all. */
   virtual NumberOfParametersType GetNumberOfNonZeroJacobianIndices( void ) const;
 
@@ -319,6 +346,18 @@ protected:
   bool m_HasNonZeroSpatialHessian;
   bool m_HasNonZeroJacobianOfSpatialHessian;
 
+  /** Threader callback for TransformPointsMultiThreaded(). */
+  static ITK_THREAD_RETURN_TYPE TransformPointsThreaderCallback( void * arg );
+
+  /** Struct to pass the batch to the threads. */
+  struct TransformPointsThreaderParameterType
+  {
+    const Self *            st_Transform;
+    const InputPointType *  st_InputPoints;
+    OutputPointType *       st_OutputPoints;
+    SizeValueType           st_NumberOfPoints;
+  };
+
 private:
 
   AdvancedTransform( const Self & ); // purposely not implemented
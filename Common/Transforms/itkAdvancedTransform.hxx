@@ -107,6 +107,95 @@ AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPoints( const InputPointType * inputPoints,
+  OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const
+{
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    outputPoints[ i ] = this->TransformPoint( inputPoints[ i ] );
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* TransformPointsMultiThreaded ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPointsMultiThreaded( const InputPointContainerType & inputPoints,
+  OutputPointContainerType & outputPoints,
+  const ThreadIdType numberOfThreads ) const
+{
+  const SizeValueType numberOfPoints = inputPoints.size();
+  outputPoints.resize( numberOfPoints );
+  if( numberOfPoints == 0 ) { return; }
+
+  /** Setup the threader parameters. */
+  TransformPointsThreaderParameterType threaderParameters;
+  threaderParameters.st_Transform      = this;
+  threaderParameters.st_InputPoints    = &inputPoints[ 0 ];
+  threaderParameters.st_OutputPoints   = &outputPoints[ 0 ];
+  threaderParameters.st_NumberOfPoints = numberOfPoints;
+
+  /** Do not use more threads than points. */
+  ThreadIdType nrOfThreads = numberOfThreads > 0 ? numberOfThreads : 1;
+  if( numberOfPoints < nrOfThreads )
+  {
+    nrOfThreads = static_cast< ThreadIdType >( numberOfPoints );
+  }
+
+  /** Launch. */
+  WorkerThreadPool::GetInstance()->Execute(
+    TransformPointsThreaderCallback, &threaderParameters, nrOfThreads );
+
+} // end TransformPointsMultiThreaded()
+
+
+/**
+ * ********************* TransformPointsThreaderCallback ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+ITK_THREAD_RETURN_TYPE
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPointsThreaderCallback( void * arg )
+{
+  typedef MultiThreader::ThreadInfoStruct ThreadInfoType;
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  TransformPointsThreaderParameterType * temp
+    = static_cast< TransformPointsThreaderParameterType * >( infoStruct->UserData );
+
+  /** Each thread transforms a contiguous block of points. */
+  const SizeValueType numberOfPoints = temp->st_NumberOfPoints;
+  const SizeValueType subSize        = ( numberOfPoints + nrOfThreads - 1 ) / nrOfThreads;
+  const SizeValueType jmin           = threadID * subSize;
+  SizeValueType       jmax           = ( threadID + 1 ) * subSize;
+  jmax = ( jmax > numberOfPoints ) ? numberOfPoints : jmax;
+
+  if( jmin < jmax )
+  {
+    temp->st_Transform->TransformPoints(
+      temp->st_InputPoints + jmin, temp->st_OutputPoints + jmin, jmax - jmin );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end TransformPointsThreaderCallback()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
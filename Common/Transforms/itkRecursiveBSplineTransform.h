@@ -133,6 +133,13 @@ public:
    */
   virtual OutputPointType TransformPoint( const InputPointType & point ) const;
 
+  /** Transform a contiguous block of points. The coefficient check, the
+   * offset table and the coefficient buffer pointers are set up only once
+   * for the whole block.
+   */
+  virtual void TransformPoints( const InputPointType * inputPoints,
+    OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const;
+
   /** Compute the Jacobian of the transformation. */
   virtual void GetJacobian(
     const InputPointType & ipp,
@@ -115,6 +115,87 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
 } // end TransformPoint()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::TransformPoints( const InputPointType * inputPoints,
+  OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const
+{
+  /** Define some constants. */
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+
+  /** Check if the coefficient image has been set. */
+  if( !this->m_CoefficientImages[ 0 ] )
+  {
+    itkWarningMacro( << "B-spline coefficients have not been set" );
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      outputPoints[ i ] = inputPoints[ i ];
+    }
+    return;
+  }
+
+  /** Allocate weights on the stack, once for all points. */
+  typename WeightsType::ValueType weightsArray1D[ numberOfWeights ];
+  WeightsType weights1D( weightsArray1D, numberOfWeights, false );
+
+  /** Initialize (helper) variables, that are the same for all points. */
+  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+  ScalarType *            coefficientBuffers[ SpaceDimension ];
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    coefficientBuffers[ j ] = this->m_CoefficientImages[ j ]->GetBufferPointer();
+  }
+
+  ContinuousIndexType cindex;
+  IndexType           supportIndex;
+  ScalarType *        mu[ SpaceDimension ];
+  ScalarType          displacement[ SpaceDimension ];
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    /** Copy the input point, to support in-place transformation. */
+    const InputPointType point = inputPoints[ i ];
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    this->TransformPointToContinuousGridIndex( point, cindex );
+    if( !this->InsideValidRegion( cindex ) )
+    {
+      outputPoints[ i ] = point;
+      continue;
+    }
+
+    // Compute interpolation weighs and store them in weights1D
+    this->m_RecursiveBSplineWeightFunction->Evaluate( cindex, weights1D, supportIndex );
+
+    OffsetValueType totalOffsetToSupportIndex = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      totalOffsetToSupportIndex += supportIndex[ j ] * bsplineOffsetTable[ j ];
+    }
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      mu[ j ] = coefficientBuffers[ j ] + totalOffsetToSupportIndex;
+    }
+
+    /** Call the recursive TransformPoint function. */
+    RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::TransformPoint( displacement, mu, bsplineOffsetTable, weightsArray1D );
+
+    // The output point is the start point + displacement.
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      outputPoints[ i ][ j ] = displacement[ j ] + point[ j ];
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ********************* GetJacobian ****************************
  */
@@ -25,6 +25,7 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkImageFullSampler.h"
 #include "itkMultiThreader.h"
+#include "itkWorkerThreadPool.h"
 
 namespace itk
 {
@@ -95,6 +96,10 @@ public:
   /** Set some parameters. */
   itkSetMacro( NumberOfJacobianMeasurements, SizeValueType );
 
+  /** Select the use of the persistent WorkerThreadPool; default true. */
+  itkSetMacro( UseThreadPool, bool );
+  itkGetConstMacro( UseThreadPool, bool );
+
   /** Set the region over which the metric will be computed. */
   void SetFixedImageRegion( const FixedImageRegionType & region )
   {
@@ -217,6 +222,7 @@ protected:
 
   SizeValueType               m_NumberOfPixelsCounted;
   bool                        m_UseMultiThread;
+  bool                        m_UseThreadPool;
   ImageSampleContainerPointer m_SampleContainer;
 
 private:
@@ -52,6 +52,7 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
 
   /** Threading related variables. */
   this->m_UseMultiThread = true;
+  this->m_UseThreadPool  = true;
   this->m_Threader       = ThreaderType::New();
   this->m_Threader->SetUseThreadPool( false );
 
@@ -319,12 +320,20 @@ void
 ComputeDisplacementDistribution< TFixedImage, TTransform >
 ::LaunchComputeThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputeThreaderCallback,
-    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderParameters ) ) );
+  void * userData = const_cast< void * >(
+    static_cast< const void * >( &this->m_ThreaderParameters ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  /** Launch, reusing the persistent worker threads if possible. */
+  if( this->m_UseThreadPool )
+  {
+    WorkerThreadPool::GetInstance()->Execute( this->ComputeThreaderCallback,
+      userData, this->m_Threader->GetNumberOfThreads() );
+  }
+  else
+  {
+    this->m_Threader->SetSingleMethod( this->ComputeThreaderCallback, userData );
+    this->m_Threader->SingleMethodExecute();
+  }
 
 } // end LaunchComputeThreaderCallback()
 
@@ -22,6 +22,13 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkMultiThreader.h"
+#include "itkWorkerThreadPool.h"
+
+#include "vnl/vnl_diag_matrix.h"
+#include "vnl/vnl_sparse_matrix.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -31,6 +38,15 @@ namespace itk
  * More specifically this class computes the Jacobian terms related to the automatic
  * parameter estimation for the adaptive stochastic gradient descent optimizer.
  * Details can be found in the paper.
+ *
+ * Compute() is multi-threaded. The Jacobians of the samples are computed in
+ * batches by all threads. The covariance matrix C is then accumulated with
+ * row ownership: each thread adds the J_j^T J_j contributions of the batch
+ * to the rows of C it owns, so that no locking, and no copy of C per thread,
+ * is needed. The maxima of terms 3 and 4 are computed per thread, and
+ * combined afterwards. Since the batches have a fixed size and the rows are
+ * updated in sample order, the result does not depend on the number of
+ * threads. ComputeSingleThreaded() is the original implementation.
  */
 
 template< class TFixedImage, class TTransform >
@@ -103,14 +119,37 @@ public:
   /** Get the region over which the metric will be computed. */
   itkGetConstReferenceMacro( FixedImageRegion, FixedImageRegionType );
 
-  /** The main functions that performs the computation. */
+  /** Select the use of multi-threading; default true. */
+  itkSetMacro( UseMultiThread, bool );
+  itkGetConstMacro( UseMultiThread, bool );
+
+  /** Select the use of the persistent WorkerThreadPool; default true. */
+  itkSetMacro( UseThreadPool, bool );
+  itkGetConstMacro( UseThreadPool, bool );
+
+  /** Set the number of threads. */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
+  /** The main function that performs the multi-threaded computation. */
   virtual void Compute( double & TrC, double & TrCC,
     double & maxJJ, double & maxJCJ );
 
+  /** The main function that performs the single-threaded computation. */
+  virtual void ComputeSingleThreaded( double & TrC, double & TrCC,
+    double & maxJJ, double & maxJCJ );
+
 protected:
 
   ComputeJacobianTerms();
-  virtual ~ComputeJacobianTerms() {}
+  virtual ~ComputeJacobianTerms();
+
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreader             ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreadInfoType;
 
   typename FixedImageType::ConstPointer m_FixedImage;
   FixedImageRegionType       m_FixedImageRegion;
@@ -145,12 +184,114 @@ protected:
   typedef typename TransformType::ScalarType             CoordinateRepresentationType;
   typedef typename TransformType::NumberOfParametersType NumberOfParametersType;
 
+  /** Typedefs for the covariance matrix. */
+  typedef double                                   CovarianceValueType;
+  typedef itk::Array2D< CovarianceValueType >      CovarianceMatrixType;
+  typedef vnl_sparse_matrix< CovarianceValueType > SparseCovarianceMatrixType;
+  typedef SparseCovarianceMatrixType::row          SparseRowType;
+  typedef itk::Array< SizeValueType >              NonZeroJacobianIndicesExpandedType;
+  typedef vnl_diag_matrix< CovarianceValueType >   DiagCovarianceMatrixType;
+  typedef std::vector< unsigned int >              BandCovarianceMapType;
+
   /** Sample the fixed image to compute the Jacobian terms. */
   // \todo: note that this is an exact copy of itk::ComputeDisplacementDistribution
   // in the future it would be better to refactoring this part of the code.
   virtual void SampleFixedImageForJacobianTerms(
     ImageSampleContainerPointer & sampleContainer );
 
+  /** Guess the band structure of the covariance matrix from a few samples.
+   * bandcovMap maps a parameter number difference q-p to a column of the
+   * band matrix, or to the number of bands if it is not stored in the band
+   * matrix. bandcovMap2 maps a column of the band matrix back to q-p.
+   */
+  virtual void ComputeBandStructure(
+    const ImageSampleContainerType * sampleContainer,
+    BandCovarianceMapType & bandcovMap,
+    BandCovarianceMapType & bandcovMap2 ) const;
+
+  /** The stages of the multi-threaded computation. */
+  typedef enum {
+    ComputeJacobiansStage,
+    UpdateCovarianceStage,
+    FinalizeCovarianceStage,
+    ComputeMaximaStage
+  } ThreadedStageType;
+
+  /** Launch a stage of the multi-threaded computation. */
+  void LaunchComputeThreaderCallback( const ThreadedStageType stage );
+
+  /** Compute threader callback function. */
+  static ITK_THREAD_RETURN_TYPE ComputeThreaderCallback( void * arg );
+
+  /** Compute the Jacobians of a part of the current batch of samples. */
+  virtual void ThreadedComputeJacobians( ThreadIdType threadID );
+
+  /** Add the J_j^T J_j of the current batch to the rows of C that are
+   * owned by this thread.
+   */
+  virtual void ThreadedUpdateCovariance( ThreadIdType threadID );
+
+  /** Move the band matrix into the sparse matrix, apply the scales, and
+   * compute the diagonal and the squared norm of a range of rows of C.
+   */
+  virtual void ThreadedFinalizeCovariance( ThreadIdType threadID );
+
+  /** Compute maxJJ and maxJCJ over a range of samples. */
+  virtual void ThreadedComputeMaxima( ThreadIdType threadID );
+
+  /** Initialize some multi-threading related parameters. */
+  virtual void InitializeThreadingParameters( void );
+
+  /** Split the batch of samples in runs of consecutive valid samples with
+   * the same nonzero Jacobian indices.
+   */
+  void ComputeBatchRuns( void );
+
+  /** To give the threads access to all member variables and functions. */
+  struct MultiThreaderParameterType
+  {
+    Self *            st_Self;
+    ThreadedStageType st_Stage;
+  };
+  MultiThreaderParameterType m_ThreaderParameters;
+
+  struct ComputePerThreadStruct
+  {
+    /**  Used for accumulating variables. */
+    double st_MaxJJ;
+    double st_MaxJCJ;
+  };
+  itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, ComputePerThreadStruct,
+    PaddedComputePerThreadStruct );
+  itkAlignedTypedef( ITK_CACHE_LINE_ALIGNMENT, PaddedComputePerThreadStruct,
+    AlignedComputePerThreadStruct );
+  AlignedComputePerThreadStruct * m_ComputePerThreadVariables;
+  ThreadIdType                    m_ComputePerThreadVariablesSize;
+
+  ThreaderType::Pointer m_Threader;
+  bool                  m_UseMultiThread;
+  bool                  m_UseThreadPool;
+
+  /** The samples, and the current batch of them. The batch size is fixed,
+   * so that the result does not depend on the number of threads.
+   */
+  ImageSampleContainerPointer               m_SampleContainer;
+  SizeValueType                             m_NumberOfSamplesPerBatch;
+  SizeValueType                             m_BatchBegin;
+  SizeValueType                             m_BatchEnd;
+  std::vector< JacobianType >               m_BatchJacobians;
+  std::vector< NonZeroJacobianIndicesType > m_BatchNonZeroJacobianIndices;
+  std::vector< SizeValueType >              m_BatchValidSamples;
+  std::vector< SizeValueType >              m_BatchRuns;
+
+  /** The covariance matrix, in sparse, diagonal and band form. */
+  SparseCovarianceMatrixType m_Covariance;
+  DiagCovarianceMatrixType   m_DiagonalCovariance;
+  CovarianceMatrixType       m_BandCovariance;
+  BandCovarianceMapType      m_BandCovarianceMap;
+  BandCovarianceMapType      m_BandCovarianceMap2;
+  std::vector< double >      m_RowSquaredNorms;
+
 private:
 
   ComputeJacobianTerms( const Self & ); // purposely not implemented
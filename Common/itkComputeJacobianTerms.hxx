@@ -25,6 +25,8 @@
 #include "vnl/vnl_diag_matrix.h"
 #include "vnl/vnl_sparse_matrix.h"
 
+#include <algorithm>
+
 namespace itk
 {
 /**
@@ -45,9 +47,70 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   this->m_NumberOfBandStructureSamples = 0;
   this->m_NumberOfJacobianMeasurements = 0;
 
+  /** Threading related variables. */
+  this->m_UseMultiThread = true;
+  this->m_UseThreadPool  = true;
+  this->m_Threader       = ThreaderType::New();
+  this->m_Threader->SetUseThreadPool( false );
+
+  /** Initialize the m_ThreaderParameters. */
+  this->m_ThreaderParameters.st_Self  = this;
+  this->m_ThreaderParameters.st_Stage = ComputeJacobiansStage;
+
+  // Multi-threading structs
+  this->m_ComputePerThreadVariables     = NULL;
+  this->m_ComputePerThreadVariablesSize = 0;
+
+  /** The batches of samples of which the Jacobians are stored at once. */
+  this->m_SampleContainer         = 0;
+  this->m_NumberOfSamplesPerBatch = 1024;
+  this->m_BatchBegin              = 0;
+  this->m_BatchEnd                = 0;
+
 } // end Constructor
 
 
+/**
+ * ************************* Destructor ************************
+ */
+
+template< class TFixedImage, class TTransform >
+ComputeJacobianTerms< TFixedImage, TTransform >
+::~ComputeJacobianTerms()
+{
+  delete[] this->m_ComputePerThreadVariables;
+} // end Destructor
+
+
+/**
+ * ************************* InitializeThreadingParameters ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::InitializeThreadingParameters( void )
+{
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfThreads();
+
+  /** Only resize the array of structs when needed. */
+  if( this->m_ComputePerThreadVariablesSize != numberOfThreads )
+  {
+    delete[] this->m_ComputePerThreadVariables;
+    this->m_ComputePerThreadVariables     = new AlignedComputePerThreadStruct[ numberOfThreads ];
+    this->m_ComputePerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. */
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    this->m_ComputePerThreadVariables[ i ].st_MaxJJ  = NumericTraits< double >::Zero;
+    this->m_ComputePerThreadVariables[ i ].st_MaxJCJ = NumericTraits< double >::Zero;
+  }
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ************************* Compute ************************
  */
@@ -56,6 +119,128 @@ template< class TFixedImage, class TTransform >
 void
 ComputeJacobianTerms< TFixedImage, TTransform >
 ::Compute( double & TrC, double & TrCC, double & maxJJ, double & maxJCJ )
+{
+  /** This function computes the same four terms as ComputeSingleThreaded(),
+   * which also documents them, in four multi-threaded stages:
+   * \li ComputeJacobiansStage: the Jacobians of a batch of samples;
+   * \li UpdateCovarianceStage: adding the J_j^T J_j of the batch to C;
+   * \li FinalizeCovarianceStage: moving the band matrix into the sparse
+   *   matrix, applying the scales, and computing TrC and TrCC per row;
+   * \li ComputeMaximaStage: term 3 and 4 per sample.
+   */
+  if( !this->m_UseMultiThread )
+  {
+    return this->ComputeSingleThreaded( TrC, TrCC, maxJJ, maxJCJ );
+  }
+
+  /** Initialize. */
+  TrC = TrCC = maxJJ = maxJCJ = 0.0;
+  this->InitializeThreadingParameters();
+
+  /** Get samples. */
+  this->SampleFixedImageForJacobianTerms( this->m_SampleContainer );
+  const SizeValueType nrofsamples = this->m_SampleContainer->Size();
+
+  /** Get the number of parameters. */
+  const unsigned int P = static_cast< unsigned int >(
+    this->m_Transform->GetNumberOfParameters() );
+  const unsigned int     outdim     = this->m_Transform->GetOutputSpaceDimension();
+  NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+
+  /** Try to guess the band structure of the covariance matrix. */
+  this->ComputeBandStructure( this->m_SampleContainer,
+    this->m_BandCovarianceMap, this->m_BandCovarianceMap2 );
+  const unsigned int bandcovsize
+    = static_cast< unsigned int >( this->m_BandCovarianceMap2.size() );
+
+  /** Initialize covariance matrix. Sparse, diagonal, and band form. */
+  this->m_Covariance         = SparseCovarianceMatrixType( P, P );
+  this->m_DiagonalCovariance = DiagCovarianceMatrixType( P, 0.0 );
+  this->m_BandCovariance     = CovarianceMatrixType( P, bandcovsize );
+  this->m_BandCovariance.Fill( 0.0 );
+
+  /** Storage for the Jacobians of a batch of samples. */
+  const SizeValueType batchSize
+    = std::min( this->m_NumberOfSamplesPerBatch, nrofsamples );
+  JacobianType jacj( outdim, sizejacind );
+  jacj.Fill( 0.0 );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+  this->m_BatchJacobians.assign( batchSize, jacj );
+  this->m_BatchNonZeroJacobianIndices.assign( batchSize, jacind );
+
+  /**
+   *    TERM 1
+   *
+   * Compute C = 1/n \sum_i J_i^T J_i, batch by batch.
+   */
+  for( this->m_BatchBegin = 0; this->m_BatchBegin < nrofsamples;
+    this->m_BatchBegin = this->m_BatchEnd )
+  {
+    this->m_BatchEnd = std::min( this->m_BatchBegin + batchSize, nrofsamples );
+    this->LaunchComputeThreaderCallback( ComputeJacobiansStage );
+    this->ComputeBatchRuns();
+    this->LaunchComputeThreaderCallback( UpdateCovarianceStage );
+  }
+  this->m_BatchJacobians.clear();
+  this->m_BatchNonZeroJacobianIndices.clear();
+
+  /** Copy the band matrix into the sparse matrix, apply the scales, and
+   * compute the diagonal and the squared norms of the rows.
+   */
+  this->m_RowSquaredNorms.assign( P, 0.0 );
+  this->LaunchComputeThreaderCallback( FinalizeCovarianceStage );
+  this->m_BandCovariance.set_size( 0, 0 );
+
+  /** Compute TrC = trace(C), in row order. */
+  for( unsigned int p = 0; p < P; ++p )
+  {
+    TrC += this->m_DiagonalCovariance[ p ];
+  }
+
+  /**
+   *    TERM 2
+   *
+   * Compute TrCC = ||C||_F^2.
+   */
+  for( unsigned int p = 0; p < P; ++p )
+  {
+    TrCC += this->m_RowSquaredNorms[ p ];
+  }
+  this->m_RowSquaredNorms.clear();
+
+  /** Symmetry: multiply by 2 and subtract sumsqr(diagcov). */
+  TrCC *= 2.0;
+  TrCC -= this->m_DiagonalCovariance.diagonal().squared_magnitude();
+
+  /**
+   *    TERM 3 and 4
+   *
+   * Compute maxJJ and maxJCJ per thread, and take the maximum.
+   */
+  this->LaunchComputeThreaderCallback( ComputeMaximaStage );
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    maxJJ  = vnl_math_max( maxJJ, this->m_ComputePerThreadVariables[ i ].st_MaxJJ );
+    maxJCJ = vnl_math_max( maxJCJ, this->m_ComputePerThreadVariables[ i ].st_MaxJCJ );
+  }
+
+  /** Release the memory. */
+  this->m_Covariance         = SparseCovarianceMatrixType();
+  this->m_DiagonalCovariance = DiagCovarianceMatrixType();
+  this->m_SampleContainer    = 0;
+
+} // end Compute()
+
+
+/**
+ * ************************* ComputeSingleThreaded ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeSingleThreaded( double & TrC, double & TrCC, double & maxJJ, double & maxJCJ )
 {
   /** This function computes four terms needed for the automatic parameter
    * estimation. The equation number refers to the IJCV paper.
@@ -73,13 +258,6 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * Term 4: maxJCJ, see (54)
    */
 
-  typedef double                                   CovarianceValueType;
-  typedef itk::Array2D< CovarianceValueType >      CovarianceMatrixType;
-  typedef vnl_sparse_matrix< CovarianceValueType > SparseCovarianceMatrixType;
-  typedef SparseCovarianceMatrixType::row          SparseRowType;
-  typedef itk::Array< SizeValueType >              NonZeroJacobianIndicesExpandedType;
-  typedef vnl_diag_matrix< CovarianceValueType >   DiagCovarianceMatrixType;
-
   /** Initialize. */
   TrC = TrCC = maxJJ = maxJCJ = 0.0;
 
@@ -126,95 +304,11 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   CovarianceMatrixType jactjac( sizejacind, sizejacind );
   jactjac.Fill( 0.0 );
 
-  typedef std::vector< unsigned int >             DifHistType;
-  typedef std::pair< unsigned int, unsigned int > FreqPairType;
-  typedef std::vector< FreqPairType >             DifHist2Type;
-  DifHist2Type difHist2;
-
-  /** DifHist is a histogram of absolute parameterNrDifferences that
-   * occur in the nonzerojacobianindex vectors.
-   * DifHist2 is another way of storing the histogram, as a vector
-   * of pairs. pair.first = Frequency, pair.second = parameterNrDifference.
-   * This is useful for sorting.
-   */
-  DifHistType difHist( P, 0 );
-
-  /** Try to guess the band structure of the covariance matrix.
-   * A 'band' is a series of elements cov(p,q) with constant q-p.
-   * In the loop below, on a few positions in the image the Jacobian
-   * is computed. The nonzerojacobianindices are inspected to figure out
-   * which values of q-p occur often. This is done by making a histogram.
-   * The histogram is then sorted and the most occurring bands
-   * are determined. The covariance elements in these bands will not
-   * be stored in the sparse matrix structure 'cov', but in the band
-   * matrix 'bandcov', which is much faster.
-   * Only after the bandcov and cov have been filled (by looping over
-   * all Jacobian measurements in the sample container, the bandcov
-   * matrix is injected in the cov matrix, for easy further calculations,
-   * and the bandcov matrix is deleted.
-   */
-  unsigned int onezero = 0;
-  for( unsigned int s = 0; s < this->m_NumberOfBandStructureSamples; ++s )
-  {
-    /** Semi-randomly get some samples from the sample container. */
-    const unsigned int samplenr = ( s + 1 ) * nrofsamples
-      / ( this->m_NumberOfBandStructureSamples + 2 + onezero );
-    onezero = 1 - onezero; // introduces semi-randomness
-
-    /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point
-      = sampleContainer->GetElement( samplenr ).m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind );
-
-    /** Skip invalid Jacobians in the beginning, if any. */
-    if( sizejacind > 1 )
-    {
-      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
-    }
-
-    /** Fill the histogram of parameter nr differences. */
-    for( unsigned int i = 0; i < sizejacind; ++i )
-    {
-      const int jacindi = static_cast< int >( jacind[ i ] );
-      for( unsigned int j = i; j < sizejacind; ++j )
-      {
-        const int jacindj = static_cast< int >( jacind[ j ] );
-        difHist[ static_cast< unsigned int >( vcl_abs( jacindj - jacindi ) ) ]++;
-      }
-    }
-  }
-
-  /** Copy the nonzero elements of the difHist to a vector pairs. */
-  for( unsigned int p = 0; p < P; ++p )
-  {
-    const unsigned int freq = difHist[ p ];
-    if( freq != 0 )
-    {
-      difHist2.push_back( FreqPairType( freq, p ) );
-    }
-  }
-  difHist.resize( 0 );
-
-  /** Compute the number of bands. */
-  const unsigned int bandcovsize = vnl_math_min( this->m_MaxBandCovSize,
-    static_cast< unsigned int >( difHist2.size() ) );
-
-  /** Maps parameterNrDifference (q-p) to colnr in bandcov. */
-  std::vector< unsigned int > bandcovMap( P, bandcovsize );
-  /** Maps colnr in bandcov to parameterNrDifference (q-p). */
-  std::vector< unsigned int > bandcovMap2( bandcovsize, P );
-
-  /** Sort the difHist2 based on the frequencies. */
-  std::sort( difHist2.begin(), difHist2.end() );
-
-  /** Determine the bands that are expected to be most dominant. */
-  DifHist2Type::iterator difHist2It = difHist2.end();
-  for( unsigned int b = 0; b < bandcovsize; ++b )
-  {
-    --difHist2It;
-    bandcovMap[ difHist2It->second ] = b;
-    bandcovMap2[ b ]                 = difHist2It->second;
-  }
+  /** Try to guess the band structure of the covariance matrix. */
+  BandCovarianceMapType bandcovMap;
+  BandCovarianceMapType bandcovMap2;
+  this->ComputeBandStructure( sampleContainer, bandcovMap, bandcovMap2 );
+  const unsigned int bandcovsize = static_cast< unsigned int >( bandcovMap2.size() );
 
   /** Initialize band matrix. */
   bandcov = CovarianceMatrixType( P, bandcovsize );
@@ -511,7 +605,549 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   /** Finalize progress information. */
   //progressObserver->PrintProgress( 1.0 );
 
-} // end Compute()
+} // end ComputeSingleThreaded()
+
+
+/**
+ * ************************* ComputeBandStructure ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeBandStructure( const ImageSampleContainerType * sampleContainer,
+  BandCovarianceMapType & bandcovMap, BandCovarianceMapType & bandcovMap2 ) const
+{
+  const SizeValueType nrofsamples = sampleContainer->Size();
+
+  /** Get the number of parameters. */
+  const unsigned int P = static_cast< unsigned int >(
+    this->m_Transform->GetNumberOfParameters() );
+  const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  NumberOfParametersType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType jacj( outdim, sizejacind );
+  jacj.Fill( 0.0 );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+
+  typedef std::vector< unsigned int >             DifHistType;
+  typedef std::pair< unsigned int, unsigned int > FreqPairType;
+  typedef std::vector< FreqPairType >             DifHist2Type;
+  DifHist2Type difHist2;
+
+  /** DifHist is a histogram of absolute parameterNrDifferences that
+   * occur in the nonzerojacobianindex vectors.
+   * DifHist2 is another way of storing the histogram, as a vector
+   * of pairs. pair.first = Frequency, pair.second = parameterNrDifference.
+   * This is useful for sorting.
+   */
+  DifHistType difHist( P, 0 );
+
+  /** Try to guess the band structure of the covariance matrix.
+   * A 'band' is a series of elements cov(p,q) with constant q-p.
+   * In the loop below, on a few positions in the image the Jacobian
+   * is computed. The nonzerojacobianindices are inspected to figure out
+   * which values of q-p occur often. This is done by making a histogram.
+   * The histogram is then sorted and the most occurring bands
+   * are determined. The covariance elements in these bands will not
+   * be stored in the sparse matrix structure 'cov', but in the band
+   * matrix 'bandcov', which is much faster.
+   * Only after the bandcov and cov have been filled (by looping over
+   * all Jacobian measurements in the sample container, the bandcov
+   * matrix is injected in the cov matrix, for easy further calculations,
+   * and the bandcov matrix is deleted.
+   */
+  unsigned int onezero = 0;
+  for( unsigned int s = 0; s < this->m_NumberOfBandStructureSamples; ++s )
+  {
+    /** Semi-randomly get some samples from the sample container. */
+    const unsigned int samplenr = ( s + 1 ) * nrofsamples
+      / ( this->m_NumberOfBandStructureSamples + 2 + onezero );
+    onezero = 1 - onezero; // introduces semi-randomness
+
+    /** Read fixed coordinates and get Jacobian J_j. */
+    const FixedImagePointType & point
+      = sampleContainer->GetElement( samplenr ).m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point, jacj, jacind );
+
+    /** Skip invalid Jacobians in the beginning, if any. */
+    if( sizejacind > 1 )
+    {
+      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
+    }
+
+    /** Fill the histogram of parameter nr differences. */
+    for( unsigned int i = 0; i < sizejacind; ++i )
+    {
+      const int jacindi = static_cast< int >( jacind[ i ] );
+      for( unsigned int j = i; j < sizejacind; ++j )
+      {
+        const int jacindj = static_cast< int >( jacind[ j ] );
+        difHist[ static_cast< unsigned int >( vcl_abs( jacindj - jacindi ) ) ]++;
+      }
+    }
+  }
+
+  /** Copy the nonzero elements of the difHist to a vector pairs. */
+  for( unsigned int p = 0; p < P; ++p )
+  {
+    const unsigned int freq = difHist[ p ];
+    if( freq != 0 )
+    {
+      difHist2.push_back( FreqPairType( freq, p ) );
+    }
+  }
+  difHist.resize( 0 );
+
+  /** Compute the number of bands. */
+  const unsigned int bandcovsize = vnl_math_min( this->m_MaxBandCovSize,
+    static_cast< unsigned int >( difHist2.size() ) );
+
+  /** Maps parameterNrDifference (q-p) to colnr in bandcov. */
+  bandcovMap.assign( P, bandcovsize );
+  /** Maps colnr in bandcov to parameterNrDifference (q-p). */
+  bandcovMap2.assign( bandcovsize, P );
+
+  /** Sort the difHist2 based on the frequencies. */
+  std::sort( difHist2.begin(), difHist2.end() );
+
+  /** Determine the bands that are expected to be most dominant. */
+  DifHist2Type::iterator difHist2It = difHist2.end();
+  for( unsigned int b = 0; b < bandcovsize; ++b )
+  {
+    --difHist2It;
+    bandcovMap[ difHist2It->second ] = b;
+    bandcovMap2[ b ]                 = difHist2It->second;
+  }
+
+} // end ComputeBandStructure()
+
+
+/**
+ * ************************* ComputeBatchRuns ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeBatchRuns( void )
+{
+  const NumberOfParametersType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  const SizeValueType batchSize = this->m_BatchEnd - this->m_BatchBegin;
+
+  /** m_BatchRuns holds the start of each run in m_BatchValidSamples,
+   * followed by the number of valid samples.
+   */
+  this->m_BatchValidSamples.clear();
+  this->m_BatchRuns.clear();
+  for( SizeValueType k = 0; k < batchSize; ++k )
+  {
+    const NonZeroJacobianIndicesType & jacind = this->m_BatchNonZeroJacobianIndices[ k ];
+
+    /** Skip invalid Jacobians, if any. */
+    if( sizejacind > 1 )
+    {
+      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
+    }
+
+    /** Start a new run when the nonzero Jacobian indices change. */
+    if( this->m_BatchValidSamples.empty()
+      || jacind != this->m_BatchNonZeroJacobianIndices[ this->m_BatchValidSamples.back() ] )
+    {
+      this->m_BatchRuns.push_back( this->m_BatchValidSamples.size() );
+    }
+    this->m_BatchValidSamples.push_back( k );
+  }
+  this->m_BatchRuns.push_back( this->m_BatchValidSamples.size() );
+
+} // end ComputeBatchRuns()
+
+
+/**
+ * *********************** LaunchComputeThreaderCallback***************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::LaunchComputeThreaderCallback( const ThreadedStageType stage )
+{
+  this->m_ThreaderParameters.st_Stage = stage;
+  void * userData = static_cast< void * >( &this->m_ThreaderParameters );
+
+  /** Launch, reusing the persistent worker threads if possible. */
+  if( this->m_UseThreadPool )
+  {
+    WorkerThreadPool::GetInstance()->Execute( this->ComputeThreaderCallback,
+      userData, this->m_Threader->GetNumberOfThreads() );
+  }
+  else
+  {
+    this->m_Threader->SetSingleMethod( this->ComputeThreaderCallback, userData );
+    this->m_Threader->SingleMethodExecute();
+  }
+
+} // end LaunchComputeThreaderCallback()
+
+
+/**
+ * ************ ComputeThreaderCallback ****************************
+ */
+
+template< class TFixedImage, class TTransform >
+ITK_THREAD_RETURN_TYPE
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType                 threadID   = infoStruct->ThreadID;
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Call the real implementation of the current stage. */
+  switch( temp->st_Stage )
+  {
+    case ComputeJacobiansStage:
+      temp->st_Self->ThreadedComputeJacobians( threadID );
+      break;
+    case UpdateCovarianceStage:
+      temp->st_Self->ThreadedUpdateCovariance( threadID );
+      break;
+    case FinalizeCovarianceStage:
+      temp->st_Self->ThreadedFinalizeCovariance( threadID );
+      break;
+    case ComputeMaximaStage:
+      temp->st_Self->ThreadedComputeMaxima( threadID );
+      break;
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeThreaderCallback()
+
+
+/**
+ * ************************* ThreadedComputeJacobians ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedComputeJacobians( ThreadIdType threadID )
+{
+  /** Get the part of the batch for this thread. */
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  const SizeValueType batchSize       = this->m_BatchEnd - this->m_BatchBegin;
+  const SizeValueType pos_begin       = batchSize * threadID / numberOfThreads;
+  const SizeValueType pos_end         = batchSize * ( threadID + 1 ) / numberOfThreads;
+
+  /** Read fixed coordinates and get Jacobian J_j. */
+  for( SizeValueType k = pos_begin; k < pos_end; ++k )
+  {
+    const FixedImagePointType & point = this->m_SampleContainer
+      ->GetElement( this->m_BatchBegin + k ).m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point,
+      this->m_BatchJacobians[ k ], this->m_BatchNonZeroJacobianIndices[ k ] );
+  }
+
+} // end ThreadedComputeJacobians()
+
+
+/**
+ * ************************* ThreadedUpdateCovariance ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedUpdateCovariance( ThreadIdType threadID )
+{
+  const ThreadIdType           numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  const unsigned int           outdim          = this->m_Transform->GetOutputSpaceDimension();
+  const NumberOfParametersType sizejacind      = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  const double                 n               = static_cast< double >( this->m_SampleContainer->Size() );
+  const unsigned int           bandcovsize     = static_cast< unsigned int >( this->m_BandCovariance.cols() );
+
+  /** For temporary storage of a row of J'J. */
+  std::vector< double > jactjacrow( sizejacind );
+
+  /** Loop over the runs of equal nonzero Jacobian indices. Row p of C is
+   * only updated by thread p % numberOfThreads, in sample order.
+   */
+  for( SizeValueType r = 0; r + 1 < this->m_BatchRuns.size(); ++r )
+  {
+    const SizeValueType runBegin = this->m_BatchRuns[ r ];
+    const SizeValueType runEnd   = this->m_BatchRuns[ r + 1 ];
+    const NonZeroJacobianIndicesType & jacind
+      = this->m_BatchNonZeroJacobianIndices[ this->m_BatchValidSamples[ runBegin ] ];
+
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      const unsigned int p = jacind[ pi ];
+      if( p % numberOfThreads != threadID ) { continue; }
+
+      /** Row pi of the sum of J_j^T J_j over the run. */
+      std::fill( jactjacrow.begin(), jactjacrow.end(), 0.0 );
+      for( SizeValueType s = runBegin; s < runEnd; ++s )
+      {
+        const JacobianType & jacj = this->m_BatchJacobians[ this->m_BatchValidSamples[ s ] ];
+        for( unsigned int qi = 0; qi < sizejacind; ++qi )
+        {
+          if( jacind[ qi ] < p ) { continue; }
+          double jtj = 0.0;
+          for( unsigned int d = 0; d < outdim; ++d )
+          {
+            jtj += jacj[ d ][ pi ] * jacj[ d ][ qi ];
+          }
+          jactjacrow[ qi ] += jtj;
+        }
+      }
+
+      /** Update covariance matrix. */
+      for( unsigned int qi = 0; qi < sizejacind; ++qi )
+      {
+        const unsigned int q = jacind[ qi ];
+        if( q >= p )
+        {
+          const double tempval = jactjacrow[ qi ] / n;
+          if( vcl_abs( tempval ) > 1e-14 )
+          {
+            const unsigned int bandindex = this->m_BandCovarianceMap[ q - p ];
+            if( bandindex < bandcovsize )
+            {
+              this->m_BandCovariance( p, bandindex ) += tempval;
+            }
+            else
+            {
+              this->m_Covariance( p, q ) += tempval;
+            }
+          }
+        }
+      } // qi
+    }   // pi
+  }     // r
+
+} // end ThreadedUpdateCovariance()
+
+
+/**
+ * ************************* ThreadedFinalizeCovariance ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedFinalizeCovariance( ThreadIdType threadID )
+{
+  /** Get the rows for this thread. */
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  const SizeValueType P               = this->m_Covariance.rows();
+  const unsigned int  p_begin         = static_cast< unsigned int >( P * threadID / numberOfThreads );
+  const unsigned int  p_end           = static_cast< unsigned int >( P * ( threadID + 1 ) / numberOfThreads );
+  const unsigned int  bandcovsize     = static_cast< unsigned int >( this->m_BandCovariance.cols() );
+
+  /** Get scales vector */
+  const ScalesType & scales = this->m_Scales;
+
+  for( unsigned int p = p_begin; p < p_end; ++p )
+  {
+    /** Copy the band matrix into the sparse matrix. */
+    for( unsigned int b = 0; b < bandcovsize; ++b )
+    {
+      const double tempval = this->m_BandCovariance( p, b );
+      if( vcl_abs( tempval ) > 1e-14 )
+      {
+        const unsigned int q = p + this->m_BandCovarianceMap2[ b ];
+        this->m_Covariance( p, q ) = tempval;
+      }
+    }
+    if( this->m_Covariance.empty_row( p ) ) { continue; }
+
+    /** Apply scales. */
+    if( this->m_UseScales )
+    {
+      this->m_Covariance.scale_row( p, 1.0 / scales[ p ] );
+      SparseRowType & covrowp = this->m_Covariance.get_row( p );
+      for( typename SparseRowType::iterator covrowpit = covrowp.begin();
+        covrowpit != covrowp.end(); ++covrowpit )
+      {
+        ( *covrowpit ).second /= scales[ ( *covrowpit ).first ];
+      }
+    }
+
+    /** Store the diagonal. Empty rows were skipped above, to avoid the
+     * creation of an element.
+     */
+    this->m_DiagonalCovariance[ p ] = this->m_Covariance( p, p );
+
+    /** Compute the contribution of this row to ||C||_F^2. */
+    double                rowSquaredNorm = 0.0;
+    const SparseRowType & covrowp        = this->m_Covariance.get_row( p );
+    for( typename SparseRowType::const_iterator covrowpit = covrowp.begin();
+      covrowpit != covrowp.end(); ++covrowpit )
+    {
+      rowSquaredNorm += vnl_math_sqr( ( *covrowpit ).second );
+    }
+    this->m_RowSquaredNorms[ p ] = rowSquaredNorm;
+  }
+
+} // end ThreadedFinalizeCovariance()
+
+
+/**
+ * ************************* ThreadedComputeMaxima ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedComputeMaxima( ThreadIdType threadID )
+{
+  /** Get the samples for this thread. */
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  const SizeValueType nrofsamples     = this->m_SampleContainer->Size();
+  const SizeValueType pos_begin       = nrofsamples * threadID / numberOfThreads;
+  const SizeValueType pos_end         = nrofsamples * ( threadID + 1 ) / numberOfThreads;
+
+  const unsigned int P = static_cast< unsigned int >(
+    this->m_Transform->GetNumberOfParameters() );
+  const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
+  const NumberOfParametersType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  const ScalesType & scales = this->m_Scales;
+  const double       sqrt2  = vcl_sqrt( static_cast< double >( 2.0 ) );
+
+  /** Temporaries of this thread. */
+  JacobianType jacj( outdim, sizejacind );
+  jacj.Fill( 0.0 );
+  NonZeroJacobianIndicesType         jacind( sizejacind );
+  JacobianType                       jacjjacj( outdim, outdim );
+  JacobianType                       jacjcov( outdim, sizejacind );
+  DiagCovarianceMatrixType           diagcovsparse( sizejacind );
+  JacobianType                       jacjdiagcov( outdim, sizejacind );
+  JacobianType                       jacjdiagcovjacj( outdim, outdim );
+  JacobianType                       jacjcovjacj( outdim, outdim );
+  NonZeroJacobianIndicesExpandedType jacindExpanded( P );
+  jacindExpanded.Fill( sizejacind );
+
+  double maxJJ  = 0.0;
+  double maxJCJ = 0.0;
+  for( SizeValueType i = pos_begin; i < pos_end; ++i )
+  {
+    /** Read fixed coordinates and get Jacobian. */
+    const FixedImagePointType & point
+      = this->m_SampleContainer->GetElement( i ).m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point, jacj, jacind );
+
+    /** Apply scales, if necessary. */
+    if( this->m_UseScales )
+    {
+      for( unsigned int pi = 0; pi < sizejacind; ++pi )
+      {
+        const unsigned int p = jacind[ pi ];
+        jacj.scale_column( pi, 1.0 / scales[ p ] );
+      }
+    }
+
+    /** Compute 1st part of JJ: ||J_j||_F^2. */
+    double JJ_j = vnl_math_sqr( jacj.frobenius_norm() );
+
+    /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
+    vnl_fastops::ABt( jacjjacj, jacj, jacj );
+    JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
+
+    /** Max_j [JJ_j]. */
+    maxJJ = vnl_math_max( maxJJ, JJ_j );
+
+    /** Compute JCJ_j. */
+    double JCJ_j = 0.0;
+
+    /** J_j C = jacjC. */
+    jacjcov.Fill( 0.0 );
+
+    /** Store the nonzero Jacobian indices in a different format
+     * and create the sparse diagcov. Only these entries of
+     * jacindExpanded are reset afterwards, instead of all P.
+     */
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      const unsigned int p = jacind[ pi ];
+      jacindExpanded[ p ] = pi;
+      diagcovsparse[ pi ] = this->m_DiagonalCovariance[ p ];
+    }
+
+    /** We below calculate jacjC = J_j cov^T, but later we will correct
+     * for this using:
+     * J C J' = J (cov + cov' - diag(cov')) J'.
+     * (NB: cov now still contains only the upper triangular part of C)
+     */
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      const unsigned int p = jacind[ pi ];
+      if( !this->m_Covariance.empty_row( p ) )
+      {
+        const SparseRowType & covrowp = this->m_Covariance.get_row( p );
+        typename SparseRowType::const_iterator covrowpit;
+
+        /** Loop over row p of the sparse cov matrix. */
+        for( covrowpit = covrowp.begin(); covrowpit != covrowp.end(); ++covrowpit )
+        {
+          const unsigned int q  = ( *covrowpit ).first;
+          const unsigned int qi = jacindExpanded[ q ];
+
+          if( qi < sizejacind )
+          {
+            /** If found, update the jacjC matrix. */
+            const CovarianceValueType covElement = ( *covrowpit ).second;
+            for( unsigned int dx = 0; dx < outdim; ++dx )
+            {
+              jacjcov[ dx ][ pi ] += jacj[ dx ][ qi ] * covElement;
+            } //dx
+          }   // if qi < sizejacind
+        }     // for covrow
+
+      } // if not empty row
+    }   // pi
+
+    /** Reset the expanded nonzero Jacobian indices. */
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      jacindExpanded[ jacind[ pi ] ] = sizejacind;
+    }
+
+    /** J_j C J_j^T  = jacjCjacj.
+     * But note that we actually compute J_j cov' J_j^T
+     */
+    vnl_fastops::ABt( jacjcovjacj, jacjcov, jacj );
+
+    /** jacjCjacj = jacjCjacj+ jacjCjacj' - jacjdiagcovjacj */
+    jacjdiagcov = jacj * diagcovsparse;
+    vnl_fastops::ABt( jacjdiagcovjacj, jacjdiagcov, jacj );
+    jacjcovjacj += jacjcovjacj.transpose();
+    jacjcovjacj -= jacjdiagcovjacj;
+
+    /** Compute 1st part of JCJ: Tr( J_j C J_j^T ). */
+    for( unsigned int d = 0; d < outdim; ++d )
+    {
+      JCJ_j += jacjcovjacj[ d ][ d ];
+    }
+
+    /** Compute 2nd part of JCJ_j: 2 \sqrt{2} || J_j C J_j^T ||_F. */
+    JCJ_j += 2.0 * sqrt2 * jacjcovjacj.frobenius_norm();
+
+    /** Max_j [JCJ_j]. */
+    maxJCJ = vnl_math_max( maxJCJ, JCJ_j );
+
+  } // end loop over sample container
+
+  this->m_ComputePerThreadVariables[ threadID ].st_MaxJJ  = maxJJ;
+  this->m_ComputePerThreadVariables[ threadID ].st_MaxJCJ = maxJCJ;
+
+} // end ThreadedComputeMaxima()
 
 
 /**
@@ -0,0 +1,237 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkConvergenceMonitor_cxx
+#define __itkConvergenceMonitor_cxx
+
+#include "itkConvergenceMonitor.h"
+
+#include <limits>
+#include <sstream>
+#include "vnl/vnl_math.h"
+
+namespace itk
+{
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+ConvergenceMonitor
+::ConvergenceMonitor()
+{
+  this->m_WindowSize        = 200;
+  this->m_TrendThreshold    = 1.0;
+  this->m_RelativeTolerance = 1e-5;
+
+  this->Reset();
+
+} // end Constructor
+
+
+/**
+ * ****************** SetWindowSize *********************************
+ */
+
+void
+ConvergenceMonitor
+::SetWindowSize( SizeValueType windowSize )
+{
+  /** The standard error of the slope needs at least three values. */
+  if( windowSize < 3 ) { windowSize = 3; }
+
+  if( this->m_WindowSize != windowSize )
+  {
+    this->m_WindowSize = windowSize;
+    this->Modified();
+  }
+  this->Reset();
+
+} // end SetWindowSize()
+
+
+/**
+ * ****************** Reset *********************************
+ */
+
+void
+ConvergenceMonitor
+::Reset( void )
+{
+  this->m_Values.assign( this->m_WindowSize, 0.0 );
+  this->m_NumberOfValues = 0;
+
+  this->m_Converged          = false;
+  this->m_Slope              = 0.0;
+  this->m_SlopeStandardError = 0.0;
+  this->m_RelativeDecrease   = 0.0;
+
+} // end Reset()
+
+
+/**
+ * ****************** AddValue *********************************
+ */
+
+bool
+ConvergenceMonitor
+::AddValue( const double value )
+{
+  this->m_Values[ this->m_NumberOfValues % this->m_WindowSize ] = value;
+  ++this->m_NumberOfValues;
+
+  if( this->m_NumberOfValues >= this->m_WindowSize )
+  {
+    this->Test();
+  }
+
+  return this->m_Converged;
+
+} // end AddValue()
+
+
+/**
+ * ****************** Test *********************************
+ */
+
+void
+ConvergenceMonitor
+::Test( void )
+{
+  const SizeValueType W = this->m_WindowSize;
+
+  /** The oldest value in the ring buffer is the one that is overwritten next. */
+  const SizeValueType oldest = this->m_NumberOfValues % W;
+
+  double mean = 0.0;
+  for( SizeValueType i = 0; i < W; ++i )
+  {
+    mean += this->m_Values[ i ];
+  }
+  mean /= static_cast< double >( W );
+
+  /** Least squares fit of y = mean + slope * ( x - xmean ), with x the
+   * iteration within the window. The sum of ( x - xmean )^2 over
+   * x = 0 .. W - 1 is W ( W^2 - 1 ) / 12.
+   */
+  const double xmean = 0.5 * static_cast< double >( W - 1 );
+  const double sxx   = static_cast< double >( W )
+    * ( static_cast< double >( W ) * static_cast< double >( W ) - 1.0 ) / 12.0;
+  double sxy = 0.0;
+  double syy = 0.0;
+  for( SizeValueType x = 0; x < W; ++x )
+  {
+    const double dy = this->m_Values[ ( oldest + x ) % W ] - mean;
+    sxy += ( static_cast< double >( x ) - xmean ) * dy;
+    syy += dy * dy;
+  }
+  const double slope = sxy / sxx;
+
+  /** The residual sum of squares, and the standard error of the slope. */
+  double rss = syy - slope * sxy;
+  if( rss < 0.0 ) { rss = 0.0; }
+  const double variance = rss / static_cast< double >( W - 2 );
+  this->m_Slope              = slope;
+  this->m_SlopeStandardError = vcl_sqrt( variance / sxx );
+
+  /** The fitted decrease over the window, relative to the mean value. */
+  const double decrease = slope < 0.0 ? -slope * static_cast< double >( W - 1 ) : 0.0;
+  const double absMean  = vnl_math_abs( mean );
+  this->m_RelativeDecrease = decrease / ( absMean > 0.0 ? absMean : 1.0 );
+
+  this->m_Converged
+    = this->GetTrendSignificance() < this->m_TrendThreshold
+    || this->m_RelativeDecrease < this->m_RelativeTolerance;
+
+} // end Test()
+
+
+/**
+ * ****************** GetTrendSignificance *********************************
+ */
+
+double
+ConvergenceMonitor
+::GetTrendSignificance( void ) const
+{
+  if( this->m_Slope >= 0.0 ) { return 0.0; }
+  if( this->m_SlopeStandardError <= 0.0 )
+  {
+    return std::numeric_limits< double >::infinity();
+  }
+  return -this->m_Slope / this->m_SlopeStandardError;
+
+} // end GetTrendSignificance()
+
+
+/**
+ * ****************** GetStopCondition *********************************
+ */
+
+std::string
+ConvergenceMonitor
+::GetStopCondition( void ) const
+{
+  std::ostringstream condition;
+  if( !this->m_Converged )
+  {
+    condition << "Not converged";
+  }
+  else if( this->GetTrendSignificance() < this->m_TrendThreshold )
+  {
+    condition << "The decrease of the metric value over the last "
+              << this->m_WindowSize << " iterations is not significant ("
+              << this->GetTrendSignificance() << " standard errors, threshold "
+              << this->m_TrendThreshold << ")";
+  }
+  else
+  {
+    condition << "The relative decrease of the metric value over the last "
+              << this->m_WindowSize << " iterations ("
+              << this->m_RelativeDecrease << ") is below the tolerance ("
+              << this->m_RelativeTolerance << ")";
+  }
+  return condition.str();
+
+} // end GetStopCondition()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+ConvergenceMonitor
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "WindowSize: " << this->m_WindowSize << std::endl;
+  os << indent << "TrendThreshold: " << this->m_TrendThreshold << std::endl;
+  os << indent << "RelativeTolerance: " << this->m_RelativeTolerance << std::endl;
+  os << indent << "NumberOfValues: " << this->m_NumberOfValues << std::endl;
+  os << indent << "Converged: " << this->m_Converged << std::endl;
+  os << indent << "Slope: " << this->m_Slope << std::endl;
+  os << indent << "SlopeStandardError: " << this->m_SlopeStandardError << std::endl;
+  os << indent << "RelativeDecrease: " << this->m_RelativeDecrease << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkConvergenceMonitor_cxx
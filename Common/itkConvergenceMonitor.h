@@ -0,0 +1,154 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkConvergenceMonitor_h
+#define __itkConvergenceMonitor_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ConvergenceMonitor
+ *
+ * \brief Decides from the metric values of the last iterations whether a
+ * minimization with noisy metric values has converged.
+ *
+ * Stochastic optimizers evaluate the metric on a new random subset of the
+ * samples in every iteration, so that consecutive metric values differ by
+ * noise, and the usual tolerance tests on the change of the value or of the
+ * parameters never succeed. This class fits a straight line to the values of
+ * the last WindowSize iterations, by linear least squares, and computes the
+ * standard error of its slope from the residuals. The minimization has
+ * converged when either:
+ * \li the decrease is not significant: the fitted slope is less than
+ *   TrendThreshold standard errors below zero, so that the trend cannot be
+ *   distinguished from the noise; or
+ * \li the decrease is negligible: the fitted decrease over the window,
+ *   relative to the mean value in the window, is below RelativeTolerance.
+ *   This test is the one that applies to metrics without noise.
+ *
+ * The test is done once the window is full, after every value that is added.
+ * The cost of a test is linear in the window size.
+ *
+ * \ingroup Optimizers
+ */
+
+class ConvergenceMonitor : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ConvergenceMonitor         Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ConvergenceMonitor, Object );
+
+  /** Set/Get the number of iterations to which the line is fitted. At least
+   * 3. Setting it calls Reset(). Default: 200.
+   */
+  void SetWindowSize( SizeValueType windowSize );
+
+  itkGetConstMacro( WindowSize, SizeValueType );
+
+  /** Set/Get the number of standard errors that the slope must be below
+   * zero for the decrease to be significant. Default: 1.0.
+   */
+  itkSetMacro( TrendThreshold, double );
+  itkGetConstMacro( TrendThreshold, double );
+
+  /** Set/Get the relative decrease over the window below which the decrease
+   * is negligible. Zero disables this test. Default: 1e-5.
+   */
+  itkSetMacro( RelativeTolerance, double );
+  itkGetConstMacro( RelativeTolerance, double );
+
+  /** Remove all values, for example at the start of a resolution. */
+  void Reset( void );
+
+  /** Add the metric value of the next iteration. Returns true if the
+   * minimization has converged.
+   */
+  bool AddValue( const double value );
+
+  /** Get whether the last test found convergence. */
+  itkGetConstMacro( Converged, bool );
+
+  /** Get the number of values added since the last Reset(). */
+  itkGetConstMacro( NumberOfValues, SizeValueType );
+
+  /** Get the results of the last test: the fitted slope per iteration, its
+   * standard error, and the fitted decrease over the window relative to the
+   * mean value.
+   */
+  itkGetConstMacro( Slope, double );
+  itkGetConstMacro( SlopeStandardError, double );
+  itkGetConstMacro( RelativeDecrease, double );
+
+  /** Get the significance of the decrease: -Slope / SlopeStandardError. */
+  double GetTrendSignificance( void ) const;
+
+  /** Get a description of the reason of convergence, for the log. */
+  std::string GetStopCondition( void ) const;
+
+protected:
+
+  ConvergenceMonitor();
+  virtual ~ConvergenceMonitor() {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Fit the line to the values in the window, and test for convergence. */
+  void Test( void );
+
+private:
+
+  ConvergenceMonitor( const Self & ); // purposely not implemented
+  void operator=( const Self & );     // purposely not implemented
+
+  /** Settings. */
+  SizeValueType m_WindowSize;
+  double        m_TrendThreshold;
+  double        m_RelativeTolerance;
+
+  /** The values in the window, as a ring buffer. */
+  std::vector< double > m_Values;
+  SizeValueType         m_NumberOfValues;
+
+  /** The results of the last test. */
+  bool   m_Converged;
+  double m_Slope;
+  double m_SlopeStandardError;
+  double m_RelativeDecrease;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkConvergenceMonitor_h
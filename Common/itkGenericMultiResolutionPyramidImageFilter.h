@@ -20,6 +20,7 @@
 
 #include "itkMultiResolutionPyramidImageFilter.h"
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
+#include "itkImageCache.h"
 
 namespace itk
 {
@@ -98,6 +99,14 @@ namespace itk
  * compute only single level of the pyramid via SetCurrentLevel() and
  * SetComputeOnlyForCurrentLevel() methods.
  *
+ * When an ImageCache is set, each computed level is stored in the cache,
+ * under a key that consists of the input image (its address and modification
+ * time), the rescale factors and sigmas of that level, and the rescale
+ * method. A level that is found in the cache is not computed again, but
+ * grafted to the output. Another pyramid on the same input image, for example
+ * of the next elastix level, can so reuse the levels that it has in common.
+ * Only levels for which the largest possible region is requested are cached.
+ *
  * \author Denis P. Shamonin and Marius Staring. Division of Image Processing,
  * Department of Radiology, Leiden, The Netherlands
  *
@@ -220,6 +229,12 @@ public:
   itkGetConstMacro( ComputeOnlyForCurrentLevel, bool );
   itkBooleanMacro( ComputeOnlyForCurrentLevel );
 
+  /** Set/Get the cache in which the computed levels are stored. Default: NULL,
+   * which means that the levels are not cached.
+   */
+  itkSetObjectMacro( ImageCache, ImageCache );
+  itkGetObjectMacro( ImageCache, ImageCache );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( SameDimensionCheck,
@@ -266,6 +281,7 @@ protected:
   unsigned int          m_CurrentLevel;
   bool                  m_ComputeOnlyForCurrentLevel;
   bool                  m_SmoothingScheduleDefined;
+  ImageCache::Pointer   m_ImageCache;
 
 private:
 
@@ -348,6 +364,20 @@ private:
   /** Returns true if rescale has been used in pipeline, otherwise return false. */
   bool IsRescaleUsed( void ) const;
 
+  /** Get the key under which a level is stored in the image cache. An empty
+   * string is returned if the level should not be cached.
+   */
+  std::string GetImageCacheKey( const unsigned int level );
+
+  /** Graft the level from the image cache to the output. Returns false if
+   * the level is not in the cache. If the level has to be computed, a new
+   * buffer is given to the output, so that a cached image is not overwritten.
+   */
+  bool GraftLevelFromImageCache( const std::string & key, const unsigned int level );
+
+  /** Store the computed level in the image cache. */
+  void StoreLevelInImageCache( const std::string & key, const unsigned int level );
+
 private:
 
   GenericMultiResolutionPyramidImageFilter( const Self & ); // purposely not implemented
@@ -24,6 +24,9 @@
 #include "itkShrinkImageFilter.h"
 #include "itkImageAlgorithm.h"
 
+#include <sstream>
+#include <typeinfo>
+
 namespace // anonymous namespace
 {
 /**
@@ -65,6 +68,7 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
   temp.Fill( NumericTraits< ScalarRealType >::ZeroValue() );
   this->m_SmoothingSchedule        = temp;
   this->m_SmoothingScheduleDefined = false;
+  this->m_ImageCache               = 0;
 } // end Constructor
 
 
@@ -312,12 +316,17 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 
       if( this->ComputeForCurrentLevel( level ) )
       {
+        // Reuse the level if it is in the cache
+        const std::string cacheKey = this->GetImageCacheKey( level );
+        if( this->GraftLevelFromImageCache( cacheKey, level ) ) { continue; }
+
         OutputImagePointer outputPtr = this->GetOutput( level );
         outputPtr->SetBufferedRegion( input->GetLargestPossibleRegion() );
         outputPtr->Allocate();
 
         ImageAlgorithm::Copy( input.GetPointer(), outputPtr.GetPointer(),
           input->GetLargestPossibleRegion(), outputPtr->GetLargestPossibleRegion() );
+        this->StoreLevelInImageCache( cacheKey, level );
       }
     }
     return; // We are done, return
@@ -343,6 +352,10 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 
     if( this->ComputeForCurrentLevel( level ) )
     {
+      // Reuse the level if it is in the cache
+      const std::string cacheKey = this->GetImageCacheKey( level );
+      if( this->GraftLevelFromImageCache( cacheKey, level ) ) { continue; }
+
       // Allocate memory for each output
       OutputImagePointer outputPtr = this->GetOutput( level );
       outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
@@ -379,6 +392,7 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
       }
       // no else needed
 
+      this->StoreLevelInImageCache( cacheKey, level );
     }
   } // end for ilevel
 }   // end GenerateData()
@@ -899,6 +913,91 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 } // end IsRescaleUsed()
 
 
+/**
+ * ******************* GetImageCacheKey ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+std::string
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GetImageCacheKey( const unsigned int level )
+{
+  /** Only cache complete levels. */
+  if( this->m_ImageCache.IsNull()
+    || this->GetOutput( level )->GetRequestedRegion()
+    != this->GetOutput( level )->GetLargestPossibleRegion() )
+  {
+    return "";
+  }
+
+  SigmaArrayType sigmaArray;
+  this->GetSigma( level, sigmaArray );
+  RescaleFactorArrayType shrinkFactors;
+  this->GetShrinkFactors( level, shrinkFactors );
+
+  std::ostringstream key;
+  key.precision( 17 );
+  key << "GenericPyramid:" << typeid( TOutputImage ).name()
+      << ":" << typeid( TPrecisionType ).name()
+      << ":" << ImageCache::GetObjectKey( this->GetInput() )
+      << ":" << ( this->GetUseShrinkImageFilter() ? "shrink" : "resample" );
+  for( unsigned int dim = 0; dim < ImageDimension; dim++ )
+  {
+    key << ":" << shrinkFactors[ dim ] << "/" << sigmaArray[ dim ];
+  }
+  return key.str();
+
+} // end GetImageCacheKey()
+
+
+/**
+ * ******************* GraftLevelFromImageCache ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+bool
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GraftLevelFromImageCache( const std::string & key, const unsigned int level )
+{
+  if( key.empty() ) { return false; }
+
+  OutputImageType * cachedImage
+    = dynamic_cast< OutputImageType * >( this->m_ImageCache->GetEntry( key ).GetPointer() );
+  if( cachedImage )
+  {
+    this->GraftNthOutput( level, cachedImage );
+    return true;
+  }
+
+  /** The output may share its buffer with a cached image of a previous
+   * update, which should not be overwritten.
+   */
+  this->GetOutput( level )->SetPixelContainer(
+    OutputImageType::PixelContainer::New() );
+  return false;
+
+} // end GraftLevelFromImageCache()
+
+
+/**
+ * ******************* StoreLevelInImageCache ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::StoreLevelInImageCache( const std::string & key, const unsigned int level )
+{
+  if( key.empty() ) { return; }
+
+  /** Store a separate image object that shares the buffer of the output. */
+  OutputImagePointer cachedImage = OutputImageType::New();
+  cachedImage->Graft( this->GetOutput( level ) );
+  this->m_ImageCache->SetEntry( key, cachedImage );
+
+} // end StoreLevelInImageCache()
+
+
 /**
  * ******************* PrintSelf ***********************
  */
@@ -916,6 +1015,8 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
      << ( this->m_ComputeOnlyForCurrentLevel ? "true" : "false" ) << std::endl;
   os << indent << "SmoothingScheduleDefined: "
      << ( this->m_SmoothingScheduleDefined ? "true" : "false" ) << std::endl;
+  os << indent << "ImageCache: "
+     << this->m_ImageCache.GetPointer() << std::endl;
   os << indent << "Smoothing Schedule: ";
   if( this->m_SmoothingSchedule.size() == 0 )
   {
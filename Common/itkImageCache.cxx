@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkImageCache_cxx
+#define __itkImageCache_cxx
+
+#include "itkImageCache.h"
+#include "itkMutexLockHolder.h"
+#include "itksys/SystemTools.hxx"
+
+#include <sstream>
+
+namespace itk
+{
+
+/**
+ * ****************** GetEntry *********************************
+ */
+
+ImageCache::DataObjectPointer
+ImageCache
+::GetEntry( const std::string & key ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  EntryMapType::const_iterator it = this->m_Entries.find( key );
+  if( it == this->m_Entries.end() ) { return NULL; }
+  ++this->m_NumberOfHits;
+  return it->second;
+
+} // end GetEntry()
+
+
+/**
+ * ****************** SetEntry *********************************
+ */
+
+void
+ImageCache
+::SetEntry( const std::string & key, DataObject * image )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  this->m_Entries[ key ] = image;
+
+} // end SetEntry()
+
+
+/**
+ * ****************** RemoveEntry *********************************
+ */
+
+void
+ImageCache
+::RemoveEntry( const std::string & key )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  this->m_Entries.erase( key );
+
+} // end RemoveEntry()
+
+
+/**
+ * ****************** Clear *********************************
+ */
+
+void
+ImageCache
+::Clear( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  this->m_Entries.clear();
+
+} // end Clear()
+
+
+/**
+ * ****************** GetNumberOfEntries *********************************
+ */
+
+SizeValueType
+ImageCache
+::GetNumberOfEntries( void ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  return static_cast< SizeValueType >( this->m_Entries.size() );
+
+} // end GetNumberOfEntries()
+
+
+/**
+ * ****************** GetNumberOfHits *********************************
+ */
+
+SizeValueType
+ImageCache
+::GetNumberOfHits( void ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  return this->m_NumberOfHits;
+
+} // end GetNumberOfHits()
+
+
+/**
+ * ****************** GetNewRunIdentifier *********************************
+ */
+
+SizeValueType
+ImageCache
+::GetNewRunIdentifier( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  return this->m_NumberOfRunIdentifiers++;
+
+} // end GetNewRunIdentifier()
+
+
+/**
+ * ****************** GetFileKey *********************************
+ */
+
+std::string
+ImageCache
+::GetFileKey( const std::string & fileName )
+{
+  if( !itksys::SystemTools::FileExists( fileName.c_str(), true ) ) { return ""; }
+
+  std::ostringstream key;
+  key << "file:" << itksys::SystemTools::CollapseFullPath( fileName.c_str() )
+      << "@" << itksys::SystemTools::ModifiedTime( fileName.c_str() );
+  return key.str();
+
+} // end GetFileKey()
+
+
+/**
+ * ****************** GetObjectKey *********************************
+ */
+
+std::string
+ImageCache
+::GetObjectKey( const Object * object )
+{
+  std::ostringstream key;
+  key << "object:" << static_cast< const void * >( object )
+      << "@" << ( object ? object->GetMTime() : 0 );
+  return key.str();
+
+} // end GetObjectKey()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+ImageCache
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfEntries: " << this->GetNumberOfEntries() << std::endl;
+  os << indent << "NumberOfHits: " << this->GetNumberOfHits() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkImageCache_cxx
@@ -0,0 +1,134 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageCache_h
+#define __itkImageCache_h
+
+#include "itkDataObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <map>
+#include <string>
+
+namespace itk
+{
+
+/** \class ImageCache
+ *
+ * \brief Stores images that are expensive to recompute, such as decoded
+ * image files and the levels of an image pyramid, so that they can be reused
+ * by the next elastix level or transformix run.
+ *
+ * The images are stored as DataObjects under a key. The key should describe
+ * everything the image depends on; helpers are provided for keys based on
+ * a file (name and modification time) and on an input image (its address
+ * and modification time). Since the modification time of an object is taken
+ * from a global counter, a new image at the address of a deleted one gets
+ * another key.
+ *
+ * Other data that the next elastix level reuses, such as the warm-start
+ * state of the optimizers, can be stored as DataObjects as well.
+ *
+ * A cached image is shared between its users, and should not be modified.
+ * Filters that store their output in the cache should therefore allocate a
+ * new buffer when they compute that output again.
+ *
+ * Getting and storing entries is thread safe.
+ *
+ * \ingroup ITKCommon
+ */
+
+class ImageCache : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ImageCache                 Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageCache, Object );
+
+  /** Typedefs. */
+  typedef DataObject::Pointer DataObjectPointer;
+
+  /** Get the image stored under a key; NULL if there is none. */
+  DataObjectPointer GetEntry( const std::string & key ) const;
+
+  /** Store an image under a key, replacing a previous one. */
+  void SetEntry( const std::string & key, DataObject * image );
+
+  /** Remove the entry stored under a key, if there is one. */
+  void RemoveEntry( const std::string & key );
+
+  /** Remove all entries. */
+  void Clear( void );
+
+  /** Get the number of entries. */
+  SizeValueType GetNumberOfEntries( void ) const;
+
+  /** Get the number of times GetEntry() found an entry. */
+  SizeValueType GetNumberOfHits( void ) const;
+
+  /** Get a new identifier for a registration run, which differs from all
+   * identifiers that this cache gave before. Entries that belong to a run,
+   * such as the warm-start state of the optimizers, are keyed by it.
+   */
+  SizeValueType GetNewRunIdentifier( void );
+
+  /** Get a key for an image read from a file: the file name and its
+   * modification time. An empty string is returned if the file does not exist.
+   */
+  static std::string GetFileKey( const std::string & fileName );
+
+  /** Get a key for an image that is computed from an object: the address and
+   * the modification time of the object.
+   */
+  static std::string GetObjectKey( const Object * object );
+
+protected:
+
+  ImageCache() : m_NumberOfHits( 0 ), m_NumberOfRunIdentifiers( 0 ) {}
+  virtual ~ImageCache() {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  ImageCache( const Self & );     // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  typedef std::map< std::string, DataObjectPointer > EntryMapType;
+
+  EntryMapType                m_Entries;
+  mutable SizeValueType       m_NumberOfHits;
+  SizeValueType               m_NumberOfRunIdentifiers;
+  mutable SimpleFastMutexLock m_Mutex;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkImageCache_h
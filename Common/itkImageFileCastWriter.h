@@ -106,6 +106,10 @@ protected:
     localInputImage->Graft( inputImage );
 #endif
 
+    /** Only the buffered piece is written, when writing in stream divisions. */
+    localInputImage->SetLargestPossibleRegion( localInputImage->GetBufferedRegion() );
+    localInputImage->SetRequestedRegion( localInputImage->GetBufferedRegion() );
+
     caster->SetInput( localInputImage );
     caster->Update();
 
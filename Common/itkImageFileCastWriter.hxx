@@ -27,6 +27,7 @@
 #include "itkVectorImage.h"
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkMetaImageIO.h"
+#include "itkImageAlgorithm.h"
 
 namespace itk
 {
@@ -103,6 +104,59 @@ ImageFileCastWriter< TInputImage >
   /** Setup the image IO for writing. */
   this->GetImageIO()->SetFileName( this->GetFileName() );
 
+  /** When writing in stream divisions, the ImageIO expects the current piece
+   * only. Normally the input is buffered for exactly that piece, but an
+   * input that was already updated completely is buffered in full. The
+   * piece is then written straight from that buffer if it is contiguous in
+   * it and needs no conversion, and copied otherwise.
+   */
+  InputImageRegionType ioRegion;
+  ImageIORegionAdaptor< InputImageDimension >::Convert(
+    this->GetImageIO()->GetIORegion(), ioRegion,
+    input->GetLargestPossibleRegion().GetIndex() );
+  const InputImageRegionType & bufferedRegion = input->GetBufferedRegion();
+  const char *                 ioBuffer       = 0;
+  typename InputImageType::Pointer cacheImage;
+  if( bufferedRegion != ioRegion )
+  {
+    if( !bufferedRegion.IsInside( ioRegion ) )
+    {
+      itkExceptionMacro( << "The input is not buffered for the region to write: "
+                         << ioRegion );
+    }
+
+    /** The piece is contiguous if it spans the buffer in the dimensions
+     * below the first one in which it does not, and has size 1 above it. */
+    unsigned int dim = 0;
+    while( dim < InputImageDimension && ioRegion.GetSize()[ dim ] == bufferedRegion.GetSize()[ dim ] )
+    {
+      ++dim;
+    }
+    bool contiguous = true;
+    for( unsigned int d = dim + 1; d < InputImageDimension; ++d )
+    {
+      contiguous &= ( ioRegion.GetSize()[ d ] == 1 );
+    }
+    const bool convert = this->m_OutputComponentType
+      != this->GetImageIO()->GetComponentTypeAsString( this->GetImageIO()->GetComponentType() )
+      && this->GetImageIO()->GetNumberOfComponents() == 1;
+
+    if( contiguous && !convert )
+    {
+      ioBuffer = static_cast< const char * >( static_cast< const void * >( input->GetBufferPointer() ) )
+        + input->ComputeOffset( ioRegion.GetIndex() ) * this->GetImageIO()->GetPixelSize();
+    }
+    else
+    {
+      cacheImage = InputImageType::New();
+      cacheImage->CopyInformation( input );
+      cacheImage->SetBufferedRegion( ioRegion );
+      cacheImage->Allocate();
+      ImageAlgorithm::Copy( input, cacheImage.GetPointer(), ioRegion, ioRegion );
+      input = cacheImage.GetPointer();
+    }
+  }
+
   /** Get the number of Components */
   unsigned int numberOfComponents = this->GetImageIO()->GetNumberOfComponents();
 
@@ -179,7 +233,8 @@ ImageFileCastWriter< TInputImage >
   else
   {
     /** No casting needed or possible, just write */
-    const void * dataPtr = (const void *)input->GetBufferPointer();
+    const void * dataPtr = ioBuffer != 0
+      ? static_cast< const void * >( ioBuffer ) : (const void *)input->GetBufferPointer();
     this->GetImageIO()->Write( dataPtr );
   }
 
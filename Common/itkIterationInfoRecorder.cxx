@@ -0,0 +1,432 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkIterationInfoRecorder_cxx
+#define __itkIterationInfoRecorder_cxx
+
+#include "itkIterationInfoRecorder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace itk
+{
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+IterationInfoRecorder
+::IterationInfoRecorder()
+{
+  this->m_Output     = NULL;
+  this->m_Buffer.resize( 1024 * 1024 );
+  this->m_BufferHead = 0;
+  this->m_BufferFill = 0;
+
+  this->m_Threader                = MultiThreader::New();
+  this->m_ThreadID                = 0;
+  this->m_Started                 = false;
+  this->m_Stopping                = false;
+  this->m_Writing                 = false;
+  this->m_DataAvailableCondition  = ConditionVariable::New();
+  this->m_SpaceAvailableCondition = ConditionVariable::New();
+
+  this->m_NumberOfRecords = 0;
+  this->m_NumberOfBatches = 0;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+IterationInfoRecorder
+::~IterationInfoRecorder()
+{
+  this->Stop();
+
+} // end Destructor
+
+
+/**
+ * ****************** SetOutput *********************************
+ */
+
+void
+IterationInfoRecorder
+::SetOutput( std::ostream * output )
+{
+  this->m_Mutex.Lock();
+  if( !this->m_Started )
+  {
+    this->m_Output = output;
+  }
+  this->m_Mutex.Unlock();
+
+} // end SetOutput()
+
+
+/**
+ * ****************** SetBufferSize *********************************
+ */
+
+void
+IterationInfoRecorder
+::SetBufferSize( SizeValueType bufferSize )
+{
+  this->m_Mutex.Lock();
+  if( !this->m_Started )
+  {
+    /** The buffer should at least hold the length of a record. */
+    bufferSize = std::max( bufferSize,
+      static_cast< SizeValueType >( 2 * sizeof( RecordLengthType ) ) );
+    this->m_Buffer.resize( bufferSize );
+    this->m_BufferHead = 0;
+    this->m_BufferFill = 0;
+  }
+  this->m_Mutex.Unlock();
+
+} // end SetBufferSize()
+
+
+/**
+ * ****************** GetBufferSize *********************************
+ */
+
+SizeValueType
+IterationInfoRecorder
+::GetBufferSize( void ) const
+{
+  this->m_Mutex.Lock();
+  const SizeValueType bufferSize = static_cast< SizeValueType >( this->m_Buffer.size() );
+  this->m_Mutex.Unlock();
+  return bufferSize;
+
+} // end GetBufferSize()
+
+
+/**
+ * ****************** Start *********************************
+ */
+
+void
+IterationInfoRecorder
+::Start( void )
+{
+  this->m_Mutex.Lock();
+  if( !this->m_Started )
+  {
+    this->m_Stopping = false;
+    this->m_ThreadID = this->m_Threader->SpawnThread( WriterThreadCallback, this );
+    this->m_Started  = true;
+  }
+  this->m_Mutex.Unlock();
+
+} // end Start()
+
+
+/**
+ * ****************** Stop *********************************
+ */
+
+void
+IterationInfoRecorder
+::Stop( void )
+{
+  /** Ask the background thread to write the remaining records and quit. */
+  this->m_Mutex.Lock();
+  if( !this->m_Started || this->m_Stopping )
+  {
+    this->m_Mutex.Unlock();
+    return;
+  }
+  this->m_Stopping = true;
+  this->m_DataAvailableCondition->Signal();
+  this->m_Mutex.Unlock();
+
+  /** Join it. */
+  this->m_Threader->TerminateThread( this->m_ThreadID );
+
+  this->m_Mutex.Lock();
+  this->m_Started  = false;
+  this->m_Stopping = false;
+  this->m_Mutex.Unlock();
+
+} // end Stop()
+
+
+/**
+ * ****************** GetStarted *********************************
+ */
+
+bool
+IterationInfoRecorder
+::GetStarted( void ) const
+{
+  this->m_Mutex.Lock();
+  const bool started = this->m_Started;
+  this->m_Mutex.Unlock();
+  return started;
+
+} // end GetStarted()
+
+
+/**
+ * ****************** Record *********************************
+ */
+
+void
+IterationInfoRecorder
+::Record( const char * data, SizeValueType length )
+{
+  const SizeValueType recordSize = sizeof( RecordLengthType ) + length;
+
+  this->m_Mutex.Lock();
+  ++this->m_NumberOfRecords;
+
+  /** Without background thread, write the record directly. */
+  if( !this->m_Started )
+  {
+    this->WriteToOutput( data, length );
+    this->m_Mutex.Unlock();
+    return;
+  }
+
+  /** A record that does not fit in the buffer is written directly, after
+   * the buffer is drained. The lock is kept while writing, so that the
+   * background thread does not write in between.
+   */
+  const SizeValueType bufferSize = static_cast< SizeValueType >( this->m_Buffer.size() );
+  if( recordSize > bufferSize )
+  {
+    while( this->m_BufferFill > 0 || this->m_Writing )
+    {
+      this->m_SpaceAvailableCondition->Wait( &this->m_Mutex );
+    }
+    this->WriteToOutput( data, length );
+    this->m_Mutex.Unlock();
+    return;
+  }
+
+  /** Wait for room, and store the length and the bytes of the record. */
+  while( bufferSize - this->m_BufferFill < recordSize )
+  {
+    this->m_SpaceAvailableCondition->Wait( &this->m_Mutex );
+  }
+  const RecordLengthType recordLength = static_cast< RecordLengthType >( length );
+  this->Push( reinterpret_cast< const char * >( &recordLength ), sizeof( RecordLengthType ) );
+  this->Push( data, length );
+
+  this->m_DataAvailableCondition->Signal();
+  this->m_Mutex.Unlock();
+
+} // end Record()
+
+
+/**
+ * ****************** Flush *********************************
+ */
+
+void
+IterationInfoRecorder
+::Flush( void )
+{
+  this->m_Mutex.Lock();
+  while( this->m_Started && ( this->m_BufferFill > 0 || this->m_Writing ) )
+  {
+    this->m_SpaceAvailableCondition->Wait( &this->m_Mutex );
+  }
+  this->m_Mutex.Unlock();
+
+} // end Flush()
+
+
+/**
+ * ****************** GetNumberOfRecords *********************************
+ */
+
+SizeValueType
+IterationInfoRecorder
+::GetNumberOfRecords( void ) const
+{
+  this->m_Mutex.Lock();
+  const SizeValueType numberOfRecords = this->m_NumberOfRecords;
+  this->m_Mutex.Unlock();
+  return numberOfRecords;
+
+} // end GetNumberOfRecords()
+
+
+/**
+ * ****************** GetNumberOfBatches *********************************
+ */
+
+SizeValueType
+IterationInfoRecorder
+::GetNumberOfBatches( void ) const
+{
+  this->m_Mutex.Lock();
+  const SizeValueType numberOfBatches = this->m_NumberOfBatches;
+  this->m_Mutex.Unlock();
+  return numberOfBatches;
+
+} // end GetNumberOfBatches()
+
+
+/**
+ * ****************** Push *********************************
+ */
+
+void
+IterationInfoRecorder
+::Push( const char * data, SizeValueType length )
+{
+  const SizeValueType bufferSize = static_cast< SizeValueType >( this->m_Buffer.size() );
+  const SizeValueType tail       = ( this->m_BufferHead + this->m_BufferFill ) % bufferSize;
+
+  /** Copy up to the end of the buffer, and the rest to its start. */
+  const SizeValueType first = std::min( length, bufferSize - tail );
+  if( first > 0 ) { std::memcpy( &this->m_Buffer[ tail ], data, first ); }
+  if( length > first ) { std::memcpy( &this->m_Buffer[ 0 ], data + first, length - first ); }
+  this->m_BufferFill += length;
+
+} // end Push()
+
+
+/**
+ * ****************** Pop *********************************
+ */
+
+void
+IterationInfoRecorder
+::Pop( char * data, SizeValueType length )
+{
+  const SizeValueType bufferSize = static_cast< SizeValueType >( this->m_Buffer.size() );
+
+  const SizeValueType first = std::min( length, bufferSize - this->m_BufferHead );
+  if( first > 0 ) { std::memcpy( data, &this->m_Buffer[ this->m_BufferHead ], first ); }
+  if( length > first ) { std::memcpy( data + first, &this->m_Buffer[ 0 ], length - first ); }
+  this->m_BufferHead  = ( this->m_BufferHead + length ) % bufferSize;
+  this->m_BufferFill -= length;
+
+} // end Pop()
+
+
+/**
+ * ****************** WriteToOutput *********************************
+ */
+
+void
+IterationInfoRecorder
+::WriteToOutput( const char * data, SizeValueType length )
+{
+  if( this->m_Output != NULL && length > 0 )
+  {
+    this->m_Output->write( data, static_cast< std::streamsize >( length ) );
+    this->m_Output->flush();
+  }
+
+} // end WriteToOutput()
+
+
+/**
+ * ****************** WriterThreadCallback *********************************
+ */
+
+ITK_THREAD_RETURN_TYPE
+IterationInfoRecorder
+::WriterThreadCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  static_cast< Self * >( infoStruct->UserData )->WriterLoop();
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end WriterThreadCallback()
+
+
+/**
+ * ****************** WriterLoop *********************************
+ */
+
+void
+IterationInfoRecorder
+::WriterLoop( void )
+{
+  std::string batch;
+
+  this->m_Mutex.Lock();
+  while( true )
+  {
+    /** Sleep until records are stored, or the recorder is stopped. */
+    while( this->m_BufferFill == 0 && !this->m_Stopping )
+    {
+      this->m_DataAvailableCondition->Wait( &this->m_Mutex );
+    }
+    if( this->m_BufferFill == 0 ) { break; }
+
+    /** Take all stored records out of the buffer. */
+    batch.clear();
+    while( this->m_BufferFill > 0 )
+    {
+      RecordLengthType recordLength = 0;
+      this->Pop( reinterpret_cast< char * >( &recordLength ), sizeof( RecordLengthType ) );
+      const std::string::size_type offset = batch.size();
+      batch.resize( offset + recordLength );
+      if( recordLength > 0 ) { this->Pop( &batch[ offset ], recordLength ); }
+    }
+    this->m_Writing = true;
+    this->m_SpaceAvailableCondition->Broadcast();
+    this->m_Mutex.Unlock();
+
+    /** Write them without holding the lock. */
+    this->WriteToOutput( batch.data(), static_cast< SizeValueType >( batch.size() ) );
+
+    this->m_Mutex.Lock();
+    this->m_Writing = false;
+    ++this->m_NumberOfBatches;
+    this->m_SpaceAvailableCondition->Broadcast();
+  }
+  this->m_Mutex.Unlock();
+
+} // end WriterLoop()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+IterationInfoRecorder
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "BufferSize: " << this->GetBufferSize() << std::endl;
+  os << indent << "Started: " << this->GetStarted() << std::endl;
+  os << indent << "NumberOfRecords: " << this->GetNumberOfRecords() << std::endl;
+  os << indent << "NumberOfBatches: " << this->GetNumberOfBatches() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkIterationInfoRecorder_cxx
@@ -0,0 +1,172 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkIterationInfoRecorder_h
+#define __itkIterationInfoRecorder_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+#include "itkConditionVariable.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class IterationInfoRecorder
+ *
+ * \brief Writes records, such as the rows of the IterationInfo table, to an
+ * output stream from a background thread.
+ *
+ * Writing the iteration info directly costs a formatted write and a flush
+ * of every output per iteration, which for cheap iterations is a noticeable
+ * part of the registration time. Record() only copies the record in a ring
+ * buffer, and returns. A background thread drains the buffer and writes the
+ * records to the output, flushing once per batch of records.
+ *
+ * The ring buffer is binary: each record is stored as its length, followed
+ * by its bytes, so that records of any content and size keep their
+ * boundaries when the buffer wraps around. When the buffer is full, Record()
+ * waits until the background thread made room. Records that do not fit in
+ * the buffer at all are written directly, after the buffer is drained. The
+ * order of the records is always preserved.
+ *
+ * While started, the output stream is used by the background thread only;
+ * it must not be written to or closed before Stop() is called. Without
+ * Start(), Record() writes to the output directly.
+ *
+ * \ingroup ITKCommon
+ */
+
+class IterationInfoRecorder : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef IterationInfoRecorder      Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( IterationInfoRecorder, Object );
+
+  /** Set the output stream. Ignored while the recorder is started. */
+  void SetOutput( std::ostream * output );
+
+  /** Set the size of the ring buffer in bytes. Ignored while the recorder
+   * is started. Default: 1 MB.
+   */
+  void SetBufferSize( SizeValueType bufferSize );
+
+  SizeValueType GetBufferSize( void ) const;
+
+  /** Start the background thread. */
+  void Start( void );
+
+  /** Write the remaining records, and stop the background thread. Also
+   * called by the destructor.
+   */
+  void Stop( void );
+
+  /** Is the background thread running? */
+  bool GetStarted( void ) const;
+
+  /** Store a record, to be written to the output by the background thread. */
+  void Record( const char * data, SizeValueType length );
+
+  void Record( const std::string & record )
+  {
+    this->Record( record.data(), static_cast< SizeValueType >( record.size() ) );
+  }
+
+
+  /** Wait until all stored records are written to the output. */
+  void Flush( void );
+
+  /** Get the number of records stored since the construction. */
+  SizeValueType GetNumberOfRecords( void ) const;
+
+  /** Get the number of times the output was written and flushed by the
+   * background thread. Each batch contains one or more records.
+   */
+  SizeValueType GetNumberOfBatches( void ) const;
+
+protected:
+
+  IterationInfoRecorder();
+  virtual ~IterationInfoRecorder();
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  IterationInfoRecorder( const Self & ); // purposely not implemented
+  void operator=( const Self & );        // purposely not implemented
+
+  /** The type in which the length of a record is stored. */
+  typedef uint32_t RecordLengthType;
+
+  /** Copy bytes to and from the ring buffer. Assume that m_Mutex is locked. */
+  void Push( const char * data, SizeValueType length );
+
+  void Pop( char * data, SizeValueType length );
+
+  /** Write data to the output, flushing it. */
+  void WriteToOutput( const char * data, SizeValueType length );
+
+  /** The function executed by the background thread. */
+  static ITK_THREAD_RETURN_TYPE WriterThreadCallback( void * arg );
+
+  /** The loop that waits for records and writes them. */
+  void WriterLoop( void );
+
+  std::ostream * m_Output;
+
+  /** The ring buffer. */
+  std::vector< char > m_Buffer;
+  SizeValueType       m_BufferHead;
+  SizeValueType       m_BufferFill;
+
+  /** The background thread and synchronization. */
+  MultiThreader::Pointer     m_Threader;
+  ThreadIdType               m_ThreadID;
+  bool                       m_Started;
+  bool                       m_Stopping;
+  bool                       m_Writing;
+  mutable SimpleMutexLock    m_Mutex;
+  ConditionVariable::Pointer m_DataAvailableCondition;
+  ConditionVariable::Pointer m_SpaceAvailableCondition;
+
+  /** Statistics. */
+  SizeValueType m_NumberOfRecords;
+  SizeValueType m_NumberOfBatches;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkIterationInfoRecorder_h
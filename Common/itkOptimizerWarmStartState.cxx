@@ -0,0 +1,158 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkOptimizerWarmStartState_cxx
+#define __itkOptimizerWarmStartState_cxx
+
+#include "itkOptimizerWarmStartState.h"
+
+#include <sstream>
+
+namespace itk
+{
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+OptimizerWarmStartState
+::OptimizerWarmStartState()
+{
+  this->m_NoiseRatio                   = 0.0;
+  this->m_NumberOfGradientMeasurements = 0;
+
+} // end Constructor
+
+
+/**
+ * ****************** SetCurvaturePairs *********************************
+ */
+
+void
+OptimizerWarmStartState
+::SetCurvaturePairs( const VectorContainerType & steps,
+  const VectorContainerType & gradientDifferences,
+  const std::string & parameterSpace )
+{
+  if( steps.size() != gradientDifferences.size() )
+  {
+    itkExceptionMacro( << "The numbers of steps and gradient differences differ: "
+                       << steps.size() << " and " << gradientDifferences.size() << "." );
+  }
+
+  this->m_CurvatureSteps               = steps;
+  this->m_CurvatureGradientDifferences = gradientDifferences;
+  this->m_ParameterSpace               = parameterSpace;
+  this->Modified();
+
+} // end SetCurvaturePairs()
+
+
+/**
+ * ****************** Initialize *********************************
+ */
+
+void
+OptimizerWarmStartState
+::Initialize( void )
+{
+  this->Superclass::Initialize();
+
+  this->m_NoiseRatio                   = 0.0;
+  this->m_NumberOfGradientMeasurements = 0;
+  this->m_CurvatureSteps.clear();
+  this->m_CurvatureGradientDifferences.clear();
+  this->m_ParameterSpace.clear();
+
+} // end Initialize()
+
+
+/**
+ * ****************** GetCacheKey *********************************
+ */
+
+std::string
+OptimizerWarmStartState
+::GetCacheKey( SizeValueType runIdentifier, unsigned int elastixLevel,
+  const std::string & componentLabel )
+{
+  std::ostringstream key;
+  key << "OptimizerWarmStartState:" << runIdentifier << ":"
+      << elastixLevel << ":" << componentLabel;
+  return key.str();
+
+} // end GetCacheKey()
+
+
+/**
+ * ****************** GetFromCache *********************************
+ */
+
+OptimizerWarmStartState::Pointer
+OptimizerWarmStartState
+::GetFromCache( ImageCache * imageCache, SizeValueType runIdentifier,
+  unsigned int elastixLevel, const std::string & componentLabel )
+{
+  Pointer state;
+  if( imageCache && elastixLevel > 0 )
+  {
+    /** Only this elastix level uses the state of the previous one. */
+    const std::string previousKey = GetCacheKey(
+      runIdentifier, elastixLevel - 1, componentLabel );
+    state = dynamic_cast< Self * >( imageCache->GetEntry( previousKey ).GetPointer() );
+    imageCache->RemoveEntry( previousKey );
+  }
+
+  if( state.IsNull() )
+  {
+    state = Self::New();
+  }
+
+  if( imageCache )
+  {
+    imageCache->SetEntry( GetCacheKey(
+      runIdentifier, elastixLevel, componentLabel ), state );
+  }
+
+  return state;
+
+} // end GetFromCache()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+OptimizerWarmStartState
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NoiseRatio: " << this->m_NoiseRatio << std::endl;
+  os << indent << "NumberOfGradientMeasurements: "
+     << this->m_NumberOfGradientMeasurements << std::endl;
+  os << indent << "NumberOfCurvaturePairs: "
+     << this->GetNumberOfCurvaturePairs() << std::endl;
+  os << indent << "ParameterSpace: " << this->m_ParameterSpace << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkOptimizerWarmStartState_cxx
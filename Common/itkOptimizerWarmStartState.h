@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkOptimizerWarmStartState_h
+#define __itkOptimizerWarmStartState_h
+
+#include "itkDataObject.h"
+#include "itkImageCache.h"
+#include "itkObjectFactory.h"
+#include "itkArray.h"
+#include "itkIntTypes.h"
+
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class OptimizerWarmStartState
+ *
+ * \brief Stores the state that an optimizer learned in one resolution, so
+ * that it can start the next resolution, or the next elastix level, from it
+ * instead of from scratch.
+ *
+ * Two kinds of state are stored:
+ * \li The gradient statistics of the stochastic gradient descent optimizers:
+ *   the ratio ee / gg of the mean squared magnitudes of the approximation
+ *   error and of the exact gradient, and the number of gradient measurements
+ *   it is based on. The ratio determines the noise compensation of the step
+ *   size, and does not depend on the parameterization of the transform.
+ * \li The curvature pairs ( s, y ) of the quasi-Newton optimizers: the steps
+ *   and the corresponding gradient differences, ordered from old to new.
+ *   They are stored unscaled, in the parameter space of the transform named
+ *   by GetParameterSpace().
+ *
+ * The state is a DataObject, so that it can be stored in the ImageCache that
+ * is shared by successive elastix levels. GetFromCache() looks it up there.
+ *
+ * \ingroup Optimizers
+ */
+
+class OptimizerWarmStartState : public DataObject
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef OptimizerWarmStartState    Self;
+  typedef DataObject                 Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( OptimizerWarmStartState, DataObject );
+
+  /** Typedefs. */
+  typedef Array< double >           VectorType;
+  typedef std::vector< VectorType > VectorContainerType;
+
+  /** Set/Get the ratio ee / gg of the gradient statistics. */
+  itkSetMacro( NoiseRatio, double );
+  itkGetConstMacro( NoiseRatio, double );
+
+  /** Set/Get the number of gradient measurements behind the noise ratio.
+   * Zero means that no gradient statistics are stored.
+   */
+  itkSetMacro( NumberOfGradientMeasurements, SizeValueType );
+  itkGetConstMacro( NumberOfGradientMeasurements, SizeValueType );
+
+  /** Store curvature pairs, ordered from old to new, together with the name
+   * of the transform in whose parameter space they are defined.
+   */
+  void SetCurvaturePairs( const VectorContainerType & steps,
+    const VectorContainerType & gradientDifferences,
+    const std::string & parameterSpace );
+
+  /** Get the stored steps s and gradient differences y. */
+  const VectorContainerType & GetCurvatureSteps( void ) const
+  {
+    return this->m_CurvatureSteps;
+  }
+
+
+  const VectorContainerType & GetCurvatureGradientDifferences( void ) const
+  {
+    return this->m_CurvatureGradientDifferences;
+  }
+
+
+  /** Get the name of the transform of the curvature pairs. */
+  const std::string & GetParameterSpace( void ) const
+  {
+    return this->m_ParameterSpace;
+  }
+
+
+  /** Get the number of stored curvature pairs. */
+  SizeValueType GetNumberOfCurvaturePairs( void ) const
+  {
+    return static_cast< SizeValueType >( this->m_CurvatureSteps.size() );
+  }
+
+
+  /** Remove all state. */
+  virtual void Initialize( void );
+
+  /** Get the key of the state of an optimizer in the image cache. A
+   * registration run is identified by the run identifier that the image
+   * cache gave it, see ImageCache::GetNewRunIdentifier(), which all its
+   * elastix levels share. The elastix level is part of the key as well; see
+   * GetFromCache().
+   */
+  static std::string GetCacheKey( SizeValueType runIdentifier,
+    unsigned int elastixLevel, const std::string & componentLabel );
+
+  /** Get the state for an optimizer in an elastix level: the state that the
+   * same optimizer left in the previous elastix level of the run, or else a
+   * new state. The entry of the previous elastix level is removed from the
+   * cache, and the state is stored under the key of this elastix level.
+   */
+  static Pointer GetFromCache( ImageCache * imageCache,
+    SizeValueType runIdentifier, unsigned int elastixLevel,
+    const std::string & componentLabel );
+
+protected:
+
+  OptimizerWarmStartState();
+  virtual ~OptimizerWarmStartState() {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  OptimizerWarmStartState( const Self & ); // purposely not implemented
+  void operator=( const Self & );          // purposely not implemented
+
+  double        m_NoiseRatio;
+  SizeValueType m_NumberOfGradientMeasurements;
+
+  VectorContainerType m_CurvatureSteps;
+  VectorContainerType m_CurvatureGradientDifferences;
+  std::string         m_ParameterSpace;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkOptimizerWarmStartState_h
@@ -0,0 +1,410 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkParameterVectorOperations_cxx
+#define __itkParameterVectorOperations_cxx
+
+#include "itkParameterVectorOperations.h"
+#include "itkWorkerThreadPool.h"
+
+#include <algorithm>
+#include <vector>
+#include "vnl/vnl_math.h"
+
+namespace itk
+{
+
+/**
+ * ****************** Axpy *********************************
+ */
+
+void
+ParameterVectorOperations
+::Axpy( const double a, const VectorType & x, VectorType & y,
+  ThreadIdType numberOfThreads )
+{
+  CheckSize( x, y );
+
+  JobType job = JobType();
+  job.st_Operation = AxpyOperation;
+  job.st_A         = a;
+  job.st_X         = x.data_block();
+  job.st_Z         = y.data_block();
+  job.st_Size      = x.GetSize();
+  Execute( job, numberOfThreads );
+
+} // end Axpy()
+
+
+/**
+ * ****************** LinearCombination *********************************
+ */
+
+void
+ParameterVectorOperations
+::LinearCombination( const double a, const VectorType & x,
+  const double b, const VectorType & y, VectorType & z,
+  ThreadIdType numberOfThreads )
+{
+  CheckSize( x, y );
+  if( z.GetSize() != x.GetSize() ) { z.SetSize( x.GetSize() ); }
+
+  JobType job = JobType();
+  job.st_Operation = LinearCombinationOperation;
+  job.st_A         = a;
+  job.st_B         = b;
+  job.st_X         = x.data_block();
+  job.st_Y         = y.data_block();
+  job.st_Z         = z.data_block();
+  job.st_Size      = x.GetSize();
+  Execute( job, numberOfThreads );
+
+} // end LinearCombination()
+
+
+/**
+ * ****************** ScaledCopy *********************************
+ */
+
+void
+ParameterVectorOperations
+::ScaledCopy( const double a, const VectorType & x, VectorType & y,
+  ThreadIdType numberOfThreads )
+{
+  if( y.GetSize() != x.GetSize() ) { y.SetSize( x.GetSize() ); }
+
+  JobType job = JobType();
+  job.st_Operation = ScaledCopyOperation;
+  job.st_A         = a;
+  job.st_X         = x.data_block();
+  job.st_Z         = y.data_block();
+  job.st_Size      = x.GetSize();
+  Execute( job, numberOfThreads );
+
+} // end ScaledCopy()
+
+
+/**
+ * ****************** Scale *********************************
+ */
+
+void
+ParameterVectorOperations
+::Scale( const double a, VectorType & x, ThreadIdType numberOfThreads )
+{
+  JobType job = JobType();
+  job.st_Operation = ScaleOperation;
+  job.st_A         = a;
+  job.st_Z         = x.data_block();
+  job.st_Size      = x.GetSize();
+  Execute( job, numberOfThreads );
+
+} // end Scale()
+
+
+/**
+ * ****************** Multiply *********************************
+ */
+
+void
+ParameterVectorOperations
+::Multiply( const VectorType & x, const VectorType & y,
+  VectorType & z, ThreadIdType numberOfThreads )
+{
+  CheckSize( x, y );
+  if( z.GetSize() != x.GetSize() ) { z.SetSize( x.GetSize() ); }
+
+  JobType job = JobType();
+  job.st_Operation = MultiplyOperation;
+  job.st_X         = x.data_block();
+  job.st_Y         = y.data_block();
+  job.st_Z         = z.data_block();
+  job.st_Size      = x.GetSize();
+  Execute( job, numberOfThreads );
+
+} // end Multiply()
+
+
+/**
+ * ****************** Divide *********************************
+ */
+
+void
+ParameterVectorOperations
+::Divide( const VectorType & x, const VectorType & y,
+  VectorType & z, ThreadIdType numberOfThreads )
+{
+  CheckSize( x, y );
+  if( z.GetSize() != x.GetSize() ) { z.SetSize( x.GetSize() ); }
+
+  JobType job = JobType();
+  job.st_Operation = DivideOperation;
+  job.st_X         = x.data_block();
+  job.st_Y         = y.data_block();
+  job.st_Z         = z.data_block();
+  job.st_Size      = x.GetSize();
+  Execute( job, numberOfThreads );
+
+} // end Divide()
+
+
+/**
+ * ****************** MultiplyAdd *********************************
+ */
+
+void
+ParameterVectorOperations
+::MultiplyAdd( const VectorType & x, const VectorType & w,
+  const VectorType & y, VectorType & z, ThreadIdType numberOfThreads )
+{
+  CheckSize( x, w );
+  CheckSize( x, y );
+  if( z.GetSize() != x.GetSize() ) { z.SetSize( x.GetSize() ); }
+
+  JobType job = JobType();
+  job.st_Operation = MultiplyAddOperation;
+  job.st_X         = x.data_block();
+  job.st_W         = w.data_block();
+  job.st_Y         = y.data_block();
+  job.st_Z         = z.data_block();
+  job.st_Size      = x.GetSize();
+  Execute( job, numberOfThreads );
+
+} // end MultiplyAdd()
+
+
+/**
+ * ****************** Dot *********************************
+ */
+
+double
+ParameterVectorOperations
+::Dot( const VectorType & x, const VectorType & y, ThreadIdType numberOfThreads )
+{
+  CheckSize( x, y );
+
+  JobType job = JobType();
+  job.st_Operation = DotOperation;
+  job.st_X         = x.data_block();
+  job.st_Y         = y.data_block();
+  job.st_Size      = x.GetSize();
+  return Execute( job, numberOfThreads );
+
+} // end Dot()
+
+
+/**
+ * ****************** DotDifference *********************************
+ */
+
+double
+ParameterVectorOperations
+::DotDifference( const VectorType & x, const VectorType & y,
+  const VectorType & w, ThreadIdType numberOfThreads )
+{
+  CheckSize( x, y );
+  CheckSize( x, w );
+
+  JobType job = JobType();
+  job.st_Operation = DotDifferenceOperation;
+  job.st_X         = x.data_block();
+  job.st_Y         = y.data_block();
+  job.st_W         = w.data_block();
+  job.st_Size      = x.GetSize();
+  return Execute( job, numberOfThreads );
+
+} // end DotDifference()
+
+
+/**
+ * ****************** SquaredNorm *********************************
+ */
+
+double
+ParameterVectorOperations
+::SquaredNorm( const VectorType & x, ThreadIdType numberOfThreads )
+{
+  JobType job = JobType();
+  job.st_Operation = SquaredNormOperation;
+  job.st_X         = x.data_block();
+  job.st_Size      = x.GetSize();
+  return Execute( job, numberOfThreads );
+
+} // end SquaredNorm()
+
+
+/**
+ * ****************** Norm *********************************
+ */
+
+double
+ParameterVectorOperations
+::Norm( const VectorType & x, ThreadIdType numberOfThreads )
+{
+  return vcl_sqrt( SquaredNorm( x, numberOfThreads ) );
+
+} // end Norm()
+
+
+/**
+ * ****************** Execute *********************************
+ */
+
+double
+ParameterVectorOperations
+::Execute( JobType & job, ThreadIdType numberOfThreads )
+{
+  const SizeValueType blockSize = GetBlockSize();
+  job.st_NumberOfBlocks = ( job.st_Size + blockSize - 1 ) / blockSize;
+  job.st_BlockSums      = NULL;
+
+  if( numberOfThreads == 0 )
+  {
+    numberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+  numberOfThreads = static_cast< ThreadIdType >( std::min(
+    static_cast< SizeValueType >( numberOfThreads ), job.st_NumberOfBlocks ) );
+
+  /** Small vectors are processed serially, in the same blocks. */
+  double sum = 0.0;
+  if( numberOfThreads <= 1 || job.st_Size < GetMinimumParallelSize() )
+  {
+    for( SizeValueType block = 0; block < job.st_NumberOfBlocks; ++block )
+    {
+      sum += ExecuteBlock( job, block );
+    }
+    return sum;
+  }
+
+  /** Process the blocks in parallel, and add the partial sums in order. */
+  std::vector< double > blockSums( job.st_NumberOfBlocks, 0.0 );
+  job.st_BlockSums = &blockSums[ 0 ];
+  WorkerThreadPool::GetInstance()->Execute( ThreaderCallback, &job, numberOfThreads );
+  for( SizeValueType block = 0; block < job.st_NumberOfBlocks; ++block )
+  {
+    sum += blockSums[ block ];
+  }
+  return sum;
+
+} // end Execute()
+
+
+/**
+ * ****************** ThreaderCallback *********************************
+ */
+
+ITK_THREAD_RETURN_TYPE
+ParameterVectorOperations
+::ThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const JobType &     job             = *static_cast< JobType * >( infoStruct->UserData );
+  const SizeValueType threadID        = infoStruct->ThreadID;
+  const SizeValueType numberOfThreads = infoStruct->NumberOfThreads;
+
+  /** Each thread processes a contiguous range of blocks. */
+  const SizeValueType blockBegin = threadID * job.st_NumberOfBlocks / numberOfThreads;
+  const SizeValueType blockEnd   = ( threadID + 1 ) * job.st_NumberOfBlocks / numberOfThreads;
+  for( SizeValueType block = blockBegin; block < blockEnd; ++block )
+  {
+    job.st_BlockSums[ block ] = ExecuteBlock( job, block );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ThreaderCallback()
+
+
+/**
+ * ****************** ExecuteBlock *********************************
+ */
+
+double
+ParameterVectorOperations
+::ExecuteBlock( const JobType & job, const SizeValueType block )
+{
+  const SizeValueType begin = block * GetBlockSize();
+  const SizeValueType end   = std::min( begin + GetBlockSize(), job.st_Size );
+
+  const double   a   = job.st_A;
+  const double   b   = job.st_B;
+  const double * x   = job.st_X;
+  const double * y   = job.st_Y;
+  const double * w   = job.st_W;
+  double *       z   = job.st_Z;
+  double         sum = 0.0;
+
+  switch( job.st_Operation )
+  {
+    case AxpyOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { z[ i ] += a * x[ i ]; }
+      break;
+    case LinearCombinationOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { z[ i ] = a * x[ i ] + b * y[ i ]; }
+      break;
+    case ScaledCopyOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { z[ i ] = a * x[ i ]; }
+      break;
+    case ScaleOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { z[ i ] *= a; }
+      break;
+    case MultiplyOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { z[ i ] = x[ i ] * y[ i ]; }
+      break;
+    case DivideOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { z[ i ] = x[ i ] / y[ i ]; }
+      break;
+    case MultiplyAddOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { z[ i ] = x[ i ] + w[ i ] * y[ i ]; }
+      break;
+    case DotOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { sum += x[ i ] * y[ i ]; }
+      break;
+    case DotDifferenceOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { sum += x[ i ] * ( y[ i ] - w[ i ] ); }
+      break;
+    case SquaredNormOperation:
+      for( SizeValueType i = begin; i < end; ++i ) { sum += x[ i ] * x[ i ]; }
+      break;
+  }
+
+  return sum;
+
+} // end ExecuteBlock()
+
+
+/**
+ * ****************** CheckSize *********************************
+ */
+
+void
+ParameterVectorOperations
+::CheckSize( const VectorType & x, const VectorType & y )
+{
+  if( x.GetSize() != y.GetSize() )
+  {
+    itkGenericExceptionMacro( << "The vectors have different sizes: "
+                              << x.GetSize() << " and " << y.GetSize() << "." );
+  }
+
+} // end CheckSize()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkParameterVectorOperations_cxx
@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkParameterVectorOperations_h
+#define __itkParameterVectorOperations_h
+
+#include "itkArray.h"
+#include "itkIntTypes.h"
+#include "itkMultiThreader.h"
+
+namespace itk
+{
+
+/** \class ParameterVectorOperations
+ *
+ * \brief Multi-threaded vector algebra on parameter and derivative vectors,
+ * shared by the optimizers.
+ *
+ * For transforms with millions of parameters, such as a fine B-spline grid,
+ * the vector operations of an optimizer iteration (the step, the L-BFGS
+ * recursion, the conjugate gradient beta) are no longer negligible compared
+ * to the cost function evaluation. This class provides these operations,
+ * executed on the WorkerThreadPool for large vectors, and serially for small
+ * ones, where starting the threads would cost more than it saves. The loops
+ * are written on raw pointers, so that the compiler can vectorize them.
+ *
+ * The vectors are split in blocks of fixed size. The reductions (Dot(),
+ * SquaredNorm()) compute a partial sum per block, and add the partial sums
+ * in block order. The result therefore does not depend on the number of
+ * threads, nor on whether the vector was large enough to be processed in
+ * parallel.
+ *
+ * In the elementwise operations the output may be one of the inputs.
+ * A numberOfThreads of 0 selects the global default number of threads.
+ *
+ * \ingroup Optimizers
+ */
+
+class ParameterVectorOperations
+{
+public:
+
+  typedef Array< double > VectorType;
+
+  /** y = y + a * x */
+  static void Axpy( const double a, const VectorType & x, VectorType & y,
+    ThreadIdType numberOfThreads = 0 );
+
+  /** z = a * x + b * y */
+  static void LinearCombination( const double a, const VectorType & x,
+    const double b, const VectorType & y, VectorType & z,
+    ThreadIdType numberOfThreads = 0 );
+
+  /** y = a * x */
+  static void ScaledCopy( const double a, const VectorType & x, VectorType & y,
+    ThreadIdType numberOfThreads = 0 );
+
+  /** x = a * x */
+  static void Scale( const double a, VectorType & x,
+    ThreadIdType numberOfThreads = 0 );
+
+  /** z = x .* y, elementwise. */
+  static void Multiply( const VectorType & x, const VectorType & y,
+    VectorType & z, ThreadIdType numberOfThreads = 0 );
+
+  /** z = x ./ y, elementwise. */
+  static void Divide( const VectorType & x, const VectorType & y,
+    VectorType & z, ThreadIdType numberOfThreads = 0 );
+
+  /** z = x + w .* y, elementwise. Used for updates with a step length per
+   * parameter, or a diagonal preconditioner w.
+   */
+  static void MultiplyAdd( const VectorType & x, const VectorType & w,
+    const VectorType & y, VectorType & z, ThreadIdType numberOfThreads = 0 );
+
+  /** Return x . y */
+  static double Dot( const VectorType & x, const VectorType & y,
+    ThreadIdType numberOfThreads = 0 );
+
+  /** Return x . ( y - w ), without computing y - w. */
+  static double DotDifference( const VectorType & x, const VectorType & y,
+    const VectorType & w, ThreadIdType numberOfThreads = 0 );
+
+  /** Return x . x */
+  static double SquaredNorm( const VectorType & x,
+    ThreadIdType numberOfThreads = 0 );
+
+  /** Return sqrt( x . x ) */
+  static double Norm( const VectorType & x,
+    ThreadIdType numberOfThreads = 0 );
+
+  /** The number of elements per block, and the minimum vector size for
+   * which multiple threads are used.
+   */
+  static SizeValueType GetBlockSize( void ) { return 4096; }
+  static SizeValueType GetMinimumParallelSize( void ) { return 65536; }
+
+private:
+
+  ParameterVectorOperations();                                    // purposely not implemented
+  ParameterVectorOperations( const ParameterVectorOperations & ); // purposely not implemented
+  void operator=( const ParameterVectorOperations & );            // purposely not implemented
+
+  /** The operations. */
+  enum OperationType {
+    AxpyOperation,
+    LinearCombinationOperation,
+    ScaledCopyOperation,
+    ScaleOperation,
+    MultiplyOperation,
+    DivideOperation,
+    MultiplyAddOperation,
+    DotOperation,
+    DotDifferenceOperation,
+    SquaredNormOperation
+  };
+
+  /** The description of an operation, passed to the threads. */
+  struct JobType
+  {
+    OperationType  st_Operation;
+    double         st_A;
+    double         st_B;
+    const double * st_X;
+    const double * st_Y;
+    const double * st_W;
+    double *       st_Z;
+    SizeValueType  st_Size;
+    SizeValueType  st_NumberOfBlocks;
+    double *       st_BlockSums;
+  };
+
+  /** Execute an operation on all blocks, and return the sum of the block
+   * results of a reduction.
+   */
+  static double Execute( JobType & job, ThreadIdType numberOfThreads );
+
+  /** Execute an operation on one block, and return its partial sum. */
+  static double ExecuteBlock( const JobType & job, const SizeValueType block );
+
+  /** The callback executed by each thread. */
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback( void * arg );
+
+  /** Check that the vectors have equal sizes. */
+  static void CheckSize( const VectorType & x, const VectorType & y );
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkParameterVectorOperations_h
@@ -0,0 +1,291 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkRegistrationProfiler_cxx
+#define __itkRegistrationProfiler_cxx
+
+#include "itkRegistrationProfiler.h"
+#include "itkMutexLockHolder.h"
+
+#include <iomanip>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace itk
+{
+
+/** The names of the phases, in the order of PhaseType. */
+static const char * const g_RegistrationProfilerPhaseNames[ RegistrationProfiler::NumberOfPhases ] = {
+  "Sampling",
+  "TransformEvaluation",
+  "Interpolation",
+  "JacobianProduct",
+  "DerivativeAccumulation",
+  "MetricEvaluation",
+  "OptimizerUpdate",
+  "ParameterEstimation"
+};
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+RegistrationProfiler
+::RegistrationProfiler()
+{
+  this->m_CurrentResolution = 0;
+
+} // end Constructor
+
+
+/**
+ * ****************** GetPhaseName *********************************
+ */
+
+const char *
+RegistrationProfiler
+::GetPhaseName( const PhaseType phase )
+{
+  if( phase >= NumberOfPhases ) { return "Unknown"; }
+  return g_RegistrationProfilerPhaseNames[ phase ];
+
+} // end GetPhaseName()
+
+
+/**
+ * ****************** GetWallClock *********************************
+ */
+
+double
+RegistrationProfiler
+::GetWallClock( void )
+{
+#if defined( _WIN32 )
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency( &frequency );
+  QueryPerformanceCounter( &counter );
+  return static_cast< double >( counter.QuadPart ) / static_cast< double >( frequency.QuadPart );
+#else
+  struct timespec time;
+  clock_gettime( CLOCK_MONOTONIC, &time );
+  return static_cast< double >( time.tv_sec ) + 1.0e-9 * static_cast< double >( time.tv_nsec );
+#endif
+
+} // end GetWallClock()
+
+
+/**
+ * ****************** GetThreadCPUClock *********************************
+ */
+
+double
+RegistrationProfiler
+::GetThreadCPUClock( void )
+{
+#if defined( _WIN32 )
+  FILETIME creationTime, exitTime, kernelTime, userTime;
+  if( !GetThreadTimes( GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime ) )
+  {
+    return 0.0;
+  }
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart  = kernelTime.dwLowDateTime;
+  kernel.HighPart = kernelTime.dwHighDateTime;
+  user.LowPart    = userTime.dwLowDateTime;
+  user.HighPart   = userTime.dwHighDateTime;
+
+  /** FILETIME is in units of 100 ns. */
+  return 1.0e-7 * static_cast< double >( kernel.QuadPart + user.QuadPart );
+#else
+  struct timespec time;
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &time );
+  return static_cast< double >( time.tv_sec ) + 1.0e-9 * static_cast< double >( time.tv_nsec );
+#endif
+
+} // end GetThreadCPUClock()
+
+
+/**
+ * ****************** Reset *********************************
+ */
+
+void
+RegistrationProfiler
+::Reset( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  this->m_Resolutions.clear();
+  this->m_CurrentResolution = 0;
+
+} // end Reset()
+
+
+/**
+ * ****************** StartResolution *********************************
+ */
+
+void
+RegistrationProfiler
+::StartResolution( const unsigned int resolution )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+
+  PhaseRecordType emptyRecord;
+  emptyRecord.st_NumberOfCalls = 0;
+  emptyRecord.st_WallTime      = 0.0;
+  emptyRecord.st_CPUTime       = 0.0;
+
+  if( resolution >= this->m_Resolutions.size() )
+  {
+    this->m_Resolutions.resize( resolution + 1,
+      ResolutionRecordType( NumberOfPhases, emptyRecord ) );
+  }
+  this->m_Resolutions[ resolution ].assign( NumberOfPhases, emptyRecord );
+  this->m_CurrentResolution = resolution;
+
+} // end StartResolution()
+
+
+/**
+ * ****************** GetNumberOfResolutions *********************************
+ */
+
+unsigned int
+RegistrationProfiler
+::GetNumberOfResolutions( void ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  return static_cast< unsigned int >( this->m_Resolutions.size() );
+
+} // end GetNumberOfResolutions()
+
+
+/**
+ * ****************** AddTime *********************************
+ */
+
+void
+RegistrationProfiler
+::AddTime( const PhaseType phase, const double wallTime,
+  const double cpuTime, const SizeValueType numberOfCalls )
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+
+  /** Ignore measurements before the first resolution. */
+  if( this->m_CurrentResolution >= this->m_Resolutions.size() ) { return; }
+
+  PhaseRecordType & record = this->m_Resolutions[ this->m_CurrentResolution ][ phase ];
+  record.st_NumberOfCalls += numberOfCalls;
+  record.st_WallTime      += wallTime;
+  record.st_CPUTime       += cpuTime;
+
+} // end AddTime()
+
+
+/**
+ * ****************** GetPhaseRecord *********************************
+ */
+
+RegistrationProfiler::PhaseRecordType
+RegistrationProfiler
+::GetPhaseRecord( const unsigned int resolution, const PhaseType phase ) const
+{
+  MutexLockHolder< SimpleFastMutexLock > lock( this->m_Mutex );
+  if( resolution >= this->m_Resolutions.size() || phase >= NumberOfPhases )
+  {
+    PhaseRecordType emptyRecord;
+    emptyRecord.st_NumberOfCalls = 0;
+    emptyRecord.st_WallTime      = 0.0;
+    emptyRecord.st_CPUTime       = 0.0;
+    return emptyRecord;
+  }
+  return this->m_Resolutions[ resolution ][ phase ];
+
+} // end GetPhaseRecord()
+
+
+/**
+ * ****************** WriteCSV *********************************
+ */
+
+void
+RegistrationProfiler
+::WriteCSV( std::ostream & os, const unsigned int resolution ) const
+{
+  os << "Resolution,Phase,NumberOfCalls,WallTime[s],CPUTime[s]\n";
+  os << std::setprecision( 9 );
+  for( unsigned int i = 0; i < NumberOfPhases; ++i )
+  {
+    const PhaseType       phase  = static_cast< PhaseType >( i );
+    const PhaseRecordType record = this->GetPhaseRecord( resolution, phase );
+    os << resolution << ',' << GetPhaseName( phase ) << ','
+       << record.st_NumberOfCalls << ',' << record.st_WallTime << ','
+       << record.st_CPUTime << '\n';
+  }
+
+} // end WriteCSV()
+
+
+/**
+ * ****************** WriteJSON *********************************
+ */
+
+void
+RegistrationProfiler
+::WriteJSON( std::ostream & os, const unsigned int resolution ) const
+{
+  os << std::setprecision( 9 );
+  os << "{\n  \"Resolution\": " << resolution << ",\n  \"Phases\": {\n";
+  for( unsigned int i = 0; i < NumberOfPhases; ++i )
+  {
+    const PhaseType       phase  = static_cast< PhaseType >( i );
+    const PhaseRecordType record = this->GetPhaseRecord( resolution, phase );
+    os << "    \"" << GetPhaseName( phase ) << "\": { "
+       << "\"NumberOfCalls\": " << record.st_NumberOfCalls << ", "
+       << "\"WallTime\": " << record.st_WallTime << ", "
+       << "\"CPUTime\": " << record.st_CPUTime << " }"
+       << ( i + 1 < NumberOfPhases ? ",\n" : "\n" );
+  }
+  os << "  }\n}\n";
+
+} // end WriteJSON()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+RegistrationProfiler
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "CurrentResolution: " << this->m_CurrentResolution << std::endl;
+  os << indent << "NumberOfResolutions: " << this->GetNumberOfResolutions() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRegistrationProfiler_cxx
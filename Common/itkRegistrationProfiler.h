@@ -0,0 +1,294 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRegistrationProfiler_h
+#define __itkRegistrationProfiler_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <ostream>
+#include <vector>
+
+namespace itk
+{
+
+/** \class RegistrationProfiler
+ *
+ * \brief Accumulates the wall clock time, CPU time and number of calls of
+ * the phases of a registration, per resolution.
+ *
+ * The phases are:
+ * \li Sampling: updating the image sampler;
+ * \li TransformEvaluation: mapping the fixed image samples;
+ * \li Interpolation: evaluating the moving image values and gradients;
+ * \li JacobianProduct: computing the products of the transform Jacobian
+ *   and the moving image gradient, and adding them to the derivative;
+ * \li DerivativeAccumulation: combining the derivatives of the threads;
+ * \li MetricEvaluation: a complete evaluation of the cost function;
+ * \li OptimizerUpdate: the part of an iteration that is not spent in the
+ *   cost function, which is mainly the update of the optimizer;
+ * \li ParameterEstimation: the automatic estimation of the optimizer
+ *   parameters at the start of a resolution, not counting the cost function
+ *   evaluations it performs, which are recorded as MetricEvaluation.
+ *
+ * Phases that are executed by several threads at once are recorded by each
+ * thread, so that their wall clock time is the time summed over the threads.
+ * The CPU time is the CPU time of the thread that recorded the phase.
+ *
+ * Measurements are added with AddTime(), with a ScopedTimer, or with a
+ * PhaseAccumulator for per-sample loops, and are thread safe. The profile of
+ * a resolution can be written as CSV or JSON.
+ *
+ * TransformEvaluation, Interpolation and JacobianProduct are recorded by the
+ * sample loops of the AdvancedImageToImageMetric: the sample-block path
+ * (UseSampleBlocks), the per-sample loops of the Parzen window metrics
+ * (AdvancedMattesMutualInformation, NormalizedMutualInformation), and the
+ * threaded per-sample loops of AdvancedMeanSquares and
+ * AdvancedNormalizedCorrelation. Other metrics only record
+ * MetricEvaluation, and report zero for these phases. Timing every sample
+ * adds a few wall clock reads per sample while profiling is enabled.
+ *
+ * \ingroup ITKCommon
+ */
+
+class RegistrationProfiler : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef RegistrationProfiler       Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( RegistrationProfiler, Object );
+
+  /** The phases of a registration. */
+  typedef enum {
+    Sampling = 0,
+    TransformEvaluation,
+    Interpolation,
+    JacobianProduct,
+    DerivativeAccumulation,
+    MetricEvaluation,
+    OptimizerUpdate,
+    ParameterEstimation,
+    NumberOfPhases
+  } PhaseType;
+
+  /** The measurements of one phase. */
+  struct PhaseRecordType
+  {
+    SizeValueType st_NumberOfCalls;
+    double        st_WallTime;
+    double        st_CPUTime;
+  };
+  typedef std::vector< PhaseRecordType > ResolutionRecordType;
+
+  /** Get the name of a phase, as used in the written profiles. */
+  static const char * GetPhaseName( const PhaseType phase );
+
+  /** Get the current time of a monotonic wall clock, in seconds. */
+  static double GetWallClock( void );
+
+  /** Get the CPU time used so far by the calling thread, in seconds. */
+  static double GetThreadCPUClock( void );
+
+  /** Clear all resolutions. */
+  void Reset( void );
+
+  /** Make a resolution the current one, and clear its measurements. */
+  void StartResolution( const unsigned int resolution );
+
+  /** Get the current resolution. */
+  itkGetConstMacro( CurrentResolution, unsigned int );
+
+  /** Get the number of resolutions that have been started. */
+  unsigned int GetNumberOfResolutions( void ) const;
+
+  /** Add a measurement to a phase of the current resolution. Thread safe. */
+  void AddTime( const PhaseType phase, const double wallTime,
+    const double cpuTime, const SizeValueType numberOfCalls = 1 );
+
+  /** Get the measurements of a phase. */
+  PhaseRecordType GetPhaseRecord( const unsigned int resolution,
+    const PhaseType phase ) const;
+
+  /** Write the profile of a resolution: one line per phase, with the
+   * phase name, the number of calls, the wall clock time and the CPU time.
+   */
+  void WriteCSV( std::ostream & os, const unsigned int resolution ) const;
+
+  /** Write the profile of a resolution as a JSON object. */
+  void WriteJSON( std::ostream & os, const unsigned int resolution ) const;
+
+  /** \class ScopedTimer
+   * Records the time between its construction and destruction as one call
+   * of a phase. Does nothing if the profiler is NULL.
+   */
+  class ScopedTimer
+  {
+public:
+
+    ScopedTimer( Self * profiler, const PhaseType phase ) :
+      m_Profiler( profiler ), m_Phase( phase ), m_WallStart( 0.0 ), m_CPUStart( 0.0 )
+    {
+      if( this->m_Profiler )
+      {
+        this->m_WallStart = GetWallClock();
+        this->m_CPUStart  = GetThreadCPUClock();
+      }
+    }
+
+
+    ~ScopedTimer()
+    {
+      if( this->m_Profiler )
+      {
+        this->m_Profiler->AddTime( this->m_Phase,
+          GetWallClock() - this->m_WallStart,
+          GetThreadCPUClock() - this->m_CPUStart );
+      }
+    }
+
+
+private:
+
+    ScopedTimer( const ScopedTimer & ); // purposely not implemented
+    void operator=( const ScopedTimer & );  // purposely not implemented
+
+    Self *    m_Profiler;
+    PhaseType m_Phase;
+    double    m_WallStart;
+    double    m_CPUStart;
+  };
+
+  /** \class PhaseAccumulator
+   * Times the phases of a per-sample loop, executed by a single thread.
+   * Start() ends the running phase, if any, and starts the given one;
+   * Stop() ends the running phase. The times are accumulated locally, and
+   * added to the profiler once per phase at destruction, so that the
+   * profiler lock is not taken per sample. Only the wall clock is read per
+   * phase, since the thread CPU clock is too expensive to read per sample:
+   * the CPU time of the thread over the lifetime of the accumulator is
+   * distributed over the phases in proportion to their wall clock time.
+   * Does nothing if the profiler is NULL.
+   */
+  class PhaseAccumulator
+  {
+public:
+
+    PhaseAccumulator( Self * profiler ) :
+      m_Profiler( profiler ), m_CurrentPhase( NumberOfPhases ),
+      m_PhaseStart( 0.0 ), m_WallStart( 0.0 ), m_CPUStart( 0.0 )
+    {
+      for( unsigned int i = 0; i < NumberOfPhases; ++i )
+      {
+        this->m_WallTimes[ i ]     = 0.0;
+        this->m_NumberOfCalls[ i ] = 0;
+      }
+      if( this->m_Profiler )
+      {
+        this->m_WallStart = GetWallClock();
+        this->m_CPUStart  = GetThreadCPUClock();
+      }
+    }
+
+
+    ~PhaseAccumulator()
+    {
+      if( !this->m_Profiler ) { return; }
+      this->Stop();
+
+      const double wallTime = GetWallClock() - this->m_WallStart;
+      const double cpuTime  = GetThreadCPUClock() - this->m_CPUStart;
+      for( unsigned int i = 0; i < NumberOfPhases; ++i )
+      {
+        if( this->m_NumberOfCalls[ i ] == 0 ) { continue; }
+        const double cpuShare = wallTime > 0.0
+          ? cpuTime * this->m_WallTimes[ i ] / wallTime : 0.0;
+        this->m_Profiler->AddTime( static_cast< PhaseType >( i ),
+          this->m_WallTimes[ i ], cpuShare, this->m_NumberOfCalls[ i ] );
+      }
+    }
+
+
+    void Start( const PhaseType phase )
+    {
+      if( !this->m_Profiler ) { return; }
+      const double now = GetWallClock();
+      if( this->m_CurrentPhase != NumberOfPhases )
+      {
+        this->m_WallTimes[ this->m_CurrentPhase ] += now - this->m_PhaseStart;
+      }
+      this->m_CurrentPhase = phase;
+      this->m_PhaseStart   = now;
+      ++this->m_NumberOfCalls[ phase ];
+    }
+
+
+    void Stop( void )
+    {
+      if( !this->m_Profiler || this->m_CurrentPhase == NumberOfPhases ) { return; }
+      this->m_WallTimes[ this->m_CurrentPhase ] += GetWallClock() - this->m_PhaseStart;
+      this->m_CurrentPhase = NumberOfPhases;
+    }
+
+
+private:
+
+    PhaseAccumulator( const PhaseAccumulator & ); // purposely not implemented
+    void operator=( const PhaseAccumulator & );   // purposely not implemented
+
+    Self *        m_Profiler;
+    PhaseType     m_CurrentPhase;
+    double        m_PhaseStart;
+    double        m_WallStart;
+    double        m_CPUStart;
+    double        m_WallTimes[ NumberOfPhases ];
+    SizeValueType m_NumberOfCalls[ NumberOfPhases ];
+  };
+
+protected:
+
+  RegistrationProfiler();
+  virtual ~RegistrationProfiler() {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  RegistrationProfiler( const Self & ); // purposely not implemented
+  void operator=( const Self & );       // purposely not implemented
+
+  std::vector< ResolutionRecordType > m_Resolutions;
+  unsigned int                        m_CurrentResolution;
+  mutable SimpleFastMutexLock         m_Mutex;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRegistrationProfiler_h
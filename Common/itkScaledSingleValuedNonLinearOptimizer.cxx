@@ -95,6 +95,20 @@ ScaledSingleValuedNonLinearOptimizer
 } // end GetUseScales()
 
 
+/**
+ * ********************* SetProfiler ******************************
+ */
+
+void
+ScaledSingleValuedNonLinearOptimizer
+::SetProfiler( RegistrationProfiler * profiler )
+{
+  this->m_ScaledCostFunction->SetProfiler( profiler );
+  this->Modified();
+
+} // end SetProfiler()
+
+
 /**
  * ********************* GetScaledValue *****************************
  */
@@ -106,6 +106,11 @@ public:
 
   bool GetUseScales( void ) const;
 
+  /** Setting: the profiler that records the time spent in the cost function.
+   * Passed on to the scaled cost function. NULL disables profiling.
+   */
+  virtual void SetProfiler( RegistrationProfiler * profiler );
+
   /** Get the current scaled position. */
   itkGetConstReferenceMacro( ScaledCurrentPosition, ParametersType );
 
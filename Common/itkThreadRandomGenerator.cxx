@@ -0,0 +1,73 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkThreadRandomGenerator.h"
+
+/** Thread local storage of a pointer. */
+#if defined( _MSC_VER )
+#define itkThreadRandomGeneratorThreadLocal __declspec( thread )
+#else
+#define itkThreadRandomGeneratorThreadLocal __thread
+#endif
+
+namespace itk
+{
+
+static itkThreadRandomGeneratorThreadLocal ThreadRandomGenerator::GeneratorType *
+  thread_generator = NULL;
+
+/**
+ * ******************* GetInstance *******************
+ */
+
+ThreadRandomGenerator::GeneratorPointer
+ThreadRandomGenerator::GetInstance( void )
+{
+  if( thread_generator )
+  {
+    return thread_generator;
+  }
+  return GeneratorType::GetInstance();
+
+} // end GetInstance()
+
+
+/**
+ * ******************* SetThreadGenerator *******************
+ */
+
+void
+ThreadRandomGenerator::SetThreadGenerator( GeneratorType * generator )
+{
+  thread_generator = generator;
+
+} // end SetThreadGenerator()
+
+
+/**
+ * ******************* GetThreadGenerator *******************
+ */
+
+ThreadRandomGenerator::GeneratorType *
+ThreadRandomGenerator::GetThreadGenerator( void )
+{
+  return thread_generator;
+
+} // end GetThreadGenerator()
+
+
+} // end namespace itk
@@ -0,0 +1,116 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkThreadRandomGenerator_h
+#define __itkThreadRandomGenerator_h
+
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+namespace itk
+{
+
+/** \class ThreadRandomGenerator
+ *
+ * \brief Gives each registration session its own random number stream.
+ *
+ * The samplers, the stochastic optimizers and some metrics draw their random
+ * numbers from a MersenneTwisterRandomVariateGenerator. Using the process
+ * wide MersenneTwisterRandomVariateGenerator::GetInstance() for this means
+ * that two registrations running in parallel threads draw from one stream:
+ * the results of both then depend on the interleaving of the threads, and
+ * the generator is accessed concurrently.
+ *
+ * GetInstance() returns the generator that is set for the calling thread
+ * with SetThreadGenerator(), or else the process wide instance, so that
+ * single registrations behave as before. ElastixMain::Run() installs a
+ * generator of its own for the duration of the run, which is seeded with the
+ * RandomSeed parameter. Threads that are started by the registration use
+ * the process wide instance, unless the generator is passed on explicitly
+ * with a Scope, as the CombinationImageToImageMetric does for its
+ * concurrently evaluated sub metrics. Components that keep the generator
+ * as a member take it from GetInstance() at construction.
+ *
+ * \ingroup ITKCommon
+ */
+
+class ThreadRandomGenerator
+{
+public:
+
+  typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  typedef GeneratorType::Pointer                            GeneratorPointer;
+
+  /** Get the generator of the calling thread: the one set with
+   * SetThreadGenerator(), or else the process wide instance.
+   */
+  static GeneratorPointer GetInstance( void );
+
+  /** Set the generator of the calling thread. Set to NULL to use the
+   * process wide instance again. The caller keeps the generator alive.
+   */
+  static void SetThreadGenerator( GeneratorType * generator );
+
+  /** Get the generator of the calling thread; NULL if none has been set. */
+  static GeneratorType * GetThreadGenerator( void );
+
+  /** \class Scope
+   * Sets the generator of the calling thread for its lifetime, and restores
+   * the previous one at destruction. Does nothing if the generator is NULL.
+   */
+  class Scope
+  {
+public:
+
+    Scope( GeneratorType * generator ) :
+      m_Previous( GetThreadGenerator() ), m_Installed( generator != NULL )
+    {
+      if( this->m_Installed )
+      {
+        SetThreadGenerator( generator );
+      }
+    }
+
+
+    ~Scope()
+    {
+      if( this->m_Installed )
+      {
+        SetThreadGenerator( this->m_Previous );
+      }
+    }
+
+
+private:
+
+    Scope( const Scope & );         // purposely not implemented
+    void operator=( const Scope & ); // purposely not implemented
+
+    GeneratorType * m_Previous;
+    bool            m_Installed;
+  };
+
+private:
+
+  ThreadRandomGenerator();                                // purposely not implemented
+  ThreadRandomGenerator( const ThreadRandomGenerator & ); // purposely not implemented
+  void operator=( const ThreadRandomGenerator & );        // purposely not implemented
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkThreadRandomGenerator_h
@@ -0,0 +1,404 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkTransformixBinaryPointFile_cxx
+#define __itkTransformixBinaryPointFile_cxx
+
+#include "itkTransformixBinaryPointFile.h"
+#include "itkByteSwapper.h"
+#include "itkNumericTraits.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+
+/** The magic string that starts every binary point file. */
+static const char g_TransformixBinaryPointFileMagic[ 9 ] = "ELXPOINT";
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+TransformixBinaryPointFile
+::TransformixBinaryPointFile()
+{
+  this->m_Dimension        = 0;
+  this->m_PointsAreIndices = false;
+  this->m_ComponentSize    = 0;
+  this->m_NumberOfPoints   = 0;
+
+  this->m_Data          = NULL;
+  this->m_FileSize      = 0;
+  this->m_FileHandle    = NULL;
+  this->m_MappingHandle = NULL;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+TransformixBinaryPointFile
+::~TransformixBinaryPointFile()
+{
+  this->UnmapFile();
+
+} // end Destructor
+
+
+/**
+ * ****************** IsBinaryPointFile *********************************
+ */
+
+bool
+TransformixBinaryPointFile
+::IsBinaryPointFile( const std::string & fileName )
+{
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  if( !file.is_open() ) { return false; }
+
+  char magic[ 8 ];
+  file.read( magic, 8 );
+  if( file.gcount() != 8 ) { return false; }
+
+  return std::memcmp( magic, g_TransformixBinaryPointFileMagic, 8 ) == 0;
+
+} // end IsBinaryPointFile()
+
+
+/**
+ * ****************** Open *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::Open( const std::string & fileName )
+{
+  this->UnmapFile();
+  this->MapFile( fileName );
+
+  /** Check the magic string. */
+  if( this->m_FileSize < HeaderSize
+    || std::memcmp( this->m_Data, g_TransformixBinaryPointFileMagic, 8 ) != 0 )
+  {
+    this->UnmapFile();
+    itkExceptionMacro( << "The file \"" << fileName
+                       << "\" is not a binary transformix point file." );
+  }
+
+  /** Read the header fields, which are stored little endian. */
+  uint32_t fields[ 4 ];
+  uint64_t numberOfPoints;
+  std::memcpy( fields, this->m_Data + 8, 4 * sizeof( uint32_t ) );
+  std::memcpy( &numberOfPoints, this->m_Data + 24, sizeof( uint64_t ) );
+  ByteSwapper< uint32_t >::SwapRangeFromSystemToLittleEndian( fields, 4 );
+  ByteSwapper< uint64_t >::SwapFromSystemToLittleEndian( &numberOfPoints );
+
+  const uint32_t version = fields[ 0 ];
+  this->m_Dimension        = fields[ 1 ];
+  this->m_PointsAreIndices = fields[ 2 ] != 0;
+  this->m_ComponentSize    = fields[ 3 ];
+  this->m_NumberOfPoints   = static_cast< SizeValueType >( numberOfPoints );
+
+  /** Check the header. The dimension and component size are checked before
+   * the size of a point is computed, and that size is computed in 64 bits,
+   * so that a corrupt header can neither overflow it nor make it zero.
+   */
+  std::string error = "";
+  if( version != 1 )
+  {
+    error = "Unsupported version of the binary point format.";
+  }
+  else if( this->m_ComponentSize != 4 && this->m_ComponentSize != 8 )
+  {
+    error = "The coordinate size should be 4 (float) or 8 (double).";
+  }
+  else if( this->m_Dimension == 0 || this->m_Dimension > MaximumDimension )
+  {
+    std::ostringstream message;
+    message << "The dimension of the points should be between 1 and "
+            << MaximumDimension << ", but is " << this->m_Dimension << ".";
+    error = message.str();
+  }
+  else if( numberOfPoints > static_cast< uint64_t >(
+    NumericTraits< SizeValueType >::max() ) )
+  {
+    error = "The number of points is too large for this platform.";
+  }
+  else
+  {
+    const uint64_t pointSize = static_cast< uint64_t >( this->m_Dimension )
+      * static_cast< uint64_t >( this->m_ComponentSize );
+    const uint64_t dataSize = static_cast< uint64_t >( this->m_FileSize - HeaderSize );
+    if( dataSize / pointSize < numberOfPoints )
+    {
+      error = "The file is not large enough.";
+    }
+  }
+  if( error != "" )
+  {
+    this->UnmapFile();
+    itkExceptionMacro( << error << "\nFilename: " << fileName );
+  }
+
+} // end Open()
+
+
+/**
+ * ****************** Close *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::Close( void )
+{
+  this->UnmapFile();
+
+} // end Close()
+
+
+/**
+ * ****************** ReadPoints *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::ReadPoints( SizeValueType first, SizeValueType count, double * buffer ) const
+{
+  if( this->m_Data == NULL )
+  {
+    itkExceptionMacro( << "No binary point file has been opened." );
+  }
+  if( first > this->m_NumberOfPoints || count > this->m_NumberOfPoints - first )
+  {
+    itkExceptionMacro( << "Requested points [" << first << ", " << first + count
+                       << ") are outside the file, which contains "
+                       << this->m_NumberOfPoints << " points." );
+  }
+
+  const std::size_t     numberOfValues = count * this->m_Dimension;
+  const unsigned char * source         = this->m_Data + HeaderSize
+    + static_cast< std::size_t >( first ) * this->m_Dimension * this->m_ComponentSize;
+
+  /** Copy, swap if needed, and convert to double. */
+  if( this->m_ComponentSize == 8 )
+  {
+    std::memcpy( buffer, source, numberOfValues * sizeof( double ) );
+    ByteSwapper< double >::SwapRangeFromSystemToLittleEndian( buffer, numberOfValues );
+  }
+  else
+  {
+    float value;
+    for( std::size_t i = 0; i < numberOfValues; ++i )
+    {
+      std::memcpy( &value, source + i * sizeof( float ), sizeof( float ) );
+      ByteSwapper< float >::SwapFromSystemToLittleEndian( &value );
+      buffer[ i ] = static_cast< double >( value );
+    }
+  }
+
+} // end ReadPoints()
+
+
+/**
+ * ****************** WriteHeader *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::WriteHeader( std::ostream & os, unsigned int dimension,
+  bool pointsAreIndices, unsigned int componentSize,
+  SizeValueType numberOfPoints )
+{
+  uint32_t fields[ 4 ];
+  fields[ 0 ] = 1;
+  fields[ 1 ] = dimension;
+  fields[ 2 ] = pointsAreIndices ? 1 : 0;
+  fields[ 3 ] = componentSize;
+  uint64_t nrOfPoints = numberOfPoints;
+  ByteSwapper< uint32_t >::SwapRangeFromSystemToLittleEndian( fields, 4 );
+  ByteSwapper< uint64_t >::SwapFromSystemToLittleEndian( &nrOfPoints );
+
+  os.write( g_TransformixBinaryPointFileMagic, 8 );
+  os.write( reinterpret_cast< const char * >( fields ), 4 * sizeof( uint32_t ) );
+  os.write( reinterpret_cast< const char * >( &nrOfPoints ), sizeof( uint64_t ) );
+
+} // end WriteHeader()
+
+
+/**
+ * ****************** WritePoints *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::WritePoints( std::ostream & os, const double * buffer,
+  SizeValueType numberOfValues, unsigned int componentSize )
+{
+  if( numberOfValues == 0 ) { return; }
+
+  if( componentSize == 8 )
+  {
+    std::vector< double > values( buffer, buffer + numberOfValues );
+    ByteSwapper< double >::SwapRangeFromSystemToLittleEndian(
+      &values[ 0 ], numberOfValues );
+    os.write( reinterpret_cast< const char * >( &values[ 0 ] ),
+      numberOfValues * sizeof( double ) );
+  }
+  else
+  {
+    std::vector< float > values( buffer, buffer + numberOfValues );
+    ByteSwapper< float >::SwapRangeFromSystemToLittleEndian(
+      &values[ 0 ], numberOfValues );
+    os.write( reinterpret_cast< const char * >( &values[ 0 ] ),
+      numberOfValues * sizeof( float ) );
+  }
+
+} // end WritePoints()
+
+
+/**
+ * ****************** MapFile *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::MapFile( const std::string & fileName )
+{
+  this->m_FileName = fileName;
+
+#if defined( _WIN32 )
+  HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+  if( file == INVALID_HANDLE_VALUE )
+  {
+    itkExceptionMacro( << "Could not open the file \"" << fileName << "\"." );
+  }
+  LARGE_INTEGER size;
+  if( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+  {
+    CloseHandle( file );
+    itkExceptionMacro( << "Could not determine the size of \"" << fileName << "\"." );
+  }
+  HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+  if( mapping == NULL )
+  {
+    CloseHandle( file );
+    itkExceptionMacro( << "Could not map the file \"" << fileName << "\"." );
+  }
+  const void * data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+  if( data == NULL )
+  {
+    CloseHandle( mapping );
+    CloseHandle( file );
+    itkExceptionMacro( << "Could not map the file \"" << fileName << "\"." );
+  }
+  this->m_FileHandle    = file;
+  this->m_MappingHandle = mapping;
+  this->m_FileSize      = static_cast< std::size_t >( size.QuadPart );
+  this->m_Data          = static_cast< const unsigned char * >( data );
+#else
+  const int file = open( fileName.c_str(), O_RDONLY );
+  if( file < 0 )
+  {
+    itkExceptionMacro( << "Could not open the file \"" << fileName << "\"." );
+  }
+  struct stat fileInfo;
+  if( fstat( file, &fileInfo ) != 0 || fileInfo.st_size == 0 )
+  {
+    close( file );
+    itkExceptionMacro( << "Could not determine the size of \"" << fileName << "\"." );
+  }
+  void * data = mmap( NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+
+  /** The mapping stays valid after closing the file descriptor. */
+  close( file );
+  if( data == MAP_FAILED )
+  {
+    itkExceptionMacro( << "Could not map the file \"" << fileName << "\"." );
+  }
+  madvise( data, fileInfo.st_size, MADV_SEQUENTIAL );
+  this->m_FileSize = static_cast< std::size_t >( fileInfo.st_size );
+  this->m_Data     = static_cast< const unsigned char * >( data );
+#endif
+
+} // end MapFile()
+
+
+/**
+ * ****************** UnmapFile *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::UnmapFile( void )
+{
+  if( this->m_Data == NULL ) { return; }
+
+#if defined( _WIN32 )
+  UnmapViewOfFile( this->m_Data );
+  CloseHandle( static_cast< HANDLE >( this->m_MappingHandle ) );
+  CloseHandle( static_cast< HANDLE >( this->m_FileHandle ) );
+#else
+  munmap( const_cast< unsigned char * >( this->m_Data ), this->m_FileSize );
+#endif
+
+  this->m_Data          = NULL;
+  this->m_FileSize      = 0;
+  this->m_FileHandle    = NULL;
+  this->m_MappingHandle = NULL;
+
+} // end UnmapFile()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+TransformixBinaryPointFile
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+  os << indent << "Dimension: " << this->m_Dimension << std::endl;
+  os << indent << "PointsAreIndices: " << this->m_PointsAreIndices << std::endl;
+  os << indent << "ComponentSize: " << this->m_ComponentSize << std::endl;
+  os << indent << "NumberOfPoints: " << this->m_NumberOfPoints << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkTransformixBinaryPointFile_cxx
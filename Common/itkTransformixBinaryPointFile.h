@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTransformixBinaryPointFile_h
+#define __itkTransformixBinaryPointFile_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+
+#include <string>
+#include <ostream>
+
+namespace itk
+{
+
+/** \class TransformixBinaryPointFile
+ *
+ * \brief A memory-mapped reader of the binary transformix point format.
+ *
+ * The text input point format needs to be parsed completely, and copied
+ * into a point set, before a single point can be transformed. For meshes
+ * with millions of vertices, this makes parsing the bottleneck, and the
+ * memory use proportional to the number of points.
+ *
+ * The binary format consists of a 32 byte header, followed by the point
+ * coordinates, stored contiguously, point after point, in little endian
+ * byte order:
+ * \li 8 bytes: the magic string "ELXPOINT";
+ * \li 4 bytes (uint32): the version of the format, currently 1;
+ * \li 4 bytes (uint32): the dimension of the points;
+ * \li 4 bytes (uint32): 1 if the points are image indices, 0 if the points
+ *   are given in world coordinates;
+ * \li 4 bytes (uint32): the size of one coordinate in bytes: 4 (float) or
+ *   8 (double);
+ * \li 8 bytes (uint64): the number of points.
+ *
+ * Open() rejects a header with another version or component size, a
+ * dimension of 0 or above MaximumDimension, or more points than the file
+ * holds.
+ *
+ * Open() maps the file in memory, so that ReadPoints() can copy any range of
+ * points without reading the rest of the file. The operating system pages
+ * the file in and out on demand, which allows chunked processing of point
+ * sets that do not fit in memory.
+ *
+ * WriteHeader() and WritePoints() write the same format, for example for
+ * the transformed points.
+ *
+ * \ingroup ITKCommon
+ */
+
+class TransformixBinaryPointFile : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef TransformixBinaryPointFile Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TransformixBinaryPointFile, Object );
+
+  /** The size of the header in bytes. */
+  itkStaticConstMacro( HeaderSize, unsigned int, 32 );
+
+  /** The largest dimension that Open() accepts. It is well above the
+   * dimensions elastix supports, and only serves to reject corrupt headers.
+   */
+  itkStaticConstMacro( MaximumDimension, unsigned int, 16 );
+
+  /** Check if a file starts with the magic string of the binary format. */
+  static bool IsBinaryPointFile( const std::string & fileName );
+
+  /** Map the file in memory, and read the header.
+   * Throws an exception if the file can not be opened or is invalid.
+   */
+  void Open( const std::string & fileName );
+
+  /** Unmap the file. Is also done by the destructor. */
+  void Close( void );
+
+  /** Get information from the header. */
+  itkGetConstMacro( Dimension, unsigned int );
+  itkGetConstMacro( PointsAreIndices, bool );
+  itkGetConstMacro( ComponentSize, unsigned int );
+  itkGetConstMacro( NumberOfPoints, SizeValueType );
+
+  /** Copy the coordinates of the points [first, first + count) into the
+   * buffer, which should have room for count * Dimension values.
+   */
+  void ReadPoints( SizeValueType first, SizeValueType count,
+    double * buffer ) const;
+
+  /** Write a header of the binary format to a stream, opened in binary mode. */
+  static void WriteHeader( std::ostream & os, unsigned int dimension,
+    bool pointsAreIndices, unsigned int componentSize,
+    SizeValueType numberOfPoints );
+
+  /** Write numberOfValues coordinates to a stream, as float or double,
+   * depending on the componentSize.
+   */
+  static void WritePoints( std::ostream & os, const double * buffer,
+    SizeValueType numberOfValues, unsigned int componentSize );
+
+protected:
+
+  TransformixBinaryPointFile();
+  virtual ~TransformixBinaryPointFile();
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  TransformixBinaryPointFile( const Self & ); // purposely not implemented
+  void operator=( const Self & );            // purposely not implemented
+
+  /** Map and unmap the file; platform specific. */
+  void MapFile( const std::string & fileName );
+
+  void UnmapFile( void );
+
+  /** Header information. */
+  unsigned int  m_Dimension;
+  bool          m_PointsAreIndices;
+  unsigned int  m_ComponentSize;
+  SizeValueType m_NumberOfPoints;
+
+  /** The mapped file. */
+  std::string           m_FileName;
+  const unsigned char * m_Data;
+  std::size_t           m_FileSize;
+  void *                m_FileHandle;
+  void *                m_MappingHandle;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkTransformixBinaryPointFile_h
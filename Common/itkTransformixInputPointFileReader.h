@@ -20,6 +20,7 @@
 #define __itkTransformixInputPointFileReader_h
 
 #include "itkMeshFileReaderBase.h"
+#include "itkTransformixBinaryPointFile.h"
 
 #include <fstream>
 
@@ -40,6 +41,9 @@ namespace itk
  *
  * The second word in the text file represents the number of points that
  * should be read.
+ *
+ * Files in the binary point format (see TransformixBinaryPointFile) are
+ * recognized by their magic string, and are read through a memory map.
  **/
 
 template< class TOutputMesh >
@@ -82,6 +86,9 @@ public:
    */
   itkGetConstMacro( NumberOfPoints, unsigned long );
 
+  /** Get whether the file is in the binary point format. */
+  itkGetConstMacro( IsBinary, bool );
+
   /** Prepare the allocation of the output mesh during the first back
    * propagation of the pipeline. Updates the PointsAreIndices and NumberOfPoints.
    */
@@ -97,8 +104,10 @@ protected:
 
   unsigned long m_NumberOfPoints;
   bool          m_PointsAreIndices;
+  bool          m_IsBinary;
 
-  std::ifstream m_Reader;
+  std::ifstream                       m_Reader;
+  TransformixBinaryPointFile::Pointer m_BinaryFile;
 
 private:
 
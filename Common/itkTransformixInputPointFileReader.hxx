@@ -21,6 +21,9 @@
 
 #include "itkTransformixInputPointFileReader.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace itk
 {
 
@@ -34,6 +37,8 @@ TransformixInputPointFileReader< TOutputMesh >
 {
   this->m_NumberOfPoints   = 0;
   this->m_PointsAreIndices = false;
+  this->m_IsBinary         = false;
+  this->m_BinaryFile       = TransformixBinaryPointFile::New();
 } // end constructor
 
 
@@ -69,6 +74,29 @@ TransformixInputPointFileReader< TOutputMesh >
   {
     this->m_Reader.close();
   }
+
+  /** Binary point files carry the information in their header. */
+  this->m_IsBinary = TransformixBinaryPointFile::IsBinaryPointFile( this->m_FileName );
+  if( this->m_IsBinary )
+  {
+    this->m_BinaryFile->Open( this->m_FileName );
+    if( this->m_BinaryFile->GetDimension() != OutputMeshType::PointDimension )
+    {
+      std::ostringstream msg;
+      msg << "The dimension of the points in the file ("
+          << this->m_BinaryFile->GetDimension()
+          << ") does not match the image dimension. "
+          << std::endl << "Filename: " << this->m_FileName
+          << std::endl;
+      this->m_BinaryFile->Close();
+      MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+      throw e;
+    }
+    this->m_PointsAreIndices = this->m_BinaryFile->GetPointsAreIndices();
+    this->m_NumberOfPoints   = this->m_BinaryFile->GetNumberOfPoints();
+    return;
+  }
+
   this->m_Reader.open( this->m_FileName.c_str() );
 
   /** Read the first entry */
@@ -118,7 +146,29 @@ TransformixInputPointFileReader< TOutputMesh >
   PointsContainerPointer points = PointsContainerType::New();
 
   /** Read the file */
-  if( this->m_Reader.is_open() )
+  if( this->m_IsBinary )
+  {
+    /** Copy the points from the memory mapped file, in chunks. */
+    const unsigned long chunkSize = 65536;
+    std::vector< double > buffer( chunkSize * dimension );
+    points->Reserve( this->m_NumberOfPoints );
+    for( unsigned long first = 0; first < this->m_NumberOfPoints; first += chunkSize )
+    {
+      const unsigned long count = std::min( chunkSize, this->m_NumberOfPoints - first );
+      this->m_BinaryFile->ReadPoints( first, count, &buffer[ 0 ] );
+      for( unsigned long i = 0; i < count; ++i )
+      {
+        PointType point;
+        for( unsigned int j = 0; j < dimension; j++ )
+        {
+          point[ j ] = buffer[ i * dimension + j ];
+        }
+        points->SetElement( first + i, point );
+      }
+    }
+    this->m_BinaryFile->Close();
+  }
+  else if( this->m_Reader.is_open() )
   {
     for( unsigned int i = 0; i < this->m_NumberOfPoints; ++i )
     {
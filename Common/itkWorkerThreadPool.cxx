@@ -0,0 +1,401 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkWorkerThreadPool_cxx
+#define __itkWorkerThreadPool_cxx
+
+#include "itkWorkerThreadPool.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkMutexLockHolder.h"
+
+#include <exception>
+
+namespace itk
+{
+
+/** The process-wide instance and the lock guarding its creation. */
+static WorkerThreadPool::Pointer g_WorkerThreadPoolInstance;
+static SimpleFastMutexLock       g_WorkerThreadPoolInstanceLock;
+
+/**
+ * ****************** GetInstance *********************************
+ */
+
+WorkerThreadPool::Pointer
+WorkerThreadPool
+::GetInstance( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > holder( g_WorkerThreadPoolInstanceLock );
+  if( g_WorkerThreadPoolInstance.IsNull() )
+  {
+    g_WorkerThreadPoolInstance = new WorkerThreadPool;
+    g_WorkerThreadPoolInstance->UnRegister();
+  }
+  return g_WorkerThreadPoolInstance;
+
+} // end GetInstance()
+
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+WorkerThreadPool
+::WorkerThreadPool()
+{
+  this->m_SpawnThreader          = MultiThreader::New();
+  this->m_NumberOfWorkerThreads  = 0;
+  this->m_WorkAvailableCondition = ConditionVariable::New();
+  this->m_WorkDoneCondition      = ConditionVariable::New();
+  this->m_Busy                   = false;
+  this->m_Shutdown               = false;
+
+  this->m_Generation          = 0;
+  this->m_Callback            = NULL;
+  this->m_UserData            = NULL;
+  this->m_NumberOfJobThreads  = 0;
+  this->m_NumberOfPendingJobs = 0;
+  this->m_ExceptionOccurred   = false;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+WorkerThreadPool
+::~WorkerThreadPool()
+{
+  /** Wake up all workers and let them leave their loop. */
+  this->m_Mutex.Lock();
+  this->m_Shutdown = true;
+  this->m_WorkAvailableCondition->Broadcast();
+  this->m_Mutex.Unlock();
+
+  /** Join them. */
+  for( ThreadIdType i = 0; i < this->m_NumberOfWorkerThreads; ++i )
+  {
+    this->m_SpawnThreader->TerminateThread( this->m_SpawnedThreadIDs[ i ] );
+  }
+
+} // end Destructor
+
+
+/**
+ * ****************** GetNumberOfWorkerThreads *********************************
+ */
+
+ThreadIdType
+WorkerThreadPool
+::GetNumberOfWorkerThreads( void ) const
+{
+  this->m_Mutex.Lock();
+  const ThreadIdType numberOfWorkers = this->m_NumberOfWorkerThreads;
+  this->m_Mutex.Unlock();
+  return numberOfWorkers;
+
+} // end GetNumberOfWorkerThreads()
+
+
+/**
+ * ****************** Execute *********************************
+ */
+
+void
+WorkerThreadPool
+::Execute( ThreadFunctionType callback, void * userData,
+  ThreadIdType numberOfThreads )
+{
+  if( numberOfThreads > ITK_MAX_THREADS ) { numberOfThreads = ITK_MAX_THREADS; }
+  if( numberOfThreads <= 1 )
+  {
+    this->ExecuteSerial( callback, userData, 1 );
+    return;
+  }
+
+  /** Claim the workers. If they are claimed already, we are either nested
+   * inside a running job, or another thread is using the pool. In both cases
+   * waiting for the workers is not an option, so the caller gets fresh
+   * threads, just like it would without the pool.
+   */
+  this->m_Mutex.Lock();
+  if( this->m_Busy || this->m_Shutdown )
+  {
+    this->m_Mutex.Unlock();
+    this->ExecuteWithMultiThreader( callback, userData, numberOfThreads );
+    return;
+  }
+  this->m_Busy = true;
+
+  /** Make sure there are enough workers, and post the job. */
+  this->SpawnWorkerThreads( numberOfThreads - 1 );
+  this->m_Callback             = callback;
+  this->m_UserData             = userData;
+  this->m_NumberOfJobThreads   = numberOfThreads;
+  this->m_NumberOfPendingJobs  = numberOfThreads - 1;
+  this->m_ExceptionOccurred    = false;
+  this->m_ExceptionDescription = "";
+  ++this->m_Generation;
+  this->m_WorkAvailableCondition->Broadcast();
+  this->m_Mutex.Unlock();
+
+  /** Thread 0 is executed by the calling thread. */
+  ThreadInfoType threadInfo;
+  threadInfo.ThreadID        = 0;
+  threadInfo.NumberOfThreads = numberOfThreads;
+  threadInfo.UserData        = userData;
+  threadInfo.ActiveFlag      = NULL;
+
+  bool           callerFailed = false;
+  ExceptionObject callerException;
+  try
+  {
+    callback( &threadInfo );
+  }
+  catch( ExceptionObject & e )
+  {
+    callerFailed    = true;
+    callerException = e;
+  }
+  catch( std::exception & e )
+  {
+    callerFailed = true;
+    callerException.SetDescription( e.what() );
+  }
+  catch( ... )
+  {
+    callerFailed = true;
+    callerException.SetDescription( "Unknown exception in thread 0." );
+  }
+
+  /** Wait for the workers and release the pool. */
+  this->m_Mutex.Lock();
+  while( this->m_NumberOfPendingJobs > 0 )
+  {
+    this->m_WorkDoneCondition->Wait( &this->m_Mutex );
+  }
+  const bool        workerFailed      = this->m_ExceptionOccurred;
+  const std::string workerDescription = this->m_ExceptionDescription;
+  this->m_Busy = false;
+  this->m_Mutex.Unlock();
+
+  /** Report exceptions only after all threads are done with the user data. */
+  if( callerFailed )
+  {
+    throw callerException;
+  }
+  if( workerFailed )
+  {
+    itkExceptionMacro( << "Exception occurred in a worker thread:\n"
+                       << workerDescription );
+  }
+
+} // end Execute()
+
+
+/**
+ * ****************** ExecuteSerial *********************************
+ */
+
+void
+WorkerThreadPool
+::ExecuteSerial( ThreadFunctionType callback, void * userData,
+  ThreadIdType numberOfThreads ) const
+{
+  ThreadInfoType threadInfo;
+  threadInfo.NumberOfThreads = numberOfThreads;
+  threadInfo.UserData        = userData;
+  threadInfo.ActiveFlag      = NULL;
+
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    threadInfo.ThreadID = i;
+    callback( &threadInfo );
+  }
+
+} // end ExecuteSerial()
+
+
+/**
+ * ****************** ExecuteWithMultiThreader *********************************
+ */
+
+void
+WorkerThreadPool
+::ExecuteWithMultiThreader( ThreadFunctionType callback, void * userData,
+  ThreadIdType numberOfThreads ) const
+{
+  /** A local threader, so that concurrent callers do not share state.
+   * The ITK pool is not used, see the class documentation.
+   */
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetUseThreadPool( false );
+  threader->SetNumberOfThreads( numberOfThreads );
+
+  /** The MultiThreader clamps the number of threads to its global maximum.
+   * Many callbacks partition their work using their own number of threads,
+   * so every thread id must be executed: run them serially in that case.
+   */
+  if( threader->GetNumberOfThreads() != numberOfThreads )
+  {
+    this->ExecuteSerial( callback, userData, numberOfThreads );
+    return;
+  }
+
+  threader->SetSingleMethod( callback, userData );
+  threader->SingleMethodExecute();
+
+} // end ExecuteWithMultiThreader()
+
+
+/**
+ * ****************** SpawnWorkerThreads *********************************
+ */
+
+void
+WorkerThreadPool
+::SpawnWorkerThreads( ThreadIdType numberOfWorkers )
+{
+  while( this->m_NumberOfWorkerThreads < numberOfWorkers )
+  {
+    /** Worker i executes thread id i + 1. The current generation is passed
+     * at creation, so that a worker that starts late still sees the job
+     * that is about to be posted.
+     */
+    const ThreadIdType i = this->m_NumberOfWorkerThreads;
+    this->m_WorkerInfo[ i ].st_Pool       = this;
+    this->m_WorkerInfo[ i ].st_WorkerID   = i + 1;
+    this->m_WorkerInfo[ i ].st_Generation = this->m_Generation;
+
+    this->m_SpawnedThreadIDs[ i ] = this->m_SpawnThreader->SpawnThread(
+      WorkerThreadCallback, &this->m_WorkerInfo[ i ] );
+    ++this->m_NumberOfWorkerThreads;
+  }
+
+} // end SpawnWorkerThreads()
+
+
+/**
+ * ****************** WorkerThreadCallback *********************************
+ */
+
+ITK_THREAD_RETURN_TYPE
+WorkerThreadPool
+::WorkerThreadCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  WorkerInfoType * workerInfo = static_cast< WorkerInfoType * >( infoStruct->UserData );
+
+  workerInfo->st_Pool->WorkerLoop( workerInfo->st_WorkerID, workerInfo->st_Generation );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end WorkerThreadCallback()
+
+
+/**
+ * ****************** WorkerLoop *********************************
+ */
+
+void
+WorkerThreadPool
+::WorkerLoop( ThreadIdType workerID, SizeValueType generation )
+{
+  this->m_Mutex.Lock();
+  while( true )
+  {
+    /** Sleep until a new job is posted, or the pool is destroyed. */
+    while( !this->m_Shutdown && this->m_Generation == generation )
+    {
+      this->m_WorkAvailableCondition->Wait( &this->m_Mutex );
+    }
+    if( this->m_Shutdown ) { break; }
+    generation = this->m_Generation;
+
+    /** Workers with a too high id skip this job. */
+    if( workerID >= this->m_NumberOfJobThreads ) { continue; }
+
+    ThreadInfoType threadInfo;
+    threadInfo.ThreadID        = workerID;
+    threadInfo.NumberOfThreads = this->m_NumberOfJobThreads;
+    threadInfo.UserData        = this->m_UserData;
+    threadInfo.ActiveFlag      = NULL;
+    ThreadFunctionType callback = this->m_Callback;
+    this->m_Mutex.Unlock();
+
+    /** Do the work without holding the lock. */
+    bool        failed = false;
+    std::string description;
+    try
+    {
+      callback( &threadInfo );
+    }
+    catch( ExceptionObject & e )
+    {
+      failed      = true;
+      description = e.GetDescription();
+    }
+    catch( std::exception & e )
+    {
+      failed      = true;
+      description = e.what();
+    }
+    catch( ... )
+    {
+      failed      = true;
+      description = "Unknown exception.";
+    }
+
+    /** Report back. */
+    this->m_Mutex.Lock();
+    if( failed && !this->m_ExceptionOccurred )
+    {
+      this->m_ExceptionOccurred    = true;
+      this->m_ExceptionDescription = description;
+    }
+    --this->m_NumberOfPendingJobs;
+    if( this->m_NumberOfPendingJobs == 0 )
+    {
+      this->m_WorkDoneCondition->Signal();
+    }
+  }
+  this->m_Mutex.Unlock();
+
+} // end WorkerLoop()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+WorkerThreadPool
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfWorkerThreads: " << this->m_NumberOfWorkerThreads << std::endl;
+  os << indent << "Busy: " << this->m_Busy << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkWorkerThreadPool_cxx
@@ -0,0 +1,171 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkWorkerThreadPool_h
+#define __itkWorkerThreadPool_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+#include "itkConditionVariable.h"
+
+#include <string>
+
+namespace itk
+{
+
+/** \class WorkerThreadPool
+ *
+ * \brief A process-wide pool of persistent worker threads.
+ *
+ * The itk::MultiThreader creates and joins fresh OS threads at every
+ * SingleMethodExecute(). In elastix this happens several times per
+ * optimizer iteration (metric value and derivative, derivative accumulation,
+ * sampler updates), which for small sample sizes and many cores means that
+ * thread creation dominates the computation time.
+ *
+ * This class keeps a set of worker threads alive for the lifetime of the
+ * process. Execute() mimics MultiThreader::SingleMethodExecute(): the
+ * callback is invoked with a MultiThreader::ThreadInfoStruct for every
+ * thread id in [0, numberOfThreads), where thread 0 runs on the calling
+ * thread, and the call blocks until all threads are finished. Existing
+ * ITK_THREAD_RETURN_TYPE callbacks can therefore be used unchanged.
+ *
+ * The ITK thread pool (MultiThreader::SetUseThreadPool( true )) is known
+ * to hang elastix in WaitForSingleMethodThread(). That pool is a single
+ * process-wide set of threads with a shared job queue, and
+ * WaitForSingleMethodThread() blocks until the queued job of a given thread
+ * id has been run. When a job running on a pool thread itself launches a
+ * multi-threaded computation (for example a sub metric evaluated
+ * concurrently by the CombinationImageToImageMetric), the jobs of the inner
+ * launch are queued behind the outer ones. Once all pool threads are
+ * occupied by outer jobs that wait for inner jobs, no thread is left to run
+ * the inner jobs, and every waiter blocks forever. This pool avoids the two
+ * situations in which a blocking join cannot complete:
+ * \li Job completion is counted under the same mutex that guards the
+ *   condition variable, so a worker finishing before the caller starts
+ *   waiting can not be missed.
+ * \li A nested Execute() (issued from inside a running job), or a concurrent
+ *   Execute() from another thread, never waits for the busy workers. It runs
+ *   on freshly created threads of a local MultiThreader instead, which is
+ *   exactly what happened before the pool existed.
+ *
+ * \ingroup ITKCommon
+ */
+
+class WorkerThreadPool : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef WorkerThreadPool           Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( WorkerThreadPool, Object );
+
+  /** Typedefs. */
+  typedef MultiThreader::ThreadInfoStruct ThreadInfoType;
+
+  /** Get the process-wide instance of the pool. It is created on first use. */
+  static Pointer GetInstance( void );
+
+  /** Run the callback for thread ids 0 .. numberOfThreads - 1, and return
+   * when all of them are finished. Thread 0 runs on the calling thread.
+   * Worker threads are created when needed, and are reused afterwards.
+   * Exceptions thrown by the callback are rethrown on the calling thread.
+   */
+  void Execute( ThreadFunctionType callback, void * userData,
+    ThreadIdType numberOfThreads );
+
+  /** Get the number of worker threads that are currently alive. Note that
+   * the calling thread is not counted.
+   */
+  ThreadIdType GetNumberOfWorkerThreads( void ) const;
+
+protected:
+
+  WorkerThreadPool();
+  virtual ~WorkerThreadPool();
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  WorkerThreadPool( const Self & );  // purposely not implemented
+  void operator=( const Self & );    // purposely not implemented
+
+  /** Execute all thread ids one after another on the calling thread. */
+  void ExecuteSerial( ThreadFunctionType callback, void * userData,
+    ThreadIdType numberOfThreads ) const;
+
+  /** Execute all thread ids on fresh threads of a local MultiThreader.
+   * Used when the workers are claimed by another job.
+   */
+  void ExecuteWithMultiThreader( ThreadFunctionType callback, void * userData,
+    ThreadIdType numberOfThreads ) const;
+
+  /** Make sure at least numberOfWorkers workers are alive.
+   * Assumes that m_Mutex is locked.
+   */
+  void SpawnWorkerThreads( ThreadIdType numberOfWorkers );
+
+  /** The function executed by each worker thread. */
+  static ITK_THREAD_RETURN_TYPE WorkerThreadCallback( void * arg );
+
+  /** The loop that waits for work and executes it. */
+  void WorkerLoop( ThreadIdType workerID, SizeValueType generation );
+
+  /** Struct that is passed to a worker at creation. */
+  struct WorkerInfoType
+  {
+    Self *        st_Pool;
+    ThreadIdType  st_WorkerID;
+    SizeValueType st_Generation;
+  };
+
+  /** Thread handles. */
+  MultiThreader::Pointer m_SpawnThreader;
+  ThreadIdType           m_NumberOfWorkerThreads;
+  ThreadIdType           m_SpawnedThreadIDs[ ITK_MAX_THREADS ];
+  WorkerInfoType         m_WorkerInfo[ ITK_MAX_THREADS ];
+
+  /** Synchronization. */
+  mutable SimpleMutexLock    m_Mutex;
+  ConditionVariable::Pointer m_WorkAvailableCondition;
+  ConditionVariable::Pointer m_WorkDoneCondition;
+  bool                       m_Busy;
+  bool                       m_Shutdown;
+
+  /** The current job. */
+  SizeValueType      m_Generation;
+  ThreadFunctionType m_Callback;
+  void *             m_UserData;
+  ThreadIdType       m_NumberOfJobThreads;
+  ThreadIdType       m_NumberOfPendingJobs;
+  bool               m_ExceptionOccurred;
+  std::string        m_ExceptionDescription;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkWorkerThreadPool_h
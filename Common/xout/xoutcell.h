@@ -70,6 +70,18 @@ public:
   /** Write the buffered cell data to the outputs. */
   virtual void WriteBufferedData( void );
 
+  /** Move the buffered cell data to a string, instead of writing it to
+   * the outputs. The buffer is empty afterwards.
+   */
+  virtual void GetBufferedData( std::basic_string< charT, traits > & data );
+
+  /** Suppress the input of the cell. The input of a suppressed cell is
+   * ignored without being formatted, which is cheaper than formatting
+   * and discarding it. Manipulators, such as std::setprecision, still
+   * take effect.
+   */
+  virtual void SetSuppressed( bool suppressed );
+
 protected:
 
   InternalBufferType m_InternalBuffer;
@@ -86,6 +86,47 @@ xoutcell< charT, traits >::WriteBufferedData( void )
 }   // end WriteBufferedData
 
 
+/**
+ * ******************** GetBufferedData *************************
+ */
+
+template< class charT, class traits >
+void
+xoutcell< charT, traits >::GetBufferedData( std::basic_string< charT, traits > & data )
+{
+  /** Make sure all data is written to the string */
+  this->m_InternalBuffer << flush;
+
+  data = this->m_InternalBuffer.str();
+
+  /** Empty the internal buffer */
+  this->m_InternalBuffer.str( std::basic_string< charT, traits >() );
+
+}   // end GetBufferedData
+
+
+/**
+ * ********************* SetSuppressed **************************
+ *
+ * A stream with the badbit set skips the formatting of its input.
+ */
+
+template< class charT, class traits >
+void
+xoutcell< charT, traits >::SetSuppressed( bool suppressed )
+{
+  if( suppressed )
+  {
+    this->m_InternalBuffer.setstate( ios_base::badbit );
+  }
+  else
+  {
+    this->m_InternalBuffer.clear();
+  }
+
+}   // end SetSuppressed
+
+
 } // end namespace xoutlibrary
 
 #endif // end #ifndef __xoutcell_hxx
@@ -20,14 +20,36 @@
 
 #include "xoutmain.h"
 
+/** Thread local storage of a pointer. */
+#if defined( _MSC_VER )
+#define xoutThreadLocal __declspec( thread )
+#else
+#define xoutThreadLocal __thread
+#endif
+
 namespace xoutlibrary
 {
-static xoutbase_type * local_xout = 0;
+static xoutbase_type *                 local_xout  = 0;
+static xoutThreadLocal xoutbase_type * thread_xout = 0;
+
+/** An xout without outputs, which discards everything written to it. It is
+ * returned when neither set_xout() nor set_thread_xout() has been called,
+ * for example when a library user runs a registration without a session.
+ */
+static xoutsimple_type null_xout;
 
 xoutbase_type &
 get_xout( void )
 {
-  return *local_xout;
+  if( thread_xout )
+  {
+    return *thread_xout;
+  }
+  if( local_xout )
+  {
+    return *local_xout;
+  }
+  return null_xout;
 }
 
 
@@ -37,8 +59,23 @@ set_xout( xoutbase_type * arg )
   local_xout = arg;
 }
 
+
+void
+set_thread_xout( xoutbase_type * arg )
+{
+  thread_xout = arg;
+}
+
+
+xoutbase_type *
+get_thread_xout( void )
+{
+  return thread_xout;
+}
+
+
 bool xout_valid() {
-  return local_xout != 0;
+  return thread_xout != 0 || local_xout != 0;
 }
 
 
@@ -37,10 +37,24 @@ typedef xoutsimple< char > xoutsimple_type;
 typedef xoutrow< char >    xoutrow_type;
 typedef xoutcell< char >   xoutcell_type;
 
+/** Get the xout of the calling thread: the one set with set_thread_xout(),
+ * or else the one set with set_xout(), or else an xout that discards
+ * everything.
+ */
 xoutbase_type & get_xout( void );
 
+/** Set the xout that is used by all threads without a thread xout. */
 void set_xout( xoutbase_type * arg );
 
+/** Set the xout of the calling thread, such that several registrations can
+ * run in parallel threads, each with its own log. Set to 0 to use the xout
+ * set with set_xout() again.
+ */
+void set_thread_xout( xoutbase_type * arg );
+
+/** Get the xout of the calling thread; 0 if none has been set. */
+xoutbase_type * get_thread_xout( void );
+
 bool xout_valid();
 
 } // end namespace xoutlibrary
@@ -82,6 +82,26 @@ public:
    */
   virtual void WriteHeaders( void );
 
+  /** Move the buffered cell data to one line, separated by tabs and ended
+   * by a newline, exactly as WriteBufferedData() would write it. The cells
+   * are empty afterwards. This allows the caller to write the row later,
+   * or from another thread.
+   */
+  virtual void GetBufferedRow( std::basic_string< charT, traits > & row );
+
+  /** Get the line with the names of the target cells, as written by
+   * WriteHeaders().
+   */
+  virtual void GetHeaderRow( std::basic_string< charT, traits > & row ) const;
+
+  /** Empty the cells, without writing their data. */
+  virtual void DiscardBufferedData( void );
+
+  /** Suppress the input of all cells, see xoutcell::SetSuppressed().
+   * Useful when the row is not going to be written anyway.
+   */
+  virtual void SetSuppressed( bool suppressed );
+
   /** This method adds an xoutcell to the map of Targets. */
   virtual int AddTargetCell( const char * name );
 
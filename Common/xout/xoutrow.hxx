@@ -66,28 +66,135 @@ void
 xoutrow< charT, traits >
 ::WriteBufferedData( void )
 {
-  /** Write the cell-data to the outputs, separated by tabs. */
-  XStreamMapIteratorType xit   = this->m_XTargetCells.begin();
-  XStreamMapIteratorType tmpIt = xit;
+  /** Collect the cell-data in one row, separated by tabs. */
+  std::basic_string< charT, traits > row;
+  this->GetBufferedRow( row );
 
-  for( ++tmpIt; tmpIt != this->m_XTargetCells.end(); ++xit, ++tmpIt )
+  /** Send the row to the outputs at once, so that each output is
+   * flushed only once per row, instead of once per cell.
+   */
+  for( CStreamMapIteratorType cit = this->m_COutputs.begin();
+    cit != this->m_COutputs.end(); ++cit )
   {
-    /** Write a tab to the cell */
-    *( xit->second ) << "\t";
+    *( cit->second ) << row << flush;
+  }
 
-    /** And send its contents to the outputs */
+  for( XStreamMapIteratorType xit = this->m_XOutputs.begin();
+    xit != this->m_XOutputs.end(); ++xit )
+  {
+    *( xit->second ) << row;
     xit->second->WriteBufferedData();
+  }
 
-    /** The cell is empty now! */
-  } // end for
+} // end WriteBufferedData()
 
-  /** Go to the last cell and use it to send an enter to the outputs. */
-  xit->second->WriteBufferedData();
-  --xit;
-  *( xit->second ) << "\n";
-  xit->second->WriteBufferedData();
 
-} // end WriteBufferedData()
+/**
+ * ******************** GetBufferedRow **************************
+ */
+
+template< class charT, class traits >
+void
+xoutrow< charT, traits >
+::GetBufferedRow( std::basic_string< charT, traits > & row )
+{
+  std::basic_ostringstream< charT, traits > line;
+  std::basic_string< charT, traits >        data;
+
+  for( XStreamMapIteratorType xit = this->m_XTargetCells.begin();
+    xit != this->m_XTargetCells.end(); ++xit )
+  {
+    if( xit != this->m_XTargetCells.begin() )
+    {
+      line << "\t";
+    }
+
+    /** Only xoutcells buffer their data. */
+    XOutCellType * cell = dynamic_cast< XOutCellType * >( xit->second );
+    if( cell != 0 )
+    {
+      cell->GetBufferedData( data );
+      line << data;
+    }
+  }
+  line << "\n";
+
+  row = line.str();
+
+} // end GetBufferedRow()
+
+
+/**
+ * ******************** GetHeaderRow ****************************
+ */
+
+template< class charT, class traits >
+void
+xoutrow< charT, traits >
+::GetHeaderRow( std::basic_string< charT, traits > & row ) const
+{
+  std::basic_ostringstream< charT, traits > line;
+
+  for( typename XStreamMapType::const_iterator xit = this->m_XTargetCells.begin();
+    xit != this->m_XTargetCells.end(); ++xit )
+  {
+    if( xit != this->m_XTargetCells.begin() )
+    {
+      line << "\t";
+    }
+    line << xit->first;
+  }
+  line << "\n";
+
+  row = line.str();
+
+} // end GetHeaderRow()
+
+
+/**
+ * ****************** DiscardBufferedData ***********************
+ */
+
+template< class charT, class traits >
+void
+xoutrow< charT, traits >
+::DiscardBufferedData( void )
+{
+  std::basic_string< charT, traits > data;
+
+  for( XStreamMapIteratorType xit = this->m_XTargetCells.begin();
+    xit != this->m_XTargetCells.end(); ++xit )
+  {
+    XOutCellType * cell = dynamic_cast< XOutCellType * >( xit->second );
+    if( cell != 0 )
+    {
+      cell->GetBufferedData( data );
+    }
+  }
+
+} // end DiscardBufferedData()
+
+
+/**
+ * ********************* SetSuppressed **************************
+ */
+
+template< class charT, class traits >
+void
+xoutrow< charT, traits >
+::SetSuppressed( bool suppressed )
+{
+  for( XStreamMapIteratorType xit = this->m_XTargetCells.begin();
+    xit != this->m_XTargetCells.end(); ++xit )
+  {
+    XOutCellType * cell = dynamic_cast< XOutCellType * >( xit->second );
+    if( cell != 0 )
+    {
+      cell->SetSuppressed( suppressed );
+    }
+  }
+
+} // end SetSuppressed()
 
 
 /**
@@ -153,6 +153,14 @@ FixedGenericPyramid< TElastix >
     "ComputePyramidImagesPerResolution", 0, false );
   this->SetComputeOnlyForCurrentLevel( computeThisResolution );
 
+  /** Decide whether or not to store the pyramid images in the image cache,
+   * so that the next elastix level can reuse them.
+   */
+  bool useImageCache = false;
+  this->m_Configuration->ReadParameter( useImageCache,
+    "UseImageCache", 0, false );
+  this->SetImageCache( useImageCache ? this->GetElastix()->GetImageCache() : 0 );
+
 } // end SetFixedSchedule()
 
 
@@ -91,6 +91,21 @@ namespace elastix
  *    B-spline grids.
  *    example: <tt>(UseFastAndLowMemoryVersion "false")</tt> \n
  *    The default is "true".
+ * \parameter UseSparsePDFDerivatives: Only used when UseFastAndLowMemoryVersion
+ *    is "false". Instead of the large 3D matrix, the derivatives of the joint
+ *    histogram are stored per sample, for the affected B-spline parameters only.
+ *    This keeps the first method usable for fine B-spline grids.
+ *    Can be given for each resolution, or for all resolutions at once. \n
+ *    example: <tt>(UseSparsePDFDerivatives "true")</tt> \n
+ *    The default is "false".
+ * \parameter JointPDFAccumulationMethod: The way the joint histogram is accumulated
+ *    over the threads: "PerThreadCopy" (each thread fills a copy, which are summed
+ *    afterwards), "ParallelReduction" (as PerThreadCopy, but the copies are summed
+ *    in parallel), or "BinSharded" (no copies; each thread adds all samples to its own
+ *    range of fixed image bins). Can be given for each resolution, or for all
+ *    resolutions at once. \n
+ *    example: <tt>(JointPDFAccumulationMethod "BinSharded")</tt> \n
+ *    The default is "PerThreadCopy".
  *
  * \sa ParzenWindowMutualInformationImageToImageMetric
  * \ingroup Metrics
@@ -125,6 +125,29 @@ AdvancedMattesMutualInformationMetric< TElastix >
     "UseFastAndLowMemoryVersion", this->GetComponentLabel(), level, 0 );
   this->SetUseExplicitPDFDerivatives( !useFastAndLowMemoryVersion );
 
+  /** Set whether the explicit pdf derivatives should be stored sparsely. */
+  bool useSparsePDFDerivatives = false;
+  this->GetConfiguration()->ReadParameter( useSparsePDFDerivatives,
+    "UseSparsePDFDerivatives", this->GetComponentLabel(), level, 0 );
+  this->SetUseSparsePDFDerivatives( useSparsePDFDerivatives );
+
+  /** Set the way the joint histogram is accumulated over the threads. */
+  std::string jointPDFAccumulationMethod = "PerThreadCopy";
+  this->GetConfiguration()->ReadParameter( jointPDFAccumulationMethod,
+    "JointPDFAccumulationMethod", this->GetComponentLabel(), level, 0, false );
+  if( jointPDFAccumulationMethod == "ParallelReduction" )
+  {
+    this->SetJointPDFAccumulationMethod( Superclass1::ParallelReduction );
+  }
+  else if( jointPDFAccumulationMethod == "BinSharded" )
+  {
+    this->SetJointPDFAccumulationMethod( Superclass1::BinSharded );
+  }
+  else
+  {
+    this->SetJointPDFAccumulationMethod( Superclass1::PerThreadCopy );
+  }
+
   /** Set whether to use Nick Tustison's preconditioning technique. */
   bool useJacobianPreconditioning = false;
   this->GetConfiguration()->ReadParameter( useJacobianPreconditioning,
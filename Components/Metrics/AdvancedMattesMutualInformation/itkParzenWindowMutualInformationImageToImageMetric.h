@@ -276,9 +276,12 @@ private:
 
   void ComputeDerivativeLowMemory( DerivativeType & derivative ) const;
 
-  /** Helper function to update the derivative for the low memory variant. */
+  /** Helper function to update the derivative for the low memory variant.
+   * The fixed image Parzen window is given, see ComputeFixedParzenWindow().
+   */
   void UpdateDerivativeLowMemory(
-    const RealType & fixedImageValue,
+    const OffsetValueType fixedParzenWindowIndex,
+    const ParzenValueContainerType & fixedParzenValues,
     const RealType & movingImageValue,
     const DerivativeType & imageJacobian,
     const NonZeroJacobianIndicesType & nzji,
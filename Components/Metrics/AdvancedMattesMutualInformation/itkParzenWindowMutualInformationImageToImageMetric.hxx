@@ -62,7 +62,7 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   this->Superclass::InitializeHistograms();
 
   /** Allocate small amount of memory for the m_PRatioArray. */
-  if( !this->GetUseExplicitPDFDerivatives() )
+  if( !this->GetUseExplicitPDFDerivatives() || this->GetUseSparsePDFDerivatives() )
   {
     this->m_PRatioArray.SetSize(
       this->GetNumberOfFixedHistogramBins(),
@@ -173,6 +173,21 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   this->ComputeMarginalPDF( this->m_JointPDF, this->m_FixedImageMarginalPDF, 0 );
   this->ComputeMarginalPDF( this->m_JointPDF, this->m_MovingImageMarginalPDF, 1 );
 
+  /** With sparse pdf derivatives, the m_PRatioArray gives the weight of
+   * each bin, which is contracted with the stored derivatives of the samples.
+   * The log of the fixed marginal pdf can be left out of the weights, since
+   * the pdf derivatives sum to zero over the moving bins.
+   */
+  if( this->GetUseSparsePDFDerivatives() )
+  {
+    double MI = 0.0;
+    this->ComputeValueAndPRatioArray( MI );
+    value = static_cast< MeasureType >( -1.0 * MI );
+    this->ContractSparseJointPDFDerivatives(
+      this->m_PRatioArray.data_block(), derivative );
+    return;
+  }
+
   /** Compute the metric and derivatives by double summation over histogram. */
 
   /** Setup iterators .*/
@@ -319,6 +334,13 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
   typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
 
+  /** The fixed image Parzen window of a sample. */
+  OffsetValueType          fixedParzenWindowIndex = 0;
+  ParzenValueContainerType fixedParzenValues;
+
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for( fiter = fbegin; fiter != fend; ++fiter )
   {
@@ -329,7 +351,9 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if the point is inside the moving mask. */
     if( sampleOk )
@@ -345,18 +369,21 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, &movingImageDerivative );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      /** Get the fixed image Parzen window, possibly from the sample cache. */
+      const RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      this->ComputeFixedParzenWindow( fiter.Index(), fixedImageValue,
+        fixedParzenWindowIndex, fixedParzenValues );
 
       /** Make sure the values fall within the histogram range. */
-      fixedImageValue = this->GetFixedImageLimiter()
-        ->Evaluate( fixedImageValue );
       movingImageValue = this->GetMovingImageLimiter()
         ->Evaluate( movingImageValue, movingImageDerivative );
 
+      phaseTimes.Start( RegistrationProfiler::JacobianProduct );
+
       /** Get the transform Jacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
 
@@ -383,8 +410,9 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
       }
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateDerivativeLowMemory(
-        fixedImageValue, movingImageValue, imageJacobian, nzji, derivative );
+      this->UpdateDerivativeLowMemory( fixedParzenWindowIndex, fixedParzenValues,
+        movingImageValue, imageJacobian, nzji, derivative );
+      phaseTimes.Stop();
 
     } // end sampleOk
   }   // end loop over sample container
@@ -485,6 +513,13 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   fbegin                                                 += (int)pos_begin;
   fend                                                   += (int)pos_end;
 
+  /** The fixed image Parzen window of a sample. */
+  OffsetValueType          fixedParzenWindowIndex = 0;
+  ParzenValueContainerType fixedParzenValues;
+
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for( fiter = fbegin; fiter != fend; ++fiter )
   {
@@ -495,7 +530,9 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if the point is inside the moving mask. */
     if( sampleOk )
@@ -511,17 +548,21 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, &movingImageDerivative );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      /** Get the fixed image Parzen window, possibly from the sample cache. */
+      const RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      this->ComputeFixedParzenWindow( fiter.Index(), fixedImageValue,
+        fixedParzenWindowIndex, fixedParzenValues );
 
       /** Make sure the values fall within the histogram range. */
-      fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
       movingImageValue = this->GetMovingImageLimiter()
         ->Evaluate( movingImageValue, movingImageDerivative );
 
+      phaseTimes.Start( RegistrationProfiler::JacobianProduct );
+
 #if 0
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
@@ -557,9 +598,9 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
       }
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateDerivativeLowMemory(
-        fixedImageValue, movingImageValue, imageJacobian, nzji,
-        derivative );
+      this->UpdateDerivativeLowMemory( fixedParzenWindowIndex, fixedParzenValues,
+        movingImageValue, imageJacobian, nzji, derivative );
+      phaseTimes.Stop();
 
     } // end sampleOk
   }   // end loop over sample container
@@ -628,9 +669,8 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->ExecuteThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 
 } // end AfterThreadedComputeDerivativeLowMemory()
@@ -667,14 +707,11 @@ void
 ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchComputeDerivativeLowMemoryThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputeDerivativeLowMemoryThreaderCallback,
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->ComputeDerivativeLowMemoryThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_ParzenWindowMutualInformationThreaderParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputeDerivativeLowMemoryThreaderCallback()
 
 
@@ -763,7 +800,8 @@ template< class TFixedImage, class TMovingImage >
 void
 ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::UpdateDerivativeLowMemory(
-  const RealType & fixedImageValue,
+  const OffsetValueType fixedParzenWindowIndex,
+  const ParzenValueContainerType & fixedParzenValues,
   const RealType & movingImageValue,
   const DerivativeType & imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
@@ -784,25 +822,14 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   /** Determine the affected region. */
 
   /** Determine Parzen window arguments (see eq. 6 of Mattes paper [2]). */
-  const double fixedImageParzenWindowTerm
-    = fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
   const double movingImageParzenWindowTerm
     = movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
 
-  /** The lowest bin numbers affected by this pixel: */
-  const int fixedParzenWindowIndex
-    = static_cast< int >( vcl_floor(
-    fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset ) );
+  /** The lowest bin number affected by this pixel: */
   const int movingParzenWindowIndex
     = static_cast< int >( vcl_floor(
     movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset ) );
 
-  /** Compute the fixed Parzen values. */
-  ParzenValueContainerType fixedParzenValues( this->m_JointPDFWindow.GetSize()[ 1 ] );
-  this->EvaluateParzenValues(
-    fixedImageParzenWindowTerm, fixedParzenWindowIndex,
-    this->m_FixedKernel, fixedParzenValues );
-
   /** Compute the derivatives of the moving Parzen window. */
   ParzenValueContainerType derivativeMovingParzenValues( this->m_JointPDFWindow.GetSize()[ 0 ] );
   this->EvaluateParzenValues(
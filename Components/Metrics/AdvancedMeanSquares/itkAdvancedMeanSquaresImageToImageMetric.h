@@ -208,6 +208,8 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::ImageSampleBlockType                ImageSampleBlockType;
+  typedef typename Superclass::MovingImageSampleBlockType          MovingImageSampleBlockType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<
@@ -240,12 +242,20 @@ protected:
   /** Get value for each thread. */
   inline void ThreadedGetValue( ThreadIdType threadID );
 
+  /** Get value for each thread, processing the samples in blocks;
+   * called by ThreadedGetValue() if UseSampleBlocks. */
+  void ThreadedGetValueUsingSampleBlocks( ThreadIdType threadID );
+
   /** Gather the values from all threads. */
   inline void AfterThreadedGetValue( MeasureType & value ) const;
 
   /** Get value and derivatives for each thread. */
   inline void ThreadedGetValueAndDerivative( ThreadIdType threadID );
 
+  /** Get value and derivatives for each thread, processing the samples in
+   * blocks; called by ThreadedGetValueAndDerivative() if UseSampleBlocks. */
+  void ThreadedGetValueAndDerivativeUsingSampleBlocks( ThreadIdType threadID );
+
   /** Gather the values and derivatives from all threads. */
   inline void AfterThreadedGetValueAndDerivative(
     MeasureType & value, DerivativeType & derivative ) const;
@@ -20,8 +20,9 @@
 
 #include "itkAdvancedMeanSquaresImageToImageMetric.h"
 #include "vnl/algo/vnl_matrix_update.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkThreadRandomGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
+#include <algorithm>
 
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
@@ -319,6 +320,12 @@ void
 AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedGetValue( ThreadIdType threadId )
 {
+  if( this->m_UseSampleBlocks )
+  {
+    this->ThreadedGetValueUsingSampleBlocks( threadId );
+    return;
+  }
+
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
@@ -345,6 +352,9 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure               = NumericTraits< MeasureType >::Zero;
 
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over the fixed image to calculate the mean squares. */
   for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
   {
@@ -354,7 +364,9 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if point is inside mask. */
     if( sampleOk )
@@ -370,6 +382,7 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, 0 );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
@@ -394,6 +407,62 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 } // end ThreadedGetValue()
 
 
+/**
+ * ******************* ThreadedGetValueUsingSampleBlocks *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueUsingSampleBlocks( ThreadIdType threadId )
+{
+  /** Get a handle to the sample container. */
+  ImageSamplerType *  sampler             = this->GetImageSampler();
+  const unsigned long sampleContainerSize = sampler->GetOutput()->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->m_NumberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long              numberOfPixelsCounted = 0;
+  MeasureType                measure               = NumericTraits< MeasureType >::Zero;
+  ImageSampleBlockType       fixedBlock;
+  MovingImageSampleBlockType movingBlock;
+
+  /** Loop over the blocks of samples of this thread. */
+  for( unsigned long first = pos_begin; first < pos_end; first += this->m_SampleBlockSize )
+  {
+    sampler->GetOutputBlock( first, std::min< unsigned long >( this->m_SampleBlockSize, pos_end - first ), fixedBlock );
+    numberOfPixelsCounted += this->EvaluateSampleBlock( fixedBlock, movingBlock, false );
+
+    /** The moving image values of invalid samples are zero, and their
+     * difference is masked by st_Valid, so this loop has no branches.
+     */
+    const SizeValueType blockSize = fixedBlock.Size();
+    const RealType *    fixedValues  = &fixedBlock.m_ImageValues[ 0 ];
+    const RealType *    movingValues = &movingBlock.st_MovingImageValues[ 0 ];
+    const RealType *    valid        = &movingBlock.st_Valid[ 0 ];
+    for( SizeValueType i = 0; i < blockSize; ++i )
+    {
+      const RealType diff = valid[ i ] * ( movingValues[ i ] - fixedValues[ i ] );
+      measure += diff * diff;
+    }
+  }
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 = measure;
+
+} // end ThreadedGetValueUsingSampleBlocks()
+
+
 /**
  * ******************* AfterThreadedGetValue *******************
  */
@@ -636,6 +705,12 @@ void
 AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedGetValueAndDerivative( ThreadIdType threadId )
 {
+  if( this->m_UseSampleBlocks )
+  {
+    this->ThreadedGetValueAndDerivativeUsingSampleBlocks( threadId );
+    return;
+  }
+
   /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
@@ -674,6 +749,9 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure               = NumericTraits< MeasureType >::Zero;
 
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over the fixed image to calculate the mean squares. */
   for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
   {
@@ -684,7 +762,9 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if point is inside mask. */
     if( sampleOk )
@@ -700,6 +780,7 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, &movingImageDerivative );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
@@ -709,6 +790,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
       const RealType & fixedImageValue
         = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
 
+      phaseTimes.Start( RegistrationProfiler::JacobianProduct );
+
 #if 0
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
@@ -727,6 +810,7 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
         fixedImageValue, movingImageValue,
         imageJacobian, nzji,
         measure, derivative );
+      phaseTimes.Stop();
 
     } // end if sampleOk
 
@@ -739,6 +823,75 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 } // end ThreadedGetValueAndDerivative()
 
 
+/**
+ * ******************* ThreadedGetValueAndDerivativeUsingSampleBlocks *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueAndDerivativeUsingSampleBlocks( ThreadIdType threadId )
+{
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
+  DerivativeType               imageJacobian( nnzji );
+
+  /** Get a handle to the pre-allocated derivative for the current thread. */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+
+  /** Get a handle to the sample container. */
+  ImageSamplerType *  sampler             = this->GetImageSampler();
+  const unsigned long sampleContainerSize = sampler->GetOutput()->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->m_NumberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long              numberOfPixelsCounted = 0;
+  MeasureType                measure               = NumericTraits< MeasureType >::Zero;
+  ImageSampleBlockType       fixedBlock;
+  MovingImageSampleBlockType movingBlock;
+
+  /** Loop over the blocks of samples of this thread. */
+  for( unsigned long first = pos_begin; first < pos_end; first += this->m_SampleBlockSize )
+  {
+    sampler->GetOutputBlock( first, std::min< unsigned long >( this->m_SampleBlockSize, pos_end - first ), fixedBlock );
+    numberOfPixelsCounted += this->EvaluateSampleBlock( fixedBlock, movingBlock, true );
+
+    /** The derivative terms are sparse and differ per sample. */
+    RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::JacobianProduct );
+    const SizeValueType               blockSize = fixedBlock.Size();
+    for( SizeValueType i = 0; i < blockSize; ++i )
+    {
+      if( movingBlock.st_Valid[ i ] == 0.0 ) { continue; }
+
+      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+        fixedBlock.m_ImageCoordinates[ i ], movingBlock.st_MovingImageDerivatives[ i ], imageJacobian, nzji );
+
+      /** Compute this pixel's contribution to the measure and derivatives. */
+      this->UpdateValueAndDerivativeTerms(
+        fixedBlock.m_ImageValues[ i ], movingBlock.st_MovingImageValues[ i ],
+        imageJacobian, nzji,
+        measure, derivative );
+    }
+  }
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 = measure;
+
+} // end ThreadedGetValueAndDerivativeUsingSampleBlocks()
+
+
 /**
  * ******************* AfterThreadedGetValueAndDerivative *******************
  */
@@ -749,6 +902,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 ::AfterThreadedGetValueAndDerivative(
   MeasureType & value, DerivativeType & derivative ) const
 {
+  RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::DerivativeAccumulation );
+
   /** Accumulate the number of pixels. */
   this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[ 0 ].st_NumberOfPixelsCounted;
   for( ThreadIdType i = 1; i < this->m_NumberOfThreads; ++i )
@@ -795,9 +950,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
     this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->ExecuteThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
@@ -881,7 +1035,7 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
-  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  RandomGeneratorType::Pointer randomGenerator = ThreadRandomGenerator::GetInstance();
   randomGenerator->Initialize();
 
   /** Array that stores dM(x)/dmu, and the sparse jacobian+indices. */
@@ -209,6 +209,8 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::ImageSampleBlockType                ImageSampleBlockType;
+  typedef typename Superclass::MovingImageSampleBlockType          MovingImageSampleBlockType;
 
   /** Compute a pixel's contribution to the derivative terms;
    * Called by GetValueAndDerivative().
@@ -231,6 +233,10 @@ protected:
   /** Get value and derivatives for each thread. */
   inline void ThreadedGetValueAndDerivative( ThreadIdType threadID );
 
+  /** Get value and derivatives for each thread, processing the samples in
+   * blocks; called by ThreadedGetValueAndDerivative() if UseSampleBlocks. */
+  void ThreadedGetValueAndDerivativeUsingSampleBlocks( ThreadIdType threadID );
+
   /** Gather the values and derivatives from all threads */
   inline void AfterThreadedGetValueAndDerivative(
     MeasureType & value, DerivativeType & derivative ) const;
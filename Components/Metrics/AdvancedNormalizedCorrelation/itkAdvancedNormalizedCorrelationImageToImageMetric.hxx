@@ -19,6 +19,7 @@
 #define _itkAdvancedNormalizedCorrelationImageToImageMetric_hxx
 
 #include "itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+#include <algorithm>
 
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
@@ -530,6 +531,12 @@ void
 AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedGetValueAndDerivative( ThreadIdType threadId )
 {
+  if( this->m_UseSampleBlocks )
+  {
+    this->ThreadedGetValueAndDerivativeUsingSampleBlocks( threadId );
+    return;
+  }
+
   /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
@@ -574,6 +581,9 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   AccumulateType sm                    = NumericTraits< AccumulateType >::Zero;
   unsigned long  numberOfPixelsCounted = 0;
 
+  /** Time the phases of the per-sample work, if profiling is enabled. */
+  RegistrationProfiler::PhaseAccumulator phaseTimes( this->m_Profiler );
+
   /** Loop over the fixed image to calculate the mean squares. */
   for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
   {
@@ -584,7 +594,9 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point and check if it is inside the B-spline support region. */
+    phaseTimes.Start( RegistrationProfiler::TransformEvaluation );
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    phaseTimes.Start( RegistrationProfiler::Interpolation );
 
     /** Check if point is inside mask. */
     if( sampleOk )
@@ -600,6 +612,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
       sampleOk = this->EvaluateMovingImageValueAndDerivative(
         mappedPoint, movingImageValue, &movingImageDerivative );
     }
+    phaseTimes.Stop();
 
     if( sampleOk )
     {
@@ -609,6 +622,8 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
       const RealType & fixedImageValue
         = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
 
+      phaseTimes.Start( RegistrationProfiler::JacobianProduct );
+
 #if 0
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
@@ -633,6 +648,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
       this->UpdateDerivativeTerms(
         fixedImageValue, movingImageValue, imageJacobian, nzji,
         derivativeF, derivativeM, differential );
+      phaseTimes.Stop();
 
     } // end if sampleOk
 
@@ -649,6 +665,102 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 } // end ThreadedGetValueAndDerivative()
 
 
+/**
+ * ******************* ThreadedGetValueAndDerivativeUsingSampleBlocks *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueAndDerivativeUsingSampleBlocks( ThreadIdType threadId )
+{
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
+  DerivativeType               imageJacobian( nzji.size() );
+
+  /** Get handles to the pre-allocated derivatives for the current thread. */
+  DerivativeType & derivativeF  = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_DerivativeF;
+  DerivativeType & derivativeM  = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_DerivativeM;
+  DerivativeType & differential = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Differential;
+
+  /** Get a handle to the sample container. */
+  ImageSamplerType *  sampler             = this->GetImageSampler();
+  const unsigned long sampleContainerSize = sampler->GetOutput()->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->m_NumberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Create variables to store intermediate results. */
+  AccumulateType             sff                   = NumericTraits< AccumulateType >::Zero;
+  AccumulateType             smm                   = NumericTraits< AccumulateType >::Zero;
+  AccumulateType             sfm                   = NumericTraits< AccumulateType >::Zero;
+  AccumulateType             sf                    = NumericTraits< AccumulateType >::Zero;
+  AccumulateType             sm                    = NumericTraits< AccumulateType >::Zero;
+  unsigned long              numberOfPixelsCounted = 0;
+  ImageSampleBlockType       fixedBlock;
+  MovingImageSampleBlockType movingBlock;
+
+  /** Loop over the blocks of samples of this thread. */
+  for( unsigned long first = pos_begin; first < pos_end; first += this->m_SampleBlockSize )
+  {
+    sampler->GetOutputBlock( first, std::min< unsigned long >( this->m_SampleBlockSize, pos_end - first ), fixedBlock );
+    numberOfPixelsCounted += this->EvaluateSampleBlock( fixedBlock, movingBlock, true );
+
+    /** Update the sums needed to calculate the value of NC. The moving image
+     * values of invalid samples are zero, and the fixed image values are
+     * masked by st_Valid, so this loop has no branches.
+     */
+    const SizeValueType blockSize    = fixedBlock.Size();
+    const RealType *    fixedValues  = &fixedBlock.m_ImageValues[ 0 ];
+    const RealType *    movingValues = &movingBlock.st_MovingImageValues[ 0 ];
+    const RealType *    valid        = &movingBlock.st_Valid[ 0 ];
+    for( SizeValueType i = 0; i < blockSize; ++i )
+    {
+      const RealType fixedImageValue  = valid[ i ] * fixedValues[ i ];
+      const RealType movingImageValue = movingValues[ i ];
+      sff += fixedImageValue  * fixedImageValue;
+      smm += movingImageValue * movingImageValue;
+      sfm += fixedImageValue  * movingImageValue;
+      sf  += fixedImageValue;  // Only needed when m_SubtractMean == true
+      sm  += movingImageValue; // Only needed when m_SubtractMean == true
+    }
+
+    /** The derivative terms are sparse and differ per sample. */
+    RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::JacobianProduct );
+    for( SizeValueType i = 0; i < blockSize; ++i )
+    {
+      if( valid[ i ] == 0.0 ) { continue; }
+
+      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+        fixedBlock.m_ImageCoordinates[ i ], movingBlock.st_MovingImageDerivatives[ i ], imageJacobian, nzji );
+
+      /** Compute this voxel's contribution to the derivative terms. */
+      this->UpdateDerivativeTerms(
+        fixedValues[ i ], movingValues[ i ], imageJacobian, nzji,
+        derivativeF, derivativeM, differential );
+    }
+  }
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sff                   = sff;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Smm                   = smm;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sfm                   = sfm;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sf                    = sf;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sm                    = sm;
+
+} // end ThreadedGetValueAndDerivativeUsingSampleBlocks()
+
+
 /**
  * ******************* AfterThreadedGetValueAndDerivative *******************
  */
@@ -659,6 +771,8 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 ::AfterThreadedGetValueAndDerivative(
   MeasureType & value, DerivativeType & derivative ) const
 {
+  RegistrationProfiler::ScopedTimer timer( this->m_Profiler, RegistrationProfiler::DerivativeAccumulation );
+
   /** Accumulate the number of pixels. */
   this->m_NumberOfPixelsCounted
     = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ 0 ].st_NumberOfPixelsCounted;
@@ -768,8 +882,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     temp->st_InvertedDenominator = 1.0 / denom;
     temp->st_DerivativePointer   = derivative.begin();
 
-    this->m_Threader->SetSingleMethod( AccumulateDerivativesThreaderCallback, temp );
-    this->m_Threader->SingleMethodExecute();
+    this->ExecuteThreaderCallback( AccumulateDerivativesThreaderCallback, temp );
 
     delete temp;
   }
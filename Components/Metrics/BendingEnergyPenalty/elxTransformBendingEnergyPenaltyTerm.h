@@ -39,6 +39,15 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Metric: Select this metric as follows:\n
  *    <tt>(Metric "TransformBendingEnergyPenalty")</tt>
+ * \parameter AnalyticBendingEnergy: Whether the bending energy of a third order
+ *    B-spline transform is computed exactly on the B-spline coefficient grid,
+ *    instead of being estimated from image samples. This makes its cost
+ *    independent of the image size and removes the sampling noise. The moving
+ *    image mask is ignored in this mode. For other transforms, and for a
+ *    B-spline that is composed with an initial transform or added to a
+ *    nonlinear one, this option has no effect. Can be given for each resolution.\n
+ *    example: <tt>(AnalyticBendingEnergy "true" "true" "false")</tt>\n
+ *    The default is "false".
  *
  * \ingroup Metrics
  *
@@ -144,6 +153,7 @@ public:
   /**
    * Do some things before each resolution:
    * \li Set options for SelfHessian
+   * \li Set the use of the analytic bending energy
    */
   virtual void BeforeEachResolution( void );
 
@@ -62,6 +62,12 @@ TransformBendingEnergyPenalty< TElastix >
     "NumberOfSamplesForSelfHessian", this->GetComponentLabel(), level, 0 );
   this->SetNumberOfSamplesForSelfHessian( numberOfSamplesForSelfHessian );
 
+  /** Check if the bending energy of a B-spline is computed on its grid. */
+  bool analyticBendingEnergy = false;
+  this->GetConfiguration()->ReadParameter( analyticBendingEnergy,
+    "AnalyticBendingEnergy", this->GetComponentLabel(), level, 0 );
+  this->SetUseAnalyticBendingEnergy( analyticBendingEnergy );
+
 } // end BeforeEachResolution()
 
 
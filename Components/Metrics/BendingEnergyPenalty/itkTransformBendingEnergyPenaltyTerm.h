@@ -20,6 +20,10 @@
 
 #include "itkTransformPenaltyTerm.h"
 #include "itkImageGridSampler.h"
+#include "itkBSplineKernelFunction2.h"
+#include "itkBSplineDerivativeKernelFunction2.h"
+#include "itkBSplineSecondOrderDerivativeKernelFunction2.h"
+#include <vector>
 
 namespace itk
 {
@@ -43,6 +47,18 @@ namespace itk
  *      "Itk::Transforms supporting spatial derivatives"",
  *      Insight Journal, http://hdl.handle.net/10380/3215.
  *
+ * For a third order B-spline transform the bending energy is a quadratic
+ * form of the B-spline coefficients. With SetUseAnalyticBendingEnergy( true )
+ * it is integrated exactly over the valid region of the B-spline grid, using
+ * precomputed 1D stencils of products of B-spline derivatives. The value and
+ * the derivative are then computed on the coefficient grid, so that their cost
+ * does not depend on the image size and they contain no sampling noise. The
+ * value is divided by the volume of the valid region, which makes it comparable
+ * to the sample mean of the default mode. The moving image mask is ignored in
+ * this mode. For other transforms, and for a B-spline that is composed with an
+ * initial transform or added to one with a nonzero spatial Hessian, the
+ * default mode is used.
+ *
  * \ingroup Metrics
  */
 
@@ -160,6 +176,12 @@ public:
   itkSetMacro( NumberOfSamplesForSelfHessian, unsigned int );
   itkGetConstMacro( NumberOfSamplesForSelfHessian, unsigned int );
 
+  /** Compute the bending energy of a third order B-spline transform
+   * analytically on its coefficient grid. Default: false.
+   */
+  itkSetMacro( UseAnalyticBendingEnergy, bool );
+  itkGetConstMacro( UseAnalyticBendingEnergy, bool );
+
 protected:
 
   /** Typedefs for indices and points. */
@@ -187,7 +209,74 @@ private:
   /** The private copy constructor. */
   void operator=( const Self & );                    // purposely not implemented
 
+  /** Typedefs for the analytic bending energy. */
+  typedef typename BSplineOrder3TransformType::ImageType CoefficientImageType;
+  typedef typename CoefficientImageType::PixelType       CoefficientPixelType;
+  typedef typename CoefficientImageType::SizeType        CoefficientImageSizeType;
+  typedef typename CoefficientImageType::SpacingType     CoefficientImageSpacingType;
+  typedef std::vector< CoefficientPixelType >            BufferType;
+
+  /** A row of a 1D stencil matrix, holding the entries of the coefficients
+   * at offsets -3, ..., 3 from the diagonal.
+   */
+  typedef FixedArray< CoefficientPixelType, 7 > StencilRowType;
+  typedef std::vector< StencilRowType >         StencilMatrixType;
+
+  /** A term of the bending energy: the order of differentiation in each
+   * dimension, and the number of second order derivatives it stands for.
+   */
+  struct AnalyticTermType
+  {
+    unsigned int st_Orders[ FixedImageDimension ];
+    RealType     st_Weight;
+  };
+
+  /** The parameters of a multi-threaded stencil pass. */
+  struct AnalyticThreaderParameterType
+  {
+    const Self *                 st_Metric;
+    const CoefficientPixelType * st_Input;
+    CoefficientPixelType *       st_Output;
+    unsigned int                 st_Dimension;
+    unsigned int                 st_Order;
+    RealType                     st_Weight;
+    bool                         st_Accumulate;
+  };
+
+  /** Compute the analytic bending energy and, if derivative is not NULL,
+   * its derivative. Returns false if the transform is not a third order
+   * B-spline, or if its initial transform contributes to the bending energy,
+   * in which case nothing is computed.
+   */
+  bool ComputeAnalyticValueAndDerivative( const ParametersType & parameters,
+    MeasureType & value, DerivativeType * derivative ) const;
+
+  /** Compute the 1D stencil matrices, if the B-spline grid changed. */
+  void InitializeAnalyticStencils( const BSplineOrder3TransformType * bspline ) const;
+
+  /** Apply a 1D stencil matrix along one dimension of the grid. */
+  void LaunchAnalyticPass( AnalyticThreaderParameterType & parameters ) const;
+
+  static ITK_THREAD_RETURN_TYPE AnalyticPassThreaderCallback( void * arg );
+
+  void ThreadedAnalyticPass( const AnalyticThreaderParameterType & parameters,
+    const ThreadIdType threadID, const ThreadIdType numberOfThreads ) const;
+
   unsigned int m_NumberOfSamplesForSelfHessian;
+  bool         m_UseAnalyticBendingEnergy;
+
+  /** Cached stencils of the analytic bending energy. The stencil matrix of
+   * dimension d and derivative order o is m_AnalyticStencils[ 3 * d + o ].
+   */
+  mutable bool                            m_AnalyticStencilsAreInitialized;
+  mutable CoefficientImageSizeType        m_AnalyticStencilsSize;
+  mutable CoefficientImageSpacingType     m_AnalyticStencilsSpacing;
+  mutable SizeValueType                   m_NumberOfCoefficients;
+  mutable RealType                        m_ValidRegionVolume;
+  mutable std::vector< StencilMatrixType > m_AnalyticStencils;
+  mutable std::vector< AnalyticTermType >  m_AnalyticTerms;
+  mutable BufferType                      m_AnalyticBuffers[ 2 ];
+  mutable BufferType                      m_AnalyticResult;
 
 };
 
@@ -19,6 +19,7 @@
 #define __itkTransformBendingEnergyPenaltyTerm_hxx
 
 #include "itkTransformBendingEnergyPenaltyTerm.h"
+#include <algorithm>
 
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
@@ -41,6 +42,11 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   this->SetUseImageSampler( true );
 
   this->m_NumberOfSamplesForSelfHessian = 100000;
+  this->m_UseAnalyticBendingEnergy      = false;
+
+  this->m_AnalyticStencilsAreInitialized = false;
+  this->m_NumberOfCoefficients           = 0;
+  this->m_ValidRegionVolume              = NumericTraits< RealType >::One;
 
 } // end Constructor
 
@@ -54,6 +60,16 @@ typename TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >::MeasureT
 TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
 ::GetValue( const ParametersType & parameters ) const
 {
+  /** Compute the bending energy on the B-spline grid, if requested. */
+  if( this->m_UseAnalyticBendingEnergy )
+  {
+    MeasureType analyticValue = NumericTraits< MeasureType >::Zero;
+    if( this->ComputeAnalyticValueAndDerivative( parameters, analyticValue, NULL ) )
+    {
+      return analyticValue;
+    }
+  }
+
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
   RealType           measure = NumericTraits< RealType >::Zero;
@@ -167,6 +183,13 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   MeasureType & value,
   DerivativeType & derivative ) const
 {
+  /** Compute the bending energy on the B-spline grid, if requested. */
+  if( this->m_UseAnalyticBendingEnergy
+    && this->ComputeAnalyticValueAndDerivative( parameters, value, &derivative ) )
+  {
+    return;
+  }
+
   /** Create and initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
   RealType measure = NumericTraits< RealType >::Zero;
@@ -368,6 +391,15 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   const ParametersType & parameters,
   MeasureType & value, DerivativeType & derivative ) const
 {
+  /** Compute the bending energy on the B-spline grid, if requested.
+   * This mode is multi-threaded over the grid by itself.
+   */
+  if( this->m_UseAnalyticBendingEnergy
+    && this->ComputeAnalyticValueAndDerivative( parameters, value, &derivative ) )
+  {
+    return;
+  }
+
   /** Option for now to still use the single threaded code. */
   if( !this->m_UseMultiThread )
   {
@@ -638,9 +670,8 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
     this->m_ThreaderMetricParameters.st_NormalizationFactor
       = static_cast< DerivativeValueType >( this->m_NumberOfPixelsCounted );
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->ExecuteThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
@@ -841,6 +872,350 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
 } // end GetSelfHessian()
 
 
+/**
+ * ******************* ComputeAnalyticValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+bool
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::ComputeAnalyticValueAndDerivative( const ParametersType & parameters,
+  MeasureType & value, DerivativeType * derivative ) const
+{
+  /** Only a third order B-spline transform, whose parameters are the
+   * parameters of this metric, has a stencil.
+   */
+  BSplineOrder3TransformPointer bspline = 0;
+  this->CheckForBSplineTransform2( bspline );
+  if( bspline.IsNull()
+    || bspline->GetNumberOfParameters() != this->GetNumberOfParameters() )
+  {
+    return false;
+  }
+
+  /** CheckForBSplineTransform2() returns the current transform of a
+   * combination transform. Its bending energy is that of the combination
+   * only if there is no initial transform, or if the initial transform is
+   * added and has a zero spatial Hessian. Otherwise the default mode is used.
+   */
+  const CombinationTransformType * combinationTransform
+    = dynamic_cast< const CombinationTransformType * >( this->m_AdvancedTransform.GetPointer() );
+  if( combinationTransform && combinationTransform->GetInitialTransform() )
+  {
+    if( !combinationTransform->GetUseAddition()
+      || combinationTransform->GetInitialTransform()->GetHasNonZeroSpatialHessian() )
+    {
+      return false;
+    }
+  }
+
+  /** Set the transform parameters. Unlike in
+   * BeforeThreadedGetValueAndDerivative(), the image sampler is not needed.
+   */
+  if( this->m_UseMetricSingleThreaded )
+  {
+    this->SetTransformParameters( parameters );
+  }
+
+  /** Make sure the stencils and the buffers match the current grid. */
+  this->InitializeAnalyticStencils( bspline.GetPointer() );
+  const SizeValueType numberOfCoefficients = this->m_NumberOfCoefficients;
+  this->m_NumberOfPixelsCounted = numberOfCoefficients;
+
+  if( derivative != NULL )
+  {
+    *derivative = DerivativeType( this->GetNumberOfParameters() );
+    derivative->Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+  }
+
+  /** The bending energy is sum_k c_k^T K c_k, with c_k the coefficients of
+   * dimension k and K the sum over the terms of the tensor products of the
+   * 1D stencil matrices. K c_k is computed term by term, with one pass per
+   * dimension, and the last pass adds the weighted result to m_AnalyticResult.
+   * The derivative is 2 K c_k. The sums run in voxel order, so that the result
+   * does not depend on the number of threads.
+   */
+  RealType                      measure = NumericTraits< RealType >::Zero;
+  const RealType                derivativeFactor = 2.0 / this->m_ValidRegionVolume;
+  AnalyticThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric = this;
+  for( unsigned int k = 0; k < FixedImageDimension; ++k )
+  {
+    const CoefficientPixelType * coefficients
+      = bspline->GetCoefficientImages()[ k ]->GetBufferPointer();
+    std::fill( this->m_AnalyticResult.begin(), this->m_AnalyticResult.end(),
+      NumericTraits< CoefficientPixelType >::ZeroValue() );
+
+    for( unsigned int t = 0; t < this->m_AnalyticTerms.size(); ++t )
+    {
+      const AnalyticTermType & term = this->m_AnalyticTerms[ t ];
+      for( unsigned int d = 0; d < FixedImageDimension; ++d )
+      {
+        const bool lastPass = ( d == FixedImageDimension - 1 );
+        threaderParameters.st_Input = ( d == 0 )
+          ? coefficients : &this->m_AnalyticBuffers[ ( d - 1 ) % 2 ][ 0 ];
+        threaderParameters.st_Output = lastPass
+          ? &this->m_AnalyticResult[ 0 ] : &this->m_AnalyticBuffers[ d % 2 ][ 0 ];
+        threaderParameters.st_Dimension  = d;
+        threaderParameters.st_Order      = term.st_Orders[ d ];
+        threaderParameters.st_Weight     = lastPass ? term.st_Weight : NumericTraits< RealType >::One;
+        threaderParameters.st_Accumulate = lastPass;
+        this->LaunchAnalyticPass( threaderParameters );
+      }
+    }
+
+    for( SizeValueType v = 0; v < numberOfCoefficients; ++v )
+    {
+      measure += coefficients[ v ] * this->m_AnalyticResult[ v ];
+    }
+
+    if( derivative != NULL )
+    {
+      const SizeValueType offset = k * numberOfCoefficients;
+      for( SizeValueType v = 0; v < numberOfCoefficients; ++v )
+      {
+        ( *derivative )[ offset + v ] = derivativeFactor * this->m_AnalyticResult[ v ];
+      }
+    }
+  }
+
+  /** Divide by the volume of the valid region, analogous to the sample mean. */
+  value = static_cast< MeasureType >( measure / this->m_ValidRegionVolume );
+  return true;
+
+} // end ComputeAnalyticValueAndDerivative()
+
+
+/**
+ * ******************* InitializeAnalyticStencils *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::InitializeAnalyticStencils( const BSplineOrder3TransformType * bspline ) const
+{
+  /** Get the B-spline grid size and spacing. */
+  const CoefficientImageType * coefficientImage = bspline->GetCoefficientImages()[ 0 ];
+  const CoefficientImageSizeType size
+    = coefficientImage->GetLargestPossibleRegion().GetSize();
+  const CoefficientImageSpacingType spacing = coefficientImage->GetSpacing();
+
+  /** Nothing has to be done if the grid did not change. */
+  if( this->m_AnalyticStencilsAreInitialized
+    && size == this->m_AnalyticStencilsSize
+    && spacing == this->m_AnalyticStencilsSpacing )
+  {
+    return;
+  }
+
+  /** The B-spline kernel and its first and second order derivative. */
+  BSplineKernelFunction2< 3 >::Pointer kernel0
+    = BSplineKernelFunction2< 3 >::New();
+  BSplineDerivativeKernelFunction2< 3 >::Pointer kernel1
+    = BSplineDerivativeKernelFunction2< 3 >::New();
+  BSplineSecondOrderDerivativeKernelFunction2< 3 >::Pointer kernel2
+    = BSplineSecondOrderDerivativeKernelFunction2< 3 >::New();
+
+  /** On a grid interval a product of two kernels is a polynomial of degree
+   * at most 6, which the 4-point Gauss-Legendre rule integrates exactly.
+   * The points and weights are given for the interval [0,1].
+   */
+  const double gaussPoints[ 4 ] = {
+    0.0694318442029737, 0.3300094782075719, 0.6699905217924281, 0.9305681557970263
+  };
+  const double gaussWeights[ 4 ] = {
+    0.1739274225687269, 0.3260725774312731, 0.3260725774312731, 0.1739274225687269
+  };
+
+  /** Entry (i,j) of the stencil matrix of dimension d and order o is the
+   * integral of the products of the o-th derivatives of the kernels of
+   * coefficients i and j, over the valid region [1, size-2] of the continuous
+   * index, see AdvancedBSplineDeformableTransform. The factor spacing^(1-2o)
+   * converts it to physical units.
+   */
+  this->m_AnalyticStencils.assign( 3 * FixedImageDimension, StencilMatrixType() );
+  this->m_NumberOfCoefficients = 1;
+  this->m_ValidRegionVolume    = NumericTraits< RealType >::One;
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    const SizeValueType n = size[ d ];
+    if( n < 4 )
+    {
+      itkExceptionMacro( << "ERROR: The B-spline grid is too small to compute the analytic bending energy." );
+    }
+    this->m_NumberOfCoefficients *= n;
+    this->m_ValidRegionVolume    *= static_cast< RealType >( n - 3 ) * spacing[ d ];
+
+    for( unsigned int o = 0; o < 3; ++o )
+    {
+      StencilRowType zeroRow;
+      zeroRow.Fill( NumericTraits< CoefficientPixelType >::ZeroValue() );
+      StencilMatrixType & stencil = this->m_AnalyticStencils[ 3 * d + o ];
+      stencil.assign( n, zeroRow );
+
+      const double scale = vcl_pow( static_cast< double >( spacing[ d ] ), 1.0 - 2.0 * o );
+      for( SizeValueType m = 1; m + 2 < n; ++m )
+      {
+        for( unsigned int q = 0; q < 4; ++q )
+        {
+          /** The coefficients m-1, ..., m+2 are nonzero on interval m. */
+          double values[ 4 ];
+          for( unsigned int i = 0; i < 4; ++i )
+          {
+            const double u = gaussPoints[ q ] + 1.0 - static_cast< double >( i );
+            values[ i ] = ( o == 0 ) ? kernel0->Evaluate( u )
+              : ( ( o == 1 ) ? kernel1->Evaluate( u ) : kernel2->Evaluate( u ) );
+          }
+
+          for( unsigned int i = 0; i < 4; ++i )
+          {
+            for( unsigned int j = 0; j < 4; ++j )
+            {
+              stencil[ m - 1 + i ][ j - i + 3 ]
+                += scale * gaussWeights[ q ] * values[ i ] * values[ j ];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  /** The terms of sum_i sum_j ( d^2 T / dx_i dx_j )^2. The mixed derivatives
+   * with i != j occur twice.
+   */
+  this->m_AnalyticTerms.clear();
+  for( unsigned int i = 0; i < FixedImageDimension; ++i )
+  {
+    for( unsigned int j = i; j < FixedImageDimension; ++j )
+    {
+      AnalyticTermType term;
+      for( unsigned int d = 0; d < FixedImageDimension; ++d )
+      {
+        term.st_Orders[ d ] = ( d == i ? 1 : 0 ) + ( d == j ? 1 : 0 );
+      }
+      term.st_Weight = ( i == j ) ? 1.0 : 2.0;
+      this->m_AnalyticTerms.push_back( term );
+    }
+  }
+
+  /** Allocate the buffers. */
+  this->m_AnalyticBuffers[ 0 ].resize( this->m_NumberOfCoefficients );
+  this->m_AnalyticBuffers[ 1 ].resize( this->m_NumberOfCoefficients );
+  this->m_AnalyticResult.resize( this->m_NumberOfCoefficients );
+
+  this->m_AnalyticStencilsSize           = size;
+  this->m_AnalyticStencilsSpacing        = spacing;
+  this->m_AnalyticStencilsAreInitialized = true;
+
+} // end InitializeAnalyticStencils()
+
+
+/**
+ * ******************* LaunchAnalyticPass *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::LaunchAnalyticPass( AnalyticThreaderParameterType & parameters ) const
+{
+  if( !this->m_UseMultiThread )
+  {
+    this->ThreadedAnalyticPass( parameters, 0, 1 );
+    return;
+  }
+
+  this->ExecuteThreaderCallback( this->AnalyticPassThreaderCallback,
+    static_cast< void * >( &parameters ) );
+
+} // end LaunchAnalyticPass()
+
+
+/**
+ * ******************* AnalyticPassThreaderCallback *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+ITK_THREAD_RETURN_TYPE
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::AnalyticPassThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct      = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID        = infoStruct->ThreadID;
+  ThreadIdType     numberOfThreads = infoStruct->NumberOfThreads;
+
+  AnalyticThreaderParameterType * temp
+    = static_cast< AnalyticThreaderParameterType * >( infoStruct->UserData );
+
+  temp->st_Metric->ThreadedAnalyticPass( *temp, threadID, numberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AnalyticPassThreaderCallback()
+
+
+/**
+ * ******************* ThreadedAnalyticPass *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::ThreadedAnalyticPass( const AnalyticThreaderParameterType & parameters,
+  const ThreadIdType threadID, const ThreadIdType numberOfThreads ) const
+{
+  /** Get the slab of voxels of this thread. */
+  const SizeValueType numberOfCoefficients = this->m_NumberOfCoefficients;
+  const SizeValueType nrOfVoxelsPerThread
+    = static_cast< SizeValueType >( vcl_ceil( static_cast< double >( numberOfCoefficients )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  SizeValueType pos_begin = nrOfVoxelsPerThread * threadID;
+  SizeValueType pos_end   = nrOfVoxelsPerThread * ( threadID + 1 );
+  pos_begin = ( pos_begin > numberOfCoefficients ) ? numberOfCoefficients : pos_begin;
+  pos_end   = ( pos_end > numberOfCoefficients ) ? numberOfCoefficients : pos_end;
+
+  /** Get the stencil, and the layout of the grid along the filtered dimension. */
+  const unsigned int        dimension = parameters.st_Dimension;
+  const StencilMatrixType & stencil
+    = this->m_AnalyticStencils[ 3 * dimension + parameters.st_Order ];
+  const OffsetValueType size = static_cast< OffsetValueType >( this->m_AnalyticStencilsSize[ dimension ] );
+  OffsetValueType       stride = 1;
+  for( unsigned int d = 0; d < dimension; ++d )
+  {
+    stride *= static_cast< OffsetValueType >( this->m_AnalyticStencilsSize[ d ] );
+  }
+
+  /** Apply the stencil, skipping the neighbours outside the grid. */
+  const CoefficientPixelType * input  = parameters.st_Input;
+  CoefficientPixelType *       output = parameters.st_Output;
+  for( SizeValueType v = pos_begin; v < pos_end; ++v )
+  {
+    const OffsetValueType  a   = ( static_cast< OffsetValueType >( v ) / stride ) % size;
+    const StencilRowType & row = stencil[ a ];
+    const OffsetValueType  lo  = ( a < 3 ) ? -a : -3;
+    const OffsetValueType  hi  = ( size - 1 - a < 3 ) ? size - 1 - a : 3;
+
+    RealType sum = NumericTraits< RealType >::Zero;
+    for( OffsetValueType o = lo; o <= hi; ++o )
+    {
+      sum += row[ o + 3 ] * input[ static_cast< OffsetValueType >( v ) + o * stride ];
+    }
+
+    if( parameters.st_Accumulate )
+    {
+      output[ v ] += static_cast< CoefficientPixelType >( parameters.st_Weight * sum );
+    }
+    else
+    {
+      output[ v ] = static_cast< CoefficientPixelType >( sum );
+    }
+  }
+
+} // end ThreadedAnalyticPass()
+
+
 } // end namespace itk
 
 #endif // #ifndef __itkTransformBendingEnergyPenaltyTerm_hxx
@@ -71,6 +71,11 @@ public:
   virtual void Search( const MeasurementVectorType & qp, IndexArrayType & ind,
     DistanceArrayType & dists ) = 0;
 
+  /** Whether Search() may be called from several threads simultaneously.
+   * The ANN searchers use global variables, so by default it may not.
+   */
+  virtual bool IsThreadSafe( void ) const { return false; }
+
 protected:
 
   BinaryTreeSearchBase();
@@ -0,0 +1,176 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFlatKDTree_h
+#define __itkFlatKDTree_h
+
+#include "itkBinaryTreeBase.h"
+#include <ANN/ANN.h>  // ANN_ALLOW_SELF_MATCH
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class FlatKDTree
+ *
+ * \brief A kd-tree stored implicitly in flat arrays.
+ *
+ * The points are reordered such that every node of the tree is a
+ * contiguous range of points, with the splitting point in the middle of
+ * the range. A copy of the coordinates is stored in this order, which
+ * keeps the points of a subtree close together in memory. Nodes with at
+ * most BucketSize points are not split.
+ *
+ * Unlike the ANN trees, which use global variables during a search,
+ * SearchKNearestNeighbors() does not modify the tree, so it can be called
+ * from several threads simultaneously.
+ *
+ * \ingroup ANNwrap
+ */
+
+template< class TListSample >
+class FlatKDTree : public BinaryTreeBase< TListSample >
+{
+public:
+
+  /** Standard itk. */
+  typedef FlatKDTree                    Self;
+  typedef BinaryTreeBase< TListSample > Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  /** New method for creating an object using a factory. */
+  itkNewMacro( Self );
+
+  /** ITK type info. */
+  itkTypeMacro( FlatKDTree, BinaryTreeBase );
+
+  /** Typedef's from Superclass. */
+  typedef typename Superclass::SampleType                 SampleType;
+  typedef typename Superclass::MeasurementVectorType      MeasurementVectorType;
+  typedef typename Superclass::MeasurementVectorSizeType  MeasurementVectorSizeType;
+  typedef typename Superclass::TotalAbsoluteFrequencyType TotalAbsoluteFrequencyType;
+
+  /** Typedef's. */
+  typedef unsigned int BucketSizeType;
+
+  /** Set and get the bucket size: the maximum number of points in a leaf. */
+  itkSetClampMacro( BucketSize, BucketSizeType, 1, NumericTraits< BucketSizeType >::max() );
+  itkGetConstMacro( BucketSize, BucketSizeType );
+
+  /** Generate the tree. */
+  virtual void GenerateTree( void );
+
+  /** Search the k nearest neighbours of the query point qp, which has
+   * GetDataDimension() coordinates. The indices of the neighbours and their
+   * squared distances to qp are stored in ind and dists, which must have
+   * room for k elements, in order of increasing distance. If the tree has
+   * less than k points, the remaining indices are -1. With a positive error
+   * bound eps, the i-th neighbour found is at most a factor (1 + eps) further
+   * away than the true i-th nearest neighbour, as in ANN. Also as in ANN,
+   * points at zero distance from qp are skipped, unless ANN_ALLOW_SELF_MATCH
+   * is true.
+   */
+  void SearchKNearestNeighbors( const double * qp, const unsigned int k,
+    const double eps, int * ind, double * dists ) const;
+
+protected:
+
+  /** Constructor. */
+  FlatKDTree();
+
+  /** Destructor. */
+  virtual ~FlatKDTree() {}
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  FlatKDTree( const Self & );       // purposely not implemented
+  void operator=( const Self & );   // purposely not implemented
+
+  /** Compares two points, given by their original index, by one coordinate. */
+  class CoordinateCompare
+  {
+public:
+
+    CoordinateCompare( const double * const * data, const unsigned int dimension ) :
+      m_Data( data ), m_Dimension( dimension ) {}
+
+    bool operator()( const int a, const int b ) const
+    {
+      return this->m_Data[ a ][ this->m_Dimension ] < this->m_Data[ b ][ this->m_Dimension ];
+    }
+
+
+private:
+
+    const double * const * m_Data;
+    unsigned int           m_Dimension;
+  };
+
+  /** The state of a search, which is passed through the recursion. */
+  struct SearchStateType
+  {
+    const double * st_Query;
+    unsigned int   st_K;
+    unsigned int   st_NumberFound;
+    double         st_ErrorFactor;
+    int *          st_Indices;
+    double *       st_Distances;
+  };
+
+  /** Split the points in [begin, end) and recursively their two halves. */
+  void BuildNode( const unsigned long begin, const unsigned long end,
+    const double * const * data );
+
+  /** Search the node containing the points in [begin, end). */
+  void SearchNode( const unsigned long begin, const unsigned long end,
+    SearchStateType & state ) const;
+
+  /** Add point p to the sorted list of neighbours, if it is close enough. */
+  void AddCandidate( const unsigned long p, SearchStateType & state ) const;
+
+  /** Member variables. */
+  BucketSizeType m_BucketSize;
+
+  /** The bucket size and the dimension with which the tree was generated. */
+  BucketSizeType m_LeafSize;
+  unsigned int   m_Dimension;
+
+  /** The original index of each point, in tree order. */
+  std::vector< int > m_PointIndices;
+
+  /** The coordinates of the points, in tree order. */
+  std::vector< double > m_Points;
+
+  /** The splitting dimension of the node whose middle point is p,
+   * for each point p in tree order.
+   */
+  std::vector< unsigned int > m_SplitDimensions;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFlatKDTree.hxx"
+#endif
+
+#endif // end #ifndef __itkFlatKDTree_h
@@ -0,0 +1,292 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFlatKDTree_hxx
+#define __itkFlatKDTree_hxx
+
+#include "itkFlatKDTree.h"
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * ************************ Constructor *************************
+ */
+
+template< class TListSample >
+FlatKDTree< TListSample >
+::FlatKDTree()
+{
+  this->m_BucketSize = 8;
+  this->m_LeafSize   = 8;
+  this->m_Dimension  = 0;
+
+} // end Constructor()
+
+
+/**
+ * ************************ GenerateTree *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::GenerateTree( void )
+{
+  const unsigned long numberOfPoints
+    = static_cast< unsigned long >( this->GetActualNumberOfDataPoints() );
+  this->m_Dimension = static_cast< unsigned int >( this->GetDataDimension() );
+  this->m_LeafSize  = this->m_BucketSize;
+
+  this->m_PointIndices.resize( numberOfPoints );
+  this->m_SplitDimensions.assign( numberOfPoints, 0 );
+  this->m_Points.resize( numberOfPoints * this->m_Dimension );
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  /** Reorder the points into the tree. */
+  const double * const * data = this->GetSample()->GetInternalContainer();
+  for( unsigned long p = 0; p < numberOfPoints; ++p )
+  {
+    this->m_PointIndices[ p ] = static_cast< int >( p );
+  }
+  this->BuildNode( 0, numberOfPoints, data );
+
+  /** Copy the coordinates in tree order. */
+  for( unsigned long p = 0; p < numberOfPoints; ++p )
+  {
+    const double * point = data[ this->m_PointIndices[ p ] ];
+    std::copy( point, point + this->m_Dimension,
+      this->m_Points.begin() + p * this->m_Dimension );
+  }
+
+} // end GenerateTree()
+
+
+/**
+ * ************************ BuildNode *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::BuildNode( const unsigned long begin, const unsigned long end,
+  const double * const * data )
+{
+  if( end - begin <= this->m_LeafSize )
+  {
+    return;
+  }
+
+  /** Split along the dimension in which the points are spread the most. */
+  unsigned int splitDimension = 0;
+  double       maxSpread      = -1.0;
+  for( unsigned int d = 0; d < this->m_Dimension; ++d )
+  {
+    double minValue = data[ this->m_PointIndices[ begin ] ][ d ];
+    double maxValue = minValue;
+    for( unsigned long p = begin + 1; p < end; ++p )
+    {
+      const double value = data[ this->m_PointIndices[ p ] ][ d ];
+      minValue = std::min( minValue, value );
+      maxValue = std::max( maxValue, value );
+    }
+    if( maxValue - minValue > maxSpread )
+    {
+      maxSpread      = maxValue - minValue;
+      splitDimension = d;
+    }
+  }
+
+  /** Put the median in the middle, with the smaller points before it. */
+  const unsigned long middle = begin + ( end - begin ) / 2;
+  int *               indices = &this->m_PointIndices[ 0 ];
+  std::nth_element( indices + begin, indices + middle, indices + end,
+    CoordinateCompare( data, splitDimension ) );
+  this->m_SplitDimensions[ middle ] = splitDimension;
+
+  this->BuildNode( begin, middle, data );
+  this->BuildNode( middle + 1, end, data );
+
+} // end BuildNode()
+
+
+/**
+ * ************************ SearchKNearestNeighbors *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::SearchKNearestNeighbors( const double * qp, const unsigned int k,
+  const double eps, int * ind, double * dists ) const
+{
+  for( unsigned int i = 0; i < k; ++i )
+  {
+    ind[ i ]   = -1;
+    dists[ i ] = NumericTraits< double >::max();
+  }
+
+  const unsigned long numberOfPoints = this->m_PointIndices.size();
+  if( k == 0 || numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  SearchStateType state;
+  state.st_Query       = qp;
+  state.st_K           = k;
+  state.st_NumberFound = 0;
+  state.st_ErrorFactor = ( 1.0 + eps ) * ( 1.0 + eps );
+  state.st_Indices     = ind;
+  state.st_Distances   = dists;
+  this->SearchNode( 0, numberOfPoints, state );
+
+} // end SearchKNearestNeighbors()
+
+
+/**
+ * ************************ SearchNode *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::SearchNode( const unsigned long begin, const unsigned long end,
+  SearchStateType & state ) const
+{
+  /** Check all points of a leaf. */
+  if( end - begin <= this->m_LeafSize )
+  {
+    for( unsigned long p = begin; p < end; ++p )
+    {
+      this->AddCandidate( p, state );
+    }
+    return;
+  }
+
+  /** Check the splitting point, and first search the half containing the
+   * query point. The other half is only searched if it may contain a point
+   * that is closer than the current k-th neighbour.
+   */
+  const unsigned long middle    = begin + ( end - begin ) / 2;
+  const unsigned int  dimension = this->m_SplitDimensions[ middle ];
+  const double        diff
+    = state.st_Query[ dimension ] - this->m_Points[ middle * this->m_Dimension + dimension ];
+  this->AddCandidate( middle, state );
+
+  const bool queryIsLeft = diff < 0.0;
+  if( queryIsLeft )
+  {
+    this->SearchNode( begin, middle, state );
+  }
+  else
+  {
+    this->SearchNode( middle + 1, end, state );
+  }
+
+  if( state.st_NumberFound < state.st_K
+    || diff * diff * state.st_ErrorFactor < state.st_Distances[ state.st_K - 1 ] )
+  {
+    if( queryIsLeft )
+    {
+      this->SearchNode( middle + 1, end, state );
+    }
+    else
+    {
+      this->SearchNode( begin, middle, state );
+    }
+  }
+
+} // end SearchNode()
+
+
+/**
+ * ************************ AddCandidate *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::AddCandidate( const unsigned long p, SearchStateType & state ) const
+{
+  /** Compute the squared distance to the query point. */
+  const double * point    = &this->m_Points[ p * this->m_Dimension ];
+  double         distance = 0.0;
+  for( unsigned int d = 0; d < this->m_Dimension; ++d )
+  {
+    const double diff = state.st_Query[ d ] - point[ d ];
+    distance += diff * diff;
+  }
+
+  /** Skip the query point itself and its duplicates, like ANN does. */
+  if( distance == 0.0 && !ANN_ALLOW_SELF_MATCH )
+  {
+    return;
+  }
+
+  /** Insert it into the sorted list of neighbours. */
+  const unsigned int k = state.st_K;
+  if( state.st_NumberFound == k && distance >= state.st_Distances[ k - 1 ] )
+  {
+    return;
+  }
+
+  unsigned int i = state.st_NumberFound;
+  if( i < k )
+  {
+    ++state.st_NumberFound;
+  }
+  else
+  {
+    i = k - 1;
+  }
+
+  while( i > 0 && state.st_Distances[ i - 1 ] > distance )
+  {
+    state.st_Distances[ i ] = state.st_Distances[ i - 1 ];
+    state.st_Indices[ i ]   = state.st_Indices[ i - 1 ];
+    --i;
+  }
+  state.st_Distances[ i ] = distance;
+  state.st_Indices[ i ]   = this->m_PointIndices[ p ];
+
+} // end AddCandidate()
+
+
+/**
+ * ************************ PrintSelf *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "BucketSize: " << this->m_BucketSize << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkFlatKDTree_hxx
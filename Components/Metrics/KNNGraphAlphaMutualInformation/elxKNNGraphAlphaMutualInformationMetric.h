@@ -37,7 +37,9 @@ namespace elastix
  *    Choose a value between 0.0 and 1.0. The default is 0.5.
  * \parameter TreeType: The type of the kNN binary tree. \n
  *    <tt>(TreeType "BDTree" "BruteForceTree")</tt> \n
- *    Choose one of { KDTree, BDTree, BruteForceTree }. \n
+ *    Choose one of { KDTree, BDTree, BruteForceTree, FlatKDTree }. \n
+ *    The first three use the ANN library, which does not allow searching in parallel.
+ *    The FlatKDTree is thread safe, so that the neighbours are searched multi-threaded. \n
  *    The default is "KDTree" for all resolutions.
  * \parameter BucketSize: The maximum number of samples in one bucket. \n
  *    This parameter influences the calculation time only, and is not appropiate for the BruteForceTree. \n
@@ -54,6 +56,7 @@ namespace elastix
  * \parameter TreeSearchType: The type of the binary tree searcher. \n
  *    <tt>(TreeSearchType "Standard" "FixedRadius")</tt> \n
  *    Choose one of { Standard, FixedRadius, Priority } \n
+ *    The FlatKDTree only supports "Standard". \n
  *    The default is "Standard" for all resolutions.
  * \parameter KNearestNeighbours: The number of nearest neighbours to be searched. \n
  *    <tt>(KNearestNeighbours 50 20 35)</tt> \n
@@ -101,6 +101,11 @@ KNNGraphAlphaMutualInformationMetric< TElastix >
     silentSplit  = true;
     silentShrink = true;
   }
+  else if( treeType == "FlatKDTree" )
+  {
+    silentSplit  = true;
+    silentShrink = true;
+  }
 
   /** Get the bucket size. */
   unsigned int bucketSize = 50;
@@ -179,6 +184,10 @@ KNNGraphAlphaMutualInformationMetric< TElastix >
   {
     this->SetANNBruteForceTree();
   }
+  else if( treeType == "FlatKDTree" )
+  {
+    this->SetFlatKDTree( bucketSize );
+  }
   else
   {
     itkExceptionMacro( << "ERROR: there is no tree type \""
@@ -217,8 +226,16 @@ KNNGraphAlphaMutualInformationMetric< TElastix >
   this->m_Configuration->ReadParameter( squaredSearchRadius,
     "SquaredSearchRadius", level, true );
 
-  /** Set the tree searcher. */
-  if( treeSearchType == "Standard" )
+  /** Set the tree searcher. The FlatKDTree has its own searcher. */
+  if( treeType == "FlatKDTree" )
+  {
+    if( treeSearchType != "Standard" )
+    {
+      itkExceptionMacro( << "ERROR: the FlatKDTree only supports the tree searcher type \"Standard\"." );
+    }
+    this->SetFlatKDTreeSearch( kNearestNeighbours, errorBound );
+  }
+  else if( treeSearchType == "Standard" )
   {
     this->SetANNStandardTreeSearch( kNearestNeighbours, errorBound );
   }
@@ -31,11 +31,13 @@
 #include "itkANNkDTree.h"
 #include "itkANNbdTree.h"
 #include "itkANNBruteForceTree.h"
+#include "itkFlatKDTree.h"
 
 /** Supported tree searchers. */
 #include "itkANNStandardTreeSearch.h"
 #include "itkANNFixedRadiusTreeSearch.h"
 #include "itkANNPriorityTreeSearch.h"
+#include "itkFlatKDTreeSearch.h"
 
 /** Include for the spatial derivatives. */
 #include "itkArray2D.h"
@@ -61,6 +63,14 @@ namespace itk
  * features, it would be better (but slower) to first apply the transform
  * on the image and then recalculate the feature.
  *
+ * The fixed feature vectors do not depend on the transform. Therefore the
+ * tree of the fixed samples is only generated again when these vectors
+ * change, e.g. when the image sampler selects new samples.
+ * The nearest neighbours of the samples are searched in parallel if the
+ * searchers are thread safe, which is the case for the FlatKDTreeSearch.
+ * The ANN searchers use global variables, so with those the search is
+ * single-threaded.
+ *
  * All the technical details can be found in:\n
  * M. Staring, U.A. van der Heide, S. Klein, M.A. Viergever and J.P.W. Pluim,
  * "Registration of Cervical MRI Using Multifeature Mutual Information,"
@@ -161,6 +171,7 @@ public:
   typedef ANNkDTree< ListSampleType >         ANNkDTreeType;
   typedef ANNbdTree< ListSampleType >         ANNbdTreeType;
   typedef ANNBruteForceTree< ListSampleType > ANNBruteForceTreeType;
+  typedef FlatKDTree< ListSampleType >        FlatKDTreeType;
 
   /** Typedefs for tree searchers. */
   typedef BinaryTreeSearchBase< ListSampleType >     BinaryKNNTreeSearchType;
@@ -168,6 +179,7 @@ public:
   typedef ANNStandardTreeSearch< ListSampleType >    ANNStandardTreeSearchType;
   typedef ANNFixedRadiusTreeSearch< ListSampleType > ANNFixedRadiusTreeSearchType;
   typedef ANNPriorityTreeSearch< ListSampleType >    ANNPriorityTreeSearchType;
+  typedef FlatKDTreeSearch< ListSampleType >         FlatKDTreeSearchType;
 
   typedef typename BinaryKNNTreeSearchType::IndexArrayType    IndexArrayType;
   typedef typename BinaryKNNTreeSearchType::DistanceArrayType DistanceArrayType;
@@ -177,7 +189,7 @@ public:
 
   /**
    * *** Set trees: ***
-   * Currently kd, bd, and brute force trees are supported.
+   * Currently kd, bd, brute force and flat kd trees are supported.
    */
 
   /** Set ANNkDTree. */
@@ -200,9 +212,13 @@ public:
   /** Set ANNBruteForceTree. */
   void SetANNBruteForceTree( void );
 
+  /** Set FlatKDTree. */
+  void SetFlatKDTree( unsigned int bucketSize );
+
   /**
    * *** Set tree searchers: ***
-   * Currently standard, fixed radius, and priority tree searchers are supported.
+   * Currently standard, fixed radius, and priority tree searchers are
+   * supported for the ANN trees, and a standard searcher for the flat kd tree.
    */
 
   /** Set ANNStandardTreeSearch. */
@@ -217,6 +233,10 @@ public:
   void SetANNPriorityTreeSearch( unsigned int kNearestNeighbors,
     double errorBound );
 
+  /** Set FlatKDTreeSearch. */
+  void SetFlatKDTreeSearch( unsigned int kNearestNeighbors,
+    double errorBound );
+
   /**
    * *** Standard metric stuff: ***
    */
@@ -285,6 +305,34 @@ private:
   typedef std::vector< NonZeroJacobianIndicesType > TransformJacobianIndicesContainerType;
   typedef Array2D< double >                         SpatialDerivativeType;
   typedef std::vector< SpatialDerivativeType >      SpatialDerivativeContainerType;
+  typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
+  typedef typename Superclass::ThreadInfoType                   ThreadInfoType;
+
+  /** The data that is shared by the threads that search the nearest
+   * neighbours of the samples and compute the graph lengths.
+   */
+  struct KNNGraphThreaderParameterType
+  {
+    const Self *                                  st_Metric;
+    const ListSampleType *                        st_ListSampleFixed;
+    const ListSampleType *                        st_ListSampleMoving;
+    const ListSampleType *                        st_ListSampleJoint;
+    bool                                          st_DoDerivative;
+    double                                        st_TwoGamma;
+    const TransformJacobianContainerType *        st_Jacobians;
+    const TransformJacobianIndicesContainerType * st_JacobiansIndices;
+    const SpatialDerivativeContainerType *        st_SpatialDerivatives;
+  };
+
+  /** The results of each thread, and its work space. */
+  struct KNNGraphPerThreadStruct
+  {
+    AccumulateType st_SumG;
+    DerivativeType st_Contribution;
+    DerivativeType st_DerivativeOfGammaM;
+    DerivativeType st_DerivativeOfGammaJ;
+  };
+  mutable std::vector< KNNGraphPerThreadStruct > m_KNNGraphPerThreadVariables;
 
   /** This function takes the fixed image samples from the ImageSampler
    * and puts them in the listSampleFixed, together with the fixed feature
@@ -306,6 +354,30 @@ private:
     TransformJacobianIndicesContainerType & jacobiansIndices,
     SpatialDerivativeContainerType & spatialDerivatives ) const;
 
+  /** Generate the trees of the three list samples, and connect them to
+   * the searchers. The fixed tree is reused if it is up to date.
+   */
+  void GenerateTrees(
+    const ListSamplePointer & listSampleFixed,
+    const ListSamplePointer & listSampleMoving,
+    const ListSamplePointer & listSampleJoint ) const;
+
+  /** Check if the fixed tree was generated from the same feature vectors. */
+  bool FixedTreeIsUpToDate( const ListSamplePointer & listSampleFixed ) const;
+
+  /** Search the nearest neighbours of all samples and sum the graph lengths,
+   * using multiple threads if the searchers allow it. The contribution to
+   * the derivative is only computed if st_DoDerivative is true.
+   */
+  void ComputeGraphLengths( KNNGraphThreaderParameterType & parameters,
+    AccumulateType & sumG, DerivativeType & contribution ) const;
+
+  static ITK_THREAD_RETURN_TYPE ComputeGraphLengthsThreaderCallback( void * arg );
+
+  /** Search the nearest neighbours of one slab of samples. */
+  void ThreadedComputeGraphLengths( const KNNGraphThreaderParameterType & parameters,
+    const ThreadIdType threadID, const ThreadIdType numberOfThreads ) const;
+
   /** This function calculates the spatial derivative of the
    * featureNr feature image at the point mappedPoint.
    * \todo move this to base class.
@@ -161,6 +161,30 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end SetANNBruteForceTree()
 
 
+/**
+ * ************************ SetFlatKDTree *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::SetFlatKDTree( unsigned int bucketSize )
+{
+  typename FlatKDTreeType::Pointer tmpPtrF = FlatKDTreeType::New();
+  typename FlatKDTreeType::Pointer tmpPtrM = FlatKDTreeType::New();
+  typename FlatKDTreeType::Pointer tmpPtrJ = FlatKDTreeType::New();
+
+  tmpPtrF->SetBucketSize( bucketSize );
+  tmpPtrM->SetBucketSize( bucketSize );
+  tmpPtrJ->SetBucketSize( bucketSize );
+
+  this->m_BinaryKNNTreeFixed  = tmpPtrF;
+  this->m_BinaryKNNTreeMoving = tmpPtrM;
+  this->m_BinaryKNNTreeJoint  = tmpPtrJ;
+
+} // end SetFlatKDTree()
+
+
 /**
  * ************************ SetANNStandardTreeSearch *************************
  */
@@ -265,6 +289,39 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end SetANNPriorityTreeSearch()
 
 
+/**
+ * ************************ SetFlatKDTreeSearch *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::SetFlatKDTreeSearch(
+  unsigned int kNearestNeighbors,
+  double errorBound )
+{
+  typename FlatKDTreeSearchType::Pointer tmpPtrF
+    = FlatKDTreeSearchType::New();
+  typename FlatKDTreeSearchType::Pointer tmpPtrM
+    = FlatKDTreeSearchType::New();
+  typename FlatKDTreeSearchType::Pointer tmpPtrJ
+    = FlatKDTreeSearchType::New();
+
+  tmpPtrF->SetKNearestNeighbors( kNearestNeighbors );
+  tmpPtrM->SetKNearestNeighbors( kNearestNeighbors );
+  tmpPtrJ->SetKNearestNeighbors( kNearestNeighbors );
+
+  tmpPtrF->SetErrorBound( errorBound );
+  tmpPtrM->SetErrorBound( errorBound );
+  tmpPtrJ->SetErrorBound( errorBound );
+
+  this->m_BinaryKNNTreeSearcherFixed  = tmpPtrF;
+  this->m_BinaryKNNTreeSearcherMoving = tmpPtrM;
+  this->m_BinaryKNNTreeSearcherJoint  = tmpPtrJ;
+
+} // end SetFlatKDTreeSearch()
+
+
 /**
  * ********************* Initialize *****************************
  */
@@ -336,25 +393,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed
-  ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
-  this->m_BinaryKNNTreeSearcherMoving
-  ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
-  this->m_BinaryKNNTreeSearcherJoint
-  ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+  this->GenerateTrees( listSampleFixed, listSampleMoving, listSampleJoint );
 
   /**
    * *************** Estimate the \alpha MI ******************
@@ -389,77 +428,28 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
-  MeasurementVectorType z_F, z_M, z_J;
-  IndexArrayType        indices_F, indices_M, indices_J;
-  DistanceArrayType     distances_F, distances_M, distances_J;
-
-  MeasureType    H, G;
-  AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
-
   /** Get the size of the feature vectors. */
   unsigned int fixedSize  = this->GetNumberOfFixedImages();
   unsigned int movingSize = this->GetNumberOfMovingImages();
   unsigned int jointSize  = fixedSize + movingSize;
 
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k        = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * ( 1.0 - this->m_Alpha );
-
-  /** Loop over all query points, i.e. all samples. */
-  for( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
-  {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(  i, z_F );
-    listSampleMoving->GetMeasurementVector( i, z_M );
-    listSampleJoint->GetMeasurementVector(  i, z_J );
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
-    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
-    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
-
-    /** Add the distances between the points to get the total graph length.
-     * The outcommented implementation calculates: sum J/sqrt(F*M)
-     *
-    for ( unsigned int j = 0; j < K; j++ )
-    {
-    enumerator = vcl_sqrt( distsJ[ j ] );
-    denominator = vcl_sqrt( vcl_sqrt( distsF[ j ] ) * vcl_sqrt( distsM[ j ] ) );
-    if ( denominator > 1e-14 )
-    {
-    contribution += vcl_pow( enumerator / denominator, twoGamma );
-    }
-    }*/
-
-    /** Add the distances of all neighbours of the query point,
-    * for the three graphs:
-    * sum M / sqrt( sum F * sum M)
-    */
-
-    /** Variables to compute the measure. */
-    AccumulateType Gamma_F = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_M = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_J = NumericTraits< AccumulateType >::Zero;
-
-    /** Loop over the neighbours. */
-    for( unsigned int p = 0; p < k; p++ )
-    {
-      Gamma_F += vcl_sqrt( distances_F[ p ] );
-      Gamma_M += vcl_sqrt( distances_M[ p ] );
-      Gamma_J += vcl_sqrt( distances_J[ p ] );
-    } // end loop over the k neighbours
+  /** Search the nearest neighbours of all query points, i.e. all samples,
+   * and sum their graph lengths.
+   */
+  KNNGraphThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric             = this;
+  threaderParameters.st_ListSampleFixed    = listSampleFixed.GetPointer();
+  threaderParameters.st_ListSampleMoving   = listSampleMoving.GetPointer();
+  threaderParameters.st_ListSampleJoint    = listSampleJoint.GetPointer();
+  threaderParameters.st_DoDerivative       = false;
+  threaderParameters.st_TwoGamma           = jointSize * ( 1.0 - this->m_Alpha );
+  threaderParameters.st_Jacobians          = NULL;
+  threaderParameters.st_JacobiansIndices   = NULL;
+  threaderParameters.st_SpatialDerivatives = NULL;
 
-    /** Calculate the contribution of this query point. */
-    H = vcl_sqrt( Gamma_F * Gamma_M );
-    if( H > this->m_AvoidDivisionBy )
-    {
-      /** Compute some sums. */
-      G     = Gamma_J / H;
-      sumG += vcl_pow( G, twoGamma );
-    }
-  } // end looping over all query points
+  AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
+  DerivativeType dummyContribution;
+  this->ComputeGraphLengths( threaderParameters, sumG, dummyContribution );
 
   /**
    * *************** Finally, calculate the metric value \alpha MI ******************
@@ -561,25 +551,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed
-  ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
-  this->m_BinaryKNNTreeSearcherMoving
-  ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
-  this->m_BinaryKNNTreeSearcherJoint
-  ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+  this->GenerateTrees( listSampleFixed, listSampleMoving, listSampleJoint );
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
@@ -614,8 +586,253 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
+  /** Get the size of the feature vectors. */
+  unsigned int fixedSize  = this->GetNumberOfFixedImages();
+  unsigned int movingSize = this->GetNumberOfMovingImages();
+  unsigned int jointSize  = fixedSize + movingSize;
+
+  /** Search the nearest neighbours of all query points, i.e. all samples,
+   * and sum their graph lengths and the contributions to the derivative.
+   */
+  KNNGraphThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric             = this;
+  threaderParameters.st_ListSampleFixed    = listSampleFixed.GetPointer();
+  threaderParameters.st_ListSampleMoving   = listSampleMoving.GetPointer();
+  threaderParameters.st_ListSampleJoint    = listSampleJoint.GetPointer();
+  threaderParameters.st_DoDerivative       = true;
+  threaderParameters.st_TwoGamma           = jointSize * ( 1.0 - this->m_Alpha );
+  threaderParameters.st_Jacobians          = &jacobianContainer;
+  threaderParameters.st_JacobiansIndices   = &jacobianIndicesContainer;
+  threaderParameters.st_SpatialDerivatives = &spatialDerivativesContainer;
+
+  AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
+  DerivativeType contribution( this->GetNumberOfParameters() );
+  contribution.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+  this->ComputeGraphLengths( threaderParameters, sumG, contribution );
+
+  /**
+   * *************** Finally, calculate the metric value and derivative ******************
+   */
+
+  /** Compute the value. */
+  double n, number;
+  if( sumG > this->m_AvoidDivisionBy )
+  {
+    /** Compute the measure. */
+    n       = static_cast< double >( this->m_NumberOfPixelsCounted );
+    number  = vcl_pow( n, this->m_Alpha );
+    measure = vcl_log( sumG / number ) / ( this->m_Alpha - 1.0 );
+
+    /** Compute the derivative (-2.0 * d = -jointSize). */
+    derivative = ( static_cast< AccumulateType >( jointSize ) / sumG ) * contribution;
+  }
+  value = -measure;
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ************************ GenerateTrees *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::GenerateTrees(
+  const ListSamplePointer & listSampleFixed,
+  const ListSamplePointer & listSampleMoving,
+  const ListSamplePointer & listSampleJoint ) const
+{
+  /** Generate the tree for the fixed image samples. The fixed feature
+   * vectors do not depend on the transform parameters, so the tree that
+   * was generated in a previous call can often be reused. It then keeps
+   * referring to the previous list sample, which holds the same vectors.
+   */
+  if( !this->FixedTreeIsUpToDate( listSampleFixed ) )
+  {
+    this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
+    this->m_BinaryKNNTreeFixed->GenerateTree();
+  }
+
+  /** Generate the tree for the moving image samples. */
+  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
+  this->m_BinaryKNNTreeMoving->GenerateTree();
+
+  /** Generate the tree for the joint image samples. */
+  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
+  this->m_BinaryKNNTreeJoint->GenerateTree();
+
+  /** Initialize tree searchers. */
+  this->m_BinaryKNNTreeSearcherFixed
+  ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
+  this->m_BinaryKNNTreeSearcherMoving
+  ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
+  this->m_BinaryKNNTreeSearcherJoint
+  ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+
+} // end GenerateTrees()
+
+
+/**
+ * ************************ FixedTreeIsUpToDate *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::FixedTreeIsUpToDate( const ListSamplePointer & listSampleFixed ) const
+{
+  /** A new tree, e.g. at the start of a resolution, has no samples yet. */
+  const ListSampleType * previousSample = this->m_BinaryKNNTreeFixed->GetSample();
+  if( previousSample == NULL )
+  {
+    return false;
+  }
+
+  /** Compare the sizes. */
+  const unsigned long numberOfSamples = listSampleFixed->GetActualSize();
+  const unsigned int  dimension       = listSampleFixed->GetMeasurementVectorSize();
+  if( this->m_BinaryKNNTreeFixed->GetActualNumberOfDataPoints() != numberOfSamples
+    || this->m_BinaryKNNTreeFixed->GetDataDimension() != dimension )
+  {
+    return false;
+  }
+
+  /** Compare the feature vectors. This is much cheaper than generating the tree. */
+  const double * const * previousData = previousSample->GetInternalContainer();
+  const double * const * currentData  = listSampleFixed->GetInternalContainer();
+  for( unsigned long i = 0; i < numberOfSamples; ++i )
+  {
+    for( unsigned int j = 0; j < dimension; ++j )
+    {
+      if( previousData[ i ][ j ] != currentData[ i ][ j ] )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+
+} // end FixedTreeIsUpToDate()
+
+
+/**
+ * ************************ ComputeGraphLengths *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeGraphLengths( KNNGraphThreaderParameterType & parameters,
+  AccumulateType & sumG, DerivativeType & contribution ) const
+{
+  /** The ANN searchers are not thread safe, so only search in parallel
+   * if all three searchers allow it.
+   */
+  const bool useMultiThread = this->m_UseMultiThread
+    && this->m_BinaryKNNTreeSearcherFixed->IsThreadSafe()
+    && this->m_BinaryKNNTreeSearcherMoving->IsThreadSafe()
+    && this->m_BinaryKNNTreeSearcherJoint->IsThreadSafe();
+  const ThreadIdType numberOfThreads
+    = useMultiThread ? this->m_Threader->GetNumberOfThreads() : 1;
+
+  /** Initialize the results and the work space of all threads. */
+  this->m_KNNGraphPerThreadVariables.resize( numberOfThreads );
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    KNNGraphPerThreadStruct & threadVariables = this->m_KNNGraphPerThreadVariables[ i ];
+    threadVariables.st_SumG = NumericTraits< AccumulateType >::Zero;
+    if( parameters.st_DoDerivative )
+    {
+      threadVariables.st_Contribution.SetSize( this->GetNumberOfParameters() );
+      threadVariables.st_Contribution.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+      threadVariables.st_DerivativeOfGammaM.SetSize( this->GetNumberOfParameters() );
+      threadVariables.st_DerivativeOfGammaJ.SetSize( this->GetNumberOfParameters() );
+    }
+  }
+
+  /** Search the nearest neighbours. */
+  if( useMultiThread )
+  {
+    this->ExecuteThreaderCallback( this->ComputeGraphLengthsThreaderCallback,
+      static_cast< void * >( &parameters ) );
+  }
+  else
+  {
+    this->ThreadedComputeGraphLengths( parameters, 0, 1 );
+  }
+
+  /** Gather the results of the threads, in a fixed order. */
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    sumG += this->m_KNNGraphPerThreadVariables[ i ].st_SumG;
+    if( parameters.st_DoDerivative )
+    {
+      contribution += this->m_KNNGraphPerThreadVariables[ i ].st_Contribution;
+    }
+  }
+
+} // end ComputeGraphLengths()
+
+
+/**
+ * ************************ ComputeGraphLengthsThreaderCallback *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeGraphLengthsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct      = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID        = infoStruct->ThreadID;
+  ThreadIdType     numberOfThreads = infoStruct->NumberOfThreads;
+
+  KNNGraphThreaderParameterType * temp
+    = static_cast< KNNGraphThreaderParameterType * >( infoStruct->UserData );
+
+  temp->st_Metric->ThreadedComputeGraphLengths( *temp, threadID, numberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeGraphLengthsThreaderCallback()
+
+
+/**
+ * ************************ ThreadedComputeGraphLengths *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedComputeGraphLengths( const KNNGraphThreaderParameterType & parameters,
+  const ThreadIdType threadID, const ThreadIdType numberOfThreads ) const
+{
+  /** Get the query points of this thread. */
+  const unsigned long numberOfSamples = this->m_NumberOfPixelsCounted;
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( numberOfSamples )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadID;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadID + 1 );
+  pos_begin = ( pos_begin > numberOfSamples ) ? numberOfSamples : pos_begin;
+  pos_end   = ( pos_end > numberOfSamples ) ? numberOfSamples : pos_end;
+
+  /** Get handles to the input, and to the results and work space of this thread. */
+  const ListSampleType * listSampleFixed  = parameters.st_ListSampleFixed;
+  const ListSampleType * listSampleMoving = parameters.st_ListSampleMoving;
+  const ListSampleType * listSampleJoint  = parameters.st_ListSampleJoint;
+  const bool             doDerivative     = parameters.st_DoDerivative;
+  const double           twoGamma         = parameters.st_TwoGamma;
+
+  KNNGraphPerThreadStruct & threadVariables = this->m_KNNGraphPerThreadVariables[ threadID ];
+  DerivativeType &          contribution    = threadVariables.st_Contribution;
+  DerivativeType &          dGamma_M        = threadVariables.st_DerivativeOfGammaM;
+  DerivativeType &          dGamma_J        = threadVariables.st_DerivativeOfGammaJ;
+
   /** Temporary variables. */
-  typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
   MeasurementVectorType z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
   IndexArrayType        indices_F,   indices_M,   indices_J;
   DistanceArrayType     distances_F, distances_M, distances_J;
@@ -624,22 +841,11 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   MeasureType    H, G, Gpow;
   AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
 
-  DerivativeType contribution( this->GetNumberOfParameters() );
-  contribution.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-  DerivativeType dGamma_M( this->GetNumberOfParameters() );
-  DerivativeType dGamma_J( this->GetNumberOfParameters() );
-
-  /** Get the size of the feature vectors. */
-  unsigned int fixedSize  = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize  = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k        = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * ( 1.0 - this->m_Alpha );
+  /** Get the number of neighbours. */
+  unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
 
-  /** Loop over all query points, i.e. all samples. */
-  for( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
+  /** Loop over the query points of this thread. */
+  for( unsigned long i = pos_begin; i < pos_end; i++ )
   {
     /** Get the i-th query point. */
     listSampleFixed->GetMeasurementVector(  i, z_F );
@@ -657,18 +863,17 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     AccumulateType Gamma_J = NumericTraits< AccumulateType >::Zero;
 
     SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
-    D1sparse = spatialDerivativesContainer[ i ] * jacobianContainer[ i ];
+    if( doDerivative )
+    {
+      D1sparse = ( *parameters.st_SpatialDerivatives )[ i ] * ( *parameters.st_Jacobians )[ i ];
 
-    dGamma_M.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-    dGamma_J.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+      dGamma_M.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+      dGamma_J.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+    }
 
     /** Loop over the neighbours. */
     for( unsigned int p = 0; p < k; p++ )
     {
-      /** Get the neighbour point z_ip^M. */
-      listSampleMoving->GetMeasurementVector( indices_M[ p ], z_M_ip );
-      listSampleMoving->GetMeasurementVector( indices_J[ p ], z_J_ip );
-
       /** Get the distances. */
       distance_F = vcl_sqrt( distances_F[ p ] );
       distance_M = vcl_sqrt( distances_M[ p ] );
@@ -679,22 +884,28 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
       Gamma_M += distance_M;
       Gamma_J += distance_J;
 
+      if( !doDerivative ) { continue; }
+
+      /** Get the neighbour point z_ip^M. */
+      listSampleMoving->GetMeasurementVector( indices_M[ p ], z_M_ip );
+      listSampleMoving->GetMeasurementVector( indices_J[ p ], z_J_ip );
+
       /** Get the difference of z_ip^M with z_i^M. */
       diff_M = z_M - z_M_ip;
       diff_J = z_M - z_J_ip;
 
       /** Compute derivatives. */
-      D2sparse_M = spatialDerivativesContainer[ indices_M[ p ] ]
-        * jacobianContainer[ indices_M[ p ] ];
-      D2sparse_J = spatialDerivativesContainer[ indices_J[ p ] ]
-        * jacobianContainer[ indices_J[ p ] ];
+      D2sparse_M = ( *parameters.st_SpatialDerivatives )[ indices_M[ p ] ]
+        * ( *parameters.st_Jacobians )[ indices_M[ p ] ];
+      D2sparse_J = ( *parameters.st_SpatialDerivatives )[ indices_J[ p ] ]
+        * ( *parameters.st_Jacobians )[ indices_J[ p ] ];
 
       /** Update the dGamma's. */
       this->UpdateDerivativeOfGammas(
         D1sparse, D2sparse_M, D2sparse_J,
-        jacobianIndicesContainer[ i ],
-        jacobianIndicesContainer[ indices_M[ p ] ],
-        jacobianIndicesContainer[ indices_J[ p ] ],
+        ( *parameters.st_JacobiansIndices )[ i ],
+        ( *parameters.st_JacobiansIndices )[ indices_M[ p ] ],
+        ( *parameters.st_JacobiansIndices )[ indices_J[ p ] ],
         diff_M, diff_J,
         distance_M, distance_J,
         dGamma_M, dGamma_J );
@@ -710,31 +921,19 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
       sumG += vcl_pow( G, twoGamma );
 
       /** Compute the contribution to the derivative. */
-      Gpow          = vcl_pow( G, twoGamma - 1.0 );
-      contribution += ( Gpow / H ) * ( dGamma_J - ( 0.5 * Gamma_J / Gamma_M ) * dGamma_M );
+      if( doDerivative )
+      {
+        Gpow          = vcl_pow( G, twoGamma - 1.0 );
+        contribution += ( Gpow / H ) * ( dGamma_J - ( 0.5 * Gamma_J / Gamma_M ) * dGamma_M );
+      }
     }
 
-  } // end looping over all query points
+  } // end looping over the query points
 
-  /**
-   * *************** Finally, calculate the metric value and derivative ******************
-   */
+  /** Only update this variable at the end to prevent unnecessary "false sharing". */
+  threadVariables.st_SumG = sumG;
 
-  /** Compute the value. */
-  double n, number;
-  if( sumG > this->m_AvoidDivisionBy )
-  {
-    /** Compute the measure. */
-    n       = static_cast< double >( this->m_NumberOfPixelsCounted );
-    number  = vcl_pow( n, this->m_Alpha );
-    measure = vcl_log( sumG / number ) / ( this->m_Alpha - 1.0 );
-
-    /** Compute the derivative (-2.0 * d = -jointSize). */
-    derivative = ( static_cast< AccumulateType >( jointSize ) / sumG ) * contribution;
-  }
-  value = -measure;
-
-} // end GetValueAndDerivative()
+} // end ThreadedComputeGraphLengths()
 
 
 /**
@@ -64,6 +64,21 @@ namespace elastix
  *    useful if you use high order B-spline interpolator for the moving image.\n
  *    example: <tt>(MovingLimitRangeRatio 0.001 0.01 0.01)</tt> \n
  *    The default value is 0.01. Can be given for each resolution, or for all resolutions at once.
+ * \parameter JointPDFAccumulationMethod: The way the joint histogram is accumulated
+ *    over the threads: "PerThreadCopy" (each thread fills a copy, which are summed
+ *    afterwards), "ParallelReduction" (as PerThreadCopy, but the copies are summed
+ *    in parallel), or "BinSharded" (no copies; each thread adds all samples to its own
+ *    range of fixed image bins). Can be given for each resolution, or for all
+ *    resolutions at once. \n
+ *    example: <tt>(JointPDFAccumulationMethod "BinSharded")</tt> \n
+ *    The default is "PerThreadCopy".
+ * \parameter UseSparsePDFDerivatives: Store the derivatives of the joint histogram
+ *    per sample, for the affected B-spline parameters only, instead of in a large 3D
+ *    matrix of size NumberOfFixedHistogramBins * NumberOfMovingHistogramBins * number
+ *    of parameters. Recommended for fine B-spline grids.
+ *    Can be given for each resolution, or for all resolutions at once. \n
+ *    example: <tt>(UseSparsePDFDerivatives "true")</tt> \n
+ *    The default is "false".
  *
  * \sa ParzenWindowNormalizedMutualInformationImageToImageMetric
  * \ingroup Metrics
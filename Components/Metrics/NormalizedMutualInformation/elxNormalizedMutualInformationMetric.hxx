@@ -102,6 +102,29 @@ NormalizedMutualInformationMetric< TElastix >
   this->SetFixedKernelBSplineOrder( fixedKernelBSplineOrder );
   this->SetMovingKernelBSplineOrder( movingKernelBSplineOrder );
 
+  /** Set the way the joint histogram is accumulated over the threads. */
+  std::string jointPDFAccumulationMethod = "PerThreadCopy";
+  this->GetConfiguration()->ReadParameter( jointPDFAccumulationMethod,
+    "JointPDFAccumulationMethod", this->GetComponentLabel(), level, 0, false );
+  if( jointPDFAccumulationMethod == "ParallelReduction" )
+  {
+    this->SetJointPDFAccumulationMethod( Superclass1::ParallelReduction );
+  }
+  else if( jointPDFAccumulationMethod == "BinSharded" )
+  {
+    this->SetJointPDFAccumulationMethod( Superclass1::BinSharded );
+  }
+  else
+  {
+    this->SetJointPDFAccumulationMethod( Superclass1::PerThreadCopy );
+  }
+
+  /** Set whether the pdf derivatives should be stored sparsely. */
+  bool useSparsePDFDerivatives = false;
+  this->GetConfiguration()->ReadParameter( useSparsePDFDerivatives,
+    "UseSparsePDFDerivatives", this->GetComponentLabel(), level, 0 );
+  this->SetUseSparsePDFDerivatives( useSparsePDFDerivatives );
+
 } // end BeforeEachResolution()
 
 
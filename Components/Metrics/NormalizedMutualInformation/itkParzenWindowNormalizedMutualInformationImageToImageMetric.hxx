@@ -219,6 +219,34 @@ ParzenWindowNormalizedMutualInformationImageToImageMetric< TFixedImage, TMovingI
    * -dNMI/dmu = - sum_k sum_i dhdmu(i,k) alpha*pRatio/Ej
    **/
 
+  /** With sparse pdf derivatives, compute alpha*pRatio for each bin, and
+   * contract these weights with the stored derivatives of the samples.
+   */
+  if( this->GetUseSparsePDFDerivatives() )
+  {
+    const unsigned long nrOfFixedBins  = this->GetNumberOfFixedHistogramBins();
+    const unsigned long nrOfMovingBins = this->GetNumberOfMovingHistogramBins();
+    const PDFValueType * jointPDFPtr   = this->m_JointPDF->GetBufferPointer();
+    std::vector< double > binWeights( nrOfFixedBins * nrOfMovingBins, 0.0 );
+    for( unsigned long f = 0; f < nrOfFixedBins; ++f )
+    {
+      const double logFixedImagePDFValue = this->m_FixedImageMarginalPDF[ f ];
+      for( unsigned long m = 0; m < nrOfMovingBins; ++m )
+      {
+        const unsigned long bin           = f * nrOfMovingBins + m;
+        const double        jointPDFValue = jointPDFPtr[ bin ];
+        if( jointPDFValue > 1e-16 )
+        {
+          const double pRatio = ( nMI * vcl_log( jointPDFValue )
+            - logFixedImagePDFValue - this->m_MovingImageMarginalPDF[ m ] ) / jointEntropy;
+          binWeights[ bin ] = this->m_Alpha * pRatio;
+        }
+      }
+    }
+    this->ContractSparseJointPDFDerivatives( &binWeights[ 0 ], derivative );
+    return;
+  }
+
   /** Typedefs for iterators */
   typedef ImageLinearConstIteratorWithIndex<
     JointPDFDerivativesType >                              JointPDFDerivativesConstIteratorType;
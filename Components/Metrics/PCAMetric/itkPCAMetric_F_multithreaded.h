@@ -179,6 +179,8 @@ protected:
     SizeValueType                      st_NumberOfPixelsCounted;
     MatrixType                         st_DataBlock;
     std::vector< FixedImagePointType > st_ApprovedSamples;
+    vnl_vector< RealType >             st_Mean;
+    MatrixType                         st_Scatter;
     DerivativeType                     st_Derivative;
   };
 
@@ -215,6 +217,17 @@ protected:
   /** Initialize some multi-threading related parameters. */
   virtual void InitializeThreadingParameters( void ) const;
 
+  /** Compute the NumEigenValues largest eigenvalues of the symmetric matrix K,
+   * and the corresponding eigenvectors. A subspace iteration is used, which
+   * is started from the eigenvectors of the previous call. Since K changes
+   * only a little between two iterations of the optimizer, this converges in
+   * a few iterations, which is much cheaper than the full eigendecomposition
+   * for long series. The full eigendecomposition is used in the first call,
+   * and when the subspace iteration does not converge.
+   */
+  void ComputeLargestEigenPairs( const MatrixType & K,
+    vnl_vector< RealType > & eigenValues, MatrixType & eigenVectors ) const;
+
 private:
 
   PCAMetric( const Self & );      // purposely not implemented
@@ -236,12 +249,19 @@ private:
   unsigned int m_NumEigenValues;
 
   /** Matrices, needed for derivative calculation */
-  mutable std::vector< unsigned int > m_PixelStartIndex;
-  mutable MatrixType                  m_Atmm;
-  mutable DerivativeMatrixType        m_vSAtmm;
-  mutable DerivativeMatrixType        m_CSv;
-  mutable DerivativeMatrixType        m_Sv;
-  mutable DerivativeMatrixType        m_vdSdmu_part1;
+  mutable vnl_vector< RealType > m_Mean;
+  mutable DerivativeMatrixType   m_vS;
+  mutable DerivativeMatrixType   m_CSv;
+  mutable DerivativeMatrixType   m_Sv;
+  mutable DerivativeMatrixType   m_vdSdmu_part1;
+
+  /** The eigenvectors of the previous call, used to start the subspace iteration. */
+  mutable MatrixType m_PreviousEigenVectors;
+
+  /** Orthonormalize the columns of Q with modified Gram-Schmidt.
+   * Returns false if the columns are (nearly) linearly dependent.
+   */
+  static bool OrthonormalizeColumns( MatrixType & Q );
 
 };
 
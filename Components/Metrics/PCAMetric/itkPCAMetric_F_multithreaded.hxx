@@ -27,6 +27,7 @@
 #include "vnl/vnl_trace.h"
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
 #include <numeric>
+#include <algorithm>
 #include <fstream>
 
 #ifdef ELASTIX_USE_OPENMP
@@ -92,6 +93,10 @@ PCAMetric< TFixedImage, TMovingImage >
     std::cerr << "ERROR: Number of eigenvalues is larger than number of images. Maximum number of eigenvalues equals: "
               << this->m_G << std::endl;
   }
+
+  /** The eigenvectors of a previous resolution are not used as a start. */
+  this->m_PreviousEigenVectors.clear();
+
 } // end Initializes
 
 
@@ -141,8 +146,6 @@ PCAMetric< TFixedImage, TMovingImage >
     this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_Derivative.SetSize( this->GetNumberOfParameters() );
   }
 
-  this->m_PixelStartIndex.resize( this->m_NumberOfThreads );
-
 } // end InitializeThreadingParameters()
 
 
@@ -322,14 +325,12 @@ PCAMetric< TFixedImage, TMovingImage >
   /** Compute correlation matrix K */
   MatrixType K( S * C * S );
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem< RealType > eig( K );
+  /** Compute the largest eigenvalues of K. */
+  vnl_vector< RealType > eigenValues;
+  MatrixType             eigenVectorMatrix;
+  this->ComputeLargestEigenPairs( K, eigenValues, eigenVectorMatrix );
 
-  RealType sumEigenValuesUsed = itk::NumericTraits< RealType >::Zero;
-  for( unsigned int i = 1; i < this->m_NumEigenValues + 1; i++ )
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue( this->m_G - i );
-  }
+  RealType sumEigenValuesUsed = eigenValues.sum();
 
   measure = this->m_G - sumEigenValuesUsed;
 
@@ -509,20 +510,12 @@ PCAMetric< TFixedImage, TMovingImage >
 
   MatrixType K( S * C * S );
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem< RealType > eig( K );
-
-  RealType sumEigenValuesUsed = itk::NumericTraits< RealType >::Zero;
-  for( unsigned int i = 1; i < this->m_NumEigenValues + 1; i++ )
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue( this->m_G - i );
-  }
+  /** Compute the largest eigenvalues and their eigenvectors of K. */
+  vnl_vector< RealType > eigenValues;
+  MatrixType             eigenVectorMatrix;
+  this->ComputeLargestEigenPairs( K, eigenValues, eigenVectorMatrix );
 
-  MatrixType eigenVectorMatrix( this->m_G, this->m_NumEigenValues );
-  for( unsigned int i = 1; i < this->m_NumEigenValues + 1; i++ )
-  {
-    eigenVectorMatrix.set_column( i - 1, ( eig.get_eigenvector( this->m_G - i ) ).normalize() );
-  }
+  RealType sumEigenValuesUsed = eigenValues.sum();
 
   MatrixType eigenVectorMatrixTranspose( eigenVectorMatrix.transpose() );
 
@@ -816,10 +809,40 @@ PCAMetric< TFixedImage, TMovingImage >
 
   } /** end first loop over image sample container */
 
+  /** Compute the mean and the scatter matrix of the samples of this thread,
+   * so that the covariance matrix is accumulated in parallel.
+   */
+  MatrixType             threadDataBlock( datablock.extract( pixelIndex, this->m_G ) );
+  vnl_vector< RealType > threadMean( this->m_G, NumericTraits< RealType >::Zero );
+  MatrixType             threadScatter( this->m_G, this->m_G, NumericTraits< RealType >::Zero );
+  if( pixelIndex > 0 )
+  {
+    for( unsigned int i = 0; i < pixelIndex; i++ )
+    {
+      for( unsigned int j = 0; j < this->m_G; j++ )
+      {
+        threadMean( j ) += threadDataBlock( i, j );
+      }
+    }
+    threadMean /= static_cast< RealType >( pixelIndex );
+
+    MatrixType threadAmm( threadDataBlock );
+    for( unsigned int i = 0; i < pixelIndex; i++ )
+    {
+      for( unsigned int j = 0; j < this->m_G; j++ )
+      {
+        threadAmm( i, j ) -= threadMean( j );
+      }
+    }
+    threadScatter = threadAmm.transpose() * threadAmm;
+  }
+
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_NumberOfPixelsCounted = pixelIndex;
-  this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_DataBlock             = datablock.extract( pixelIndex, this->m_G );
+  this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_DataBlock             = threadDataBlock;
   this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_ApprovedSamples       = SamplesOK;
+  this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_Mean                  = threadMean;
+  this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_Scatter               = threadScatter;
 
 } // end ThreadedGetSamples()
 
@@ -845,42 +868,35 @@ PCAMetric< TFixedImage, TMovingImage >
   this->CheckNumberOfSamples(
     sampleContainer->Size(), this->m_NumberOfPixelsCounted );
 
-  MatrixType   A( this->m_NumberOfPixelsCounted, this->m_G );
-  unsigned int row_start = 0;
+  /** Merge the means and scatter matrices of the threads into the mean and
+   * covariance matrix C of all samples. The scatter matrix of each thread is
+   * computed around its own mean, and is corrected here for the difference
+   * with the overall mean.
+   */
+  const RealType         N = static_cast< RealType >( this->m_NumberOfPixelsCounted );
+  vnl_vector< RealType > mean( this->m_G, NumericTraits< RealType >::Zero );
   for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
   {
-    A.update( this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_DataBlock, row_start, 0 );
-    this->m_PixelStartIndex[ i ] = row_start;
-    row_start                   += this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_DataBlock.rows();
+    const RealType threadN = static_cast< RealType >(
+      this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_NumberOfPixelsCounted );
+    mean += threadN * this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_Mean;
   }
+  mean /= N;
 
-  /** Calculate mean of from columns */
-  vnl_vector< RealType > mean( this->m_G );
-  mean.fill( NumericTraits< RealType >::Zero );
-  for( unsigned int i = 0; i < this->m_NumberOfPixelsCounted; i++ )
-  {
-    for( unsigned int j = 0; j < this->m_G; j++ )
-    {
-      mean( j ) += A( i, j );
-    }
-  }
-  mean /= RealType( this->m_NumberOfPixelsCounted );
-
-  /** Calculate standard deviation from columns */
-  MatrixType Amm( this->m_NumberOfPixelsCounted, this->m_G );
-  Amm.fill( NumericTraits< RealType >::Zero );
-  for( unsigned int i = 0; i < this->m_NumberOfPixelsCounted; i++ )
+  MatrixType C( this->m_G, this->m_G, NumericTraits< RealType >::Zero );
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
   {
-    for( unsigned int j = 0; j < this->m_G; j++ )
+    const RealType threadN = static_cast< RealType >(
+      this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_NumberOfPixelsCounted );
+    if( threadN > 0.0 )
     {
-      Amm( i, j ) = A( i, j ) - mean( j );
+      const vnl_vector< RealType > diff
+        = this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_Mean - mean;
+      C += this->m_PCAMetricGetSamplesPerThreadVariables[ i ].st_Scatter;
+      C += threadN * outer_product( diff, diff );
     }
   }
-
-  /** Compute covariancematrix C */
-  this->m_Atmm = Amm.transpose();
-  MatrixType C( this->m_Atmm * Amm );
-  C /= static_cast< RealType >( RealType( this->m_NumberOfPixelsCounted ) - 1.0 );
+  C /= static_cast< RealType >( N - 1.0 );
 
   vnl_diag_matrix< RealType > S( this->m_G );
   S.fill( NumericTraits< RealType >::Zero );
@@ -891,16 +907,12 @@ PCAMetric< TFixedImage, TMovingImage >
 
   MatrixType K( S * C * S );
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem< RealType > eig( K );
+  /** Compute the largest eigenvalues and their eigenvectors of K. */
+  vnl_vector< RealType > eigenValues;
+  MatrixType             eigenVectorMatrix;
+  this->ComputeLargestEigenPairs( K, eigenValues, eigenVectorMatrix );
 
-  RealType   sumEigenValuesUsed = itk::NumericTraits< RealType >::Zero;
-  MatrixType eigenVectorMatrix( this->m_G, this->m_NumEigenValues );
-  for( unsigned int i = 1; i < this->m_NumEigenValues + 1; i++ )
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue( this->m_G - i );
-    eigenVectorMatrix.set_column( i - 1, ( eig.get_eigenvector( this->m_G - i ) ).normalize() );
-  }
+  RealType sumEigenValuesUsed = eigenValues.sum();
 
   value = this->m_G - sumEigenValuesUsed;
 
@@ -916,7 +928,9 @@ PCAMetric< TFixedImage, TMovingImage >
     dSdmu_part1( d, d ) = -S_qub;
   }
 
-  this->m_vSAtmm       = eigenVectorMatrixTranspose * S * this->m_Atmm;
+  /** The centered samples are only formed per sample in the threads. */
+  this->m_Mean         = mean;
+  this->m_vS           = eigenVectorMatrixTranspose * S;
   this->m_CSv          = C * S * eigenVectorMatrix;
   this->m_Sv           = S * eigenVectorMatrix;
   this->m_vdSdmu_part1 = eigenVectorMatrixTranspose * dSdmu_part1;
@@ -955,17 +969,11 @@ void
 PCAMetric< TFixedImage, TMovingImage >
 ::LaunchGetSamplesThreaderCallback( void ) const
 {
-  /** Setup local threader. */
-  // \todo: is a global threader better performance-wise? check
-  typename ThreaderType::Pointer local_threader = ThreaderType::New();
-  local_threader->SetNumberOfThreads( this->m_NumberOfThreads );
-  local_threader->SetSingleMethod( this->GetSamplesThreaderCallback,
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->GetSamplesThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_PCAMetricThreaderParameters ) ) );
 
-  /** Launch. */
-  local_threader->SingleMethodExecute();
-
 } // end LaunchGetSamplesThreaderCallback()
 
 
@@ -982,6 +990,12 @@ PCAMetric< TFixedImage, TMovingImage >
   DerivativeType & derivative = this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_Derivative;
   derivative.Fill( 0.0 );
 
+  /** Get a handle to the samples of this thread. */
+  const MatrixType &                         datablock
+    = this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_DataBlock;
+  const std::vector< FixedImagePointType > & approvedSamples
+    = this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_ApprovedSamples;
+
   /** Initialize some variables. */
   RealType                  movingImageValue;
   MovingImagePointType      mappedPoint;
@@ -991,19 +1005,26 @@ PCAMetric< TFixedImage, TMovingImage >
   DerivativeType             imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
   NonZeroJacobianIndicesType nzjis( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
 
-  unsigned int dummyindex = 0;
+  vnl_vector< DerivativeValueType > Atmm( this->m_G );
+  vnl_vector< DerivativeValueType > vSAtmm( this->m_NumEigenValues );
+
   /** Second loop over fixed image samples. */
-  for( unsigned int pixelIndex = this->m_PixelStartIndex[ threadId ];
-    pixelIndex < ( this->m_PixelStartIndex[ threadId ] + this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_ApprovedSamples.size() );
-    ++pixelIndex )
+  for( unsigned int pixelIndex = 0; pixelIndex < approvedSamples.size(); ++pixelIndex )
   {
     /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = this->m_PCAMetricGetSamplesPerThreadVariables[ threadId ].st_ApprovedSamples[ dummyindex ];
+    FixedImagePointType fixedPoint = approvedSamples[ pixelIndex ];
 
     /** Transform sampled point to voxel coordinates. */
     FixedImageContinuousIndexType voxelCoord;
     this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
 
+    /** Center the sample, and project it on the scaled eigenvectors. */
+    for( unsigned int d = 0; d < this->m_G; ++d )
+    {
+      Atmm[ d ] = datablock( pixelIndex, d ) - this->m_Mean[ d ];
+    }
+    vSAtmm = this->m_vS * Atmm;
+
     for( unsigned int d = 0; d < this->m_G; ++d )
     {
       /** Set fixed point's last dimension to lastDimPosition. */
@@ -1023,20 +1044,23 @@ PCAMetric< TFixedImage, TMovingImage >
       this->EvaluateTransformJacobianInnerProduct(
         jacobian, movingImageDerivative, imageJacobian );
 
+      /** The sum over the eigenvalues does not depend on the parameter,
+       * so compute it once per time point.
+       */
+      DerivativeValueType sumOverEigenValues = 0.0;
+      for( unsigned int z = 0; z < this->m_NumEigenValues; z++ )
+      {
+        sumOverEigenValues += vSAtmm[ z ] * this->m_Sv[ d ][ z ]
+          + this->m_vdSdmu_part1[ z ][ d ] * Atmm[ d ] * this->m_CSv[ d ][ z ];
+      } //end loop over eigenvalues
+
       /** build metric derivative components */
       for( unsigned int p = 0; p < nzjis.size(); ++p )
       {
-        DerivativeValueType tmp = 0.0;
-        for( unsigned int z = 0; z < this->m_NumEigenValues; z++ )
-        {
-          tmp += this->m_vSAtmm[ z ][ pixelIndex ] * imageJacobian[ p ] * this->m_Sv[ d ][ z ]
-            + this->m_vdSdmu_part1[ z ][ d ] * this->m_Atmm[ d ][ pixelIndex ] * imageJacobian[ p ] * this->m_CSv[ d ][ z ];
-        } //end loop over eigenvalues
-        derivative[ nzjis[ p ] ] += tmp;
+        derivative[ nzjis[ p ] ] += sumOverEigenValues * imageJacobian[ p ];
       } //end loop over non-zero jacobian indices
 
     } //end loop over last dimension
-    dummyindex++;
 
   } // end second for loop over sample container
 
@@ -1163,20 +1187,162 @@ void
 PCAMetric< TFixedImage, TMovingImage >
 ::LaunchComputeDerivativeThreaderCallback( void ) const
 {
-  /** Setup local threader. */
-  // \todo: is a global threader better performance-wise? check
-  typename ThreaderType::Pointer local_threader = ThreaderType::New();
-  local_threader->SetNumberOfThreads( this->m_NumberOfThreads );
-  local_threader->SetSingleMethod( this->ComputeDerivativeThreaderCallback,
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->ComputeDerivativeThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_PCAMetricThreaderParameters ) ) );
 
-  /** Launch. */
-  local_threader->SingleMethodExecute();
-
 } // end LaunchComputeDerivativeThreaderCallback()
 
 
+/**
+ * ******************* ComputeLargestEigenPairs *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric< TFixedImage, TMovingImage >
+::ComputeLargestEigenPairs( const MatrixType & K,
+  vnl_vector< RealType > & eigenValues, MatrixType & eigenVectors ) const
+{
+  const unsigned int G = K.rows();
+  const unsigned int k = std::min( this->m_NumEigenValues, G );
+
+  /** Iterate on some more vectors than needed, which speeds up the convergence. */
+  const unsigned int p = std::min( 2 * k, G );
+
+  /** The residual ||K v - lambda v|| of the wanted eigenpairs, relative to
+   * the largest eigenvalue, below which the subspace iteration is converged.
+   */
+  const RealType     tolerance                 = 1e-6;
+  const unsigned int maximumNumberOfIterations = 20;
+
+  /** Subspace iteration, started from the eigenvectors of the previous call. */
+  bool       converged = false;
+  MatrixType Q( this->m_PreviousEigenVectors );
+  if( Q.rows() == G && Q.cols() == p && this->OrthonormalizeColumns( Q ) )
+  {
+    for( unsigned int iter = 0; iter < maximumNumberOfIterations; ++iter )
+    {
+      /** Rayleigh-Ritz: compute the eigenpairs of K restricted to the span of Q. */
+      const MatrixType KQ = K * Q;
+      MatrixType       H  = Q.transpose() * KQ;
+      H = 0.5 * ( H + H.transpose() );
+      vnl_symmetric_eigensystem< RealType > eigH( H );
+
+      /** Sort the Ritz values and vectors in descending order. */
+      vnl_vector< RealType > ritzValues( p );
+      MatrixType             U( p, p );
+      for( unsigned int j = 0; j < p; j++ )
+      {
+        ritzValues[ j ] = eigH.get_eigenvalue( p - j - 1 );
+        U.set_column( j, eigH.get_eigenvector( p - j - 1 ) );
+      }
+      const MatrixType V  = Q * U;
+      const MatrixType KV = KQ * U;
+
+      /** Check the residuals of the wanted eigenpairs. */
+      const RealType maximumResidual
+        = tolerance * std::max( vnl_math_abs( ritzValues[ 0 ] ), NumericTraits< RealType >::One );
+      converged = true;
+      for( unsigned int j = 0; j < k && converged; j++ )
+      {
+        const RealType residual
+          = ( KV.get_column( j ) - ritzValues[ j ] * V.get_column( j ) ).two_norm();
+        converged = residual <= maximumResidual;
+      }
+
+      if( converged )
+      {
+        eigenValues                  = ritzValues.extract( k );
+        eigenVectors                 = V.extract( G, k );
+        this->m_PreviousEigenVectors = V;
+        break;
+      }
+
+      /** Multiply the Ritz vectors with K once more. */
+      Q = KV;
+      if( !this->OrthonormalizeColumns( Q ) )
+      {
+        break;
+      }
+    }
+  }
+
+  /** Compute the full eigendecomposition in the first call, or when the
+   * subspace iteration did not converge.
+   */
+  if( !converged )
+  {
+    vnl_symmetric_eigensystem< RealType > eig( K );
+
+    eigenValues.set_size( k );
+    eigenVectors.set_size( G, k );
+    this->m_PreviousEigenVectors.set_size( G, p );
+    for( unsigned int j = 0; j < p; j++ )
+    {
+      vnl_vector< RealType > eigenVector = eig.get_eigenvector( G - j - 1 );
+      eigenVector.normalize();
+      this->m_PreviousEigenVectors.set_column( j, eigenVector );
+      if( j < k )
+      {
+        eigenValues[ j ] = eig.get_eigenvalue( G - j - 1 );
+        eigenVectors.set_column( j, eigenVector );
+      }
+    }
+  }
+
+} // end ComputeLargestEigenPairs()
+
+
+/**
+ * ******************* OrthonormalizeColumns *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+PCAMetric< TFixedImage, TMovingImage >
+::OrthonormalizeColumns( MatrixType & Q )
+{
+  const unsigned int rows = Q.rows();
+  for( unsigned int j = 0; j < Q.cols(); j++ )
+  {
+    /** Remove the components along the previous columns. */
+    for( unsigned int i = 0; i < j; i++ )
+    {
+      RealType projection = NumericTraits< RealType >::Zero;
+      for( unsigned int r = 0; r < rows; r++ )
+      {
+        projection += Q( r, i ) * Q( r, j );
+      }
+      for( unsigned int r = 0; r < rows; r++ )
+      {
+        Q( r, j ) -= projection * Q( r, i );
+      }
+    }
+
+    /** Normalize. */
+    RealType norm = NumericTraits< RealType >::Zero;
+    for( unsigned int r = 0; r < rows; r++ )
+    {
+      norm += Q( r, j ) * Q( r, j );
+    }
+    norm = vcl_sqrt( norm );
+    if( norm < 1e-12 )
+    {
+      return false;
+    }
+    for( unsigned int r = 0; r < rows; r++ )
+    {
+      Q( r, j ) /= norm;
+    }
+  }
+
+  return true;
+
+} // end OrthonormalizeColumns()
+
+
 } // end namespace itk
 
 #endif // __PCAMetric_F_multithreaded_HXX__
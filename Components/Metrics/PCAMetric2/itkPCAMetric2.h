@@ -100,6 +100,12 @@ public:
     Superclass::MovingImageLimiterOutputType              MovingImageLimiterOutputType;
   typedef typename
     Superclass::MovingImageDerivativeScalesType           MovingImageDerivativeScalesType;
+  typedef typename DerivativeType::ValueType              DerivativeValueType;
+  typedef typename Superclass::ThreaderType               ThreaderType;
+  typedef typename Superclass::ThreadInfoType             ThreadInfoType;
+
+  typedef vnl_matrix< RealType >            MatrixType;
+  typedef vnl_matrix< DerivativeValueType > DerivativeMatrixType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro( FixedImageDimension, unsigned int,
@@ -117,6 +123,9 @@ public:
     DerivativeType & derivative ) const;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void GetValueAndDerivativeSingleThreaded( const TransformParametersType & parameters,
+    MeasureType & Value, DerivativeType & Derivative ) const;
+
   virtual void GetValueAndDerivative( const TransformParametersType & parameters,
     MeasureType & Value, DerivativeType & Derivative ) const;
 
@@ -129,7 +138,7 @@ public:
 protected:
 
   PCAMetric2();
-  virtual ~PCAMetric2() {}
+  virtual ~PCAMetric2();
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
   /** Protected Typedefs ******************/
@@ -157,6 +166,56 @@ protected:
     const MovingImageDerivativeType & movingImageDerivative,
     DerivativeType & imageJacobian ) const;
 
+  struct PCAMetric2MultiThreaderParameterType
+  {
+    Self * m_Metric;
+  };
+
+  PCAMetric2MultiThreaderParameterType m_PCAMetric2ThreaderParameters;
+
+  struct PCAMetric2GetSamplesPerThreadStruct
+  {
+    SizeValueType                      st_NumberOfPixelsCounted;
+    MatrixType                         st_DataBlock;
+    std::vector< FixedImagePointType > st_ApprovedSamples;
+    vnl_vector< RealType >             st_Mean;
+    MatrixType                         st_Scatter;
+    DerivativeType                     st_Derivative;
+  };
+
+  itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, PCAMetric2GetSamplesPerThreadStruct,
+    PaddedPCAMetric2GetSamplesPerThreadStruct );
+
+  itkAlignedTypedef( ITK_CACHE_LINE_ALIGNMENT,
+    PaddedPCAMetric2GetSamplesPerThreadStruct,
+    AlignedPCAMetric2GetSamplesPerThreadStruct );
+
+  mutable AlignedPCAMetric2GetSamplesPerThreadStruct * m_PCAMetric2GetSamplesPerThreadVariables;
+  mutable ThreadIdType                                 m_PCAMetric2GetSamplesPerThreadVariablesSize;
+
+  /** Get value and derivatives for each thread. */
+  inline void ThreadedGetSamples( ThreadIdType threadID );
+
+  inline void ThreadedComputeDerivative( ThreadIdType threadID );
+
+  /** Gather the values and derivatives from all threads */
+  inline void AfterThreadedGetSamples( MeasureType & value ) const;
+
+  inline void AfterThreadedComputeDerivative( DerivativeType & derivative ) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_TYPE GetSamplesThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE ComputeDerivativeThreaderCallback( void * arg );
+
+  /** Helper functions to launch the threads. */
+  void LaunchGetSamplesThreaderCallback( void ) const;
+
+  void LaunchComputeDerivativeThreaderCallback( void ) const;
+
+  /** Initialize some multi-threading related parameters. */
+  virtual void InitializeThreadingParameters( void ) const;
+
 private:
 
   PCAMetric2( const Self & );      // purposely not implemented
@@ -178,6 +237,16 @@ private:
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
 
+  unsigned int m_G;
+  unsigned int m_LastDimIndex;
+
+  /** Matrices, needed for derivative calculation */
+  mutable vnl_vector< RealType > m_Mean;
+  mutable DerivativeMatrixType   m_vS;
+  mutable DerivativeMatrixType   m_CSv;
+  mutable DerivativeMatrixType   m_Sv;
+  mutable DerivativeMatrixType   m_vdSdmu_part1;
+
 };
 
 } // end namespace itk
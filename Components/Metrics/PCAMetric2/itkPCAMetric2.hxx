@@ -20,7 +20,7 @@
 
 #include "itkPCAMetric2.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkThreadRandomGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
 #include "vnl/algo/vnl_svd.h"
@@ -44,9 +44,28 @@ PCAMetric2< TFixedImage, TMovingImage >
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
+
+  // Multi-threading structs
+  this->m_PCAMetric2GetSamplesPerThreadVariables     = NULL;
+  this->m_PCAMetric2GetSamplesPerThreadVariablesSize = 0;
+
+  /** Initialize the m_PCAMetric2ThreaderParameters. */
+  this->m_PCAMetric2ThreaderParameters.m_Metric = this;
 } // end constructor
 
 
+/**
+ * ******************* Destructor *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+PCAMetric2< TFixedImage, TMovingImage >
+::~PCAMetric2()
+{
+  delete[] this->m_PCAMetric2GetSamplesPerThreadVariables;
+} // end Destructor
+
+
 /**
  * ******************* Initialize *******************
  */
@@ -60,8 +79,8 @@ PCAMetric2< TFixedImage, TMovingImage >
   Superclass::Initialize();
 
   /** Retrieve slowest varying dimension and its size. */
-  //const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
-  //const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+  this->m_LastDimIndex = this->GetFixedImage()->GetImageDimension() - 1;
+  this->m_G            = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( this->m_LastDimIndex );
 
 } // end Initialize()
 
@@ -79,6 +98,41 @@ PCAMetric2< TFixedImage, TMovingImage >
 } // end PrintSelf()
 
 
+/**
+ * ********************* InitializeThreadingParameters ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::InitializeThreadingParameters( void ) const
+{
+  /** Resize and initialize the threading related parameters.
+   * The SetSize() functions do not resize the data when this is not
+   * needed, which saves valuable re-allocation time.
+   * Filling the potentially large vectors is performed later, in each thread,
+   * which has performance benefits for larger vector sizes.
+   */
+
+  /** Only resize the array of structs when needed. */
+  if( this->m_PCAMetric2GetSamplesPerThreadVariablesSize != this->m_NumberOfThreads )
+  {
+    delete[] this->m_PCAMetric2GetSamplesPerThreadVariables;
+    this->m_PCAMetric2GetSamplesPerThreadVariables
+      = new AlignedPCAMetric2GetSamplesPerThreadStruct[ this->m_NumberOfThreads ];
+    this->m_PCAMetric2GetSamplesPerThreadVariablesSize = this->m_NumberOfThreads;
+  }
+
+  /** Some initialization. */
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
+  {
+    this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_NumberOfPixelsCounted = NumericTraits< SizeValueType >::Zero;
+    this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_Derivative.SetSize( this->GetNumberOfParameters() );
+  }
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ******************* SampleRandom *******************
  */
@@ -93,7 +147,7 @@ PCAMetric2< TFixedImage, TMovingImage >
 
   /** Initialize random number generator. */
   Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator
-    = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+    = ThreadRandomGenerator::GetInstance();
 
   /** Sample additional at fixed timepoint. */
   for( unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i )
@@ -360,18 +414,17 @@ PCAMetric2< TFixedImage, TMovingImage >
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template< class TFixedImage, class TMovingImage >
 void
 PCAMetric2< TFixedImage, TMovingImage >
-::GetValueAndDerivative( const TransformParametersType & parameters,
+::GetValueAndDerivativeSingleThreaded( const TransformParametersType & parameters,
   MeasureType & value, DerivativeType & derivative ) const
 {
   itkDebugMacro( "GetValueAndDerivative( " << parameters << " ) " );
-  /** Define derivative and Jacobian types. */
-  typedef typename DerivativeType::ValueType DerivativeValueType;
+  /** Define Jacobian types. */
   //typedef typename TransformJacobianType::ValueType TransformJacobianValueType;
 
   /** Initialize some variables */
@@ -397,9 +450,6 @@ PCAMetric2< TFixedImage, TMovingImage >
   const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
   const unsigned int G       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
 
-  typedef vnl_matrix< RealType >            MatrixType;
-  typedef vnl_matrix< DerivativeValueType > DerivativeMatrixType;
-
   std::vector< FixedImagePointType > SamplesOK;
 
   /** The rows of the ImageSampleMatrix contain the samples of the images of the stack */
@@ -692,9 +742,538 @@ PCAMetric2< TFixedImage, TMovingImage >
   /** Return the measure value. */
   value = measure;
 
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::GetValueAndDerivative(
+  const TransformParametersType & parameters,
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  /** Option for now to still use the single threaded code. */
+  if( !this->m_UseMultiThread )
+  {
+    return this->GetValueAndDerivativeSingleThreaded(
+      parameters, value, derivative );
+  }
+
+  /** Call non-thread-safe stuff, such as:
+     *   this->SetTransformParameters( parameters );
+     *   this->GetImageSampler()->Update();
+     * Because of these calls GetValueAndDerivative itself is not thread-safe,
+     * so cannot be called multiple times simultaneously.
+     * This is however needed in the CombinationImageToImageMetric.
+     * In that case, you need to:
+     * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
+     * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
+     *   calling GetValueAndDerivative
+     * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
+     * - Now you can call GetValueAndDerivative multi-threaded.
+     */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  this->InitializeThreadingParameters();
+
+  /** Launch multi-threading GetSamples */
+  this->LaunchGetSamplesThreaderCallback();
+
+  /** Get the metric value contributions from all threads. */
+  this->AfterThreadedGetSamples( value );
+
+  /** Launch multi-threading ComputeDerivative */
+  this->LaunchComputeDerivativeThreaderCallback();
+
+  /** Sum derivative contributions from all threads */
+  this->AfterThreadedComputeDerivative( derivative );
+
 } // end GetValueAndDerivative()
 
 
+/**
+ * ******************* ThreadedGetSamples *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::ThreadedGetSamples( ThreadIdType threadId )
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->m_NumberOfThreads ) ) );
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend   = sampleContainer->Begin();
+  threader_fbegin                                                 += (int)pos_begin;
+  threader_fend                                                   += (int)pos_end;
+
+  std::vector< FixedImagePointType > SamplesOK;
+  MatrixType                         datablock( nrOfSamplesPerThreads, this->m_G );
+
+  unsigned int pixelIndex = 0;
+  for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    unsigned int numSamplesOk = 0;
+
+    /** Loop over t */
+    for( unsigned int d = 0; d < this->m_G; ++d )
+    {
+      /** Initialize some variables. */
+      RealType             movingImageValue;
+      MovingImagePointType mappedPoint;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ this->m_LastDimIndex ] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+      /** Check if point is inside mask. */
+      if( sampleOk )
+      {
+        sampleOk = this->IsInsideMovingMask( mappedPoint );
+      }
+
+      if( sampleOk )
+
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, 0 );
+      }
+
+      if( sampleOk )
+      {
+        numSamplesOk++;
+        datablock( pixelIndex, d ) = movingImageValue;
+      } // end if sampleOk
+
+    } // end loop over t
+    if( numSamplesOk == m_G )
+    {
+      SamplesOK.push_back( fixedPoint );
+      pixelIndex++;
+    }
+
+  } /** end first loop over image sample container */
+
+  /** Compute the mean and the scatter matrix of the samples of this thread,
+   * so that the covariance matrix is accumulated in parallel.
+   */
+  MatrixType             threadDataBlock( datablock.extract( pixelIndex, this->m_G ) );
+  vnl_vector< RealType > threadMean( this->m_G, NumericTraits< RealType >::Zero );
+  MatrixType             threadScatter( this->m_G, this->m_G, NumericTraits< RealType >::Zero );
+  if( pixelIndex > 0 )
+  {
+    for( unsigned int i = 0; i < pixelIndex; i++ )
+    {
+      for( unsigned int j = 0; j < this->m_G; j++ )
+      {
+        threadMean( j ) += threadDataBlock( i, j );
+      }
+    }
+    threadMean /= static_cast< RealType >( pixelIndex );
+
+    MatrixType threadAmm( threadDataBlock );
+    for( unsigned int i = 0; i < pixelIndex; i++ )
+    {
+      for( unsigned int j = 0; j < this->m_G; j++ )
+      {
+        threadAmm( i, j ) -= threadMean( j );
+      }
+    }
+    threadScatter = threadAmm.transpose() * threadAmm;
+  }
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_NumberOfPixelsCounted = pixelIndex;
+  this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_DataBlock             = threadDataBlock;
+  this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_ApprovedSamples       = SamplesOK;
+  this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_Mean                  = threadMean;
+  this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_Scatter               = threadScatter;
+
+} // end ThreadedGetSamples()
+
+
+/**
+ * ******************* AfterThreadedGetSamples *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::AfterThreadedGetSamples( MeasureType & value ) const
+{
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = this->m_PCAMetric2GetSamplesPerThreadVariables[ 0 ].st_NumberOfPixelsCounted;
+  for( ThreadIdType i = 1; i < this->m_NumberOfThreads; ++i )
+  {
+    this->m_NumberOfPixelsCounted += this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_NumberOfPixelsCounted;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(
+    sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+
+  /** Merge the means and scatter matrices of the threads into the mean and
+   * covariance matrix C of all samples. The scatter matrix of each thread is
+   * computed around its own mean, and is corrected here for the difference
+   * with the overall mean.
+   */
+  const RealType         N = static_cast< RealType >( this->m_NumberOfPixelsCounted );
+  vnl_vector< RealType > mean( this->m_G, NumericTraits< RealType >::Zero );
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
+  {
+    const RealType threadN = static_cast< RealType >(
+      this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_NumberOfPixelsCounted );
+    mean += threadN * this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_Mean;
+  }
+  mean /= N;
+
+  MatrixType C( this->m_G, this->m_G, NumericTraits< RealType >::Zero );
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
+  {
+    const RealType threadN = static_cast< RealType >(
+      this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_NumberOfPixelsCounted );
+    if( threadN > 0.0 )
+    {
+      const vnl_vector< RealType > diff
+        = this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_Mean - mean;
+      C += this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_Scatter;
+      C += threadN * outer_product( diff, diff );
+    }
+  }
+  C /= static_cast< RealType >( N - 1.0 );
+
+  vnl_diag_matrix< RealType > S( this->m_G );
+  S.fill( NumericTraits< RealType >::Zero );
+  for( unsigned int j = 0; j < this->m_G; j++ )
+  {
+    S( j, j ) = 1.0 / sqrt( C( j, j ) );
+  }
+
+  MatrixType K( S * C * S );
+
+  /** Compute all eigenvalues and eigenvectors of K. The metric is a weighted
+   * sum of all eigenvalues, so the full eigendecomposition is needed.
+   */
+  vnl_symmetric_eigensystem< RealType > eig( K );
+
+  RealType   sumWeightedEigenValues = itk::NumericTraits< RealType >::Zero;
+  MatrixType eigenVectorMatrix( this->m_G, this->m_G );
+  for( unsigned int i = 0; i < this->m_G; i++ )
+  {
+    sumWeightedEigenValues += ( i + 1 ) * eig.get_eigenvalue( this->m_G - i - 1 );
+    eigenVectorMatrix.set_column( i, ( eig.get_eigenvector( this->m_G - i - 1 ) ).normalize() );
+  }
+
+  value = sumWeightedEigenValues;
+
+  MatrixType eigenVectorMatrixTranspose( eigenVectorMatrix.transpose() );
+
+  /** Sub components of metric derivative */
+  vnl_diag_matrix< DerivativeValueType > dSdmu_part1( this->m_G );
+
+  for( unsigned int d = 0; d < this->m_G; d++ )
+  {
+    double S_sqr = S( d, d ) * S( d, d );
+    double S_qub = S_sqr * S( d, d );
+    dSdmu_part1( d, d ) = -S_qub;
+  }
+
+  /** The centered samples are only formed per sample in the threads. */
+  this->m_Mean         = mean;
+  this->m_vS           = eigenVectorMatrixTranspose * S;
+  this->m_CSv          = C * S * eigenVectorMatrix;
+  this->m_Sv           = S * eigenVectorMatrix;
+  this->m_vdSdmu_part1 = eigenVectorMatrixTranspose * dSdmu_part1;
+
+} // end AfterThreadedGetSamples()
+
+
+/**
+ * **************** GetSamplesThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+PCAMetric2< TFixedImage, TMovingImage >
+::GetSamplesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  PCAMetric2MultiThreaderParameterType * temp
+    = static_cast< PCAMetric2MultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedGetSamples( threadId );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // GetSamplesThreaderCallback()
+
+
+/**
+ * *********************** LaunchGetSamplesThreaderCallback***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::LaunchGetSamplesThreaderCallback( void ) const
+{
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->GetSamplesThreaderCallback,
+    const_cast< void * >( static_cast< const void * >(
+      &this->m_PCAMetric2ThreaderParameters ) ) );
+
+} // end LaunchGetSamplesThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::ThreadedComputeDerivative( ThreadIdType threadId )
+{
+  /** Create variables to store intermediate results in. */
+  DerivativeType & derivative = this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_Derivative;
+  derivative.Fill( 0.0 );
+
+  /** Get a handle to the samples of this thread. */
+  const MatrixType &                         datablock
+    = this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_DataBlock;
+  const std::vector< FixedImagePointType > & approvedSamples
+    = this->m_PCAMetric2GetSamplesPerThreadVariables[ threadId ].st_ApprovedSamples;
+
+  /** Initialize some variables. */
+  RealType                  movingImageValue;
+  MovingImagePointType      mappedPoint;
+  MovingImageDerivativeType movingImageDerivative;
+
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+  NonZeroJacobianIndicesType nzjis( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+
+  vnl_vector< DerivativeValueType > Atmm( this->m_G );
+  vnl_vector< DerivativeValueType > vSAtmm( this->m_G );
+
+  /** Second loop over fixed image samples. */
+  for( unsigned int pixelIndex = 0; pixelIndex < approvedSamples.size(); ++pixelIndex )
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = approvedSamples[ pixelIndex ];
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    /** Center the sample, and project it on the scaled eigenvectors. */
+    for( unsigned int d = 0; d < this->m_G; ++d )
+    {
+      Atmm[ d ] = datablock( pixelIndex, d ) - this->m_Mean[ d ];
+    }
+    vSAtmm = this->m_vS * Atmm;
+
+    for( unsigned int d = 0; d < this->m_G; ++d )
+    {
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ this->m_LastDimIndex ] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+      this->TransformPoint( fixedPoint, mappedPoint );
+
+      this->EvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, &movingImageDerivative );
+
+      /** Get the TransformJacobian dT/dmu */
+      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzjis );
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(
+        jacobian, movingImageDerivative, imageJacobian );
+
+      /** The weighted sum over the eigenvalues does not depend on the parameter,
+       * so compute it once per time point.
+       */
+      DerivativeValueType sumOverEigenValues = 0.0;
+      for( unsigned int z = 0; z < this->m_G; z++ )
+      {
+        sumOverEigenValues += z * ( vSAtmm[ z ] * this->m_Sv[ d ][ z ]
+          + this->m_vdSdmu_part1[ z ][ d ] * Atmm[ d ] * this->m_CSv[ d ][ z ] );
+      } //end loop over eigenvalues
+
+      /** build metric derivative components */
+      for( unsigned int p = 0; p < nzjis.size(); ++p )
+      {
+        derivative[ nzjis[ p ] ] += sumOverEigenValues * imageJacobian[ p ];
+      } //end loop over non-zero jacobian indices
+
+    } //end loop over last dimension
+
+  } // end second for loop over sample container
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* AfterThreadedComputeDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::AfterThreadedComputeDerivative(
+  DerivativeType & derivative ) const
+{
+  derivative = this->m_PCAMetric2GetSamplesPerThreadVariables[ 0 ].st_Derivative;
+  for( ThreadIdType i = 1; i < this->m_NumberOfThreads; ++i )
+  {
+    derivative += this->m_PCAMetric2GetSamplesPerThreadVariables[ i ].st_Derivative;
+  }
+
+  derivative *= ( 2.0 / ( DerivativeValueType( this->m_NumberOfPixelsCounted ) - 1.0 ) ); //normalize
+
+  /** Subtract mean from derivative elements. */
+  if( this->m_SubtractMean )
+  {
+    if( !this->m_TransformIsStackTransform )
+    {
+      /** Update derivative per dimension.
+   * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
+   * per dimension xyz.
+   */
+      const unsigned int lastDimGridSize = this->m_GridSize[ this->m_LastDimIndex ];
+      const unsigned int numParametersPerDimension
+        = this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
+      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
+      DerivativeType     mean( numControlPointsPerDimension );
+      for( unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d )
+      {
+        /** Compute mean per dimension. */
+        mean.Fill( 0.0 );
+        const unsigned int starti = numParametersPerDimension * d;
+        for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
+        {
+          const unsigned int index = i % numControlPointsPerDimension;
+          mean[ index ] += derivative[ i ];
+        }
+        mean /= static_cast< RealType >( lastDimGridSize );
+
+        /** Update derivative for every control point per dimension. */
+        for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
+        {
+          const unsigned int index = i % numControlPointsPerDimension;
+          derivative[ i ] -= mean[ index ];
+        }
+      }
+    }
+    else
+    {
+      /** Update derivative per dimension.
+   * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
+   * the number the time point index.
+   */
+      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / this->m_G;
+      DerivativeType     mean( numParametersPerLastDimension );
+      mean.Fill( 0.0 );
+
+      /** Compute mean per control point. */
+      for( unsigned int t = 0; t < this->m_G; ++t )
+      {
+        const unsigned int startc = numParametersPerLastDimension * t;
+        for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
+        {
+          const unsigned int index = c % numParametersPerLastDimension;
+          mean[ index ] += derivative[ c ];
+        }
+      }
+      mean /= static_cast< RealType >( this->m_G );
+
+      /** Update derivative per control point. */
+      for( unsigned int t = 0; t < this->m_G; ++t )
+      {
+        const unsigned int startc = numParametersPerLastDimension * t;
+        for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
+        {
+          const unsigned int index = c % numParametersPerLastDimension;
+          derivative[ c ] -= mean[ index ];
+        }
+      }
+    }
+  }
+} // end AfterThreadedComputeDerivative()
+
+
+/**
+ * **************** ComputeDerivativeThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+PCAMetric2< TFixedImage, TMovingImage >
+::ComputeDerivativeThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  PCAMetric2MultiThreaderParameterType * temp
+    = static_cast< PCAMetric2MultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedComputeDerivative( threadId );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeDerivativeThreaderCallback()
+
+
+/**
+ * ************** LaunchComputeDerivativeThreaderCallback **********
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::LaunchComputeDerivativeThreaderCallback( void ) const
+{
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->ComputeDerivativeThreaderCallback,
+    const_cast< void * >( static_cast< const void * >(
+      &this->m_PCAMetric2ThreaderParameters ) ) );
+
+} // end LaunchComputeDerivativeThreaderCallback()
+
+
 } // end namespace itk
 
 #endif // __itkPCAMetric2_HXX__
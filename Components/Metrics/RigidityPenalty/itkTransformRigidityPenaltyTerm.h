@@ -27,7 +27,6 @@
 /** Needed for the filtering of the B-spline coefficients. */
 #include "itkNeighborhood.h"
 #include "itkImageRegionIterator.h"
-#include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkNeighborhoodIterator.h"
 
 /** Include stuff needed for the construction of the rigidity coefficient image. */
@@ -52,6 +51,14 @@ namespace itk
  * The RigidityPenaltyTermValueImageFilter at each pixel location is computed by
  * convolution with some separable 1D kernels.
  *
+ * The filtering is done on preallocated buffers that are reused between
+ * evaluations. Operators that start with the same 1D kernels share these
+ * passes, and all passes and the per-voxel computations are multi-threaded
+ * over slabs of the coefficient images, when UseMultiThread is set. Every
+ * voxel is computed with the same arithmetic as before, and the sums are
+ * accumulated in the same order, so the value and derivative do not depend
+ * on the number of threads.
+ *
  * The rigid penalty term penalizes deviations from a rigid
  * transformation at regions specified by the so-called rigidity images.
  *
@@ -122,6 +129,7 @@ public:
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
   typedef typename Superclass::ScalarType                   ScalarType;
+  typedef typename Superclass::ThreadInfoType               ThreadInfoType;
 
   /** Typedef's for the B-spline transform. */
   typedef typename Superclass::CombinationTransformType       CombinationTransformType;
@@ -160,8 +168,6 @@ public:
     itkGetStaticConstMacro( FixedImageDimension ) >     NeighborhoodType;
   typedef typename NeighborhoodType::SizeType           NeighborhoodSizeType;
   typedef ImageRegionIterator< CoefficientImageType >   CoefficientImageIteratorType;
-  typedef NeighborhoodOperatorImageFilter<
-    CoefficientImageType, CoefficientImageType >        NOIFType;
   typedef NeighborhoodIterator< CoefficientImageType >  NeighborhoodIteratorType;
   typedef typename NeighborhoodIteratorType::RadiusType RadiusType;
 
@@ -322,9 +328,86 @@ private:
   void CreateNDOperator( NeighborhoodType & F, const std::string & whichF,
     const CoefficientImageSpacingType & spacing ) const;
 
-  /** Private function used for the filtering. It performs 1D separable filtering. */
-  CoefficientImagePointer FilterSeparable( const CoefficientImageType *,
-    const std::vector< NeighborhoodType > & Operators ) const;
+  /** Typedefs for the filtering. The 1D passes accumulate in the same type as
+   * the NeighborhoodOperatorImageFilter that was used before.
+   */
+  typedef typename CoefficientImageType::PixelType                 CoefficientPixelType;
+  typedef typename CoefficientImageType::SizeType                  CoefficientImageSizeType;
+  typedef typename NumericTraits< CoefficientPixelType >::RealType FilterValueType;
+  typedef std::vector< CoefficientPixelType >                      BufferType;
+
+  /** One 1D pass of the separable filtering: the output of pass st_Input,
+   * or the B-spline coefficients if st_Input is -1, filtered along
+   * st_Dimension with st_Kernel.
+   */
+  struct SeparablePassType
+  {
+    int          st_Input;
+    unsigned int st_Dimension;
+    ScalarType   st_Kernel[ 3 ];
+  };
+
+  /** The multi-threaded stages of the evaluation. */
+  enum EvaluationStageType {
+    FilterCoefficientsStage,
+    ComputeSubpartsStage,
+    FilterSubpartsStage,
+    ComputeDerivativeStage
+  };
+
+  /** Helper struct that passes the stage to the threads. */
+  struct RigidityThreaderParameterType
+  {
+    const Self *          st_Metric;
+    EvaluationStageType   st_Stage;
+    unsigned int          st_Dimension;
+    bool                  st_ComputeSubparts;
+    ScalarType            st_RigidityCoefficientSum;
+    DerivativeValueType * st_DerivativePointer;
+  };
+
+  /** Create the 1D passes and the ND operators, and allocate the buffers,
+   * if the B-spline grid changed or a needed condition is not set up yet.
+   * The calculated conditions are needed for the value; all conditions are
+   * needed for the derivative, since the gradient magnitudes of all
+   * conditions are reported.
+   */
+  void InitializeFilterEngine( const bool allConditions ) const;
+
+  /** Get the B-spline coefficients of dimension i filtered with one of the
+   * operators A to I.
+   */
+  const CoefficientPixelType * GetFilteredCoefficients(
+    const unsigned int whichOperator, const unsigned int dimension ) const;
+
+  /** Filter the B-spline coefficient images with the operators A to I. */
+  void FilterCoefficientImages( const bool allConditions ) const;
+
+  /** Compute the contributions of all voxels to the orthonormality and
+   * properness values, and optionally the subparts of the derivative, and
+   * add the values, the linearity value included, in voxel order.
+   */
+  void ComputeConditionValues( const bool computeSubparts ) const;
+
+  /** Run one stage, multi-threaded when m_UseMultiThread is set. */
+  void LaunchEvaluationStage( RigidityThreaderParameterType & parameters ) const;
+
+  /** Threader callback function of the stages. */
+  static ITK_THREAD_RETURN_TYPE EvaluationThreaderCallback( void * arg );
+
+  /** Run a stage for the slab of voxels of one thread. */
+  void ThreadedEvaluationStage( const RigidityThreaderParameterType & parameters,
+    const ThreadIdType threadID, const ThreadIdType numberOfThreads ) const;
+
+  /** The stages, for the voxels [begin, end). */
+  void ThreadedFilterCoefficientImages( const unsigned int dimension,
+    const SizeValueType begin, const SizeValueType end ) const;
+  void ThreadedComputeSubparts( const bool computeSubparts,
+    const SizeValueType begin, const SizeValueType end ) const;
+  void ThreadedFilterSubparts( const SizeValueType begin, const SizeValueType end ) const;
+  void ThreadedComputeDerivative( const ScalarType rigidityCoefficientSum,
+    DerivativeValueType * derivative,
+    const SizeValueType begin, const SizeValueType end ) const;
 
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
@@ -361,6 +444,24 @@ private:
   bool                               m_UseFixedRigidityImage;
   bool                               m_UseMovingRigidityImage;
 
+  /** Filter engine variables. The operators A to I have index 0 to 8. */
+  mutable bool                             m_FilterEngineIsInitialized;
+  mutable CoefficientImageSizeType         m_FilterEngineSize;
+  mutable CoefficientImageSpacingType      m_FilterEngineSpacing;
+  mutable bool                             m_FilterEngineConditions[ 3 ];
+  mutable SizeValueType                    m_NumberOfCoefficients;
+  mutable std::vector< SeparablePassType > m_SeparablePasses;
+  mutable std::vector< int >               m_FilteredCoefficientsPass;
+  mutable std::vector< NeighborhoodType >  m_NDOperators;
+  mutable std::vector< BufferType >        m_SeparablePassOutputs;
+  mutable std::vector< BufferType >        m_OrthonormalitySubparts;
+  mutable std::vector< BufferType >        m_PropernessSubparts;
+  mutable std::vector< BufferType >        m_FilteredOrthonormalitySubparts;
+  mutable std::vector< BufferType >        m_FilteredPropernessSubparts;
+  mutable std::vector< BufferType >        m_FilteredLinearitySubparts;
+  mutable std::vector< MeasureType >       m_OrthonormalityValues;
+  mutable std::vector< MeasureType >       m_PropernessValues;
+
 };
 
 } // end namespace itk
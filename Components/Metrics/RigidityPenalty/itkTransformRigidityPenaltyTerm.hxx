@@ -87,6 +87,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
 
   this->m_BSplineTransform = NULL;
 
+  /** The filter engine is set up at the first evaluation. */
+  this->m_FilterEngineIsInitialized = false;
+  this->m_NumberOfCoefficients      = 0;
+
 } // end Constructor
 
 
@@ -167,6 +171,9 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   /** Reset the filling bool. */
   this->m_RigidityCoefficientImageIsFilled = false;
 
+  /** The B-spline grid may have changed, so set up the filter engine again. */
+  this->m_FilterEngineIsInitialized = false;
+
 } // end Initialize()
 
 
@@ -495,16 +502,6 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     itkExceptionMacro( << "ERROR: This filter is only implemented for dimension 2 and 3." );
   }
 
-  /** Get a handle to the B-spline coefficient images. */
-  std::vector< CoefficientImagePointer > inputImages( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    inputImages[ i ] = this->m_BSplineTransform->GetCoefficientImages()[ i ];
-  }
-
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
-
   /** TASK 0:
    * Compute the rigidityCoefficientSum and check on it.
    *
@@ -531,328 +528,20 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }
 
   /** TASK 1:
-   * Prepare for the calculation of the rigidity penalty term.
+   * Filter the B-spline coefficient images.
    *
    ************************************************************************* */
 
-  /** Create 1D neighbourhood operators. */
-  std::vector< NeighborhoodType > Operators_A( ImageDimension ),
-  Operators_B( ImageDimension ), Operators_C( ImageDimension ),
-  Operators_D( ImageDimension ), Operators_E( ImageDimension ),
-  Operators_F( ImageDimension ), Operators_G( ImageDimension ),
-  Operators_H( ImageDimension ), Operators_I( ImageDimension );
-
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector< CoefficientImagePointer > ui_FA( ImageDimension ),
-  ui_FB( ImageDimension ), ui_FC( ImageDimension ),
-  ui_FD( ImageDimension ), ui_FE( ImageDimension ),
-  ui_FF( ImageDimension ), ui_FG( ImageDimension ),
-  ui_FH( ImageDimension ), ui_FI( ImageDimension );
-
-  /** For all dimensions ... */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    /** ... create the filtered images ... */
-    ui_FA[ i ] = CoefficientImageType::New();
-    ui_FB[ i ] = CoefficientImageType::New();
-    ui_FD[ i ] = CoefficientImageType::New();
-    ui_FE[ i ] = CoefficientImageType::New();
-    ui_FG[ i ] = CoefficientImageType::New();
-    if( ImageDimension == 3 )
-    {
-      ui_FC[ i ] = CoefficientImageType::New();
-      ui_FF[ i ] = CoefficientImageType::New();
-      ui_FH[ i ] = CoefficientImageType::New();
-      ui_FI[ i ] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
-     * The operators C, D and E from the paper are here created
-     * by Create1DOperator D, E and G, because of the 3D case and history.
-     */
-    this->Create1DOperator( Operators_A[ i ], "FA_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_B[ i ], "FB_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_D[ i ], "FD_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_E[ i ], "FE_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_G[ i ], "FG_xi", i + 1, spacing );
-    if( ImageDimension == 3 )
-    {
-      this->Create1DOperator( Operators_C[ i ], "FC_xi", i + 1, spacing );
-      this->Create1DOperator( Operators_F[ i ], "FF_xi", i + 1, spacing );
-      this->Create1DOperator( Operators_H[ i ], "FH_xi", i + 1, spacing );
-      this->Create1DOperator( Operators_I[ i ], "FI_xi", i + 1, spacing );
-    }
-  } // end for loop
+  this->FilterCoefficientImages( false );
 
   /** TASK 2:
-   * Filter the B-spline coefficient images.
+   * Calculate the orthonormality, properness and linearity terms.
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    ui_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A );
-    ui_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B );
-    ui_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D );
-    ui_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E );
-    ui_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G );
-    if( ImageDimension == 3 )
-    {
-      ui_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C );
-      ui_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F );
-      ui_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H );
-      ui_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I );
-    }
-  }
+  this->ComputeConditionValues( false );
 
   /** TASK 3:
-   * Create iterators.
-   *
-   ************************************************************************* */
-
-  /** Create iterators over ui_F?. */
-  std::vector< CoefficientImageIteratorType > itA( ImageDimension ),
-  itB( ImageDimension ), itC( ImageDimension ),
-  itD( ImageDimension ), itE( ImageDimension ),
-  itF( ImageDimension ), itG( ImageDimension ),
-  itH( ImageDimension ), itI( ImageDimension );
-
-  /** Create iterators. */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    /** Create iterators. */
-    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], ui_FA[ i ]->GetLargestPossibleRegion() );
-    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], ui_FB[ i ]->GetLargestPossibleRegion() );
-    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], ui_FD[ i ]->GetLargestPossibleRegion() );
-    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], ui_FE[ i ]->GetLargestPossibleRegion() );
-    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], ui_FG[ i ]->GetLargestPossibleRegion() );
-    if( ImageDimension == 3 )
-    {
-      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], ui_FC[ i ]->GetLargestPossibleRegion() );
-      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], ui_FF[ i ]->GetLargestPossibleRegion() );
-      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], ui_FH[ i ]->GetLargestPossibleRegion() );
-      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], ui_FI[ i ]->GetLargestPossibleRegion() );
-    }
-    /** Reset iterators. */
-    itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
-    itD[ i ].GoToBegin(); itE[ i ].GoToBegin(); itG[ i ].GoToBegin();
-    if( ImageDimension == 3 )
-    {
-      itC[ i ].GoToBegin(); itF[ i ].GoToBegin();
-      itH[ i ].GoToBegin(); itI[ i ].GoToBegin();
-    }
-  }
-
-  /** TASK 4A:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the orthonormality term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if( this->m_CalculateOrthonormalityCondition )
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    while( !itA[ 0 ].IsAtEnd() )
-    {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[ 0 ].Get(); mu2_A = itA[ 1 ].Get();
-      mu1_B = itB[ 0 ].Get(); mu2_B = itB[ 1 ].Get();
-      if( ImageDimension == 3 )
-      {
-        mu3_A = itA[ 2 ].Get(); mu3_B = itB[ 2 ].Get();
-        mu1_C = itC[ 0 ].Get(); mu2_C = itC[ 1 ].Get(); mu3_C = itC[ 2 ].Get();
-      }
-
-      if( ImageDimension == 2 )
-      {
-        this->m_OrthonormalityConditionValue
-          += it_RCI.Get() * (
-          vcl_pow(
-          +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          + mu2_A * mu2_A
-          - 1.0,
-          2.0 )
-          + vcl_pow(
-          +mu1_B * mu1_B
-          + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          - 1.0,
-          2.0 )
-          + vcl_pow(
-          +( 1.0 + mu1_A ) * mu1_B
-          + mu2_A * ( 1.0 + mu2_B ),
-          2.0 )
-          );
-      }
-      else if( ImageDimension == 3 )
-      {
-        this->m_OrthonormalityConditionValue
-          += it_RCI.Get() * (
-          vcl_pow(
-          +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          + mu2_A * mu2_A
-          + mu3_A * mu3_A
-          - 1.0,
-          2.0 )
-          + vcl_pow(
-          +( 1.0 + mu1_A ) * mu1_B
-          + mu2_A * ( 1.0 + mu2_B )
-          + mu3_A * mu3_B,
-          2.0 )
-          + vcl_pow(
-          +( 1.0 + mu1_A ) * mu1_C
-          + mu2_A * mu2_C
-          + mu3_A * ( 1.0 + mu3_C ),
-          2.0 )
-          + vcl_pow(
-          +mu1_B * mu1_B
-          + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          + mu3_B * mu3_B
-          - 1.0,
-          2.0 )
-          + vcl_pow(
-          +mu1_B * mu1_C
-          + ( 1.0 + mu2_B ) * mu2_C
-          + mu3_B * ( 1.0 + mu3_C ),
-          2.0 )
-          + vcl_pow(
-          +mu1_C * mu1_C
-          + mu2_C * mu2_C
-          + ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - 1.0,
-          2.0 ) );
-      }
-
-      /** Increase all iterators. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        ++itA[ i ]; ++itB[ i ];
-        if( ImageDimension == 3 ) { ++itC[ i ]; }
-      }
-      ++it_RCI;
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 4B:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the properness term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
-    if( ImageDimension == 3 ) { itC[ i ].GoToBegin(); }
-  }
-  it_RCI.GoToBegin();
-
-  if( this->m_CalculatePropernessCondition )
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    while( !itA[ 0 ].IsAtEnd() )
-    {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[ 0 ].Get(); mu2_A = itA[ 1 ].Get();
-      mu1_B = itB[ 0 ].Get(); mu2_B = itB[ 1 ].Get();
-      if( ImageDimension == 3 )
-      {
-        mu3_A = itA[ 2 ].Get(); mu3_B = itB[ 2 ].Get();
-        mu1_C = itC[ 0 ].Get(); mu2_C = itC[ 1 ].Get(); mu3_C = itC[ 2 ].Get();
-      }
-
-      if( ImageDimension == 2 )
-      {
-        this->m_PropernessConditionValue
-          += it_RCI.Get() * (
-          vcl_pow(
-          +( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
-          - mu2_A * mu1_B
-          - 1.0,
-          2.0 )
-          );
-      }
-      else if( ImageDimension == 3 )
-      {
-        this->m_PropernessConditionValue
-          += it_RCI.Get() * (
-          vcl_pow(
-          -mu1_C * ( 1.0 + mu2_B ) * mu3_A
-          + mu1_B * mu2_C * mu3_A
-          + mu1_C * mu2_A * mu3_B
-          - ( 1.0 + mu1_A ) * mu2_C * mu3_B
-          - mu1_B * mu2_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
-          - 1.0,
-          2.0 )
-          );
-      }
-
-      /** Increase all iterators. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        ++itA[ i ]; ++itB[ i ];
-        if( ImageDimension == 3 ) { ++itC[ i ]; }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 4C:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the linearity term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if( this->m_CalculateLinearityCondition )
-  {
-    while( !itD[ 0 ].IsAtEnd() )
-    {
-      /** Linearity condition part. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        this->m_LinearityConditionValue
-          += it_RCI.Get() * (
-          +itD[ i ].Get() * itD[ i ].Get()
-          + itE[ i ].Get() * itE[ i ].Get()
-          + itG[ i ].Get() * itG[ i ].Get()
-          );
-        if( ImageDimension == 3 )
-        {
-          this->m_LinearityConditionValue
-            += it_RCI.Get() * (
-            +itF[ i ].Get() * itF[ i ].Get()
-            + itH[ i ].Get() * itH[ i ].Get()
-            + itI[ i ].Get() * itI[ i ].Get()
-            );
-        }
-      } // end loop over i
-
-      /** Increase all iterators. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        ++itD[ i ]; ++itE[ i ]; ++itG[ i ];
-        if( ImageDimension == 3 )
-        {
-          ++itF[ i ]; ++itH[ i ]; ++itI[ i ];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 5:
    * Do the actual calculation of the rigidity penalty term value.
    *
    ************************************************************************* */
@@ -979,16 +668,6 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     itkExceptionMacro( << "ERROR: This filter is only implemented for dimension 2 and 3." );
   }
 
-  /** Get a handle to the B-spline coefficient images. */
-  std::vector< CoefficientImagePointer > inputImages( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    inputImages[ i ] = this->m_BSplineTransform->GetCoefficientImages()[ i ];
-  }
-
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
-
   /** TASK 0:
    * Compute the rigidityCoefficientSum and check on it.
    *
@@ -1015,205 +694,591 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }
 
   /** TASK 1:
-   * Prepare for the calculation of the rigidity penalty term.
+   * Filter the B-spline coefficient images.
    *
    ************************************************************************* */
 
-  /** Create 1D neighbourhood operators. */
-  std::vector< NeighborhoodType > Operators_A( ImageDimension ),
-  Operators_B( ImageDimension ), Operators_C( ImageDimension ),
-  Operators_D( ImageDimension ), Operators_E( ImageDimension ),
-  Operators_F( ImageDimension ), Operators_G( ImageDimension ),
-  Operators_H( ImageDimension ), Operators_I( ImageDimension );
-
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector< CoefficientImagePointer > ui_FA( ImageDimension ),
-  ui_FB( ImageDimension ), ui_FC( ImageDimension ),
-  ui_FD( ImageDimension ), ui_FE( ImageDimension ),
-  ui_FF( ImageDimension ), ui_FG( ImageDimension ),
-  ui_FH( ImageDimension ), ui_FI( ImageDimension );
-
-  /** For all dimensions ... */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    /** ... create the filtered images ... */
-    ui_FA[ i ] = CoefficientImageType::New();
-    ui_FB[ i ] = CoefficientImageType::New();
-    ui_FD[ i ] = CoefficientImageType::New();
-    ui_FE[ i ] = CoefficientImageType::New();
-    ui_FG[ i ] = CoefficientImageType::New();
-    if( ImageDimension == 3 )
-    {
-      ui_FC[ i ] = CoefficientImageType::New();
-      ui_FF[ i ] = CoefficientImageType::New();
-      ui_FH[ i ] = CoefficientImageType::New();
-      ui_FI[ i ] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
-     * The operators C, D and E from the paper are here created
-     * by Create1DOperator D, E and G, because of the 3D case and history.
-     */
-    this->Create1DOperator( Operators_A[ i ], "FA_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_B[ i ], "FB_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_D[ i ], "FD_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_E[ i ], "FE_xi", i + 1, spacing );
-    this->Create1DOperator( Operators_G[ i ], "FG_xi", i + 1, spacing );
-    if( ImageDimension == 3 )
-    {
-      this->Create1DOperator( Operators_C[ i ], "FC_xi", i + 1, spacing );
-      this->Create1DOperator( Operators_F[ i ], "FF_xi", i + 1, spacing );
-      this->Create1DOperator( Operators_H[ i ], "FH_xi", i + 1, spacing );
-      this->Create1DOperator( Operators_I[ i ], "FI_xi", i + 1, spacing );
-    }
-  } // end for loop
+  this->FilterCoefficientImages( true );
 
   /** TASK 2:
-   * Filter the B-spline coefficient images.
+   * Calculate the orthonormality, properness and linearity terms,
+   * and the subparts of their derivatives.
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    ui_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A );
-    ui_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B );
-    ui_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D );
-    ui_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E );
-    ui_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G );
-    if( ImageDimension == 3 )
-    {
-      ui_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C );
-      ui_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F );
-      ui_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H );
-      ui_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I );
-    }
-  }
+  this->ComputeConditionValues( true );
 
   /** TASK 3:
-   * Create subparts and iterators.
+   * Do the actual calculation of the rigidity penalty term value.
    *
    ************************************************************************* */
 
-  /** Create iterators over ui_F?. */
-  std::vector< CoefficientImageIteratorType > itA( ImageDimension ),
-  itB( ImageDimension ), itC( ImageDimension ),
-  itD( ImageDimension ), itE( ImageDimension ),
-  itF( ImageDimension ), itG( ImageDimension ),
-  itH( ImageDimension ), itI( ImageDimension );
-
-  /** Create iterators. */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  /** Calculate the rigidity penalty term value. */
+  if( this->m_CalculateLinearityCondition )
   {
-    /** Create iterators. */
-    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], ui_FA[ i ]->GetLargestPossibleRegion() );
-    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], ui_FB[ i ]->GetLargestPossibleRegion() );
-    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], ui_FD[ i ]->GetLargestPossibleRegion() );
-    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], ui_FE[ i ]->GetLargestPossibleRegion() );
-    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], ui_FG[ i ]->GetLargestPossibleRegion() );
-    if( ImageDimension == 3 )
-    {
-      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], ui_FC[ i ]->GetLargestPossibleRegion() );
-      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], ui_FF[ i ]->GetLargestPossibleRegion() );
-      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], ui_FH[ i ]->GetLargestPossibleRegion() );
-      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], ui_FI[ i ]->GetLargestPossibleRegion() );
-    }
-    /** Reset iterators. */
-    itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
-    itD[ i ].GoToBegin(); itE[ i ].GoToBegin(); itG[ i ].GoToBegin();
-    if( ImageDimension == 3 )
-    {
-      itC[ i ].GoToBegin(); itF[ i ].GoToBegin();
-      itH[ i ].GoToBegin(); itI[ i ].GoToBegin();
-    }
+    this->m_LinearityConditionValue /= rigidityCoefficientSum;
   }
-
-  /** Create orthonormality and properness parts. */
-  std::vector< std::vector< CoefficientImagePointer > > OCparts( ImageDimension );
-  std::vector< std::vector< CoefficientImagePointer > > PCparts( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  if( this->m_CalculateOrthonormalityCondition )
   {
-    OCparts[ i ].resize( ImageDimension );
-    PCparts[ i ].resize( ImageDimension );
-    for( unsigned int j = 0; j < ImageDimension; j++ )
-    {
-      OCparts[ i ][ j ] = CoefficientImageType::New();
-      OCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      OCparts[ i ][ j ]->Allocate();
-      PCparts[ i ][ j ] = CoefficientImageType::New();
-      PCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      PCparts[ i ][ j ]->Allocate();
-    }
+    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
   }
-
-  /** Create linearity parts. */
-  unsigned int                                          NofLParts = 3 * ImageDimension - 3;
-  std::vector< std::vector< CoefficientImagePointer > > LCparts( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  if( this->m_CalculatePropernessCondition )
   {
-    LCparts[ i ].resize( NofLParts );
-    for( unsigned int j = 0; j < NofLParts; j++ )
-    {
-      LCparts[ i ][ j ] = CoefficientImageType::New();
-      LCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      LCparts[ i ][ j ]->Allocate();
-    }
+    this->m_PropernessConditionValue /= rigidityCoefficientSum;
   }
 
-  /** Create iterators over all parts. */
-  std::vector< std::vector< CoefficientImageIteratorType > > itOCp( ImageDimension );
-  std::vector< std::vector< CoefficientImageIteratorType > > itPCp( ImageDimension );
-  std::vector< std::vector< CoefficientImageIteratorType > > itLCp( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  if( this->m_UseLinearityCondition )
   {
-    itOCp[ i ].resize( ImageDimension );
-    itPCp[ i ].resize( ImageDimension );
-    itLCp[ i ].resize( NofLParts );
-    for( unsigned int j = 0; j < ImageDimension; j++ )
-    {
-      itOCp[ i ][ j ] = CoefficientImageIteratorType( OCparts[ i ][ j ],
-        OCparts[ i ][ j ]->GetLargestPossibleRegion() );
-      itOCp[ i ][ j ].GoToBegin();
-      itPCp[ i ][ j ] = CoefficientImageIteratorType( PCparts[ i ][ j ],
-        PCparts[ i ][ j ]->GetLargestPossibleRegion() );
-      itPCp[ i ][ j ].GoToBegin();
-    }
-    for( unsigned int j = 0; j < NofLParts; j++ )
-    {
-      itLCp[ i ][ j ] = CoefficientImageIteratorType( LCparts[ i ][ j ],
-        LCparts[ i ][ j ]->GetLargestPossibleRegion() );
-      itLCp[ i ][ j ].GoToBegin();
-    }
+    this->m_RigidityPenaltyTermValue
+      += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
   }
-
-  /** TASK 4A:
-   * Do the calculation of the orthonormality subparts.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
+  if( this->m_UseOrthonormalityCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
+  }
+  if( this->m_UsePropernessCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
+  }
+  value = this->m_RigidityPenaltyTermValue;
+
+  /** TASK 4:
+   * Calculate the filtered versions of the subparts.
+   * These are F_A * {subpart_0} + F_B * {subpart_1},
+   * and (for 3D) + F_C * {subpart_2}, for the orthonormality and
+   * properness subparts, and sum_{i=1}^{NofLParts} F_{D,E,G,F,H,I} * {subpart_i}
+   * for the linearity subparts, for all dimensions.
+   ************************************************************************* */
+
+  RigidityThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric                 = this;
+  threaderParameters.st_Stage                  = FilterSubpartsStage;
+  threaderParameters.st_Dimension              = 0;
+  threaderParameters.st_ComputeSubparts        = true;
+  threaderParameters.st_RigidityCoefficientSum = rigidityCoefficientSum;
+  threaderParameters.st_DerivativePointer      = derivative.data_block();
+  this->LaunchEvaluationStage( threaderParameters );
+
+  /** TASK 5:
+   * Add it all to create the final derivative.
+   ************************************************************************* */
+
+  threaderParameters.st_Stage = ComputeDerivativeStage;
+  this->LaunchEvaluationStage( threaderParameters );
+
+  /** Compute the gradient magnitudes of the several terms, in voxel order.
+   * NOTE: unlike the values, for the derivatives weight * derivative is returned.
+   */
+  MeasureType gradMagLC                 = NumericTraits< MeasureType >::Zero;
+  MeasureType gradMagOC                 = NumericTraits< MeasureType >::Zero;
+  MeasureType gradMagPC                 = NumericTraits< MeasureType >::Zero;
+  double      rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
+  for( SizeValueType v = 0; v < this->m_NumberOfCoefficients; ++v )
+  {
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      /** Compute gradient magnitude of LC. */
+      ScalarType tmpLC = this->m_LinearityConditionWeight
+        * this->m_FilteredLinearitySubparts[ i ][ v ];
+      gradMagLC += tmpLC * tmpLC / rigidityCoefficientSumSqr;
+
+      /** Compute gradient magnitude of OC. */
+      ScalarType tmpOC = this->m_OrthonormalityConditionWeight
+        * this->m_FilteredOrthonormalitySubparts[ i ][ v ];
+      gradMagOC += tmpOC * tmpOC / rigidityCoefficientSumSqr;
+
+      /** Compute gradient magnitude of PC. */
+      ScalarType tmpPC = this->m_PropernessConditionWeight
+        * this->m_FilteredPropernessSubparts[ i ][ v ];
+      gradMagPC += tmpPC * tmpPC / rigidityCoefficientSumSqr;
+    }
+  }
+
+  /** Set the gradient magnitudes of the several terms. */
+  this->m_LinearityConditionGradientMagnitude      = vcl_sqrt( gradMagLC );
+  this->m_OrthonormalityConditionGradientMagnitude = vcl_sqrt( gradMagOC );
+  this->m_PropernessConditionGradientMagnitude     = vcl_sqrt( gradMagPC );
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ********************* InitializeFilterEngine ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::InitializeFilterEngine( const bool allConditions ) const
+{
+  /** Get the B-spline coefficient image size and spacing. */
+  const CoefficientImagePointer coefficientImage
+    = this->m_BSplineTransform->GetCoefficientImages()[ 0 ];
+  const CoefficientImageSizeType size
+    = coefficientImage->GetLargestPossibleRegion().GetSize();
+  const CoefficientImageSpacingType spacing = coefficientImage->GetSpacing();
+
+  /** Nothing has to be done if the grid did not change, and the needed
+   * conditions are already set up. The engine is not reduced when fewer
+   * conditions are needed, so that alternating GetValue() and
+   * GetValueAndDerivative() calls do not reallocate the buffers.
+   */
+  const bool conditions[ 3 ] = {
+    this->m_CalculateOrthonormalityCondition || allConditions,
+    this->m_CalculatePropernessCondition || allConditions,
+    this->m_CalculateLinearityCondition || allConditions
+  };
+  if( this->m_FilterEngineIsInitialized
+    && size == this->m_FilterEngineSize
+    && spacing == this->m_FilterEngineSpacing
+    && ( !conditions[ 0 ] || this->m_FilterEngineConditions[ 0 ] )
+    && ( !conditions[ 1 ] || this->m_FilterEngineConditions[ 1 ] )
+    && ( !conditions[ 2 ] || this->m_FilterEngineConditions[ 2 ] ) )
+  {
+    return;
+  }
+
+  /** Determine which operators are needed. The operators C, F, H and I
+   * only exist in 3D.
+   */
+  const char * operatorNames[ 9 ] = { "FA", "FB", "FC", "FD", "FE", "FF", "FG", "FH", "FI" };
+  const bool   needAB             = conditions[ 0 ] || conditions[ 1 ];
+  const bool   needDEG            = conditions[ 2 ];
+  const bool   is3D               = ImageDimension == 3;
+  const bool   useOperator[ 9 ]   = {
+    needAB, needAB, needAB && is3D,
+    needDEG, needDEG, needDEG && is3D,
+    needDEG, needDEG && is3D, needDEG && is3D
+  };
+
+  /** Create the 1D passes of the separable operators, and the ND operators.
+   * The passes of an operator filter along the dimensions one after another.
+   * An operator that starts with the same 1D kernels as an earlier operator
+   * reuses the output of its passes.
+   */
+  this->m_SeparablePasses.clear();
+  this->m_FilteredCoefficientsPass.assign( 9, -1 );
+  this->m_NDOperators.assign( 9, NeighborhoodType() );
+  for( unsigned int o = 0; o < 9; o++ )
+  {
+    if( !useOperator[ o ] ) { continue; }
+
+    int input = -1;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+      NeighborhoodType F;
+      this->Create1DOperator( F, std::string( operatorNames[ o ] ) + "_xi", d + 1, spacing );
+
+      SeparablePassType pass;
+      pass.st_Input     = input;
+      pass.st_Dimension = d;
+      for( unsigned int k = 0; k < 3; k++ )
+      {
+        pass.st_Kernel[ k ] = F[ k ];
+      }
+
+      /** Look for an identical pass. */
+      int passIndex = -1;
+      for( unsigned int p = 0; p < this->m_SeparablePasses.size(); p++ )
+      {
+        const SeparablePassType & other = this->m_SeparablePasses[ p ];
+        if( other.st_Input == pass.st_Input && other.st_Dimension == pass.st_Dimension
+          && other.st_Kernel[ 0 ] == pass.st_Kernel[ 0 ]
+          && other.st_Kernel[ 1 ] == pass.st_Kernel[ 1 ]
+          && other.st_Kernel[ 2 ] == pass.st_Kernel[ 2 ] )
+        {
+          passIndex = static_cast< int >( p );
+          break;
+        }
+      }
+      if( passIndex < 0 )
+      {
+        this->m_SeparablePasses.push_back( pass );
+        passIndex = static_cast< int >( this->m_SeparablePasses.size() ) - 1;
+      }
+      input = passIndex;
+    }
+    this->m_FilteredCoefficientsPass[ o ] = input;
+
+    this->CreateNDOperator( this->m_NDOperators[ o ], operatorNames[ o ], spacing );
+  }
+
+  /** Allocate the buffers. */
+  SizeValueType numberOfCoefficients = 1;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+  {
+    numberOfCoefficients *= size[ d ];
+  }
+  const BufferType buffer( numberOfCoefficients, NumericTraits< CoefficientPixelType >::ZeroValue() );
+  this->m_SeparablePassOutputs.assign( this->m_SeparablePasses.size() * ImageDimension, buffer );
+  this->m_OrthonormalitySubparts.assign(
+    conditions[ 0 ] ? ImageDimension * ImageDimension : 0, buffer );
+  this->m_PropernessSubparts.assign(
+    conditions[ 1 ] ? ImageDimension * ImageDimension : 0, buffer );
+  this->m_FilteredOrthonormalitySubparts.assign( ImageDimension, buffer );
+  this->m_FilteredPropernessSubparts.assign( ImageDimension, buffer );
+  this->m_FilteredLinearitySubparts.assign( ImageDimension, buffer );
+  this->m_OrthonormalityValues.assign( conditions[ 0 ] ? numberOfCoefficients : 0,
+    NumericTraits< MeasureType >::Zero );
+  this->m_PropernessValues.assign( conditions[ 1 ] ? numberOfCoefficients : 0,
+    NumericTraits< MeasureType >::Zero );
+
+  /** Remember for which grid and conditions the engine was set up. */
+  this->m_NumberOfCoefficients        = numberOfCoefficients;
+  this->m_FilterEngineSize            = size;
+  this->m_FilterEngineSpacing         = spacing;
+  this->m_FilterEngineConditions[ 0 ] = conditions[ 0 ];
+  this->m_FilterEngineConditions[ 1 ] = conditions[ 1 ];
+  this->m_FilterEngineConditions[ 2 ] = conditions[ 2 ];
+  this->m_FilterEngineIsInitialized   = true;
+
+} // end InitializeFilterEngine()
+
+
+/**
+ * ********************* GetFilteredCoefficients ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+const typename TransformRigidityPenaltyTerm< TFixedImage, TScalarType >::CoefficientPixelType *
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::GetFilteredCoefficients( const unsigned int whichOperator, const unsigned int dimension ) const
+{
+  const unsigned int pass = this->m_FilteredCoefficientsPass[ whichOperator ];
+  return &this->m_SeparablePassOutputs[ pass * ImageDimension + dimension ][ 0 ];
+
+} // end GetFilteredCoefficients()
+
+
+/**
+ * ********************* FilterCoefficientImages ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::FilterCoefficientImages( const bool allConditions ) const
+{
+  /** Make sure the passes and the buffers match the current grid. */
+  this->InitializeFilterEngine( allConditions );
+
+  /** The passes along a dimension only need the output of the passes along
+   * the previous dimension, so they run one dimension at a time.
+   */
+  RigidityThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric                 = this;
+  threaderParameters.st_Stage                  = FilterCoefficientsStage;
+  threaderParameters.st_ComputeSubparts        = false;
+  threaderParameters.st_RigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
+  threaderParameters.st_DerivativePointer      = NULL;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+  {
+    threaderParameters.st_Dimension = d;
+    this->LaunchEvaluationStage( threaderParameters );
+  }
+
+} // end FilterCoefficientImages()
+
+
+/**
+ * ********************* ComputeConditionValues ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionValues( const bool computeSubparts ) const
+{
+  /** Compute the orthonormality and properness terms of all voxels,
+   * and the subparts of the derivative.
+   */
+  RigidityThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric                 = this;
+  threaderParameters.st_Stage                  = ComputeSubpartsStage;
+  threaderParameters.st_Dimension              = 0;
+  threaderParameters.st_ComputeSubparts        = computeSubparts;
+  threaderParameters.st_RigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
+  threaderParameters.st_DerivativePointer      = NULL;
+  this->LaunchEvaluationStage( threaderParameters );
+
+  /** Add the terms in voxel order, so that the result does not depend on
+   * the number of threads.
+   */
+  const SizeValueType numberOfCoefficients = this->m_NumberOfCoefficients;
   if( this->m_CalculateOrthonormalityCondition )
   {
+    for( SizeValueType v = 0; v < numberOfCoefficients; ++v )
+    {
+      this->m_OrthonormalityConditionValue += this->m_OrthonormalityValues[ v ];
+    }
+  }
+  if( this->m_CalculatePropernessCondition )
+  {
+    for( SizeValueType v = 0; v < numberOfCoefficients; ++v )
+    {
+      this->m_PropernessConditionValue += this->m_PropernessValues[ v ];
+    }
+  }
+
+  /** The linearity terms are cheap, so they are added here directly. */
+  if( this->m_CalculateLinearityCondition )
+  {
+    const CoefficientPixelType * rci = this->m_RigidityCoefficientImage->GetBufferPointer();
+    const CoefficientPixelType * D[ ImageDimension ];
+    const CoefficientPixelType * E[ ImageDimension ];
+    const CoefficientPixelType * F[ ImageDimension ];
+    const CoefficientPixelType * G[ ImageDimension ];
+    const CoefficientPixelType * H[ ImageDimension ];
+    const CoefficientPixelType * I[ ImageDimension ];
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      D[ i ] = this->GetFilteredCoefficients( 3, i );
+      E[ i ] = this->GetFilteredCoefficients( 4, i );
+      G[ i ] = this->GetFilteredCoefficients( 6, i );
+      if( ImageDimension == 3 )
+      {
+        F[ i ] = this->GetFilteredCoefficients( 5, i );
+        H[ i ] = this->GetFilteredCoefficients( 7, i );
+        I[ i ] = this->GetFilteredCoefficients( 8, i );
+      }
+    }
+
+    for( SizeValueType v = 0; v < numberOfCoefficients; ++v )
+    {
+      for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+        this->m_LinearityConditionValue
+          += rci[ v ] * (
+          +D[ i ][ v ] * D[ i ][ v ]
+          + E[ i ][ v ] * E[ i ][ v ]
+          + G[ i ][ v ] * G[ i ][ v ]
+          );
+        if( ImageDimension == 3 )
+        {
+          this->m_LinearityConditionValue
+            += rci[ v ] * (
+            +F[ i ][ v ] * F[ i ][ v ]
+            + H[ i ][ v ] * H[ i ][ v ]
+            + I[ i ][ v ] * I[ i ][ v ]
+            );
+        }
+      } // end loop over i
+    }   // end loop over v
+  }     // end if do linearity
+
+} // end ComputeConditionValues()
+
+
+/**
+ * ********************* LaunchEvaluationStage ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::LaunchEvaluationStage( RigidityThreaderParameterType & parameters ) const
+{
+  if( !this->m_UseMultiThread )
+  {
+    this->ThreadedEvaluationStage( parameters, 0, 1 );
+    return;
+  }
+
+  this->ExecuteThreaderCallback( this->EvaluationThreaderCallback,
+    static_cast< void * >( &parameters ) );
+
+} // end LaunchEvaluationStage()
+
+
+/**
+ * ********************* EvaluationThreaderCallback ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+ITK_THREAD_RETURN_TYPE
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::EvaluationThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct      = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID        = infoStruct->ThreadID;
+  ThreadIdType     numberOfThreads = infoStruct->NumberOfThreads;
+
+  RigidityThreaderParameterType * temp
+    = static_cast< RigidityThreaderParameterType * >( infoStruct->UserData );
+
+  temp->st_Metric->ThreadedEvaluationStage( *temp, threadID, numberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end EvaluationThreaderCallback()
+
+
+/**
+ * ********************* ThreadedEvaluationStage ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ThreadedEvaluationStage( const RigidityThreaderParameterType & parameters,
+  const ThreadIdType threadID, const ThreadIdType numberOfThreads ) const
+{
+  /** Get the slab of voxels of this thread. */
+  const SizeValueType numberOfCoefficients = this->m_NumberOfCoefficients;
+  const SizeValueType nrOfVoxelsPerThread
+    = static_cast< SizeValueType >( vcl_ceil( static_cast< double >( numberOfCoefficients )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  SizeValueType pos_begin = nrOfVoxelsPerThread * threadID;
+  SizeValueType pos_end   = nrOfVoxelsPerThread * ( threadID + 1 );
+  pos_begin = ( pos_begin > numberOfCoefficients ) ? numberOfCoefficients : pos_begin;
+  pos_end   = ( pos_end > numberOfCoefficients ) ? numberOfCoefficients : pos_end;
+  if( pos_begin == pos_end ) { return; }
+
+  /** Run the stage. */
+  switch( parameters.st_Stage )
+  {
+    case FilterCoefficientsStage:
+      this->ThreadedFilterCoefficientImages( parameters.st_Dimension, pos_begin, pos_end );
+      break;
+    case ComputeSubpartsStage:
+      this->ThreadedComputeSubparts( parameters.st_ComputeSubparts, pos_begin, pos_end );
+      break;
+    case FilterSubpartsStage:
+      this->ThreadedFilterSubparts( pos_begin, pos_end );
+      break;
+    case ComputeDerivativeStage:
+      this->ThreadedComputeDerivative( parameters.st_RigidityCoefficientSum,
+        parameters.st_DerivativePointer, pos_begin, pos_end );
+      break;
+  }
+
+} // end ThreadedEvaluationStage()
+
+
+/**
+ * ********************* ThreadedFilterCoefficientImages ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ThreadedFilterCoefficientImages( const unsigned int dimension,
+  const SizeValueType begin, const SizeValueType end ) const
+{
+  /** Get the distance between neighbors along this dimension. */
+  SizeValueType stride = 1;
+  for( unsigned int d = 0; d < dimension; d++ )
+  {
+    stride *= this->m_FilterEngineSize[ d ];
+  }
+  const SizeValueType length = this->m_FilterEngineSize[ dimension ];
+
+  /** Run all passes along this dimension, for all coefficient images. */
+  for( unsigned int p = 0; p < this->m_SeparablePasses.size(); p++ )
+  {
+    const SeparablePassType & pass = this->m_SeparablePasses[ p ];
+    if( pass.st_Dimension != dimension ) { continue; }
+
+    const FilterValueType k0 = static_cast< FilterValueType >( pass.st_Kernel[ 0 ] );
+    const FilterValueType k1 = static_cast< FilterValueType >( pass.st_Kernel[ 1 ] );
+    const FilterValueType k2 = static_cast< FilterValueType >( pass.st_Kernel[ 2 ] );
+
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      const CoefficientPixelType * input = pass.st_Input < 0
+        ? this->m_BSplineTransform->GetCoefficientImages()[ i ]->GetBufferPointer()
+        : &this->m_SeparablePassOutputs[ pass.st_Input * ImageDimension + i ][ 0 ];
+      CoefficientPixelType * output = &this->m_SeparablePassOutputs[ p * ImageDimension + i ][ 0 ];
+
+      for( SizeValueType v = begin; v < end; ++v )
+      {
+        /** Zero flux Neumann boundary condition: the border value is repeated. */
+        const SizeValueType x        = ( v / stride ) % length;
+        const SizeValueType previous = x > 0 ? v - stride : v;
+        const SizeValueType next     = x + 1 < length ? v + stride : v;
+
+        /** The inner product, in the order of the NeighborhoodInnerProduct. */
+        FilterValueType sum = NumericTraits< FilterValueType >::ZeroValue();
+        sum += k0 * static_cast< FilterValueType >( input[ previous ] );
+        sum += k1 * static_cast< FilterValueType >( input[ v ] );
+        sum += k2 * static_cast< FilterValueType >( input[ next ] );
+        output[ v ] = static_cast< CoefficientPixelType >( sum );
+      }
+    }
+  }
+
+} // end ThreadedFilterCoefficientImages()
+
+
+/**
+ * ********************* ThreadedComputeSubparts ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ThreadedComputeSubparts( const bool computeSubparts,
+  const SizeValueType begin, const SizeValueType end ) const
+{
+  /** The subparts of the derivative are computed for all conditions, since
+   * the gradient magnitudes of all conditions are reported.
+   */
+  const bool doOrthonormality = this->m_CalculateOrthonormalityCondition || computeSubparts;
+  const bool doProperness     = this->m_CalculatePropernessCondition || computeSubparts;
+  if( !doOrthonormality && !doProperness )
+  {
+    return;
+  }
+
+  /** Get the rigidity coefficients, and the coefficients filtered with A, B and C. */
+  const CoefficientPixelType * rci = this->m_RigidityCoefficientImage->GetBufferPointer();
+  const CoefficientPixelType * A[ ImageDimension ];
+  const CoefficientPixelType * B[ ImageDimension ];
+  const CoefficientPixelType * C[ ImageDimension ];
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+  {
+    A[ i ] = this->GetFilteredCoefficients( 0, i );
+    B[ i ] = this->GetFilteredCoefficients( 1, i );
+    if( ImageDimension == 3 )
+    {
+      C[ i ] = this->GetFilteredCoefficients( 2, i );
+    }
+  }
+
+  /** Do the calculation of the orthonormality subparts. */
+  if( doOrthonormality )
+  {
+    CoefficientPixelType * OCparts[ ImageDimension ][ ImageDimension ];
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+        OCparts[ i ][ j ] = &this->m_OrthonormalitySubparts[ i * ImageDimension + j ][ 0 ];
+      }
+    }
+
     ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
     ScalarType valueOC;
-    while( !itOCp[ 0 ][ 0 ].IsAtEnd() )
+    for( SizeValueType v = begin; v < end; ++v )
     {
-      /** Copy values: this way we avoid calling Get() so many times.
+      /** Copy values: this way we avoid reading the buffers so many times.
        * It also improves code readability.
        */
-      mu1_A = itA[ 0 ].Get(); mu2_A = itA[ 1 ].Get();
-      mu1_B = itB[ 0 ].Get(); mu2_B = itB[ 1 ].Get();
+      mu1_A = A[ 0 ][ v ]; mu2_A = A[ 1 ][ v ];
+      mu1_B = B[ 0 ][ v ]; mu2_B = B[ 1 ][ v ];
       if( ImageDimension == 3 )
       {
-        mu3_A = itA[ 2 ].Get(); mu3_B = itB[ 2 ].Get();
-        mu1_C = itC[ 0 ].Get(); mu2_C = itC[ 1 ].Get(); mu3_C = itC[ 2 ].Get();
+        mu3_A = A[ 2 ][ v ]; mu3_B = B[ 2 ][ v ];
+        mu1_C = C[ 0 ][ v ]; mu2_C = C[ 1 ][ v ]; mu3_C = C[ 2 ][ v ];
       }
       if( ImageDimension == 2 )
       {
         /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue
-          += it_RCI.Get() * (
+        this->m_OrthonormalityValues[ v ]
+          = rci[ v ] * (
           vcl_pow(
           +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
           + mu2_A * mu2_A
@@ -1229,45 +1294,48 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
           + mu2_A * ( 1.0 + mu2_B ),
           2.0 )
           );
-        /** Calculate the derivative of the orthonormality condition. */
-        /** mu1, part 1 */
-        valueOC
-          = +2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          + 2.0 * mu2_A * mu2_A * ( 1.0 + mu1_A )
-          - 2.0 * ( 1.0 + mu1_A )
-          + mu1_B * mu1_B * ( 1.0 + mu1_A )
-          + mu2_A * ( 1.0 + mu2_B ) * mu1_B;
-        itOCp[ 0 ][ 0 ].Set( 2.0 * valueOC );
-        /** mu1, part2*/
-        valueOC
-          = +mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A )
-          + 2.0 * mu1_B * mu1_B * mu1_B
-          + 2.0 * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          - 2.0 * mu1_B;
-        itOCp[ 0 ][ 1 ].Set( 2.0 * valueOC );
-        /** mu2, part 1 */
-        valueOC
-          = +2.0 * mu2_A * mu2_A * mu2_A
-          + 2.0 * mu2_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          - 2.0 * mu2_A
-          + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          + mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B );
-        itOCp[ 1 ][ 0 ].Set( 2.0 * valueOC );
-        /** mu2, part2*/
-        valueOC
-          = +mu2_A * mu2_A * ( 1.0 + mu2_B )
-          + mu1_B * ( 1.0 + mu1_A ) * mu2_A
-          + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          + 2.0 * mu1_B * mu1_B * ( 1.0 + mu2_B )
-          - 2.0 * ( 1.0 + mu2_B );
-        itOCp[ 1 ][ 1 ].Set( 2.0 * valueOC );
+        if( computeSubparts )
+        {
+          /** Calculate the derivative of the orthonormality condition. */
+          /** mu1, part 1 */
+          valueOC
+            = +2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            + 2.0 * mu2_A * mu2_A * ( 1.0 + mu1_A )
+            - 2.0 * ( 1.0 + mu1_A )
+            + mu1_B * mu1_B * ( 1.0 + mu1_A )
+            + mu2_A * ( 1.0 + mu2_B ) * mu1_B;
+          OCparts[ 0 ][ 0 ][ v ] = 2.0 * valueOC;
+          /** mu1, part2*/
+          valueOC
+            = +mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A )
+            + 2.0 * mu1_B * mu1_B * mu1_B
+            + 2.0 * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            - 2.0 * mu1_B;
+          OCparts[ 0 ][ 1 ][ v ] = 2.0 * valueOC;
+          /** mu2, part 1 */
+          valueOC
+            = +2.0 * mu2_A * mu2_A * mu2_A
+            + 2.0 * mu2_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            - 2.0 * mu2_A
+            + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            + mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B );
+          OCparts[ 1 ][ 0 ][ v ] = 2.0 * valueOC;
+          /** mu2, part2*/
+          valueOC
+            = +mu2_A * mu2_A * ( 1.0 + mu2_B )
+            + mu1_B * ( 1.0 + mu1_A ) * mu2_A
+            + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            + 2.0 * mu1_B * mu1_B * ( 1.0 + mu2_B )
+            - 2.0 * ( 1.0 + mu2_B );
+          OCparts[ 1 ][ 1 ][ v ] = 2.0 * valueOC;
+        }
       } // end if dim == 2
       else if( ImageDimension == 3 )
       {
         /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue
-          += it_RCI.Get() * (
+        this->m_OrthonormalityValues[ v ]
+          = rci[ v ] * (
           vcl_pow(
           +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
           + mu2_A * mu2_A
@@ -1301,212 +1369,202 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
           + ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
           - 1.0,
           2.0 ) );
-        /** Calculate the derivative of the orthonormality condition. */
-        /** mu1, part 1 */
-        valueOC
-          = +2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          + 2.0 * mu2_A * mu2_A * ( 1.0 + mu1_A )
-          + 2.0 * ( 1.0 + mu1_A ) * mu3_A * mu3_A
-          - 2.0 * ( 1.0 + mu1_A )
-          + mu1_B * mu1_B * ( 1.0 + mu1_A )
-          + mu2_A * ( 1.0 + mu2_B ) * mu1_B
-          + mu1_B * mu3_A * mu3_B
-          + ( 1.0 + mu1_A ) * mu1_C * mu1_C
-          + mu1_C * mu2_A * mu2_C
-          + mu1_C * mu3_A * ( 1.0 + mu3_C );
-        itOCp[ 0 ][ 0 ].Set( 2.0 * valueOC );
-        /** mu1, part2 */
-        valueOC
-          = +( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu1_B
-          + ( 1.0 + mu1_A ) * mu2_A * mu3_B
-          + ( 1.0 + mu1_A ) * mu3_A * mu3_B
-          + mu1_B * mu1_B * mu1_B
-          + mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          + mu1_B * mu3_B * mu3_B
-          - mu1_B
-          + mu1_B * mu1_C * mu1_C
-          + mu1_C * ( 1.0 + mu2_B ) * mu2_C
-          + mu1_C * mu3_B * ( 1.0 + mu3_C );
-        itOCp[ 0 ][ 1 ].Set( 2.0 * valueOC );
-        /** mu1, part3 */
-        valueOC
-          = +( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu1_C
-          + ( 1.0 + mu1_A ) * mu2_A * mu2_C
-          + ( 1.0 + mu1_A ) * mu3_A * ( 1.0 + mu3_C )
-          + mu1_B * mu1_B * mu1_C
-          + mu1_B * ( 1.0 + mu2_B ) * mu2_C
-          + mu1_B * mu3_B * ( 1.0 + mu3_C )
-          + 2.0 * mu1_C * mu1_C * mu1_C
-          + 2.0 * mu1_C * mu2_C * mu2_C
-          + 2.0 * mu1_C * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - 2.0 * mu1_C;
-        itOCp[ 0 ][ 2 ].Set( 2.0 * valueOC );
-        /** mu2, part 1 */
-        valueOC
-          = +2.0 * mu2_A * mu2_A * mu2_A
-          + 2.0 * mu2_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          - 2.0 * mu2_A
-          + 2.0 * mu2_A * mu3_A * mu3_A
-          + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          + mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
-          + ( 1.0 + mu2_B ) * mu3_A * mu3_B
-          + mu2_A * mu2_C * mu2_C
-          + ( 1.0 + mu1_A ) * mu1_C * mu2_C
-          + mu2_C * mu3_A * ( 1.0 + mu3_C );
-        itOCp[ 1 ][ 0 ].Set( 2.0 * valueOC );
-        /** mu2, part2 */
-        valueOC
-          = +mu2_A * mu2_A * ( 1.0 + mu2_B )
-          + mu1_B * ( 1.0 + mu1_A ) * mu2_A
-          + mu2_A * mu3_A * mu3_B
-          + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          + 2.0 * mu1_B * mu1_B * ( 1.0 + mu2_B )
-          - 2.0 * ( 1.0 + mu2_B )
-          + 2.0 * ( 1.0 + mu2_B ) * mu3_B * mu3_B
-          + ( 1.0 + mu2_B ) * mu2_C * mu2_C
-          + mu1_B * mu1_C * mu2_C
-          + mu2_C * mu3_B * ( 1.0 + mu3_C );
-        itOCp[ 1 ][ 1 ].Set( 2.0 * valueOC );
-        /** mu2, part 3 */
-        valueOC
-          = +mu2_A * mu2_A * mu2_C
-          + ( 1.0 + mu1_A ) * mu1_C * mu2_A
-          + mu2_A * mu3_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu2_C
-          + mu1_B * mu1_C * mu2_B
-          + ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
-          + 2.0 * mu2_C * mu2_C * mu2_C
-          + 2.0 * mu1_C * mu1_C * mu2_C
-          + 2.0 * mu2_C * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - 2.0 * mu2_C;
-        itOCp[ 1 ][ 2 ].Set( 2.0 * valueOC );
-        /** mu3, part 1 */
-        valueOC
-          = +2.0 * mu3_A * mu3_A * mu3_A
-          + 2.0 * mu3_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
-          - 2.0 * mu3_A
-          + 2.0 * mu2_A * mu2_A * mu3_A
-          + mu3_A * mu3_B * mu3_B
-          + mu1_B * ( 1.0 + mu1_A ) * mu3_B
-          + ( 1.0 + mu2_B ) * mu2_A * mu3_B
-          + mu3_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu3_C )
-          + mu2_C * mu2_A * ( 1.0 + mu3_C );
-        itOCp[ 2 ][ 0 ].Set( 2.0 * valueOC );
-        /** mu3, part2 */
-        valueOC
-          = +mu3_A * mu3_A * mu3_B
-          + mu1_B * ( 1.0 + mu1_A ) * mu3_A
-          + mu2_A * mu3_A * ( 1.0 + mu2_B )
-          + 2.0 *  mu3_B *  mu3_B *  mu3_B
-          + 2.0 * mu1_B * mu1_B *  mu3_B
-          - 2.0 *  mu3_B
-          + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_B
-          + mu3_B * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          + mu1_B * mu1_C * ( 1.0 + mu3_C )
-          + mu2_C * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C );
-        itOCp[ 2 ][ 1 ].Set( 2.0 * valueOC );
-        /** mu3, part 3 */
-        valueOC
-          = +mu3_A * mu3_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu1_C * mu3_A
-          + mu2_A * mu3_A * mu2_C
-          + mu3_B * mu3_B * ( 1.0 + mu3_C )
-          + mu1_B * mu1_C * mu3_B
-          + ( 1.0 + mu2_B ) * mu3_B * mu2_C
-          + 2.0 * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          + 2.0 * mu1_C * mu1_C * ( 1.0 + mu3_C )
-          + 2.0 * mu2_C * mu2_C * ( 1.0 + mu3_C )
-          - 2.0 * ( 1.0 + mu3_C );
-        itOCp[ 2 ][ 2 ].Set( 2.0 * valueOC );
-      } // end if dim == 3
-
-      /** Increase all iterators. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        ++itA[ i ]; ++itB[ i ];
-        if( ImageDimension == 3 ) { ++itC[ i ]; }
-        for( unsigned int j = 0; j < ImageDimension; j++ )
+        if( computeSubparts )
         {
-          ++itOCp[ i ][ j ];
+          /** Calculate the derivative of the orthonormality condition. */
+          /** mu1, part 1 */
+          valueOC
+            = +2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            + 2.0 * mu2_A * mu2_A * ( 1.0 + mu1_A )
+            + 2.0 * ( 1.0 + mu1_A ) * mu3_A * mu3_A
+            - 2.0 * ( 1.0 + mu1_A )
+            + mu1_B * mu1_B * ( 1.0 + mu1_A )
+            + mu2_A * ( 1.0 + mu2_B ) * mu1_B
+            + mu1_B * mu3_A * mu3_B
+            + ( 1.0 + mu1_A ) * mu1_C * mu1_C
+            + mu1_C * mu2_A * mu2_C
+            + mu1_C * mu3_A * ( 1.0 + mu3_C );
+          OCparts[ 0 ][ 0 ][ v ] = 2.0 * valueOC;
+          /** mu1, part2 */
+          valueOC
+            = +( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu1_B
+            + ( 1.0 + mu1_A ) * mu2_A * mu3_B
+            + ( 1.0 + mu1_A ) * mu3_A * mu3_B
+            + mu1_B * mu1_B * mu1_B
+            + mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            + mu1_B * mu3_B * mu3_B
+            - mu1_B
+            + mu1_B * mu1_C * mu1_C
+            + mu1_C * ( 1.0 + mu2_B ) * mu2_C
+            + mu1_C * mu3_B * ( 1.0 + mu3_C );
+          OCparts[ 0 ][ 1 ][ v ] = 2.0 * valueOC;
+          /** mu1, part3 */
+          valueOC
+            = +( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu1_C
+            + ( 1.0 + mu1_A ) * mu2_A * mu2_C
+            + ( 1.0 + mu1_A ) * mu3_A * ( 1.0 + mu3_C )
+            + mu1_B * mu1_B * mu1_C
+            + mu1_B * ( 1.0 + mu2_B ) * mu2_C
+            + mu1_B * mu3_B * ( 1.0 + mu3_C )
+            + 2.0 * mu1_C * mu1_C * mu1_C
+            + 2.0 * mu1_C * mu2_C * mu2_C
+            + 2.0 * mu1_C * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - 2.0 * mu1_C;
+          OCparts[ 0 ][ 2 ][ v ] = 2.0 * valueOC;
+          /** mu2, part 1 */
+          valueOC
+            = +2.0 * mu2_A * mu2_A * mu2_A
+            + 2.0 * mu2_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            - 2.0 * mu2_A
+            + 2.0 * mu2_A * mu3_A * mu3_A
+            + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            + mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
+            + ( 1.0 + mu2_B ) * mu3_A * mu3_B
+            + mu2_A * mu2_C * mu2_C
+            + ( 1.0 + mu1_A ) * mu1_C * mu2_C
+            + mu2_C * mu3_A * ( 1.0 + mu3_C );
+          OCparts[ 1 ][ 0 ][ v ] = 2.0 * valueOC;
+          /** mu2, part2 */
+          valueOC
+            = +mu2_A * mu2_A * ( 1.0 + mu2_B )
+            + mu1_B * ( 1.0 + mu1_A ) * mu2_A
+            + mu2_A * mu3_A * mu3_B
+            + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            + 2.0 * mu1_B * mu1_B * ( 1.0 + mu2_B )
+            - 2.0 * ( 1.0 + mu2_B )
+            + 2.0 * ( 1.0 + mu2_B ) * mu3_B * mu3_B
+            + ( 1.0 + mu2_B ) * mu2_C * mu2_C
+            + mu1_B * mu1_C * mu2_C
+            + mu2_C * mu3_B * ( 1.0 + mu3_C );
+          OCparts[ 1 ][ 1 ][ v ] = 2.0 * valueOC;
+          /** mu2, part 3 */
+          valueOC
+            = +mu2_A * mu2_A * mu2_C
+            + ( 1.0 + mu1_A ) * mu1_C * mu2_A
+            + mu2_A * mu3_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu2_C
+            + mu1_B * mu1_C * mu2_B
+            + ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+            + 2.0 * mu2_C * mu2_C * mu2_C
+            + 2.0 * mu1_C * mu1_C * mu2_C
+            + 2.0 * mu2_C * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - 2.0 * mu2_C;
+          OCparts[ 1 ][ 2 ][ v ] = 2.0 * valueOC;
+          /** mu3, part 1 */
+          valueOC
+            = +2.0 * mu3_A * mu3_A * mu3_A
+            + 2.0 * mu3_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            - 2.0 * mu3_A
+            + 2.0 * mu2_A * mu2_A * mu3_A
+            + mu3_A * mu3_B * mu3_B
+            + mu1_B * ( 1.0 + mu1_A ) * mu3_B
+            + ( 1.0 + mu2_B ) * mu2_A * mu3_B
+            + mu3_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu3_C )
+            + mu2_C * mu2_A * ( 1.0 + mu3_C );
+          OCparts[ 2 ][ 0 ][ v ] = 2.0 * valueOC;
+          /** mu3, part2 */
+          valueOC
+            = +mu3_A * mu3_A * mu3_B
+            + mu1_B * ( 1.0 + mu1_A ) * mu3_A
+            + mu2_A * mu3_A * ( 1.0 + mu2_B )
+            + 2.0 *  mu3_B *  mu3_B *  mu3_B
+            + 2.0 * mu1_B * mu1_B *  mu3_B
+            - 2.0 *  mu3_B
+            + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_B
+            + mu3_B * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            + mu1_B * mu1_C * ( 1.0 + mu3_C )
+            + mu2_C * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C );
+          OCparts[ 2 ][ 1 ][ v ] = 2.0 * valueOC;
+          /** mu3, part 3 */
+          valueOC
+            = +mu3_A * mu3_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu1_C * mu3_A
+            + mu2_A * mu3_A * mu2_C
+            + mu3_B * mu3_B * ( 1.0 + mu3_C )
+            + mu1_B * mu1_C * mu3_B
+            + ( 1.0 + mu2_B ) * mu3_B * mu2_C
+            + 2.0 * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            + 2.0 * mu1_C * mu1_C * ( 1.0 + mu3_C )
+            + 2.0 * mu2_C * mu2_C * ( 1.0 + mu3_C )
+            - 2.0 * ( 1.0 + mu3_C );
+          OCparts[ 2 ][ 2 ][ v ] = 2.0 * valueOC;
         }
-      }
-      ++it_RCI;
-
-    } // end while
+      } // end if dim == 3
+    } // end loop over v
   }   // end if do orthonormality
 
-  /** TASK 4B:
-   * Do the calculation of the properness parts.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  /** Do the calculation of the properness subparts. */
+  if( doProperness )
   {
-    itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
-    if( ImageDimension == 3 ) { itC[ i ].GoToBegin(); }
-  }
-  it_RCI.GoToBegin();
+    CoefficientPixelType * PCparts[ ImageDimension ][ ImageDimension ];
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+        PCparts[ i ][ j ] = &this->m_PropernessSubparts[ i * ImageDimension + j ][ 0 ];
+      }
+    }
 
-  if( this->m_CalculatePropernessCondition )
-  {
     ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
     ScalarType valuePC;
-    while( !itPCp[ 0 ][ 0 ].IsAtEnd() )
+    for( SizeValueType v = begin; v < end; ++v )
     {
-      /** Copy values: this way we avoid calling Get() so many times.
+      /** Copy values: this way we avoid reading the buffers so many times.
        * It also improves code readability.
        */
-      mu1_A = itA[ 0 ].Get(); mu2_A = itA[ 1 ].Get();
-      mu1_B = itB[ 0 ].Get(); mu2_B = itB[ 1 ].Get();
+      mu1_A = A[ 0 ][ v ]; mu2_A = A[ 1 ][ v ];
+      mu1_B = B[ 0 ][ v ]; mu2_B = B[ 1 ][ v ];
       if( ImageDimension == 3 )
       {
-        mu3_A = itA[ 2 ].Get(); mu3_B = itB[ 2 ].Get();
-        mu1_C = itC[ 0 ].Get(); mu2_C = itC[ 1 ].Get(); mu3_C = itC[ 2 ].Get();
+        mu3_A = A[ 2 ][ v ]; mu3_B = B[ 2 ][ v ];
+        mu1_C = C[ 0 ][ v ]; mu2_C = C[ 1 ][ v ]; mu3_C = C[ 2 ][ v ];
       }
       if( ImageDimension == 2 )
       {
         /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue
-          += it_RCI.Get() * (
+        this->m_PropernessValues[ v ]
+          = rci[ v ] * (
           vcl_pow(
           +( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
           - mu2_A * mu1_B
           - 1.0,
           2.0 )
           );
-        /** Calculate the derivative of the properness condition. */
-        /** mu1, part 1 */
-        valuePC
-          = +( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A )
-          - mu2_A * ( 1.0 + mu2_B ) * mu1_B
-          - ( 1.0 + mu2_B );
-        itPCp[ 0 ][ 0 ].Set( 2.0 * valuePC );
-        /** mu1, part 2 */
-        valuePC
-          = +mu2_A
-          + mu2_A * mu2_A * mu1_B
-          - mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A );
-        itPCp[ 0 ][ 1 ].Set( 2.0 * valuePC );
-        /** mu2, part 1 */
-        valuePC
-          = +mu1_B * mu1_B * mu2_A
-          - mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
-          + mu1_B;
-        itPCp[ 1 ][ 0 ].Set( 2.0 * valuePC );
-        /** mu2, part 2 */
-        valuePC
-          = -( 1.0 + mu1_A )
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
-          - mu1_B * ( 1.0 + mu1_A ) * mu2_A;
-        itPCp[ 1 ][ 1 ].Set( 2.0 * valuePC );
+        if( computeSubparts )
+        {
+          /** Calculate the derivative of the properness condition. */
+          /** mu1, part 1 */
+          valuePC
+            = +( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A )
+            - mu2_A * ( 1.0 + mu2_B ) * mu1_B
+            - ( 1.0 + mu2_B );
+          PCparts[ 0 ][ 0 ][ v ] = 2.0 * valuePC;
+          /** mu1, part 2 */
+          valuePC
+            = +mu2_A
+            + mu2_A * mu2_A * mu1_B
+            - mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A );
+          PCparts[ 0 ][ 1 ][ v ] = 2.0 * valuePC;
+          /** mu2, part 1 */
+          valuePC
+            = +mu1_B * mu1_B * mu2_A
+            - mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
+            + mu1_B;
+          PCparts[ 1 ][ 0 ][ v ] = 2.0 * valuePC;
+          /** mu2, part 2 */
+          valuePC
+            = -( 1.0 + mu1_A )
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
+            - mu1_B * ( 1.0 + mu1_A ) * mu2_A;
+          PCparts[ 1 ][ 1 ][ v ] = 2.0 * valuePC;
+        }
       } // end if dim == 2
       else if( ImageDimension == 3 )
       {
         /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue
-          += it_RCI.Get() * (
+        this->m_PropernessValues[ v ]
+          = rci[ v ] * (
           vcl_pow(
           -mu1_C * ( 1.0 + mu2_B ) * mu3_A
           + mu1_B * mu2_C * mu3_A
@@ -1517,598 +1575,327 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
           - 1.0,
           2.0 )
           );
-        /** Calculate the derivative of the properness condition. */
-        /** mu1, part 1 */
-        valuePC
-          = +( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_B * mu3_B
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          + mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_B
-          - mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
-          - mu1_B * mu2_C * mu2_C * mu3_A * mu3_B
-          + mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A * ( 1.0 + mu3_C )
-          - mu1_C * mu2_A * mu2_C * mu3_B * mu3_B
-          + mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
-          + mu1_B * mu2_A * mu2_C * mu3_B * ( 1.0 + mu3_C )
-          - 2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B * ( 1.0 + mu3_C )
-          + mu2_C * mu3_B
-          - mu1_B * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - ( 1.0 + mu2_B ) * ( 1.0 + mu3_C );
-        itPCp[ 0 ][ 0 ].Set( 2.0 * valuePC );
-        /** mu1, part 2 */
-        valuePC
-          = +mu1_B * mu2_C * mu2_C * mu3_A * mu3_A
-          + mu1_B * mu2_A * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_A
-          + mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
-          + mu1_C * mu2_A * mu2_C * mu3_A * mu3_B
-          - ( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_A * mu3_B
-          - 2.0 * mu1_B * mu2_A * mu2_C * mu3_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_A * ( 1.0 + mu3_C )
-          - mu2_C * mu3_A
-          - mu1_C * mu2_A * mu2_A * mu3_B * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu2_A * mu2_C * mu3_B * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          + mu2_A * ( 1.0 + mu3_C );
-        itPCp[ 0 ][ 1 ].Set( 2.0 * valuePC );
-        /** mu1, part 3 */
-        valuePC
-          = +mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * mu3_A
-          + mu1_C * mu2_A * mu2_A * mu3_B * mu3_B
-          - mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_A
-          - 2.0 * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A * mu3_B
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_B
-          + mu1_B * mu2_A * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu2_B ) * mu3_A
-          + mu1_B * mu2_A * mu2_C * mu3_A * mu3_B
-          - ( 1.0 + mu1_A ) * mu2_A * mu2_C * mu3_B * mu3_B
-          - mu1_B * mu2_A * mu2_A * mu3_B * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
-          - mu2_A * mu3_B;
-        itPCp[ 0 ][ 2 ].Set( 2.0 * valuePC );
-        /** mu2, part 1 */
-        valuePC
-          = +mu1_C * mu1_C * mu2_A * mu3_B * mu3_B
-          + mu1_B * mu1_B * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - mu1_C * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_B
-          + mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
-          + mu1_B * mu1_C * mu2_C * mu3_A * mu3_B
-          - mu1_B * mu1_B * mu2_C * mu3_A * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * mu1_C * mu2_C * mu3_B * mu3_B
-          - 2.0 * mu1_B * mu1_C * mu2_A * mu3_B * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
-          - mu1_C * mu3_B
-          + ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_B * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          + mu1_B * ( 1.0 + mu3_C );
-        itPCp[ 1 ][ 0 ].Set( 2.0 * valuePC );
-        /** mu2, part 2 */
-        valuePC
-          = +mu1_C * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_A
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - mu1_B * mu1_C * mu2_C * mu3_A * mu3_A
-          - mu1_C * mu1_C * mu2_A * mu3_A * mu3_B
-          + ( 1.0 + mu1_A ) * mu1_C * mu2_C * mu3_A * mu3_B
-          + mu1_B * mu1_C * mu2_A * mu3_A * ( 1.0 + mu3_C )
-          - 2.0 * ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
-          + mu1_C * mu3_A
-          + ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu3_B * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu3_B * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * mu1_B * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * ( 1.0 + mu3_C );
-        itPCp[ 1 ][ 1 ].Set( 2.0 * valuePC );
-        /** mu2, part 3 */
-        valuePC
-          = +mu1_B * mu1_B * mu2_C * mu3_A * mu3_A
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu3_B * mu3_B
-          - mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_A
-          + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_B
-          + mu1_B * mu1_C * mu2_A * mu3_A * mu3_B
-          - 2.0 * ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_A * mu3_B
-          - mu1_B * mu1_B * mu2_A * mu3_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
-          - mu1_B * mu3_A
-          - ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu3_B * mu3_B
-          + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu3_B * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu3_B;
-        itPCp[ 1 ][ 2 ].Set( 2.0 * valuePC );
-        /** mu3, part 1 */
-        valuePC
-          = +mu1_C * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A
-          + mu1_B * mu1_B * mu2_C * mu2_C * mu3_A
-          - 2.0 * mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A
-          - mu1_C * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B
-          + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_B
-          + mu1_B * mu1_C * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
-          + mu1_C * ( 1.0 + mu2_B )
-          + mu1_B * mu1_C * mu2_A * mu2_C * mu3_B
-          - ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu2_C * mu3_B
-          - mu1_B * mu1_B * mu2_A * mu2_C * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu2_C * ( 1.0 + mu3_C )
-          + mu1_B * mu2_C;
-        itPCp[ 2 ][ 0 ].Set( 2.0 * valuePC );
-        /** mu3, part 2 */
-        valuePC
-          = +mu1_C * mu1_C * mu2_A * mu2_A * mu3_B
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_B
-          - mu1_C * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A
-          + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A
-          + mu1_B * mu1_C * mu2_A * mu2_C * mu3_A
-          - ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu2_C * mu3_A
-          - 2.0 * ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu2_C * mu3_B
-          - mu1_B * mu1_C * mu2_A * mu2_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu1_C * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
-          - mu1_C * mu2_A
-          + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu2_C * ( 1.0 + mu3_C )
-          - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * mu2_C;
-        itPCp[ 2 ][ 1 ].Set( 2.0 * valuePC );
-        /** mu3, part 3 */
-        valuePC
-          = +mu1_B * mu1_B * mu2_A * mu2_A * ( 1.0 + mu3_C )
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
-          + mu1_B * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A
-          - ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A
-          - mu1_B * mu1_B * mu2_A * mu2_C * mu3_A
-          + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A
-          - mu1_B * mu1_C * mu2_A * mu2_A * mu3_B
-          + ( 1.0 + mu1_A ) * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B
-          + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu2_C * mu3_B
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B
-          - 2.0 * ( 1.0 + mu1_A ) * mu1_B * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
-          + mu1_B * mu2_A
-          - ( 1.0 + mu1_A ) * ( 1.0 + mu2_B );
-        itPCp[ 2 ][ 2 ].Set( 2.0 * valuePC );
-      } // end if dim == 3
-
-      /** Increase all iterators. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        ++itA[ i ]; ++itB[ i ];
-        if( ImageDimension == 3 ) { ++itC[ i ]; }
-        for( unsigned int j = 0; j < ImageDimension; j++ )
-        {
-          ++itPCp[ i ][ j ];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 4C:
-   * Do the calculation of the linearity parts.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if( this->m_CalculateLinearityCondition )
-  {
-    while( !itLCp[ 0 ][ 0 ].IsAtEnd() )
-    {
-      /** Linearity condition part. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        /** Calculate the value of the linearity condition. */
-        this->m_LinearityConditionValue
-          += it_RCI.Get() * (
-          +itD[ i ].Get() * itD[ i ].Get()
-          + itE[ i ].Get() * itE[ i ].Get()
-          + itG[ i ].Get() * itG[ i ].Get()
-          );
-        if( ImageDimension == 3 )
+        if( computeSubparts )
         {
-          this->m_LinearityConditionValue
-            += it_RCI.Get() * (
-            +itF[ i ].Get() * itF[ i ].Get()
-            + itH[ i ].Get() * itH[ i ].Get()
-            + itI[ i ].Get() * itI[ i ].Get()
-            );
+          /** Calculate the derivative of the properness condition. */
+          /** mu1, part 1 */
+          valuePC
+            = +( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_B * mu3_B
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            + mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_B
+            - mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+            - mu1_B * mu2_C * mu2_C * mu3_A * mu3_B
+            + mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A * ( 1.0 + mu3_C )
+            - mu1_C * mu2_A * mu2_C * mu3_B * mu3_B
+            + mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+            + mu1_B * mu2_A * mu2_C * mu3_B * ( 1.0 + mu3_C )
+            - 2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B * ( 1.0 + mu3_C )
+            + mu2_C * mu3_B
+            - mu1_B * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - ( 1.0 + mu2_B ) * ( 1.0 + mu3_C );
+          PCparts[ 0 ][ 0 ][ v ] = 2.0 * valuePC;
+          /** mu1, part 2 */
+          valuePC
+            = +mu1_B * mu2_C * mu2_C * mu3_A * mu3_A
+            + mu1_B * mu2_A * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_A
+            + mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+            + mu1_C * mu2_A * mu2_C * mu3_A * mu3_B
+            - ( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_A * mu3_B
+            - 2.0 * mu1_B * mu2_A * mu2_C * mu3_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_A * ( 1.0 + mu3_C )
+            - mu2_C * mu3_A
+            - mu1_C * mu2_A * mu2_A * mu3_B * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu2_A * mu2_C * mu3_B * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            + mu2_A * ( 1.0 + mu3_C );
+          PCparts[ 0 ][ 1 ][ v ] = 2.0 * valuePC;
+          /** mu1, part 3 */
+          valuePC
+            = +mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * mu3_A
+            + mu1_C * mu2_A * mu2_A * mu3_B * mu3_B
+            - mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_A
+            - 2.0 * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A * mu3_B
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_B
+            + mu1_B * mu2_A * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu2_B ) * mu3_A
+            + mu1_B * mu2_A * mu2_C * mu3_A * mu3_B
+            - ( 1.0 + mu1_A ) * mu2_A * mu2_C * mu3_B * mu3_B
+            - mu1_B * mu2_A * mu2_A * mu3_B * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+            - mu2_A * mu3_B;
+          PCparts[ 0 ][ 2 ][ v ] = 2.0 * valuePC;
+          /** mu2, part 1 */
+          valuePC
+            = +mu1_C * mu1_C * mu2_A * mu3_B * mu3_B
+            + mu1_B * mu1_B * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - mu1_C * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_B
+            + mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+            + mu1_B * mu1_C * mu2_C * mu3_A * mu3_B
+            - mu1_B * mu1_B * mu2_C * mu3_A * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * mu1_C * mu2_C * mu3_B * mu3_B
+            - 2.0 * mu1_B * mu1_C * mu2_A * mu3_B * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+            - mu1_C * mu3_B
+            + ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_B * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            + mu1_B * ( 1.0 + mu3_C );
+          PCparts[ 1 ][ 0 ][ v ] = 2.0 * valuePC;
+          /** mu2, part 2 */
+          valuePC
+            = +mu1_C * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_A
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - mu1_B * mu1_C * mu2_C * mu3_A * mu3_A
+            - mu1_C * mu1_C * mu2_A * mu3_A * mu3_B
+            + ( 1.0 + mu1_A ) * mu1_C * mu2_C * mu3_A * mu3_B
+            + mu1_B * mu1_C * mu2_A * mu3_A * ( 1.0 + mu3_C )
+            - 2.0 * ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+            + mu1_C * mu3_A
+            + ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu3_B * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu3_B * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * mu1_B * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * ( 1.0 + mu3_C );
+          PCparts[ 1 ][ 1 ][ v ] = 2.0 * valuePC;
+          /** mu2, part 3 */
+          valuePC
+            = +mu1_B * mu1_B * mu2_C * mu3_A * mu3_A
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu3_B * mu3_B
+            - mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_A
+            + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_B
+            + mu1_B * mu1_C * mu2_A * mu3_A * mu3_B
+            - 2.0 * ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_A * mu3_B
+            - mu1_B * mu1_B * mu2_A * mu3_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+            - mu1_B * mu3_A
+            - ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu3_B * mu3_B
+            + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu3_B * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu3_B;
+          PCparts[ 1 ][ 2 ][ v ] = 2.0 * valuePC;
+          /** mu3, part 1 */
+          valuePC
+            = +mu1_C * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A
+            + mu1_B * mu1_B * mu2_C * mu2_C * mu3_A
+            - 2.0 * mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A
+            - mu1_C * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B
+            + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_B
+            + mu1_B * mu1_C * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+            + mu1_C * ( 1.0 + mu2_B )
+            + mu1_B * mu1_C * mu2_A * mu2_C * mu3_B
+            - ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu2_C * mu3_B
+            - mu1_B * mu1_B * mu2_A * mu2_C * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu2_C * ( 1.0 + mu3_C )
+            + mu1_B * mu2_C;
+          PCparts[ 2 ][ 0 ][ v ] = 2.0 * valuePC;
+          /** mu3, part 2 */
+          valuePC
+            = +mu1_C * mu1_C * mu2_A * mu2_A * mu3_B
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_B
+            - mu1_C * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A
+            + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A
+            + mu1_B * mu1_C * mu2_A * mu2_C * mu3_A
+            - ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu2_C * mu3_A
+            - 2.0 * ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu2_C * mu3_B
+            - mu1_B * mu1_C * mu2_A * mu2_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu1_C * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+            - mu1_C * mu2_A
+            + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu2_C * ( 1.0 + mu3_C )
+            - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * mu2_C;
+          PCparts[ 2 ][ 1 ][ v ] = 2.0 * valuePC;
+          /** mu3, part 3 */
+          valuePC
+            = +mu1_B * mu1_B * mu2_A * mu2_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+            + mu1_B * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A
+            - ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A
+            - mu1_B * mu1_B * mu2_A * mu2_C * mu3_A
+            + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A
+            - mu1_B * mu1_C * mu2_A * mu2_A * mu3_B
+            + ( 1.0 + mu1_A ) * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B
+            + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu2_C * mu3_B
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B
+            - 2.0 * ( 1.0 + mu1_A ) * mu1_B * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+            + mu1_B * mu2_A
+            - ( 1.0 + mu1_A ) * ( 1.0 + mu2_B );
+          PCparts[ 2 ][ 2 ][ v ] = 2.0 * valuePC;
         }
-      } // end loop over i
-
-      /** Calculate the derivative of the linearity condition. */
-      if( ImageDimension == 2 )
-      {
-        itLCp[ 0 ][ 0 ].Set( 2.0 * itD[ 0 ].Get() );
-        itLCp[ 0 ][ 1 ].Set( 2.0 * itE[ 0 ].Get() );
-        itLCp[ 0 ][ 2 ].Set( 2.0 * itG[ 0 ].Get() );
-        itLCp[ 1 ][ 0 ].Set( 2.0 * itD[ 1 ].Get() );
-        itLCp[ 1 ][ 1 ].Set( 2.0 * itE[ 1 ].Get() );
-        itLCp[ 1 ][ 2 ].Set( 2.0 * itG[ 1 ].Get() );
-      } // end if dim == 2
-      else if( ImageDimension == 3 )
-      {
-        itLCp[ 0 ][ 0 ].Set( 2.0 * itD[ 0 ].Get() );
-        itLCp[ 0 ][ 1 ].Set( 2.0 * itE[ 0 ].Get() );
-        itLCp[ 0 ][ 2 ].Set( 2.0 * itG[ 0 ].Get() );
-        itLCp[ 0 ][ 3 ].Set( 2.0 * itF[ 0 ].Get() );
-        itLCp[ 0 ][ 4 ].Set( 2.0 * itH[ 0 ].Get() );
-        itLCp[ 0 ][ 5 ].Set( 2.0 * itI[ 0 ].Get() );
-        itLCp[ 1 ][ 0 ].Set( 2.0 * itD[ 1 ].Get() );
-        itLCp[ 1 ][ 1 ].Set( 2.0 * itE[ 1 ].Get() );
-        itLCp[ 1 ][ 2 ].Set( 2.0 * itG[ 1 ].Get() );
-        itLCp[ 1 ][ 3 ].Set( 2.0 * itF[ 1 ].Get() );
-        itLCp[ 1 ][ 4 ].Set( 2.0 * itH[ 1 ].Get() );
-        itLCp[ 1 ][ 5 ].Set( 2.0 * itI[ 1 ].Get() );
-        itLCp[ 2 ][ 0 ].Set( 2.0 * itD[ 2 ].Get() );
-        itLCp[ 2 ][ 1 ].Set( 2.0 * itE[ 2 ].Get() );
-        itLCp[ 2 ][ 2 ].Set( 2.0 * itG[ 2 ].Get() );
-        itLCp[ 2 ][ 3 ].Set( 2.0 * itF[ 2 ].Get() );
-        itLCp[ 2 ][ 4 ].Set( 2.0 * itH[ 2 ].Get() );
-        itLCp[ 2 ][ 5 ].Set( 2.0 * itI[ 2 ].Get() );
       } // end if dim == 3
+    } // end loop over v
+  }   // end if do properness
 
-      /** Increase all iterators. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        ++itD[ i ]; ++itE[ i ]; ++itG[ i ];
-        if( ImageDimension == 3 )
-        {
-          ++itF[ i ]; ++itH[ i ]; ++itI[ i ];
-        }
-        for( unsigned int j = 0; j < NofLParts; j++ )
-        {
-          ++itLCp[ i ][ j ];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do linearity
+} // end ThreadedComputeSubparts()
 
-  /** TASK 5:
-   * Do the actual calculation of the rigidity penalty term value.
-   *
-   ************************************************************************* */
 
-  /** Calculate the rigidity penalty term value. */
-  if( this->m_CalculateLinearityCondition )
-  {
-    this->m_LinearityConditionValue /= rigidityCoefficientSum;
-  }
-  if( this->m_CalculateOrthonormalityCondition )
-  {
-    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
-  }
-  if( this->m_CalculatePropernessCondition )
-  {
-    this->m_PropernessConditionValue /= rigidityCoefficientSum;
-  }
+/**
+ * ********************* ThreadedFilterSubparts ******************************
+ */
 
-  if( this->m_UseLinearityCondition )
-  {
-    this->m_RigidityPenaltyTermValue
-      += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
-  }
-  if( this->m_UseOrthonormalityCondition )
-  {
-    this->m_RigidityPenaltyTermValue
-      += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
-  }
-  if( this->m_UsePropernessCondition )
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ThreadedFilterSubparts( const SizeValueType begin, const SizeValueType end ) const
+{
+  /** The operators are 3x3 in 2D and 3x3x3 in 3D. */
+  unsigned int  neighborhoodSize = 1;
+  SizeValueType strides[ ImageDimension ];
+  for( unsigned int d = 0; d < ImageDimension; d++ )
   {
-    this->m_RigidityPenaltyTermValue
-      += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
+    strides[ d ]      = d == 0 ? 1 : strides[ d - 1 ] * this->m_FilterEngineSize[ d - 1 ];
+    neighborhoodSize *= 3;
   }
-  value = this->m_RigidityPenaltyTermValue;
+  std::vector< SizeValueType > neighbors( neighborhoodSize );
 
-  /** TASK 6:
-   * Create filtered versions of the subparts.
-   * Create all necessary iterators and operators.
-   ************************************************************************* */
-
-  /** Create filtered orthonormality, properness and linearity parts. */
-  std::vector< CoefficientImagePointer > OCpartsF( ImageDimension );
-  std::vector< CoefficientImagePointer > PCpartsF( ImageDimension );
-  std::vector< CoefficientImagePointer > LCpartsF( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    OCpartsF[ i ] = CoefficientImageType::New();
-    OCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    OCpartsF[ i ]->Allocate();
-    PCpartsF[ i ] = CoefficientImageType::New();
-    PCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    PCpartsF[ i ]->Allocate();
-    LCpartsF[ i ] = CoefficientImageType::New();
-    LCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    LCpartsF[ i ]->Allocate();
-  }
-
-  /** Create neighborhood iterators over the subparts. */
-  std::vector< std::vector< NeighborhoodIteratorType > > nitOCp( ImageDimension );
-  std::vector< std::vector< NeighborhoodIteratorType > > nitPCp( ImageDimension );
-  std::vector< std::vector< NeighborhoodIteratorType > > nitLCp( ImageDimension );
-  RadiusType                                             radius;
-  radius.Fill( 1 );
+  /** Get the rigidity coefficients and the subparts. The linearity subparts
+   * are two times the coefficients filtered with D, E, G, F, H and I. The
+   * subparts of all conditions are filtered, since the gradient magnitudes
+   * of all conditions are reported.
+   */
+  const unsigned int           NofLParts = 3 * ImageDimension - 3;
+  const unsigned int           linearityOperators[ 6 ] = { 3, 4, 6, 5, 7, 8 };
+  const CoefficientPixelType * rci = this->m_RigidityCoefficientImage->GetBufferPointer();
+  const CoefficientPixelType * OCparts[ ImageDimension ][ ImageDimension ];
+  const CoefficientPixelType * PCparts[ ImageDimension ][ ImageDimension ];
+  const CoefficientPixelType * LCfiltered[ ImageDimension ][ 6 ];
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    nitOCp[ i ].resize( ImageDimension );
-    nitPCp[ i ].resize( ImageDimension );
-    nitLCp[ i ].resize( NofLParts );
     for( unsigned int j = 0; j < ImageDimension; j++ )
     {
-      nitOCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        OCparts[ i ][ j ], OCparts[ i ][ j ]->GetLargestPossibleRegion() );
-      nitOCp[ i ][ j ].GoToBegin();
-      nitPCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        PCparts[ i ][ j ], PCparts[ i ][ j ]->GetLargestPossibleRegion() );
-      nitPCp[ i ][ j ].GoToBegin();
+      OCparts[ i ][ j ] = &this->m_OrthonormalitySubparts[ i * ImageDimension + j ][ 0 ];
+      PCparts[ i ][ j ] = &this->m_PropernessSubparts[ i * ImageDimension + j ][ 0 ];
     }
     for( unsigned int j = 0; j < NofLParts; j++ )
     {
-      nitLCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        LCparts[ i ][ j ], LCparts[ i ][ j ]->GetLargestPossibleRegion() );
-      nitLCp[ i ][ j ].GoToBegin();
+      LCfiltered[ i ][ j ] = this->GetFilteredCoefficients( linearityOperators[ j ], i );
     }
   }
+  const NeighborhoodType & Operator_A = this->m_NDOperators[ 0 ];
+  const NeighborhoodType & Operator_B = this->m_NDOperators[ 1 ];
+  const NeighborhoodType & Operator_C = this->m_NDOperators[ 2 ];
 
-  /** Create iterators over the filtered parts. */
-  std::vector< CoefficientImageIteratorType > itOCpf( ImageDimension );
-  std::vector< CoefficientImageIteratorType > itPCpf( ImageDimension );
-  std::vector< CoefficientImageIteratorType > itLCpf( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    itOCpf[ i ] = CoefficientImageIteratorType( OCpartsF[ i ],
-      OCpartsF[ i ]->GetLargestPossibleRegion() );
-    itOCpf[ i ].GoToBegin();
-    itPCpf[ i ] = CoefficientImageIteratorType( PCpartsF[ i ],
-      PCpartsF[ i ]->GetLargestPossibleRegion() );
-    itPCpf[ i ].GoToBegin();
-    itLCpf[ i ] = CoefficientImageIteratorType( LCpartsF[ i ],
-      LCpartsF[ i ]->GetLargestPossibleRegion() );
-    itLCpf[ i ].GoToBegin();
-  }
-
-  /** Create a neigborhood iterator over the rigidity image. */
-  NeighborhoodIteratorType nit_RCI( radius, this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
-  nit_RCI.GoToBegin();
-  unsigned int neighborhoodSize = nit_RCI.Size();
-
-  /** Create ND operators. */
-  NeighborhoodType Operator_A, Operator_B, Operator_C,
-    Operator_D, Operator_E, Operator_F,
-    Operator_G, Operator_H, Operator_I;
-  this->CreateNDOperator( Operator_A, "FA", spacing );
-  this->CreateNDOperator( Operator_B, "FB", spacing );
-  if( ImageDimension == 3 )
+  for( SizeValueType v = begin; v < end; ++v )
   {
-    this->CreateNDOperator( Operator_C, "FC", spacing );
-  }
-
-  if( this->m_CalculateLinearityCondition )
-  {
-    this->CreateNDOperator( Operator_D, "FD", spacing );
-    this->CreateNDOperator( Operator_E, "FE", spacing );
-    this->CreateNDOperator( Operator_G, "FG", spacing );
-    if( ImageDimension == 3 )
+    /** Compute the neighbors of this voxel, with the zero flux Neumann
+     * boundary condition of the neighborhood iterators.
+     */
+    SizeValueType lower[ ImageDimension ];
+    SizeValueType upper[ ImageDimension ];
+    for( unsigned int d = 0; d < ImageDimension; d++ )
     {
-      this->CreateNDOperator( Operator_F, "FF", spacing );
-      this->CreateNDOperator( Operator_H, "FH", spacing );
-      this->CreateNDOperator( Operator_I, "FI", spacing );
+      const SizeValueType x = ( v / strides[ d ] ) % this->m_FilterEngineSize[ d ];
+      lower[ d ] = x > 0 ? strides[ d ] : 0;
+      upper[ d ] = x + 1 < this->m_FilterEngineSize[ d ] ? strides[ d ] : 0;
     }
-  }
-
-  /** TASK 7A:
-   * Calculate the filtered versions of the orthonormality subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
-   ************************************************************************* */
-
-  if( this->m_CalculateOrthonormalityCondition )
-  {
-    while( !itOCpf[ 0 ].IsAtEnd() )
+    for( unsigned int k = 0; k < neighborhoodSize; ++k )
     {
-      /** Create and reset tmp with zeros. */
-      std::vector< double > tmp( ImageDimension, 0.0 );
-
-      /** Loop over all dimensions. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
+      SizeValueType neighbor = v;
+      unsigned int  position = k;
+      for( unsigned int d = 0; d < ImageDimension; d++ )
       {
-        /** Loop over the neighborhood. */
-        for( unsigned int k = 0; k < neighborhoodSize; ++k )
-        {
-          /** Calculation of the inner product. */
-          tmp[ i ] += Operator_A.GetElement( k )      // FA *
-            * nitOCp[ i ][ 0 ].GetPixel( k )          // subpart[ i ][ 0 ]
-            * nit_RCI.GetPixel( k );                  // c(k)
-          tmp[ i ] += Operator_B.GetElement( k )      // FB *
-            * nitOCp[ i ][ 1 ].GetPixel( k )          // subpart[ i ][ 1 ]
-            * nit_RCI.GetPixel( k );                  // c(k)
-          if( ImageDimension == 3 )
-          {
-            tmp[ i ] += Operator_C.GetElement( k )    // FC *
-              * nitOCp[ i ][ 2 ].GetPixel( k )        // subpart[ i ][ 2 ]
-              * nit_RCI.GetPixel( k );                // c(k)
-          }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itOCpf[ i ].Set( tmp[ i ] );
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for( unsigned int i = 0; i < ImageDimension; i++ )
+        const unsigned int offset = position % 3;
+        position /= 3;
+        if( offset == 0 ) { neighbor -= lower[ d ]; }
+        else if( offset == 2 ) { neighbor += upper[ d ]; }
+      }
+      neighbors[ k ] = neighbor;
+    }
+
+    /** Calculate the filtered versions of the orthonormality subparts. */
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      double tmp = 0.0;
+      for( unsigned int k = 0; k < neighborhoodSize; ++k )
       {
-        ++itOCpf[ i ];
-        for( unsigned int j = 0; j < ImageDimension; j++ )
+        const SizeValueType n = neighbors[ k ];
+        tmp += Operator_A.GetElement( k )      // FA *
+          * OCparts[ i ][ 0 ][ n ]             // subpart[ i ][ 0 ]
+          * rci[ n ];                          // c(k)
+        tmp += Operator_B.GetElement( k )      // FB *
+          * OCparts[ i ][ 1 ][ n ]             // subpart[ i ][ 1 ]
+          * rci[ n ];                          // c(k)
+        if( ImageDimension == 3 )
         {
-          ++nitOCp[ i ][ j ];
+          tmp += Operator_C.GetElement( k )    // FC *
+            * OCparts[ i ][ 2 ][ n ]           // subpart[ i ][ 2 ]
+            * rci[ n ];                        // c(k)
         }
       }
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 7B:
-   * Calculate the filtered versions of the properness subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
-   ************************************************************************* */
+      this->m_FilteredOrthonormalitySubparts[ i ][ v ] = tmp;
+    }
 
-  nit_RCI.GoToBegin();
-  if( this->m_CalculatePropernessCondition )
-  {
-    while( !itPCpf[ 0 ].IsAtEnd() )
+    /** Calculate the filtered versions of the properness subparts. */
+    for( unsigned int i = 0; i < ImageDimension; i++ )
     {
-      /** Create and reset tmp with zeros. */
-      std::vector< double > tmp( ImageDimension, 0.0 );
-
-      /** Loop over all dimensions. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        /** Loop over the neighborhood. */
-        for( unsigned int k = 0; k < neighborhoodSize; ++k )
-        {
-          /** Calculation of the inner product. */
-          tmp[ i ] += Operator_A.GetElement( k )      // FA *
-            * nitPCp[ i ][ 0 ].GetPixel( k )          // subpart[ i ][ 0 ]
-            * nit_RCI.GetPixel( k );                  // c(k)
-          tmp[ i ] += Operator_B.GetElement( k )      // FB *
-            * nitPCp[ i ][ 1 ].GetPixel( k )          // subpart[ i ][ 1 ]
-            * nit_RCI.GetPixel( k );                  // c(k)
-          if( ImageDimension == 3 )
-          {
-            tmp[ i ] += Operator_C.GetElement( k )    // FC *
-              * nitPCp[ i ][ 2 ].GetPixel( k )        // subpart[ i ][ 2 ]
-              * nit_RCI.GetPixel( k );                // c(k)
-          }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itPCpf[ i ].Set( tmp[ i ] );
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for( unsigned int i = 0; i < ImageDimension; i++ )
+      double tmp = 0.0;
+      for( unsigned int k = 0; k < neighborhoodSize; ++k )
       {
-        ++itPCpf[ i ];
-        for( unsigned int j = 0; j < ImageDimension; j++ )
+        const SizeValueType n = neighbors[ k ];
+        tmp += Operator_A.GetElement( k )      // FA *
+          * PCparts[ i ][ 0 ][ n ]             // subpart[ i ][ 0 ]
+          * rci[ n ];                          // c(k)
+        tmp += Operator_B.GetElement( k )      // FB *
+          * PCparts[ i ][ 1 ][ n ]             // subpart[ i ][ 1 ]
+          * rci[ n ];                          // c(k)
+        if( ImageDimension == 3 )
         {
-          ++nitPCp[ i ][ j ];
+          tmp += Operator_C.GetElement( k )    // FC *
+            * PCparts[ i ][ 2 ][ n ]           // subpart[ i ][ 2 ]
+            * rci[ n ];                        // c(k)
         }
       }
-    } // end while
-  }   // end if do properness
-
-  /** TASK 7C:
-   * Calculate the filtered versions of the linearity subparts.
-   * These are sum_{i=1}^{NofLParts} F_{D,E,G,F,H,I} * {subpart_i}.
-   ************************************************************************* */
+      this->m_FilteredPropernessSubparts[ i ][ v ] = tmp;
+    }
 
-  nit_RCI.GoToBegin();
-  if( this->m_CalculateLinearityCondition )
-  {
-    while( !itLCpf[ 0 ].IsAtEnd() )
+    /** Calculate the filtered versions of the linearity subparts. */
+    for( unsigned int i = 0; i < ImageDimension; i++ )
     {
-      /** Create and reset tmp with zeros. */
-      std::vector< double > tmp( ImageDimension, 0.0 );
-
-      /** Loop over all dimensions. */
-      for( unsigned int i = 0; i < ImageDimension; i++ )
+      double tmp = 0.0;
+      for( unsigned int k = 0; k < neighborhoodSize; ++k )
       {
-        /** Loop over the neighborhood. */
-        for( unsigned int k = 0; k < neighborhoodSize; ++k )
-        {
-          /** Calculation of the inner product. */
-          tmp[ i ] += Operator_D.GetElement( k )      // FD *
-            * nitLCp[ i ][ 0 ].GetPixel( k )          // subpart[ i ][ 0 ]
-            * nit_RCI.GetPixel( k );                  // c(k)
-          tmp[ i ] += Operator_E.GetElement( k )      // FE *
-            * nitLCp[ i ][ 1 ].GetPixel( k )          // subpart[ i ][ 1 ]
-            * nit_RCI.GetPixel( k );                  // c(k)
-          tmp[ i ] += Operator_G.GetElement( k )      // FG *
-            * nitLCp[ i ][ 2 ].GetPixel( k )          // subpart[ i ][ 1 ]
-            * nit_RCI.GetPixel( k );                  // c(k)
-          if( ImageDimension == 3 )
-          {
-            tmp[ i ] += Operator_F.GetElement( k )    // FF *
-              * nitLCp[ i ][ 3 ].GetPixel( k )        // subpart[ i ][ 1 ]
-              * nit_RCI.GetPixel( k );                // c(k)
-            tmp[ i ] += Operator_H.GetElement( k )    // FH *
-              * nitLCp[ i ][ 4 ].GetPixel( k )        // subpart[ i ][ 1 ]
-              * nit_RCI.GetPixel( k );                // c(k)
-            tmp[ i ] += Operator_I.GetElement( k )    // FI *
-              * nitLCp[ i ][ 5 ].GetPixel( k )        // subpart[ i ][ 1 ]
-              * nit_RCI.GetPixel( k );                // c(k)
-          }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itLCpf[ i ].Set( tmp[ i ] );
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-        ++itLCpf[ i ];
+        const SizeValueType n = neighbors[ k ];
         for( unsigned int j = 0; j < NofLParts; j++ )
         {
-          ++nitLCp[ i ][ j ];
+          tmp += this->m_NDOperators[ linearityOperators[ j ] ].GetElement( k ) // F{D,E,G,F,H,I} *
+            * static_cast< CoefficientPixelType >( 2.0 * LCfiltered[ i ][ j ][ n ] ) // subpart[ i ][ j ]
+            * rci[ n ];                                                        // c(k)
         }
       }
-    } // end while
-  }   // end if do linearity
+      this->m_FilteredLinearitySubparts[ i ][ v ] = tmp;
+    }
+  } // end loop over v
 
-  /** TASK 8:
-   * Add it all to create the final derivative images.
-   ************************************************************************* */
+} // end ThreadedFilterSubparts()
 
-  /** Create derivative images, each holding a component of the vector field. */
-  std::vector< CoefficientImagePointer > derivativeImages( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    derivativeImages[ i ] = CoefficientImageType::New();
-    derivativeImages[ i ]->SetRegions( inputImages[ i ]->GetLargestPossibleRegion() );
-    derivativeImages[ i ]->Allocate();
-  }
 
-  /** Create iterators over the derivative images. */
-  std::vector< CoefficientImageIteratorType > itDIs( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    itDIs[ i ] = CoefficientImageIteratorType( derivativeImages[ i ],
-      derivativeImages[ i ]->GetLargestPossibleRegion() );
-    itDIs[ i ].GoToBegin();
-    itOCpf[ i ].GoToBegin();
-    itPCpf[ i ].GoToBegin();
-    itLCpf[ i ].GoToBegin();
-  }
+/**
+ * ********************* ThreadedComputeDerivative ******************************
+ */
 
-  /** Do the addition. */
-  // NOTE: unlike the values, for the derivatives weight * derivative is returned.
-  MeasureType gradMagLC                 = NumericTraits< MeasureType >::Zero;
-  MeasureType gradMagOC                 = NumericTraits< MeasureType >::Zero;
-  MeasureType gradMagPC                 = NumericTraits< MeasureType >::Zero;
-  double      rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
-  while( !itDIs[ 0 ].IsAtEnd() )
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ThreadedComputeDerivative( const ScalarType rigidityCoefficientSum,
+  DerivativeValueType * derivative,
+  const SizeValueType begin, const SizeValueType end ) const
+{
+  /** Add it all, and rearrange to create a derivative.
+   * NOTE: unlike the values, for the derivatives weight * derivative is returned.
+   */
+  const SizeValueType numberOfCoefficients = this->m_NumberOfCoefficients;
+  for( SizeValueType v = begin; v < end; ++v )
   {
     for( unsigned int i = 0; i < ImageDimension; i++ )
     {
       ScalarType tmpDIs = NumericTraits< ScalarType >::Zero;
-
-      /** Compute gradient magnitude of LC. */
-      ScalarType tmpLC = this->m_LinearityConditionWeight * itLCpf[ i ].Get();
-      gradMagLC += tmpLC * tmpLC / rigidityCoefficientSumSqr;
-
-      /** Compute gradient magnitude of OC. */
-      ScalarType tmpOC = this->m_OrthonormalityConditionWeight * itOCpf[ i ].Get();
-      gradMagOC += tmpOC * tmpOC / rigidityCoefficientSumSqr;
-
-      /** Compute gradient magnitude of PC. */
-      ScalarType tmpPC = this->m_PropernessConditionWeight * itPCpf[ i ].Get();
-      gradMagPC += tmpPC * tmpPC / rigidityCoefficientSumSqr;
+      ScalarType tmpLC = this->m_LinearityConditionWeight
+        * this->m_FilteredLinearitySubparts[ i ][ v ];
+      ScalarType tmpOC = this->m_OrthonormalityConditionWeight
+        * this->m_FilteredOrthonormalitySubparts[ i ][ v ];
+      ScalarType tmpPC = this->m_PropernessConditionWeight
+        * this->m_FilteredPropernessSubparts[ i ][ v ];
 
       /** Compute derivative contribution. */
       if( this->m_UseLinearityCondition )
@@ -2123,32 +1910,12 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       {
         tmpDIs += tmpPC;
       }
-      itDIs[ i ].Set( tmpDIs );
-
-      /** Update iterators. */
-      ++itDIs[ i ]; ++itOCpf[ i ]; ++itPCpf[ i ]; ++itLCpf[ i ];
+      derivative[ i * numberOfCoefficients + v ]
+        = static_cast< CoefficientPixelType >( tmpDIs ) / rigidityCoefficientSum;
     }
-  } // end while
-
-  /** Set the gradient magnitudes of the several terms. */
-  this->m_LinearityConditionGradientMagnitude      = vcl_sqrt( gradMagLC );
-  this->m_OrthonormalityConditionGradientMagnitude = vcl_sqrt( gradMagOC );
-  this->m_PropernessConditionGradientMagnitude     = vcl_sqrt( gradMagPC );
-
-  /** Rearrange to create a derivative. */
-  unsigned int j = 0;
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    itDIs[ i ].GoToBegin();
-    while( !itDIs[ i ].IsAtEnd() )
-    {
-      derivative[ j ] = itDIs[ i ].Get() / rigidityCoefficientSum;
-      ++itDIs[ i ];
-      j++;
-    } // end while
-  }   // end for
+  }
 
-} // end GetValueAndDerivative()
+} // end ThreadedComputeDerivative()
 
 
 /**
@@ -2381,41 +2148,6 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
 } // end Create1DOperator()
 
 
-/**
- * ************************** FilterSeparable ********************
- */
-
-template< class TFixedImage, class TScalarType >
-typename TransformRigidityPenaltyTerm< TFixedImage, TScalarType >::CoefficientImagePointer
-TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
-::FilterSeparable(
-  const CoefficientImageType * image,
-  const std::vector< NeighborhoodType > & Operators ) const
-{
-  /** Create filters, supply them with boundary conditions and operators. */
-  std::vector< typename NOIFType::Pointer > filters( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    filters[ i ] = NOIFType::New();
-    filters[ i ]->SetOperator( Operators[ i ] );
-  }
-
-  /** Set up the mini-pipline. */
-  filters[ 0 ]->SetInput( image );
-  for( unsigned int i = 1; i < ImageDimension; i++ )
-  {
-    filters[ i ]->SetInput( filters[ i - 1 ]->GetOutput() );
-  }
-
-  /** Execute the mini-pipeline. */
-  filters[ ImageDimension - 1 ]->Update();
-
-  /** Return the filtered image. */
-  return filters[ ImageDimension - 1 ]->GetOutput();
-
-} // end FilterSeparable()
-
-
 /**
  * ************************ CreateNDOperator *********************
  */
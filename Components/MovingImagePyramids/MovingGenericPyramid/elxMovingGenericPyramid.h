@@ -65,6 +65,12 @@ namespace elastix
  *    for rescaling the image, or the ResampleImageFilter. Shrinker is faster.\n
  *    example: <tt>(ImagePyramidUseShrinkImageFilter "true")</tt>\n
  *    Default false, so by default the resampler is used.
+ * \parameter UseImageCache: Flag to specify if the pyramid images are stored in the image
+ *    cache of the run, so that the next elastix level reuses the levels that have the same input
+ *    image, rescale factors and sigmas, instead of computing them again. The cached images are kept
+ *    in memory until the end of the run.\n
+ *    example: <tt>(UseImageCache "true")</tt>\n
+ *    Default false.
  *
  * \ingroup ImagePyramids
  */
@@ -25,7 +25,7 @@
 #include "itkComputeDisplacementDistribution.h" // For FASGD step size
 #include "elxProgressCommand.h"
 #include "itkAdvancedTransform.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkThreadRandomGenerator.h"
 
 
 namespace elastix
@@ -182,6 +182,26 @@ namespace elastix
  *   The parameter can be specified for each resolution, or for all resolutions at once.\n
  *   example: <tt>(NoiseCompensation "true")</tt>\n
  *   Default/recommended: true.
+ * \parameter WarmStart: Whether to start the automatic parameter estimation from the
+ *   gradient statistics of the previous resolution, or of the previous elastix level.
+ *   The Jacobian terms are computed as usual, since they depend on the transform,
+ *   but instead of NumberOfGradientMeasurements gradients only one gradient is
+ *   measured. The magnitude of the exact gradient is taken from this measurement, to
+ *   follow its change between resolutions; the ratio of the magnitudes of the
+ *   approximation error and the exact gradient, which determines the noise
+ *   compensation, is averaged with the ratio found before. The parameter has only
+ *   influence when AutomaticParameterEstimation is used. See also the OptimizerBase.\n
+ *   example: <tt>(WarmStart "false" "true" "true")</tt>\n
+ *   Default: false.
+ * \parameter UseAdaptiveStopping: Whether to stop a resolution before
+ *   MaximumNumberOfIterations when the metric values of the last iterations show convergence.
+ *   The metric values are noisy, since they are computed from a new set of samples in every
+ *   iteration; the test therefore compares their decrease to the noise. The window and
+ *   thresholds of the test are set with AdaptiveStoppingWindowSize,
+ *   AdaptiveStoppingTrendThreshold and AdaptiveStoppingRelativeTolerance. See the
+ *   OptimizerBase.\n
+ *   example: <tt>(UseAdaptiveStopping "true" "true" "true")</tt>\n
+ *   Default: false.
  *
  * \todo: this class contains a lot of functional code, which actually does not belong here.
  *
@@ -229,6 +249,7 @@ public:
   typedef typename Superclass2::RegistrationType     RegistrationType;
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
+  typedef typename Superclass2::WarmStartStateType   WarmStartStateType;
   typedef itk::SizeValueType                         SizeValueType;
 
   /** Typedef for the ParametersType. */
@@ -391,6 +412,13 @@ protected:
   virtual void SampleGradients( const ParametersType & mu0,
     double perturbationSigma, double & gg, double & ee );
 
+  /** Call SampleGradients. With a warm start, measure only one gradient if
+   * gradient statistics of the previous resolution are available, and
+   * combine them. The statistics are stored for the next resolution.
+   */
+  virtual void SampleGradientsWithWarmStart( const ParametersType & mu0,
+    double perturbationSigma, double & gg, double & ee );
+
   /** Helper function, which calls GetScaledValueAndDerivative and does
    * some exception handling. Used by SampleGradients.
    */
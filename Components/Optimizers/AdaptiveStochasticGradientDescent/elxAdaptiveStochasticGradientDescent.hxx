@@ -27,6 +27,7 @@
 #include <algorithm>
 #include <utility>
 #include "itkAdvancedImageToImageMetric.h"
+#include "itkParameterVectorOperations.h"
 #include "itkTimeProbe.h"
 
 namespace elastix
@@ -54,7 +55,7 @@ AdaptiveStochasticGradientDescent< TElastix >
   this->m_NumberOfSamplesForExactGradient = 100000;
   this->m_SigmoidScaleFactor              = 0.1;
 
-  this->m_RandomGenerator   = RandomGeneratorType::GetInstance();
+  this->m_RandomGenerator   = itk::ThreadRandomGenerator::GetInstance();
   this->m_AdvancedTransform = 0;
 
   this->m_UseNoiseCompensation        = true;
@@ -298,6 +299,13 @@ AdaptiveStochasticGradientDescent< TElastix >
     xl::xout[ "iteration" ][ "4:||Gradient||" ] << this->GetGradient().magnitude();
   }
 
+  /** Stop if the metric values show convergence. */
+  if( this->TestAdaptiveStopping( this->GetValue() ) )
+  {
+    this->StopOptimization();
+    return;
+  }
+
   /** Select new spatial samples for the computation of the metric. */
   if( this->GetNewSamplesEveryIteration() )
   {
@@ -346,6 +354,10 @@ AdaptiveStochasticGradientDescent< TElastix >
       stopcondition = "Unknown";
       break;
   }
+  if( this->GetAdaptivelyStopped() )
+  {
+    stopcondition = this->GetAdaptiveStoppingCondition();
+  }
 
   /** Print the stopping condition. */
   elxout << "Stopping condition: " << stopcondition << "." << std::endl;
@@ -497,6 +509,22 @@ AdaptiveStochasticGradientDescent< TElastix >
   /** Total time. */
   itk::TimeProbe timer1;
   timer1.Start();
+
+  /** For the profile: the clocks, and the time spent in the cost function,
+   * which is not counted as ParameterEstimation.
+   */
+  typedef itk::RegistrationProfiler ProfilerType;
+  ProfilerType * profiler = this->GetElastix()->GetUseProfiling()
+    ? this->GetElastix()->GetProfiler() : NULL;
+  const double wallStart = ProfilerType::GetWallClock();
+  const double cpuStart  = ProfilerType::GetThreadCPUClock();
+  ProfilerType::PhaseRecordType metricAtStart = ProfilerType::PhaseRecordType();
+  if( profiler )
+  {
+    metricAtStart = profiler->GetPhaseRecord(
+      profiler->GetCurrentResolution(), ProfilerType::MetricEvaluation );
+  }
+
   elxout << "Starting automatic parameter estimation for "
          << this->elxGetClassName()
          << " ..." << std::endl;
@@ -525,6 +553,18 @@ AdaptiveStochasticGradientDescent< TElastix >
     this->AutomaticParameterEstimationUsingDisplacementDistribution();
   }
 
+  /** Record the estimation in the profile. */
+  if( profiler )
+  {
+    const ProfilerType::PhaseRecordType metric = profiler->GetPhaseRecord(
+      profiler->GetCurrentResolution(), ProfilerType::MetricEvaluation );
+    profiler->AddTime( ProfilerType::ParameterEstimation,
+      std::max( 0.0, ProfilerType::GetWallClock() - wallStart
+      - ( metric.st_WallTime - metricAtStart.st_WallTime ) ),
+      std::max( 0.0, ProfilerType::GetThreadCPUClock() - cpuStart
+      - ( metric.st_CPUTime - metricAtStart.st_CPUTime ) ) );
+  }
+
   /** Print the elapsed time. */
   timer1.Stop();
   elxout << "Automatic parameter estimation took "
@@ -637,7 +677,7 @@ AdaptiveStochasticGradientDescent< TElastix >
   {
     sigma4 = sigma4factor * delta / vcl_sqrt( maxJJ );
   }
-  this->SampleGradients(
+  this->SampleGradientsWithWarmStart(
     this->GetScaledCurrentPosition(), sigma4, gg, ee );
   timer3.Stop();
   elxout << "  Sampling the gradients took "
@@ -788,7 +828,7 @@ AdaptiveStochasticGradientDescent< TElastix >
     {
       sigma4 = sigma4factor * delta / vcl_sqrt( maxJJ );
     }
-    this->SampleGradients( this->GetScaledCurrentPosition(), sigma4, gg, ee );
+    this->SampleGradientsWithWarmStart( this->GetScaledCurrentPosition(), sigma4, gg, ee );
 
     double noisefactor = gg / ( gg + ee );
     a =  delta * vcl_pow( A + 1.0, alpha ) / jacg * noisefactor;
@@ -922,6 +962,9 @@ AdaptiveStochasticGradientDescent< TElastix >
   double         exactgg = 0.0;
   double         diffgg  = 0.0;
 
+  /** The vector operations on the gradients are multi-threaded. */
+  typedef itk::ParameterVectorOperations ParameterVectorOperationsType;
+
   /** Compute gg for some random parameters. */
   for( unsigned int i = 0; i < this->m_NumberOfGradientMeasurements; ++i )
   {
@@ -962,11 +1005,12 @@ AdaptiveStochasticGradientDescent< TElastix >
       this->GetScaledDerivativeWithExceptionHandling( perturbedMu0, approxgradient );
 
       /** Compute error vector. */
-      diffgradient = exactgradient - approxgradient;
+      ParameterVectorOperationsType::LinearCombination(
+        1.0, exactgradient, -1.0, approxgradient, diffgradient );
 
       /** Compute g^T g and e^T e */
-      exactgg += exactgradient.squared_magnitude();
-      diffgg  += diffgradient.squared_magnitude();
+      exactgg += ParameterVectorOperationsType::SquaredNorm( exactgradient );
+      diffgg  += ParameterVectorOperationsType::SquaredNorm( diffgradient );
     }
     else // no stochastic gradients
     {
@@ -974,7 +1018,7 @@ AdaptiveStochasticGradientDescent< TElastix >
       this->GetScaledDerivativeWithExceptionHandling( perturbedMu0, exactgradient );
 
       /** Compute g^T g. NB: diffgg=0. */
-      exactgg += exactgradient.squared_magnitude();
+      exactgg += ParameterVectorOperationsType::SquaredNorm( exactgradient );
     } // end else: no stochastic gradients
 
   } // end for loop over gradient measurements
@@ -1008,6 +1052,55 @@ AdaptiveStochasticGradientDescent< TElastix >
 } // end SampleGradients()
 
 
+/**
+ * ******************** SampleGradientsWithWarmStart **********************
+ */
+
+template< class TElastix >
+void
+AdaptiveStochasticGradientDescent< TElastix >
+::SampleGradientsWithWarmStart( const ParametersType & mu0,
+  double perturbationSigma, double & gg, double & ee )
+{
+  if( !this->GetWarmStart() )
+  {
+    this->SampleGradients( mu0, perturbationSigma, gg, ee );
+    return;
+  }
+
+  /** Without statistics of the previous resolution, measure as usual. */
+  WarmStartStateType * state = this->GetWarmStartState();
+  const SizeValueType  previousNumberOfMeasurements = state->GetNumberOfGradientMeasurements();
+  if( previousNumberOfMeasurements == 0 )
+  {
+    this->SampleGradients( mu0, perturbationSigma, gg, ee );
+    state->SetNoiseRatio( gg > 1e-14 ? ee / gg : 0.0 );
+    state->SetNumberOfGradientMeasurements( this->m_NumberOfGradientMeasurements );
+    return;
+  }
+
+  /** Measure one gradient, which gives the magnitude of the exact gradient
+   * in this resolution. Average its noise ratio with the previous one,
+   * weighted by the numbers of measurements.
+   */
+  elxout << "  Warm start: using the gradient statistics of "
+         << previousNumberOfMeasurements << " previous measurements." << std::endl;
+  const SizeValueType numberOfGradientMeasurements = this->m_NumberOfGradientMeasurements;
+  this->m_NumberOfGradientMeasurements = 1;
+  this->SampleGradients( mu0, perturbationSigma, gg, ee );
+  this->m_NumberOfGradientMeasurements = numberOfGradientMeasurements;
+
+  const double n     = static_cast< double >( previousNumberOfMeasurements );
+  const double ratio = ( n * state->GetNoiseRatio()
+    + ( gg > 1e-14 ? ee / gg : 0.0 ) ) / ( n + 1.0 );
+  ee = ratio * gg;
+
+  state->SetNoiseRatio( ratio );
+  state->SetNumberOfGradientMeasurements( previousNumberOfMeasurements + 1 );
+
+} // end SampleGradientsWithWarmStart()
+
+
 /**
  * **************** PrintSettingsVector **********************
  */
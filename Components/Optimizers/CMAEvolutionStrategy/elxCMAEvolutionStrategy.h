@@ -106,7 +106,19 @@ namespace elastix
  *    covariance matrix is updated. If 0, the optimizer estimates a value. The actual value used is
  *    reported back in the elastix.log file. This parameter can be specified for each resolution. \n
  *    example: <tt>(UpdateBDPeriod 0 0 50)</tt> \n
- *    Default: 0 (so, automatically determined).
+ *    Default: 0 (so, automatically determined).\n
+ * \parameter UseMultiThreading: whether the generation of the offspring, the covariance
+ *    matrix update and, from 100 parameters on, its eigen decomposition are computed with
+ *    multiple threads. Only these steps are parallel: this component evaluates the
+ *    population serially, one member after another, because the elastix metrics share the
+ *    transform and the sampler of the registration and cannot be copied for
+ *    itk::CMAEvolutionStrategyOptimizer::SetCostFunctionClones(). Each evaluation is
+ *    multi-threaded by the metric itself. The offspring is generated as a whole, before it
+ *    is evaluated, so the result differs from the single-threaded optimizer when a metric
+ *    evaluation fails, and by rounding errors of the eigen decomposition.
+ *    This parameter can be specified for each resolution. \n
+ *    example: <tt>(UseMultiThreading "true")</tt> \n
+ *    Default: "false".
  *
  * \ingroup Optimizers
  */
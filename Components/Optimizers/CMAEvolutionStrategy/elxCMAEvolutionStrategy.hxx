@@ -208,6 +208,19 @@ CMAEvolutionStrategy< TElastix >
     "MinimumDeviation", this->GetComponentLabel(), level, 0 );
   this->SetMinimumDeviation( minimumDeviation );
 
+  /** Set UseMultiThreading */
+  bool useMultiThreading = false;
+  this->m_Configuration->ReadParameter( useMultiThreading,
+    "UseMultiThreading", this->GetComponentLabel(), level, 0 );
+  if( useMultiThreading )
+  {
+    this->SetNumberOfThreads( itk::MultiThreader::GetGlobalDefaultNumberOfThreads() );
+  }
+  else
+  {
+    this->SetNumberOfThreads( 1 );
+  }
+
 }   // end BeforeEachResolution
 
 
@@ -26,6 +26,7 @@
 #include "itkCommand.h"
 #include "itkEventObject.h"
 #include "itkExceptionObject.h"
+#include "itkWorkerThreadPool.h"
 
 namespace itk
 {
@@ -38,7 +39,7 @@ CMAEvolutionStrategyOptimizer::CMAEvolutionStrategyOptimizer()
 {
   itkDebugMacro( "Constructor" );
 
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+  this->m_RandomGenerator = ThreadRandomGenerator::GetInstance();
 
   this->m_CurrentValue     = NumericTraits< MeasureType >::Zero;
   this->m_CurrentIteration = 0;
@@ -76,6 +77,9 @@ CMAEvolutionStrategyOptimizer::CMAEvolutionStrategyOptimizer()
   this->m_PositionToleranceMax       = 1e8;
   this->m_ValueTolerance             = 1e-12;
 
+  this->m_NumberOfThreads = 1;
+  this->m_NextMember      = 0;
+
 }   // end constructor
 
 
@@ -124,6 +128,8 @@ CMAEvolutionStrategyOptimizer::PrintSelf( std::ostream & os, Indent indent ) con
   os << indent << "m_PositionToleranceMin: " << this->m_PositionToleranceMin << std::endl;
   os << indent << "m_PositionToleranceMax: " << this->m_PositionToleranceMax << std::endl;
   os << indent << "m_ValueTolerance: " << this->m_ValueTolerance << std::endl;
+  os << indent << "m_NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "m_CostFunctionClones: " << this->m_CostFunctionClones.size() << std::endl;
 
   os << indent << "m_RecombinationWeights: " << this->m_RecombinationWeights << std::endl;
   os << indent << "m_C: " << this->m_C << std::endl;
@@ -157,6 +163,7 @@ CMAEvolutionStrategyOptimizer::StartOptimization()
 
   /** Initialize the scaledCostFunction with the currently set scales */
   this->InitializeScales();
+  this->InitializeCostFunctionClones();
 
   /** Set the current position as the scaled initial position */
   this->SetCurrentPosition( this->GetInitialPosition() );
@@ -276,6 +283,55 @@ CMAEvolutionStrategyOptimizer::StopOptimization()
 }   // end StopOptimization()
 
 
+/**
+ * ****************** SetCostFunctionClones *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::SetCostFunctionClones( const CostFunctionContainerType & clones )
+{
+  itkDebugMacro( "SetCostFunctionClones" );
+
+  this->m_CostFunctionClones = clones;
+  this->Modified();
+
+}   // end SetCostFunctionClones()
+
+
+/**
+ * ****************** InitializeCostFunctionClones *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::InitializeCostFunctionClones( void )
+{
+  itkDebugMacro( "InitializeCostFunctionClones" );
+
+  /** The clones are not profiled: the profiler is not thread safe. */
+  this->m_ScaledCostFunctionClones.clear();
+  for( unsigned int i = 0; i < this->m_CostFunctionClones.size(); ++i )
+  {
+    if( this->m_CostFunctionClones[ i ].IsNull() )
+    {
+      itkExceptionMacro( << "Cost function clone " << i << " is not set." );
+    }
+    ScaledCostFunctionType::Pointer scaledClone = ScaledCostFunctionType::New();
+    scaledClone->SetUnscaledCostFunction( this->m_CostFunctionClones[ i ] );
+    scaledClone->SetScales( this->m_ScaledCostFunction->GetScales() );
+    scaledClone->SetUseScales( this->m_ScaledCostFunction->GetUseScales() );
+    scaledClone->SetNegateCostFunction( this->m_ScaledCostFunction->GetNegateCostFunction() );
+    if( scaledClone->GetNumberOfParameters()
+      != this->m_ScaledCostFunction->GetNumberOfParameters() )
+    {
+      itkExceptionMacro( << "Cost function clone " << i
+                         << " has a different number of parameters than the cost function." );
+    }
+    this->m_ScaledCostFunctionClones.push_back( scaledClone );
+  }
+
+}   // end InitializeCostFunctionClones()
+
+
 /**
  * ****************** InitializeConstants *********************
  */
@@ -500,6 +556,12 @@ CMAEvolutionStrategyOptimizer::GenerateOffspring( void )
 {
   itkDebugMacro( "GenerateOffspring" );
 
+  if( this->m_NumberOfThreads > 1 )
+  {
+    this->GenerateOffspringMultiThreaded();
+    return;
+  }
+
   /** Get the number of parameters from the cost function */
   const unsigned int numberOfParameters
     = this->GetScaledCostFunction()->GetNumberOfParameters();
@@ -572,6 +634,235 @@ CMAEvolutionStrategyOptimizer::GenerateOffspring( void )
 }   // end GenerateOffspring
 
 
+/**
+ * ****************** GenerateOffspringMultiThreaded *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::GenerateOffspringMultiThreaded( void )
+{
+  itkDebugMacro( "GenerateOffspringMultiThreaded" );
+
+  /** Get the number of parameters from the cost function */
+  const unsigned int numberOfParameters
+    = this->GetScaledCostFunction()->GetNumberOfParameters();
+
+  /** Some casts/aliases: */
+  const unsigned int N      = numberOfParameters;
+  const unsigned int lambda = this->m_PopulationSize;
+
+  /** Clear the old values */
+  this->m_CostFunctionValues.clear();
+  this->m_MemberValues.assign( lambda, NumericTraits< MeasureType >::Zero );
+  this->m_MemberFailed.assign( lambda, 0 );
+  this->m_MemberErrors.assign( lambda, ExceptionObject() );
+
+  /** The members to be generated; at first all of them */
+  std::vector< unsigned int > members( lambda );
+  for( unsigned int lam = 0; lam < lambda; ++lam )
+  {
+    members[ lam ] = lam;
+  }
+  std::vector< unsigned int > nrOfFails( lambda, 0 );
+
+  MultiThreaderParameterType parameters;
+  parameters.st_Optimizer          = this;
+  parameters.st_Members            = &members;
+  parameters.st_WeightedSearchDirs = NULL;
+  parameters.st_OldCFactor         = 0.0;
+  parameters.st_RankOneFactor      = 0.0;
+  parameters.st_RankMuFactor       = 0.0;
+
+  while( !members.empty() )
+  {
+    /** Draw from distribution N(0,I), in the order of the members */
+    for( unsigned int m = 0; m < members.size(); ++m )
+    {
+      for( unsigned int par = 0; par < N; ++par )
+      {
+        this->m_NormalizedSearchDirs[ members[ m ] ][ par ]
+          = this->m_RandomGenerator->GetNormalVariate();
+      }
+    }
+
+    /** Make like they were drawn from N( 0, sigma^2 C ) */
+    const ThreadIdType numberOfThreads = static_cast< ThreadIdType >(
+      vnl_math_min( static_cast< unsigned long >( this->m_NumberOfThreads ),
+      static_cast< unsigned long >( members.size() ) ) );
+    WorkerThreadPool::GetInstance()->Execute(
+      ComputeSearchDirectionsThreaderCallback, &parameters, numberOfThreads );
+
+    /** Compute the cost function, concurrently if clones are available */
+    const ThreadIdType numberOfEvaluators = static_cast< ThreadIdType >(
+      vnl_math_min( static_cast< unsigned long >( numberOfThreads ),
+      static_cast< unsigned long >( this->m_ScaledCostFunctionClones.size() + 1 ) ) );
+    this->m_NextMember = 0;
+    if( numberOfEvaluators > 1 )
+    {
+      WorkerThreadPool::GetInstance()->Execute(
+        EvaluateMembersThreaderCallback, &parameters, numberOfEvaluators );
+    }
+    else
+    {
+      for( unsigned int m = 0; m < members.size(); ++m )
+      {
+        this->EvaluateMember( members[ m ], 0 );
+      }
+    }
+
+    /** Try the failed members again, if we haven't tried that for 10 times already */
+    std::vector< unsigned int > failedMembers;
+    for( unsigned int m = 0; m < members.size(); ++m )
+    {
+      const unsigned int lam = members[ m ];
+      if( !this->m_MemberFailed[ lam ] )
+      {
+        continue;
+      }
+      ++nrOfFails[ lam ];
+      if( nrOfFails[ lam ] > 10 )
+      {
+        this->m_StopCondition = MetricError;
+        this->StopOptimization();
+        throw this->m_MemberErrors[ lam ];
+      }
+      failedMembers.push_back( lam );
+    }
+    members.swap( failedMembers );
+  }
+
+  /** Successfull cost function evaluations, in the order of the members */
+  for( unsigned int lam = 0; lam < lambda; ++lam )
+  {
+    this->m_CostFunctionValues.push_back(
+      MeasureIndexPairType( this->m_MemberValues[ lam ], lam ) );
+  }
+
+}   // end GenerateOffspringMultiThreaded
+
+
+/**
+ * ****************** ComputeSearchDirections *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::ComputeSearchDirections(
+  const std::vector< unsigned int > & members,
+  unsigned long begin, unsigned long end )
+{
+  for( unsigned long m = begin; m < end; ++m )
+  {
+    const unsigned int lam = members[ m ];
+
+    /** Make like it was drawn from N(0,C) */
+    if( this->GetUseCovarianceMatrixAdaptation() )
+    {
+      this->m_SearchDirs[ lam ] = this->m_B * ( this->m_D * this->m_NormalizedSearchDirs[ lam ] );
+    }
+    else
+    {
+      this->m_SearchDirs[ lam ] = this->m_NormalizedSearchDirs[ lam ];
+    }
+    /** Make like it was drawn from N( 0, sigma^2 C ) */
+    this->m_SearchDirs[ lam ] *= this->m_CurrentSigma;
+  }
+
+}   // end ComputeSearchDirections
+
+
+/**
+ * ****************** EvaluateMember *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::EvaluateMember( unsigned int lam, ThreadIdType evaluator )
+{
+  /** x_lam = m + d_lam */
+  ParametersType x_lam = this->GetScaledCurrentPosition();
+  x_lam += this->m_SearchDirs[ lam ];
+  try
+  {
+    if( evaluator == 0 )
+    {
+      this->m_MemberValues[ lam ] = this->GetScaledValue( x_lam );
+    }
+    else
+    {
+      this->m_MemberValues[ lam ]
+        = this->m_ScaledCostFunctionClones[ evaluator - 1 ]->GetValue( x_lam );
+    }
+    this->m_MemberFailed[ lam ] = 0;
+  }
+  catch( ExceptionObject & err )
+  {
+    this->m_MemberFailed[ lam ] = 1;
+    this->m_MemberErrors[ lam ] = err;
+  }
+
+}   // end EvaluateMember
+
+
+/**
+ * ************ ComputeSearchDirectionsThreaderCallback ***************
+ */
+
+ITK_THREAD_RETURN_TYPE
+CMAEvolutionStrategyOptimizer::ComputeSearchDirectionsThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ThreadIdType threadID        = infoStruct->ThreadID;
+  const ThreadIdType numberOfThreads = infoStruct->NumberOfThreads;
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Each thread processes a contiguous range of members */
+  const unsigned long numberOfMembers = temp->st_Members->size();
+  const unsigned long begin           = threadID * numberOfMembers / numberOfThreads;
+  const unsigned long end             = ( threadID + 1 ) * numberOfMembers / numberOfThreads;
+  temp->st_Optimizer->ComputeSearchDirections( *temp->st_Members, begin, end );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end ComputeSearchDirectionsThreaderCallback
+
+
+/**
+ * ************ EvaluateMembersThreaderCallback ***************
+ */
+
+ITK_THREAD_RETURN_TYPE
+CMAEvolutionStrategyOptimizer::EvaluateMembersThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ThreadIdType threadID = infoStruct->ThreadID;
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+  Self * optimizer = temp->st_Optimizer;
+
+  /** Each thread takes the next member to be evaluated, so that threads
+   * with cheap evaluations do not wait for threads with expensive ones.
+   * The thread id selects the cost function (clone) to be used.
+   */
+  const unsigned long numberOfMembers = temp->st_Members->size();
+  while( true )
+  {
+    optimizer->m_NextMemberMutex.Lock();
+    const unsigned long m = optimizer->m_NextMember++;
+    optimizer->m_NextMemberMutex.Unlock();
+    if( m >= numberOfMembers )
+    {
+      break;
+    }
+    optimizer->EvaluateMember( ( *temp->st_Members )[ m ], threadID );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end EvaluateMembersThreaderCallback
+
+
 /**
  * ****************** SortCostFunctionValues *********************
  */
@@ -751,46 +1042,121 @@ CMAEvolutionStrategyOptimizer::UpdateC( void )
   const double       mu_cov = this->m_CovarianceMatrixAdaptationWeight;
   const double       sigma  = this->m_CurrentSigma;
 
-  /** Multiply old m_C with some factor */
+  /** The factor for old m_C */
   double oldCfactor = 1.0 - c_cov;
   if( !this->m_Heaviside )
   {
     oldCfactor += ( c_cov * c_c * ( 2.0 - c_c ) / mu_cov );
   }
-  this->m_C *= oldCfactor;
 
-  /** Do rank-one update */
-  const double rankonefactor = c_cov / mu_cov;
-  for( unsigned int i = 0; i < N; ++i )
+  /** The weighted search directions of the rank-mu update */
+  ParameterContainerType weightedSearchDirs( mu );
+  for( unsigned int m = 0; m < mu; ++m )
+  {
+    const unsigned int lam        = this->m_CostFunctionValues[ m ].second;
+    const double       sqrtweight = vcl_sqrt( this->m_RecombinationWeights[ m ] );
+    weightedSearchDirs[ m ]  = this->m_SearchDirs[ lam ];
+    weightedSearchDirs[ m ] *= ( sqrtweight / sigma );
+  }
+
+  MultiThreaderParameterType parameters;
+  parameters.st_Optimizer          = this;
+  parameters.st_Members            = NULL;
+  parameters.st_WeightedSearchDirs = &weightedSearchDirs;
+  parameters.st_OldCFactor         = oldCfactor;
+  parameters.st_RankOneFactor      = c_cov / mu_cov;
+  parameters.st_RankMuFactor       = c_cov * ( 1.0 - 1.0 / mu_cov );
+
+  /** Multiply old m_C with the factor, and do the rank-one and rank-mu
+   * updates, row by row. */
+  const ThreadIdType numberOfThreads = static_cast< ThreadIdType >(
+    vnl_math_min( this->m_NumberOfThreads, static_cast< ThreadIdType >( N ) ) );
+  if( numberOfThreads > 1 )
+  {
+    WorkerThreadPool::GetInstance()->Execute(
+      UpdateCThreaderCallback, &parameters, numberOfThreads );
+  }
+  else
   {
+    this->UpdateCRows( parameters, 0, N );
+  }
+
+}   // end UpdateC
+
+
+/**
+ * ****************** UpdateCRows *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::UpdateCRows(
+  const MultiThreaderParameterType & parameters,
+  unsigned int begin, unsigned int end )
+{
+  /** Some casts/aliases: */
+  const unsigned int             N                  = this->m_C.cols();
+  const ParameterContainerType & weightedSearchDirs = *parameters.st_WeightedSearchDirs;
+  const double                   rankonefactor      = parameters.st_RankOneFactor;
+  const double                   rankmufactor       = parameters.st_RankMuFactor;
+
+  /** Each element receives the updates in the same order as if the complete
+   * matrix would be updated at once: the result does not depend on the
+   * number of threads. */
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    double * C_i = this->m_C[ i ];
+    for( unsigned int j = 0; j < N; ++j )
+    {
+      C_i[ j ] *= parameters.st_OldCFactor;
+    }
+
+    /** Do rank-one update */
     const double evolutionPath_i = this->m_EvolutionPath[ i ];
     for( unsigned int j = 0; j < N; ++j )
     {
       const double update = rankonefactor * evolutionPath_i * this->m_EvolutionPath[ j ];
-      this->m_C[ i ][ j ] += update;
+      C_i[ j ] += update;
     }
-  }
 
-  /** Do rank-mu update */
-  const double rankmufactor = c_cov * ( 1.0 - 1.0 / mu_cov );
-  for( unsigned int m = 0; m < mu; ++m )
-  {
-    const unsigned int lam               = this->m_CostFunctionValues[ m ].second;
-    const double       sqrtweight        = vcl_sqrt( this->m_RecombinationWeights[ m ] );
-    ParametersType     weightedSearchDir = this->m_SearchDirs[ lam ];
-    weightedSearchDir *= ( sqrtweight / sigma );
-    for( unsigned int i = 0; i < N; ++i )
+    /** Do rank-mu update */
+    for( unsigned int m = 0; m < weightedSearchDirs.size(); ++m )
     {
-      const double weightedSearchDir_i = weightedSearchDir[ i ];
+      const ParametersType & weightedSearchDir   = weightedSearchDirs[ m ];
+      const double           weightedSearchDir_i = weightedSearchDir[ i ];
       for( unsigned int j = 0; j < N; ++j )
       {
         const double update = rankmufactor * weightedSearchDir_i * weightedSearchDir[ j ];
-        this->m_C[ i ][ j ] += update;
+        C_i[ j ] += update;
       }
     }
-  }   // end for m
+  }
 
-}   // end UpdateC
+}   // end UpdateCRows
+
+
+/**
+ * ****************** UpdateCThreaderCallback *********************
+ */
+
+ITK_THREAD_RETURN_TYPE
+CMAEvolutionStrategyOptimizer::UpdateCThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ThreadIdType threadID        = infoStruct->ThreadID;
+  const ThreadIdType numberOfThreads = infoStruct->NumberOfThreads;
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Each thread updates a contiguous range of rows */
+  const unsigned int N     = temp->st_Optimizer->m_C.rows();
+  const unsigned int begin = threadID * N / numberOfThreads;
+  const unsigned int end   = ( threadID + 1 ) * N / numberOfThreads;
+  temp->st_Optimizer->UpdateCRows( *temp, begin, end );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end UpdateCThreaderCallback
 
 
 /**
@@ -847,24 +1213,17 @@ CMAEvolutionStrategyOptimizer::UpdateBD( void )
     return;
   }
 
-  typedef itk::SymmetricEigenAnalysis<
-    CovarianceMatrixType,
-    EigenValueMatrixType,
-    CovarianceMatrixType >                      EigenAnalysisType;
-
-  /** In the itkEigenAnalysis only the upper triangle of the matrix will be accessed, so
-   * we do not need to make sure the matrix is symmetric, like in the
-   * matlab code. Just run the eigenAnalysis! */
-  EigenAnalysisType eigenAnalysis( N );
-  unsigned int      returncode = 0;
-  returncode = eigenAnalysis.ComputeEigenValuesAndVectors( this->m_C, this->m_D, this->m_B );
-  if( returncode != 0 )
+  /** Compute the eigen decomposition of C. The eigen vectors are stored in
+   * the columns of B. */
+  std::vector< double > eigenValues;
+  if( !this->ComputeEigenDecomposition( eigenValues ) )
   {
-    itkExceptionMacro( << "EigenAnalysis failed while computing eigenvalue nr: " << returncode );
+    itkExceptionMacro( << "EigenAnalysis failed: the QL algorithm did not converge." );
+  }
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    this->m_D[ i ] = eigenValues[ i ];
   }
-
-  /** itk eigen analysis returns eigen vectors in rows... */
-  this->m_B.inplace_transpose();
 
   /**  limit condition of C to 1e10 + 1, and avoid negative eigenvalues */
   const double largeNumber = 1e10;
@@ -909,6 +1268,429 @@ CMAEvolutionStrategyOptimizer::UpdateBD( void )
 }   // end UpdateBD
 
 
+/**
+ * **************** ComputeEigenDecomposition ********************
+ */
+
+bool
+CMAEvolutionStrategyOptimizer::ComputeEigenDecomposition(
+  std::vector< double > & eigenValues )
+{
+  itkDebugMacro( "ComputeEigenDecomposition" );
+
+  /** Some casts/aliases: */
+  const unsigned int     N = this->m_C.rows();
+  CovarianceMatrixType & A = this->m_B;
+
+  /** Below this size, the threads would not get enough work. */
+  const unsigned int minimumSizeForThreads = 100;
+  if( this->m_NumberOfThreads == 1 || N < minimumSizeForThreads )
+  {
+    typedef itk::SymmetricEigenAnalysis<
+      CovarianceMatrixType,
+      EigenValueMatrixType,
+      CovarianceMatrixType >                      EigenAnalysisType;
+
+    /** In the itkEigenAnalysis only the upper triangle of the matrix will be accessed, so
+     * we do not need to make sure the matrix is symmetric, like in the
+     * matlab code. Just run the eigenAnalysis! */
+    EigenAnalysisType    eigenAnalysis( N );
+    EigenValueMatrixType D( N );
+    unsigned int         returncode = 0;
+    returncode = eigenAnalysis.ComputeEigenValuesAndVectors( this->m_C, D, this->m_B );
+    if( returncode != 0 )
+    {
+      itkExceptionMacro( << "EigenAnalysis failed while computing eigenvalue nr: " << returncode );
+    }
+
+    /** itk eigen analysis returns eigen vectors in rows... */
+    this->m_B.inplace_transpose();
+    eigenValues.assign( D.diagonal().begin(), D.diagonal().end() );
+    return true;
+  }
+
+  std::vector< double > & d = eigenValues;
+  std::vector< double >   e( N, 0.0 );
+  std::vector< double >   householderNorms( N, 0.0 );
+  std::vector< double >   work( N, 0.0 );
+  d.assign( N, 0.0 );
+
+  EigenThreaderParameterType parameters;
+  parameters.st_Optimizer       = this;
+  parameters.st_Operation       = HouseholderProduct;
+  parameters.st_Size            = 0;
+  parameters.st_Matrix          = &A;
+  parameters.st_Householder     = NULL;
+  parameters.st_HouseholderNorm = 0.0;
+  parameters.st_Vector          = &work[ 0 ];
+  parameters.st_Cosines         = NULL;
+  parameters.st_Sines           = NULL;
+  parameters.st_FirstRotation   = 0;
+  parameters.st_LastRotation    = 0;
+
+  /** Reduce A = C to tridiagonal form, from the last row to the first. The
+   * Householder vector u that annihilates row i left of the subdiagonal
+   * is stored in that row. The leading i x i block is then updated as
+   * A = A - u q' - q u', with p = A u / H and q = p - ( u'p / 2H ) u, where
+   * both triangles are updated, so that A remains exactly symmetric. */
+  A = this->m_C;
+  for( unsigned int i = N - 1; i > 0; --i )
+  {
+    double * u     = A[ i ];
+    double   scale = 0.0;
+    for( unsigned int k = 0; k < i; ++k )
+    {
+      scale += vcl_abs( u[ k ] );
+    }
+    if( scale == 0.0 )
+    {
+      /** Row i is already reduced */
+      e[ i ] = u[ i - 1 ];
+    }
+    else
+    {
+      double H = 0.0;
+      for( unsigned int k = 0; k < i; ++k )
+      {
+        u[ k ] /= scale;
+        H      += u[ k ] * u[ k ];
+      }
+      const double f = u[ i - 1 ];
+      const double g = ( f > 0.0 ) ? -vcl_sqrt( H ) : vcl_sqrt( H );
+      e[ i ]                = scale * g;
+      H                    -= f * g;
+      u[ i - 1 ]            = f - g;
+      householderNorms[ i ] = H;
+
+      /** work = p = A u / H */
+      parameters.st_Size            = i;
+      parameters.st_Householder     = u;
+      parameters.st_HouseholderNorm = H;
+      parameters.st_Operation       = HouseholderProduct;
+      this->ExecuteEigenOperation( parameters, static_cast< unsigned long >( i ) * i );
+
+      /** work = q = p - ( u'p / 2H ) u */
+      double K = 0.0;
+      for( unsigned int k = 0; k < i; ++k )
+      {
+        K += u[ k ] * work[ k ];
+      }
+      K /= ( H + H );
+      for( unsigned int k = 0; k < i; ++k )
+      {
+        work[ k ] -= K * u[ k ];
+      }
+
+      /** A = A - u q' - q u' */
+      parameters.st_Operation = HouseholderUpdate;
+      this->ExecuteEigenOperation( parameters, static_cast< unsigned long >( i ) * i );
+    }
+    d[ i ] = A[ i ][ i ];
+  }
+  d[ 0 ] = A[ 0 ][ 0 ];
+
+  /** Accumulate the reflections: Q = P_{N-1} ... P_1, with P_i = I - u u' / H.
+   * The reflection P_i only changes the columns [0, i) of Q. */
+  CovarianceMatrixType Q( N, N );
+  Q.Fill( 0.0 );
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    Q[ i ][ i ] = 1.0;
+  }
+  parameters.st_Matrix    = &Q;
+  parameters.st_Operation = AccumulateReflection;
+  for( unsigned int i = 1; i < N; ++i )
+  {
+    if( householderNorms[ i ] == 0.0 )
+    {
+      continue;
+    }
+    parameters.st_Size            = i;
+    parameters.st_Householder     = A[ i ];
+    parameters.st_HouseholderNorm = householderNorms[ i ];
+    this->ExecuteEigenOperation( parameters, 2ul * i * i );
+  }
+
+  /** The QL algorithm with implicit shifts on the tridiagonal matrix, with
+   * diagonal d and subdiagonal e. The Givens rotations of a sweep are
+   * recorded first, and then applied to all rows of Q. */
+  for( unsigned int i = 1; i < N; ++i )
+  {
+    e[ i - 1 ] = e[ i ];
+  }
+  e[ N - 1 ] = 0.0;
+
+  std::vector< double > cosines( N, 0.0 );
+  std::vector< double > sines( N, 0.0 );
+  parameters.st_Size      = N;
+  parameters.st_Operation = ApplyRotations;
+  parameters.st_Cosines   = &cosines[ 0 ];
+  parameters.st_Sines     = &sines[ 0 ];
+
+  const double       epsilon          = vcl_pow( 2.0, -52.0 );
+  const unsigned int maximumNrOfSweeps = 30 * N;
+  double             shift            = 0.0;
+  double             tst1             = 0.0;
+  for( unsigned int l = 0; l < N; ++l )
+  {
+    /** Find a small subdiagonal element */
+    tst1 = vnl_math_max( tst1, vcl_abs( d[ l ] ) + vcl_abs( e[ l ] ) );
+    unsigned int m = l;
+    while( m < N - 1 && vcl_abs( e[ m ] ) > epsilon * tst1 )
+    {
+      ++m;
+    }
+
+    /** If m == l, d[ l ] is an eigen value; otherwise iterate */
+    unsigned int nrOfSweeps = 0;
+    while( m > l )
+    {
+      if( ++nrOfSweeps > maximumNrOfSweeps )
+      {
+        return false;
+      }
+
+      /** Compute the implicit shift */
+      double g = d[ l ];
+      double p = ( d[ l + 1 ] - g ) / ( 2.0 * e[ l ] );
+      double r = vcl_sqrt( p * p + 1.0 );
+      if( p < 0.0 )
+      {
+        r = -r;
+      }
+      d[ l ]     = e[ l ] / ( p + r );
+      d[ l + 1 ] = e[ l ] * ( p + r );
+      const double dl1 = d[ l + 1 ];
+      double       h   = g - d[ l ];
+      for( unsigned int i = l + 2; i < N; ++i )
+      {
+        d[ i ] -= h;
+      }
+      shift += h;
+
+      /** The QL sweep */
+      p = d[ m ];
+      double       c   = 1.0;
+      double       c2  = c;
+      double       c3  = c;
+      const double el1 = e[ l + 1 ];
+      double       s   = 0.0;
+      double       s2  = 0.0;
+      for( unsigned int i = m; i-- > l; )
+      {
+        c3           = c2;
+        c2           = c;
+        s2           = s;
+        g            = c * e[ i ];
+        h            = c * p;
+        r            = vcl_sqrt( p * p + e[ i ] * e[ i ] );
+        e[ i + 1 ]   = s * r;
+        s            = e[ i ] / r;
+        c            = p / r;
+        p            = c * d[ i ] - s * g;
+        d[ i + 1 ]   = h + s * ( c * g + s * d[ i ] );
+        cosines[ i ] = c;
+        sines[ i ]   = s;
+      }
+
+      /** Apply the rotations m-1, ..., l to the columns of Q */
+      parameters.st_FirstRotation = l;
+      parameters.st_LastRotation  = m;
+      this->ExecuteEigenOperation( parameters, static_cast< unsigned long >( N ) * ( m - l ) );
+
+      p      = -s * s2 * c3 * el1 * e[ l ] / dl1;
+      e[ l ] = s * p;
+      d[ l ] = c * p;
+
+      /** Check for convergence */
+      if( vcl_abs( e[ l ] ) <= epsilon * tst1 )
+      {
+        break;
+      }
+    }
+    d[ l ] += shift;
+    e[ l ]  = 0.0;
+  }
+
+  /** Sort the eigen values and the corresponding eigen vectors */
+  for( unsigned int i = 0; i + 1 < N; ++i )
+  {
+    unsigned int k = i;
+    double       p = d[ i ];
+    for( unsigned int j = i + 1; j < N; ++j )
+    {
+      if( d[ j ] < p )
+      {
+        k = j;
+        p = d[ j ];
+      }
+    }
+    if( k != i )
+    {
+      d[ k ] = d[ i ];
+      d[ i ] = p;
+      for( unsigned int j = 0; j < N; ++j )
+      {
+        std::swap( Q[ j ][ i ], Q[ j ][ k ] );
+      }
+    }
+  }
+
+  this->m_B = Q;
+  return true;
+
+}   // end ComputeEigenDecomposition
+
+
+/**
+ * **************** ExecuteEigenOperation ********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::ExecuteEigenOperation(
+  EigenThreaderParameterType & parameters, unsigned long work )
+{
+  /** Starting the threads only pays off for a sufficient amount of work.
+   * Each row or column is processed in the same way in both cases. */
+  const unsigned long minimumWorkPerThread = 4096;
+  const ThreadIdType  numberOfThreads      = static_cast< ThreadIdType >(
+    vnl_math_min( static_cast< unsigned long >( this->m_NumberOfThreads ),
+    vnl_math_min( static_cast< unsigned long >( parameters.st_Size ),
+    work / minimumWorkPerThread ) ) );
+  if( numberOfThreads > 1 )
+  {
+    WorkerThreadPool::GetInstance()->Execute(
+      EigenThreaderCallback, &parameters, numberOfThreads );
+  }
+  else
+  {
+    ExecuteEigenOperationRange( parameters, 0, parameters.st_Size );
+  }
+
+}   // end ExecuteEigenOperation
+
+
+/**
+ * **************** ExecuteEigenOperationRange ********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::ExecuteEigenOperationRange(
+  const EigenThreaderParameterType & parameters,
+  unsigned int begin, unsigned int end )
+{
+  CovarianceMatrixType & A = *parameters.st_Matrix;
+  const unsigned int     n = parameters.st_Size;
+  const double *         u = parameters.st_Householder;
+  const double           H = parameters.st_HouseholderNorm;
+  double *               v = parameters.st_Vector;
+
+  switch( parameters.st_Operation )
+  {
+    case HouseholderProduct:
+      /** v = A u / H, for the rows [begin, end) */
+      for( unsigned int j = begin; j < end; ++j )
+      {
+        const double * A_j = A[ j ];
+        double         sum = 0.0;
+        for( unsigned int k = 0; k < n; ++k )
+        {
+          sum += A_j[ k ] * u[ k ];
+        }
+        v[ j ] = sum / H;
+      }
+      break;
+
+    case HouseholderUpdate:
+      /** A = A - u v' - v u', for the rows [begin, end) */
+      for( unsigned int j = begin; j < end; ++j )
+      {
+        double *     A_j = A[ j ];
+        const double u_j = u[ j ];
+        const double v_j = v[ j ];
+        for( unsigned int k = 0; k < n; ++k )
+        {
+          A_j[ k ] -= u_j * v[ k ] + v_j * u[ k ];
+        }
+      }
+      break;
+
+    case AccumulateReflection:
+      /** A = A - u ( u'A / H ), for the columns [begin, end); the rows run
+       * over the support [0, n) of u */
+      for( unsigned int j = begin; j < end; ++j )
+      {
+        v[ j ] = 0.0;
+      }
+      for( unsigned int k = 0; k < n; ++k )
+      {
+        const double * A_k = A[ k ];
+        for( unsigned int j = begin; j < end; ++j )
+        {
+          v[ j ] += u[ k ] * A_k[ j ];
+        }
+      }
+      for( unsigned int j = begin; j < end; ++j )
+      {
+        v[ j ] /= H;
+      }
+      for( unsigned int k = 0; k < n; ++k )
+      {
+        double *     A_k = A[ k ];
+        const double u_k = u[ k ];
+        for( unsigned int j = begin; j < end; ++j )
+        {
+          A_k[ j ] -= u_k * v[ j ];
+        }
+      }
+      break;
+
+    case ApplyRotations:
+      /** Rotate the columns (i, i+1) for i = last-1, ..., first, for the
+       * rows [begin, end) */
+      for( unsigned int k = begin; k < end; ++k )
+      {
+        double * A_k = A[ k ];
+        for( unsigned int i = parameters.st_LastRotation; i-- > parameters.st_FirstRotation; )
+        {
+          const double c = parameters.st_Cosines[ i ];
+          const double s = parameters.st_Sines[ i ];
+          const double h = A_k[ i + 1 ];
+          A_k[ i + 1 ] = s * A_k[ i ] + c * h;
+          A_k[ i ]     = c * A_k[ i ] - s * h;
+        }
+      }
+      break;
+  }
+
+}   // end ExecuteEigenOperationRange
+
+
+/**
+ * **************** EigenThreaderCallback ********************
+ */
+
+ITK_THREAD_RETURN_TYPE
+CMAEvolutionStrategyOptimizer::EigenThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ThreadIdType threadID        = infoStruct->ThreadID;
+  const ThreadIdType numberOfThreads = infoStruct->NumberOfThreads;
+  const EigenThreaderParameterType * temp
+    = static_cast< EigenThreaderParameterType * >( infoStruct->UserData );
+
+  /** Each thread processes a contiguous range of rows or columns */
+  const unsigned int n     = temp->st_Size;
+  const unsigned int begin = threadID * n / numberOfThreads;
+  const unsigned int end   = ( threadID + 1 ) * n / numberOfThreads;
+  ExecuteEigenOperationRange( *temp, begin, end );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end EigenThreaderCallback
+
+
 /**
  * **************** FixNumericalErrors ********************
  */
@@ -26,7 +26,9 @@
 
 #include "itkArray.h"
 #include "itkArray2D.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkThreadRandomGenerator.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
 #include "vnl/vnl_diag_matrix.h"
 
 namespace itk
@@ -43,6 +45,16 @@ namespace itk
  *   - See also the Matlab code, cmaes.m, which you can download from the
  *     website mentioned above.
  *
+ * With NumberOfThreads larger than 1, the search directions of the offspring
+ * and the covariance matrix update are computed on the WorkerThreadPool, and
+ * so is the eigen decomposition of covariance matrices of at least 100
+ * parameters. The offspring is evaluated concurrently if
+ * independent copies of the cost function, each with its own state, are
+ * provided with SetCostFunctionClones(). The random numbers are always drawn
+ * in the order of the offspring, and every matrix element is computed in the
+ * same order of operations, so that the result does not depend on the number
+ * of threads.
+ *
  * \ingroup Numerics Optimizers
  */
 
@@ -67,6 +79,8 @@ public:
   typedef Superclass::MeasureType            MeasureType;
   typedef Superclass::ScalesType             ScalesType;
 
+  typedef std::vector< CostFunctionType::Pointer > CostFunctionContainerType;
+
   typedef enum {
     MetricError,
     MaximumNumberOfIterations,
@@ -219,6 +233,30 @@ public:
   itkSetMacro( ValueTolerance, double );
   itkGetConstMacro( ValueTolerance, double );
 
+  /** Setting: the number of threads used to generate the offspring, to
+   * evaluate it, and to update the covariance matrix and its eigen
+   * decomposition. If 1, the offspring
+   * is generated and evaluated one member at a time, as in the original
+   * algorithm. Otherwise, the search directions of all members are computed
+   * first, after which the members are evaluated.
+   * Default: 1 */
+  itkSetClampMacro( NumberOfThreads, ThreadIdType, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  /** Setting: independent copies of the cost function, which may be evaluated
+   * concurrently with the cost function itself and with each other. Each
+   * copy should have its own state (for a metric: its own transform and work
+   * buffers), so that no two threads evaluate the same object. With n clones,
+   * at most n + 1 offspring members are evaluated at the same time. The clones
+   * should have the same number of parameters, and return the same value as
+   * the cost function. They are scaled like the cost function when the
+   * optimization is started.
+   * Default: none, so the offspring is evaluated one member at a time. */
+  virtual void SetCostFunctionClones( const CostFunctionContainerType & clones );
+
+  const CostFunctionContainerType & GetCostFunctionClones( void ) const
+  { return this->m_CostFunctionClones; }
+
 protected:
 
   typedef Array< double >               RecombinationWeightsType;
@@ -233,6 +271,8 @@ protected:
 
   typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
 
+  typedef std::vector< ScaledCostFunctionType::Pointer > ScaledCostFunctionContainerType;
+
   /** The random number generator used to generate the offspring. */
   RandomGeneratorType::Pointer m_RandomGenerator;
 
@@ -312,6 +352,9 @@ protected:
   /** D: sqrt(eigen values) */
   EigenValueMatrixType m_D;
 
+  /** The cost function clones, scaled like m_ScaledCostFunction */
+  ScaledCostFunctionContainerType m_ScaledCostFunctionClones;
+
   /** Constructor */
   CMAEvolutionStrategyOptimizer();
 
@@ -354,10 +397,20 @@ protected:
   /** Initialize the covariance matrix and its eigen decomposition */
   virtual void InitializeBCD( void );
 
+  /** Wrap the cost function clones in scaled cost functions, with the
+   * scales of m_ScaledCostFunction */
+  virtual void InitializeCostFunctionClones( void );
+
   /** GenerateOffspring: Fill m_SearchDirs, m_NormalizedSearchDirs,
    * and m_CostFunctionValues */
   virtual void GenerateOffspring( void );
 
+  /** GenerateOffspring with NumberOfThreads > 1: draw the normalized search
+   * directions of all members, compute their search directions in parallel,
+   * and evaluate them, concurrently if cost function clones are available.
+   * Members for which the evaluation failed are drawn again. */
+  virtual void GenerateOffspringMultiThreaded( void );
+
   /** Sort the m_CostFunctionValues vector and update m_MeasureHistory */
   virtual void SortCostFunctionValues( void );
 
@@ -382,6 +435,15 @@ protected:
   /** Update the eigen decomposition and m_CurrentMaximumD/m_CurrentMinimumD */
   virtual void UpdateBD( void );
 
+  /** Compute the eigen decomposition of m_C: the eigen vectors are stored in
+   * the columns of m_B, and the eigen values, in ascending order, in
+   * eigenValues. With one thread, or a small matrix, the SymmetricEigenAnalysis
+   * is used. Otherwise the matrix is reduced to tridiagonal form by
+   * multi-threaded Householder reflections, after which the QL algorithm with
+   * implicit shifts is used, as in EISPACK's tred2 and tql2. Returns false if
+   * the QL algorithm does not converge. */
+  virtual bool ComputeEigenDecomposition( std::vector< double > & eigenValues );
+
   /** Some checks, to be sure no numerical errors occur
    * \li Adjust too low/high deviation that otherwise would violate
    * m_MinimumDeviation or m_MaximumDeviation.
@@ -410,6 +472,83 @@ private:
   CMAEvolutionStrategyOptimizer( const Self & ); // purposely not implemented
   void operator=( const Self & );                // purposely not implemented
 
+  /** The struct passed to the threads. */
+  struct MultiThreaderParameterType
+  {
+    Self *                              st_Optimizer;
+    const std::vector< unsigned int > * st_Members;
+    const ParameterContainerType *      st_WeightedSearchDirs;
+    double                              st_OldCFactor;
+    double                              st_RankOneFactor;
+    double                              st_RankMuFactor;
+  };
+
+  /** Compute m_SearchDirs from m_NormalizedSearchDirs for some members. */
+  void ComputeSearchDirections( const std::vector< unsigned int > & members,
+    unsigned long begin, unsigned long end );
+
+  /** Evaluate the cost function for a member, using the cost function
+   * (evaluator 0) or one of its clones. A failure is recorded, not thrown. */
+  void EvaluateMember( unsigned int lam, ThreadIdType evaluator );
+
+  /** Update the rows [begin, end) of the covariance matrix. */
+  void UpdateCRows( const MultiThreaderParameterType & parameters,
+    unsigned int begin, unsigned int end );
+
+  /** The steps of ComputeEigenDecomposition() that are multi-threaded. */
+  typedef enum {
+    HouseholderProduct,
+    HouseholderUpdate,
+    AccumulateReflection,
+    ApplyRotations
+  } EigenOperationType;
+
+  /** The struct passed to the threads of ComputeEigenDecomposition(). Each
+   * thread processes a contiguous range of the st_Size rows or columns. */
+  struct EigenThreaderParameterType
+  {
+    Self *                 st_Optimizer;
+    EigenOperationType     st_Operation;
+    unsigned int           st_Size;
+    CovarianceMatrixType * st_Matrix;
+    const double *         st_Householder;
+    double                 st_HouseholderNorm;
+    double *               st_Vector;
+    const double *         st_Cosines;
+    const double *         st_Sines;
+    unsigned int           st_FirstRotation;
+    unsigned int           st_LastRotation;
+  };
+
+  /** Execute a step of the eigen decomposition, with multiple threads if
+   * it involves at least the given number of multiply-adds. */
+  void ExecuteEigenOperation( EigenThreaderParameterType & parameters,
+    unsigned long work );
+
+  /** Execute a step of the eigen decomposition on the rows or columns
+   * [begin, end). */
+  static void ExecuteEigenOperationRange(
+    const EigenThreaderParameterType & parameters,
+    unsigned int begin, unsigned int end );
+
+  /** The callbacks executed by the threads. */
+  static ITK_THREAD_RETURN_TYPE ComputeSearchDirectionsThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE EvaluateMembersThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE UpdateCThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE EigenThreaderCallback( void * arg );
+
+  /** Multi-threading settings and the results of the concurrent evaluation. */
+  ThreadIdType                   m_NumberOfThreads;
+  CostFunctionContainerType      m_CostFunctionClones;
+  std::vector< MeasureType >     m_MemberValues;
+  std::vector< unsigned char >   m_MemberFailed;
+  std::vector< ExceptionObject > m_MemberErrors;
+  unsigned long                  m_NextMember;
+  SimpleMutexLock                m_NextMemberMutex;
+
   /** Settings that are only inspected/changed by the associated get/set member functions. */
   unsigned long m_MaximumNumberOfIterations;
   bool          m_UseDecayingSigma;
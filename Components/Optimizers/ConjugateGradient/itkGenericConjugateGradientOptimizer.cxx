@@ -20,6 +20,7 @@
 #define __itkGenericConjugateGradientOptimizer_cxx
 
 #include "itkGenericConjugateGradientOptimizer.h"
+#include "itkParameterVectorOperations.h"
 #include "vnl/vnl_math.h"
 
 namespace itk
@@ -264,8 +265,6 @@ GenericConjugateGradientOptimizer::ComputeSearchDirection(
 {
   itkDebugMacro( "ComputeSearchDirection" );
 
-  const unsigned int numberOfParameters = gradient.GetSize();
-
   /** When no previous gradient and/or previous search direction are
    * available, return the negative gradient as search direction */
   if( !this->m_PreviousGradientAndSearchDirValid )
@@ -284,10 +283,8 @@ GenericConjugateGradientOptimizer::ComputeSearchDirection(
   }
 
   /** Compute the new search direction */
-  for( unsigned int i = 0; i < numberOfParameters; ++i )
-  {
-    searchDir[ i ] = -gradient[ i ] + beta * searchDir[ i ];
-  }
+  ParameterVectorOperations::LinearCombination(
+    -1.0, gradient, beta, searchDir, searchDir );
 
 }   // end ComputeSearchDirection
 
@@ -405,17 +402,8 @@ GenericConjugateGradientOptimizer::ComputeBetaFR(
   const DerivativeType & gradient,
   const ParametersType & itkNotUsed( previousSearchDir ) )
 {
-  const unsigned int numberOfParameters = gradient.GetSize();
-  double             num                = 0.0;
-  double             den                = 0.0;
-
-  for( unsigned int i = 0; i < numberOfParameters; ++i )
-  {
-    const double & grad     = gradient[ i ];
-    const double & prevgrad = previousGradient[ i ];
-    num += grad * grad;
-    den += prevgrad * prevgrad;
-  }
+  const double num = ParameterVectorOperations::SquaredNorm( gradient );
+  const double den = ParameterVectorOperations::SquaredNorm( previousGradient );
 
   if( den <= NumericTraits< double >::epsilon() )
   {
@@ -438,17 +426,9 @@ GenericConjugateGradientOptimizer::ComputeBetaPR(
   const DerivativeType & gradient,
   const ParametersType & itkNotUsed( previousSearchDir ) )
 {
-  const unsigned int numberOfParameters = gradient.GetSize();
-  double             num                = 0.0;
-  double             den                = 0.0;
-
-  for( unsigned int i = 0; i < numberOfParameters; ++i )
-  {
-    const double & grad     = gradient[ i ];
-    const double & prevgrad = previousGradient[ i ];
-    num += grad * ( grad - prevgrad );
-    den += prevgrad * prevgrad;
-  }
+  const double num = ParameterVectorOperations::DotDifference(
+    gradient, gradient, previousGradient );
+  const double den = ParameterVectorOperations::SquaredNorm( previousGradient );
 
   if( den <= NumericTraits< double >::epsilon() )
   {
@@ -471,16 +451,9 @@ GenericConjugateGradientOptimizer::ComputeBetaDY(
   const DerivativeType & gradient,
   const ParametersType & previousSearchDir )
 {
-  const unsigned int numberOfParameters = gradient.GetSize();
-  double             num                = 0.0;
-  double             den                = 0.0;
-
-  for( unsigned int i = 0; i < numberOfParameters; ++i )
-  {
-    const double & grad = gradient[ i ];
-    num += grad * grad;
-    den += previousSearchDir[ i ] * ( grad - previousGradient[ i ] );
-  }
+  const double num = ParameterVectorOperations::SquaredNorm( gradient );
+  const double den = ParameterVectorOperations::DotDifference(
+    previousSearchDir, gradient, previousGradient );
 
   if( den <= NumericTraits< double >::epsilon() )
   {
@@ -502,16 +475,10 @@ GenericConjugateGradientOptimizer::ComputeBetaHS(
   const DerivativeType & gradient,
   const ParametersType & previousSearchDir )
 {
-  const unsigned int numberOfParameters = gradient.GetSize();
-  double             num                = 0.0;
-  double             den                = 0.0;
-
-  for( unsigned int i = 0; i < numberOfParameters; ++i )
-  {
-    const double & diff = gradient[ i ] - previousGradient[ i ];
-    num += gradient[ i ] * diff;
-    den += previousSearchDir[ i ] * diff;
-  }
+  const double num = ParameterVectorOperations::DotDifference(
+    gradient, gradient, previousGradient );
+  const double den = ParameterVectorOperations::DotDifference(
+    previousSearchDir, gradient, previousGradient );
 
   if( den <= NumericTraits< double >::epsilon() )
   {
@@ -612,8 +579,8 @@ GenericConjugateGradientOptimizer::TestConvergence( bool itkNotUsed( firstLineSe
   }
 
   /** Check for convergence of gradient magnitude */
-  const double gnorm = this->GetCurrentGradient().magnitude();
-  const double xnorm = this->GetScaledCurrentPosition().magnitude();
+  const double gnorm = ParameterVectorOperations::Norm( this->GetCurrentGradient() );
+  const double xnorm = ParameterVectorOperations::Norm( this->GetScaledCurrentPosition() );
   if( gnorm / vnl_math_max( 1.0, xnorm ) <= this->GetGradientMagnitudeTolerance() )
   {
     this->m_StopCondition = GradientMagnitudeTolerance;
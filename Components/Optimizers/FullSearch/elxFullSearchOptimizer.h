@@ -20,7 +20,9 @@
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
 #include "itkFullSearchOptimizer.h"
+#include "itkImageGridSampler.h"
 #include <map>
+#include <vector>
 
 #include "itkNDImageBase.h"
 
@@ -48,6 +50,34 @@ namespace elastix
  *   This varies the second transform parameter in the range [-4.0 3.0] with steps of 1.0
  *   and the third parameter in the range [-1.0 1.0] with steps of 0.5. The names are used
  *   as column headers in the screen output.
+ * \parameter CoarseGridStride: Search coarse-to-fine: first only every n-th grid point
+ *   in each dimension is evaluated, after which the neighbourhoods of the best points are
+ *   searched with the stride halved, until the full resolution is reached. Points that are
+ *   not evaluated are NaN in the OptimizationSurface image. Can be given for each resolution.\n
+ *   example: <tt>(CoarseGridStride 4)</tt> \n
+ *   Default: 1, which evaluates all grid points.
+ * \parameter NumberOfRefinedPoints: The number of best points of which the neighbourhood is
+ *   searched at each finer level of the coarse-to-fine search. Can be given for each resolution.\n
+ *   example: <tt>(NumberOfRefinedPoints 3)</tt> \n
+ *   Default: 1.
+ * \parameter PruningSampleGridSpacing: Prune points with a cheap estimate of the metric:
+ *   before a point is evaluated, the metrics are evaluated on a regular grid of samples with
+ *   this spacing (in voxels), instead of on the samples of the image sampler. The point is
+ *   skipped if this estimate is worse than the best estimate of the previously evaluated batches
+ *   of points by more than the PruningMargin. Pruned points are NaN in the OptimizationSurface
+ *   image. Metrics that do not use an image sampler are evaluated as usual. Can be given for
+ *   each resolution and each dimension.\n
+ *   example: <tt>(PruningSampleGridSpacing 8 8 8)</tt> \n
+ *   Default: no pruning.
+ * \parameter PruningMargin: The margin by which the estimate of a point may be worse than the
+ *   best estimate, before the point is pruned. Can be given for each resolution.\n
+ *   example: <tt>(PruningMargin 0.05)</tt> \n
+ *   Default: 0.
+ *
+ * This component evaluates the grid points serially, one after another, since the elastix
+ * metrics share their transform and sampler and cannot be copied; each evaluation is
+ * multi-threaded by the metric. The parallel grid evaluation of itk::FullSearchOptimizer is
+ * only available to ITK-level callers that supply cost function clones.
  *
  * \ingroup Optimizers
  * \sa FullSearchOptimizer
@@ -105,6 +135,14 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
+  /** Typedef's for the pruning. */
+  typedef typename ElastixType::FixedImageType           FixedImageType;
+  typedef typename ElastixType::MetricBaseType           MetricBaseType;
+  typedef typename MetricBaseType::ImageSamplerBaseType  MetricImageSamplerType;
+  typedef itk::ImageGridSampler< FixedImageType >        PruningImageSamplerType;
+  typedef typename PruningImageSamplerType::SampleGridSpacingType
+    PruningSampleGridSpacingType;
+
   /** To store the results of the full search */
   typedef itk::NDImageBase< float >     NDImageType;
   typedef typename NDImageType::Pointer NDImagePointer;
@@ -136,6 +174,76 @@ protected:
 
   NDImagePointer m_OptimizationSurface;
 
+  /** \class PruningCostFunction
+   * The cost function used to prune points: the cost function of the
+   * registration, with the image samplers of the metrics replaced by
+   * grid samplers with the PruningSampleGridSpacing.
+   */
+  class PruningCostFunction : public itk::SingleValuedCostFunction
+  {
+public:
+
+    typedef PruningCostFunction             Self;
+    typedef itk::SingleValuedCostFunction   Superclass;
+    typedef itk::SmartPointer< Self >       Pointer;
+    typedef itk::SmartPointer< const Self > ConstPointer;
+
+    itkNewMacro( Self );
+    itkTypeMacro( PruningCostFunction, SingleValuedCostFunction );
+
+    typedef Superclass::ParametersType ParametersType;
+    typedef Superclass::DerivativeType DerivativeType;
+    typedef Superclass::MeasureType    MeasureType;
+
+    /** Set the optimizer, whose cost function is evaluated, the elastix
+     * object, which gives the metrics, and the spacing of the samples.
+     * Forgets the samplers of the previous resolution. */
+    void Initialize( const Superclass1 * optimizer, ElastixType * elastix,
+      const PruningSampleGridSpacingType & sampleGridSpacing )
+    {
+      this->m_Optimizer         = optimizer;
+      this->m_Elastix           = elastix;
+      this->m_SampleGridSpacing = sampleGridSpacing;
+      this->m_Samplers.clear();
+    }
+
+
+    virtual unsigned int GetNumberOfParameters( void ) const
+    {
+      return this->m_Optimizer->GetCostFunction()->GetNumberOfParameters();
+    }
+
+
+    virtual MeasureType GetValue( const ParametersType & parameters ) const;
+
+    virtual void GetDerivative( const ParametersType &, DerivativeType & ) const
+    {
+      itkExceptionMacro( << "Not implemented" );
+    }
+
+
+protected:
+
+    PruningCostFunction() : m_Optimizer( 0 ), m_Elastix( 0 ) {}
+    virtual ~PruningCostFunction() {}
+
+private:
+
+    PruningCostFunction( const Self & );  // purposely not implemented
+    void operator=( const Self & );       // purposely not implemented
+
+    const Superclass1 *          m_Optimizer;
+    ElastixType *                m_Elastix;
+    PruningSampleGridSpacingType m_SampleGridSpacing;
+
+    /** The grid samplers, one for each metric; created at the first
+     * evaluation, when the samplers of the metrics are initialized. */
+    mutable std::vector< typename PruningImageSamplerType::Pointer > m_Samplers;
+
+  };
+
+  typename PruningCostFunction::Pointer m_PruningMetric;
+
   DimensionNameMapType m_SearchSpaceDimensionNames;
 
   /** Checks if an error generated while reading the search space
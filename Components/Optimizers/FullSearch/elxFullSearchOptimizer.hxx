@@ -23,6 +23,7 @@
 #include <sstream>
 #include <string>
 #include "vnl/vnl_math.h"
+#include <limits>
 
 namespace elastix
 {
@@ -36,6 +37,7 @@ FullSearch< TElastix >
 ::FullSearch()
 {
   this->m_OptimizationSurface = 0;
+  this->m_PruningMetric       = 0;
 
 } // end Constructor
 
@@ -180,6 +182,10 @@ FullSearch< TElastix >
     this->m_OptimizationSurface->Allocate();
     /** \todo try/catch block around Allocate? */
 
+    /** Points skipped by the coarse-to-fine search are not a number. */
+    this->m_OptimizationSurface->FillBuffer(
+      std::numeric_limits< float >::quiet_NaN() );
+
     /** Set the name of this image on disk. */
     std::string resultImageFormat = "mhd";
     this->m_Configuration->ReadParameter(
@@ -193,10 +199,62 @@ FullSearch< TElastix >
       << "." << resultImageFormat;
     this->m_OptimizationSurface->SetOutputFileName( makeString.str().c_str() );
 
-    elxout
-      << "Total number of iterations needed in this resolution: "
-      << this->GetNumberOfIterations()
-      << "." << std::endl;
+    /** Set the coarse-to-fine search. */
+    unsigned int coarseGridStride = 1;
+    this->GetConfiguration()->ReadParameter( coarseGridStride,
+      "CoarseGridStride", this->GetComponentLabel(), level, 0 );
+    this->SetCoarseGridStride( coarseGridStride );
+
+    unsigned int numberOfRefinedPoints = 1;
+    this->GetConfiguration()->ReadParameter( numberOfRefinedPoints,
+      "NumberOfRefinedPoints", this->GetComponentLabel(), level, 0 );
+    this->SetNumberOfRefinedPoints( numberOfRefinedPoints );
+
+    /** Set the pruning, if a sample grid spacing is given for it. */
+    const unsigned int           fixedImageDimension = FixedImageType::ImageDimension;
+    PruningSampleGridSpacingType pruningSampleGridSpacing;
+    bool                         prune = false;
+    for( unsigned int dim = 0; dim < fixedImageDimension; dim++ )
+    {
+      unsigned int spacing_dim = 1;
+      prune |= this->GetConfiguration()->ReadParameter( spacing_dim,
+        "PruningSampleGridSpacing", this->GetComponentLabel(),
+        level * fixedImageDimension + dim, dim, false );
+      pruningSampleGridSpacing[ dim ] = static_cast<
+        typename PruningImageSamplerType::SampleGridSpacingValueType >( spacing_dim );
+    }
+    if( prune )
+    {
+      if( this->m_PruningMetric.IsNull() )
+      {
+        this->m_PruningMetric = PruningCostFunction::New();
+      }
+      this->m_PruningMetric->Initialize( this, this->GetElastix(), pruningSampleGridSpacing );
+      this->SetPruningCostFunction( this->m_PruningMetric.GetPointer() );
+
+      double pruningMargin = 0.0;
+      this->GetConfiguration()->ReadParameter( pruningMargin,
+        "PruningMargin", this->GetComponentLabel(), level, 0 );
+      this->SetPruningMargin( pruningMargin );
+    }
+    else
+    {
+      this->SetPruningCostFunction( 0 );
+    }
+
+    if( this->GetCoarseGridStride() > 1 || prune )
+    {
+      elxout
+        << "At most " << this->GetNumberOfIterations()
+        << " iterations are needed in this resolution." << std::endl;
+    }
+    else
+    {
+      elxout
+        << "Total number of iterations needed in this resolution: "
+        << this->GetNumberOfIterations()
+        << "." << std::endl;
+    }
 
   }
   else
@@ -265,6 +323,16 @@ FullSearch< TElastix >
 
   /** Print the stopping condition */
   elxout << "Stopping condition: " << stopcondition << "." << std::endl;
+  if( this->GetCoarseGridStride() > 1 || this->GetPruningCostFunction() )
+  {
+    elxout << "Number of evaluated points: " << this->GetCurrentIteration()
+           << " of " << this->GetNumberOfIterations() << "." << std::endl;
+  }
+  if( this->GetPruningCostFunction() )
+  {
+    elxout << "Number of pruned points: " << this->GetNumberOfPrunedPoints()
+           << "." << std::endl;
+  }
 
   /** Write the optimization surface to disk */
   bool writeSurfaceEachResolution = false;
@@ -381,6 +449,72 @@ FullSearch< TElastix >
 } // end CheckSearchSpaceRangeDefinition()
 
 
+/**
+ * ***************** PruningCostFunction::GetValue ***********************
+ */
+
+template< class TElastix >
+typename FullSearch< TElastix >::PruningCostFunction::MeasureType
+FullSearch< TElastix >::PruningCostFunction
+::GetValue( const ParametersType & parameters ) const
+{
+  /** Replace the sampler of each metric that uses one by a grid sampler
+   * with the same input, like MetricBase::GetExactValue() does.
+   */
+  const unsigned int numberOfMetrics = this->m_Elastix->GetNumberOfMetrics();
+  std::vector< typename MetricImageSamplerType::Pointer > originalSamplers( numberOfMetrics );
+  const bool createSamplers = this->m_Samplers.size() != numberOfMetrics;
+  this->m_Samplers.resize( numberOfMetrics );
+  for( unsigned int i = 0; i < numberOfMetrics; i++ )
+  {
+    MetricBaseType * metric = this->m_Elastix->GetElxMetricBase( i );
+    originalSamplers[ i ] = metric->GetAdvancedMetricImageSampler();
+    if( originalSamplers[ i ].IsNull() )
+    {
+      continue;
+    }
+    if( createSamplers )
+    {
+      this->m_Samplers[ i ] = PruningImageSamplerType::New();
+      this->m_Samplers[ i ]->SetInput( originalSamplers[ i ]->GetInput() );
+      this->m_Samplers[ i ]->SetMask( originalSamplers[ i ]->GetMask() );
+      this->m_Samplers[ i ]->SetInputImageRegion(
+        originalSamplers[ i ]->GetInputImageRegion() );
+      this->m_Samplers[ i ]->SetSampleGridSpacing( this->m_SampleGridSpacing );
+    }
+    metric->SetAdvancedMetricImageSampler( this->m_Samplers[ i ] );
+  }
+
+  /** Compute the value, and reset the original samplers. */
+  MeasureType value = itk::NumericTraits< MeasureType >::Zero;
+  try
+  {
+    value = this->m_Optimizer->GetCostFunction()->GetValue( parameters );
+  }
+  catch( itk::ExceptionObject & )
+  {
+    for( unsigned int i = 0; i < numberOfMetrics; i++ )
+    {
+      if( originalSamplers[ i ].IsNotNull() )
+      {
+        this->m_Elastix->GetElxMetricBase( i )->SetAdvancedMetricImageSampler( originalSamplers[ i ] );
+      }
+    }
+    throw;
+  }
+  for( unsigned int i = 0; i < numberOfMetrics; i++ )
+  {
+    if( originalSamplers[ i ].IsNotNull() )
+    {
+      this->m_Elastix->GetElxMetricBase( i )->SetAdvancedMetricImageSampler( originalSamplers[ i ] );
+    }
+  }
+
+  return value;
+
+} // end PruningCostFunction::GetValue()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxFullSearchOptimizer_hxx
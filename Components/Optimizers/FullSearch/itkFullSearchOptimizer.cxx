@@ -24,6 +24,9 @@
 #include "itkEventObject.h"
 #include "itkExceptionObject.h"
 #include "itkNumericTraits.h"
+#include "itkWorkerThreadPool.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -46,6 +49,15 @@ FullSearchOptimizer
   m_SearchSpace                   = 0;
   m_LastSearchSpaceChanges        = 0;
 
+  m_NumberOfThreads       = 1;
+  m_CoarseGridStride      = 1;
+  m_NumberOfRefinedPoints = 1;
+  m_PruningCostFunction   = 0;
+  m_PruningMargin         = 0.0;
+  m_NextPoint             = 0;
+  m_BestPruningValue      = 0.0;
+  m_NumberOfPrunedPoints  = 0;
+
 }   //end constructor
 
 
@@ -80,6 +92,12 @@ FullSearchOptimizer
     m_BestValue = NumericTraits< double >::max();
   }
 
+  /** Reset the state of the batch search */
+  m_Visited.clear();
+  m_EvaluatedPoints.clear();
+  m_BestPruningValue     = m_BestValue;
+  m_NumberOfPrunedPoints = 0;
+
   this->ResumeOptimization();
 
 }
@@ -95,6 +113,12 @@ FullSearchOptimizer
 
   itkDebugMacro( "ResumeOptimization" );
 
+  if( m_NumberOfThreads > 1 || m_CoarseGridStride > 1 || m_PruningCostFunction.IsNotNull() )
+  {
+    this->ResumeBatchOptimization();
+    return;
+  }
+
   m_Stop = false;
 
   InvokeEvent( StartEvent() );
@@ -149,6 +173,369 @@ FullSearchOptimizer
 }   //end function ResumeOptimization
 
 
+/**
+ * ******************** ResumeBatchOptimization ******************
+ */
+void
+FullSearchOptimizer
+::ResumeBatchOptimization( void )
+{
+
+  itkDebugMacro( "ResumeBatchOptimization" );
+
+  m_Stop = false;
+
+  this->ProcessSearchSpaceChanges();
+  const unsigned int  searchSpaceDimension = m_NumberOfSearchSpaceDimensions;
+  const unsigned long numberOfPoints       = this->GetNumberOfIterations();
+
+  /** Points that were visited before are skipped, when resuming. */
+  if( m_Visited.size() != numberOfPoints )
+  {
+    m_Visited.assign( numberOfPoints, false );
+    m_EvaluatedPoints.clear();
+  }
+
+  InvokeEvent( StartEvent() );
+
+  /** The coarsest level: the points with all indices a multiple of the stride. */
+  IndexValueType               stride = static_cast< IndexValueType >( m_CoarseGridStride );
+  std::vector< unsigned long > offsets;
+  SearchSpaceIndexType         index( searchSpaceDimension );
+  for( unsigned long offset = 0; offset < numberOfPoints; offset++ )
+  {
+    if( m_Visited[ offset ] )
+    {
+      continue;
+    }
+    this->OffsetToIndex( offset, index );
+    bool onGrid = true;
+    for( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+    {
+      onGrid &= ( index[ ssdim ] % stride == 0 );
+    }
+    if( onGrid )
+    {
+      m_Visited[ offset ] = true;
+      offsets.push_back( offset );
+    }
+  }
+  if( !this->EvaluatePoints( offsets ) )
+  {
+    return;
+  }
+
+  /** The finer levels: search the neighbourhood of the best points so far. */
+  while( stride > 1 )
+  {
+    const IndexValueType previousStride = stride;
+    stride = stride / 2;
+
+    const unsigned long numberOfRefinedPoints = std::min(
+      static_cast< unsigned long >( m_NumberOfRefinedPoints ),
+      static_cast< unsigned long >( m_EvaluatedPoints.size() ) );
+    std::partial_sort( m_EvaluatedPoints.begin(),
+      m_EvaluatedPoints.begin() + numberOfRefinedPoints, m_EvaluatedPoints.end() );
+
+    offsets.clear();
+    SearchSpaceIndexType center( searchSpaceDimension );
+    SearchSpaceIndexType lower( searchSpaceDimension );
+    SearchSpaceIndexType upper( searchSpaceDimension );
+    for( unsigned long p = 0; p < numberOfRefinedPoints; p++ )
+    {
+      /** The box of points closer than the previous stride, on the new grid. */
+      this->OffsetToIndex( m_EvaluatedPoints[ p ].second, center );
+      for( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+      {
+        const IndexValueType last = static_cast< IndexValueType >( m_SearchSpaceSize[ ssdim ] ) - 1;
+        lower[ ssdim ] = std::max< IndexValueType >( 0, center[ ssdim ] - previousStride + 1 );
+        lower[ ssdim ] = ( ( lower[ ssdim ] + stride - 1 ) / stride ) * stride;
+        upper[ ssdim ] = std::min( last, center[ ssdim ] + previousStride - 1 );
+      }
+
+      /** Walk through the box, dimension 0 fastest. */
+      index = lower;
+      bool done = false;
+      while( !done )
+      {
+        unsigned long offset = 0;
+        for( int ssdim = searchSpaceDimension - 1; ssdim >= 0; ssdim-- )
+        {
+          offset = offset * m_SearchSpaceSize[ ssdim ] + index[ ssdim ];
+        }
+        if( !m_Visited[ offset ] )
+        {
+          m_Visited[ offset ] = true;
+          offsets.push_back( offset );
+        }
+
+        done = true;
+        for( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+        {
+          index[ ssdim ] += stride;
+          if( index[ ssdim ] <= upper[ ssdim ] )
+          {
+            done = false;
+            break;
+          }
+          index[ ssdim ] = lower[ ssdim ];
+        }
+      }
+    }
+
+    /** Evaluate in the order of the grid. */
+    std::sort( offsets.begin(), offsets.end() );
+    if( !this->EvaluatePoints( offsets ) )
+    {
+      return;
+    }
+  }
+
+  m_StopCondition = FullRangeSearched;
+  StopOptimization();
+
+}   //end function ResumeBatchOptimization
+
+
+/**
+ * ************************** EvaluatePoints **********************
+ */
+bool
+FullSearchOptimizer
+::EvaluatePoints( const std::vector< unsigned long > & offsets )
+{
+
+  /** The number of points that can be evaluated concurrently. */
+  unsigned long numberOfEvaluators = std::min(
+    static_cast< unsigned long >( m_NumberOfThreads ),
+    static_cast< unsigned long >( m_CostFunctionClones.size() + 1 ) );
+  if( m_PruningCostFunction.IsNotNull() )
+  {
+    numberOfEvaluators = std::min( numberOfEvaluators,
+      static_cast< unsigned long >( m_PruningCostFunctionClones.size() + 1 ) );
+  }
+
+  /** Evaluate in batches of a fixed size, to report the progress now and
+   * then, and to update the pruning reference. The size does not depend on
+   * the number of threads, so neither do the pruned points. */
+  const unsigned long batchSize = 64;
+  for( unsigned long begin = 0; begin < offsets.size(); begin += batchSize )
+  {
+    const std::vector< unsigned long > batch( offsets.begin() + begin,
+      offsets.begin() + std::min( begin + batchSize, static_cast< unsigned long >( offsets.size() ) ) );
+    const unsigned long numberOfPoints = batch.size();
+
+    m_BatchValues.resize( numberOfPoints );
+    m_BatchPruningValues.resize( numberOfPoints );
+    m_BatchStatus.resize( numberOfPoints );
+    m_BatchErrors.resize( numberOfPoints );
+    m_BatchIndices.resize( numberOfPoints );
+    m_BatchPositions.resize( numberOfPoints );
+
+    MultiThreaderParameterType parameters;
+    parameters.st_Optimizer = this;
+    parameters.st_Offsets   = &batch;
+    m_NextPoint             = 0;
+
+    const ThreadIdType numberOfThreads = static_cast< ThreadIdType >(
+      std::min( numberOfEvaluators, numberOfPoints ) );
+    if( numberOfThreads > 1 )
+    {
+      WorkerThreadPool::GetInstance()->Execute(
+        EvaluatePointsThreaderCallback, &parameters, numberOfThreads );
+    }
+    else
+    {
+      for( unsigned long m = 0; m < numberOfPoints; m++ )
+      {
+        this->EvaluatePoint( batch, m, 0 );
+      }
+    }
+
+    /** Process the results in the order of the grid. */
+    for( unsigned long m = 0; m < numberOfPoints; m++ )
+    {
+      if( m_BatchStatus[ m ] == PointFailed )
+      {
+        // An exception has occurred.
+        // Terminate immediately.
+        m_StopCondition = MetricError;
+        StopOptimization();
+
+        // Pass exception to caller
+        throw m_BatchErrors[ m ];
+      }
+      if( m_PruningCostFunction.IsNotNull()
+        && this->IsBetter( m_BatchPruningValues[ m ], m_BestPruningValue ) )
+      {
+        m_BestPruningValue = m_BatchPruningValues[ m ];
+      }
+      if( m_BatchStatus[ m ] == PointPruned )
+      {
+        m_NumberOfPrunedPoints++;
+        continue;
+      }
+
+      m_Value                     = m_BatchValues[ m ];
+      m_CurrentIndexInSearchSpace = m_BatchIndices[ m ];
+      m_CurrentPointInSearchSpace = this->IndexToPoint( m_CurrentIndexInSearchSpace );
+      this->SetCurrentPosition( m_BatchPositions[ m ] );
+      m_EvaluatedPoints.push_back( std::make_pair(
+        m_Maximize ? -m_Value : m_Value, batch[ m ] ) );
+
+      /** Check if the value is a minimum or maximum */
+      if( this->IsBetter( m_Value, m_BestValue ) )
+      {
+        m_BestValue              = m_Value;
+        m_BestPointInSearchSpace = m_CurrentPointInSearchSpace;
+        m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
+      }
+
+      this->InvokeEvent( IterationEvent() );
+
+      m_CurrentIteration++;
+
+      if( m_Stop )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+
+}   //end function EvaluatePoints
+
+
+/**
+ * ************************** EvaluatePoint ***********************
+ */
+void
+FullSearchOptimizer
+::EvaluatePoint( const std::vector< unsigned long > & offsets,
+  unsigned long m, ThreadIdType evaluator )
+{
+  /** The index and position of the point. */
+  this->OffsetToIndex( offsets[ m ], m_BatchIndices[ m ] );
+  this->ComputePosition( m_BatchIndices[ m ], m_BatchPositions[ m ] );
+  const ParametersType & position = m_BatchPositions[ m ];
+
+  /** The cost function (clone) of this evaluator. */
+  CostFunctionType * costFunction = evaluator == 0
+    ? m_CostFunction.GetPointer() : m_CostFunctionClones[ evaluator - 1 ].GetPointer();
+
+  try
+  {
+    /** Prune the point if it is clearly worse than the best point of the
+     * previous batches. The best pruning value is only updated between
+     * batches, so a point is never pruned against a point after it. */
+    if( m_PruningCostFunction.IsNotNull() )
+    {
+      CostFunctionType * pruningCostFunction = evaluator == 0
+        ? m_PruningCostFunction.GetPointer()
+        : m_PruningCostFunctionClones[ evaluator - 1 ].GetPointer();
+      const double pruningValue = pruningCostFunction->GetValue( position );
+      m_BatchPruningValues[ m ] = pruningValue;
+
+      const bool pruned = m_Maximize
+        ? ( pruningValue < m_BestPruningValue - m_PruningMargin )
+        : ( pruningValue > m_BestPruningValue + m_PruningMargin );
+      if( pruned )
+      {
+        m_BatchStatus[ m ] = PointPruned;
+        return;
+      }
+    }
+
+    m_BatchValues[ m ] = costFunction->GetValue( position );
+    m_BatchStatus[ m ] = PointEvaluated;
+  }
+  catch( ExceptionObject & err )
+  {
+    m_BatchStatus[ m ] = PointFailed;
+    m_BatchErrors[ m ] = err;
+  }
+
+}   // end function EvaluatePoint
+
+
+/**
+ * **************** EvaluatePointsThreaderCallback ****************
+ */
+ITK_THREAD_RETURN_TYPE
+FullSearchOptimizer
+::EvaluatePointsThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ThreadIdType threadID = infoStruct->ThreadID;
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+  Self * optimizer = temp->st_Optimizer;
+
+  /** Each thread takes the next point to be evaluated. The thread id
+   * selects the cost function (clone) to be used. */
+  const unsigned long numberOfPoints = temp->st_Offsets->size();
+  while( true )
+  {
+    optimizer->m_Mutex.Lock();
+    const unsigned long m = optimizer->m_NextPoint++;
+    optimizer->m_Mutex.Unlock();
+    if( m >= numberOfPoints )
+    {
+      break;
+    }
+    optimizer->EvaluatePoint( *temp->st_Offsets, m, threadID );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end function EvaluatePointsThreaderCallback
+
+
+/**
+ * ************************** OffsetToIndex ***********************
+ */
+void
+FullSearchOptimizer
+::OffsetToIndex( unsigned long offset, SearchSpaceIndexType & index ) const
+{
+  /** Dimension 0 runs fastest, like in UpdateCurrentPosition. */
+  index.SetSize( m_NumberOfSearchSpaceDimensions );
+  for( unsigned int ssdim = 0; ssdim < m_NumberOfSearchSpaceDimensions; ssdim++ )
+  {
+    index[ ssdim ] = static_cast< IndexValueType >( offset % m_SearchSpaceSize[ ssdim ] );
+    offset        /= m_SearchSpaceSize[ ssdim ];
+  }
+
+}   // end function OffsetToIndex
+
+
+/**
+ * ************************ ComputePosition ***********************
+ */
+void
+FullSearchOptimizer
+::ComputePosition( const SearchSpaceIndexType & index,
+  ParametersType & position ) const
+{
+  position = this->GetInitialPosition();
+
+  /** Initialise the iterator. */
+  SearchSpaceIteratorType it( m_SearchSpace->Begin() );
+
+  /** point = min + step*index */
+  for( unsigned int ssdim = 0; ssdim < m_NumberOfSearchSpaceDimensions; ssdim++ )
+  {
+    const RangeType & range = it.Value();
+    position[ it.Index() ] = range[ 0 ]
+      + static_cast< double >( range[ 2 ] * index[ ssdim ] );
+    it++;
+  }
+
+}   // end function ComputePosition
+
+
 /**
  * ************************** Stop optimization ******************
  */
@@ -24,6 +24,11 @@
 #include "itkImage.h"
 #include "itkArray.h"
 #include "itkFixedArray.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+
+#include <utility>
+#include <vector>
 
 namespace itk
 {
@@ -35,6 +40,33 @@ namespace itk
  * Optimizer that scans a subspace of the parameter space
  * and searches for the best parameters.
  *
+ * The grid points can be evaluated in parallel, by setting NumberOfThreads
+ * larger than 1 and providing independent copies of the cost function (and
+ * of the pruning cost function) with SetCostFunctionClones() (and
+ * SetPruningCostFunctionClones()). Each copy should have its own state, so
+ * that no two threads evaluate the same object. The points are then
+ * evaluated in batches, and the IterationEvent is invoked for each point in
+ * the order of the grid, from the thread that started the optimization.
+ * The result does not depend on the number of threads.
+ *
+ * Two options reduce the number of evaluated points:
+ * \li Coarse-to-fine search: with a CoarseGridStride s > 1, first only the
+ *   points whose indices are multiples of s are evaluated. Then, with the
+ *   stride halved at each level, the neighbourhoods of the
+ *   NumberOfRefinedPoints best points found so far are searched, until
+ *   the stride is 1.
+ * \li Pruning: if a PruningCostFunction is set, typically the same metric
+ *   computed on a small subset of the samples, it is evaluated first at each
+ *   point. The cost function is only evaluated if the pruning value is not
+ *   worse than the best pruning value of the previous batches of points by
+ *   more than the PruningMargin. The points of the first batch are never
+ *   pruned. Since the batches have a fixed size, the pruned points only
+ *   depend on the search space and the cost functions.
+ *
+ * With either option, or multiple threads, the points are evaluated in batches, in the order of
+ * the grid within each level. Points that are not evaluated get no
+ * IterationEvent.
+ *
  * \todo This optimizer has similar functionality as the recently added
  * itkExhaustiveOptimizer. See if we can replace it by that optimizer,
  * or inherit from it.
@@ -71,6 +103,8 @@ public:
   typedef Superclass::CostFunctionPointer CostFunctionPointer;
   typedef Superclass::MeasureType         MeasureType;
 
+  typedef std::vector< CostFunctionPointer > CostFunctionContainerType;
+
   typedef ParametersType::ValueType               ParameterValueType;     // = double
   typedef ParameterValueType                      RangeValueType;
   typedef FixedArray< RangeValueType, 3 >         RangeType;
@@ -191,6 +225,60 @@ public:
   /** Get Stop condition. */
   itkGetConstMacro( StopCondition, StopConditionType );
 
+  /** Set/Get the number of threads used to evaluate the grid points.
+   * Default: 1, the points are evaluated one after another. */
+  itkSetClampMacro( NumberOfThreads, ThreadIdType, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  /** Set/Get independent copies of the cost function, which may be evaluated
+   * concurrently with the cost function and with each other. With n clones,
+   * at most n + 1 points are evaluated at the same time. Default: none. */
+  virtual void SetCostFunctionClones( const CostFunctionContainerType & clones )
+  {
+    this->m_CostFunctionClones = clones;
+    this->Modified();
+  }
+
+
+  const CostFunctionContainerType & GetCostFunctionClones( void ) const
+  { return this->m_CostFunctionClones; }
+
+  /** Set/Get the stride of the coarsest grid of the coarse-to-fine search.
+   * Default: 1, which searches the full grid. */
+  itkSetClampMacro( CoarseGridStride, unsigned int, 1, NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( CoarseGridStride, unsigned int );
+
+  /** Set/Get the number of best points of which the neighbourhood is searched
+   * at the next level of the coarse-to-fine search. Default: 1. */
+  itkSetClampMacro( NumberOfRefinedPoints, unsigned int, 1, NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( NumberOfRefinedPoints, unsigned int );
+
+  /** Set/Get a cheap approximation of the cost function, used to prune
+   * points before the cost function is evaluated. Default: NULL, no pruning. */
+  itkSetObjectMacro( PruningCostFunction, CostFunctionType );
+  itkGetObjectMacro( PruningCostFunction, CostFunctionType );
+
+  /** Set/Get independent copies of the pruning cost function, one for each
+   * cost function clone. Default: none. */
+  virtual void SetPruningCostFunctionClones( const CostFunctionContainerType & clones )
+  {
+    this->m_PruningCostFunctionClones = clones;
+    this->Modified();
+  }
+
+
+  const CostFunctionContainerType & GetPruningCostFunctionClones( void ) const
+  { return this->m_PruningCostFunctionClones; }
+
+  /** Set/Get the margin by which the pruning value of a point may be worse
+   * than the best pruning value of the previous batches, before the point
+   * is pruned. Default: 0. */
+  itkSetClampMacro( PruningMargin, double, 0.0, NumericTraits< double >::max() );
+  itkGetConstMacro( PruningMargin, double );
+
+  /** Get the number of points that were pruned in the last optimization. */
+  itkGetConstMacro( NumberOfPrunedPoints, unsigned long );
+
 protected:
 
   FullSearchOptimizer();
@@ -215,6 +303,14 @@ protected:
   unsigned long m_LastSearchSpaceChanges;
   virtual void ProcessSearchSpaceChanges( void );
 
+  /** Search the grid in batches of points, evaluated in parallel, with
+   * the coarse-to-fine search and the pruning. */
+  virtual void ResumeBatchOptimization( void );
+
+  /** Evaluate the points with the given grid offsets, and invoke the
+   * iteration events for them. Returns false if the optimization was stopped. */
+  virtual bool EvaluatePoints( const std::vector< unsigned long > & offsets );
+
 private:
 
   FullSearchOptimizer( const Self & ); // purposely not implemented
@@ -222,6 +318,64 @@ private:
 
   unsigned long m_CurrentIteration;
 
+  /** The status of an evaluated point. */
+  enum PointStatusType {
+    PointEvaluated,
+    PointPruned,
+    PointFailed
+  };
+
+  /** The struct passed to the threads. */
+  struct MultiThreaderParameterType
+  {
+    Self *                               st_Optimizer;
+    const std::vector< unsigned long > * st_Offsets;
+  };
+
+  /** Convert a grid offset (the iteration number in the full search) to
+   * an index, and an index to a position. Thread safe, after ProcessSearchSpaceChanges. */
+  void OffsetToIndex( unsigned long offset, SearchSpaceIndexType & index ) const;
+
+  void ComputePosition( const SearchSpaceIndexType & index,
+    ParametersType & position ) const;
+
+  /** Evaluate point m of the current batch with the cost function (evaluator
+   * 0) or one of its clones. A failure is recorded, not thrown. */
+  void EvaluatePoint( const std::vector< unsigned long > & offsets,
+    unsigned long m, ThreadIdType evaluator );
+
+  /** Is a value better than another? */
+  bool IsBetter( double value, double otherValue ) const
+  { return ( value < otherValue ) ^ this->m_Maximize; }
+
+  /** The callback executed by the threads. */
+  static ITK_THREAD_RETURN_TYPE EvaluatePointsThreaderCallback( void * arg );
+
+  /** Settings. */
+  ThreadIdType              m_NumberOfThreads;
+  CostFunctionContainerType m_CostFunctionClones;
+  unsigned int              m_CoarseGridStride;
+  unsigned int              m_NumberOfRefinedPoints;
+  CostFunctionPointer       m_PruningCostFunction;
+  CostFunctionContainerType m_PruningCostFunctionClones;
+  double                    m_PruningMargin;
+
+  /** The state of the batch search. The evaluated points are stored as
+   * ( value, offset ), with the value negated when maximizing, so that
+   * the best points come first when sorted. */
+  std::vector< bool >                                m_Visited;
+  std::vector< std::pair< double, unsigned long > > m_EvaluatedPoints;
+  std::vector< double >                              m_BatchValues;
+  std::vector< double >                              m_BatchPruningValues;
+  std::vector< PointStatusType >                     m_BatchStatus;
+  std::vector< ExceptionObject >                     m_BatchErrors;
+  std::vector< SearchSpaceIndexType >                m_BatchIndices;
+  std::vector< ParametersType >                      m_BatchPositions;
+  unsigned long                                      m_NextPoint;
+  double                                             m_BestPruningValue;
+  unsigned long                                      m_NumberOfPrunedPoints;
+  SimpleMutexLock                                    m_Mutex;
+
 };
 
 } // end namespace itk
@@ -80,6 +80,16 @@ namespace elastix
  *    In general it is wise to do so.\n
  *    example: <tt>(StopIfWolfeNotSatisfied "true" "false")</tt> \n
  *    Default value: "true".\n
+ * \parameter WarmStart: Whether to start the resolution with the curvature pairs
+ *    ( s, y ) of the last iterations of the previous resolution, or of the previous
+ *    elastix level, instead of with an empty memory. The first search direction is
+ *    then a quasi-Newton direction, scaled by the curvature learned before, rather
+ *    than the normalised gradient. When the B-spline grid is upsampled, the pairs
+ *    are upsampled with it, and y is rescaled so that the curvature s'y along the
+ *    step is preserved. Pairs that cannot be mapped to the parameters of the current
+ *    transform are dropped. See also the OptimizerBase.\n
+ *    example: <tt>(WarmStart "false" "true" "true")</tt> \n
+ *    Default value: "false".\n
  *
  * \ingroup Optimizers
  */
@@ -130,10 +140,11 @@ public:
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
   /** Extra typedefs */
-  typedef itk::MoreThuenteLineSearchOptimizer    LineOptimizerType;
-  typedef LineOptimizerType::Pointer             LineOptimizerPointer;
-  typedef itk::ReceptorMemberCommand< Self >     EventPassThroughType;
-  typedef typename EventPassThroughType::Pointer EventPassThroughPointer;
+  typedef itk::MoreThuenteLineSearchOptimizer      LineOptimizerType;
+  typedef LineOptimizerType::Pointer               LineOptimizerPointer;
+  typedef itk::ReceptorMemberCommand< Self >       EventPassThroughType;
+  typedef typename EventPassThroughType::Pointer   EventPassThroughPointer;
+  typedef typename Superclass2::WarmStartStateType WarmStartStateType;
 
   /** Check if any scales are set, and set the UseScales flag on or off;
    * after that call the superclass' implementation */
@@ -190,6 +201,14 @@ private:
 
   void InvokeIterationEvent( const itk::EventObject & event );
 
+  /** Set the curvature pairs of the warm-start state as initial curvature
+   * pairs, mapped to the parameters of the current resolution.
+   */
+  void SetInitialCurvaturePairsFromWarmStartState( void );
+
+  /** Store the current curvature pairs in the warm-start state. */
+  void StoreCurvaturePairsInWarmStartState( void );
+
   EventPassThroughPointer m_EventPasser;
   double                  m_SearchDirectionMagnitude;
   bool                    m_StartLineSearch;
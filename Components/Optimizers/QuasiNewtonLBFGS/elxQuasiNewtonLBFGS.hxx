@@ -20,6 +20,7 @@
 #define __elxQuasiNewtonLBFGS_hxx
 
 #include "elxQuasiNewtonLBFGS.h"
+#include "itkParameterVectorOperations.h"
 #include <iomanip>
 #include <string>
 #include "vnl/vnl_math.h"
@@ -103,6 +104,12 @@ QuasiNewtonLBFGS< TElastix >::StartOptimization( void )
     }
   }
 
+  /** Start from the curvature pairs of the previous resolution, if requested. */
+  if( this->GetWarmStart() )
+  {
+    this->SetInitialCurvaturePairsFromWarmStartState();
+  }
+
   this->Superclass1::StartOptimization();
 
 }   //end StartOptimization
@@ -456,9 +463,112 @@ QuasiNewtonLBFGS< TElastix >
   /** Print the stopping condition */
   elxout << "Stopping condition: " << stopcondition << "." << std::endl;
 
+  /** Leave the curvature pairs for the next resolution, if requested. */
+  if( this->GetWarmStart() )
+  {
+    this->StoreCurvaturePairsInWarmStartState();
+  }
+
 }   // end AfterEachResolution
 
 
+/**
+ * ********* SetInitialCurvaturePairsFromWarmStartState ************
+ */
+
+template< class TElastix >
+void
+QuasiNewtonLBFGS< TElastix >
+::SetInitialCurvaturePairsFromWarmStartState( void )
+{
+  typedef itk::ParameterVectorOperations VectorOperations;
+
+  typedef typename ElastixType::TransformBaseType TransformBaseType;
+  const WarmStartStateType * state     = this->GetWarmStartState();
+  const TransformBaseType *  transform = this->GetElastix()->GetElxTransformBase();
+
+  /** The pairs are only valid for the same transform. */
+  SType s;
+  YType y;
+  if( state->GetNumberOfCurvaturePairs() > 0
+    && state->GetParameterSpace() == transform->elxGetClassName() )
+  {
+    for( unsigned int i = 0; i < state->GetNumberOfCurvaturePairs(); ++i )
+    {
+      const ParametersType & previousS = state->GetCurvatureSteps()[ i ];
+      const DerivativeType & previousY = state->GetCurvatureGradientDifferences()[ i ];
+      ParametersType         currentS;
+      DerivativeType         currentY;
+      if( !transform->MapVectorFromPreviousResolution( previousS, currentS )
+        || !transform->MapVectorFromPreviousResolution( previousY, currentY ) )
+      {
+        continue;
+      }
+
+      /** The mapped y is only known up to a scale factor: the mapping of the
+       * gradient is the transpose of the mapping of the parameters. Choose
+       * it such that the curvature s'y along the step is preserved.
+       */
+      const double previousSY = VectorOperations::Dot( previousS, previousY );
+      const double currentSY  = VectorOperations::Dot( currentS, currentY );
+      if( !( previousSY > 0.0 ) || !( currentSY > 0.0 ) )
+      {
+        continue;
+      }
+      VectorOperations::Scale( previousSY / currentSY, currentY );
+
+      /** The optimizer works on scaled parameters. */
+      if( this->GetUseScales() )
+      {
+        VectorOperations::Multiply( currentS, this->GetScales(), currentS );
+        VectorOperations::Divide( currentY, this->GetScales(), currentY );
+      }
+
+      s.push_back( currentS );
+      y.push_back( currentY );
+    }
+
+    elxout << "Warm start: using " << s.size() << " of "
+           << state->GetNumberOfCurvaturePairs()
+           << " curvature pairs of the previous resolution." << std::endl;
+  }
+
+  this->SetInitialCurvaturePairs( s, y );
+
+}   // end SetInitialCurvaturePairsFromWarmStartState
+
+
+/**
+ * ************ StoreCurvaturePairsInWarmStartState ***************
+ */
+
+template< class TElastix >
+void
+QuasiNewtonLBFGS< TElastix >
+::StoreCurvaturePairsInWarmStartState( void )
+{
+  typedef itk::ParameterVectorOperations VectorOperations;
+
+  SType s;
+  YType y;
+  this->GetCurvaturePairs( s, y );
+
+  /** Store them unscaled, since the scales may differ per resolution. */
+  if( this->GetUseScales() )
+  {
+    for( unsigned int i = 0; i < s.size(); ++i )
+    {
+      VectorOperations::Divide( s[ i ], this->GetScales(), s[ i ] );
+      VectorOperations::Multiply( y[ i ], this->GetScales(), y[ i ] );
+    }
+  }
+
+  this->GetWarmStartState()->SetCurvaturePairs( s, y,
+    this->GetElastix()->GetElxTransformBase()->elxGetClassName() );
+
+}   // end StoreCurvaturePairsInWarmStartState
+
+
 /**
  * ******************* AfterRegistration ************************
  */
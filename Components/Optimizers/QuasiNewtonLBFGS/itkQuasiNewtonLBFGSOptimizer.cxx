@@ -21,6 +21,7 @@
 
 #include "itkQuasiNewtonLBFGSOptimizer.h"
 #include "itkArray.h"
+#include "itkParameterVectorOperations.h"
 #include "vnl/vnl_math.h"
 
 namespace itk
@@ -43,6 +44,7 @@ QuasiNewtonLBFGSOptimizer::QuasiNewtonLBFGSOptimizer()
   this->m_Point             = 0;
   this->m_PreviousPoint     = 0;
   this->m_Bound             = 0;
+  this->m_NewestPoint       = 0;
 
   this->m_MaximumNumberOfIterations  = 100;
   this->m_GradientMagnitudeTolerance = 1e-5;
@@ -65,6 +67,7 @@ QuasiNewtonLBFGSOptimizer::StartOptimization()
   this->m_Point             = 0;
   this->m_PreviousPoint     = 0;
   this->m_Bound             = 0;
+  this->m_NewestPoint       = 0;
   this->m_Stop              = false;
   this->m_StopCondition     = Unknown;
   this->m_CurrentIteration  = 0;
@@ -85,6 +88,9 @@ QuasiNewtonLBFGSOptimizer::StartOptimization()
   this->m_S.resize( this->GetMemory() );
   this->m_Y.resize( this->GetMemory() );
 
+  /** Start from the initial curvature pairs, if any. */
+  this->UseInitialCurvaturePairs( numberOfParameters );
+
   /** Initialize the scaledCostFunction with the currently set scales */
   this->InitializeScales();
 
@@ -174,8 +180,10 @@ QuasiNewtonLBFGSOptimizer::ResumeOptimization()
     {
       ParametersType s;
       DerivativeType y;
-      s = this->GetCurrentStepLength() * searchDir;
-      y = this->GetCurrentGradient() - previousGradient;
+      ParameterVectorOperations::ScaledCopy(
+        this->GetCurrentStepLength(), searchDir, s );
+      ParameterVectorOperations::LinearCombination(
+        1.0, this->GetCurrentGradient(), -1.0, previousGradient, y );
       this->StoreCurrentPoint( s, y );
       s.clear();
       y.clear();
@@ -246,7 +254,7 @@ QuasiNewtonLBFGSOptimizer::ComputeDiagonalMatrix( DiagonalMatrixType & diag_H0 )
   {
     const DerivativeType & y  = this->m_Y[ this->m_PreviousPoint ];
     const double           ys = 1.0 / this->m_Rho[ this->m_PreviousPoint ];
-    const double           yy = y.squared_magnitude();
+    const double           yy = ParameterVectorOperations::SquaredNorm( y );
     fill_value = ys / yy;
     if( fill_value <= 0. )
     {
@@ -276,11 +284,14 @@ QuasiNewtonLBFGSOptimizer::ComputeSearchDirection(
   typedef Array< double > AlphaType;
   AlphaType alpha( this->GetMemory() );
 
-  const unsigned int numberOfParameters = gradient.GetSize();
   DiagonalMatrixType H0;
   this->ComputeDiagonalMatrix( H0 );
 
-  searchDir = -gradient;
+  /** The vector operations are done by ParameterVectorOperations, which
+   * multi-threads them for large numbers of parameters.
+   */
+  typedef ParameterVectorOperations VectorOperations;
+  VectorOperations::ScaledCopy( -1.0, gradient, searchDir );
 
   int cp = static_cast< int >( this->m_Point );
 
@@ -291,31 +302,19 @@ QuasiNewtonLBFGSOptimizer::ComputeSearchDirection(
     {
       cp = this->GetMemory() - 1;
     }
-    const double sq = inner_product( this->m_S[ cp ], searchDir );
+    const double sq = VectorOperations::Dot( this->m_S[ cp ], searchDir );
     alpha[ cp ] = this->m_Rho[ cp ] * sq;
-    const double &         alpha_cp = alpha[ cp ];
-    const DerivativeType & y        = this->m_Y[ cp ];
-    for( unsigned int j = 0; j < numberOfParameters; ++j )
-    {
-      searchDir[ j ] -= alpha_cp * y[ j ];
-    }
+    VectorOperations::Axpy( -alpha[ cp ], this->m_Y[ cp ], searchDir );
   }
 
-  for( unsigned int j = 0; j < numberOfParameters; ++j )
-  {
-    searchDir[ j ] *= H0[ j ];
-  }
+  VectorOperations::Multiply( searchDir, H0, searchDir );
 
   for( unsigned int i = 0; i < this->m_Bound; ++i )
   {
-    const double           yr             = inner_product( this->m_Y[ cp ], searchDir );
-    const double           beta           = this->m_Rho[ cp ] * yr;
-    const double           alpha_min_beta = alpha[ cp ] - beta;
-    const ParametersType & s              = this->m_S[ cp ];
-    for( unsigned int j = 0; j < numberOfParameters; ++j )
-    {
-      searchDir[ j ] += alpha_min_beta * s[ j ];
-    }
+    const double yr             = VectorOperations::Dot( this->m_Y[ cp ], searchDir );
+    const double beta           = this->m_Rho[ cp ] * yr;
+    const double alpha_min_beta = alpha[ cp ] - beta;
+    VectorOperations::Axpy( alpha_min_beta, this->m_S[ cp ], searchDir );
     ++cp;
     if( static_cast< unsigned int >( cp ) == this->GetMemory() )
     {
@@ -326,7 +325,7 @@ QuasiNewtonLBFGSOptimizer::ComputeSearchDirection(
   /** Normalize if no information about previous steps is available yet */
   if( this->m_Bound == 0 )
   {
-    searchDir /= gradient.magnitude();
+    VectorOperations::Scale( 1.0 / VectorOperations::Norm( gradient ), searchDir );
   }
 
 }   // end ComputeSearchDirection
@@ -409,11 +408,107 @@ QuasiNewtonLBFGSOptimizer::StoreCurrentPoint(
 
   this->m_S[ this->m_Point ]   = step;                                  // s
   this->m_Y[ this->m_Point ]   = grad_dif;                              // y
-  this->m_Rho[ this->m_Point ] = 1.0 / inner_product( step, grad_dif ); // 1/ys
+  this->m_Rho[ this->m_Point ] = 1.0
+    / ParameterVectorOperations::Dot( step, grad_dif ); // 1/ys
+  this->m_NewestPoint          = this->m_Point;
 
 }   // end StoreCurrentPoint
 
 
+/**
+ * ********************* SetInitialCurvaturePairs ************************
+ */
+
+void
+QuasiNewtonLBFGSOptimizer::SetInitialCurvaturePairs(
+  const SType & s, const YType & y )
+{
+  if( s.size() != y.size() )
+  {
+    itkExceptionMacro( << "The numbers of s and y vectors differ: "
+                       << s.size() << " and " << y.size() << "." );
+  }
+  this->m_InitialS = s;
+  this->m_InitialY = y;
+
+}   // end SetInitialCurvaturePairs
+
+
+/**
+ * ********************* GetCurvaturePairs ************************
+ */
+
+void
+QuasiNewtonLBFGSOptimizer::GetCurvaturePairs( SType & s, YType & y ) const
+{
+  s.clear();
+  y.clear();
+
+  /** m_S and m_Y are circular buffers; the oldest of the m_Bound valid
+   * entries follows the newest one.
+   */
+  const unsigned int memory = static_cast< unsigned int >( this->m_S.size() );
+  if( memory == 0 || this->m_Bound == 0 )
+  {
+    return;
+  }
+  const unsigned int oldest = this->m_NewestPoint + 1 + memory - this->m_Bound;
+  for( unsigned int i = 0; i < this->m_Bound; ++i )
+  {
+    const unsigned int point = ( oldest + i ) % memory;
+    s.push_back( this->m_S[ point ] );
+    y.push_back( this->m_Y[ point ] );
+  }
+
+}   // end GetCurvaturePairs
+
+
+/**
+ * ********************* UseInitialCurvaturePairs ************************
+ */
+
+void
+QuasiNewtonLBFGSOptimizer::UseInitialCurvaturePairs(
+  const unsigned int numberOfParameters )
+{
+  /** Store the newest initial pairs that fit in the memory, oldest first,
+   * as if they were stored in the previous iterations.
+   */
+  const unsigned int numberOfPairs = static_cast< unsigned int >( this->m_InitialS.size() );
+  const unsigned int first         = numberOfPairs > this->GetMemory()
+    ? numberOfPairs - this->GetMemory() : 0;
+  for( unsigned int i = first; i < numberOfPairs; ++i )
+  {
+    const ParametersType & s = this->m_InitialS[ i ];
+    const DerivativeType & y = this->m_InitialY[ i ];
+    if( s.GetSize() != numberOfParameters || y.GetSize() != numberOfParameters )
+    {
+      continue;
+    }
+    const double ys = ParameterVectorOperations::Dot( s, y );
+    if( !( ys > 0.0 ) )
+    {
+      continue;
+    }
+
+    this->m_S[ this->m_Bound ]   = s;
+    this->m_Y[ this->m_Bound ]   = y;
+    this->m_Rho[ this->m_Bound ] = 1.0 / ys;
+    this->m_NewestPoint          = this->m_Bound;
+    this->m_PreviousPoint        = this->m_Bound;
+    this->m_Bound++;
+  }
+
+  /** The next pair is stored after the newest one. */
+  this->m_Point = this->m_Bound < this->GetMemory() ? this->m_Bound : 0;
+
+  /** The initial pairs are used once. */
+  this->m_InitialS.clear();
+  this->m_InitialY.clear();
+
+}   // end UseInitialCurvaturePairs
+
+
 /**
  * ********************* TestConvergence ************************
  */
@@ -441,8 +536,8 @@ QuasiNewtonLBFGSOptimizer::TestConvergence( bool firstLineSearchDone )
   }
 
   /** Check for convergence of gradient magnitude */
-  const double gnorm = this->GetCurrentGradient().magnitude();
-  const double xnorm = this->GetScaledCurrentPosition().magnitude();
+  const double gnorm = ParameterVectorOperations::Norm( this->GetCurrentGradient() );
+  const double xnorm = ParameterVectorOperations::Norm( this->GetScaledCurrentPosition() );
   if( gnorm / vnl_math_max( 1.0, xnorm ) <= this->GetGradientMagnitudeTolerance() )
   {
     this->m_StopCondition = GradientMagnitudeTolerance;
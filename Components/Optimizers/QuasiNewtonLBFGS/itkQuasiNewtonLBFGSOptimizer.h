@@ -129,6 +129,20 @@ public:
   itkSetClampMacro( Memory, unsigned int, 0, NumericTraits< unsigned int >::max() );
   itkGetConstMacro( Memory, unsigned int );
 
+  /** Warm start: set curvature pairs ( s, y ), ordered from old to new, that
+   * the next StartOptimization() uses as if they were stored in previous
+   * iterations. Only the newest pairs that fit in the memory are used, and
+   * pairs of the wrong size or with s'y <= 0 are skipped. The pairs are used
+   * once; pass empty containers to start without them.
+   */
+  virtual void SetInitialCurvaturePairs( const SType & s, const YType & y );
+
+  /** Get the curvature pairs ( s, y ) that are currently stored, ordered from
+   * old to new. After the optimization, these can be passed to
+   * SetInitialCurvaturePairs() of the next optimization.
+   */
+  virtual void GetCurvaturePairs( SType & s, YType & y ) const;
+
 protected:
 
   QuasiNewtonLBFGSOptimizer();
@@ -154,6 +168,11 @@ protected:
   unsigned int m_Point;
   unsigned int m_PreviousPoint;
   unsigned int m_Bound;
+  unsigned int m_NewestPoint;
+
+  /** The curvature pairs to start the next optimization with. */
+  SType m_InitialS;
+  YType m_InitialY;
 
   itkSetMacro( InLineSearch, bool );
 
@@ -190,6 +209,10 @@ protected:
     const ParametersType & step,
     const DerivativeType & grad_dif );
 
+  /** Store the initial curvature pairs in m_S, m_Y and m_Rho, and clear them.
+   * Called by StartOptimization(). */
+  virtual void UseInitialCurvaturePairs( const unsigned int numberOfParameters );
+
   /** Check if convergence has occured;
    * The firstLineSearchDone bool allows the implementation of TestConvergence to
    * decide to skip a few convergence checks when no line search has performed yet
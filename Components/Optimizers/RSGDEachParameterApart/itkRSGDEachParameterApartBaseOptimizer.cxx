@@ -22,6 +22,7 @@
 #include "itkRSGDEachParameterApartBaseOptimizer.h"
 #include "itkCommand.h"
 #include "itkEventObject.h"
+#include "itkParameterVectorOperations.h"
 #include "vnl/vnl_math.h"
 
 namespace itk
@@ -195,21 +196,10 @@ RSGDEachParameterApartBaseOptimizer
                        << "." );
   }
 
-  for( unsigned int i = 0; i < spaceDimension; i++ )
-  {
-    transformedGradient[ i ] = m_Gradient[ i ] / scales[ i ];
-    previousTransformedGradient[ i ]
-      = m_PreviousGradient[ i ] / scales[ i ];
-  }
-
-  double magnitudeSquare = 0;
-  for( unsigned int dim = 0; dim < spaceDimension; dim++ )
-  {
-    const double weighted = transformedGradient[ dim ];
-    magnitudeSquare += weighted * weighted;
-  }
+  ParameterVectorOperations::Divide( m_Gradient, scales, transformedGradient );
+  ParameterVectorOperations::Divide( m_PreviousGradient, scales, previousTransformedGradient );
 
-  m_GradientMagnitude = vcl_sqrt( magnitudeSquare );
+  m_GradientMagnitude = ParameterVectorOperations::Norm( transformedGradient );
 
   if( m_GradientMagnitude < m_GradientMagnitudeTolerance )
   {
@@ -262,12 +252,8 @@ RSGDEachParameterApartBaseOptimizer
     direction = -1.0;
   }
 
-  DerivativeType factor = DerivativeType( spaceDimension );
-
-  for( unsigned int i = 0; i < spaceDimension; i++ )
-  {
-    factor[ i ] = direction * m_CurrentStepLengths[ i ] / m_GradientMagnitude;
-  }
+  DerivativeType factor = m_CurrentStepLengths;
+  ParameterVectorOperations::Scale( direction / m_GradientMagnitude, factor );
 
   // This method StepAlongGradient() will
   // be overloaded in non-vector spaces
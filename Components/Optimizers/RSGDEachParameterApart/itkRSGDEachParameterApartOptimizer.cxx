@@ -22,6 +22,7 @@
 #include "itkRSGDEachParameterApartOptimizer.h"
 #include "itkCommand.h"
 #include "itkEventObject.h"
+#include "itkParameterVectorOperations.h"
 
 namespace itk
 {
@@ -44,11 +45,9 @@ RSGDEachParameterApartOptimizer
   ParametersType newPosition( spaceDimension );
   ParametersType currentPosition = this->GetCurrentPosition();
 
-  for( unsigned int j = 0; j < spaceDimension; j++ )
-  {
-    /** Each parameters has its own factor! */
-    newPosition[ j ] = currentPosition[ j ] + transformedGradient[ j ] * factor[ j ];
-  }
+  /** Each parameters has its own factor! */
+  ParameterVectorOperations::MultiplyAdd(
+    currentPosition, factor, transformedGradient, newPosition );
 
   itkDebugMacro( << "new position = " << newPosition );
 
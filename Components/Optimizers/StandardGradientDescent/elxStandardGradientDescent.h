@@ -59,6 +59,12 @@ namespace elastix
 *   SP_alpha can be defined for each resolution. \n
 *   example: <tt>(SP_alpha 0.602 0.602 0.602)</tt> \n
 *   The default/recommended value is 0.602.
+* \parameter UseAdaptiveStopping: Whether to stop a resolution before MaximumNumberOfIterations
+*   when the metric values of the last iterations show convergence. The window and thresholds
+*   of the test are set with AdaptiveStoppingWindowSize, AdaptiveStoppingTrendThreshold and
+*   AdaptiveStoppingRelativeTolerance. See the OptimizerBase. \n
+*   example: <tt>(UseAdaptiveStopping "true" "true" "true")</tt> \n
+*   The default value is false.
 *
 * \sa StandardGradientDescentOptimizer
 * \ingroup Optimizers
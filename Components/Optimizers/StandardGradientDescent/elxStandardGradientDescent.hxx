@@ -125,6 +125,13 @@ StandardGradientDescent< TElastix >
   xl::xout[ "iteration" ][ "3:StepSize" ] << this->GetLearningRate();
   xl::xout[ "iteration" ][ "4:||Gradient||" ] << this->GetGradient().magnitude();
 
+  /** Stop if the metric values show convergence */
+  if( this->TestAdaptiveStopping( this->GetValue() ) )
+  {
+    this->StopOptimization();
+    return;
+  }
+
   /** Select new spatial samples for the computation of the metric */
   if( this->GetNewSamplesEveryIteration() )
   {
@@ -163,6 +170,10 @@ StandardGradientDescent< TElastix >
       break;
 
   }
+  if( this->GetAdaptivelyStopped() )
+  {
+    stopcondition = this->GetAdaptiveStoppingCondition();
+  }
 
   /** Print the stopping condition */
   elxout << "Stopping condition: " << stopcondition << "." << std::endl;
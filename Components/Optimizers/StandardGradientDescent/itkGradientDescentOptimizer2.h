@@ -129,18 +129,14 @@ public:
   /** Get current search direction */
   itkGetConstReferenceMacro( SearchDirection, DerivativeType );
 
-  /** Set the number of threads. */
+  /** Set the number of threads used for the vector operations,
+   * see ParameterVectorOperations.
+   */
   void SetNumberOfThreads( ThreadIdType numberOfThreads )
   {
     this->m_Threader->SetNumberOfThreads( numberOfThreads );
   }
 
-
-  //itkGetConstReferenceMacro( NumberOfThreads, ThreadIdType );
-  itkSetMacro( UseMultiThread, bool );
-  itkSetMacro( UseOpenMP, bool );
-  itkSetMacro( UseEigen, bool );
-
 protected:
 
   GradientDescentOptimizer2();
@@ -169,23 +165,6 @@ private:
   GradientDescentOptimizer2( const Self & ); // purposely not implemented
   void operator=( const Self & );            // purposely not implemented
 
-  // multi-threaded AdvanceOneStep:
-  bool m_UseMultiThread;
-  struct MultiThreaderParameterType
-  {
-    ParametersType * t_NewPosition;
-    Self *           t_Optimizer;
-  };
-
-  bool m_UseOpenMP;
-  bool m_UseEigen;
-
-  /** The callback function. */
-  static ITK_THREAD_RETURN_TYPE AdvanceOneStepThreaderCallback( void * arg );
-
-  /** The threaded implementation of AdvanceOneStep(). */
-  inline void ThreadedAdvanceOneStep( ThreadIdType threadId, ParametersType & newPosition );
-
 };
 
 } // end namespace itk
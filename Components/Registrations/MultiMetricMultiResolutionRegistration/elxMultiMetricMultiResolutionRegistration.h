@@ -88,6 +88,15 @@ namespace elastix
  *    example: <tt>(Metric0Use "false" "true")</tt> \n
  *    example: <tt>(Metric1Use "true" "false")</tt> \n
  *    The default is "true".
+ * \parameter ConcurrentMetricEvaluation: Whether the metrics are evaluated concurrently,
+ *    each on its own share of the threads, or one after another with all threads. \n
+ *    Metrics that are not image metrics, such as the point set metrics, get one thread;
+ *    the other threads are divided equally over the image metrics. This is faster when
+ *    some metrics do not scale with the number of threads, for example a mutual
+ *    information metric combined with a bending energy penalty and a landmark metric.
+ *    The command line argument -mtcombo overrides this parameter.\n
+ *    example: <tt>(ConcurrentMetricEvaluation "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Registrations
  */
@@ -105,13 +105,16 @@ MultiMetricMultiResolutionRegistration< TElastix >
     xl::xout[ "iteration" ][ makestring3.str().c_str() ] << std::showpoint << std::fixed << std::setprecision( 1 );
   }
 
-  /** Temporary? Use the multi-threaded version or not. */
+  /** Evaluate the metrics concurrently or not. The command line argument
+   * -mtcombo overrides the parameter file.
+   */
+  bool concurrentMetricEvaluation = false;
+  this->m_Configuration->ReadParameter( concurrentMetricEvaluation,
+    "ConcurrentMetricEvaluation", 0, false );
   std::string tmp = this->m_Configuration->GetCommandLineArgument( "-mtcombo" );
-  if( tmp == "true" || tmp == "" )
-  {
-    this->GetCombinationMetric()->SetUseMultiThread( true );
-  }
-  else { this->GetCombinationMetric()->SetUseMultiThread( false ); }
+  if( tmp == "true" ) { concurrentMetricEvaluation = true; }
+  else if( tmp == "false" ) { concurrentMetricEvaluation = false; }
+  this->GetCombinationMetric()->SetUseMultiThread( concurrentMetricEvaluation );
 
 } // end BeforeRegistration()
 
@@ -20,6 +20,7 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkSingleValuedPointSetToPointSetMetric.h"
+#include "itkThreadRandomGenerator.h"
 
 namespace itk
 {
@@ -200,8 +201,13 @@ public:
   itkSetMacro( UseRelativeWeights, bool );
   itkGetMacro( UseRelativeWeights, bool );
 
-  /** \todo: Temporary, should think about interface. */
+  /** Set/Get whether GetValueAndDerivative() evaluates the sub metrics
+   * concurrently. The threads of this metric are then split over the sub
+   * metrics, see ComputeNumberOfThreadsPerMetric(), during the concurrent
+   * evaluation only. Default: false.
+   */
   itkSetMacro( UseMultiThread, bool );
+  itkGetConstMacro( UseMultiThread, bool );
 
   /** Select which metrics are used.
    * This is useful in case you want to compute a certain measure, but not
@@ -406,12 +412,6 @@ public:
   /** GetValueAndDerivatives threader callback function */
   static ITK_THREAD_RETURN_TYPE GetValueAndDerivativeComboThreaderCallback( void * arg );
 
-  /** CombineDerivatives threader callback function */
-  static ITK_THREAD_RETURN_TYPE CombineDerivativesThreaderCallback( void * arg );
-
-  /** Compute Derivatives Magnitude threader callback function */
-  static ITK_THREAD_RETURN_TYPE ComputeDerivativesMagnitudeThreaderCallback( void * arg );
-
 protected:
 
   CombinationImageToImageMetric();
@@ -450,21 +450,33 @@ private:
    */
   double GetFinalMetricWeight( unsigned int pos ) const;
 
+  /** Split the threads of this metric over the sub metrics, for the
+   * concurrent evaluation. Sub metrics that are not image metrics are not
+   * multi-threaded, and get one thread. The remaining threads are divided
+   * equally over the image metrics, but no image metric gets more threads
+   * than it was initialized with. The split does not depend on timings, so
+   * that the results are reproducible.
+   */
+  void ComputeNumberOfThreadsPerMetric( std::vector< ThreadIdType > & numberOfThreads ) const;
+
+  /** Compute the values and derivatives of the sub metrics concurrently. */
+  void ConcurrentGetValueAndDerivative( const ParametersType & parameters ) const;
+
+  /** Set the number of threads and the use of the thread pool of the image
+   * metrics back to the given values, after the concurrent evaluation.
+   */
+  void RestoreMetricThreads( const std::vector< ThreadIdType > & numberOfThreads,
+    const std::vector< bool > & useThreadPool ) const;
+
   /** For threading: store thread data. */
   struct MultiThreaderComboMetricsType
   {
     std::vector< SingleValuedCostFunctionPointer > st_MetricsIterator;
     typename std::vector< MeasureType >::iterator st_MetricValuesIterator;
     typename std::vector< DerivativeType >::iterator st_MetricDerivativesIterator;
-    std::vector< double > st_MetricComputationTime;
-    ParametersType *      st_Parameters;
-  };
-
-  struct MultiThreaderCombineDerivativeType
-  {
-    Self *                st_ThisComboMetric;
-    std::vector< double > st_DerivativesSumOfSquares;
-    DerivativeValueType * st_Derivative;
+    std::vector< double >                  st_MetricComputationTime;
+    ParametersType *                       st_Parameters;
+    ThreadRandomGenerator::GeneratorType * st_RandomGenerator;
   };
 
   bool m_UseMultiThread;
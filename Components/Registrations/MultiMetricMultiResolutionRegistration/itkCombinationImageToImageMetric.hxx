@@ -21,6 +21,10 @@
 #include "itkCombinationImageToImageMetric.h"
 #include "itkTimeProbe.h"
 #include "itkMath.h"
+#include "itkWorkerThreadPool.h"
+#include "itkParameterVectorOperations.h"
+
+#include <algorithm>
 
 /** Macros to reduce some copy-paste work.
  * These macros provide the implementation of
@@ -164,7 +168,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   this->m_UseRelativeWeights = false;
   this->ComputeGradientOff();
 
-  this->m_UseMultiThread = true;
+  this->m_UseMultiThread = false;
 
 } // end Constructor
 
@@ -617,6 +621,26 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     itkExceptionMacro( << "At least one metric should be set!" );
   }
 
+  /** Let the metrics that use a sample cache share the first one, so that
+   * quantities of a sample set that are used by several metrics are
+   * computed only once. This is done before the metrics are initialized,
+   * since Initialize() clears the cache.
+   */
+  ImageSampleCache * sampleCache = NULL;
+  for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
+  {
+    ImageMetricType * testPtr = dynamic_cast< ImageMetricType * >( this->GetMetric( i ) );
+    if( !testPtr || !testPtr->GetSampleCache() ) { continue; }
+    if( !sampleCache )
+    {
+      sampleCache = testPtr->GetSampleCache();
+    }
+    else
+    {
+      testPtr->SetSampleCache( sampleCache );
+    }
+  }
+
   /** Call Initialize for all metrics. */
   for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
   {
@@ -829,10 +853,6 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   MeasureType & value,
   DerivativeType & derivative ) const
 {
-  /** Declare timer and multi-threader. */
-  itk::TimeProbe timer;
-  typename ThreaderType::Pointer local_threader = ThreaderType::New();
-
   /** This function must be called before the multi-threaded code.
    * It calls all the non thread-safe stuff.
    */
@@ -857,28 +877,18 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   /** Initialize some threading related parameters. */
   this->InitializeThreadingParameters();
 
-  /** Decide whether or not to use multi-threading.
-   * If the global maximum number of threads is smaller than the number
-   * of metrics, then setting the number of threads to the number of
-   * threads will result in a bug: all metrics after the max will not be
-   * run. For now we decide to run this metric single-threadedly in that case.
-   *
-   * Actually we should sum the number of threads of each metric and check that
-   * it does not surpass the global maximum. But for now we don't.
+  /** Decide whether or not to evaluate the metrics concurrently. This needs
+   * a thread per metric, and is only useful when there are threads to split.
    */
-  bool useMultiThread = this->m_UseMultiThread;
-  if( MultiThreader::GetGlobalMaximumNumberOfThreads() < this->m_NumberOfMetrics )
-  {
-    useMultiThread = false;
-  }
-
-  // For now we disable multi-threading of the combo metric, since the MacMini build
-  // segfaults with it. Have to investigate this issue later
-  useMultiThread = false;
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  const bool         useMultiThread  = this->m_UseMultiThread
+    && this->m_NumberOfMetrics > 1
+    && numberOfThreads > 1;
 
   /** Compute all metric values and derivatives, single-threadedly. */
   if( !useMultiThread )
   {
+    itk::TimeProbe timer;
     for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
     {
       /** Compute ... */
@@ -892,68 +902,17 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
       this->m_MetricComputationTime[ i ] = timer.GetMean() * 1000.0;
     }
   }
-  /** Compute all metric values and derivatives, multi-threadedly. */
+  /** Compute all metric values and derivatives, concurrently. */
   else
   {
-    /** Setup struct with multi-threading information. */
-    MultiThreaderComboMetricsType * temp_c = new MultiThreaderComboMetricsType;
-    temp_c->st_MetricsIterator           = this->m_Metrics;
-    temp_c->st_MetricDerivativesIterator = this->m_MetricDerivatives.begin();
-    temp_c->st_MetricValuesIterator      = this->m_MetricValues.begin();
-    temp_c->st_MetricComputationTime.resize( this->m_NumberOfMetrics, 0 );
-    temp_c->st_Parameters = const_cast< ParametersType * >( &parameters );
-
-    /** GetValueAndDerivative */
-    local_threader->SetNumberOfThreads( this->m_NumberOfMetrics );
-    local_threader->SetSingleMethod( GetValueAndDerivativeComboThreaderCallback, temp_c );
-    local_threader->SingleMethodExecute();
-
-    /** Store computation time. */
-    for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
-    {
-      this->m_MetricComputationTime[ i ] = temp_c->st_MetricComputationTime[ i ];
-    }
-
-    delete temp_c;
+    this->ConcurrentGetValueAndDerivative( parameters );
   }
 
-  /** Compute the derivative magnitude, single-threadedly. */
-  // I get random segfaults on the Linux or Mac systems when this is enabled.
-  // For now disable multi-threading and force single-threaded:
-  //if( !this->m_UseMultiThread )
-  if( true )
-  {
-    for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
-    {
-      this->m_MetricDerivativesMagnitude[ i ] = this->m_MetricDerivatives[ i ].magnitude();
-    }
-  }
-  /** Compute the derivative magnitude, multi-threadedly. */
-  else
+  /** Compute the derivative magnitudes, multi-threadedly. */
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    /** Setup struct with multi-threading information. */
-    ThreadIdType                         numberOfThreads = this->GetNumberOfThreads();
-    MultiThreaderCombineDerivativeType * temp_m          = new MultiThreaderCombineDerivativeType;
-    temp_m->st_ThisComboMetric = const_cast< Self * >( this );
-    temp_m->st_DerivativesSumOfSquares.resize( numberOfThreads * this->m_NumberOfMetrics );
-
-    /** Compute derivatives magnitude multi-threadedly. */
-    local_threader->SetNumberOfThreads( numberOfThreads );
-    local_threader->SetSingleMethod( ComputeDerivativesMagnitudeThreaderCallback, temp_m );
-    local_threader->SingleMethodExecute();
-
-    /** Gather the results. */
-    for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
-    {
-      double mag = 0.0;
-      for( unsigned int j = 0; j < numberOfThreads; j++ )
-      {
-        mag += temp_m->st_DerivativesSumOfSquares[ i * numberOfThreads + j ];
-      }
-      this->m_MetricDerivativesMagnitude[ i ] = vcl_sqrt( mag );
-    }
-
-    delete temp_m;
+    this->m_MetricDerivativesMagnitude[ i ] = ParameterVectorOperations::Norm(
+      this->m_MetricDerivatives[ i ], numberOfThreads );
   }
 
   /** Combine the metric values, single-threadedly. */
@@ -967,50 +926,21 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     } // end if m_UseMetric[i]
   }   // end of combine metrics
 
-  /** Combine the metric derivatives, single-threadedly. */
-  // I get random segfaults on the linux or Mac systems when this is enabled.
-  // For now disable multi-threading and force single-threaded:
-  //if( !this->m_UseMultiThread )
-  if( true )
+  /** Combine the metric derivatives, multi-threadedly. */
+  if( derivative.GetSize() != this->GetNumberOfParameters() )
   {
-    /** The first derivative. */
-    if( this->m_UseMetric[ 0 ] )
-    {
-      double weight = this->GetFinalMetricWeight( 0 );
-      derivative = weight * this->m_MetricDerivatives[ 0 ];
-    }
-    else
-    {
-      derivative.Fill( 0 );
-    }
-
-    /** The remaining derivatives. */
-    for( unsigned int i = 1; i < this->m_NumberOfMetrics; i++ )
-    {
-      /** and combine. */
-      if( this->m_UseMetric[ i ] )
-      {
-        double weight = this->GetFinalMetricWeight( i );
-        derivative += weight * this->m_MetricDerivatives[ i ];
-      } // end if m_UseMetric[i]
-    }   // end of combine metrics
+    derivative.SetSize( this->GetNumberOfParameters() );
   }
-  /** Combine the derivatives, multi-threadedly. */
-  else
+  derivative.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    /** Setup struct with multi-threading information. */
-    ThreadIdType                         numberOfThreads = this->GetNumberOfThreads();
-    MultiThreaderCombineDerivativeType * temp_d          = new MultiThreaderCombineDerivativeType;
-    temp_d->st_ThisComboMetric = const_cast< Self * >( this );
-    temp_d->st_Derivative      = &derivative[ 0 ];
-
-    /** Combine derivatives */
-    local_threader->SetNumberOfThreads( numberOfThreads );
-    local_threader->SetSingleMethod( CombineDerivativesThreaderCallback, temp_d );
-    local_threader->SingleMethodExecute();
-
-    delete temp_d;
-  }
+    if( this->m_UseMetric[ i ] )
+    {
+      const double weight = this->GetFinalMetricWeight( i );
+      ParameterVectorOperations::Axpy( weight,
+        this->m_MetricDerivatives[ i ], derivative, numberOfThreads );
+    } // end if m_UseMetric[i]
+  }   // end of combine metrics
 
 } // end GetValueAndDerivative()
 
@@ -1030,14 +960,24 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   MultiThreaderComboMetricsType * temp
     = static_cast< MultiThreaderComboMetricsType * >( infoStruct->UserData );
 
-  itk::TimeProbe timer;
-  timer.Start();
-  temp->st_MetricsIterator[ threadID ]->GetValueAndDerivative(
-    *temp->st_Parameters,
-    temp->st_MetricValuesIterator[ threadID ],
-    temp->st_MetricDerivativesIterator[ threadID ] );
-  timer.Stop();
-  temp->st_MetricComputationTime[ threadID ] = timer.GetMean() * 1000.0;
+  /** Draw random numbers from the generator of the calling session. */
+  ThreadRandomGenerator::Scope randomGeneratorScope( temp->st_RandomGenerator );
+
+  /** Each thread evaluates every NumberOfThreads-th metric, starting at its
+   * own id, in case there are more metrics than threads.
+   */
+  const unsigned int numberOfMetrics = temp->st_MetricsIterator.size();
+  for( unsigned int i = threadID; i < numberOfMetrics; i += infoStruct->NumberOfThreads )
+  {
+    itk::TimeProbe timer;
+    timer.Start();
+    temp->st_MetricsIterator[ i ]->GetValueAndDerivative(
+      *temp->st_Parameters,
+      temp->st_MetricValuesIterator[ i ],
+      temp->st_MetricDerivativesIterator[ i ] );
+    timer.Stop();
+    temp->st_MetricComputationTime[ i ] = timer.GetMean() * 1000.0;
+  }
 
   return ITK_THREAD_RETURN_VALUE;
 
@@ -1045,109 +985,146 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
 
 
 /**
- *********** ComputeDerivativesMagnitudeThreaderCallback *************
+ * **************** ComputeNumberOfThreadsPerMetric *******
  */
 
 template< class TFixedImage, class TMovingImage >
-ITK_THREAD_RETURN_TYPE
+void
 CombinationImageToImageMetric< TFixedImage, TMovingImage >
-::ComputeDerivativesMagnitudeThreaderCallback( void * arg )
+::ComputeNumberOfThreadsPerMetric( std::vector< ThreadIdType > & numberOfThreads ) const
 {
-  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
-  ThreadIdType     threadId    = infoStruct->ThreadID;
-  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
-
-  MultiThreaderCombineDerivativeType * temp
-    = static_cast< MultiThreaderCombineDerivativeType * >( infoStruct->UserData );
-
-  /** Get references to member variables. */
-  const unsigned int numberOfParameters = temp->st_ThisComboMetric->GetNumberOfParameters();
-  const unsigned int numberOfMetrics    = temp->st_ThisComboMetric->GetNumberOfMetrics();
-
-  /** Determine compute range of this thread. */
-  const unsigned int subSize = static_cast< unsigned int >(
-    vcl_ceil( static_cast< double >( numberOfParameters ) / static_cast< double >( nrOfThreads ) ) );
-  unsigned int jmin = threadId * subSize;
-  unsigned int jmax = ( threadId + 1 ) * subSize;
-  jmax = ( jmax > numberOfParameters ) ? numberOfParameters : jmax;
-
-  /** Compute the sum of squares within compute range. */
-  double derivativeValue = 0.0;
-  for( unsigned int i = 0; i < numberOfMetrics; i++ )
+  /** Every metric runs on its own thread, so gets at least one. */
+  numberOfThreads.assign( this->m_NumberOfMetrics, 1 );
+
+  unsigned int numberOfImageMetrics = 0;
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    if( temp->st_ThisComboMetric->m_UseMetric[ i ] )
+    if( dynamic_cast< const ImageMetricType * >( this->GetMetric( i ) ) )
     {
-      const DerivativeType & derivative   = temp->st_ThisComboMetric->m_MetricDerivatives[ i ];
-      double                 sumOfSquares = 0.0;
-      for( unsigned int j = jmin; j < jmax; j++ )
-      {
-        derivativeValue = derivative[ j ];
-        sumOfSquares   += derivativeValue * derivativeValue;
-      }
-      temp->st_DerivativesSumOfSquares[ i * nrOfThreads + threadId ] = sumOfSquares;
+      ++numberOfImageMetrics;
     }
   }
+  if( numberOfImageMetrics == 0 ) { return; }
 
-  return ITK_THREAD_RETURN_VALUE;
+  /** Divide the threads that are left over the image metrics. */
+  const ThreadIdType totalNumberOfThreads = this->GetNumberOfThreads();
+  const ThreadIdType numberOfOtherThreads = this->m_NumberOfMetrics - numberOfImageMetrics;
+  ThreadIdType       numberOfImageThreads = numberOfImageMetrics;
+  if( totalNumberOfThreads > numberOfOtherThreads + numberOfImageMetrics )
+  {
+    numberOfImageThreads = totalNumberOfThreads - numberOfOtherThreads;
+  }
+  unsigned int imageMetric = 0;
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+  {
+    const ImageMetricType * testPtr = dynamic_cast< const ImageMetricType * >( this->GetMetric( i ) );
+    if( !testPtr ) { continue; }
+
+    /** The first image metrics get the remainder of the division. */
+    ThreadIdType threads = numberOfImageThreads / numberOfImageMetrics;
+    if( imageMetric < numberOfImageThreads % numberOfImageMetrics ) { ++threads; }
+    ++imageMetric;
+
+    /** The per-thread variables of a metric are allocated for the number
+     * of threads it was initialized with.
+     */
+    numberOfThreads[ i ] = std::max( static_cast< ThreadIdType >( 1 ),
+      std::min( threads, testPtr->GetNumberOfThreads() ) );
+  }
 
-} // end ComputeDerivativesMagnitudeThreaderCallback()
+} // end ComputeNumberOfThreadsPerMetric()
 
 
 /**
- *********** CombineDerivativesThreaderCallback *************
+ * **************** ConcurrentGetValueAndDerivative *******
  */
 
 template< class TFixedImage, class TMovingImage >
-ITK_THREAD_RETURN_TYPE
+void
 CombinationImageToImageMetric< TFixedImage, TMovingImage >
-::CombineDerivativesThreaderCallback( void * arg )
+::ConcurrentGetValueAndDerivative( const ParametersType & parameters ) const
 {
-  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
-  ThreadIdType     threadId    = infoStruct->ThreadID;
-  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
-
-  MultiThreaderCombineDerivativeType * temp
-    = static_cast< MultiThreaderCombineDerivativeType * >( infoStruct->UserData );
-
-  /** Get references to member variables. */
-  const unsigned int numberOfParameters = temp->st_ThisComboMetric->GetNumberOfParameters();
-  const unsigned int numberOfMetrics    = temp->st_ThisComboMetric->GetNumberOfMetrics();
-
-  /** Determine compute range of this thread. */
-  const unsigned int subSize = static_cast< unsigned int >(
-    vcl_ceil( static_cast< double >( numberOfParameters ) / static_cast< double >( nrOfThreads ) ) );
-  unsigned int jmin = threadId * subSize;
-  unsigned int jmax = ( threadId + 1 ) * subSize;
-  jmax = ( jmax > numberOfParameters ) ? numberOfParameters : jmax;
-
-  // First metric, assign
-  if( temp->st_ThisComboMetric->m_UseMetric[ 0 ] )
+  /** Give each image metric its share of the threads, for the duration of
+   * this evaluation only. The metrics are run by the worker threads of the
+   * pool, so the pool is busy during their evaluation; each metric spawns its
+   * own threads instead.
+   */
+  std::vector< ThreadIdType > numberOfThreadsPerMetric;
+  this->ComputeNumberOfThreadsPerMetric( numberOfThreadsPerMetric );
+
+  std::vector< ThreadIdType > savedNumberOfThreads( this->m_NumberOfMetrics, 0 );
+  std::vector< bool >         savedUseThreadPool( this->m_NumberOfMetrics, false );
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    double                 weight           = temp->st_ThisComboMetric->GetFinalMetricWeight( 0 );
-    const DerivativeType & metricDerivative = temp->st_ThisComboMetric->m_MetricDerivatives[ 0 ];
-    for( unsigned int j = jmin; j < jmax; j++ )
+    ImageMetricType * testPtr = dynamic_cast< ImageMetricType * >( this->GetMetric( i ) );
+    if( testPtr )
     {
-      temp->st_Derivative[ j ] = weight * metricDerivative[ j ];
+      savedNumberOfThreads[ i ] = testPtr->GetNumberOfThreads();
+      savedUseThreadPool[ i ]   = testPtr->GetUseThreadPool();
+      testPtr->SetNumberOfThreads( numberOfThreadsPerMetric[ i ] );
+      testPtr->SetUseThreadPool( false );
     }
   }
 
-  // Other metrics, add
-  for( unsigned int i = 1; i < numberOfMetrics; i++ )
+  /** Setup struct with multi-threading information. */
+  MultiThreaderComboMetricsType temp_c;
+  temp_c.st_MetricsIterator           = this->m_Metrics;
+  temp_c.st_MetricDerivativesIterator = this->m_MetricDerivatives.begin();
+  temp_c.st_MetricValuesIterator      = this->m_MetricValues.begin();
+  temp_c.st_MetricComputationTime.resize( this->m_NumberOfMetrics, 0 );
+  temp_c.st_Parameters      = const_cast< ParametersType * >( &parameters );
+  temp_c.st_RandomGenerator = ThreadRandomGenerator::GetThreadGenerator();
+
+  /** GetValueAndDerivative, one metric per thread, as far as there are
+   * threads. The settings of the metrics are restored, also when one of them
+   * throws; SetNumberOfThreads() then also restores the number of OpenMP
+   * threads.
+   */
+  const ThreadIdType numberOfThreads = std::min(
+    static_cast< ThreadIdType >( this->m_NumberOfMetrics ),
+    MultiThreader::GetGlobalMaximumNumberOfThreads() );
+  try
+  {
+    WorkerThreadPool::GetInstance()->Execute(
+      GetValueAndDerivativeComboThreaderCallback, &temp_c, numberOfThreads );
+  }
+  catch( ... )
+  {
+    this->RestoreMetricThreads( savedNumberOfThreads, savedUseThreadPool );
+    throw;
+  }
+  this->RestoreMetricThreads( savedNumberOfThreads, savedUseThreadPool );
+
+  /** Store the computation times. */
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    if( temp->st_ThisComboMetric->m_UseMetric[ i ] )
+    this->m_MetricComputationTime[ i ] = temp_c.st_MetricComputationTime[ i ];
+  }
+
+} // end ConcurrentGetValueAndDerivative()
+
+
+/**
+ * **************** RestoreMetricThreads *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::RestoreMetricThreads( const std::vector< ThreadIdType > & numberOfThreads,
+  const std::vector< bool > & useThreadPool ) const
+{
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+  {
+    ImageMetricType * testPtr = dynamic_cast< ImageMetricType * >( this->GetMetric( i ) );
+    if( testPtr )
     {
-      double                 weight           = temp->st_ThisComboMetric->GetFinalMetricWeight( i );
-      const DerivativeType & metricDerivative = temp->st_ThisComboMetric->m_MetricDerivatives[ i ];
-      for( unsigned int j = jmin; j < jmax; j++ )
-      {
-        temp->st_Derivative[ j ] += weight * metricDerivative[ j ];
-      }
+      testPtr->SetNumberOfThreads( numberOfThreads[ i ] );
+      testPtr->SetUseThreadPool( useThreadPool[ i ] );
     }
   }
 
-  return ITK_THREAD_RETURN_VALUE;
-
-} // end CombineDerivativesThreaderCallback()
+} // end RestoreMetricThreads()
 
 
 /**
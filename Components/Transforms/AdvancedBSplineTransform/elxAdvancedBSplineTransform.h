@@ -270,6 +270,13 @@ public:
    */
   virtual void IncreaseScale( void );
 
+  /** Upsample a vector from the grid of the previous resolution, such as a
+   * step of the optimizer, in the same way as IncreaseScale() upsampled the
+   * B-spline coefficients.
+   */
+  virtual bool MapVectorFromPreviousResolution(
+    const ParametersType & previousVector, ParametersType & currentVector ) const;
+
   /** Function to read transform-parameters from a file. */
   virtual void ReadFromFile( void );
 
@@ -309,6 +316,9 @@ private:
   GridScheduleComputerPointer m_GridScheduleComputer;
   GridUpsamplerPointer        m_GridUpsampler;
 
+  /** The number of parameters of the grid before the last IncreaseScale(). */
+  itk::SizeValueType m_NumberOfParametersOfPreviousGrid;
+
   /** Variables to remember order and periodicity of B-spline transform. */
   unsigned int m_SplineOrder;
   bool         m_Cyclic;
@@ -35,6 +35,8 @@ template< class TElastix >
 AdvancedBSplineTransform< TElastix >
 ::AdvancedBSplineTransform()
 {
+  this->m_NumberOfParametersOfPreviousGrid = 0;
+
 } // end Constructor()
 
 
@@ -457,6 +459,7 @@ AdvancedBSplineTransform< TElastix >
   this->m_GridUpsampler->SetRequiredGridDirection( requiredGridDirection );
 
   /** Compute the upsampled B-spline parameters. */
+  this->m_NumberOfParametersOfPreviousGrid = latestParameters.GetSize();
   ParametersType upsampledParameters;
   this->m_GridUpsampler->UpsampleParameters( latestParameters, upsampledParameters );
 
@@ -478,6 +481,31 @@ AdvancedBSplineTransform< TElastix >
 }  // end IncreaseScale()
 
 
+/**
+ * ***************** MapVectorFromPreviousResolution ************************
+ */
+
+template< class TElastix >
+bool
+AdvancedBSplineTransform< TElastix >
+::MapVectorFromPreviousResolution(
+  const ParametersType & previousVector, ParametersType & currentVector ) const
+{
+  /** The upsampling is linear in the coefficients, so that the grid
+   * upsampler, still set up by IncreaseScale(), maps vectors as well.
+   */
+  if( this->m_NumberOfParametersOfPreviousGrid > 0
+    && previousVector.GetSize() == this->m_NumberOfParametersOfPreviousGrid )
+  {
+    this->m_GridUpsampler->UpsampleParameters( previousVector, currentVector );
+    return true;
+  }
+
+  return this->Superclass2::MapVectorFromPreviousResolution( previousVector, currentVector );
+
+} // end MapVectorFromPreviousResolution()
+
+
 /**
  * ************************* ReadFromFile ************************
  */
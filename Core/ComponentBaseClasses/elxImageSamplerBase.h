@@ -36,6 +36,15 @@ namespace elastix
  *
  * This class contains all the common functionality for ImageSamplers.
  *
+ * The parameters used in this class are:
+ * \parameter UseMultiThreadingForSamplers: Whether the samples should be generated
+ *   by multiple threads. The random samplers then use a counter-based random
+ *   generator per thread, so that the samples are reproducible for a fixed
+ *   RandomSeed, independent of the number of threads. The command line argument
+ *   "-mts true" has the same effect. \n
+ *   example: <tt>(UseMultiThreadingForSamplers "true")</tt> \n
+ *   The default is "false". Can be given for each resolution.
+ *
  * \ingroup ImageSamplers
  * \ingroup ComponentBaseClasses
  */
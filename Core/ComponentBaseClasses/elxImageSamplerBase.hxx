@@ -56,13 +56,16 @@ ImageSamplerBase< TElastix >
     }
   }
 
-  /** Temporary?: Use the multi-threaded version or not. */
-  std::string useMultiThread = this->m_Configuration->GetCommandLineArgument( "-mts" ); // mts: multi-threaded samplers
-  if( useMultiThread == "true" )
+  /** Use the multi-threaded version or not. */
+  bool useMultiThread = false;
+  this->m_Configuration->ReadParameter( useMultiThread,
+    "UseMultiThreadingForSamplers", this->GetComponentLabel(), level, 0, false );
+  std::string useMultiThreadArgument = this->m_Configuration->GetCommandLineArgument( "-mts" ); // mts: multi-threaded samplers
+  if( useMultiThreadArgument == "true" )
   {
-    this->GetAsITKBaseType()->SetUseMultiThread( true );
+    useMultiThread = true;
   }
-  else { this->GetAsITKBaseType()->SetUseMultiThread( false ); }
+  this->GetAsITKBaseType()->SetUseMultiThread( useMultiThread );
 
 } // end BeforeEachResolutionBase()
 
@@ -63,6 +63,31 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseThreadPoolForMetrics: Whether multi-threaded metrics reuse a
+ *    persistent pool of worker threads, instead of creating new threads for
+ *    every threaded computation. \n
+ *    example: <tt>(UseThreadPoolForMetrics "false")</tt> \n
+ *    The default is true.
+ * \parameter UseSampleBlocks: Whether multi-threaded metrics process the samples
+ *    in blocks: all points of a block are mapped with one call to the transform,
+ *    and the moving image is evaluated for the block as a whole. Supported by
+ *    the AdvancedMeanSquares and AdvancedNormalizedCorrelation metrics.
+ *    Can be given for each resolution. \n
+ *    example: <tt>(UseSampleBlocks "true")</tt> \n
+ *    The default is false.
+ * \parameter SampleBlockSize: The number of samples in a block, when
+ *    UseSampleBlocks is true. Can be given for each resolution. \n
+ *    example: <tt>(SampleBlockSize 128)</tt> \n
+ *    The default is 64.
+ * \parameter UseSampleCache: Whether quantities per sample that do not change
+ *    during a resolution are computed once, and reused in every iteration.
+ *    Only effective with the Full and Grid image samplers; costs memory in
+ *    proportion to the number of samples. Supported by the Parzen window
+ *    based metrics, such as AdvancedMattesMutualInformation, which cache the
+ *    fixed image Parzen windows. Metrics combined in a multi-metric
+ *    registration share the cache. Can be given for each resolution. \n
+ *    example: <tt>(UseSampleCache "true")</tt> \n
+ *    The default is false.
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
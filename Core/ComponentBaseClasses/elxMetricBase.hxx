@@ -178,7 +178,42 @@ MetricBase< TElastix >
         const unsigned int nrOfThreads = atoi( tmp.c_str() );
         thisAsAdvanced->SetNumberOfThreads( nrOfThreads );
       }
+
+      /** Should the persistent worker threads be used, or new threads
+       * for every threaded computation? */
+      bool useThreadPool = true;
+      this->GetConfiguration()->ReadParameter( useThreadPool,
+        "UseThreadPoolForMetrics", this->GetComponentLabel(), level, 0, false );
+      thisAsAdvanced->SetUseThreadPool( useThreadPool );
+
+      /** Should the samples be processed in blocks? */
+      bool useSampleBlocks = false;
+      this->GetConfiguration()->ReadParameter( useSampleBlocks,
+        "UseSampleBlocks", this->GetComponentLabel(), level, 0, false );
+      thisAsAdvanced->SetUseSampleBlocks( useSampleBlocks );
+
+      unsigned int sampleBlockSize = 64;
+      this->GetConfiguration()->ReadParameter( sampleBlockSize,
+        "SampleBlockSize", this->GetComponentLabel(), level, 0, false );
+      thisAsAdvanced->SetSampleBlockSize( sampleBlockSize );
+    }
+
+    /** Should quantities per sample be cached over the iterations? */
+    bool useSampleCache = false;
+    this->GetConfiguration()->ReadParameter( useSampleCache,
+      "UseSampleCache", this->GetComponentLabel(), level, 0, false );
+    if( !useSampleCache )
+    {
+      thisAsAdvanced->SetSampleCache( NULL );
     }
+    else if( !thisAsAdvanced->GetSampleCache() )
+    {
+      thisAsAdvanced->SetSampleCache( itk::ImageSampleCache::New() );
+    }
+
+    /** Profile the phases of the metric evaluation, if requested. */
+    thisAsAdvanced->SetProfiler( this->GetElastix()->GetUseProfiling()
+      ? this->GetElastix()->GetProfiler() : NULL );
 
   } // end advanced metric
 
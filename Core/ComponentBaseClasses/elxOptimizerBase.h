@@ -24,6 +24,9 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkOptimizer.h"
+#include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkOptimizerWarmStartState.h"
+#include "itkConvergenceMonitor.h"
 
 namespace elastix
 {
@@ -44,6 +47,37 @@ namespace elastix
  *    Choose one from {"true", "false"} for every resolution.\n
  *    example: <tt>(NewSamplesEveryIteration "true" "true" "true")</tt> \n
  *    Default is "false" for every resolution.\n
+ * \parameter WarmStart: if this flag is set to "true", optimizers that support it
+ *    (AdaptiveStochasticGradientDescent and QuasiNewtonLBFGS) start the resolution
+ *    from the state they learned in the previous resolution, or in the previous
+ *    elastix level, such as gradient statistics and curvature pairs, and leave
+ *    their own state for the next one. See the documentation of these optimizers.\n
+ *    Choose one from {"true", "false"} for every resolution.\n
+ *    example: <tt>(WarmStart "false" "true" "true")</tt> \n
+ *    Default is "false" for every resolution.\n
+ * \parameter UseAdaptiveStopping: if this flag is set to "true", optimizers that support it
+ *    (AdaptiveStochasticGradientDescent and StandardGradientDescent) stop the resolution
+ *    before MaximumNumberOfIterations when the metric values of the last iterations show
+ *    that the optimization has converged. A line is fitted to the metric values of the last
+ *    AdaptiveStoppingWindowSize iterations; the optimization has converged when its decrease
+ *    is not significant compared to the noise in the metric values, or negligible compared
+ *    to the metric value. The reason is reported in the log.\n
+ *    Choose one from {"true", "false"} for every resolution.\n
+ *    example: <tt>(UseAdaptiveStopping "true" "true" "true")</tt> \n
+ *    Default is "false" for every resolution.\n
+ * \parameter AdaptiveStoppingWindowSize: the number of iterations to which the line is fitted.
+ *    At least 3. Larger windows stop later, but more reliably.\n
+ *    example: <tt>(AdaptiveStoppingWindowSize 200 200 100)</tt> \n
+ *    Default is 200 for every resolution.\n
+ * \parameter AdaptiveStoppingTrendThreshold: the number of standard errors that the fitted
+ *    slope must be below zero for the decrease to be significant.\n
+ *    example: <tt>(AdaptiveStoppingTrendThreshold 1.0 1.0 2.0)</tt> \n
+ *    Default is 1.0 for every resolution.\n
+ * \parameter AdaptiveStoppingRelativeTolerance: the fitted decrease over the window, relative
+ *    to the mean metric value in the window, below which the decrease is negligible.
+ *    0.0 disables this test.\n
+ *    example: <tt>(AdaptiveStoppingRelativeTolerance 1e-5 1e-5 1e-6)</tt> \n
+ *    Default is 1e-5 for every resolution.\n
  *
  * \ingroup Optimizers
  * \ingroup ComponentBaseClasses
@@ -94,6 +128,7 @@ public:
 
   /** Execute stuff before each new pyramid resolution:
    * \li Find out if new samples are used every new iteration in this resolution.
+   * \li Read the warm-start and adaptive stopping settings of this resolution.
    */
   virtual void BeforeEachResolutionBase() ITK_OVERRIDE;
 
@@ -123,6 +158,31 @@ protected:
   /** Check whether the user asked to select new samples every iteration. */
   virtual bool GetNewSamplesEveryIteration( void ) const;
 
+  /** Check whether the user asked for a warm start in this resolution. */
+  virtual bool GetWarmStart( void ) const;
+
+  /** Get the warm-start state. It is created on first use, and stored in the
+   * image cache of elastix, if there is one, so that the next elastix level
+   * finds it. Without image cache it is kept for the resolutions of this
+   * elastix level only.
+   */
+  typedef itk::OptimizerWarmStartState WarmStartStateType;
+  virtual WarmStartStateType * GetWarmStartState( void );
+
+  /** Add the metric value of the last iteration to the adaptive stopping
+   * test. Returns true if the user asked for adaptive stopping in this
+   * resolution, and the optimization has converged. Optimizers that
+   * support adaptive stopping call this in AfterEachIteration(), and stop
+   * the optimization if it returns true.
+   */
+  virtual bool TestAdaptiveStopping( const double value );
+
+  /** Check whether the adaptive stopping test stopped this resolution. */
+  virtual bool GetAdaptivelyStopped( void ) const;
+
+  /** Get the reason of the adaptive stop, to report as stopping condition. */
+  virtual std::string GetAdaptiveStoppingCondition( void ) const;
+
 private:
 
   /** The private constructor. */
@@ -135,6 +195,14 @@ private:
    */
   bool m_NewSamplesEveryIteration;
 
+  /** The user preference for a warm start, and the warm-start state. */
+  bool                        m_WarmStart;
+  WarmStartStateType::Pointer m_WarmStartState;
+
+  /** The user preference for adaptive stopping, and the convergence test. */
+  bool                             m_UseAdaptiveStopping;
+  itk::ConvergenceMonitor::Pointer m_ConvergenceMonitor;
+
 };
 
 } // end namespace elastix
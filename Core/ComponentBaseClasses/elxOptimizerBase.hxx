@@ -23,6 +23,8 @@
 #include "itkSingleValuedNonLinearOptimizer.h"
 #include "itk_zlib.h"
 
+#include <sstream>
+
 namespace elastix
 {
 
@@ -35,6 +37,9 @@ OptimizerBase< TElastix >
 ::OptimizerBase()
 {
   this->m_NewSamplesEveryIteration = false;
+  this->m_WarmStart                = false;
+  this->m_UseAdaptiveStopping      = false;
+  this->m_ConvergenceMonitor       = itk::ConvergenceMonitor::New();
 
 } // end Constructor
 
@@ -79,9 +84,92 @@ OptimizerBase< TElastix >
   this->GetConfiguration()->ReadParameter( this->m_NewSamplesEveryIteration,
     "NewSamplesEveryIteration", this->GetComponentLabel(), level, 0 );
 
+  /** Check if the optimizer should start from its state of the previous resolution. */
+  this->m_WarmStart = false;
+  this->GetConfiguration()->ReadParameter( this->m_WarmStart,
+    "WarmStart", this->GetComponentLabel(), level, 0, false );
+
+  /** Check if the optimizer should stop when the metric values show convergence. */
+  this->m_UseAdaptiveStopping = false;
+  this->GetConfiguration()->ReadParameter( this->m_UseAdaptiveStopping,
+    "UseAdaptiveStopping", this->GetComponentLabel(), level, 0, false );
+  if( this->m_UseAdaptiveStopping )
+  {
+    unsigned long windowSize        = 200;
+    double        trendThreshold    = 1.0;
+    double        relativeTolerance = 1e-5;
+    this->GetConfiguration()->ReadParameter( windowSize,
+      "AdaptiveStoppingWindowSize", this->GetComponentLabel(), level, 0 );
+    this->GetConfiguration()->ReadParameter( trendThreshold,
+      "AdaptiveStoppingTrendThreshold", this->GetComponentLabel(), level, 0 );
+    this->GetConfiguration()->ReadParameter( relativeTolerance,
+      "AdaptiveStoppingRelativeTolerance", this->GetComponentLabel(), level, 0 );
+    this->m_ConvergenceMonitor->SetTrendThreshold( trendThreshold );
+    this->m_ConvergenceMonitor->SetRelativeTolerance( relativeTolerance );
+    this->m_ConvergenceMonitor->SetWindowSize( windowSize );
+  }
+  this->m_ConvergenceMonitor->Reset();
+
+  /** Profile the time spent in the cost function, if requested. */
+  itk::ScaledSingleValuedNonLinearOptimizer * scaledOptimizer
+    = dynamic_cast< itk::ScaledSingleValuedNonLinearOptimizer * >( this->GetAsITKBaseType() );
+  if( scaledOptimizer )
+  {
+    scaledOptimizer->SetProfiler( this->GetElastix()->GetUseProfiling()
+      ? this->GetElastix()->GetProfiler() : NULL );
+  }
+
 } // end BeforeEachResolutionBase()
 
 
+/**
+ * ****************** TestAdaptiveStopping **********************
+ */
+
+template< class TElastix >
+bool
+OptimizerBase< TElastix >
+::TestAdaptiveStopping( const double value )
+{
+  if( !this->m_UseAdaptiveStopping ) { return false; }
+  return this->m_ConvergenceMonitor->AddValue( value );
+
+} // end TestAdaptiveStopping()
+
+
+/**
+ * ****************** GetAdaptivelyStopped **********************
+ */
+
+template< class TElastix >
+bool
+OptimizerBase< TElastix >
+::GetAdaptivelyStopped( void ) const
+{
+  return this->m_UseAdaptiveStopping && this->m_ConvergenceMonitor->GetConverged();
+
+} // end GetAdaptivelyStopped()
+
+
+/**
+ * ****************** GetAdaptiveStoppingCondition **********************
+ */
+
+template< class TElastix >
+std::string
+OptimizerBase< TElastix >
+::GetAdaptiveStoppingCondition( void ) const
+{
+  std::ostringstream condition;
+  condition << "Adaptive stopping: "
+            << this->m_ConvergenceMonitor->GetStopCondition()
+            << " after " << this->m_ConvergenceMonitor->GetNumberOfValues()
+            << " iterations";
+  return condition.str();
+
+} // end GetAdaptiveStoppingCondition()
+
+
 /**
  * ****************** AfterRegistrationBase **********************
  */
@@ -151,6 +239,47 @@ OptimizerBase< TElastix >
 } // end GetNewSamplesEveryIteration()
 
 
+/**
+ * ****************** GetWarmStart ********************
+ */
+
+template< class TElastix >
+bool
+OptimizerBase< TElastix >
+::GetWarmStart( void ) const
+{
+  return this->m_WarmStart;
+
+} // end GetWarmStart()
+
+
+/**
+ * ****************** GetWarmStartState ********************
+ */
+
+template< class TElastix >
+typename OptimizerBase< TElastix >::WarmStartStateType
+* OptimizerBase< TElastix >
+::GetWarmStartState( void )
+{
+  if( this->m_WarmStartState.IsNull() )
+  {
+    /** Look for the state of the previous elastix level of this run, and
+     * leave it for the next one. Without image cache the state is only kept
+     * for the resolutions of this elastix level.
+     */
+    this->m_WarmStartState = WarmStartStateType::GetFromCache(
+      this->GetElastix()->GetImageCache(),
+      this->GetConfiguration()->GetRunIdentifier(),
+      this->GetConfiguration()->GetElastixLevel(),
+      this->GetComponentLabel() );
+  }
+
+  return this->m_WarmStartState.GetPointer();
+
+} // end GetWarmStartState()
+
+
 /**
  * ****************** SetSinusScales ********************
  */
@@ -23,6 +23,7 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkResampleImageFilter.h"
+#include "itkStreamingImageFilter.h"
 #include "elxProgressCommand.h"
 
 namespace elastix
@@ -64,6 +65,17 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter ResultImageNumberOfStreamDivisions: parameter to set the number of
+ *    slabs in which the result image is resampled and written. The resampler then
+ *    only holds one slab of the result image in memory at a time, and the writer
+ *    writes the slabs one by one, which bounds the memory needed for large result
+ *    images. Each slab is resampled multi-threaded. Streamed writing is not possible
+ *    for all file formats, nor with compression; the writer then falls back to a single
+ *    update of the whole result image, so the memory is not bounded. When the result
+ *    image is kept in memory, as in the elastix library, only the cast result image is
+ *    allocated in full.\n
+ *    example: <tt>(ResultImageNumberOfStreamDivisions 16)</tt> \n
+ *    The default is 1, i.e. no streaming.
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -191,6 +203,18 @@ protected:
   /** Method that sets the transform, the interpolator and the inputImage. */
   virtual void SetComponents( void );
 
+  /** Get the number of slabs in which the result image is resampled, as set
+   * by the parameter ResultImageNumberOfStreamDivisions.
+   */
+  virtual unsigned int GetNumberOfResultImageStreamDivisions( void ) const;
+
+  /** Update the pipeline that ends in the cast filter, in slabs if more than
+   * one stream division is given, and return the cast result image.
+   */
+  template< class TCastFilter >
+  itk::DataObject::Pointer UpdateResultImageCaster( TCastFilter * castFilter,
+    const unsigned int numberOfStreamDivisions ) const;
+
   /** Variable that defines to print the progress or not. */
   bool m_ShowProgress;
 
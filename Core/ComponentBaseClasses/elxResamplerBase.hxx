@@ -326,10 +326,15 @@ ResamplerBase< TElastix >
   /** Make sure the resampler is updated. */
   this->GetAsITKBaseType()->Modified();
 
+  /** When streaming, the writer resamples the image slab by slab, and
+   * reports the progress itself.
+   */
+  const bool streaming = this->GetNumberOfResultImageStreamDivisions() > 1;
+
   /** Add a progress observer to the resampler. */
 #ifndef _ELASTIX_BUILD_LIBRARY
   typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
-  if( showProgress )
+  if( showProgress && !streaming )
   {
     progressObserver->ConnectObserver( this->GetAsITKBaseType() );
     progressObserver->SetStartString( "  Progress: " );
@@ -338,28 +343,51 @@ ResamplerBase< TElastix >
 #endif
 
   /** Do the resampling. */
-  try
+  if( !streaming )
   {
-    this->GetAsITKBaseType()->Update();
+    try
+    {
+      this->GetAsITKBaseType()->Update();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      /** Add information to the exception. */
+      excp.SetLocation( "ResamplerBase - WriteResultImage()" );
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while resampling the image.\n";
+      excp.SetDescription( err_str );
+
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
   }
-  catch( itk::ExceptionObject & excp )
-  {
-    /** Add information to the exception. */
-    excp.SetLocation( "ResamplerBase - WriteResultImage()" );
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while resampling the image.\n";
-    excp.SetDescription( err_str );
 
-    /** Pass the exception to an higher level. */
-    throw excp;
+  /** Perform the writing; when streaming, this also does the resampling. */
+  if( !streaming )
+  {
+    this->WriteResultImage( this->GetAsITKBaseType()->GetOutput(), filename, showProgress );
   }
+  else
+  {
+    try
+    {
+      this->WriteResultImage( this->GetAsITKBaseType()->GetOutput(), filename, showProgress );
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      /** Add information to the exception. */
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while resampling the image.\n";
+      excp.SetDescription( err_str );
 
-  /** Perform the writing. */
-  this->WriteResultImage( this->GetAsITKBaseType()->GetOutput(), filename, showProgress );
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
+  }
 
   /** Disconnect from the resampler. */
 #ifndef _ELASTIX_BUILD_LIBRARY
-  if( showProgress )
+  if( showProgress && !streaming )
   {
     progressObserver->DisconnectObserver( this->GetAsITKBaseType() );
   }
@@ -433,11 +461,36 @@ ResamplerBase< TElastix >
   writer->SetOutputComponentType( resultImagePixelType.c_str() );
   writer->SetUseCompression( doCompression );
 
+  /** Write in slabs, if requested. The writer then updates the resampler
+   * for one slab at a time.
+   */
+  const unsigned int numberOfStreamDivisions
+    = this->GetNumberOfResultImageStreamDivisions();
+  writer->SetNumberOfStreamDivisions( numberOfStreamDivisions );
+
+#ifndef _ELASTIX_BUILD_LIBRARY
+  typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
+  if( showProgress && numberOfStreamDivisions > 1 )
+  {
+    progressObserver->ConnectObserver( writer );
+    progressObserver->SetStartString( "  Progress: " );
+    progressObserver->SetEndString( "%" );
+  }
+#endif
+
   /** Do the writing. */
   if( showProgress )
   {
     xl::xout[ "coutonly" ] << std::flush;
-    xl::xout[ "coutonly" ] << "\n  Writing image ..." << std::endl;
+    if( numberOfStreamDivisions > 1 )
+    {
+      xl::xout[ "coutonly" ] << "\n  Resampling and writing image in "
+                             << numberOfStreamDivisions << " slabs ..." << std::endl;
+    }
+    else
+    {
+      xl::xout[ "coutonly" ] << "\n  Writing image ..." << std::endl;
+    }
   }
   try
   {
@@ -454,9 +507,76 @@ ResamplerBase< TElastix >
     /** Pass the exception to an higher level. */
     throw excp;
   }
+
+#ifndef _ELASTIX_BUILD_LIBRARY
+  if( showProgress && numberOfStreamDivisions > 1 )
+  {
+    progressObserver->DisconnectObserver( writer );
+  }
+#endif
 } // end WriteResultImage()
 
 
+/**
+ * ************** GetNumberOfResultImageStreamDivisions ***************
+ */
+
+template< class TElastix >
+unsigned int
+ResamplerBase< TElastix >
+::GetNumberOfResultImageStreamDivisions( void ) const
+{
+  unsigned int numberOfStreamDivisions = 1;
+  this->m_Configuration->ReadParameter( numberOfStreamDivisions,
+    "ResultImageNumberOfStreamDivisions", 0, false );
+  return numberOfStreamDivisions > 0 ? numberOfStreamDivisions : 1;
+
+} // end GetNumberOfResultImageStreamDivisions()
+
+
+/**
+ * ******************* UpdateResultImageCaster ********************
+ */
+
+template< class TElastix >
+template< class TCastFilter >
+itk::DataObject::Pointer
+ResamplerBase< TElastix >
+::UpdateResultImageCaster( TCastFilter * castFilter,
+  const unsigned int numberOfStreamDivisions ) const
+{
+  if( numberOfStreamDivisions <= 1 )
+  {
+    castFilter->Update();
+    return castFilter->GetOutput();
+  }
+
+  /** Stream the resampler and the cast filter slab by slab. */
+  typedef typename TCastFilter::OutputImageType                     CastImageType;
+  typedef itk::StreamingImageFilter< CastImageType, CastImageType > StreamerType;
+  typename StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( castFilter->GetOutput() );
+  streamer->SetNumberOfStreamDivisions( numberOfStreamDivisions );
+  try
+  {
+    streamer->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "ResamplerBase - CreateItkResultImage()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while resampling the image.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+  return streamer->GetOutput();
+
+} // end UpdateResultImageCaster()
+
+
 /*
  * ******************* CreateItkResultImage ********************
  * \todo: avoid code duplication with WriteResultImage function
@@ -472,6 +592,12 @@ ResamplerBase< TElastix >
   /** Make sure the resampler is updated. */
   this->GetAsITKBaseType()->Modified();
 
+  /** When streaming, the cast filter is updated slab by slab, so that only
+   * the cast result image is allocated in full.
+   */
+  const unsigned int numberOfStreamDivisions
+    = this->GetNumberOfResultImageStreamDivisions();
+
 #ifndef _ELASTIX_BUILD_LIBRARY
   /** Add a progress observer to the resampler. */
   typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
@@ -481,20 +607,23 @@ ResamplerBase< TElastix >
 #endif
 
   /** Do the resampling. */
-  try
+  if( numberOfStreamDivisions <= 1 )
   {
-    this->GetAsITKBaseType()->Update();
-  }
-  catch( itk::ExceptionObject & excp )
-  {
-    /** Add information to the exception. */
-    excp.SetLocation( "ResamplerBase - WriteResultImage()" );
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while resampling the image.\n";
-    excp.SetDescription( err_str );
-
-    /** Pass the exception to an higher level. */
-    throw excp;
+    try
+    {
+      this->GetAsITKBaseType()->Update();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      /** Add information to the exception. */
+      excp.SetLocation( "ResamplerBase - WriteResultImage()" );
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while resampling the image.\n";
+      excp.SetDescription( err_str );
+
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
   }
 
   /** Check if ResampleInterpolator is the RayCastResampleInterpolator */
@@ -559,71 +688,61 @@ ResamplerBase< TElastix >
   {
     typename CastFilterChar::Pointer castFilter = CastFilterChar::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   if( resultImagePixelType.compare( "unsigned char" ) == 0 )
   {
     typename CastFilterUChar::Pointer castFilter = CastFilterUChar::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "short" ) == 0 )
   {
     typename CastFilterShort::Pointer castFilter = CastFilterShort::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "ushort" ) == 0 || resultImagePixelType.compare( "unsigned short" ) == 0 ) // <-- ushort for backwards compatibility
   {
     typename CastFilterUShort::Pointer castFilter = CastFilterUShort::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "int" ) == 0 )
   {
     typename CastFilterInt::Pointer castFilter = CastFilterInt::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "unsigned int" ) == 0 )
   {
     typename CastFilterUInt::Pointer castFilter = CastFilterUInt::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "long" ) == 0 )
   {
     typename CastFilterLong::Pointer castFilter = CastFilterLong::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "unsigned long" ) == 0 )
   {
     typename CastFilterULong::Pointer castFilter = CastFilterULong::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "float" ) == 0 )
   {
     typename CastFilterFloat::Pointer castFilter = CastFilterFloat::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
   else if( resultImagePixelType.compare( "double" ) == 0 )
   {
     typename CastFilterDouble::Pointer castFilter = CastFilterDouble::New();
     castFilter->SetInput( infoChanger->GetOutput() );
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = this->UpdateResultImageCaster( castFilter.GetPointer(), numberOfStreamDivisions );
   }
 
   if( resultImage.IsNull() )
@@ -107,6 +107,10 @@ namespace elastix
  * The location is relative to the path from where elastix/transformix is started!\n
  * Default: "NoInitialTransform", which (obviously) means that there is no initial transform
  * to be loaded.
+ * \transformparameter NumberOfPointsPerChunk: The number of points that are read,
+ * transformed and written at once, when transforming a binary point file.\n
+ * example <tt>(NumberOfPointsPerChunk 100000)</tt>\n
+ * Default: 1048576.
  *
  * The command line arguments used by this class are:
  * \commandlinearg -t0: optional argument for elastix for specifying an initial transform
@@ -119,6 +123,11 @@ namespace elastix
  *    "point", depending if the user supplies voxel indices or real world coordinates.
  *    The second line should be the number of points that should be transformed. The
  *    third and following lines give the indices or points.\n
+ *    The points may also be given in the binary point format, described in
+ *    itk::TransformixBinaryPointFile. Such files are recognized by their
+ *    header, and are processed in chunks, so that the memory use does not
+ *    depend on the number of points. The transformed points are written
+ *    in the same format to outputpoints.bin.\n
  *    It is also possible to deform all points, thereby generating a deformation field
  *    image. This is done by:\n
  *    example: <tt>-def all</tt> \n
@@ -298,6 +307,11 @@ public:
   /** Function to transform coordinates from fixed to moving image, given as VTK file. */
   virtual void TransformPointsSomePointsVTK( const std::string filename ) const;
 
+  /** Function to transform coordinates from fixed to moving image, given as
+   * binary point file. The points are read, transformed and written in chunks.
+   */
+  virtual void TransformPointsSomePointsBinary( const std::string filename ) const;
+
   /** Deprecation note: The plan is to split all Compute* and TransformPoints* functions
    *  into Generate* and Write* functions, since that would facilitate a proper library
    *  interface. To keep everything functional during the transition period we need to
@@ -323,6 +337,17 @@ public:
    */
   virtual void SetFinalParameters( void );
 
+  /** Map a vector from the parameter space of the previous resolution, such
+   * as a step of the optimizer, to the parameter space of the current
+   * resolution, in the same way as the parameters were mapped. Returns false
+   * if the mapping is not known. The default implementation maps a vector
+   * of unchanged size to itself; transforms that change their parameters
+   * between resolutions, such as a B-spline grid that is upsampled, should
+   * override it.
+   */
+  virtual bool MapVectorFromPreviousResolution(
+    const ParametersType & previousVector, ParametersType & currentVector ) const;
+
 protected:
 
   /** The constructor. */
@@ -23,6 +23,7 @@
 #include "itkPointSet.h"
 #include "itkDefaultStaticMeshTraits.h"
 #include "itkTransformixInputPointFileReader.h"
+#include "itkTransformixBinaryPointFile.h"
 #include "vnl/vnl_math.h"
 #include <itksys/SystemTools.hxx>
 #include "itkVector.h"
@@ -36,7 +37,9 @@
 #include "itkMesh.h"
 #include "itkMeshFileReader.h"
 #include "itkMeshFileWriter.h"
-#include "itkTransformMeshFilter.h"
+#include "itkMultiThreader.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -367,6 +370,27 @@ TransformBase< TElastix >
 } // end SetFinalParameters()
 
 
+/**
+ * ******************* MapVectorFromPreviousResolution ******************
+ */
+
+template< class TElastix >
+bool
+TransformBase< TElastix >
+::MapVectorFromPreviousResolution(
+  const ParametersType & previousVector, ParametersType & currentVector ) const
+{
+  if( previousVector.GetSize() != this->GetAsITKBaseType()->GetNumberOfParameters() )
+  {
+    return false;
+  }
+
+  currentVector = previousVector;
+  return true;
+
+} // end MapVectorFromPreviousResolution()
+
+
 /**
  * ******************* AfterRegistrationBase ********************
  */
@@ -1092,7 +1116,13 @@ TransformBase< TElastix >
   /** If there is an input point-file? */
   if( def != "" && def != "all" )
   {
-    if( itksys::SystemTools::StringEndsWith( def.c_str(), ".vtk" )
+    if( itk::TransformixBinaryPointFile::IsBinaryPointFile( def ) )
+    {
+      elxout << "  The transform is evaluated on some points, "
+             << "specified in a binary input point file." << std::endl;
+      this->TransformPointsSomePointsBinary( def );
+    }
+    else if( itksys::SystemTools::StringEndsWith( def.c_str(), ".vtk" )
       || itksys::SystemTools::StringEndsWith( def.c_str(), ".VTK" ) )
     {
       elxout << "  The transform is evaluated on some points, "
@@ -1275,13 +1305,17 @@ TransformBase< TElastix >
     }
   }
 
-  /** Apply the transform. */
+  /** Apply the transform. The points are transformed in batches, in
+   * parallel. The number of threads respects the -threads argument,
+   * which sets the global maximum number of threads.
+   */
   elxout << "  The input points are transformed." << std::endl;
+  this->GetAsITKBaseType()->TransformPointsMultiThreaded(
+    inputpointvec, outputpointvec,
+    itk::MultiThreader::GetGlobalDefaultNumberOfThreads() );
+
   for( unsigned int j = 0; j < nrofpoints; j++ )
   {
-    /** Call TransformPoint. */
-    outputpointvec[ j ] = this->GetAsITKBaseType()->TransformPoint( inputpointvec[ j ] );
-
     /** Transform back to index in fixed image domain. */
     dummyImage->TransformPhysicalPointToContinuousIndex(
       outputpointvec[ j ], fixedcindex );
@@ -1395,8 +1429,8 @@ TransformBase< TElastix >
     DummyIPPPixelType, FixedImageDimension, MeshTraitsType > MeshType;
   typedef itk::MeshFileReader< MeshType > MeshReaderType;
   typedef itk::MeshFileWriter< MeshType > MeshWriterType;
-  typedef itk::TransformMeshFilter<
-    MeshType, MeshType, CombinationTransformType >       TransformMeshFilterType;
+  typedef typename MeshType::PointsContainer             PointsContainerType;
+  typedef typename PointsContainerType::Iterator         PointsIteratorType;
 
   /** Read the input points. */
   typename MeshReaderType::Pointer meshReader = MeshReaderType::New();
@@ -1417,15 +1451,34 @@ TransformBase< TElastix >
   unsigned long nrofpoints = meshReader->GetOutput()->GetNumberOfPoints();
   elxout << "  Number of specified input points: " << nrofpoints << std::endl;
 
-  /** Apply the transform. */
+  /** Apply the transform. The mesh points are gathered in a contiguous
+   * buffer, transformed in batches in parallel, and written back into the
+   * mesh, which keeps its cells and point data.
+   */
   elxout << "  The input points are transformed." << std::endl;
-  typename TransformMeshFilterType::Pointer meshTransformer = TransformMeshFilterType::New();
-  meshTransformer->SetTransform(
-    const_cast< CombinationTransformType * >( this->GetAsCombinationTransform() ) );
-  meshTransformer->SetInput( meshReader->GetOutput() );
+  typename MeshType::Pointer mesh = meshReader->GetOutput();
+  std::vector< InputPointType >  inputpointvec;
+  std::vector< OutputPointType > outputpointvec;
+  inputpointvec.reserve( nrofpoints );
+  PointsContainerType * points = mesh->GetPoints();
+  if( points != NULL )
+  {
+    for( PointsIteratorType it = points->Begin(); it != points->End(); ++it )
+    {
+      InputPointType point;
+      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      {
+        point[ i ] = it.Value()[ i ];
+      }
+      inputpointvec.push_back( point );
+    }
+  }
+
   try
   {
-    meshTransformer->Update();
+    this->GetAsITKBaseType()->TransformPointsMultiThreaded(
+      inputpointvec, outputpointvec,
+      itk::MultiThreader::GetGlobalDefaultNumberOfThreads() );
   }
   catch( itk::ExceptionObject & err )
   {
@@ -1433,6 +1486,18 @@ TransformBase< TElastix >
     xl::xout[ "error" ] << err << std::endl;
   }
 
+  if( points != NULL && outputpointvec.size() == inputpointvec.size() )
+  {
+    unsigned long j = 0;
+    for( PointsIteratorType it = points->Begin(); it != points->End(); ++it, ++j )
+    {
+      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      {
+        it.Value()[ i ] = outputpointvec[ j ][ i ];
+      }
+    }
+  }
+
   /** Create filename and file stream. */
   std::string outputPointsFileName = this->m_Configuration
     ->GetCommandLineArgument( "-out" );
@@ -1441,7 +1506,7 @@ TransformBase< TElastix >
          <<  outputPointsFileName << std::endl;
   typename MeshWriterType::Pointer meshWriter = MeshWriterType::New();
   meshWriter->SetFileName( outputPointsFileName.c_str() );
-  meshWriter->SetInput( meshTransformer->GetOutput() );
+  meshWriter->SetInput( mesh );
 
   try
   {
@@ -1456,6 +1521,153 @@ TransformBase< TElastix >
 } // end TransformPointsSomePointsVTK()
 
 
+/**
+ * ************** TransformPointsSomePointsBinary *********************
+ *
+ * This function reads points from a binary point file and transforms
+ * these fixed-image coordinates to moving-image coordinates.
+ *
+ * The file is memory mapped, and processed in chunks: each chunk is
+ * read, transformed in parallel, and appended to outputpoints.bin, so
+ * that the memory use does not depend on the number of points.
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::TransformPointsSomePointsBinary( const std::string filename ) const
+{
+  /** Typedef's. */
+  typedef typename FixedImageType::RegionType           FixedImageRegionType;
+  typedef typename FixedImageType::IndexType            FixedImageIndexType;
+  typedef typename FixedImageIndexType::IndexValueType  FixedImageIndexValueType;
+
+  /** Open the input points. */
+  itk::TransformixBinaryPointFile::Pointer inputFile
+    = itk::TransformixBinaryPointFile::New();
+  elxout << "  Reading input point file: " << filename << std::endl;
+  try
+  {
+    inputFile->Open( filename );
+  }
+  catch( itk::ExceptionObject & err )
+  {
+    xl::xout[ "error" ] << "  Error while opening input point file." << std::endl;
+    xl::xout[ "error" ] << err << std::endl;
+    return;
+  }
+  if( inputFile->GetDimension() != FixedImageDimension )
+  {
+    xl::xout[ "error" ] << "  Error: the dimension of the input points ("
+                        << inputFile->GetDimension()
+                        << ") does not match the fixed image dimension." << std::endl;
+    return;
+  }
+
+  /** Some user-feedback. */
+  const bool pointsAreIndices = inputFile->GetPointsAreIndices();
+  if( pointsAreIndices )
+  {
+    elxout << "  Input points are specified as image indices." << std::endl;
+  }
+  else
+  {
+    elxout << "  Input points are specified in world coordinates." << std::endl;
+  }
+  const unsigned long nrofpoints = inputFile->GetNumberOfPoints();
+  elxout << "  Number of specified input points: " << nrofpoints << std::endl;
+
+  /** Read the chunk size. */
+  unsigned long chunkSize = 1048576;
+  this->m_Configuration->ReadParameter( chunkSize, "NumberOfPointsPerChunk", 0, false );
+  chunkSize = std::max( chunkSize, 1UL );
+
+  /** Make a temporary image with the right region info, to convert
+   * indices to points. See TransformPointsSomePoints(). */
+  FixedImageRegionType region;
+  region.SetIndex(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex() );
+  region.SetSize(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize() );
+
+  typename FixedImageType::Pointer dummyImage = FixedImageType::New();
+  dummyImage->SetRegions( region );
+  dummyImage->SetOrigin(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin() );
+  dummyImage->SetSpacing(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing() );
+  dummyImage->SetDirection(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection() );
+
+  /** Create filename and file stream. */
+  std::string outputPointsFileName = this->m_Configuration
+    ->GetCommandLineArgument( "-out" );
+  outputPointsFileName += "outputpoints.bin";
+  std::ofstream outputPointsFile( outputPointsFileName.c_str(),
+    std::ios::out | std::ios::binary );
+  elxout << "  The transformed points are saved in: "
+         <<  outputPointsFileName << std::endl;
+  itk::TransformixBinaryPointFile::WriteHeader( outputPointsFile,
+    MovingImageDimension, false, inputFile->GetComponentSize(), nrofpoints );
+
+  /** Process the points chunk by chunk. */
+  elxout << "  The input points are transformed." << std::endl;
+  const unsigned long            bufferSize = std::min( chunkSize, nrofpoints );
+  std::vector< double >          buffer( bufferSize * FixedImageDimension );
+  std::vector< InputPointType >  inputpointvec;
+  std::vector< OutputPointType > outputpointvec;
+  FixedImageIndexType            index;
+  for( unsigned long first = 0; first < nrofpoints; first += chunkSize )
+  {
+    const unsigned long count = std::min( chunkSize, nrofpoints - first );
+    inputFile->ReadPoints( first, count, &buffer[ 0 ] );
+
+    /** Convert to physical points. */
+    inputpointvec.resize( count );
+    for( unsigned long j = 0; j < count; j++ )
+    {
+      const double * coordinates = &buffer[ j * FixedImageDimension ];
+      if( pointsAreIndices )
+      {
+        for( unsigned int i = 0; i < FixedImageDimension; i++ )
+        {
+          index[ i ] = static_cast< FixedImageIndexValueType >(
+            itk::Math::Round< double >( coordinates[ i ] ) );
+        }
+        dummyImage->TransformIndexToPhysicalPoint( index, inputpointvec[ j ] );
+      }
+      else
+      {
+        for( unsigned int i = 0; i < FixedImageDimension; i++ )
+        {
+          inputpointvec[ j ][ i ] = coordinates[ i ];
+        }
+      }
+    }
+
+    /** Transform and write this chunk. */
+    this->GetAsITKBaseType()->TransformPointsMultiThreaded(
+      inputpointvec, outputpointvec,
+      itk::MultiThreader::GetGlobalDefaultNumberOfThreads() );
+    for( unsigned long j = 0; j < count; j++ )
+    {
+      for( unsigned int i = 0; i < MovingImageDimension; i++ )
+      {
+        buffer[ j * MovingImageDimension + i ] = outputpointvec[ j ][ i ];
+      }
+    }
+    itk::TransformixBinaryPointFile::WritePoints( outputPointsFile,
+      &buffer[ 0 ], count * MovingImageDimension, inputFile->GetComponentSize() );
+  }
+
+  if( !outputPointsFile )
+  {
+    xl::xout[ "error" ] << "  Error while saving points." << std::endl;
+  }
+
+} // end TransformPointsSomePointsBinary()
+
+
 /**
  * ************** TransformPointsAllPoints **********************
  *
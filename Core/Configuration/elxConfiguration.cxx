@@ -37,6 +37,7 @@ Configuration::Configuration()
   this->m_IsInitialized              = false;
   this->m_ElastixLevel               = 0;
   this->m_TotalNumberOfElastixLevels = 1;
+  this->m_RunIdentifier              = 0;
 
 } // end Constructor()
 
@@ -108,6 +108,12 @@ public:
   itkSetMacro( TotalNumberOfElastixLevels, unsigned int );
   itkGetConstMacro( TotalNumberOfElastixLevels, unsigned int );
 
+  /** Get and Set the identifier of the registration run, which all its
+   * elastix levels share; see itk::ImageCache::GetNewRunIdentifier().
+   */
+  itkSetMacro( RunIdentifier, itk::SizeValueType );
+  itkGetConstMacro( RunIdentifier, itk::SizeValueType );
+
   /***/
   virtual bool GetPrintErrorMessages( void )
   {
@@ -257,9 +263,10 @@ private:
   ParameterFileParserPointer   m_ParameterFileParser;
   ParameterMapInterfacePointer m_ParameterMapInterface;
 
-  bool         m_IsInitialized;
-  unsigned int m_ElastixLevel;
-  unsigned int m_TotalNumberOfElastixLevels;
+  bool               m_IsInitialized;
+  unsigned int       m_ElastixLevel;
+  unsigned int       m_TotalNumberOfElastixLevels;
+  itk::SizeValueType m_RunIdentifier;
 
 };
 
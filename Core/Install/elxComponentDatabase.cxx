@@ -134,18 +134,16 @@ ComponentDatabase::SetIndex(
 ComponentDatabase::PtrToCreator
 ComponentDatabase::GetCreator(
   const ComponentDescriptionType & name,
-  IndexType i )
+  IndexType i ) const
 {
-  /** Get the map */
-  CreatorMapType map = GetCreatorMap();
-
   /** Make a key with the input arguments */
   CreatorMapKeyType key( name, i );
 
   /** Check if this key has been defined. If yes, return the 'creator'
    * that is linked to it.
    */
-  if( map.count( key ) == 0 )    // of gewoon !map.count( key ) als boven??
+  CreatorMapType::const_iterator it = this->CreatorMap.find( key );
+  if( it == this->CreatorMap.end() )
   {
     xout[ "error" ] << "Error: " << std::endl;
     xout[ "error" ] << name << "(index " << i << ") - This component is not installed!" << std::endl;
@@ -153,7 +151,7 @@ ComponentDatabase::GetCreator(
   }
   else
   {
-    return map[ key ];
+    return it->second;
   }
 
 }   // end GetCreator
@@ -168,11 +166,8 @@ ComponentDatabase::GetIndex(
   const PixelTypeDescriptionType & fixedPixelType,
   ImageDimensionType fixedDimension,
   const PixelTypeDescriptionType & movingPixelType,
-  ImageDimensionType movingDimension )
+  ImageDimensionType movingDimension ) const
 {
-  /** Get the map */
-  IndexMapType map = GetIndexMap();
-
   /** Make a key with the input arguments */
   ImageTypeDescriptionType fixedImage( fixedPixelType, fixedDimension );
   ImageTypeDescriptionType movingImage( movingPixelType, movingDimension );
@@ -181,7 +176,8 @@ ComponentDatabase::GetIndex(
   /** Check if this key has been defined. If yes, return the 'index'
    * that is linked to it.
    */
-  if( map.count( key ) == 0 )
+  IndexMapType::const_iterator it = this->IndexMap.find( key );
+  if( it == this->IndexMap.end() )
   {
     xout[ "error" ] << "ERROR:\n"
                     << "  FixedImageType:  " << fixedDimension << "D " << fixedPixelType << std::endl
@@ -196,7 +192,7 @@ ComponentDatabase::GetIndex(
   }
   else
   {
-    return map[ key ];
+    return it->second;
   }
 
 }   // end GetIndex
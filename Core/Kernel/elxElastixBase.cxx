@@ -17,7 +17,7 @@
  *=========================================================================*/
 #include "elxElastixBase.h"
 #include <sstream>
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkThreadRandomGenerator.h"
 
 namespace elastix
 {
@@ -69,6 +69,10 @@ ElastixBase::ElastixBase()
    * backward compatability. From Elastix 4.8: set it to true by default.*/
   this->m_UseDirectionCosines = true;
 
+  /** Profiling is off by default. */
+  this->m_Profiler     = ProfilerType::New();
+  this->m_UseProfiling = false;
+
 } // end Constructor
 
 
@@ -242,7 +246,7 @@ ElastixBase::BeforeAllBase( void )
   typedef RandomGeneratorType::IntegerType                       SeedType;
   unsigned int randomSeed = 121212;
   this->GetConfiguration()->ReadParameter( randomSeed, "RandomSeed", 0, false );
-  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  RandomGeneratorType::Pointer randomGenerator = itk::ThreadRandomGenerator::GetInstance();
   randomGenerator->SetSeed( static_cast< SeedType >( randomSeed ) );
 
   /** Return a value. */
@@ -351,6 +355,12 @@ ElastixBase::BeforeRegistrationBase( void )
 
   xout.AddTargetCell( "iteration", &this->m_IterationInfo );
 
+  /** Should the registration be profiled? */
+  this->m_UseProfiling = false;
+  this->GetConfiguration()->ReadParameter( this->m_UseProfiling,
+    "Profiling", 0, false );
+  this->m_Profiler->Reset();
+
 } // end BeforeRegistrationBase()
 
 
@@ -38,9 +38,12 @@
 #include "itkVectorContainer.h"
 #include "itkImageFileReader.h"
 #include "itkChangeInformationImageFilter.h"
+#include "itkRegistrationProfiler.h"
+#include "itkImageCache.h"
 
 #include <fstream>
 #include <iomanip>
+#include <typeinfo>
 
 /** Like itkGet/SetObjectMacro, but in these macros the itkDebugMacro is
  * not called. Besides, they are not virtual, since
@@ -97,6 +100,27 @@ namespace elastix
  *   Most importantly, it affects the output precision of the parameters in the transform parameter file.\n
  *   example: <tt>(DefaultOutputPrecision 6)</tt>\n
  *   Default value: 6.
+ * \parameter Profiling: Whether the time spent in the phases of the registration
+ *   (sampling, transform evaluation, interpolation, Jacobian products, derivative
+ *   accumulation, metric evaluation and optimizer update) should be measured.
+ *   The profile of each resolution is written to the output directory, next to
+ *   the IterationInfo file.\n
+ *   example: <tt>(Profiling "true")</tt>\n
+ *   Default value: false.
+ * \parameter ProfileFormat: The format of the written profiles, "csv" or "json".\n
+ *   example: <tt>(ProfileFormat "json")</tt>\n
+ *   Default value: "csv".
+ * \parameter IterationInfoInterval: Write the iteration info of every N-th iteration
+ *   only, that is of the iterations 0, N, 2N, etc. The iteration info of the other
+ *   iterations is not formatted at all.\n
+ *   example: <tt>(IterationInfoInterval 10)</tt>\n
+ *   Default value: 1, which writes every iteration.
+ * \parameter AsynchronousIterationInfo: Whether the iteration info should be written
+ *   to the IterationInfo file by a background thread. The registration thread then only
+ *   copies the row of each iteration in a buffer, and the iteration info is not written
+ *   to the screen and the elastix.log. Only used if WriteIterationInfo is true.\n
+ *   example: <tt>(AsynchronousIterationInfo "true")</tt>\n
+ *   Default value: false.
  *
  * The command line arguments used by this class are:
  * \commandlinearg -f: mandatory argument for elastix with the file name of the fixed image. \n
@@ -343,6 +367,32 @@ public:
   }
 
 
+  /** Set/Get the image cache, which is shared by the elastix levels of a run
+   * and by transformix runs. It is NULL when the caller did not provide one.
+   */
+  typedef itk::ImageCache ImageCacheType;
+  elxGetObjectMacro( ImageCache, ImageCacheType );
+  elxSetObjectMacro( ImageCache, ImageCacheType );
+
+  /** Get the profiler, which records the time spent in the phases of the
+   * registration. It is always created, but the components only use it
+   * when GetUseProfiling() returns true.
+   */
+  typedef itk::RegistrationProfiler ProfilerType;
+  virtual ProfilerType * GetProfiler( void ) const
+  {
+    return this->m_Profiler.GetPointer();
+  }
+
+
+  /** Get whether the registration is profiled. This depends on the
+   * Profiling parameter. */
+  virtual bool GetUseProfiling( void ) const
+  {
+    return this->m_UseProfiling;
+  }
+
+
   /** Get whether direction cosines should be taken into account (true)
    * or ignored (false). This depends on the UseDirectionCosines
    * parameter. */
@@ -375,6 +425,13 @@ protected:
 
   FlatDirectionCosinesType m_OriginalFixedImageDirection;
 
+  /** Get the table with the iteration info, xout["iteration"]. */
+  xl::xoutrow_type & GetIterationInfo( void )
+  {
+    return this->m_IterationInfo;
+  }
+
+
   /** Convenient mini class to load the files specified by a filename container
    * The function GenerateImageContainer can be used without instantiating an
    * object of this class, since it is static. It has 2 arguments: the
@@ -386,6 +443,10 @@ protected:
    * The useDirection option is built in as a means to ignore the direction
    * cosines. Set it to false to force the direction cosines to identity.
    * The original direction cosines are returned separately.
+   *
+   * If an image cache is given, the images are stored in it as they were
+   * read, under the file name and modification time, and an image that is
+   * found in the cache is not read again.
    */
   template< class TImage >
   class MultipleImageLoader
@@ -402,13 +463,28 @@ public:
 
     static DataObjectContainerPointer GenerateImageContainer(
       FileNameContainerType * fileNameContainer, const std::string & imageDescription,
-      bool useDirectionCosines, DirectionType * originalDirectionCosines = NULL )
+      bool useDirectionCosines, DirectionType * originalDirectionCosines = NULL,
+      ImageCacheType * imageCache = NULL )
     {
       DataObjectContainerPointer imageContainer = DataObjectContainerType::New();
 
       /** Loop over all image filenames. */
       for( unsigned int i = 0; i < fileNameContainer->Size(); ++i )
       {
+        /** Look for the image in the cache. */
+        std::string  cacheKey    = "";
+        ImagePointer cachedImage = NULL;
+        if( imageCache )
+        {
+          cacheKey = ImageCacheType::GetFileKey( fileNameContainer->ElementAt( i ) );
+          if( !cacheKey.empty() )
+          {
+            cacheKey   += std::string( ":" ) + typeid( ImageType ).name();
+            cachedImage = dynamic_cast< ImageType * >(
+              imageCache->GetEntry( cacheKey ).GetPointer() );
+          }
+        }
+
         /** Setup reader. */
         ImageReaderPointer imageReader = ImageReaderType::New();
         imageReader->SetFileName( fileNameContainer->ElementAt( i ).c_str() );
@@ -417,7 +493,14 @@ public:
         direction.SetIdentity();
         infoChanger->SetOutputDirection( direction );
         infoChanger->SetChangeDirection( !useDirectionCosines );
-        infoChanger->SetInput( imageReader->GetOutput() );
+        if( cachedImage.IsNotNull() )
+        {
+          infoChanger->SetInput( cachedImage );
+        }
+        else
+        {
+          infoChanger->SetInput( imageReader->GetOutput() );
+        }
 
         /** Do the reading. */
         try
@@ -435,6 +518,12 @@ public:
           throw excp;
         }
 
+        /** Store the image as it was read in the cache. */
+        if( cachedImage.IsNull() && !cacheKey.empty() )
+        {
+          imageCache->SetEntry( cacheKey, imageReader->GetOutput() );
+        }
+
         /** Store loaded image in the image container, as a DataObjectPointer. */
         ImagePointer image = infoChanger->GetOutput();
         imageContainer->CreateElementAt( i ) = image.GetPointer();
@@ -442,7 +531,7 @@ public:
         /** Store the original direction cosines */
         if( originalDirectionCosines )
         {
-          *originalDirectionCosines = imageReader->GetOutput()->GetDirection();
+          *originalDirectionCosines = infoChanger->GetInput()->GetDirection();
         }
 
       } // end for i
@@ -546,6 +635,13 @@ private:
   /** Use or ignore direction cosines. */
   bool m_UseDirectionCosines;
 
+  /** The image cache. */
+  ImageCacheType::Pointer m_ImageCache;
+
+  /** The profiler, and whether it is used. */
+  ProfilerType::Pointer m_Profiler;
+  bool                  m_UseProfiling;
+
   /** Read a series of command line options that satisfy the following syntax:
    * {-f,-f0} \<filename0\> [-f1 \<filename1\> [ -f2 \<filename2\> ... ] ]
    *
@@ -28,6 +28,8 @@
 
 #include "elxMacro.h"
 #include "itkMultiThreader.h"
+#include "itkMutexLockHolder.h"
+#include "itkSimpleFastMutexLock.h"
 
 #ifdef ELASTIX_USE_OPENCL
 #include "itkOpenCLSetup.h"
@@ -56,27 +58,30 @@ xoutsimple_type g_CoutOnlyXout;
 xoutsimple_type g_LogOnlyXout;
 std::ofstream   g_LogFileStream;
 
+/** Protects the loading and unloading of the shared component database. */
+static itk::SimpleFastMutexLock g_ComponentDatabaseLock;
+
 /**
- * ********************* xoutSetup ******************************
+ * ********************* xoutSetupTargets ******************************
  *
- * NB: this function is a global function, not part of the ElastixMain
- * class!!
+ * Configure an xout, its target cells and the logfile.
+ * Used by xoutSetup() and xoutSession::Setup().
  */
 
-int
-xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
+static int
+xoutSetupTargets( xoutbase_type & targetXout,
+  xoutsimple_type & warningXout, xoutsimple_type & errorXout,
+  xoutsimple_type & standardXout, xoutsimple_type & coutOnlyXout,
+  xoutsimple_type & logOnlyXout, std::ofstream & logFileStream,
+  const char * logfilename, bool setupLogging, bool setupCout )
 {
-  /** The namespace of xout. */
-  using namespace xl;
-
   int returndummy = 0;
-  set_xout( &g_xout );
 
   if( setupLogging )
   {
     /** Open the logfile for writing. */
-    g_LogFileStream.open( logfilename );
-    if( !g_LogFileStream.is_open() )
+    logFileStream.open( logfilename );
+    if( !logFileStream.is_open() )
     {
       std::cerr << "ERROR: LogFile cannot be opened!" << std::endl;
       return 1;
@@ -86,43 +91,123 @@ xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
   /** Set std::cout and the logfile as outputs of xout. */
   if( setupLogging )
   {
-    returndummy |= xout.AddOutput( "log", &g_LogFileStream );
+    returndummy |= targetXout.AddOutput( "log", &logFileStream );
   }
   if( setupCout )
   {
-    returndummy |= xout.AddOutput( "cout", &std::cout );
+    returndummy |= targetXout.AddOutput( "cout", &std::cout );
   }
 
   /** Set outputs of LogOnly and CoutOnly. */
-  returndummy |= g_LogOnlyXout.AddOutput( "log", &g_LogFileStream );
-  returndummy |= g_CoutOnlyXout.AddOutput( "cout", &std::cout );
+  returndummy |= logOnlyXout.AddOutput( "log", &logFileStream );
+  returndummy |= coutOnlyXout.AddOutput( "cout", &std::cout );
 
   /** Copy the outputs to the warning-, error- and standard-xouts. */
-  g_WarningXout.SetOutputs( xout.GetCOutputs() );
-  g_ErrorXout.SetOutputs( xout.GetCOutputs() );
-  g_StandardXout.SetOutputs( xout.GetCOutputs() );
+  warningXout.SetOutputs( targetXout.GetCOutputs() );
+  errorXout.SetOutputs( targetXout.GetCOutputs() );
+  standardXout.SetOutputs( targetXout.GetCOutputs() );
 
-  g_WarningXout.SetOutputs( xout.GetXOutputs() );
-  g_ErrorXout.SetOutputs( xout.GetXOutputs() );
-  g_StandardXout.SetOutputs( xout.GetXOutputs() );
+  warningXout.SetOutputs( targetXout.GetXOutputs() );
+  errorXout.SetOutputs( targetXout.GetXOutputs() );
+  standardXout.SetOutputs( targetXout.GetXOutputs() );
 
   /** Link the warning-, error- and standard-xouts to xout. */
-  returndummy |= xout.AddTargetCell( "warning", &g_WarningXout );
-  returndummy |= xout.AddTargetCell( "error", &g_ErrorXout );
-  returndummy |= xout.AddTargetCell( "standard", &g_StandardXout );
-  returndummy |= xout.AddTargetCell( "logonly", &g_LogOnlyXout );
-  returndummy |= xout.AddTargetCell( "coutonly", &g_CoutOnlyXout );
+  returndummy |= targetXout.AddTargetCell( "warning", &warningXout );
+  returndummy |= targetXout.AddTargetCell( "error", &errorXout );
+  returndummy |= targetXout.AddTargetCell( "standard", &standardXout );
+  returndummy |= targetXout.AddTargetCell( "logonly", &logOnlyXout );
+  returndummy |= targetXout.AddTargetCell( "coutonly", &coutOnlyXout );
 
   /** Format the output. */
-  xout[ "standard" ] << std::fixed;
-  xout[ "standard" ] << std::showpoint;
+  targetXout[ "standard" ] << std::fixed;
+  targetXout[ "standard" ] << std::showpoint;
 
   /** Return a value. */
   return returndummy;
 
+} // end xoutSetupTargets()
+
+
+/**
+ * ********************* xoutSetup ******************************
+ *
+ * NB: this function is a global function, not part of the ElastixMain
+ * class!!
+ */
+
+int
+xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
+{
+  /** The namespace of xout. */
+  using namespace xl;
+
+  set_xout( &g_xout );
+
+  return xoutSetupTargets( g_xout, g_WarningXout, g_ErrorXout,
+    g_StandardXout, g_CoutOnlyXout, g_LogOnlyXout, g_LogFileStream,
+    logfilename, setupLogging, setupCout );
+
 } // end xoutSetup()
 
 
+/**
+ * ********************* xoutSession ******************************
+ */
+
+xoutSession::xoutSession()
+{
+  this->m_PreviousThreadXout = 0;
+  this->m_Installed          = false;
+
+} // end Constructor
+
+
+xoutSession::~xoutSession()
+{
+  /** Restore the xout of the thread, before the target cells are destroyed. */
+  if( this->m_Installed )
+  {
+    xl::set_thread_xout( this->m_PreviousThreadXout );
+  }
+  if( this->m_LogFileStream.is_open() )
+  {
+    this->m_LogFileStream.close();
+  }
+
+} // end Destructor
+
+
+/**
+ * ********************* xoutSession::Setup ******************************
+ */
+
+int
+xoutSession::Setup( const char * logfilename, bool setupLogging, bool setupCout )
+{
+  if( this->m_Installed )
+  {
+    std::cerr << "ERROR: The xout session has already been set up!" << std::endl;
+    return 1;
+  }
+
+  const int returndummy = xoutSetupTargets( this->m_Xout, this->m_WarningXout,
+    this->m_ErrorXout, this->m_StandardXout, this->m_CoutOnlyXout,
+    this->m_LogOnlyXout, this->m_LogFileStream,
+    logfilename, setupLogging, setupCout );
+
+  /** Make this the xout of the calling thread. */
+  if( returndummy == 0 )
+  {
+    this->m_PreviousThreadXout = xl::get_thread_xout();
+    xl::set_thread_xout( &this->m_Xout );
+    this->m_Installed = true;
+  }
+
+  return returndummy;
+
+} // end Setup()
+
+
 /**
  * ********************* Constructor ****************************
  */
@@ -150,10 +235,14 @@ ElastixMain::ElastixMain()
 
   this->m_ResultImageContainer = 0;
 
+  this->m_ImageCache = 0;
+
   this->m_FinalTransform   = 0;
   this->m_InitialTransform = 0;
   this->m_TransformParametersMap.clear();
 
+  this->m_RandomGenerator = itk::ThreadRandomGenerator::GeneratorType::New();
+
 } // end Constructor
 
 
@@ -263,6 +352,10 @@ ElastixMain
 int
 ElastixMain::Run( void )
 {
+  /** Sessions running in parallel threads each draw from their own random
+   * number generator.
+   */
+  itk::ThreadRandomGenerator::Scope randomGeneratorScope( this->m_RandomGenerator );
 
   /** Set process properties. */
   this->SetProcessPriority();
@@ -319,7 +412,7 @@ ElastixMain::Run( void )
 
   /** Set some information in the ElastixBase. */
   this->GetElastixBase()->SetConfiguration( this->m_Configuration );
-  this->GetElastixBase()->SetComponentDatabase( this->s_CDB );
+  this->GetElastixBase()->SetComponentDatabase( this->m_ComponentDatabase );
   this->GetElastixBase()->SetDBIndex( this->m_DBIndex );
 
   /** Populate the component containers. ImageSampler is not mandatory.
@@ -378,6 +471,7 @@ ElastixMain::Run( void )
   this->GetElastixBase()->SetFixedMaskContainer( this->GetFixedMaskContainer() );
   this->GetElastixBase()->SetMovingMaskContainer( this->GetMovingMaskContainer() );
   this->GetElastixBase()->SetResultImageContainer( this->GetResultImageContainer() );
+  this->GetElastixBase()->SetImageCache( this->GetImageCache() );
 
   /** Set the initial transform, if it happens to be there. */
   this->GetElastixBase()->SetInitialTransform( this->GetInitialTransform() );
@@ -634,21 +728,18 @@ ElastixMain::InitDBIndex( void )
       }
     }
 
-    /** Load the components. */
-    if( this->s_CDB.IsNull() )
+    /** Load the components, if this has not been done already. */
+    int loadReturnCode = this->LoadComponents();
+    if( loadReturnCode != 0 )
     {
-      int loadReturnCode = this->LoadComponents();
-      if( loadReturnCode != 0 )
-      {
-        xout[ "error" ] << "Loading components failed" << std::endl;
-        return loadReturnCode;
-      }
+      xout[ "error" ] << "Loading components failed" << std::endl;
+      return loadReturnCode;
     }
 
-    if( this->s_CDB.IsNotNull() )
+    if( this->m_ComponentDatabase.IsNotNull() )
     {
       /** Get the DBIndex from the ComponentDatabase. */
-      this->m_DBIndex = this->s_CDB->GetIndex(
+      this->m_DBIndex = this->m_ComponentDatabase->GetIndex(
         this->m_FixedImagePixelType,
         this->m_FixedImageDimension,
         this->m_MovingImagePixelType,
@@ -659,7 +750,7 @@ ElastixMain::InitDBIndex( void )
         xout[ "error" ] << "Something went wrong in the ComponentDatabase" << std::endl;
         return 1;
       }
-    } // end if s_CDB!=0
+    } // end if m_ComponentDatabase!=0
 
   } // end if m_Configuration->Initialized();
   else
@@ -727,6 +818,32 @@ ElastixMain::GetTotalNumberOfElastixLevels( void )
 } // end GetTotalNumberOfElastixLevels()
 
 
+/**
+ * ********************* SetRunIdentifier ************************
+ */
+
+void
+ElastixMain::SetRunIdentifier( itk::SizeValueType runIdentifier )
+{
+  /** Call SetRunIdentifier from MyConfiguration. */
+  this->m_Configuration->SetRunIdentifier( runIdentifier );
+
+} // end SetRunIdentifier()
+
+
+/**
+ * ********************* GetRunIdentifier ************************
+ */
+
+itk::SizeValueType
+ElastixMain::GetRunIdentifier( void )
+{
+  /** Call GetRunIdentifier from MyConfiguration. */
+  return this->m_Configuration->GetRunIdentifier();
+
+} // end GetRunIdentifier()
+
+
 /**
  * ********************* LoadComponents **************************
  *
@@ -737,25 +854,34 @@ ElastixMain::GetTotalNumberOfElastixLevels( void )
 int
 ElastixMain::LoadComponents( void )
 {
-  /** Create a ComponentDatabase. */
+  /** Several sessions may start at the same time. */
+  itk::MutexLockHolder< itk::SimpleFastMutexLock > lock( g_ComponentDatabaseLock );
+
+  /** The components are loaded once, and shared by all sessions. */
   if( this->s_CDB.IsNull() )
   {
-    this->s_CDB = ComponentDatabaseType::New();
-  }
+    /** Create a ComponentDatabase and a ComponentLoader. */
+    ComponentDatabasePointer cdb    = ComponentDatabaseType::New();
+    ComponentLoaderPointer   loader = ComponentLoaderType::New();
+    loader->SetComponentDatabase( cdb );
+
+    /** Get the current program. */
+    const char * argv0
+      = this->m_Configuration->GetCommandLineArgument( "-argv0" ).c_str();
+
+    /** Load the components. Only a complete database is shared. */
+    const int loadReturnCode = loader->LoadComponents( argv0 );
+    if( loadReturnCode != 0 )
+    {
+      return loadReturnCode;
+    }
 
-  /** Create a ComponentLoader and set the database. */
-  if( this->s_ComponentLoader.IsNull() )
-  {
-    this->s_ComponentLoader = ComponentLoaderType::New();
-    this->s_ComponentLoader->SetComponentDatabase( s_CDB );
+    this->s_CDB             = cdb;
+    this->s_ComponentLoader = loader;
   }
 
-  /** Get the current program. */
-  const char * argv0
-    = this->m_Configuration->GetCommandLineArgument( "-argv0" ).c_str();
-
-  /** Load the components. */
-  return this->s_ComponentLoader->LoadComponents( argv0 );
+  this->m_ComponentDatabase = this->s_CDB;
+  return 0;
 
 } // end LoadComponents()
 
@@ -767,11 +893,13 @@ ElastixMain::LoadComponents( void )
 void
 ElastixMain::UnloadComponents( void )
 {
+  itk::MutexLockHolder< itk::SimpleFastMutexLock > lock( g_ComponentDatabaseLock );
+
   s_CDB = 0;
-  s_ComponentLoader->SetComponentDatabase( 0 );
 
   if( s_ComponentLoader )
   {
+    s_ComponentLoader->SetComponentDatabase( 0 );
     s_ComponentLoader->UnloadComponents();
   }
 
@@ -812,7 +940,7 @@ ElastixMain::CreateComponent(
   /** A pointer to the New() function. */
   PtrToCreator  testcreator = 0;
   ObjectPointer testpointer = 0;
-  testcreator = this->s_CDB->GetCreator( name,  this->m_DBIndex );
+  testcreator = this->m_ComponentDatabase->GetCreator( name,  this->m_DBIndex );
   testpointer = testcreator ? testcreator() : NULL;
   if( testpointer.IsNull() )
   {
@@ -23,6 +23,7 @@
 
 #include "elxElastixBase.h"
 #include "itkObject.h"
+#include "itkThreadRandomGenerator.h"
 
 #include <iostream>
 #include <fstream>
@@ -54,6 +55,53 @@ namespace elastix
  */
 extern int xoutSetup( const char * logfilename, bool setupLogging, bool setupCout );
 
+/**
+ * \class xoutSession
+ * \brief The logging context of one registration session.
+ *
+ * xoutSetup() configures the process wide xout, which is fine for the
+ * elastix and transformix executables, but makes it impossible to run
+ * several registrations in parallel threads of one process: they would
+ * share the log file and the "iteration" target cell. An xoutSession
+ * owns its own xout, target cells and log file, and Setup() makes it the
+ * xout of the calling thread (see xoutlibrary::set_thread_xout()). The
+ * destructor restores the previous xout of the thread.
+ *
+ * A session should be created and destroyed by the same thread, and it
+ * should outlive the ElastixMain / TransformixMain objects of the session.
+ * Threads that are started by the registration, such as the threads of a
+ * multi-threaded metric, log to the process wide xout.
+ */
+class xoutSession
+{
+public:
+
+  xoutSession();
+  ~xoutSession();
+
+  /** Configure the xout of this session like xoutSetup() does, and make it
+   * the xout of the calling thread. Returns 0 if everything went ok.
+   */
+  int Setup( const char * logfilename, bool setupLogging, bool setupCout );
+
+private:
+
+  xoutSession( const xoutSession & );  // purposely not implemented
+  void operator=( const xoutSession & ); // purposely not implemented
+
+  xl::xoutbase_type   m_Xout;
+  xl::xoutsimple_type m_WarningXout;
+  xl::xoutsimple_type m_ErrorXout;
+  xl::xoutsimple_type m_StandardXout;
+  xl::xoutsimple_type m_CoutOnlyXout;
+  xl::xoutsimple_type m_LogOnlyXout;
+  std::ofstream       m_LogFileStream;
+
+  xl::xoutbase_type * m_PreviousThreadXout;
+  bool                m_Installed;
+
+};
+
 /**
  * \class ElastixMain
  * \brief A class with all functionality to configure elastix.
@@ -186,6 +234,14 @@ public:
   itkSetObjectMacro( ResultDeformationFieldContainer, DataObjectContainerType );
   itkGetObjectMacro( ResultDeformationFieldContainer, DataObjectContainerType );
 
+  /** Set/Get the image cache. Pass the same cache to the ElastixMain objects
+   * of successive elastix levels, or of several transformix runs, to let them
+   * reuse decoded images and image pyramid levels.
+   */
+  typedef ElastixBaseType::ImageCacheType ImageCacheType;
+  itkSetObjectMacro( ImageCache, ImageCacheType );
+  itkGetObjectMacro( ImageCache, ImageCacheType );
+
   /** Set/Get the configuration object. */
   itkSetObjectMacro( Configuration, ConfigurationType );
   itkGetObjectMacro( Configuration, ConfigurationType );
@@ -232,6 +288,11 @@ public:
 
   unsigned int GetTotalNumberOfElastixLevels( void );
 
+  /** Get and Set the identifier of the registration run. */
+  void SetRunIdentifier( itk::SizeValueType runIdentifier );
+
+  itk::SizeValueType GetRunIdentifier( void );
+
   /** Returns the Index that is used in elx::ComponentDatabase. */
   itkGetConstMacro( DBIndex, DBIndexType );
 
@@ -294,6 +355,9 @@ public:
   /** GetTransformParametersMap */
   virtual ParameterMapType GetTransformParametersMap( void ) const;
 
+  /** Release the shared component database. Sessions that are still
+   * running keep using their own reference to it. Thread safe.
+   */
   static void UnloadComponents( void );
 
 protected:
@@ -328,6 +392,9 @@ protected:
   DataObjectContainerPointer m_ResultImageContainer;
   DataObjectContainerPointer m_ResultDeformationFieldContainer;
 
+  /** The image cache, shared between runs. */
+  ImageCacheType::Pointer m_ImageCache;
+
   /** A transform that is the result of registration. */
   ObjectPointer m_FinalTransform;
 
@@ -340,8 +407,28 @@ protected:
 
   FlatDirectionCosinesType m_OriginalFixedImageDirection;
 
+  /** The component database, shared by all sessions in the process. It is
+   * filled once, by the first session that needs it, and is only read
+   * after that.
+   */
   static ComponentDatabasePointer s_CDB;
   static ComponentLoaderPointer   s_ComponentLoader;
+
+  /** The component database used by this object. Holding it keeps it alive
+   * when UnloadComponents() is called while this session is running.
+   */
+  ComponentDatabasePointer m_ComponentDatabase;
+
+  /** The random number generator of this session. Run() makes it the
+   * generator of the calling thread (see itk::ThreadRandomGenerator), so
+   * that the components created by the run draw from it and not from the
+   * process wide generator. It is seeded with the RandomSeed parameter.
+   */
+  itk::ThreadRandomGenerator::GeneratorPointer m_RandomGenerator;
+
+  /** Load the components into the shared component database, unless this
+   * has been done already, and set m_ComponentDatabase. Thread safe.
+   */
   virtual int LoadComponents( void );
 
   /** InitDBIndex sets m_DBIndex by asking the ImageTypes
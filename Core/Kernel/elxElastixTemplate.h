@@ -39,9 +39,11 @@
 #include "elxTransformBase.h"
 
 #include "itkTimeProbe.h"
+#include "itkIterationInfoRecorder.h"
 
 #include <sstream>
 #include <fstream>
+#include <algorithm>
 
 /**
  * Macro that defines to functions. In the case of
@@ -138,6 +140,7 @@ public:
   typedef Superclass2::ObjectContainerType        ObjectContainerType;
   typedef Superclass2::DataObjectContainerType    DataObjectContainerType;
   typedef Superclass2::FileNameContainerType      FileNameContainerType;
+  typedef Superclass2::ProfilerType               ProfilerType;
   typedef Superclass2::ObjectContainerPointer     ObjectContainerPointer;
   typedef Superclass2::DataObjectContainerPointer DataObjectContainerPointer;
   typedef Superclass2::FileNameContainerPointer   FileNameContainerPointer;
@@ -383,6 +386,39 @@ protected:
 
   std::ofstream m_IterationInfoFile;
 
+  /** Writes the iteration info to the IterationInfoFile from a background
+   * thread, if AsynchronousIterationInfo is true. It is declared after the
+   * file, so that it is stopped before the file is destroyed.
+   */
+  itk::IterationInfoRecorder::Pointer m_IterationInfoRecorder;
+  bool                                m_AsynchronousIterationInfo;
+
+  /** Only the iteration info of every m_IterationInfoInterval-th iteration
+   * is written.
+   */
+  unsigned int m_IterationInfoInterval;
+
+  /** Start the measurement of the time spent outside the cost function in
+   * the next iteration, which is recorded as the OptimizerUpdate phase.
+   */
+  virtual void StartProfilingIteration( void );
+
+  /** Record the OptimizerUpdate phase of the current iteration. */
+  virtual void StopProfilingIteration( void );
+
+  /** Write the profile of the current resolution to the output directory,
+   * next to the IterationInfo file, and print a summary.
+   */
+  virtual void WriteProfile( void );
+
+  /** The clocks, and the accumulated cost function and parameter estimation
+   * times at the start of the current iteration, used for profiling.
+   */
+  double                        m_ProfileIterationWallStart;
+  double                        m_ProfileIterationCPUStart;
+  ProfilerType::PhaseRecordType m_ProfileMetricAtIterationStart;
+  ProfilerType::PhaseRecordType m_ProfileEstimationAtIterationStart;
+
   /** Used by the callback functions, BeforeEachResolution() etc.).
    * This method calls a function in each component, in the following order:
    * \li Registration
@@ -60,6 +60,19 @@ ElastixTemplate< TFixedImage, TMovingImage >
   /** Initialize the this->m_IterationCounter. */
   this->m_IterationCounter = 0;
 
+  /** Initialize the iteration info settings. */
+  this->m_IterationInfoRecorder     = itk::IterationInfoRecorder::New();
+  this->m_AsynchronousIterationInfo = false;
+  this->m_IterationInfoInterval     = 1;
+
+  /** Initialize the profiling variables. */
+  this->m_ProfileIterationWallStart = 0.0;
+  this->m_ProfileIterationCPUStart  = 0.0;
+  this->m_ProfileMetricAtIterationStart.st_NumberOfCalls = 0;
+  this->m_ProfileMetricAtIterationStart.st_WallTime      = 0.0;
+  this->m_ProfileMetricAtIterationStart.st_CPUTime       = 0.0;
+  this->m_ProfileEstimationAtIterationStart              = this->m_ProfileMetricAtIterationStart;
+
   /** Initialize CurrentTransformParameterFileName. */
   this->m_CurrentTransformParameterFileName = "";
   this->m_TransformParametersMap.clear();
@@ -261,7 +274,8 @@ ElastixTemplate< TFixedImage, TMovingImage >
   {
     this->SetFixedImageContainer(
       FixedImageLoaderType::GenerateImageContainer(
-      this->GetFixedImageFileNameContainer(), "Fixed Image", useDirCos, &fixDirCos ) );
+      this->GetFixedImageFileNameContainer(), "Fixed Image", useDirCos, &fixDirCos,
+      this->GetImageCache() ) );
     this->SetOriginalFixedImageDirection( fixDirCos );
   }
   else
@@ -281,19 +295,22 @@ ElastixTemplate< TFixedImage, TMovingImage >
   {
     this->SetMovingImageContainer(
       MovingImageLoaderType::GenerateImageContainer(
-      this->GetMovingImageFileNameContainer(), "Moving Image", useDirCos ) );
+      this->GetMovingImageFileNameContainer(), "Moving Image", useDirCos, NULL,
+      this->GetImageCache() ) );
   }
   if( this->GetFixedMask() == 0 )
   {
     this->SetFixedMaskContainer(
       FixedMaskLoaderType::GenerateImageContainer(
-      this->GetFixedMaskFileNameContainer(), "Fixed Mask", useDirCos ) );
+      this->GetFixedMaskFileNameContainer(), "Fixed Mask", useDirCos, NULL,
+      this->GetImageCache() ) );
   }
   if( this->GetMovingMask() == 0 )
   {
     this->SetMovingMaskContainer(
       MovingMaskLoaderType::GenerateImageContainer(
-      this->GetMovingMaskFileNameContainer(), "Moving Mask", useDirCos ) );
+      this->GetMovingMaskFileNameContainer(), "Moving Mask", useDirCos, NULL,
+      this->GetImageCache() ) );
   }
 
   /** Print the time spent on reading images. */
@@ -399,7 +416,8 @@ ElastixTemplate< TFixedImage, TMovingImage >
     {
       this->SetMovingImageContainer(
         MovingImageLoaderType::GenerateImageContainer(
-        this->GetMovingImageFileNameContainer(), "Input Image", useDirCos ) );
+        this->GetMovingImageFileNameContainer(), "Input Image", useDirCos, NULL,
+        this->GetImageCache() ) );
     } // end if !moving image
 
     /** Tell the user. */
@@ -653,14 +671,28 @@ ElastixTemplate< TFixedImage, TMovingImage >
   /** Print the current resolution. */
   elxout << "\nResolution: " << level << std::endl;
 
+  /** Clear the profile of this resolution. */
+  if( this->GetUseProfiling() )
+  {
+    this->GetProfiler()->StartResolution( level );
+  }
+
   /** Create a TransformParameter-file for the current resolution. */
   bool writeIterationInfo = true;
   this->GetConfiguration()->ReadParameter( writeIterationInfo,
     "WriteIterationInfo", 0, false );
+  this->m_IterationInfoInterval = 1;
+  this->GetConfiguration()->ReadParameter( this->m_IterationInfoInterval,
+    "IterationInfoInterval", 0, false );
+  this->m_IterationInfoInterval = std::max( this->m_IterationInfoInterval, 1u );
+  this->m_AsynchronousIterationInfo = false;
+  this->GetConfiguration()->ReadParameter( this->m_AsynchronousIterationInfo,
+    "AsynchronousIterationInfo", 0, false );
   if( writeIterationInfo )
   {
     this->OpenIterationInfoFile();
   }
+  this->GetIterationInfo().SetSuppressed( false );
 
   /** Call all the BeforeEachResolution() functions. */
   this->BeforeEachResolutionBase();
@@ -681,6 +713,7 @@ ElastixTemplate< TFixedImage, TMovingImage >
    */
   this->m_IterationTimer.Reset();
   this->m_IterationTimer.Start();
+  this->StartProfilingIteration();
 
 } // end BeforeEachResolution()
 
@@ -709,11 +742,21 @@ ElastixTemplate< TFixedImage, TMovingImage >
     << " s.\n";
   elxout << std::setprecision( this->GetDefaultOutputPrecision() );
 
+  /** Write the profile of this resolution. */
+  if( this->GetUseProfiling() )
+  {
+    this->WriteProfile();
+  }
+
   /** Call all the AfterEachResolution() functions. */
   this->AfterEachResolutionBase();
   CallInEachComponent( &BaseComponentType::AfterEachResolutionBase );
   CallInEachComponent( &BaseComponentType::AfterEachResolution );
 
+  /** Write the remaining iteration info of this resolution. */
+  this->m_IterationInfoRecorder->Stop();
+  this->GetIterationInfo().SetSuppressed( false );
+
   /** Create a TransformParameter-file for the current resolution. */
   bool writeTransformParameterEachResolution = false;
   this->GetConfiguration()->ReadParameter( writeTransformParameterEachResolution,
@@ -753,9 +796,19 @@ ElastixTemplate< TFixedImage, TMovingImage >
 ::AfterEachIteration( void )
 {
   /** Write the headers of the columns that are printed each iteration. */
+  const bool asynchronous = this->m_IterationInfoRecorder->GetStarted();
   if( this->m_IterationCounter == 0 )
   {
-    xout[ "iteration" ][ "WriteHeaders" ];
+    if( asynchronous )
+    {
+      std::string headers;
+      this->GetIterationInfo().GetHeaderRow( headers );
+      this->m_IterationInfoRecorder->Record( headers );
+    }
+    else
+    {
+      xout[ "iteration" ][ "WriteHeaders" ];
+    }
   }
 
   /** Call all the AfterEachIteration() functions. */
@@ -769,9 +822,23 @@ ElastixTemplate< TFixedImage, TMovingImage >
   /** Time in this iteration. */
   this->m_IterationTimer.Stop();
   xout[ "iteration" ][ "Time[ms]" ] << this->m_IterationTimer.GetMean() * 1000.0;
+  this->StopProfilingIteration();
 
-  /** Write the iteration info of this iteration. */
-  xout[ "iteration" ].WriteBufferedData();
+  /** Write the iteration info of this iteration, if it is not skipped. */
+  if( this->m_IterationCounter % this->m_IterationInfoInterval != 0 )
+  {
+    this->GetIterationInfo().DiscardBufferedData();
+  }
+  else if( asynchronous )
+  {
+    std::string row;
+    this->GetIterationInfo().GetBufferedRow( row );
+    this->m_IterationInfoRecorder->Record( row );
+  }
+  else
+  {
+    xout[ "iteration" ].WriteBufferedData();
+  }
 
   /** Create a TransformParameter-file for the current iteration. */
   bool writeTansformParametersThisIteration = false;
@@ -818,9 +885,14 @@ ElastixTemplate< TFixedImage, TMovingImage >
   /** Count the number of iterations. */
   this->m_IterationCounter++;
 
+  /** Do not format the iteration info of the next iteration, if it is skipped. */
+  this->GetIterationInfo().SetSuppressed(
+    this->m_IterationCounter % this->m_IterationInfoInterval != 0 );
+
   /** Start timer for next iteration. */
   this->m_IterationTimer.Reset();
   this->m_IterationTimer.Start();
+  this->StartProfilingIteration();
 
 } // end AfterEachIteration()
 
@@ -1189,6 +1261,7 @@ ElastixTemplate< TFixedImage, TMovingImage >
   using namespace xl;
 
   /** Remove the current iteration info output file, if any. */
+  this->m_IterationInfoRecorder->Stop();
   xout[ "iteration" ].RemoveOutput( "IterationInfoFile" );
 
   if( this->m_IterationInfoFile.is_open() )
@@ -1211,6 +1284,12 @@ ElastixTemplate< TFixedImage, TMovingImage >
   {
     xout[ "error" ] << "ERROR: File \"" << fileName << "\" could not be opened!" << std::endl;
   }
+  else if( this->m_AsynchronousIterationInfo )
+  {
+    /** Let the recorder write the iteration info to this file. */
+    this->m_IterationInfoRecorder->SetOutput( &( this->m_IterationInfoFile ) );
+    this->m_IterationInfoRecorder->Start();
+  }
   else
   {
     /** Add this file to the list of outputs of xout["iteration"]. */
@@ -1220,6 +1299,118 @@ ElastixTemplate< TFixedImage, TMovingImage >
 } // end OpenIterationInfoFile()
 
 
+/**
+ * ************** StartProfilingIteration *********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ElastixTemplate< TFixedImage, TMovingImage >
+::StartProfilingIteration( void )
+{
+  if( !this->GetUseProfiling() ) { return; }
+
+  this->m_ProfileIterationWallStart     = ProfilerType::GetWallClock();
+  this->m_ProfileIterationCPUStart      = ProfilerType::GetThreadCPUClock();
+  this->m_ProfileMetricAtIterationStart = this->GetProfiler()->GetPhaseRecord(
+    this->GetProfiler()->GetCurrentResolution(), ProfilerType::MetricEvaluation );
+  this->m_ProfileEstimationAtIterationStart = this->GetProfiler()->GetPhaseRecord(
+    this->GetProfiler()->GetCurrentResolution(), ProfilerType::ParameterEstimation );
+
+} // end StartProfilingIteration()
+
+
+/**
+ * ************** StopProfilingIteration *********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ElastixTemplate< TFixedImage, TMovingImage >
+::StopProfilingIteration( void )
+{
+  if( !this->GetUseProfiling() ) { return; }
+
+  /** The time of this iteration minus the time spent in the cost function,
+   * and in the parameter estimation of the first iteration. All are measured
+   * on this thread, so that also the CPU times match.
+   */
+  const double wallTime = ProfilerType::GetWallClock() - this->m_ProfileIterationWallStart;
+  const double cpuTime  = ProfilerType::GetThreadCPUClock() - this->m_ProfileIterationCPUStart;
+  const ProfilerType::PhaseRecordType metric = this->GetProfiler()->GetPhaseRecord(
+    this->GetProfiler()->GetCurrentResolution(), ProfilerType::MetricEvaluation );
+  const ProfilerType::PhaseRecordType estimation = this->GetProfiler()->GetPhaseRecord(
+    this->GetProfiler()->GetCurrentResolution(), ProfilerType::ParameterEstimation );
+  const double excludedWallTime = metric.st_WallTime - this->m_ProfileMetricAtIterationStart.st_WallTime
+    + estimation.st_WallTime - this->m_ProfileEstimationAtIterationStart.st_WallTime;
+  const double excludedCPUTime  = metric.st_CPUTime - this->m_ProfileMetricAtIterationStart.st_CPUTime
+    + estimation.st_CPUTime - this->m_ProfileEstimationAtIterationStart.st_CPUTime;
+
+  this->GetProfiler()->AddTime( ProfilerType::OptimizerUpdate,
+    std::max( 0.0, wallTime - excludedWallTime ),
+    std::max( 0.0, cpuTime - excludedCPUTime ) );
+
+} // end StopProfilingIteration()
+
+
+/**
+ * ************** WriteProfile *********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ElastixTemplate< TFixedImage, TMovingImage >
+::WriteProfile( void )
+{
+  const unsigned int level = this->GetProfiler()->GetCurrentResolution();
+
+  /** Read the format of the profile. */
+  std::string profileFormat = "csv";
+  this->GetConfiguration()->ReadParameter( profileFormat,
+    "ProfileFormat", 0, false );
+  const bool writeJSON = ( profileFormat == "json" );
+
+  /** Create the Profile filename for this resolution. */
+  std::ostringstream makeFileName( "" );
+  makeFileName << this->m_Configuration->GetCommandLineArgument( "-out" )
+               << "Profile."
+               << this->m_Configuration->GetElastixLevel()
+               << ".R" << level
+               << ( writeJSON ? ".json" : ".csv" );
+  std::string fileName = makeFileName.str();
+
+  /** Write the profile. */
+  std::ofstream profileFile( fileName.c_str() );
+  if( !profileFile.is_open() )
+  {
+    xout[ "error" ] << "ERROR: File \"" << fileName << "\" could not be opened!" << std::endl;
+  }
+  else if( writeJSON )
+  {
+    this->GetProfiler()->WriteJSON( profileFile, level );
+  }
+  else
+  {
+    this->GetProfiler()->WriteCSV( profileFile, level );
+  }
+
+  /** Print a summary. */
+  elxout << std::setprecision( 3 );
+  elxout << "Profile of resolution " << level << " (wall / CPU time):\n";
+  for( unsigned int i = 0; i < ProfilerType::NumberOfPhases; ++i )
+  {
+    const ProfilerType::PhaseType       phase  = static_cast< ProfilerType::PhaseType >( i );
+    const ProfilerType::PhaseRecordType record = this->GetProfiler()->GetPhaseRecord( level, phase );
+    if( record.st_NumberOfCalls == 0 ) { continue; }
+    elxout << "  " << ProfilerType::GetPhaseName( phase ) << ": "
+           << record.st_WallTime << " / " << record.st_CPUTime << " s, in "
+           << record.st_NumberOfCalls << " calls.\n";
+  }
+  elxout << std::setprecision( this->GetDefaultOutputPrecision() );
+
+} // end WriteProfile()
+
+
 /**
  * ************** GetOriginalFixedImageDirection *********************
  * Determine the original fixed image direction (it might have been
@@ -104,7 +104,7 @@ TransformixMain::Run( void )
 
   /** Set some information in the ElastixBase. */
   this->GetElastixBase()->SetConfiguration( this->m_Configuration );
-  this->GetElastixBase()->SetComponentDatabase( this->s_CDB );
+  this->GetElastixBase()->SetComponentDatabase( this->m_ComponentDatabase );
   this->GetElastixBase()->SetDBIndex( this->m_DBIndex );
 
   /** Populate the component containers. No default is specified for the Transform. */
@@ -131,6 +131,7 @@ TransformixMain::Run( void )
    */
   this->GetElastixBase()->SetMovingImageContainer(
     this->GetMovingImageContainer() );
+  this->GetElastixBase()->SetImageCache( this->GetImageCache() );
 
   /** Set the initial transform, if it happens to be there
   * \todo: Does this make sense for transformix?
@@ -285,21 +286,18 @@ TransformixMain::InitDBIndex( void )
       }
     }
 
-    /** Load the components. */
-    if( this->s_CDB.IsNull() )
+    /** Load the components, if this has not been done already. */
+    int loadReturnCode = this->LoadComponents();
+    if( loadReturnCode != 0 )
     {
-      int loadReturnCode = this->LoadComponents();
-      if( loadReturnCode != 0 )
-      {
-        xl::xout[ "error" ] << "Loading components failed" << std::endl;
-        return loadReturnCode;
-      }
+      xl::xout[ "error" ] << "Loading components failed" << std::endl;
+      return loadReturnCode;
     }
 
-    if( this->s_CDB.IsNotNull() )
+    if( this->m_ComponentDatabase.IsNotNull() )
     {
       /** Get the DBIndex from the ComponentDatabase. */
-      this->m_DBIndex = this->s_CDB->GetIndex(
+      this->m_DBIndex = this->m_ComponentDatabase->GetIndex(
         this->m_FixedImagePixelType,
         this->m_FixedImageDimension,
         this->m_MovingImagePixelType,
@@ -310,7 +308,7 @@ TransformixMain::InitDBIndex( void )
         xl::xout[ "error" ] << "Something went wrong in the ComponentDatabase." << std::endl;
         return 1;
       }
-    } //end if s_CDB!=0
+    } //end if m_ComponentDatabase!=0
 
   } // end if m_Configuration->Initialized();
   else
@@ -59,6 +59,7 @@ main( int argc, char ** argv )
   typedef ElastixMainType::ObjectPointer              ObjectPointer;
   typedef ElastixMainType::DataObjectContainerPointer DataObjectContainerPointer;
   typedef ElastixMainType::FlatDirectionCosinesType   FlatDirectionCosinesType;
+  typedef ElastixMainType::ImageCacheType             ImageCacheType;
 
   typedef ElastixMainType::ArgumentMapType ArgumentMapType;
   typedef ArgumentMapType::value_type      ArgumentMapEntryType;
@@ -87,6 +88,11 @@ main( int argc, char ** argv )
   std::string                outFolder        = "";
   std::string                logFileName      = "";
 
+  /** The image cache, shared by the registrations, and the identifier of
+   * this run in it. */
+  ImageCacheType::Pointer  imageCache    = ImageCacheType::New();
+  const itk::SizeValueType runIdentifier = imageCache->GetNewRunIdentifier();
+
   /** Put command line parameters into parameterFileList. */
   for( unsigned int i = 1; static_cast< long >( i ) < ( argc - 1 ); i += 2 )
   {
@@ -228,6 +234,7 @@ main( int argc, char ** argv )
 
     /** Set stuff we get from a former registration. */
     elastices[ i ]->SetInitialTransform( transform );
+    elastices[ i ]->SetImageCache( imageCache );
     elastices[ i ]->SetFixedImageContainer( fixedImageContainer );
     elastices[ i ]->SetMovingImageContainer( movingImageContainer );
     elastices[ i ]->SetFixedMaskContainer( fixedMaskContainer );
@@ -237,6 +244,7 @@ main( int argc, char ** argv )
     /** Set the current elastix-level. */
     elastices[ i ]->SetElastixLevel( i );
     elastices[ i ]->SetTotalNumberOfElastixLevels( nrOfParameterFiles );
+    elastices[ i ]->SetRunIdentifier( runIdentifier );
 
     /** Delete the previous ParameterFileName. */
     if( argMap.count( "-p" ) )
@@ -318,6 +326,7 @@ main( int argc, char ** argv )
   movingImageContainer = 0;
   fixedMaskContainer   = 0;
   movingMaskContainer  = 0;
+  imageCache           = 0;
 
   /** Close the modules. */
   ElastixMainType::UnloadComponents();
@@ -147,6 +147,7 @@ ELASTIX::RegisterImages(
   typedef ElastixMainType::DataObjectContainerType    DataObjectContainerType;
   typedef ElastixMainType::DataObjectContainerPointer DataObjectContainerPointer;
   typedef ElastixMainType::FlatDirectionCosinesType   FlatDirectionCosinesType;
+  typedef ElastixMainType::ImageCacheType             ImageCacheType;
 
   typedef ElastixMainType::ArgumentMapType ArgumentMapType;
   typedef ArgumentMapType::value_type      ArgumentMapEntryType;
@@ -158,7 +159,10 @@ ELASTIX::RegisterImages(
   // Clear output transform parameters
   this->m_TransformParametersList.clear();
 
-  /** Some declarations and initialisations. */
+  /** Some declarations and initialisations. The xout session is declared
+   * first, so that it outlives the ElastixMain objects.
+   */
+  elx::xoutSession      xoutSession;
   ElastixMainVectorType elastices;
 
   //ObjectPointer              transform = 0;
@@ -178,6 +182,11 @@ ELASTIX::RegisterImages(
   std::string                value;
   unsigned long              nrOfParameterFiles = parameterMaps.size();
 
+  /** The image cache, shared by the registrations, and the identifier of
+   * this run in it. */
+  ImageCacheType::Pointer  imageCache    = ImageCacheType::New();
+  const itk::SizeValueType runIdentifier = imageCache->GetNewRunIdentifier();
+
   /** Setup the argumentMap for output path. */
   if( !outputPath.empty() )
   {
@@ -242,7 +251,7 @@ ELASTIX::RegisterImages(
   argMap.insert( ArgumentMapEntryType( "-argv0", "elastix" ) );
 
   /** Setup xout. */
-  returndummy = elx::xoutSetup( logFileName.c_str(), performLogging, performCout );
+  returndummy = xoutSession.Setup( logFileName.c_str(), performLogging, performCout );
   if( returndummy && performCout )
   {
     if( performCout )
@@ -299,6 +308,7 @@ ELASTIX::RegisterImages(
 
     /** Set stuff we get from a former registration. */
     elastices[ i ]->SetInitialTransform( transform );
+    elastices[ i ]->SetImageCache( imageCache );
     elastices[ i ]->SetFixedImageContainer( fixedImageContainer );
     elastices[ i ]->SetMovingImageContainer( movingImageContainer );
     elastices[ i ]->SetFixedMaskContainer( fixedMaskContainer );
@@ -309,6 +319,7 @@ ELASTIX::RegisterImages(
     /** Set the current elastix-level. */
     elastices[ i ]->SetElastixLevel( i );
     elastices[ i ]->SetTotalNumberOfElastixLevels( nrOfParameterFiles );
+    elastices[ i ]->SetRunIdentifier( runIdentifier );
 
     /** Delete the previous ParameterFileName. */
     if( argMap.count( "-p" ) )
@@ -403,6 +414,7 @@ ELASTIX::RegisterImages(
   movingImageContainer = 0;
   fixedMaskContainer   = 0;
   movingMaskContainer  = 0;
+  imageCache           = 0;
   resultImageContainer = 0;
 
   /** Close the modules. */
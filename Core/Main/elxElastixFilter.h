@@ -23,6 +23,7 @@
 #include "elxElastixMain.h"
 #include "elxParameterObject.h"
 #include "elxPixelType.h"
+#include "itkRegistrationProfiler.h"
 
 /**
  * \class ElastixFilter
@@ -57,6 +58,8 @@ public:
   typedef ElastixMainType::ArgumentMapType          ArgumentMapType;
   typedef ArgumentMapType::value_type               ArgumentMapEntryType;
   typedef ElastixMainType::FlatDirectionCosinesType FlatDirectionCosinesType;
+  typedef itk::RegistrationProfiler                 ProfilerType;
+  typedef std::vector< ProfilerType::Pointer >      ProfilerVectorType;
 
   typedef ElastixMainType::DataObjectContainerType           DataObjectContainerType;
   typedef ElastixMainType::DataObjectContainerPointer        DataObjectContainerPointer;
@@ -165,6 +168,22 @@ public:
   itkSetMacro( NumberOfThreads, int );
   itkGetMacro( NumberOfThreads, int );
 
+  /** Set/Get the image cache that is shared by the registrations of the
+   * parameter maps, see the UseImageCache parameter of the generic pyramids.
+   * If no cache is set, a cache is created for each update of the filter.
+   * Set the same cache in several filters to share decoded images and
+   * pyramid levels between them.
+   */
+  typedef ElastixMainType::ImageCacheType ImageCacheType;
+  itkSetObjectMacro( ImageCache, ImageCacheType );
+  itkGetObjectMacro( ImageCache, ImageCacheType );
+
+  /** Get the profilers of the registrations, one per parameter map. They
+   * contain the time spent in the phases of each resolution, and are only
+   * filled when the parameter map sets (Profiling "true").
+   */
+  itkGetConstReferenceMacro( Profilers, ProfilerVectorType );
+
 protected:
 
   ElastixFilter( void );
@@ -205,6 +224,10 @@ private:
 
   unsigned int m_InputUID;
 
+  ProfilerVectorType m_Profilers;
+
+  ImageCacheType::Pointer m_ImageCache;
+
 };
 
 } // namespace elx
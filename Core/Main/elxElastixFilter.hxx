@@ -47,6 +47,7 @@ ElastixFilter< TFixedImage, TMovingImage >
   this->m_LogToFile    = false;
 
   this->m_NumberOfThreads = 0;
+  this->m_ImageCache      = 0;
 
   ParameterObjectPointer defaultParameterObject = ParameterObject::New();
   defaultParameterObject->AddParameterMap( ParameterObject::GetDefaultParameterMap( "translation" ) );
@@ -198,13 +199,23 @@ ElastixFilter< TFixedImage, TMovingImage >
     argumentMap.insert( ArgumentMapEntryType( "-threads", ParameterObjectType::ToString( this->m_NumberOfThreads ) ) );
   }
 
-  // Setup xout
-  if( elx::xoutSetup( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() ) )
+  // Setup xout for this thread only, so that filters can run in parallel
+  elx::xoutSession xoutSession;
+  if( xoutSession.Setup( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() ) )
   {
     itkExceptionMacro( "Error while setting up xout" );
   }
 
+  // Share decoded images and pyramid levels between the registrations
+  ImageCacheType::Pointer imageCache = this->m_ImageCache;
+  if( imageCache.IsNull() )
+  {
+    imageCache = ImageCacheType::New();
+  }
+  const itk::SizeValueType runIdentifier = imageCache->GetNewRunIdentifier();
+
   // Run the (possibly multiple) registration(s)
+  this->m_Profilers.clear();
   for( unsigned int i = 0; i < parameterMapVector.size(); ++i )
   {
     // Set image dimension from input images (overrides user settings)
@@ -227,9 +238,11 @@ ElastixFilter< TFixedImage, TMovingImage >
     // Set elastix levels
     elastix->SetElastixLevel( i );
     elastix->SetTotalNumberOfElastixLevels( parameterMapVector.size() );
+    elastix->SetRunIdentifier( runIdentifier );
 
     // Set stuff we get from a previous registration
     elastix->SetInitialTransform( transform );
+    elastix->SetImageCache( imageCache );
     elastix->SetFixedImageContainer( fixedImageContainer );
     elastix->SetMovingImageContainer( movingImageContainer );
     elastix->SetFixedMaskContainer( fixedMaskContainer );
@@ -263,6 +276,7 @@ ElastixFilter< TFixedImage, TMovingImage >
     fixedImageOriginalDirection = elastix->GetOriginalFixedImageDirectionFlat();
 
     transformParameterMapVector.push_back( elastix->GetTransformParametersMap() );
+    this->m_Profilers.push_back( elastix->GetElastixBase()->GetProfiler() );
     if( i > 0 )
     {
       transformParameterMapVector[ i ][ "InitialTransformParametersFileName" ]
@@ -133,6 +133,14 @@ public:
   itkGetConstMacro( LogToFile, bool );
   itkBooleanMacro( LogToFile );
 
+  /** Set/Get the image cache. Set the same cache in several filters, or in
+   * an ElastixFilter and a TransformixFilter, to let them reuse images that
+   * were read from file. Default: NULL, no cache.
+   */
+  typedef TransformixMainType::ImageCacheType ImageCacheType;
+  itkSetObjectMacro( ImageCache, ImageCacheType );
+  itkGetObjectMacro( ImageCache, ImageCacheType );
+
   /** To support outputs of different types (i.e. ResultImage and ResultDeformationField)
    * MakeOutput from itk::ImageSource< TOutputImage > needs to be overridden.
    */
@@ -176,6 +184,8 @@ private:
   bool m_LogToConsole;
   bool m_LogToFile;
 
+  ImageCacheType::Pointer m_ImageCache;
+
 };
 
 } // namespace elx
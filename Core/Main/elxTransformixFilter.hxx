@@ -46,6 +46,8 @@ TransformixFilter< TMovingImage >
   this->m_LogToConsole = false;
   this->m_LogToFile    = false;
 
+  this->m_ImageCache = 0;
+
 } // end Constructor
 
 
@@ -156,14 +158,16 @@ TransformixFilter< TMovingImage >
     }
   }
 
-  // Setup xout
-  if( elx::xoutSetup( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() ) )
+  // Setup xout for this thread only, so that filters can run in parallel
+  elx::xoutSession xoutSession;
+  if( xoutSession.Setup( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() ) )
   {
     itkExceptionMacro( "Error while setting up xout" );
   }
 
   // Instantiate transformix
   TransformixMainPointer transformix = TransformixMainType::New();
+  transformix->SetImageCache( this->m_ImageCache );
 
   // Setup transformix for warping input image if given
   DataObjectContainerPointer inputImageContainer = 0;
@@ -93,7 +93,10 @@ TRANSFORMIX::TransformImage(
   typedef ElastixMainType::DataObjectContainerType    DataObjectContainerType;
   typedef ElastixMainType::DataObjectContainerPointer DataObjectContainerPointer;
 
-  /** Declare an instance of the Transformix class. */
+  /** Declare an instance of the Transformix class, and the xout session,
+   * which should outlive it.
+   */
+  elx::xoutSession       xoutSession;
   TransformixMainPointer transformix;
 
   DataObjectContainerPointer movingImageContainer = 0;
@@ -173,7 +176,7 @@ TRANSFORMIX::TransformImage(
   argMap.insert( ArgumentMapEntryType( "-argv0", "transformix" ) );
 
   /** Setup xout. */
-  int returndummy2 = elx::xoutSetup( logFileName.c_str(), performLogging, performCout );
+  int returndummy2 = xoutSession.Setup( logFileName.c_str(), performLogging, performCout );
   if( returndummy2 && performCout )
   {
     if( performCout )
@@ -29,6 +29,9 @@
 // Multi-threading using ITK threads
 #include "itkMultiThreader.h"
 
+// The vector operations shared by the optimizers
+#include "itkParameterVectorOperations.h"
+
 // Multi-threading using OpenMP
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
@@ -244,6 +247,219 @@ public:
 
 //-------------------------------------------------------------------------------------
 
+/** The vector operations of one iteration of each optimizer, written as
+ * plain serial loops (the reference), and with the ParameterVectorOperations
+ * using a given number of threads.
+ */
+
+typedef itk::ParameterVectorOperations VectorOperations;
+typedef VectorOperations::VectorType   VectorType;
+
+/** Gradient descent, ASGD: x = x - a * g */
+void
+GradientDescentStep( const bool reference, const VectorType & g, VectorType & x,
+  const itk::ThreadIdType threads )
+{
+  if( reference )
+  {
+    for( unsigned int j = 0; j < x.GetSize(); ++j ) { x[ j ] = x[ j ] - 0.01 * g[ j ]; }
+  }
+  else { VectorOperations::LinearCombination( 1.0, x, -0.01, g, x, threads ); }
+}
+
+
+/** RSGDEachParameterApart: x = x + f .* g */
+void
+RSGDStep( const bool reference, const VectorType & f, const VectorType & g,
+  VectorType & x, const itk::ThreadIdType threads )
+{
+  if( reference )
+  {
+    for( unsigned int j = 0; j < x.GetSize(); ++j ) { x[ j ] = x[ j ] + f[ j ] * g[ j ]; }
+  }
+  else { VectorOperations::MultiplyAdd( x, f, g, x, threads ); }
+}
+
+
+/** Conjugate gradient, Polak-Ribiere: d = -g + beta * d */
+double
+ConjugateGradientStep( const bool reference, const VectorType & g,
+  const VectorType & gp, VectorType & d, const itk::ThreadIdType threads )
+{
+  double beta = 0.0;
+  if( reference )
+  {
+    double num = 0.0;
+    double den = 0.0;
+    for( unsigned int j = 0; j < g.GetSize(); ++j )
+    {
+      num += g[ j ] * ( g[ j ] - gp[ j ] );
+      den += gp[ j ] * gp[ j ];
+    }
+    beta = num / den;
+    for( unsigned int j = 0; j < g.GetSize(); ++j ) { d[ j ] = -g[ j ] + beta * d[ j ]; }
+  }
+  else
+  {
+    beta = VectorOperations::DotDifference( g, g, gp, threads )
+      / VectorOperations::SquaredNorm( gp, threads );
+    VectorOperations::LinearCombination( -1.0, g, beta, d, d, threads );
+  }
+  return beta;
+}
+
+
+/** L-BFGS two-loop recursion: d = -H g */
+void
+LBFGSStep( const bool reference, const VectorType & g,
+  const std::vector< VectorType > & S, const std::vector< VectorType > & Y,
+  const std::vector< double > & rho, VectorType & d, const itk::ThreadIdType threads )
+{
+  const unsigned int    m = S.size();
+  std::vector< double > alpha( m );
+  if( reference ) { d = -g; }
+  else { VectorOperations::ScaledCopy( -1.0, g, d, threads ); }
+  for( int i = m - 1; i >= 0; --i )
+  {
+    if( reference )
+    {
+      alpha[ i ] = rho[ i ] * inner_product( S[ i ], d );
+      for( unsigned int j = 0; j < d.GetSize(); ++j ) { d[ j ] -= alpha[ i ] * Y[ i ][ j ]; }
+    }
+    else
+    {
+      alpha[ i ] = rho[ i ] * VectorOperations::Dot( S[ i ], d, threads );
+      VectorOperations::Axpy( -alpha[ i ], Y[ i ], d, threads );
+    }
+  }
+  for( unsigned int i = 0; i < m; ++i )
+  {
+    if( reference )
+    {
+      const double beta = rho[ i ] * inner_product( Y[ i ], d );
+      for( unsigned int j = 0; j < d.GetSize(); ++j ) { d[ j ] += ( alpha[ i ] - beta ) * S[ i ][ j ]; }
+    }
+    else
+    {
+      const double beta = rho[ i ] * VectorOperations::Dot( Y[ i ], d, threads );
+      VectorOperations::Axpy( alpha[ i ] - beta, S[ i ], d, threads );
+    }
+  }
+}
+
+
+/** Compare two vectors with a relative tolerance. */
+bool
+AreEqual( const VectorType & a, const VectorType & b, const double tolerance )
+{
+  const double diff = ( a - b ).inf_norm();
+  return diff <= tolerance * ( 1.0 + b.inf_norm() );
+}
+
+
+/** Time and check the vector operations of all optimizers. */
+int
+TestParameterVectorOperations( void )
+{
+  std::cout << "ParameterVectorOperations, per optimizer iteration:\n" << std::endl;
+  const itk::ThreadIdType threads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  std::vector< unsigned int > arraySizes;
+  arraySizes.push_back( 1e3 ); arraySizes.push_back( 1e5 ); arraySizes.push_back( 1e6 );
+  std::vector< unsigned int > repetitions;
+  repetitions.push_back( 1e4 ); repetitions.push_back( 1e2 ); repetitions.push_back( 1e1 );
+
+  for( unsigned int s = 0; s < arraySizes.size(); ++s )
+  {
+    const unsigned int n = arraySizes[ s ];
+    std::cout << "Array size = " << n << std::endl;
+    itk::TimeProbesCollectorBase timeCollector;
+    const unsigned int rep = repetitions[ s ];
+
+    /** Smooth test vectors, and an L-BFGS memory of 5. */
+    VectorType g( n ), gp( n ), f( n ), x0( n ), d0( n );
+    for( unsigned int j = 0; j < n; ++j )
+    {
+      g[ j ] = vcl_sin( 0.001 * j );  gp[ j ] = vcl_cos( 0.002 * j );
+      f[ j ] = 0.1 + 0.01 * ( j % 7 ); x0[ j ] = 1.0 + 0.5 * vcl_sin( 0.01 * j );
+      d0[ j ] = -gp[ j ];
+    }
+    std::vector< VectorType > S( 5, VectorType( n ) ), Y( 5, VectorType( n ) );
+    std::vector< double >     rho( 5 );
+    for( unsigned int i = 0; i < 5; ++i )
+    {
+      for( unsigned int j = 0; j < n; ++j )
+      {
+        S[ i ][ j ] = 0.01 * vcl_sin( 0.003 * ( i + 1 ) * j );
+        Y[ i ][ j ] = S[ i ][ j ] + 0.001 * vcl_cos( 0.005 * j );
+      }
+      rho[ i ] = 1.0 / inner_product( S[ i ], Y[ i ] );
+    }
+
+    /** Run each operation serially (reference), and with 1 and N threads. */
+    const char *            names[ 3 ] = { " (ref)", " (1 thread)", " (mt)" };
+    const itk::ThreadIdType nthreads[ 3 ] = { 1, 1, threads };
+    VectorType              x[ 3 ], xr[ 3 ], d[ 3 ], dl[ 3 ];
+    double                  beta[ 3 ];
+    for( unsigned int v = 0; v < 3; ++v )
+    {
+      const bool        reference = ( v == 0 );
+      const std::string name      = names[ v ];
+      x[ v ] = x0; xr[ v ] = x0; d[ v ] = d0;
+      for( unsigned int i = 0; i < rep; ++i )
+      {
+        timeCollector.Start( ( "GD/ASGD" + name ).c_str() );
+        GradientDescentStep( reference, g, x[ v ], nthreads[ v ] );
+        timeCollector.Stop( ( "GD/ASGD" + name ).c_str() );
+
+        timeCollector.Start( ( "RSGD" + name ).c_str() );
+        RSGDStep( reference, f, g, xr[ v ], nthreads[ v ] );
+        timeCollector.Stop( ( "RSGD" + name ).c_str() );
+
+        d[ v ] = d0;
+        timeCollector.Start( ( "CG" + name ).c_str() );
+        beta[ v ] = ConjugateGradientStep( reference, g, gp, d[ v ], nthreads[ v ] );
+        timeCollector.Stop( ( "CG" + name ).c_str() );
+
+        timeCollector.Start( ( "LBFGS" + name ).c_str() );
+        LBFGSStep( reference, g, S, Y, rho, dl[ v ], nthreads[ v ] );
+        timeCollector.Stop( ( "LBFGS" + name ).c_str() );
+      }
+    }
+    timeCollector.Report( std::cout, false, true );
+    std::cout << std::endl;
+
+    /** The elementwise updates equal the reference up to rounding; the
+     * reductions differ from it by the summation order, and do not depend
+     * on the number of threads.
+     */
+    for( unsigned int v = 1; v < 3; ++v )
+    {
+      if( !AreEqual( x[ v ], x[ 0 ], 1e-14 ) || !AreEqual( xr[ v ], xr[ 0 ], 1e-14 ) )
+      {
+        std::cerr << "ERROR: the GD or RSGD step differs from the reference." << std::endl;
+        return EXIT_FAILURE;
+      }
+      if( vcl_abs( beta[ v ] - beta[ 0 ] ) > 1e-10 * vcl_abs( beta[ 0 ] )
+        || !AreEqual( d[ v ], d[ 0 ], 1e-10 ) || !AreEqual( dl[ v ], dl[ 0 ], 1e-8 ) )
+      {
+        std::cerr << "ERROR: the CG or L-BFGS direction differs from the reference." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    if( beta[ 1 ] != beta[ 2 ] || !AreEqual( dl[ 1 ], dl[ 2 ], 0.0 ) )
+    {
+      std::cerr << "ERROR: the reductions depend on the number of threads." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+
+} // end TestParameterVectorOperations()
+
+//-------------------------------------------------------------------------------------
+
 int
 main( int argc, char * argv[] )
 {
@@ -350,6 +566,12 @@ main( int argc, char * argv[] )
 
   } // end loop over array sizes
 
+  /** The vector operations of all optimizers. */
+  if( TestParameterVectorOperations() != EXIT_SUCCESS )
+  {
+    return EXIT_FAILURE;
+  }
+
   return EXIT_SUCCESS;
 
 } // end main
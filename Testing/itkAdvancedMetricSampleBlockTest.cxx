@@ -0,0 +1,141 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+#include "AdvancedNormalizedCorrelation/itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+
+// Report timings
+#include "itkTimeProbe.h"
+
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that processing the samples in blocks (UseSampleBlocks)
+ * gives the same value and derivative as processing them one at a time, for
+ * the mean squares and normalized correlation metrics with a B-spline
+ * transform, and reports the time of both.
+ */
+
+using namespace MetricTestHelper;
+
+/** Compute the value and derivative with a new metric of type TMetric. */
+template< class TMetric >
+void
+ComputeValueAndDerivative( ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const ParametersType & parameters,
+  const bool useSampleBlocks,
+  MeasureType & value, MeasureType & valueOnly, DerivativeType & derivative )
+{
+  typename TMetric::Pointer metric = TMetric::New();
+  SetupMetric( metric, fixedImage, movingImage, transform, 2 );
+  metric->SetUseMultiThread( true );
+  metric->SetUseSampleBlocks( useSampleBlocks );
+  metric->SetSampleBlockSize( 37 ); // not a divisor of the number of samples
+  metric->Initialize();
+
+  itk::TimeProbe timer;
+  timer.Start();
+  metric->GetValueAndDerivative( parameters, value, derivative );
+  timer.Stop();
+  valueOnly = metric->GetValue( parameters );
+  std::cout << "  time " << ( useSampleBlocks ? "blocks" : "per sample" )
+            << " [s]: " << timer.GetMean() << std::endl;
+
+} // end ComputeValueAndDerivative()
+
+
+/** Compare the results with and without sample blocks. */
+template< class TMetric >
+int
+CompareWithAndWithoutBlocks( const std::string & name,
+  ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const ParametersType & parameters )
+{
+  MeasureType    value, blockValue, valueOnly, blockValueOnly;
+  DerivativeType derivative, blockDerivative;
+  ComputeValueAndDerivative< TMetric >( fixedImage, movingImage, transform,
+    parameters, false, value, valueOnly, derivative );
+  ComputeValueAndDerivative< TMetric >( fixedImage, movingImage, transform,
+    parameters, true, blockValue, blockValueOnly, blockDerivative );
+
+  /** Only the order of summation differs. */
+  if( std::abs( valueOnly - blockValueOnly ) > 1e-10 * ( 1.0 + std::abs( valueOnly ) ) )
+  {
+    std::cerr << "ERROR: the GetValue() results of " << name
+              << " with and without sample blocks differ." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return CompareValueAndDerivative( name, "per sample", "blocks",
+    value, blockValue, derivative, blockDerivative, 1e-10, 1e-10 );
+
+} // end CompareWithAndWithoutBlocks()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ImageType::Pointer fixedImage, movingImage;
+  if( !ReadTestImages( argv[ 1 ], LinearRemapping, fixedImage, movingImage ) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  /** A deformation which maps some samples outside the moving image. */
+  BSplineTransformType::Pointer transform  = CreateBSplineTransform( fixedImage, 4.0 );
+  const ParametersType          parameters = transform->GetParameters();
+
+  std::cout << std::scientific << std::setprecision( 6 );
+  std::cout << "Number of parameters: " << parameters.GetSize() << "\n" << std::endl;
+
+  /** Compare. */
+  typedef itk::AdvancedMeanSquaresImageToImageMetric<
+    ImageType, ImageType >                          MSDMetricType;
+  typedef itk::AdvancedNormalizedCorrelationImageToImageMetric<
+    ImageType, ImageType >                          NCMetricType;
+  try
+  {
+    if( CompareWithAndWithoutBlocks< MSDMetricType >( "AdvancedMeanSquares",
+      fixedImage, movingImage, transform, parameters ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+    if( CompareWithAndWithoutBlocks< NCMetricType >( "AdvancedNormalizedCorrelation",
+      fixedImage, movingImage, transform, parameters ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -18,6 +18,8 @@
 
 #include "itkAdvancedBSplineDeformableTransform.h" // original elastix
 #include "itkRecursiveBSplineTransform.h"          // recursive version
+#include "itkRecursiveBSplineTransformImplementation.h"
+#include "itkRecursiveBSplineInterpolationWeightFunction.h"
 
 // Report timings
 #include "itkTimeProbe.h"
@@ -25,6 +27,21 @@
 
 #include <fstream>
 #include <iomanip>
+#include <vector>
+#include <cmath>
+
+//-------------------------------------------------------------------------------------
+
+/** Report the time and the throughput of a kernel. */
+void
+ReportThroughput( const std::string & name, const itk::TimeProbe & probe, const unsigned int N )
+{
+  std::cerr << std::left << std::setw( 36 ) << name << std::right
+            << std::setw( 12 ) << probe.GetMean() << " " << probe.GetUnit()
+            << std::setw( 12 ) << N / probe.GetMean() / 1.0e6 << " Mpoints/s" << std::endl;
+
+} // end ReportThroughput()
+
 
 //-------------------------------------------------------------------------------------
 
@@ -227,6 +244,84 @@ main( int argc, char * argv[] )
   /** Report timings. */
   timeCollector.Report();
 
+  /** Time the bare recursive kernels, in double and in float precision,
+   * excluding the computation of the weights and the nonzero Jacobian indices.
+   */
+  typedef itk::RecursiveBSplineInterpolationWeightFunction<
+    CoordinateRepresentationType, Dimension, SplineOrder >  WeightFunctionType;
+  typedef itk::RecursiveBSplineTransformImplementation<
+    Dimension, Dimension, SplineOrder, double >             DoubleKernelType;
+  typedef itk::RecursiveBSplineTransformImplementation<
+    Dimension, Dimension, SplineOrder, float >              FloatKernelType;
+
+  WeightFunctionType::Pointer             weightFunction = WeightFunctionType::New();
+  WeightFunctionType::ContinuousIndexType cindex;
+  WeightFunctionType::IndexType           supportIndex;
+  WeightFunctionType::WeightsType         weights( WeightFunctionType::NumberOfWeights );
+  for( unsigned int j = 0; j < Dimension; ++j )
+  {
+    cindex[ j ] = ( inputPoint[ j ] - gridOrigin[ j ] ) / gridSpacing[ j ];
+  }
+  weightFunction->Evaluate( cindex, weights, supportIndex );
+
+  double migArray[ Dimension ];
+  for( unsigned int j = 0; j < Dimension; ++j )
+  {
+    migArray[ j ] = movingImageGradient[ j ];
+  }
+
+  std::vector< double > jacobianDouble( Dimension * nnzji, 0.0 );
+  std::vector< float >  jacobianFloat( Dimension * nnzji, 0.0f );
+  std::vector< double > imageJacobianDouble( nnzji );
+  std::vector< float >  imageJacobianFloat( nnzji );
+  itk::TimeProbe        timeProbeJacobianDouble, timeProbeJacobianFloat;
+  itk::TimeProbe        timeProbeImageJacobianDouble, timeProbeImageJacobianFloat;
+
+  timeProbeJacobianDouble.Start();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    double * jacobianPointer = &jacobianDouble[ 0 ];
+    DoubleKernelType::GetJacobian( jacobianPointer, weights.data_block(), 1.0 );
+    sum += jacobianDouble[ 0 ];
+  }
+  timeProbeJacobianDouble.Stop();
+
+  timeProbeJacobianFloat.Start();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    float * jacobianPointer = &jacobianFloat[ 0 ];
+    FloatKernelType::GetJacobian( jacobianPointer, weights.data_block(), 1.0 );
+    sum += jacobianFloat[ 0 ];
+  }
+  timeProbeJacobianFloat.Stop();
+
+  timeProbeImageJacobianDouble.Start();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    double * imageJacobianPointer = &imageJacobianDouble[ 0 ];
+    DoubleKernelType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobianPointer, migArray, weights.data_block(), 1.0 );
+    sum += imageJacobianDouble[ 0 ];
+  }
+  timeProbeImageJacobianDouble.Stop();
+
+  timeProbeImageJacobianFloat.Start();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    float * imageJacobianPointer = &imageJacobianFloat[ 0 ];
+    FloatKernelType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobianPointer, migArray, weights.data_block(), 1.0 );
+    sum += imageJacobianFloat[ 0 ];
+  }
+  timeProbeImageJacobianFloat.Stop();
+
+  std::cerr << std::setprecision( 4 );
+  std::cerr << "\nThroughput of the recursive kernels:" << std::endl;
+  ReportThroughput( "GetJacobian, double", timeProbeJacobianDouble, N );
+  ReportThroughput( "GetJacobian, float", timeProbeJacobianFloat, N );
+  ReportThroughput( "JacobianGradient, double", timeProbeImageJacobianDouble, N );
+  ReportThroughput( "JacobianGradient, float", timeProbeImageJacobianFloat, N );
+
   // Avoid compiler optimizations, so use sum
   std::cerr << sum << std::endl; // works but ugly on screen
 
@@ -252,6 +347,26 @@ main( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  /** The bare kernels should agree with the transform, also in float precision. */
+  for( unsigned int mu = 0; mu < nnzji; ++mu )
+  {
+    const double reference = imageJacobian_new( mu );
+    if( std::abs( imageJacobianDouble[ mu ] - reference ) > 1e-10
+      || std::abs( imageJacobianFloat[ mu ] - reference ) > 1e-5 * ( 1.0 + std::abs( reference ) ) )
+    {
+      std::cerr << "ERROR: the recursive B-spline kernels return incorrect results." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  for( unsigned int i = 0; i < Dimension * nnzji; ++i )
+  {
+    if( std::abs( jacobianFloat[ i ] - jacobianDouble[ i ] ) > 1e-6 )
+    {
+      std::cerr << "ERROR: the float GetJacobian kernel returns incorrect results." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   /** Return a value. */
   return EXIT_SUCCESS;
 
@@ -16,6 +16,9 @@
  *
  *=========================================================================*/
 #include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkRecursiveBSplineTransform.h"
+#include "itkRecursiveBSplineTransformImplementation.h"
+#include "itkRecursiveBSplineInterpolationWeightFunction.h"
 
 #include "itkImageRegionIterator.h"
 
@@ -24,6 +27,8 @@
 
 #include <fstream>
 #include <iomanip>
+#include <vector>
+#include <cmath>
 
 //-------------------------------------------------------------------------------------
 // Create a class that inherits from the B-spline transform,
@@ -163,6 +168,19 @@ public:
 // end class BSplineTransform_TEST
 } // end namespace itk
 
+//-------------------------------------------------------------------------------------
+
+/** Report the time and the throughput of a kernel. */
+void
+ReportThroughput( const std::string & name, const itk::TimeProbe & probe, const unsigned int N )
+{
+  std::cerr << std::left << std::setw( 36 ) << name << std::right
+            << std::setw( 12 ) << probe.GetMean() << " " << probe.GetUnit()
+            << std::setw( 12 ) << N / probe.GetMean() / 1.0e6 << " Mpoints/s" << std::endl;
+
+} // end ReportThroughput()
+
+
 //-------------------------------------------------------------------------------------
 
 int
@@ -197,6 +215,8 @@ main( int argc, char * argv[] )
   /** Typedefs. */
   typedef itk::BSplineTransform_TEST<
     CoordinateRepresentationType, Dimension, SplineOrder >    TransformType;
+  typedef itk::RecursiveBSplineTransform<
+    CoordinateRepresentationType, Dimension, SplineOrder >    RecursiveTransformType;
 
   typedef TransformType::InputPointType  InputPointType;
   typedef TransformType::OutputPointType OutputPointType;
@@ -243,6 +263,12 @@ main( int argc, char * argv[] )
   transform->SetGridRegion( gridRegion );
   transform->SetGridDirection( gridDirection );
 
+  RecursiveTransformType::Pointer recursiveTransform = RecursiveTransformType::New();
+  recursiveTransform->SetGridOrigin( gridOrigin );
+  recursiveTransform->SetGridSpacing( gridSpacing );
+  recursiveTransform->SetGridRegion( gridRegion );
+  recursiveTransform->SetGridDirection( gridDirection );
+
   /** Now read the parameters as defined in the file par.txt. */
   ParametersType parameters( transform->GetNumberOfParameters() );
   std::ifstream  input( argv[ 1 ] );
@@ -260,6 +286,7 @@ main( int argc, char * argv[] )
     return 1;
   }
   transform->SetParameters( parameters );
+  recursiveTransform->SetParameters( parameters );
 
   /** Declare variables. */
   InputPointType  inputPoint; inputPoint.Fill( 4.1 );
@@ -298,6 +325,115 @@ main( int argc, char * argv[] )
   std::cerr << "Time NEW = " << newTime << " " << timeProbeNEW.GetUnit() << std::endl;
   std::cerr << "Speedup factor = " << oldTime / newTime << std::endl;
 
+  /**
+   *
+   * Benchmark the recursive kernels
+   *
+   */
+
+  itk::TimeProbe timeProbeRecursive, timeProbeBatched, timeProbeKernelDouble, timeProbeKernelFloat;
+
+  /** The recursive transform, one point at a time. */
+  timeProbeRecursive.Start();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    outputPoint = recursiveTransform->TransformPoint( inputPoint );
+    sum        += outputPoint[ 0 ]; sum += outputPoint[ 1 ]; sum += outputPoint[ 2 ];
+  }
+  timeProbeRecursive.Stop();
+
+  /** The recursive transform, all points at once. */
+  std::vector< InputPointType >  inputPoints( N, inputPoint );
+  std::vector< OutputPointType > outputPoints( N );
+  timeProbeBatched.Start();
+  recursiveTransform->TransformPoints( &inputPoints[ 0 ], &outputPoints[ 0 ], N );
+  timeProbeBatched.Stop();
+  sum += outputPoints[ N - 1 ][ 0 ];
+
+  /** The bare kernels, in double and in float precision, excluding the
+   * computation of the weights.
+   */
+  typedef itk::RecursiveBSplineInterpolationWeightFunction<
+    CoordinateRepresentationType, Dimension, SplineOrder >  WeightFunctionType;
+  typedef itk::RecursiveBSplineTransformImplementation<
+    Dimension, Dimension, SplineOrder, double >             DoubleKernelType;
+  typedef itk::RecursiveBSplineTransformImplementation<
+    Dimension, Dimension, SplineOrder, float >              FloatKernelType;
+
+  WeightFunctionType::Pointer             weightFunction = WeightFunctionType::New();
+  WeightFunctionType::ContinuousIndexType cindex;
+  WeightFunctionType::IndexType           supportIndex;
+  WeightFunctionType::WeightsType         weights( WeightFunctionType::NumberOfWeights );
+  for( unsigned int j = 0; j < Dimension; ++j )
+  {
+    cindex[ j ] = ( inputPoint[ j ] - gridOrigin[ j ] ) / gridSpacing[ j ];
+  }
+  weightFunction->Evaluate( cindex, weights, supportIndex );
+
+  const RecursiveTransformType::ImagePointer * coefficientImages
+    = recursiveTransform->GetCoefficientImages();
+  const itk::OffsetValueType * offsetTable = coefficientImages[ 0 ]->GetOffsetTable();
+  const std::size_t            numberOfCoefficients
+    = coefficientImages[ 0 ]->GetLargestPossibleRegion().GetNumberOfPixels();
+  itk::OffsetValueType totalOffset = 0;
+  for( unsigned int j = 0; j < Dimension; ++j )
+  {
+    totalOffset += supportIndex[ j ] * offsetTable[ j ];
+  }
+
+  std::vector< float > floatCoefficients[ Dimension ];
+  double *             muDouble[ Dimension ];
+  float *              muFloat[ Dimension ];
+  for( unsigned int j = 0; j < Dimension; ++j )
+  {
+    double * buffer = coefficientImages[ j ]->GetBufferPointer();
+    floatCoefficients[ j ].assign( buffer, buffer + numberOfCoefficients );
+    muDouble[ j ] = buffer + totalOffset;
+    muFloat[ j ]  = &floatCoefficients[ j ][ 0 ] + totalOffset;
+  }
+
+  double displacementDouble[ Dimension ];
+  float  displacementFloat[ Dimension ];
+  timeProbeKernelDouble.Start();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    DoubleKernelType::TransformPoint( displacementDouble, muDouble, offsetTable, weights.data_block() );
+    sum += displacementDouble[ 0 ];
+  }
+  timeProbeKernelDouble.Stop();
+
+  timeProbeKernelFloat.Start();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    FloatKernelType::TransformPoint( displacementFloat, muFloat, offsetTable, weights.data_block() );
+    sum += displacementFloat[ 0 ];
+  }
+  timeProbeKernelFloat.Stop();
+  std::cerr << sum << std::endl;
+
+  std::cerr << "\nThroughput of TransformPoint:" << std::endl;
+  ReportThroughput( "AdvancedBSpline, old", timeProbeOLD, N );
+  ReportThroughput( "AdvancedBSpline", timeProbeNEW, N );
+  ReportThroughput( "RecursiveBSpline", timeProbeRecursive, N );
+  ReportThroughput( "RecursiveBSpline, TransformPoints", timeProbeBatched, N );
+  ReportThroughput( "Recursive kernel, double", timeProbeKernelDouble, N );
+  ReportThroughput( "Recursive kernel, float", timeProbeKernelFloat, N );
+
+  /** Check the accuracy of the recursive transform and the float kernel. */
+  const OutputPointType outputPointOLD       = transform->TransformPoint_OLD( inputPoint );
+  const OutputPointType outputPointRecursive = recursiveTransform->TransformPoint( inputPoint );
+  for( unsigned int j = 0; j < Dimension; ++j )
+  {
+    const double displacement = outputPointOLD[ j ] - inputPoint[ j ];
+    if( std::abs( outputPointRecursive[ j ] - outputPointOLD[ j ] ) > 1e-8
+      || std::abs( displacementDouble[ j ] - displacement ) > 1e-8
+      || std::abs( displacementFloat[ j ] - displacement ) > 1e-4 * ( 1.0 + std::abs( displacement ) ) )
+    {
+      std::cerr << "ERROR: the recursive B-spline kernels return incorrect results." << std::endl;
+      return 1;
+    }
+  }
+
   /** Return a value. */
   return 0;
 
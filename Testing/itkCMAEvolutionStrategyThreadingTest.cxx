@@ -0,0 +1,384 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "CMAEvolutionStrategy/itkCMAEvolutionStrategyOptimizer.h"
+#include "itkThreadRandomGenerator.h"
+#include "itkMultiThreader.h"
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the CMA evolution strategy optimizer gives exactly
+ * the same result with 1, 2 and N threads: the same final position, value
+ * and number of iterations. The cost function is an ill-conditioned,
+ * rotated quadratic, so that the covariance matrix adaptation matters.
+ *
+ * With N threads, the offspring is evaluated concurrently by the cost
+ * function and N - 1 copies of it. The cost function keeps its residuals in
+ * a member, like a metric keeps its transform parameters, so each copy has
+ * its own state. With 120 parameters and more than one thread, the eigen
+ * decomposition of the covariance matrix is multi-threaded too, so that only
+ * 2 and N threads give the same result then. Each eigen decomposition is
+ * compared with vnl_symmetric_eigensystem.
+ */
+
+namespace itk
+{
+
+class CMAEvolutionStrategyTestCostFunction : public SingleValuedCostFunction
+{
+public:
+
+  typedef CMAEvolutionStrategyTestCostFunction Self;
+  typedef SingleValuedCostFunction             Superclass;
+  typedef SmartPointer< Self >                 Pointer;
+  typedef SmartPointer< const Self >           ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( CMAEvolutionStrategyTestCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::ParametersType ParametersType;
+  typedef Superclass::DerivativeType DerivativeType;
+  typedef Superclass::MeasureType    MeasureType;
+
+  itkSetMacro( NumberOfParameters, unsigned int );
+
+  virtual unsigned int GetNumberOfParameters( void ) const
+  {
+    return this->m_NumberOfParameters;
+  }
+
+
+  /** The number of times GetValue() was called. */
+  itkGetConstMacro( NumberOfEvaluations, unsigned long );
+
+  /** f(x) = sum_i 10^(3i/(n-1)) ( x_i + x_{i+1} - i )^2, with x_n = x_0. */
+  virtual MeasureType GetValue( const ParametersType & parameters ) const
+  {
+    const unsigned int n = this->m_NumberOfParameters;
+    this->m_Residuals.SetSize( n );
+    for( unsigned int i = 0; i < n; ++i )
+    {
+      this->m_Residuals[ i ] = parameters[ i ] + parameters[ ( i + 1 ) % n ]
+        - static_cast< double >( i );
+    }
+    MeasureType value = 0.0;
+    for( unsigned int i = 0; i < n; ++i )
+    {
+      const double weight = std::pow( 10.0, 3.0 * i / ( n - 1.0 ) );
+      value += weight * this->m_Residuals[ i ] * this->m_Residuals[ i ];
+    }
+    ++this->m_NumberOfEvaluations;
+    return value;
+  }
+
+
+  virtual void GetDerivative( const ParametersType &, DerivativeType & ) const
+  {
+    itkExceptionMacro( << "Not implemented" );
+  }
+
+
+protected:
+
+  CMAEvolutionStrategyTestCostFunction()
+  {
+    this->m_NumberOfParameters  = 10;
+    this->m_NumberOfEvaluations = 0;
+  }
+
+
+  virtual ~CMAEvolutionStrategyTestCostFunction() {}
+
+private:
+
+  CMAEvolutionStrategyTestCostFunction( const Self & ); // purposely not implemented
+  void operator=( const Self & );                       // purposely not implemented
+
+  unsigned int           m_NumberOfParameters;
+  mutable ParametersType m_Residuals;
+  mutable unsigned long  m_NumberOfEvaluations;
+
+};
+
+/** The optimizer, which checks each eigen decomposition of the covariance
+ * matrix against vnl_symmetric_eigensystem.
+ */
+class CMAEvolutionStrategyTestOptimizer : public CMAEvolutionStrategyOptimizer
+{
+public:
+
+  typedef CMAEvolutionStrategyTestOptimizer Self;
+  typedef CMAEvolutionStrategyOptimizer     Superclass;
+  typedef SmartPointer< Self >              Pointer;
+  typedef SmartPointer< const Self >        ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( CMAEvolutionStrategyTestOptimizer, CMAEvolutionStrategyOptimizer );
+
+  /** The largest difference between the eigen values and those of
+   * vnl_symmetric_eigensystem, and the largest element of B D B' - C, both
+   * relative to the largest eigen value, over all decompositions. */
+  itkGetConstMacro( EigenValueError, double );
+  itkGetConstMacro( ReconstructionError, double );
+  itkGetConstMacro( NumberOfEigenDecompositions, unsigned long );
+
+protected:
+
+  CMAEvolutionStrategyTestOptimizer()
+  {
+    this->m_EigenValueError             = 0.0;
+    this->m_ReconstructionError         = 0.0;
+    this->m_NumberOfEigenDecompositions = 0;
+  }
+
+
+  virtual ~CMAEvolutionStrategyTestOptimizer() {}
+
+  virtual bool ComputeEigenDecomposition( std::vector< double > & eigenValues )
+  {
+    const CovarianceMatrixType C = this->m_C;
+    if( !this->Superclass::ComputeEigenDecomposition( eigenValues ) )
+    {
+      return false;
+    }
+    ++this->m_NumberOfEigenDecompositions;
+
+    const unsigned int                  N = C.rows();
+    vnl_symmetric_eigensystem< double > eig( C );
+    const double                        maxEigenValue = vnl_math_max(
+      vcl_abs( eig.D( 0, 0 ) ), vcl_abs( eig.D( N - 1, N - 1 ) ) );
+    for( unsigned int i = 0; i < N; ++i )
+    {
+      this->m_EigenValueError = vnl_math_max( this->m_EigenValueError,
+        vcl_abs( eigenValues[ i ] - eig.D( i, i ) ) / maxEigenValue );
+      for( unsigned int j = 0; j < N; ++j )
+      {
+        double element = 0.0;
+        for( unsigned int k = 0; k < N; ++k )
+        {
+          element += this->m_B[ i ][ k ] * eigenValues[ k ] * this->m_B[ j ][ k ];
+        }
+        this->m_ReconstructionError = vnl_math_max( this->m_ReconstructionError,
+          vcl_abs( element - C[ i ][ j ] ) / maxEigenValue );
+      }
+    }
+    return true;
+  }
+
+
+private:
+
+  CMAEvolutionStrategyTestOptimizer( const Self & ); // purposely not implemented
+  void operator=( const Self & );                    // purposely not implemented
+
+  double        m_EigenValueError;
+  double        m_ReconstructionError;
+  unsigned long m_NumberOfEigenDecompositions;
+
+};
+
+} // end namespace itk
+
+typedef itk::CMAEvolutionStrategyTestOptimizer    OptimizerType;
+typedef itk::CMAEvolutionStrategyTestCostFunction CostFunctionType;
+typedef OptimizerType::ParametersType             ParametersType;
+typedef OptimizerType::MeasureType                MeasureType;
+typedef itk::ThreadRandomGenerator                RandomGeneratorType;
+
+/** The result of one optimization. */
+struct ResultType
+{
+  ParametersType st_Position;
+  MeasureType    st_InitialValue;
+  MeasureType    st_Value;
+  unsigned long  st_NumberOfIterations;
+  unsigned long  st_NumberOfEvaluations;
+  unsigned long  st_NumberOfCloneEvaluations;
+  unsigned long  st_NumberOfEigenDecompositions;
+  double         st_EigenValueError;
+  double         st_ReconstructionError;
+};
+
+/** Run the optimizer with a freshly seeded random number stream, and
+ * numberOfThreads - 1 copies of the cost function.
+ */
+ResultType
+RunOptimizer( const itk::ThreadIdType numberOfThreads,
+  const unsigned int numberOfParameters, const unsigned long numberOfIterations )
+{
+  /** The optimizer takes the random generator of the calling thread at
+   * construction, so install a seeded one before creating it.
+   */
+  RandomGeneratorType::GeneratorPointer randomGenerator
+    = RandomGeneratorType::GeneratorType::New();
+  randomGenerator->Initialize( 121212 );
+  RandomGeneratorType::Scope randomGeneratorScope( randomGenerator );
+
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+  costFunction->SetNumberOfParameters( numberOfParameters );
+  OptimizerType::CostFunctionContainerType clones;
+  for( itk::ThreadIdType i = 1; i < numberOfThreads; ++i )
+  {
+    CostFunctionType::Pointer clone = CostFunctionType::New();
+    clone->SetNumberOfParameters( numberOfParameters );
+    clones.push_back( clone.GetPointer() );
+  }
+  ParametersType initialPosition( numberOfParameters );
+  initialPosition.Fill( 3.0 );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetCostFunctionClones( clones );
+  optimizer->SetInitialPosition( initialPosition );
+  optimizer->SetMaximumNumberOfIterations( numberOfIterations );
+  optimizer->SetInitialSigma( 1.0 );
+  optimizer->SetUseCovarianceMatrixAdaptation( true );
+  optimizer->SetUpdateBDPeriod( 1 );
+  optimizer->SetPositionToleranceMin( 1e-12 );
+  optimizer->SetPositionToleranceMax( 1e12 );
+  optimizer->SetValueTolerance( 0.0 );
+  optimizer->SetNumberOfThreads( numberOfThreads );
+  optimizer->StartOptimization();
+
+  ResultType result;
+  result.st_Position                 = optimizer->GetCurrentPosition();
+  result.st_Value                    = optimizer->GetCurrentValue();
+  result.st_NumberOfIterations       = optimizer->GetCurrentIteration();
+  result.st_NumberOfEvaluations      = costFunction->GetNumberOfEvaluations();
+  result.st_NumberOfCloneEvaluations = 0;
+  for( unsigned int i = 0; i < clones.size(); ++i )
+  {
+    result.st_NumberOfCloneEvaluations
+      += static_cast< CostFunctionType * >( clones[ i ].GetPointer() )->GetNumberOfEvaluations();
+  }
+  result.st_NumberOfEigenDecompositions = optimizer->GetNumberOfEigenDecompositions();
+  result.st_EigenValueError             = optimizer->GetEigenValueError();
+  result.st_ReconstructionError         = optimizer->GetReconstructionError();
+  result.st_InitialValue = costFunction->GetValue( initialPosition );
+  return result;
+
+} // end RunOptimizer()
+
+
+/** Compare the results of 1, 2 and N threads. */
+int
+CompareThreads( const itk::ThreadIdType numberOfThreads,
+  const unsigned int numberOfParameters, const unsigned long numberOfIterations,
+  const bool checkProgress )
+{
+  std::cout << "Number of parameters: " << numberOfParameters << std::endl;
+
+  const itk::ThreadIdType threads[ 3 ] = { 1, 2, numberOfThreads };
+  ResultType              results[ 3 ];
+  for( unsigned int r = 0; r < 3; ++r )
+  {
+    results[ r ] = RunOptimizer( threads[ r ], numberOfParameters, numberOfIterations );
+    std::cout << "  " << threads[ r ] << " thread(s): value " << results[ r ].st_Value
+              << " after " << results[ r ].st_NumberOfIterations << " iterations, "
+              << results[ r ].st_NumberOfCloneEvaluations << " of "
+              << results[ r ].st_NumberOfEvaluations + results[ r ].st_NumberOfCloneEvaluations
+              << " evaluations by the copies" << std::endl;
+    std::cout << "  " << results[ r ].st_NumberOfEigenDecompositions
+              << " eigen decompositions, eigen value error: " << results[ r ].st_EigenValueError
+              << ", B D B' - C: " << results[ r ].st_ReconstructionError << std::endl;
+
+    /** The eigen decomposition should be accurate to rounding errors. */
+    if( results[ r ].st_NumberOfEigenDecompositions == 0
+      || !( results[ r ].st_EigenValueError < 1e-10 )
+      || !( results[ r ].st_ReconstructionError < 1e-10 ) )
+    {
+      std::cerr << "ERROR: the eigen decomposition of the covariance matrix is inaccurate." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** The optimizer should make progress on the test function at all. */
+  const ResultType & serialResult = results[ 0 ];
+  if( checkProgress && !( serialResult.st_Value < 1e-3 * serialResult.st_InitialValue ) )
+  {
+    std::cerr << "ERROR: the optimizer did not decrease the cost function." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Exact equality: the random numbers are drawn in the same order, and
+   * each member is evaluated exactly once, by the cost function or a copy.
+   * From 100 parameters on, one thread uses another eigen solver than more
+   * threads, so then the 2 thread result is the reference.
+   */
+  const unsigned int  reference       = numberOfParameters < 100 ? 0 : 1;
+  const ResultType &  referenceResult = results[ reference ];
+  const unsigned long referenceEvaluations
+    = referenceResult.st_NumberOfEvaluations + referenceResult.st_NumberOfCloneEvaluations;
+  for( unsigned int r = reference + 1; r < 3; ++r )
+  {
+    if( results[ r ].st_Value != referenceResult.st_Value
+      || results[ r ].st_NumberOfIterations != referenceResult.st_NumberOfIterations
+      || results[ r ].st_Position != referenceResult.st_Position )
+    {
+      std::cerr << "ERROR: the multi-threaded optimizer gives a different result." << std::endl;
+      std::cerr << "  " << threads[ reference ] << " thread(s): " << referenceResult.st_Position << std::endl;
+      std::cerr << "  " << threads[ r ] << " thread(s): " << results[ r ].st_Position << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( results[ r ].st_NumberOfEvaluations + results[ r ].st_NumberOfCloneEvaluations
+      != referenceEvaluations )
+    {
+      std::cerr << "ERROR: the multi-threaded optimizer evaluates the cost function "
+                << results[ r ].st_NumberOfEvaluations + results[ r ].st_NumberOfCloneEvaluations
+                << " times instead of " << referenceEvaluations << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+
+} // end CompareThreads()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  itk::ThreadIdType numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  if( numberOfThreads < 2 ) { numberOfThreads = 2; }
+  std::cout << "Number of threads: " << numberOfThreads << std::endl;
+
+  try
+  {
+    /** A small problem that converges, and a larger one for which the eigen
+     * decomposition is multi-threaded.
+     */
+    if( CompareThreads( numberOfThreads, 10, 150, true ) != EXIT_SUCCESS
+      || CompareThreads( numberOfThreads, 120, 20, false ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
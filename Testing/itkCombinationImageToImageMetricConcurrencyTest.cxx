@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+#include "AdvancedNormalizedCorrelation/itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+#include "MultiMetricMultiResolutionRegistration/itkCombinationImageToImageMetric.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the concurrent evaluation of the sub metrics of a
+ * CombinationImageToImageMetric gives the same value and derivative as the
+ * serial evaluation. The threads are only split over the sub metrics during
+ * the concurrent evaluation: before and after it, the sub metrics keep all
+ * threads of the combination metric, so that GetValue(), GetDerivative() and
+ * the serial evaluation use all of them.
+ */
+
+using namespace MetricTestHelper;
+
+typedef itk::AdvancedMeanSquaresImageToImageMetric<
+  ImageType, ImageType >                                         MSDMetricType;
+typedef itk::AdvancedNormalizedCorrelationImageToImageMetric<
+  ImageType, ImageType >                                         NCMetricType;
+typedef itk::CombinationImageToImageMetric<
+  ImageType, ImageType >                                         CombinationMetricType;
+
+/** Create a combination of a mean squares and a normalized correlation metric,
+ * each with its own sampler and interpolator.
+ */
+CombinationMetricType::Pointer
+CreateCombinationMetric( ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const bool useConcurrentEvaluation )
+{
+  MSDMetricType::Pointer msdMetric = MSDMetricType::New();
+  NCMetricType::Pointer  ncMetric  = NCMetricType::New();
+  SetupMetric( msdMetric, fixedImage, movingImage, transform, 2 );
+  SetupMetric( ncMetric, fixedImage, movingImage, transform, 3 );
+  msdMetric->SetUseMultiThread( true );
+  ncMetric->SetUseMultiThread( true );
+
+  CombinationMetricType::Pointer metric = CombinationMetricType::New();
+  metric->SetNumberOfMetrics( 2 );
+  metric->SetMetric( msdMetric, 0 );
+  metric->SetMetric( ncMetric, 1 );
+  metric->SetMetricWeight( 1.0, 0 );
+  metric->SetMetricWeight( 1000.0, 1 );
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  metric->SetTransform( transform );
+  metric->SetNumberOfThreads( 4 );
+  metric->SetUseMultiThread( useConcurrentEvaluation );
+  metric->Initialize();
+
+  return metric;
+
+} // end CreateCombinationMetric()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ImageType::Pointer fixedImage, movingImage;
+  if( !ReadTestImages( argv[ 1 ], LinearRemapping, fixedImage, movingImage ) )
+  {
+    return EXIT_FAILURE;
+  }
+  BSplineTransformType::Pointer transform  = CreateBSplineTransform( fixedImage, 4.0 );
+  const ParametersType          parameters = transform->GetParameters();
+
+  try
+  {
+    CombinationMetricType::Pointer serialMetric
+      = CreateCombinationMetric( fixedImage, movingImage, transform, false );
+    CombinationMetricType::Pointer concurrentMetric
+      = CreateCombinationMetric( fixedImage, movingImage, transform, true );
+
+    /** The sub metrics get the four threads of the combination metric. */
+    for( unsigned int i = 0; i < 2; ++i )
+    {
+      const MetricType * subMetric
+        = dynamic_cast< MetricType * >( concurrentMetric->GetMetric( i ) );
+      if( subMetric->GetNumberOfThreads() != 4 || !subMetric->GetUseThreadPool() )
+      {
+        std::cerr << "ERROR: sub metric " << i << " has " << subMetric->GetNumberOfThreads()
+                  << " threads after Initialize(), instead of 4 on the thread pool." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    MeasureType    serialValue, concurrentValue, repeatedValue;
+    DerivativeType serialDerivative, concurrentDerivative, repeatedDerivative;
+    serialMetric->GetValueAndDerivative( parameters, serialValue, serialDerivative );
+    concurrentMetric->GetValueAndDerivative( parameters, concurrentValue, concurrentDerivative );
+    concurrentMetric->GetValueAndDerivative( parameters, repeatedValue, repeatedDerivative );
+
+    /** The concurrent evaluation must restore the threads of the sub metrics. */
+    for( unsigned int i = 0; i < 2; ++i )
+    {
+      const MetricType * subMetric
+        = dynamic_cast< MetricType * >( concurrentMetric->GetMetric( i ) );
+      if( subMetric->GetNumberOfThreads() != 4 || !subMetric->GetUseThreadPool() )
+      {
+        std::cerr << "ERROR: the concurrent evaluation does not restore the threads of sub metric "
+                  << i << "." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    /** The sub metrics use a different number of threads in the two modes,
+     * which only changes the order of the sums of the threads.
+     */
+    if( CompareValueAndDerivative( "CombinationImageToImageMetric",
+      "serial", "concurrent", serialValue, concurrentValue,
+      serialDerivative, concurrentDerivative, 1e-10, 1e-10 ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+    if( repeatedValue != concurrentValue || repeatedDerivative != concurrentDerivative )
+    {
+      std::cerr << "ERROR: repeated concurrent evaluations differ." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,232 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkComputeJacobianTerms.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImage.h"
+#include "itkMultiThreader.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks the multi-threaded ComputeJacobianTerms::Compute()
+ * against the original ComputeSingleThreaded(), for TrC, TrCC, maxJJ and
+ * maxJCJ, on a 2D and a 3D cubic B-spline transform, with and without
+ * scales. Compute() must give exactly the same terms with 1 and N threads,
+ * with and without the WorkerThreadPool. Compared to ComputeSingleThreaded()
+ * only rounding differences are allowed: Compute() accumulates the
+ * covariance matrix batch by batch.
+ */
+
+/** The terms computed by ComputeJacobianTerms. */
+struct TermsType
+{
+  double st_TrC;
+  double st_TrCC;
+  double st_MaxJJ;
+  double st_MaxJCJ;
+};
+
+/** Check two sets of terms; with a tolerance of 0, exact equality is required. */
+bool
+CompareTerms( const std::string & name, const TermsType & terms,
+  const TermsType & reference, const double tolerance )
+{
+  const double values[ 4 ] = {
+    terms.st_TrC, terms.st_TrCC, terms.st_MaxJJ, terms.st_MaxJCJ
+  };
+  const double referenceValues[ 4 ] = {
+    reference.st_TrC, reference.st_TrCC, reference.st_MaxJJ, reference.st_MaxJCJ
+  };
+  const char * names[ 4 ] = { "TrC", "TrCC", "maxJJ", "maxJCJ" };
+
+  bool success = true;
+  for( unsigned int i = 0; i < 4; ++i )
+  {
+    const double difference = std::abs( values[ i ] - referenceValues[ i ] );
+    if( difference > tolerance * std::abs( referenceValues[ i ] ) )
+    {
+      std::cerr << "ERROR: " << name << ": " << names[ i ] << " is "
+                << std::setprecision( 17 ) << values[ i ] << " instead of "
+                << referenceValues[ i ] << std::endl;
+      success = false;
+    }
+  }
+  return success;
+
+} // end CompareTerms()
+
+
+/** Run the test for one dimension. */
+template< unsigned int Dimension >
+bool
+TestComputeJacobianTerms( const itk::ThreadIdType numberOfThreads )
+{
+  typedef itk::Image< float, Dimension > ImageType;
+  typedef itk::AdvancedBSplineDeformableTransform<
+    double, Dimension, 3 >                                TransformType;
+  typedef itk::ComputeJacobianTerms< ImageType, TransformType > ComputeJacobianTermsType;
+  typedef typename ComputeJacobianTermsType::ScalesType   ScalesType;
+  typedef typename TransformType::ParametersType          ParametersType;
+
+  /** A fixed image; only its geometry is used. */
+  typename ImageType::SizeType    imageSize;
+  typename ImageType::SpacingType imageSpacing;
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    imageSize[ i ]    = Dimension == 2 ? 120 : 40 - 3 * i;
+    imageSpacing[ i ] = 1.0 + 0.25 * i;
+  }
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( imageSize );
+  image->SetSpacing( imageSpacing );
+  image->Allocate();
+  image->FillBuffer( 1.0f );
+
+  /** A B-spline grid covering the image, with random coefficients. */
+  typename TransformType::OriginType    gridOrigin;
+  typename TransformType::SpacingType   gridSpacing;
+  typename TransformType::SizeType      gridSize;
+  typename TransformType::RegionType    gridRegion;
+  typename TransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    gridSpacing[ i ] = 8.0 + i;
+    gridOrigin[ i ]  = -gridSpacing[ i ];
+    gridSize[ i ]    = static_cast< unsigned long >(
+      std::ceil( ( imageSize[ i ] - 1 ) * imageSpacing[ i ] / gridSpacing[ i ] ) ) + 3;
+  }
+  gridRegion.SetSize( gridSize );
+
+  typename TransformType::Pointer transform = TransformType::New();
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridDirection( gridDirection );
+  ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = 2.0 * std::sin( 0.37 * i );
+  }
+  transform->SetParameters( parameters );
+
+  ScalesType scales( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < scales.GetSize(); ++i )
+  {
+    scales[ i ] = 1.0 + 0.5 * std::cos( 0.11 * i );
+  }
+
+  std::cout << Dimension << "D, " << transform->GetNumberOfParameters()
+            << " parameters:" << std::endl;
+
+  bool success = true;
+  for( unsigned int s = 0; s < 2; ++s )
+  {
+    const bool useScales = ( s == 1 );
+
+    /** The original implementation, and the multi-threaded one with 1 and N
+     * threads, with and without the thread pool. */
+    TermsType  terms[ 5 ];
+    const bool useMultiThread[ 5 ]           = { false, true, true, true, true };
+    const bool useThreadPool[ 5 ]            = { false, true, true, false, true };
+    const itk::ThreadIdType threadCounts[ 5 ] = { 1, 1, numberOfThreads, numberOfThreads, 2 };
+    for( unsigned int r = 0; r < 5; ++r )
+    {
+      typename ComputeJacobianTermsType::Pointer computeJacobianTerms
+        = ComputeJacobianTermsType::New();
+      computeJacobianTerms->SetFixedImage( image );
+      computeJacobianTerms->SetFixedImageRegion( image->GetBufferedRegion() );
+      computeJacobianTerms->SetTransform( transform );
+      computeJacobianTerms->SetMaxBandCovSize( 192 );
+      computeJacobianTerms->SetNumberOfBandStructureSamples( 10 );
+      computeJacobianTerms->SetNumberOfJacobianMeasurements( 5000 );
+      computeJacobianTerms->SetUseScales( useScales );
+      if( useScales )
+      {
+        computeJacobianTerms->SetScales( scales );
+      }
+      computeJacobianTerms->SetUseMultiThread( useMultiThread[ r ] );
+      computeJacobianTerms->SetUseThreadPool( useThreadPool[ r ] );
+      computeJacobianTerms->SetNumberOfThreads( threadCounts[ r ] );
+
+      if( useMultiThread[ r ] )
+      {
+        computeJacobianTerms->Compute( terms[ r ].st_TrC, terms[ r ].st_TrCC,
+          terms[ r ].st_MaxJJ, terms[ r ].st_MaxJCJ );
+      }
+      else
+      {
+        computeJacobianTerms->ComputeSingleThreaded( terms[ r ].st_TrC, terms[ r ].st_TrCC,
+          terms[ r ].st_MaxJJ, terms[ r ].st_MaxJCJ );
+      }
+    }
+
+    std::cout << std::setprecision( 17 ) << "  scales " << ( useScales ? "on" : "off" )
+              << ": TrC " << terms[ 0 ].st_TrC << ", TrCC " << terms[ 0 ].st_TrCC
+              << ", maxJJ " << terms[ 0 ].st_MaxJJ << ", maxJCJ " << terms[ 0 ].st_MaxJCJ
+              << std::endl;
+
+    const std::string name = useScales ? " with scales" : " without scales";
+    success &= CompareTerms( "1 thread vs single-threaded" + name,
+      terms[ 1 ], terms[ 0 ], 1e-10 );
+    success &= CompareTerms( "N threads vs 1 thread" + name,
+      terms[ 2 ], terms[ 1 ], 0.0 );
+    success &= CompareTerms( "N threads without thread pool vs 1 thread" + name,
+      terms[ 3 ], terms[ 1 ], 0.0 );
+    success &= CompareTerms( "2 threads vs 1 thread" + name,
+      terms[ 4 ], terms[ 1 ], 0.0 );
+  }
+
+  return success;
+
+} // end TestComputeJacobianTerms()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  itk::ThreadIdType numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  if( numberOfThreads < 3 ) { numberOfThreads = 3; }
+  std::cout << "Number of threads: " << numberOfThreads << std::endl;
+
+  bool success = true;
+  try
+  {
+    success &= TestComputeJacobianTerms< 2 >( numberOfThreads );
+    success &= TestComputeJacobianTerms< 3 >( numberOfThreads );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if( !success )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
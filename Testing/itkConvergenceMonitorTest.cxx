@@ -0,0 +1,115 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkConvergenceMonitor.h"
+
+#include <iostream>
+#include <cmath>
+
+//-------------------------------------------------------------------------------------
+
+/** A reproducible uniform noise sample in [-1, 1]. */
+
+static double
+Noise( unsigned long & state )
+{
+  state = ( 1103515245UL * state + 12345UL ) % 2147483648UL;
+  return 2.0 * static_cast< double >( state ) / 2147483648.0 - 1.0;
+}
+
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the ConvergenceMonitor does not stop a noisy
+ * minimization that still makes progress, and does stop one that has
+ * levelled off, either noisy or smooth.
+ */
+
+int
+main( void )
+{
+  typedef itk::ConvergenceMonitor MonitorType;
+
+  MonitorType::Pointer monitor = MonitorType::New();
+  monitor->SetWindowSize( 50 );
+  monitor->SetTrendThreshold( 1.0 );
+  monitor->SetRelativeTolerance( 1e-5 );
+
+  /** A noisy decrease: not converged, also not before the window is full. */
+  unsigned long state = 1;
+  for( unsigned int i = 0; i < 500; ++i )
+  {
+    if( monitor->AddValue( 100.0 - 0.1 * i + Noise( state ) ) )
+    {
+      std::cerr << "ERROR: a noisy decrease was stopped after "
+                << monitor->GetNumberOfValues() << " values." << std::endl;
+      std::cerr << monitor->GetStopCondition() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if( std::abs( monitor->GetSlope() + 0.1 ) > 0.02 )
+  {
+    std::cerr << "ERROR: the fitted slope is " << monitor->GetSlope()
+              << " instead of -0.1." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Noise around a constant: converged, because the trend is not significant. */
+  monitor->Reset();
+  bool converged = false;
+  for( unsigned int i = 0; i < 500 && !converged; ++i )
+  {
+    converged = monitor->AddValue( 10.0 + Noise( state ) );
+  }
+  if( !converged || monitor->GetTrendSignificance() >= monitor->GetTrendThreshold() )
+  {
+    std::cerr << "ERROR: noise around a constant was not stopped by the trend test."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Noisy constant: " << monitor->GetStopCondition()
+            << ", after " << monitor->GetNumberOfValues() << " values." << std::endl;
+
+  /** A smooth exponential decay: converged, because the decrease is negligible. */
+  monitor->Reset();
+  converged = false;
+  for( unsigned int i = 0; i < 1000 && !converged; ++i )
+  {
+    converged = monitor->AddValue( 1.0 + std::exp( -0.05 * i ) );
+  }
+  if( !converged || monitor->GetNumberOfValues() < 200
+    || monitor->GetTrendSignificance() < monitor->GetTrendThreshold() )
+  {
+    std::cerr << "ERROR: the exponential decay was stopped after "
+              << monitor->GetNumberOfValues() << " values." << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Exponential decay: " << monitor->GetStopCondition()
+            << ", after " << monitor->GetNumberOfValues() << " values." << std::endl;
+
+  /** The window size has a minimum of three values. */
+  monitor->SetWindowSize( 1 );
+  if( monitor->GetWindowSize() != 3 || monitor->GetNumberOfValues() != 0 )
+  {
+    std::cerr << "ERROR: the window size is " << monitor->GetWindowSize()
+              << " instead of 3." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
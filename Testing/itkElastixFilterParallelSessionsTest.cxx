@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "elxElastixFilter.h"
+#include "elxParameterObject.h"
+
+#include "itkImageFileReader.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that registrations with the ElastixFilter can run in
+ * parallel threads of one process: two registrations that run at the same
+ * time must give exactly the same transform parameters as the same
+ * registrations run one after the other. The registrations use a random
+ * sampler and different random seeds, so that they would influence each
+ * other if they drew from one random number stream.
+ */
+
+const unsigned int Dimension = 3;
+typedef float                                         PixelType;
+typedef itk::Image< PixelType, Dimension >            ImageType;
+typedef elastix::ElastixFilter< ImageType, ImageType > ElastixFilterType;
+typedef elastix::ParameterObject                      ParameterObjectType;
+typedef ParameterObjectType::ParameterMapType         ParameterMapType;
+typedef ParameterObjectType::ParameterValueVectorType ParameterValueVectorType;
+
+const unsigned int NumberOfSessions = 2;
+
+/** The input and output of one registration session. */
+struct SessionType
+{
+  ImageType::Pointer       st_FixedImage;
+  ImageType::Pointer       st_MovingImage;
+  unsigned int             st_RandomSeed;
+  ParameterValueVectorType st_TransformParameters;
+  std::string              st_Error;
+};
+
+/** Run one registration. */
+void
+RunSession( SessionType & session )
+{
+  ParameterMapType parameterMap
+    = ParameterObjectType::GetDefaultParameterMap( "translation", 2 );
+  parameterMap[ "ImageSampler" ]              = ParameterValueVectorType( 1, "RandomCoordinate" );
+  parameterMap[ "NumberOfSpatialSamples" ]    = ParameterValueVectorType( 1, "500" );
+  parameterMap[ "MaximumNumberOfIterations" ] = ParameterValueVectorType( 1, "50" );
+  parameterMap[ "RandomSeed" ]
+    = ParameterValueVectorType( 1, ParameterObjectType::ToString( session.st_RandomSeed ) );
+
+  ParameterObjectType::Pointer parameterObject = ParameterObjectType::New();
+  parameterObject->SetParameterMap( parameterMap );
+
+  try
+  {
+    ElastixFilterType::Pointer filter = ElastixFilterType::New();
+    filter->SetFixedImage( session.st_FixedImage );
+    filter->SetMovingImage( session.st_MovingImage );
+    filter->SetParameterObject( parameterObject );
+    filter->LogToConsoleOff();
+    filter->LogToFileOff();
+    filter->Update();
+
+    session.st_TransformParameters = filter->GetTransformParameterObject()
+      ->GetParameterMap( 0 ).find( "TransformParameters" )->second;
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    session.st_Error = excp.GetDescription();
+  }
+
+} // end RunSession()
+
+
+/** Run the session of the thread. */
+ITK_THREAD_RETURN_TYPE
+RunSessionThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  SessionType * sessions = static_cast< SessionType * >( infoStruct->UserData );
+  RunSession( sessions[ infoStruct->ThreadID ] );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end RunSessionThreaderCallback()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Read the fixed image. */
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[ 1 ] );
+  try
+  {
+    reader->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+  ImageType::Pointer fixedImage = reader->GetOutput();
+
+  /** Create the moving image by shifting the fixed image a few voxels. */
+  typedef itk::ImageRegionIteratorWithIndex< ImageType > IteratorType;
+  const ImageType::RegionType region = fixedImage->GetLargestPossibleRegion();
+  ImageType::Pointer          movingImage = ImageType::New();
+  movingImage->CopyInformation( fixedImage );
+  movingImage->SetRegions( region );
+  movingImage->Allocate();
+  for( IteratorType it( movingImage, region ); !it.IsAtEnd(); ++it )
+  {
+    ImageType::IndexType index = it.GetIndex();
+    index[ 0 ] += 2; index[ 1 ] -= 1;
+    it.Set( region.IsInside( index ) ? fixedImage->GetPixel( index ) : 0.0f );
+  }
+
+  /** Setup the sessions, with different random seeds. */
+  SessionType serialSessions[ NumberOfSessions ];
+  SessionType parallelSessions[ NumberOfSessions ];
+  for( unsigned int i = 0; i < NumberOfSessions; ++i )
+  {
+    serialSessions[ i ].st_FixedImage  = fixedImage;
+    serialSessions[ i ].st_MovingImage = movingImage;
+    serialSessions[ i ].st_RandomSeed  = 121212 + 1000 * i;
+    parallelSessions[ i ]              = serialSessions[ i ];
+  }
+
+  /** Run the sessions one after the other. */
+  for( unsigned int i = 0; i < NumberOfSessions; ++i )
+  {
+    RunSession( serialSessions[ i ] );
+  }
+
+  /** Run the sessions at the same time, each in its own thread. */
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( NumberOfSessions );
+  threader->SetSingleMethod( RunSessionThreaderCallback, parallelSessions );
+  threader->SingleMethodExecute();
+
+  /** Compare. */
+  bool success = true;
+  for( unsigned int i = 0; i < NumberOfSessions; ++i )
+  {
+    if( !serialSessions[ i ].st_Error.empty() || !parallelSessions[ i ].st_Error.empty() )
+    {
+      std::cerr << "ERROR: session " << i << " failed: "
+                << serialSessions[ i ].st_Error << parallelSessions[ i ].st_Error << std::endl;
+      success = false;
+      continue;
+    }
+
+    std::cout << "Session " << i << ": TransformParameters";
+    for( unsigned int j = 0; j < serialSessions[ i ].st_TransformParameters.size(); ++j )
+    {
+      std::cout << " " << serialSessions[ i ].st_TransformParameters[ j ];
+    }
+    std::cout << std::endl;
+
+    if( serialSessions[ i ].st_TransformParameters.empty()
+      || serialSessions[ i ].st_TransformParameters != parallelSessions[ i ].st_TransformParameters )
+    {
+      std::cerr << "ERROR: session " << i << " gives different transform parameters "
+                << "when run in parallel with another session." << std::endl;
+      success = false;
+    }
+  }
+
+  if( !success )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
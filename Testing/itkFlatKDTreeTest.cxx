@@ -0,0 +1,318 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkListSampleCArray.h"
+#include "itkFlatKDTree.h"
+#include "itkFlatKDTreeSearch.h"
+#include "itkANNkDTree.h"
+#include "itkANNBruteForceTree.h"
+#include "itkANNStandardTreeSearch.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cmath>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks the k nearest neighbours that the FlatKDTree finds
+ * against a brute force search, and against the ANN kd and brute force trees.
+ * With an error bound of zero the neighbours must be exact. With a positive
+ * error bound eps the i-th neighbour may be at most a factor 1 + eps further
+ * away than the true i-th neighbour.
+ *
+ * Half of the query points are points of the data set, as in the metric.
+ * Unless ANN_ALLOW_SELF_MATCH is true, points at zero distance from the query
+ * point must then be skipped by all trees.
+ */
+
+typedef itk::Array< double >                                               MeasurementVectorType;
+typedef itk::Statistics::ListSampleCArray< MeasurementVectorType, double > ListSampleType;
+typedef itk::FlatKDTree< ListSampleType >                                  FlatKDTreeType;
+typedef itk::FlatKDTreeSearch< ListSampleType >                            FlatKDTreeSearchType;
+typedef itk::ANNkDTree< ListSampleType >                                   ANNkDTreeType;
+typedef itk::ANNBruteForceTree< ListSampleType >                           ANNBruteForceTreeType;
+typedef itk::ANNStandardTreeSearch< ListSampleType >                       ANNStandardTreeSearchType;
+typedef itk::BinaryTreeSearchBase< ListSampleType >                        TreeSearchType;
+typedef TreeSearchType::IndexArrayType                                     IndexArrayType;
+typedef TreeSearchType::DistanceArrayType                                  DistanceArrayType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator             GeneratorType;
+
+/** Create a list sample of random points. If quantize is true, the
+ * coordinates are rounded to integers, which gives many points at equal
+ * distances from a query point, as the intensities of an image do.
+ */
+ListSampleType::Pointer
+CreateListSample( GeneratorType * generator, const unsigned int dimension,
+  const unsigned long numberOfPoints, const bool quantize )
+{
+  ListSampleType::Pointer listSample = ListSampleType::New();
+  listSample->SetMeasurementVectorSize( dimension );
+  listSample->Resize( numberOfPoints );
+  for( unsigned long p = 0; p < numberOfPoints; ++p )
+  {
+    for( unsigned int d = 0; d < dimension; ++d )
+    {
+      double value = generator->GetUniformVariate( 0.0, 10.0 );
+      if( quantize )
+      {
+        value = std::floor( value );
+      }
+      listSample->SetMeasurement( p, d, value );
+    }
+  }
+  listSample->SetActualSize( numberOfPoints );
+
+  return listSample;
+
+} // end CreateListSample()
+
+
+/** Compute the squared distance between a query point and a point of the
+ * list sample, in the same way as the trees do.
+ */
+double
+ComputeSquaredDistance( const ListSampleType * listSample,
+  const MeasurementVectorType & qp, const int index )
+{
+  const double * point    = listSample->GetInternalContainer()[ index ];
+  double         distance = 0.0;
+  for( unsigned int d = 0; d < qp.GetSize(); ++d )
+  {
+    const double diff = qp[ d ] - point[ d ];
+    distance += diff * diff;
+  }
+
+  return distance;
+
+} // end ComputeSquaredDistance()
+
+
+/** Check the neighbours found by a searcher against the sorted squared
+ * distances to all points. Every index must be valid, be found only once and
+ * have the reported distance, and the distances must increase. With eps = 0
+ * the distances must equal the true ones, otherwise they may be at most a
+ * factor ( 1 + eps )^2 larger.
+ */
+bool
+CheckNeighbours( const std::string & name, const ListSampleType * listSample,
+  const MeasurementVectorType & qp, const std::vector< double > & trueDistances,
+  const double eps, const IndexArrayType & ind, const DistanceArrayType & dists )
+{
+  const unsigned int k      = ind.GetSize();
+  const double       factor = ( 1.0 + eps ) * ( 1.0 + eps );
+  for( unsigned int i = 0; i < k; ++i )
+  {
+    if( ind[ i ] < 0 || static_cast< unsigned long >( ind[ i ] ) >= listSample->Size()
+      || std::find( &ind[ 0 ], &ind[ 0 ] + i, ind[ i ] ) != &ind[ 0 ] + i )
+    {
+      std::cerr << "ERROR: " << name << " finds an invalid index " << ind[ i ]
+                << " as neighbour " << i << "." << std::endl;
+      return false;
+    }
+
+    const double actualDistance = ComputeSquaredDistance( listSample, qp, ind[ i ] );
+    const double tolerance      = 1e-12 * ( 1.0 + trueDistances[ i ] );
+    bool         ok             = std::abs( dists[ i ] - actualDistance ) <= tolerance;
+    ok &= i == 0 || dists[ i - 1 ] <= dists[ i ];
+    if( eps == 0.0 )
+    {
+      ok &= std::abs( dists[ i ] - trueDistances[ i ] ) <= tolerance;
+    }
+    else
+    {
+      ok &= trueDistances[ i ] - tolerance <= dists[ i ]
+        && dists[ i ] <= factor * trueDistances[ i ] + tolerance;
+    }
+    if( !ok )
+    {
+      std::cerr << "ERROR: " << name << " with eps = " << eps
+                << " finds neighbour " << i << " at squared distance " << dists[ i ]
+                << " (actual " << actualDistance << "), while the true squared distance is "
+                << trueDistances[ i ] << "." << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+
+} // end CheckNeighbours()
+
+
+/** Compare the searches of the FlatKDTree, the ANNkDTree and the
+ * ANNBruteForceTree on one data set with a brute force search, for
+ * eps = 0 and eps > 0.
+ */
+int
+TestDataSet( GeneratorType * generator, const unsigned int dimension,
+  const unsigned long numberOfPoints, const bool quantize,
+  const unsigned int bucketSize, const unsigned int k )
+{
+  std::cout << "Testing " << numberOfPoints << ( quantize ? " quantized" : "" )
+            << " points of dimension " << dimension << ", bucket size "
+            << bucketSize << " and k = " << k << std::endl;
+
+  ListSampleType::Pointer listSample
+    = CreateListSample( generator, dimension, numberOfPoints, quantize );
+
+  FlatKDTreeType::Pointer flatTree = FlatKDTreeType::New();
+  flatTree->SetBucketSize( bucketSize );
+  flatTree->SetSample( listSample );
+  flatTree->GenerateTree();
+
+  ANNkDTreeType::Pointer annTree = ANNkDTreeType::New();
+  annTree->SetBucketSize( bucketSize );
+  annTree->SetSplittingRule( "ANN_KD_SL_MIDPT" );
+  annTree->SetSample( listSample );
+  annTree->GenerateTree();
+
+  ANNBruteForceTreeType::Pointer bruteForceTree = ANNBruteForceTreeType::New();
+  bruteForceTree->SetSample( listSample );
+  bruteForceTree->GenerateTree();
+
+  FlatKDTreeSearchType::Pointer flatSearcher = FlatKDTreeSearchType::New();
+  flatSearcher->SetKNearestNeighbors( k );
+  flatSearcher->SetBinaryTree( flatTree );
+  ANNStandardTreeSearchType::Pointer annSearcher = ANNStandardTreeSearchType::New();
+  annSearcher->SetKNearestNeighbors( k );
+  annSearcher->SetBinaryTree( annTree );
+  ANNStandardTreeSearchType::Pointer bruteForceSearcher = ANNStandardTreeSearchType::New();
+  bruteForceSearcher->SetKNearestNeighbors( k );
+  bruteForceSearcher->SetBinaryTree( bruteForceTree );
+
+  const double          errorBounds[ 2 ] = { 0.0, 0.5 };
+  MeasurementVectorType qp( dimension );
+  std::vector< double > trueDistances;
+  IndexArrayType        ind;
+  DistanceArrayType     dists;
+  for( unsigned int q = 0; q < 200; ++q )
+  {
+    /** Alternately a point of the data set, and a point inside or around the data. */
+    if( q % 2 == 0 )
+    {
+      listSample->GetMeasurementVector( q * 7 % numberOfPoints, qp );
+    }
+    else
+    {
+      for( unsigned int d = 0; d < dimension; ++d )
+      {
+        qp[ d ] = generator->GetUniformVariate( -2.0, 12.0 );
+      }
+    }
+
+    /** The sorted squared distances to all points that may be found. */
+    trueDistances.clear();
+    for( unsigned long p = 0; p < numberOfPoints; ++p )
+    {
+      const double distance = ComputeSquaredDistance( listSample, qp, static_cast< int >( p ) );
+      if( distance != 0.0 || ANN_ALLOW_SELF_MATCH )
+      {
+        trueDistances.push_back( distance );
+      }
+    }
+    std::sort( trueDistances.begin(), trueDistances.end() );
+
+    for( unsigned int e = 0; e < 2; ++e )
+    {
+      flatSearcher->SetErrorBound( errorBounds[ e ] );
+      flatSearcher->Search( qp, ind, dists );
+      if( !CheckNeighbours( "FlatKDTree", listSample, qp, trueDistances,
+        errorBounds[ e ], ind, dists ) )
+      {
+        return EXIT_FAILURE;
+      }
+
+      annSearcher->SetErrorBound( errorBounds[ e ] );
+      annSearcher->Search( qp, ind, dists );
+      if( !CheckNeighbours( "ANNkDTree", listSample, qp, trueDistances,
+        errorBounds[ e ], ind, dists ) )
+      {
+        return EXIT_FAILURE;
+      }
+    }
+
+    bruteForceSearcher->Search( qp, ind, dists );
+    if( !CheckNeighbours( "ANNBruteForceTree", listSample, qp, trueDistances,
+      0.0, ind, dists ) )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+
+} // end TestDataSet()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( void )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 121212 );
+
+  try
+  {
+    /** Several leaf sizes, including leaves of a single point, and spaces
+     * of the dimensions of the fixed, moving and joint samples of the
+     * KNN graph alpha-mutual information metric.
+     */
+    if( TestDataSet( generator, 1, 500, false, 1, 5 ) != EXIT_SUCCESS
+      || TestDataSet( generator, 2, 2000, false, 8, 5 ) != EXIT_SUCCESS
+      || TestDataSet( generator, 2, 2000, true, 8, 5 ) != EXIT_SUCCESS
+      || TestDataSet( generator, 3, 1000, false, 3, 10 ) != EXIT_SUCCESS
+      || TestDataSet( generator, 4, 1000, true, 16, 20 ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+
+    /** With fewer points than neighbours, the remaining indices are -1. */
+    ListSampleType::Pointer listSample = CreateListSample( generator, 2, 3, false );
+    FlatKDTreeType::Pointer flatTree   = FlatKDTreeType::New();
+    flatTree->SetSample( listSample );
+    flatTree->GenerateTree();
+    FlatKDTreeSearchType::Pointer flatSearcher = FlatKDTreeSearchType::New();
+    flatSearcher->SetKNearestNeighbors( 5 );
+    flatSearcher->SetBinaryTree( flatTree );
+
+    MeasurementVectorType qp( 2 );
+    qp.Fill( 5.5 );
+    IndexArrayType    ind;
+    DistanceArrayType dists;
+    flatSearcher->Search( qp, ind, dists );
+    for( unsigned int i = 0; i < 5; ++i )
+    {
+      if( ( i < 3 ) != ( ind[ i ] >= 0 ) )
+      {
+        std::cerr << "ERROR: with 3 points, neighbour " << i << " has index "
+                  << ind[ i ] << "." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
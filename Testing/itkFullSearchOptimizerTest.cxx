@@ -0,0 +1,337 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "FullSearch/itkFullSearchOptimizer.h"
+#include "itkMultiThreader.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the coarse-to-fine search and the pruned search of
+ * the FullSearchOptimizer find the same optimum as the search of the full
+ * grid, both when minimizing and when maximizing, and that they evaluate
+ * fewer points. The cost function is a separable, anisotropic quadratic
+ * with its optimum between the grid points; the pruning cost function
+ * deviates from it by at most 0.1.
+ *
+ * Each search is also run with N threads, on copies of the cost functions,
+ * and should then evaluate and prune exactly the same points. The cost
+ * function keeps its residuals in a member, like a metric keeps its
+ * transform parameters, so each copy has its own state.
+ */
+
+namespace itk
+{
+
+class FullSearchTestCostFunction : public SingleValuedCostFunction
+{
+public:
+
+  typedef FullSearchTestCostFunction Self;
+  typedef SingleValuedCostFunction   Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( FullSearchTestCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::ParametersType ParametersType;
+  typedef Superclass::DerivativeType DerivativeType;
+  typedef Superclass::MeasureType    MeasureType;
+
+  itkStaticConstMacro( SpaceDimension, unsigned int, 4 );
+
+  /** The sign of the function: -1 to test maximization. */
+  itkSetMacro( Sign, double );
+
+  /** The amplitude of the deviation, for the pruning cost function. */
+  itkSetMacro( Deviation, double );
+
+  /** The number of times GetValue() was called. */
+  itkGetConstMacro( NumberOfEvaluations, unsigned long );
+
+  virtual unsigned int GetNumberOfParameters( void ) const
+  {
+    return SpaceDimension;
+  }
+
+
+  /** f(x) = sum_i w_i ( x_i - c_i )^2 + d sin( 7 x_0 + 3 x_1 + x_2 ).
+   * Parameter 3 is not searched. */
+  virtual MeasureType GetValue( const ParametersType & parameters ) const
+  {
+    const double center[ 3 ] = { 2.3, -3.7, 1.1 };
+    const double weight[ 3 ] = { 1.0, 4.0, 0.5 };
+    this->m_Residuals.SetSize( 3 );
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+      this->m_Residuals[ i ] = parameters[ i ] - center[ i ];
+    }
+    MeasureType value = 0.0;
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+      value += weight[ i ] * this->m_Residuals[ i ] * this->m_Residuals[ i ];
+    }
+    value += this->m_Deviation
+      * std::sin( 7.0 * parameters[ 0 ] + 3.0 * parameters[ 1 ] + parameters[ 2 ] );
+    ++this->m_NumberOfEvaluations;
+    return this->m_Sign * ( value + parameters[ 3 ] );
+  }
+
+
+  virtual void GetDerivative( const ParametersType &, DerivativeType & ) const
+  {
+    itkExceptionMacro( << "Not implemented" );
+  }
+
+
+protected:
+
+  FullSearchTestCostFunction() : m_Sign( 1.0 ), m_Deviation( 0.0 ), m_NumberOfEvaluations( 0 ) {}
+  virtual ~FullSearchTestCostFunction() {}
+
+private:
+
+  FullSearchTestCostFunction( const Self & ); // purposely not implemented
+  void operator=( const Self & );             // purposely not implemented
+
+  double                 m_Sign;
+  double                 m_Deviation;
+  mutable ParametersType m_Residuals;
+  mutable unsigned long  m_NumberOfEvaluations;
+
+};
+
+} // end namespace itk
+
+typedef itk::FullSearchOptimizer        OptimizerType;
+typedef itk::FullSearchTestCostFunction CostFunctionType;
+typedef OptimizerType::ParametersType   ParametersType;
+
+/** The number of evaluations of a cost function and its copies. */
+unsigned long
+GetNumberOfEvaluations( const CostFunctionType * costFunction,
+  const OptimizerType::CostFunctionContainerType & clones )
+{
+  unsigned long numberOfEvaluations = costFunction->GetNumberOfEvaluations();
+  for( unsigned int i = 0; i < clones.size(); ++i )
+  {
+    numberOfEvaluations
+      += static_cast< const CostFunctionType * >( clones[ i ].GetPointer() )->GetNumberOfEvaluations();
+  }
+  return numberOfEvaluations;
+
+} // end GetNumberOfEvaluations()
+
+
+/** Run a search with the given number of threads, and check that each point
+ * was evaluated exactly once, by the cost function or one of its copies.
+ */
+bool
+RunSearch( const std::string & name, const bool maximize,
+  const unsigned int coarseGridStride, const bool prune,
+  const itk::ThreadIdType numberOfThreads, OptimizerType::Pointer & optimizer )
+{
+  const double sign = maximize ? -1.0 : 1.0;
+
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+  costFunction->SetSign( sign );
+  CostFunctionType::Pointer pruningCostFunction = CostFunctionType::New();
+  pruningCostFunction->SetSign( sign );
+  pruningCostFunction->SetDeviation( 0.1 );
+
+  OptimizerType::CostFunctionContainerType clones;
+  OptimizerType::CostFunctionContainerType pruningClones;
+  for( itk::ThreadIdType i = 1; i < numberOfThreads; ++i )
+  {
+    CostFunctionType::Pointer clone = CostFunctionType::New();
+    clone->SetSign( sign );
+    clones.push_back( clone.GetPointer() );
+    CostFunctionType::Pointer pruningClone = CostFunctionType::New();
+    pruningClone->SetSign( sign );
+    pruningClone->SetDeviation( 0.1 );
+    pruningClones.push_back( pruningClone.GetPointer() );
+  }
+
+  ParametersType initialPosition( costFunction->GetNumberOfParameters() );
+  initialPosition.Fill( 0.0 );
+  initialPosition[ 3 ] = 0.25;
+
+  optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetInitialPosition( initialPosition );
+  optimizer->SetMaximize( maximize );
+  optimizer->AddSearchDimension( 0, -10.0, 10.0, 0.5 );
+  optimizer->AddSearchDimension( 1, -8.0, 8.0, 0.5 );
+  optimizer->AddSearchDimension( 2, -5.0, 5.0, 0.5 );
+  optimizer->SetCoarseGridStride( coarseGridStride );
+  optimizer->SetNumberOfRefinedPoints( 2 );
+  optimizer->SetNumberOfThreads( numberOfThreads );
+  optimizer->SetCostFunctionClones( clones );
+  if( prune )
+  {
+    /** The pruning value differs at most 0.1 from the value, so with a
+     * margin of 0.2 the optimum is never pruned. */
+    optimizer->SetPruningCostFunction( pruningCostFunction );
+    optimizer->SetPruningCostFunctionClones( pruningClones );
+    optimizer->SetPruningMargin( 0.2 );
+  }
+  optimizer->StartOptimization();
+
+  std::cout << name << ", " << numberOfThreads << " thread(s): best value "
+            << optimizer->GetBestValue()
+            << " at " << optimizer->GetBestPointInSearchSpace()
+            << ", " << optimizer->GetCurrentIteration() << " of "
+            << optimizer->GetNumberOfIterations() << " points evaluated, "
+            << optimizer->GetNumberOfPrunedPoints() << " pruned" << std::endl;
+
+  const unsigned long numberOfEvaluations = GetNumberOfEvaluations( costFunction, clones );
+  if( numberOfEvaluations != optimizer->GetCurrentIteration() )
+  {
+    std::cerr << "ERROR: " << name << " evaluates the cost function " << numberOfEvaluations
+              << " times for " << optimizer->GetCurrentIteration() << " points." << std::endl;
+    return false;
+  }
+  if( prune && GetNumberOfEvaluations( pruningCostFunction, pruningClones )
+    != optimizer->GetCurrentIteration() + optimizer->GetNumberOfPrunedPoints() )
+  {
+    std::cerr << "ERROR: " << name << " does not evaluate the pruning cost function "
+              << "once for each point." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end RunSearch()
+
+
+/** Compare a search with the search of the full grid. */
+bool
+CompareWithFullSearch( const std::string & name, const bool prune,
+  const OptimizerType * optimizer, const OptimizerType * fullSearch )
+{
+  if( optimizer->GetBestValue() != fullSearch->GetBestValue()
+    || optimizer->GetBestIndexInSearchSpace() != fullSearch->GetBestIndexInSearchSpace()
+    || optimizer->GetCurrentPosition() != fullSearch->GetCurrentPosition() )
+  {
+    std::cerr << "ERROR: " << name << " finds " << optimizer->GetBestPointInSearchSpace()
+              << " instead of " << fullSearch->GetBestPointInSearchSpace() << std::endl;
+    return false;
+  }
+  if( optimizer->GetCurrentIteration() >= fullSearch->GetCurrentIteration() )
+  {
+    std::cerr << "ERROR: " << name << " does not evaluate fewer points." << std::endl;
+    return false;
+  }
+  if( prune && optimizer->GetNumberOfPrunedPoints() == 0 )
+  {
+    std::cerr << "ERROR: " << name << " does not prune any point." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end CompareWithFullSearch()
+
+
+/** Compare the multi-threaded search with the single-threaded one. */
+bool
+CompareThreads( const std::string & name,
+  const OptimizerType * serial, const OptimizerType * threaded )
+{
+  if( threaded->GetBestValue() != serial->GetBestValue()
+    || threaded->GetBestIndexInSearchSpace() != serial->GetBestIndexInSearchSpace()
+    || threaded->GetCurrentPosition() != serial->GetCurrentPosition()
+    || threaded->GetCurrentIteration() != serial->GetCurrentIteration()
+    || threaded->GetNumberOfPrunedPoints() != serial->GetNumberOfPrunedPoints() )
+  {
+    std::cerr << "ERROR: " << name << " gives a different result with multiple threads." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end CompareThreads()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  itk::ThreadIdType numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  if( numberOfThreads < 2 ) { numberOfThreads = 2; }
+
+  /** The searches: the full grid first, as the reference. */
+  const unsigned int numberOfSearches = 4;
+  const char *       searchNames[ numberOfSearches ] = {
+    "full grid", "coarse-to-fine", "pruned", "coarse-to-fine and pruned"
+  };
+  const unsigned int coarseGridStrides[ numberOfSearches ] = { 1, 8, 1, 8 };
+  const bool         prune[ numberOfSearches ]             = { false, false, true, true };
+
+  bool success = true;
+  try
+  {
+    for( unsigned int m = 0; m < 2; ++m )
+    {
+      const bool             maximize = ( m == 1 );
+      const std::string      prefix   = maximize ? "Maximize, " : "Minimize, ";
+      OptimizerType::Pointer fullSearch;
+      for( unsigned int s = 0; s < numberOfSearches; ++s )
+      {
+        const std::string      name = prefix + searchNames[ s ];
+        OptimizerType::Pointer serial;
+        OptimizerType::Pointer threaded;
+        success &= RunSearch( name, maximize, coarseGridStrides[ s ], prune[ s ], 1, serial );
+        success &= RunSearch( name, maximize, coarseGridStrides[ s ], prune[ s ],
+          numberOfThreads, threaded );
+        success &= CompareThreads( name, serial, threaded );
+
+        if( s == 0 )
+        {
+          fullSearch = serial;
+          if( fullSearch->GetCurrentIteration() != fullSearch->GetNumberOfIterations() )
+          {
+            std::cerr << "ERROR: the full search does not evaluate all points." << std::endl;
+            success = false;
+          }
+        }
+        else
+        {
+          success &= CompareWithFullSearch( name, prune[ s ], serial, fullSearch );
+        }
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if( !success )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,153 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageCache.h"
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that a GenericMultiResolutionPyramidImageFilter with an
+ * ImageCache reuses the levels that another pyramid on the same input has
+ * computed, that the reused levels are equal to computed ones, and that
+ * computing a level again does not overwrite the cached image.
+ */
+
+const unsigned int Dimension = 2;
+typedef float                                      PixelType;
+typedef itk::Image< PixelType, Dimension >         ImageType;
+typedef itk::GenericMultiResolutionPyramidImageFilter<
+  ImageType, ImageType >                           PyramidType;
+typedef PyramidType::ScheduleType                  ScheduleType;
+typedef itk::ImageCache                            CacheType;
+
+/** Return true if two images have the same size and pixel values. */
+bool
+AreEqual( const ImageType * image1, const ImageType * image2 )
+{
+  if( image1->GetLargestPossibleRegion() != image2->GetLargestPossibleRegion() )
+  {
+    return false;
+  }
+  itk::ImageRegionConstIterator< ImageType > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< ImageType > it2( image2, image2->GetLargestPossibleRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+  {
+    if( it1.Get() != it2.Get() ) { return false; }
+  }
+  return true;
+
+} // end AreEqual()
+
+
+/** Create a pyramid with a schedule that halves the image per level. */
+PyramidType::Pointer
+CreatePyramid( ImageType * image, const unsigned int numberOfLevels, CacheType * cache )
+{
+  PyramidType::Pointer pyramid = PyramidType::New();
+  pyramid->SetInput( image );
+  pyramid->SetNumberOfLevels( numberOfLevels );
+  ScheduleType schedule( numberOfLevels, Dimension );
+  for( unsigned int level = 0; level < numberOfLevels; ++level )
+  {
+    for( unsigned int dim = 0; dim < Dimension; ++dim )
+    {
+      schedule[ level ][ dim ] = 1 << ( numberOfLevels - level - 1 );
+    }
+  }
+  pyramid->SetSchedule( schedule );
+  pyramid->SetImageCache( cache );
+  return pyramid;
+
+} // end CreatePyramid()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( void )
+{
+  /** Create an image with a smooth intensity pattern. */
+  ImageType::SizeType size;
+  size.Fill( 64 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< PixelType >( index[ 0 ] * index[ 0 ] + 3.0 * index[ 1 ] ) );
+  }
+
+  CacheType::Pointer cache = CacheType::New();
+
+  try
+  {
+    /** A pyramid with levels 4 2 1 fills the cache. */
+    PyramidType::Pointer pyramid1 = CreatePyramid( image, 3, cache );
+    pyramid1->Update();
+    if( cache->GetNumberOfEntries() != 3 || cache->GetNumberOfHits() != 0 )
+    {
+      std::cerr << "ERROR: the levels were not stored in the cache." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** A pyramid with levels 2 1 reuses two levels. */
+    PyramidType::Pointer pyramid2 = CreatePyramid( image, 2, cache );
+    pyramid2->Update();
+    if( cache->GetNumberOfEntries() != 3 || cache->GetNumberOfHits() != 2 )
+    {
+      std::cerr << "ERROR: the levels were not reused." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** The reused levels equal computed levels. */
+    PyramidType::Pointer pyramid3 = CreatePyramid( image, 2, NULL );
+    pyramid3->Update();
+    for( unsigned int level = 0; level < 2; ++level )
+    {
+      if( !AreEqual( pyramid2->GetOutput( level ), pyramid3->GetOutput( level ) ) )
+      {
+        std::cerr << "ERROR: reused level " << level << " differs." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    /** A modified input is not found in the cache, and computing the levels
+     * again does not change the cached images.
+     */
+    image->GetPixelContainer()->GetBufferPointer()[ 0 ] += 1000.0f;
+    image->Modified();
+    pyramid2->Update();
+    if( cache->GetNumberOfEntries() != 5 || cache->GetNumberOfHits() != 2
+      || !AreEqual( pyramid1->GetOutput( 2 ), pyramid3->GetOutput( 1 ) ) )
+    {
+      std::cerr << "ERROR: a cached level was overwritten." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
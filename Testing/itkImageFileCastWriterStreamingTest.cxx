@@ -0,0 +1,211 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageFileCastWriter.h"
+#include "itkImageFileReader.h"
+#include "itkResampleImageFilter.h"
+#include "itkTranslationTransform.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that writing a resampled image in stream divisions with
+ * the ImageFileCastWriter gives the same file contents as writing it at once:
+ * with and without conversion of the component type, with an uncompressed
+ * (streamable) and a compressed (not streamable) file, and with a resampler
+ * that was already updated completely before writing, and that was not.
+ * It also checks that the resampler really is updated slab by slab when the
+ * file can be streamed.
+ */
+
+const unsigned int Dimension = 3;
+typedef float                                              PixelType;
+typedef itk::Image< PixelType, Dimension >                 ImageType;
+typedef itk::ResampleImageFilter< ImageType, ImageType >   ResamplerType;
+typedef itk::TranslationTransform< double, Dimension >     TransformType;
+typedef itk::LinearInterpolateImageFunction< ImageType >   InterpolatorType;
+typedef itk::ImageFileCastWriter< ImageType >              WriterType;
+typedef itk::ImageFileReader< ImageType >                  ReaderType;
+
+/** Write the output of the resampler, and read the file back. */
+ImageType::Pointer
+WriteAndRead( ResamplerType * resampler, const std::string & fileName,
+  const std::string & componentType, const bool compress,
+  const unsigned int numberOfStreamDivisions, const bool updateFirst )
+{
+  resampler->Modified();
+  if( updateFirst )
+  {
+    resampler->Update();
+  }
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( resampler->GetOutput() );
+  writer->SetFileName( fileName.c_str() );
+  writer->SetOutputComponentType( componentType.c_str() );
+  writer->SetUseCompression( compress );
+  writer->SetNumberOfStreamDivisions( numberOfStreamDivisions );
+  writer->Update();
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName.c_str() );
+  reader->Update();
+  return reader->GetOutput();
+
+} // end WriteAndRead()
+
+
+/** Are two images equal, pixel by pixel? */
+bool
+AreEqual( const ImageType * image, const ImageType * reference )
+{
+  if( image->GetLargestPossibleRegion() != reference->GetLargestPossibleRegion() )
+  {
+    return false;
+  }
+  typedef itk::ImageRegionConstIterator< ImageType > IteratorType;
+  IteratorType it( image, image->GetLargestPossibleRegion() );
+  IteratorType rit( reference, reference->GetLargestPossibleRegion() );
+  for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+  {
+    if( it.Get() != rit.Get() )
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end AreEqual()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Some basic checks. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify the output directory." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string outputDirectory = argv[ 1 ];
+
+  /** A smooth test image, of a size that the stream divisions do not divide. */
+  ImageType::SizeType size;
+  size[ 0 ] = 23; size[ 1 ] = 19; size[ 2 ] = 11;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< PixelType >( 1000.0 * std::sin( 0.3 * index[ 0 ] )
+      * std::cos( 0.2 * index[ 1 ] ) + 30.0 * index[ 2 ] ) );
+  }
+
+  /** Resample it with a translation of a fraction of a voxel. */
+  TransformType::Pointer          transform = TransformType::New();
+  TransformType::OutputVectorType translation;
+  translation[ 0 ] = 0.35; translation[ 1 ] = -0.6; translation[ 2 ] = 0.2;
+  transform->Translate( translation );
+
+  ResamplerType::Pointer resampler = ResamplerType::New();
+  resampler->SetInput( image );
+  resampler->SetTransform( transform );
+  resampler->SetInterpolator( InterpolatorType::New() );
+  resampler->UseReferenceImageOn();
+  resampler->SetReferenceImage( image );
+
+  const unsigned int numberOfComponentTypes                   = 2;
+  const char *       componentTypes[ numberOfComponentTypes ] = { "float", "short" };
+  const unsigned int numberOfDivisions                        = 2;
+  const unsigned int divisions[ numberOfDivisions ]           = { 4, 7 };
+
+  bool success = true;
+  try
+  {
+    for( unsigned int c = 0; c < numberOfComponentTypes; ++c )
+    {
+      /** The reference: written at once. */
+      const std::string  prefix    = outputDirectory + "/ImageFileCastWriterStreamingTest_" + componentTypes[ c ];
+      ImageType::Pointer reference = WriteAndRead( resampler, prefix + "_reference.mhd",
+        componentTypes[ c ], false, 1, false );
+
+      for( unsigned int compress = 0; compress < 2; ++compress )
+      {
+        for( unsigned int d = 0; d < numberOfDivisions; ++d )
+        {
+          for( unsigned int updateFirst = 0; updateFirst < 2; ++updateFirst )
+          {
+            std::ostringstream name;
+            name << componentTypes[ c ] << ", " << ( compress ? "compressed" : "uncompressed" )
+                 << ", " << divisions[ d ] << " stream divisions"
+                 << ( updateFirst ? ", resampler updated first" : "" );
+            std::ostringstream fileName;
+            fileName << prefix << "_" << compress << "_" << divisions[ d ] << "_" << updateFirst << ".mhd";
+
+            ImageType::Pointer streamed = WriteAndRead( resampler, fileName.str(),
+              componentTypes[ c ], compress != 0, divisions[ d ], updateFirst != 0 );
+            std::cout << name.str() << ": resampler buffered "
+                      << resampler->GetOutput()->GetBufferedRegion().GetSize() << std::endl;
+
+            if( !AreEqual( streamed, reference ) )
+            {
+              std::cerr << "ERROR: the image written with " << name.str()
+                        << " differs from the image written at once." << std::endl;
+              success = false;
+            }
+
+            /** Without compression, the writer should update the resampler
+             * one slab at a time; with compression it cannot stream, and
+             * falls back to a single update. */
+            const bool bufferedInFull = resampler->GetOutput()->GetBufferedRegion()
+              == resampler->GetOutput()->GetLargestPossibleRegion();
+            if( !updateFirst && bufferedInFull == !compress )
+            {
+              std::cerr << "ERROR: the resampler is " << ( bufferedInFull ? "" : "not " )
+                        << "updated in full with " << name.str() << "." << std::endl;
+              success = false;
+            }
+          }
+        }
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if( !success )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,169 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRandomCoordinateSampler.h"
+#include "itkImageRandomSamplerSparseMask.h"
+#include "itkImageMaskSpatialObject.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the multi-threaded ImageRandomCoordinateSampler and
+ * ImageRandomSamplerSparseMask generate the same samples for a fixed seed,
+ * independent of the number of threads, with and without a mask.
+ */
+
+const unsigned int Dimension = 3;
+typedef float                                          PixelType;
+typedef itk::Image< PixelType, Dimension >             ImageType;
+typedef itk::Image< unsigned char, Dimension >         MaskImageType;
+typedef itk::ImageMaskSpatialObject< Dimension >       MaskType;
+typedef itk::ImageSamplerBase< ImageType >             SamplerBaseType;
+typedef SamplerBaseType::ImageSampleContainerType      SampleContainerType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+/** Generate the samples with a fixed seed and a given number of threads. */
+void
+GenerateSamples( SamplerBaseType * sampler, const unsigned int numberOfThreads,
+  std::vector< SamplerBaseType::ImageSampleType > & samples )
+{
+  GeneratorType::GetInstance()->SetSeed( 121212 );
+  sampler->SetNumberOfThreads( numberOfThreads );
+  sampler->Modified();
+  sampler->Update();
+
+  SampleContainerType * container = sampler->GetOutput();
+  samples.assign( container->begin(), container->end() );
+
+} // end GenerateSamples()
+
+
+/** Compare the samples generated with one and with several threads. */
+int
+CompareThreads( const std::string & name, SamplerBaseType * sampler )
+{
+  std::vector< SamplerBaseType::ImageSampleType > samples1, samplesN;
+  GenerateSamples( sampler, 1, samples1 );
+  GenerateSamples( sampler, 4, samplesN );
+
+  std::cout << name << ": " << samples1.size() << " / " << samplesN.size() << " samples." << std::endl;
+  if( samples1.size() != 2000 || samples1.size() != samplesN.size() )
+  {
+    std::cerr << "ERROR: " << name << " generated a wrong number of samples." << std::endl;
+    return EXIT_FAILURE;
+  }
+  for( std::size_t i = 0; i < samples1.size(); ++i )
+  {
+    if( samples1[ i ].m_ImageCoordinates != samplesN[ i ].m_ImageCoordinates
+      || samples1[ i ].m_ImageValue != samplesN[ i ].m_ImageValue )
+    {
+      std::cerr << "ERROR: " << name << " sample " << i
+                << " depends on the number of threads." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** A new update should give new samples. */
+  GeneratorType::GetInstance()->SetSeed( 121212 );
+  sampler->Modified();
+  sampler->Update();
+  sampler->Modified();
+  sampler->Update();
+  if( sampler->GetOutput()->ElementAt( 0 ).m_ImageCoordinates == samples1[ 0 ].m_ImageCoordinates )
+  {
+    std::cerr << "ERROR: " << name << " did not generate new samples." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end CompareThreads()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( void )
+{
+  /** Create an image with a smooth intensity pattern, and a spherical mask. */
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  MaskImageType::Pointer maskImage = MaskImageType::New();
+  maskImage->SetRegions( size );
+  maskImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType >     it( image, image->GetLargestPossibleRegion() );
+  itk::ImageRegionIteratorWithIndex< MaskImageType > mit( maskImage, maskImage->GetLargestPossibleRegion() );
+  for( it.GoToBegin(), mit.GoToBegin(); !it.IsAtEnd(); ++it, ++mit )
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    double                     r2    = 0.0;
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      r2 += ( index[ i ] - 15.5 ) * ( index[ i ] - 15.5 );
+    }
+    it.Set( static_cast< PixelType >( index[ 0 ] + 2.0 * index[ 1 ] - index[ 2 ] ) );
+    mit.Set( r2 < 100.0 ? 1 : 0 );
+  }
+
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetImage( maskImage );
+
+  typedef itk::ImageRandomCoordinateSampler< ImageType >  CoordinateSamplerType;
+  typedef itk::ImageRandomSamplerSparseMask< ImageType > SparseMaskSamplerType;
+
+  try
+  {
+    /** The random coordinate sampler, without and with a mask. */
+    CoordinateSamplerType::Pointer coordinateSampler = CoordinateSamplerType::New();
+    coordinateSampler->SetInput( image );
+    coordinateSampler->SetNumberOfSamples( 2000 );
+    coordinateSampler->SetUseMultiThread( true );
+    if( CompareThreads( "RandomCoordinate", coordinateSampler ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+    coordinateSampler->SetMask( mask );
+    if( CompareThreads( "RandomCoordinate with mask", coordinateSampler ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+
+    /** The sparse mask sampler. */
+    SparseMaskSamplerType::Pointer sparseMaskSampler = SparseMaskSamplerType::New();
+    sparseMaskSampler->SetInput( image );
+    sparseMaskSampler->SetMask( mask );
+    sparseMaskSampler->SetNumberOfSamples( 2000 );
+    sparseMaskSampler->SetUseMultiThread( true );
+    if( CompareThreads( "RandomSparseMask", sparseMaskSampler ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
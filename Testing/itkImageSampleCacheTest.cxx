@@ -0,0 +1,149 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageSampleCache.h"
+#include "itkImageFullSampler.h"
+#include "itkImageGridSampler.h"
+#include "itkImageRandomSampler.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the deterministic image samplers give equal sample
+ * set signatures if and only if they produce the same samples, and that
+ * the ImageSampleCache stores and clears its entries.
+ */
+
+const unsigned int Dimension = 2;
+typedef float                                 PixelType;
+typedef itk::Image< PixelType, Dimension >    ImageType;
+typedef itk::ImageFullSampler< ImageType >    FullSamplerType;
+typedef itk::ImageGridSampler< ImageType >    GridSamplerType;
+typedef itk::ImageRandomSampler< ImageType >  RandomSamplerType;
+typedef itk::ImageSampleCache                 CacheType;
+
+/** Update the sampler and get its signature. */
+std::string
+GetSignature( itk::ImageSamplerBase< ImageType > * sampler )
+{
+  sampler->Update();
+  std::string signature;
+  if( !sampler->GetSampleSetSignature( signature ) ) { return ""; }
+  return signature;
+
+} // end GetSignature()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( void )
+{
+  ImageType::SizeType size;
+  size.Fill( 16 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  image->FillBuffer( 1.0f );
+
+  GridSamplerType::SampleGridSpacingType spacing;
+  spacing.Fill( 2 );
+
+  try
+  {
+    /** Two grid samplers with the same settings share the signature. */
+    GridSamplerType::Pointer grid1 = GridSamplerType::New();
+    GridSamplerType::Pointer grid2 = GridSamplerType::New();
+    grid1->SetInput( image );
+    grid2->SetInput( image );
+    grid1->SetSampleGridSpacing( spacing );
+    grid2->SetSampleGridSpacing( spacing );
+    const std::string gridSignature = GetSignature( grid1 );
+    if( gridSignature.empty() || gridSignature != GetSignature( grid2 ) )
+    {
+      std::cerr << "ERROR: equal grid samplers have different signatures." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** Another spacing gives another signature. */
+    spacing.Fill( 3 );
+    grid2->SetSampleGridSpacing( spacing );
+    if( gridSignature == GetSignature( grid2 ) )
+    {
+      std::cerr << "ERROR: the signature does not depend on the grid spacing." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** A full sampler has a different signature; a modified image changes it. */
+    FullSamplerType::Pointer full = FullSamplerType::New();
+    full->SetInput( image );
+    const std::string fullSignature = GetSignature( full );
+    if( fullSignature.empty() || fullSignature == gridSignature )
+    {
+      std::cerr << "ERROR: wrong full sampler signature." << std::endl;
+      return EXIT_FAILURE;
+    }
+    image->Modified();
+    if( fullSignature == GetSignature( full ) )
+    {
+      std::cerr << "ERROR: the signature does not depend on the input image." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** Random samplers do not support a signature. */
+    RandomSamplerType::Pointer random = RandomSamplerType::New();
+    random->SetInput( image );
+    random->SetNumberOfSamples( 100 );
+    if( !GetSignature( random ).empty() )
+    {
+      std::cerr << "ERROR: a random sampler returned a signature." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Store, get and clear an entry. */
+  CacheType::Pointer      cache = CacheType::New();
+  CacheType::EntryPointer entry = CacheType::EntryType::New();
+  entry->Allocate( 10, 4 );
+  entry->GetIndex( 3 )       = 7;
+  entry->GetValues( 3 )[ 2 ] = 0.5;
+  cache->SetEntry( "a", entry );
+
+  CacheType::EntryConstPointer found = cache->GetEntry( "a" );
+  if( found.IsNull() || found->GetNumberOfSamples() != 10
+    || found->GetNumberOfValuesPerSample() != 4
+    || found->GetIndex( 3 ) != 7 || found->GetValues( 3 )[ 2 ] != 0.5
+    || cache->GetEntry( "b" ).IsNotNull()
+    || cache->GetMemorySize() != entry->GetMemorySize() )
+  {
+    std::cerr << "ERROR: the cache did not return the stored entry." << std::endl;
+    return EXIT_FAILURE;
+  }
+  cache->Clear();
+  if( cache->GetNumberOfEntries() != 0 || cache->GetEntry( "a" ).IsNotNull() )
+  {
+    std::cerr << "ERROR: the cache was not cleared." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,90 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkIterationInfoRecorder.h"
+
+#include <iostream>
+#include <sstream>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the IterationInfoRecorder writes all records in
+ * order, also when the ring buffer wraps around, is full, or is smaller
+ * than a record.
+ */
+
+int
+main( void )
+{
+  typedef itk::IterationInfoRecorder RecorderType;
+
+  std::ostringstream output;
+  std::ostringstream expected;
+
+  /** Use a small buffer, so that it wraps around and fills up often. */
+  RecorderType::Pointer recorder = RecorderType::New();
+  recorder->SetOutput( &output );
+  recorder->SetBufferSize( 100 );
+  recorder->Start();
+
+  recorder->Record( "ItNr\tMetric\tTime[ms]\n" );
+  expected << "ItNr\tMetric\tTime[ms]\n";
+  for( unsigned int i = 0; i < 10000; ++i )
+  {
+    std::ostringstream row;
+    row << i << "\t" << 1.0 / ( i + 1.0 ) << "\t" << 0.5 * i << "\n";
+    recorder->Record( row.str() );
+    expected << row.str();
+
+    /** A record that does not fit in the buffer. */
+    if( i % 1000 == 0 )
+    {
+      const std::string longRow( 250, 'x' );
+      recorder->Record( longRow );
+      expected << longRow;
+    }
+  }
+
+  recorder->Flush();
+  if( output.str() != expected.str() )
+  {
+    std::cerr << "ERROR: the recorded rows differ after Flush()." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Stop writes the remaining records; afterwards records are written directly. */
+  recorder->Record( "last\n" );
+  recorder->Stop();
+  recorder->Record( "direct\n" );
+  expected << "last\n" << "direct\n";
+  if( output.str() != expected.str() || recorder->GetStarted() )
+  {
+    std::cerr << "ERROR: the recorded rows differ after Stop()." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << recorder->GetNumberOfRecords() << " records were written in "
+            << recorder->GetNumberOfBatches() << " batches." << std::endl;
+  if( recorder->GetNumberOfRecords() != 10013 )
+  {
+    std::cerr << "ERROR: wrong number of records." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
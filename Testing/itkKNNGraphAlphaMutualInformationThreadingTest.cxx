@@ -0,0 +1,144 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "KNNGraphAlphaMutualInformation/itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
+#include "itkBSplineInterpolateImageFunction.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the KNN graph alpha-mutual information metric gives
+ * the same value and derivative when the nearest neighbours are searched in
+ * parallel, with the thread safe FlatKDTree, as when they are searched by a
+ * single thread. It also checks that the value equals the one found with the
+ * ANN kd tree. The derivatives of the two trees are not compared, since
+ * samples with equal intensities may be found in a different order.
+ */
+
+using namespace MetricTestHelper;
+
+typedef itk::KNNGraphAlphaMutualInformationImageToImageMetric<
+  ImageType, ImageType >                                         KNNMetricType;
+typedef itk::BSplineInterpolateImageFunction<
+  ImageType, double, double >                                    BSplineInterpolatorType;
+
+/** Create a KNN graph alpha-MI metric that uses the flat kd tree or the ANN
+ * kd tree. The metric needs B-spline interpolators for the moving images.
+ */
+KNNMetricType::Pointer
+CreateKNNMetric( ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const bool useFlatKDTree, const bool useMultiThread )
+{
+  KNNMetricType::Pointer metric = KNNMetricType::New();
+  SetupMetric( metric, fixedImage, movingImage, transform, 4 );
+  metric->SetInterpolator( BSplineInterpolatorType::New() );
+  if( useFlatKDTree )
+  {
+    metric->SetFlatKDTree( 8 );
+    metric->SetFlatKDTreeSearch( 10, 0.0 );
+  }
+  else
+  {
+    metric->SetANNkDTree( 8, "ANN_KD_SL_MIDPT" );
+    metric->SetANNStandardTreeSearch( 10, 0.0 );
+  }
+  metric->SetAlpha( 0.5 );
+  metric->SetNumberOfThreads( 4 );
+  metric->SetUseMultiThread( useMultiThread );
+  metric->Initialize();
+
+  return metric;
+
+} // end CreateKNNMetric()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ImageType::Pointer fixedImage, movingImage;
+  if( !ReadTestImages( argv[ 1 ], CosineRemapping, fixedImage, movingImage ) )
+  {
+    return EXIT_FAILURE;
+  }
+  BSplineTransformType::Pointer transform  = CreateBSplineTransform( fixedImage, 4.0 );
+  const ParametersType          parameters = transform->GetParameters();
+
+  try
+  {
+    KNNMetricType::Pointer serialMetric
+      = CreateKNNMetric( fixedImage, movingImage, transform, true, false );
+    KNNMetricType::Pointer threadedMetric
+      = CreateKNNMetric( fixedImage, movingImage, transform, true, true );
+    KNNMetricType::Pointer annMetric
+      = CreateKNNMetric( fixedImage, movingImage, transform, false, false );
+
+    MeasureType    serialValue, threadedValue, repeatedValue;
+    DerivativeType serialDerivative, threadedDerivative, repeatedDerivative;
+    serialMetric->GetValueAndDerivative( parameters, serialValue, serialDerivative );
+    threadedMetric->GetValueAndDerivative( parameters, threadedValue, threadedDerivative );
+
+    /** The second evaluation reuses the tree of the fixed samples. */
+    threadedMetric->GetValueAndDerivative( parameters, repeatedValue, repeatedDerivative );
+
+    const MeasureType serialGetValue   = serialMetric->GetValue( parameters );
+    const MeasureType threadedGetValue = threadedMetric->GetValue( parameters );
+    const MeasureType annGetValue      = annMetric->GetValue( parameters );
+    std::cout << "GetValue serial / threaded / ANN: " << serialGetValue << " / "
+              << threadedGetValue << " / " << annGetValue << std::endl;
+
+    /** The threads only change the order in which the graph lengths are summed. */
+    if( CompareValueAndDerivative( "KNNGraphAlphaMutualInformationImageToImageMetric",
+      "serial", "threaded", serialValue, threadedValue,
+      serialDerivative, threadedDerivative, 1e-10, 1e-10 ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+    if( repeatedValue != threadedValue || repeatedDerivative != threadedDerivative )
+    {
+      std::cerr << "ERROR: repeated threaded evaluations differ." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( std::abs( serialGetValue - serialValue ) > 1e-10 * ( 1.0 + std::abs( serialValue ) )
+      || std::abs( threadedGetValue - serialGetValue ) > 1e-10 * ( 1.0 + std::abs( serialGetValue ) ) )
+    {
+      std::cerr << "ERROR: the serial and threaded GetValue() differ." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( std::abs( annGetValue - serialGetValue ) > 1e-10 * ( 1.0 + std::abs( annGetValue ) ) )
+    {
+      std::cerr << "ERROR: the values of the flat and the ANN kd tree differ." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
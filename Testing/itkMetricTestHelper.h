@@ -0,0 +1,215 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMetricTestHelper_h
+#define __itkMetricTestHelper_h
+
+/** Setup that the metric tests share: a 3D CT image as fixed image, an
+ * intensity remapping of it as moving image, a deformed cubic B-spline
+ * transform covering the fixed image, and a comparison of two values and
+ * derivatives.
+ */
+
+#include "itkAdvancedImageToImageMetric.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageGridSampler.h"
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkImageFileReader.h"
+#include "itkImageRegionIterator.h"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+
+namespace MetricTestHelper
+{
+
+const unsigned int Dimension = 3;
+typedef float                                                    PixelType;
+typedef itk::Image< PixelType, Dimension >                       ImageType;
+typedef itk::AdvancedBSplineDeformableTransform<
+  double, Dimension, 3 >                                         BSplineTransformType;
+typedef itk::ImageGridSampler< ImageType >                       GridSamplerType;
+typedef itk::AdvancedLinearInterpolateImageFunction< ImageType > InterpolatorType;
+typedef itk::AdvancedImageToImageMetric< ImageType, ImageType >  MetricType;
+typedef MetricType::TransformType                                TransformType;
+typedef MetricType::ParametersType                               ParametersType;
+typedef MetricType::DerivativeType                               DerivativeType;
+typedef MetricType::MeasureType                                  MeasureType;
+
+/** LinearRemapping mimics a mono-modal pair (suited for mean squares and
+ * normalized correlation), CosineRemapping a multi-modal CT/MR pair (suited
+ * for mutual information).
+ */
+typedef enum {
+  LinearRemapping,
+  CosineRemapping
+} IntensityRemappingType;
+
+/** Read the fixed image and create the moving image by remapping its
+ * intensities. Returns false, after reporting the error, if reading fails.
+ */
+inline bool
+ReadTestImages( const char * fileName, const IntensityRemappingType remapping,
+  ImageType::Pointer & fixedImage, ImageType::Pointer & movingImage )
+{
+  typedef itk::ImageFileReader< ImageType >     ReaderType;
+  typedef itk::ImageRegionIterator< ImageType > IteratorType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  try
+  {
+    reader->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return false;
+  }
+  fixedImage = reader->GetOutput();
+
+  movingImage = ImageType::New();
+  movingImage->CopyInformation( fixedImage );
+  movingImage->SetRegions( fixedImage->GetLargestPossibleRegion() );
+  movingImage->Allocate();
+  IteratorType fit( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  IteratorType mit( movingImage, movingImage->GetLargestPossibleRegion() );
+  for( fit.GoToBegin(), mit.GoToBegin(); !fit.IsAtEnd(); ++fit, ++mit )
+  {
+    const double value = fit.Get();
+    if( remapping == LinearRemapping )
+    {
+      mit.Set( static_cast< PixelType >( 0.8 * value + 30.0 ) );
+    }
+    else
+    {
+      mit.Set( static_cast< PixelType >( 1000.0 * std::cos( value / 400.0 ) ) );
+    }
+  }
+
+  return true;
+
+} // end ReadTestImages()
+
+
+/** Create a cubic B-spline transform covering the fixed image, with a control
+ * point spacing of 20 mm and one extra control point on either side, and give
+ * it the smooth, deterministic deformation amplitude * sin( 0.37 i ).
+ */
+inline BSplineTransformType::Pointer
+CreateBSplineTransform( const ImageType * fixedImage, const double amplitude )
+{
+  const ImageType::RegionType         region  = fixedImage->GetLargestPossibleRegion();
+  const ImageType::SpacingType        spacing = fixedImage->GetSpacing();
+  BSplineTransformType::OriginType    gridOrigin;
+  BSplineTransformType::SpacingType   gridSpacing;
+  BSplineTransformType::RegionType    gridRegion;
+  BSplineTransformType::SizeType      gridSize;
+  BSplineTransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    const double extent = ( region.GetSize()[ i ] - 1 ) * spacing[ i ];
+    gridSpacing[ i ] = 20.0;
+    gridOrigin[ i ]  = fixedImage->GetOrigin()[ i ] - gridSpacing[ i ];
+    gridSize[ i ]    = static_cast< unsigned long >( std::ceil( extent / gridSpacing[ i ] ) ) + 3;
+  }
+  gridRegion.SetSize( gridSize );
+
+  BSplineTransformType::Pointer transform = BSplineTransformType::New();
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridDirection( gridDirection );
+
+  ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = amplitude * std::sin( 0.37 * i );
+  }
+  transform->SetParametersByValue( parameters );
+
+  return transform;
+
+} // end CreateBSplineTransform()
+
+
+/** Setup the parts that all metrics share: the images, the transform, a
+ * linear interpolator and a grid sampler with the given grid spacing.
+ */
+inline void
+SetupMetric( MetricType * metric, ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const unsigned int sampleGridSpacing )
+{
+  GridSamplerType::Pointer               sampler      = GridSamplerType::New();
+  InterpolatorType::Pointer              interpolator = InterpolatorType::New();
+  GridSamplerType::SampleGridSpacingType gridSpacing;
+  gridSpacing.Fill( sampleGridSpacing );
+  sampler->SetSampleGridSpacing( gridSpacing );
+
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( interpolator );
+  metric->SetImageSampler( sampler );
+
+} // end SetupMetric()
+
+
+/** Compare the values and derivatives of two ways of computing a metric.
+ * The value tolerance is relative to 1 + |valueA|, the derivative tolerance
+ * relative to the largest component of derivativeA. A zero derivative is an
+ * error too, since it makes the comparison meaningless.
+ */
+inline int
+CompareValueAndDerivative( const std::string & name,
+  const std::string & labelA, const std::string & labelB,
+  const MeasureType valueA, const MeasureType valueB,
+  const DerivativeType & derivativeA, const DerivativeType & derivativeB,
+  const double valueTolerance, const double derivativeTolerance )
+{
+  const double maxDerivative = derivativeA.inf_norm();
+  const double maxDifference = ( derivativeA - derivativeB ).inf_norm();
+
+  std::cout << name << ":" << std::endl;
+  std::cout << "  value " << labelA << " / " << labelB << ": "
+            << valueA << " / " << valueB << std::endl;
+  std::cout << "  max |derivative|: " << maxDerivative << std::endl;
+  std::cout << "  max |difference|: " << maxDifference << std::endl;
+
+  if( std::abs( valueA - valueB ) > valueTolerance * ( 1.0 + std::abs( valueA ) ) )
+  {
+    std::cerr << "ERROR: the " << labelA << " and " << labelB
+              << " values of " << name << " differ." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( maxDerivative == 0.0 || maxDifference > derivativeTolerance * maxDerivative )
+  {
+    std::cerr << "ERROR: the " << labelA << " and " << labelB
+              << " derivatives of " << name << " differ." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end CompareValueAndDerivative()
+
+
+} // end namespace MetricTestHelper
+
+#endif // end #ifndef __itkMetricTestHelper_h
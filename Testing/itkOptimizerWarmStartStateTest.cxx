@@ -0,0 +1,290 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkOptimizerWarmStartState.h"
+#include "itkImageCache.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkGridScheduleComputer.h"
+#include "itkUpsampleBSplineParametersFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks the two parts of the warm start between resolutions and
+ * elastix levels:
+ * \li The lookup of the OptimizerWarmStartState in the image cache: an
+ *   elastix level finds the state of the previous level of its own run, but
+ *   not the state of another run or of another component. The entry of the
+ *   previous level is removed once it has been found.
+ * \li The mapping of a vector, such as a step of the optimizer, from the
+ *   B-spline grid of the previous resolution to the current one, as done by
+ *   AdvancedBSplineTransform::MapVectorFromPreviousResolution() with its grid
+ *   upsampler: the mapping is linear, and the upsampled coefficients give
+ *   the same displacements inside the image.
+ */
+
+typedef itk::OptimizerWarmStartState StateType;
+typedef itk::ImageCache              ImageCacheType;
+
+/** Check the lookup of the state in the image cache. */
+bool
+TestStateLookup( void )
+{
+  ImageCacheType::Pointer imageCache = ImageCacheType::New();
+
+  /** Two runs that share the cache. */
+  const itk::SizeValueType runA = imageCache->GetNewRunIdentifier();
+  const itk::SizeValueType runB = imageCache->GetNewRunIdentifier();
+  if( runA == runB )
+  {
+    std::cerr << "ERROR: two runs get the same identifier." << std::endl;
+    return false;
+  }
+
+  /** Level 0 of run A gets a new state, and leaves something in it. */
+  StateType::Pointer stateA0 = StateType::GetFromCache(
+    imageCache, runA, 0, "Optimizer0" );
+  stateA0->SetNoiseRatio( 0.5 );
+  stateA0->SetNumberOfGradientMeasurements( 3 );
+
+  /** Level 1 of run B does not find it. */
+  StateType::Pointer stateB1 = StateType::GetFromCache(
+    imageCache, runB, 1, "Optimizer0" );
+  if( stateB1 == stateA0 || stateB1->GetNumberOfGradientMeasurements() != 0 )
+  {
+    std::cerr << "ERROR: a registration finds the state of another one." << std::endl;
+    return false;
+  }
+
+  /** Another component of run A does not. */
+  StateType::Pointer stateOther = StateType::GetFromCache(
+    imageCache, runA, 1, "Optimizer1" );
+  if( stateOther == stateA0 )
+  {
+    std::cerr << "ERROR: a component finds the state of another component." << std::endl;
+    return false;
+  }
+
+  /** Level 1 of run A finds it, and the entry of level 0 is removed. */
+  const itk::SizeValueType numberOfEntries = imageCache->GetNumberOfEntries();
+  StateType::Pointer       stateA1         = StateType::GetFromCache(
+    imageCache, runA, 1, "Optimizer0" );
+  if( stateA1 != stateA0 )
+  {
+    std::cerr << "ERROR: the next elastix level does not find the state." << std::endl;
+    return false;
+  }
+  if( imageCache->GetEntry( StateType::GetCacheKey( runA, 0, "Optimizer0" ) ).IsNotNull()
+    || imageCache->GetNumberOfEntries() != numberOfEntries )
+  {
+    std::cerr << "ERROR: the state of the previous elastix level is not removed." << std::endl;
+    return false;
+  }
+
+  /** Level 2 of run A finds the same state. */
+  StateType::Pointer stateA2 = StateType::GetFromCache(
+    imageCache, runA, 2, "Optimizer0" );
+  if( stateA2 != stateA0 )
+  {
+    std::cerr << "ERROR: the state is not passed on to the next elastix level." << std::endl;
+    return false;
+  }
+
+  /** Without image cache, each call gives a new state. */
+  StateType::Pointer stateNoCache0 = StateType::GetFromCache(
+    NULL, runA, 0, "Optimizer0" );
+  StateType::Pointer stateNoCache1 = StateType::GetFromCache(
+    NULL, runA, 1, "Optimizer0" );
+  if( stateNoCache0.IsNull() || stateNoCache1.IsNull() || stateNoCache0 == stateNoCache1 )
+  {
+    std::cerr << "ERROR: wrong state without image cache." << std::endl;
+    return false;
+  }
+
+  std::cout << "State lookup: OK" << std::endl;
+  return true;
+
+} // end TestStateLookup()
+
+
+/** Check the mapping of vectors to the upsampled B-spline grid. */
+bool
+TestMapVectorFromPreviousResolution( void )
+{
+  const unsigned int Dimension = 2;
+  typedef itk::AdvancedBSplineDeformableTransform<
+    double, Dimension, 3 >                                TransformType;
+  typedef TransformType::ParametersType                   ParametersType;
+  typedef TransformType::ImageType                        CoefficientImageType;
+  typedef itk::GridScheduleComputer< double, Dimension >  GridScheduleComputerType;
+  typedef itk::UpsampleBSplineParametersFilter<
+    ParametersType, CoefficientImageType >                GridUpsamplerType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
+  /** The B-spline grids of two resolutions, for an image of 100 x 80 mm. */
+  GridScheduleComputerType::RegionType    imageRegion;
+  GridScheduleComputerType::SpacingType   imageSpacing;
+  GridScheduleComputerType::OriginType    imageOrigin;
+  GridScheduleComputerType::DirectionType imageDirection;
+  GridScheduleComputerType::SpacingType   finalGridSpacing;
+  GridScheduleComputerType::SizeType      imageSize;
+  imageSize[ 0 ] = 101; imageSize[ 1 ] = 81;
+  imageRegion.SetSize( imageSize );
+  imageSpacing.Fill( 1.0 );
+  imageOrigin.Fill( 0.0 );
+  imageDirection.SetIdentity();
+  finalGridSpacing.Fill( 8.0 );
+
+  GridScheduleComputerType::Pointer gridScheduleComputer = GridScheduleComputerType::New();
+  gridScheduleComputer->SetBSplineOrder( 3 );
+  gridScheduleComputer->SetImageOrigin( imageOrigin );
+  gridScheduleComputer->SetImageSpacing( imageSpacing );
+  gridScheduleComputer->SetImageDirection( imageDirection );
+  gridScheduleComputer->SetImageRegion( imageRegion );
+  gridScheduleComputer->SetFinalGridSpacing( finalGridSpacing );
+  gridScheduleComputer->SetDefaultSchedule( 2, 2.0 );
+  gridScheduleComputer->ComputeBSplineGrid();
+
+  TransformType::Pointer transforms[ 2 ] = { TransformType::New(), TransformType::New() };
+  for( unsigned int level = 0; level < 2; ++level )
+  {
+    TransformType::RegionType    gridRegion;
+    TransformType::SpacingType   gridSpacing;
+    TransformType::OriginType    gridOrigin;
+    TransformType::DirectionType gridDirection;
+    gridScheduleComputer->GetBSplineGrid( level,
+      gridRegion, gridSpacing, gridOrigin, gridDirection );
+    transforms[ level ]->SetGridOrigin( gridOrigin );
+    transforms[ level ]->SetGridSpacing( gridSpacing );
+    transforms[ level ]->SetGridRegion( gridRegion );
+    transforms[ level ]->SetGridDirection( gridDirection );
+  }
+
+  /** Setup the grid upsampler like AdvancedBSplineTransform::IncreaseScale(). */
+  GridUpsamplerType::Pointer gridUpsampler = GridUpsamplerType::New();
+  gridUpsampler->SetBSplineOrder( 3 );
+  gridUpsampler->SetCurrentGridOrigin( transforms[ 0 ]->GetGridOrigin() );
+  gridUpsampler->SetCurrentGridSpacing( transforms[ 0 ]->GetGridSpacing() );
+  gridUpsampler->SetCurrentGridRegion( transforms[ 0 ]->GetGridRegion() );
+  gridUpsampler->SetCurrentGridDirection( transforms[ 0 ]->GetGridDirection() );
+  gridUpsampler->SetRequiredGridOrigin( transforms[ 1 ]->GetGridOrigin() );
+  gridUpsampler->SetRequiredGridSpacing( transforms[ 1 ]->GetGridSpacing() );
+  gridUpsampler->SetRequiredGridRegion( transforms[ 1 ]->GetGridRegion() );
+  gridUpsampler->SetRequiredGridDirection( transforms[ 1 ]->GetGridDirection() );
+
+  /** Two random vectors on the coarse grid, such as a step s and a gradient
+   * difference y. */
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::New();
+  randomGenerator->Initialize( 121212 );
+  const unsigned int numberOfCoarseParameters = transforms[ 0 ]->GetNumberOfParameters();
+  ParametersType     s( numberOfCoarseParameters );
+  ParametersType     y( numberOfCoarseParameters );
+  ParametersType     combination( numberOfCoarseParameters );
+  for( unsigned int i = 0; i < numberOfCoarseParameters; ++i )
+  {
+    s[ i ]           = randomGenerator->GetUniformVariate( -2.0, 2.0 );
+    y[ i ]           = randomGenerator->GetUniformVariate( -2.0, 2.0 );
+    combination[ i ] = 0.75 * s[ i ] - 1.5 * y[ i ];
+  }
+
+  ParametersType mappedS, mappedY, mappedCombination;
+  gridUpsampler->UpsampleParameters( s, mappedS );
+  gridUpsampler->UpsampleParameters( y, mappedY );
+  gridUpsampler->UpsampleParameters( combination, mappedCombination );
+
+  if( mappedS.GetSize() != transforms[ 1 ]->GetNumberOfParameters()
+    || mappedY.GetSize() != transforms[ 1 ]->GetNumberOfParameters() )
+  {
+    std::cerr << "ERROR: the mapped vectors have " << mappedS.GetSize()
+              << " instead of " << transforms[ 1 ]->GetNumberOfParameters()
+              << " elements." << std::endl;
+    return false;
+  }
+
+  /** The mapping is linear. */
+  for( unsigned int i = 0; i < mappedCombination.GetSize(); ++i )
+  {
+    const double linearCombination = 0.75 * mappedS[ i ] - 1.5 * mappedY[ i ];
+    if( std::abs( mappedCombination[ i ] - linearCombination ) > 1e-10 )
+    {
+      std::cerr << "ERROR: the mapping is not linear at parameter " << i << ": "
+                << mappedCombination[ i ] << " instead of " << linearCombination
+                << std::endl;
+      return false;
+    }
+  }
+
+  /** The mapped step displaces the points inside the image in the same way.
+   * Stay away from the border of the image, where the upsampling of the
+   * B-spline coefficients is not exact. */
+  transforms[ 0 ]->SetParameters( s );
+  transforms[ 1 ]->SetParameters( mappedS );
+  double maximumError = 0.0;
+  for( double x = 20.0; x <= 80.0; x += 1.7 )
+  {
+    for( double z = 20.0; z <= 60.0; z += 1.3 )
+    {
+      TransformType::InputPointType point;
+      point[ 0 ] = x; point[ 1 ] = z;
+      const TransformType::OutputPointType coarsePoint = transforms[ 0 ]->TransformPoint( point );
+      const TransformType::OutputPointType finePoint   = transforms[ 1 ]->TransformPoint( point );
+      maximumError = std::max( maximumError, coarsePoint.EuclideanDistanceTo( finePoint ) );
+    }
+  }
+  std::cout << "Map vector from previous resolution: " << numberOfCoarseParameters
+            << " -> " << mappedS.GetSize() << " parameters, maximum displacement difference "
+            << maximumError << " mm" << std::endl;
+  if( maximumError > 1e-2 )
+  {
+    std::cerr << "ERROR: the mapped vector gives other displacements." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end TestMapVectorFromPreviousResolution()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  bool success = true;
+  try
+  {
+    success &= TestStateLookup();
+    success &= TestMapVectorFromPreviousResolution();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if( !success )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "PCAMetric/itkPCAMetric_F_multithreaded.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+#include "vnl/vnl_diag_matrix.h"
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks the eigenpairs that PCAMetric computes with the warm
+ * started subspace iteration against vnl_symmetric_eigensystem. When the
+ * iteration converges, the residual || K v - lambda v || of each eigenpair
+ * must be below 1e-6 times the largest eigenvalue. In the first call, after a
+ * change of the matrix size, and when the iteration does not converge, the
+ * full eigendecomposition is used, so the result must be exactly that of
+ * vnl_symmetric_eigensystem.
+ */
+
+typedef itk::Image< float, 3 >                                 ImageType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+/** Make the protected eigensolver of PCAMetric accessible. */
+class PCAMetricTester : public itk::PCAMetric< ImageType, ImageType >
+{
+public:
+
+  typedef PCAMetricTester                        Self;
+  typedef itk::PCAMetric< ImageType, ImageType > Superclass;
+  typedef itk::SmartPointer< Self >              Pointer;
+  typedef itk::SmartPointer< const Self >        ConstPointer;
+
+  itkNewMacro( Self );
+
+  using Superclass::ComputeLargestEigenPairs;
+
+protected:
+
+  PCAMetricTester() {}
+  virtual ~PCAMetricTester() {}
+
+};
+
+typedef PCAMetricTester::MatrixType MatrixType;
+typedef vnl_vector< double >        VectorType;
+
+/** Create a random symmetric matrix with entries in [ -1, 1 ]. */
+MatrixType
+CreateRandomSymmetricMatrix( GeneratorType * generator, const unsigned int G )
+{
+  MatrixType E( G, G );
+  for( unsigned int i = 0; i < G; ++i )
+  {
+    for( unsigned int j = 0; j <= i; ++j )
+    {
+      E( i, j ) = generator->GetUniformVariate( -1.0, 1.0 );
+      E( j, i ) = E( i, j );
+    }
+  }
+
+  return E;
+
+} // end CreateRandomSymmetricMatrix()
+
+
+/** Create the symmetric matrix R diag( eigenValues ) R^T, with R a random
+ * orthogonal matrix.
+ */
+MatrixType
+CreateMatrix( GeneratorType * generator, const VectorType & eigenValues )
+{
+  const unsigned int                  G = eigenValues.size();
+  vnl_symmetric_eigensystem< double > eig( CreateRandomSymmetricMatrix( generator, G ) );
+  const MatrixType &                  R = eig.V;
+
+  MatrixType K( R * vnl_diag_matrix< double >( eigenValues ) * R.transpose() );
+  return 0.5 * ( K + K.transpose() );
+
+} // end CreateMatrix()
+
+
+/** Check the eigenpairs of K computed by the metric. If exact is true, they
+ * must be those of the full eigendecomposition, else they must satisfy the
+ * convergence criterion of the subspace iteration.
+ */
+bool
+CheckEigenPairs( const std::string & name, PCAMetricTester * metric,
+  const MatrixType & K, const unsigned int k, const bool exact )
+{
+  const unsigned int G = K.rows();
+  VectorType         eigenValues;
+  MatrixType         eigenVectors;
+  metric->ComputeLargestEigenPairs( K, eigenValues, eigenVectors );
+
+  vnl_symmetric_eigensystem< double > eig( K );
+  const double                        scale     = std::max( std::abs( eig.get_eigenvalue( G - 1 ) ), 1.0 );
+  const double                        tolerance = 1e-6 * scale;
+
+  if( eigenValues.size() != k || eigenVectors.rows() != G || eigenVectors.cols() != k )
+  {
+    std::cerr << "ERROR: " << name << ": wrong number of eigenpairs." << std::endl;
+    return false;
+  }
+
+  bool isExact = true;
+  for( unsigned int j = 0; j < k; ++j )
+  {
+    const double     referenceValue  = eig.get_eigenvalue( G - j - 1 );
+    const VectorType referenceVector = eig.get_eigenvector( G - j - 1 ).normalize();
+    const VectorType v               = eigenVectors.get_column( j );
+    isExact &= eigenValues[ j ] == referenceValue && v == referenceVector;
+
+    /** The residual, the eigenvalue, and the direction of the eigenvector. */
+    const double residual = ( K * v - eigenValues[ j ] * v ).two_norm();
+    const double cosine   = std::abs( dot_product( v, referenceVector ) );
+    std::cout << name << ": eigenvalue " << j << ": " << eigenValues[ j ]
+              << " (vnl " << referenceValue << "), residual " << residual
+              << ", 1 - |cos| " << 1.0 - cosine << std::endl;
+    if( residual > tolerance + 1e-12 || std::abs( eigenValues[ j ] - referenceValue ) > tolerance
+      || std::abs( v.two_norm() - 1.0 ) > 1e-10 || 1.0 - cosine > 1e-8 )
+    {
+      std::cerr << "ERROR: " << name << ": eigenpair " << j
+                << " differs from vnl_symmetric_eigensystem." << std::endl;
+      return false;
+    }
+  }
+
+  /** The full eigendecomposition gives exactly the vnl result, the subspace
+   * iteration differs from it in rounding.
+   */
+  if( isExact != exact )
+  {
+    std::cerr << "ERROR: " << name << ": the "
+              << ( exact ? "full eigendecomposition" : "subspace iteration" )
+              << " was expected to be used." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end CheckEigenPairs()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( void )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 121212 );
+
+  const unsigned int       G      = 20;
+  const unsigned int       k      = 4;
+  PCAMetricTester::Pointer metric = PCAMetricTester::New();
+  metric->SetNumEigenValues( k );
+
+  /** Well separated eigenvalues, like those of the correlation matrix of a
+   * series of similar images.
+   */
+  VectorType eigenValues( G );
+  for( unsigned int j = 0; j < G; ++j )
+  {
+    eigenValues[ j ] = 10.0 * std::pow( 0.7, static_cast< double >( j ) );
+  }
+  const MatrixType K = CreateMatrix( generator, eigenValues );
+  const MatrixType E = CreateRandomSymmetricMatrix( generator, G );
+
+  /** The first call uses the full eigendecomposition. */
+  if( !CheckEigenPairs( "first call", metric, K, k, true ) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  /** Small changes of K, as between iterations of the optimizer, are
+   * followed by the subspace iteration.
+   */
+  for( unsigned int i = 1; i <= 5; ++i )
+  {
+    const MatrixType Ki( K + ( 1e-3 * i ) * E );
+    if( !CheckEigenPairs( "warm start", metric, Ki, k, false ) )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Clustered eigenvalues with other eigenvectors: the subspace iteration
+   * converges too slowly, so it falls back to the full eigendecomposition.
+   */
+  VectorType clusteredEigenValues( G );
+  for( unsigned int j = 0; j < G; ++j )
+  {
+    clusteredEigenValues[ j ] = 2.0 - 1e-4 * j;
+  }
+  const MatrixType clusteredK = CreateMatrix( generator, clusteredEigenValues );
+  if( !CheckEigenPairs( "no convergence", metric, clusteredK, k, true ) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  /** The fallback restarts the warm start. */
+  if( !CheckEigenPairs( "warm start after fallback", metric, K, k, false ) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  /** A different matrix size, as in a new resolution with another number of
+   * images, uses the full eigendecomposition.
+   */
+  const MatrixType smallK = K.extract( 12, 12 );
+  if( !CheckEigenPairs( "other size", metric, smallK, k, true ) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,146 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "PCAMetric/itkPCAMetric_F_multithreaded.h"
+#include "PCAMetric2/itkPCAMetric2.h"
+
+#include <sstream>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the threaded GetValueAndDerivative of PCAMetric and
+ * PCAMetric2 gives the same value and derivative as
+ * GetValueAndDerivativeSingleThreaded. The slices of the 3D test image are
+ * used as a series of 2D images, the last dimension being the series.
+ *
+ * Both are evaluated twice, since PCAMetric starts the eigensolver of the
+ * second evaluation from the eigenvectors of the first. The threads only
+ * change the order in which the covariance matrix and the derivative are
+ * summed.
+ */
+
+using namespace MetricTestHelper;
+
+typedef itk::PCAMetric< ImageType, ImageType >  PCAMetricType;
+typedef itk::PCAMetric2< ImageType, ImageType > PCAMetric2Type;
+
+/** Setup a PCA metric with a single thread or with four threads. The mean
+ * derivative over the series is subtracted, which needs the grid size.
+ */
+template< class TPCAMetric >
+typename TPCAMetric::Pointer
+CreatePCAMetric( ImageType * fixedImage, ImageType * movingImage,
+  BSplineTransformType * transform, const bool useMultiThread )
+{
+  typename TPCAMetric::Pointer metric = TPCAMetric::New();
+  SetupMetric( metric, fixedImage, movingImage, transform, 6 );
+  metric->SetSubtractMean( true );
+  metric->SetGridSize( transform->GetGridRegion().GetSize() );
+  metric->SetTransformIsStackTransform( false );
+  metric->SetNumberOfThreads( 4 );
+  metric->SetUseMultiThread( useMultiThread );
+  metric->Initialize();
+
+  return metric;
+
+} // end CreatePCAMetric()
+
+
+/** Compare two evaluations of the single threaded and the threaded metric. */
+template< class TPCAMetric >
+int
+TestPCAMetric( const std::string & name, ImageType * fixedImage, ImageType * movingImage,
+  BSplineTransformType * transform, const ParametersType & parameters0,
+  const ParametersType & parameters1 )
+{
+  typename TPCAMetric::Pointer serialMetric
+    = CreatePCAMetric< TPCAMetric >( fixedImage, movingImage, transform, false );
+  typename TPCAMetric::Pointer threadedMetric
+    = CreatePCAMetric< TPCAMetric >( fixedImage, movingImage, transform, true );
+
+  const ParametersType * parameters[ 2 ] = { &parameters0, &parameters1 };
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    MeasureType    serialValue, threadedValue;
+    DerivativeType serialDerivative, threadedDerivative;
+    serialMetric->GetValueAndDerivativeSingleThreaded(
+      *parameters[ i ], serialValue, serialDerivative );
+    threadedMetric->GetValueAndDerivative(
+      *parameters[ i ], threadedValue, threadedDerivative );
+
+    std::ostringstream label;
+    label << name << ", evaluation " << i;
+    if( CompareValueAndDerivative( label.str(), "single threaded", "threaded",
+      serialValue, threadedValue, serialDerivative, threadedDerivative,
+      1e-10, 1e-8 ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+
+} // end TestPCAMetric()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ImageType::Pointer fixedImage, movingImage;
+  if( !ReadTestImages( argv[ 1 ], LinearRemapping, fixedImage, movingImage ) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  /** Two nearby parameter vectors, as in two iterations of an optimizer. */
+  BSplineTransformType::Pointer transform   = CreateBSplineTransform( fixedImage, 4.0 );
+  const ParametersType          parameters0 = transform->GetParameters();
+  ParametersType                parameters1 = parameters0;
+  for( unsigned int i = 0; i < parameters1.GetSize(); ++i )
+  {
+    parameters1[ i ] += 0.2 * std::cos( 0.53 * i );
+  }
+
+  try
+  {
+    if( TestPCAMetric< PCAMetricType >( "PCAMetric", fixedImage, movingImage,
+      transform, parameters0, parameters1 ) != EXIT_SUCCESS
+      || TestPCAMetric< PCAMetric2Type >( "PCAMetric2", fixedImage, movingImage,
+      transform, parameters0, parameters1 ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,136 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "NormalizedMutualInformation/itkParzenWindowNormalizedMutualInformationImageToImageMetric.h"
+
+// Report timings
+#include "itkTimeProbe.h"
+
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the sparse storage of the joint histogram
+ * derivatives (UseSparsePDFDerivatives) gives the same value and derivative
+ * as the dense storage, for mutual information and normalized mutual
+ * information with a B-spline transform.
+ */
+
+using namespace MetricTestHelper;
+
+/** Compute the value and derivative with a new metric of type TMetric. */
+template< class TMetric >
+void
+ComputeValueAndDerivative( ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const ParametersType & parameters,
+  const bool useSparsePDFDerivatives,
+  MeasureType & value, DerivativeType & derivative )
+{
+  typename TMetric::Pointer metric = TMetric::New();
+  SetupMetric( metric, fixedImage, movingImage, transform, 4 );
+  metric->SetNumberOfFixedHistogramBins( 32 );
+  metric->SetNumberOfMovingHistogramBins( 32 );
+  metric->SetUseDerivative( true );
+  metric->SetUseExplicitPDFDerivatives( true );
+  metric->SetUseSparsePDFDerivatives( useSparsePDFDerivatives );
+  metric->Initialize();
+
+  itk::TimeProbe timer;
+  timer.Start();
+  metric->GetValueAndDerivative( parameters, value, derivative );
+  timer.Stop();
+  std::cout << "  time " << ( useSparsePDFDerivatives ? "sparse" : "dense" )
+            << " [s]: " << timer.GetMean() << std::endl;
+
+} // end ComputeValueAndDerivative()
+
+
+/** Compare the dense and sparse results. */
+template< class TMetric >
+int
+CompareDenseAndSparse( const std::string & name,
+  ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const ParametersType & parameters )
+{
+  MeasureType    denseValue, sparseValue;
+  DerivativeType denseDerivative, sparseDerivative;
+  ComputeValueAndDerivative< TMetric >( fixedImage, movingImage, transform,
+    parameters, false, denseValue, denseDerivative );
+  ComputeValueAndDerivative< TMetric >( fixedImage, movingImage, transform,
+    parameters, true, sparseValue, sparseDerivative );
+
+  /** The derivatives are accumulated in float, so compare relative to
+   * the largest derivative component.
+   */
+  return CompareValueAndDerivative( name, "dense", "sparse",
+    denseValue, sparseValue, denseDerivative, sparseDerivative, 1e-8, 1e-4 );
+
+} // end CompareDenseAndSparse()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ImageType::Pointer fixedImage, movingImage;
+  if( !ReadTestImages( argv[ 1 ], CosineRemapping, fixedImage, movingImage ) )
+  {
+    return EXIT_FAILURE;
+  }
+  BSplineTransformType::Pointer transform  = CreateBSplineTransform( fixedImage, 2.0 );
+  const ParametersType          parameters = transform->GetParameters();
+
+  std::cout << std::scientific << std::setprecision( 6 );
+  std::cout << "Number of parameters: " << parameters.GetSize() << "\n" << std::endl;
+
+  /** Compare. */
+  typedef itk::ParzenWindowMutualInformationImageToImageMetric<
+    ImageType, ImageType >                          MIMetricType;
+  typedef itk::ParzenWindowNormalizedMutualInformationImageToImageMetric<
+    ImageType, ImageType >                          NMIMetricType;
+  try
+  {
+    if( CompareDenseAndSparse< MIMetricType >( "MutualInformation",
+      fixedImage, movingImage, transform, parameters ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+    if( CompareDenseAndSparse< NMIMetricType >( "NormalizedMutualInformation",
+      fixedImage, movingImage, transform, parameters ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
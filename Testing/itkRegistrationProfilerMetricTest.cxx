@@ -0,0 +1,191 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+#include "AdvancedNormalizedCorrelation/itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+#include "itkRegistrationProfiler.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the per-sample loops of the metrics record the
+ * TransformEvaluation, Interpolation and JacobianProduct phases in the
+ * RegistrationProfiler, without sample blocks: the Parzen window mutual
+ * information (explicit PDF derivatives, and the single and multi-threaded
+ * low memory derivative), and the threaded mean squares and normalized
+ * correlation. It also checks that profiling does not change the value and
+ * derivative.
+ */
+
+using namespace MetricTestHelper;
+
+typedef itk::RegistrationProfiler ProfilerType;
+
+typedef itk::ParzenWindowMutualInformationImageToImageMetric<
+  ImageType, ImageType >                                         MIMetricType;
+typedef itk::AdvancedMeanSquaresImageToImageMetric<
+  ImageType, ImageType >                                         MSDMetricType;
+typedef itk::AdvancedNormalizedCorrelationImageToImageMetric<
+  ImageType, ImageType >                                         NCMetricType;
+
+/** Setup the parts that all metrics share, without sample blocks. */
+void
+SetupProfiledMetric( MetricType * metric, ImageType * fixedImage, ImageType * movingImage,
+  TransformType * transform, const bool useMultiThread )
+{
+  SetupMetric( metric, fixedImage, movingImage, transform, 2 );
+  metric->SetUseMultiThread( useMultiThread );
+  metric->SetUseSampleBlocks( false );
+
+} // end SetupProfiledMetric()
+
+
+/** Compute the value and derivative with and without a profiler, and check
+ * the recorded phases.
+ */
+int
+CheckPhases( const std::string & name, MetricType * metric,
+  MetricType * unprofiledMetric, const ParametersType & parameters )
+{
+  ProfilerType::Pointer profiler = ProfilerType::New();
+  profiler->StartResolution( 0 );
+  metric->SetProfiler( profiler );
+  metric->Initialize();
+  unprofiledMetric->Initialize();
+
+  MeasureType    value, unprofiledValue;
+  DerivativeType derivative, unprofiledDerivative;
+  metric->GetValueAndDerivative( parameters, value, derivative );
+  unprofiledMetric->GetValueAndDerivative( parameters, unprofiledValue, unprofiledDerivative );
+
+  std::cout << name << ":" << std::endl;
+  profiler->WriteCSV( std::cout, 0 );
+
+  /** Profiling only reads clocks; the results must be identical. */
+  if( value != unprofiledValue || derivative != unprofiledDerivative )
+  {
+    std::cerr << "ERROR: " << name << ": profiling changes the value or derivative." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const ProfilerType::PhaseType phases[ 3 ] = {
+    ProfilerType::TransformEvaluation,
+    ProfilerType::Interpolation,
+    ProfilerType::JacobianProduct
+  };
+  for( unsigned int i = 0; i < 3; ++i )
+  {
+    const ProfilerType::PhaseRecordType record = profiler->GetPhaseRecord( 0, phases[ i ] );
+    if( record.st_NumberOfCalls == 0 || record.st_WallTime < 0.0 || record.st_CPUTime < 0.0 )
+    {
+      std::cerr << "ERROR: " << name << ": the phase "
+                << ProfilerType::GetPhaseName( phases[ i ] )
+                << " is not recorded." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+
+} // end CheckPhases()
+
+
+/** Check a Parzen window mutual information configuration. */
+int
+CheckMutualInformation( const std::string & name,
+  ImageType * fixedImage, ImageType * movingImage, TransformType * transform,
+  const ParametersType & parameters,
+  const bool useExplicitPDFDerivatives, const bool useMultiThread )
+{
+  MIMetricType::Pointer metrics[ 2 ] = { MIMetricType::New(), MIMetricType::New() };
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    SetupProfiledMetric( metrics[ i ], fixedImage, movingImage, transform, useMultiThread );
+    metrics[ i ]->SetNumberOfFixedHistogramBins( 32 );
+    metrics[ i ]->SetNumberOfMovingHistogramBins( 32 );
+    metrics[ i ]->SetUseDerivative( true );
+    metrics[ i ]->SetUseExplicitPDFDerivatives( useExplicitPDFDerivatives );
+  }
+  return CheckPhases( name, metrics[ 0 ], metrics[ 1 ], parameters );
+
+} // end CheckMutualInformation()
+
+
+/** Check a threaded metric of type TMetric. */
+template< class TMetric >
+int
+CheckThreadedMetric( const std::string & name,
+  ImageType * fixedImage, ImageType * movingImage, TransformType * transform,
+  const ParametersType & parameters )
+{
+  typename TMetric::Pointer metrics[ 2 ] = { TMetric::New(), TMetric::New() };
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    SetupProfiledMetric( metrics[ i ], fixedImage, movingImage, transform, true );
+  }
+  return CheckPhases( name, metrics[ 0 ], metrics[ 1 ], parameters );
+
+} // end CheckThreadedMetric()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ImageType::Pointer fixedImage, movingImage;
+  if( !ReadTestImages( argv[ 1 ], LinearRemapping, fixedImage, movingImage ) )
+  {
+    return EXIT_FAILURE;
+  }
+  BSplineTransformType::Pointer transform  = CreateBSplineTransform( fixedImage, 4.0 );
+  const ParametersType          parameters = transform->GetParameters();
+
+  /** Check. */
+  try
+  {
+    if( CheckMutualInformation( "MutualInformation, explicit PDF derivatives",
+      fixedImage, movingImage, transform, parameters, true, false ) != EXIT_SUCCESS
+      || CheckMutualInformation( "MutualInformation, low memory, single-threaded",
+      fixedImage, movingImage, transform, parameters, false, false ) != EXIT_SUCCESS
+      || CheckMutualInformation( "MutualInformation, low memory, multi-threaded",
+      fixedImage, movingImage, transform, parameters, false, true ) != EXIT_SUCCESS
+      || CheckThreadedMetric< MSDMetricType >( "AdvancedMeanSquares",
+      fixedImage, movingImage, transform, parameters ) != EXIT_SUCCESS
+      || CheckThreadedMetric< NCMetricType >( "AdvancedNormalizedCorrelation",
+      fixedImage, movingImage, transform, parameters ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkRegistrationProfiler.h"
+#include "itkMultiThreader.h"
+
+#include <sstream>
+#include <cmath>
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks that the RegistrationProfiler accumulates the
+ * measurements of several threads per resolution, and that the profiles
+ * are written in the expected CSV and JSON layout.
+ */
+
+typedef itk::RegistrationProfiler ProfilerType;
+
+const unsigned int NumberOfThreads        = 4;
+const unsigned int NumberOfCallsPerThread = 1000;
+
+/** Each thread adds NumberOfCallsPerThread measurements of 1 ms. */
+ITK_THREAD_RETURN_TYPE
+AddTimeThreaderCallback( void * arg )
+{
+  typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ProfilerType *   profiler   = static_cast< ProfilerType * >( infoStruct->UserData );
+
+  for( unsigned int i = 0; i < NumberOfCallsPerThread; ++i )
+  {
+    profiler->AddTime( ProfilerType::Interpolation, 1.0e-3, 1.0e-3 );
+  }
+  { ProfilerType::ScopedTimer timer( profiler, ProfilerType::TransformEvaluation ); }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AddTimeThreaderCallback()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( void )
+{
+  ProfilerType::Pointer profiler = ProfilerType::New();
+
+  /** Measurements before the first resolution are ignored. */
+  profiler->AddTime( ProfilerType::Sampling, 1.0, 1.0 );
+  if( profiler->GetNumberOfResolutions() != 0 )
+  {
+    std::cerr << "ERROR: a measurement was recorded before the first resolution." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Add measurements in two resolutions, from several threads. */
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( NumberOfThreads );
+  threader->SetSingleMethod( AddTimeThreaderCallback, profiler.GetPointer() );
+  for( unsigned int level = 0; level < 2; ++level )
+  {
+    profiler->StartResolution( level );
+    threader->SingleMethodExecute();
+    profiler->AddTime( ProfilerType::OptimizerUpdate, 0.5, 0.25, 10 );
+  }
+
+  /** Check the accumulated measurements. */
+  const unsigned int numberOfThreads = threader->GetNumberOfThreads();
+  for( unsigned int level = 0; level < 2; ++level )
+  {
+    const ProfilerType::PhaseRecordType interpolation
+      = profiler->GetPhaseRecord( level, ProfilerType::Interpolation );
+    const ProfilerType::PhaseRecordType transform
+      = profiler->GetPhaseRecord( level, ProfilerType::TransformEvaluation );
+    const ProfilerType::PhaseRecordType optimizer
+      = profiler->GetPhaseRecord( level, ProfilerType::OptimizerUpdate );
+    const ProfilerType::PhaseRecordType sampling
+      = profiler->GetPhaseRecord( level, ProfilerType::Sampling );
+
+    const double expectedTime = numberOfThreads * NumberOfCallsPerThread * 1.0e-3;
+    if( interpolation.st_NumberOfCalls != numberOfThreads * NumberOfCallsPerThread
+      || std::abs( interpolation.st_WallTime - expectedTime ) > 1.0e-9
+      || std::abs( interpolation.st_CPUTime - expectedTime ) > 1.0e-9 )
+    {
+      std::cerr << "ERROR: wrong Interpolation record in resolution " << level << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( transform.st_NumberOfCalls != numberOfThreads || transform.st_WallTime < 0.0 )
+    {
+      std::cerr << "ERROR: wrong TransformEvaluation record in resolution " << level << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( optimizer.st_NumberOfCalls != 10 || optimizer.st_WallTime != 0.5 || optimizer.st_CPUTime != 0.25 )
+    {
+      std::cerr << "ERROR: wrong OptimizerUpdate record in resolution " << level << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( sampling.st_NumberOfCalls != 0 )
+    {
+      std::cerr << "ERROR: wrong Sampling record in resolution " << level << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Starting a resolution again clears it. */
+  profiler->StartResolution( 1 );
+  if( profiler->GetPhaseRecord( 1, ProfilerType::Interpolation ).st_NumberOfCalls != 0
+    || profiler->GetPhaseRecord( 0, ProfilerType::Interpolation ).st_NumberOfCalls == 0 )
+  {
+    std::cerr << "ERROR: StartResolution() did not clear only the started resolution." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Check the written profiles. */
+  std::ostringstream csv;
+  profiler->WriteCSV( csv, 0 );
+  std::cout << csv.str() << std::endl;
+  if( csv.str().find( "Resolution,Phase,NumberOfCalls,WallTime[s],CPUTime[s]\n" ) != 0
+    || csv.str().find( "0,OptimizerUpdate,10,0.5,0.25\n" ) == std::string::npos )
+  {
+    std::cerr << "ERROR: unexpected CSV profile." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ostringstream json;
+  profiler->WriteJSON( json, 0 );
+  std::cout << json.str() << std::endl;
+  if( json.str().find( "\"Resolution\": 0" ) == std::string::npos
+    || json.str().find( "\"OptimizerUpdate\": { \"NumberOfCalls\": 10, \"WallTime\": 0.5, \"CPUTime\": 0.25 }" )
+    == std::string::npos )
+  {
+    std::cerr << "ERROR: unexpected JSON profile." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
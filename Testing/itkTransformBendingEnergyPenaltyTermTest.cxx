@@ -0,0 +1,264 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedTranslationTransform.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks the analytic bending energy of a B-spline transform:
+ * - against the default mode with a dense grid sampler, on an image whose
+ *   voxels tile the valid region of the B-spline grid, so that the sample
+ *   mean is the midpoint rule for the integral of the analytic mode;
+ * - against central finite differences, which are exact for the quadratic
+ *   analytic bending energy up to rounding;
+ * - for a B-spline in an AdvancedCombinationTransform: with an added
+ *   translation the analytic mode must be used, and with a composed
+ *   translation or an added B-spline the default mode must be used.
+ */
+
+using namespace MetricTestHelper;
+
+typedef itk::TransformBendingEnergyPenaltyTerm< ImageType, double > PenaltyType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >      CombinationTransformType;
+typedef itk::AdvancedTranslationTransform< double, Dimension >      TranslationTransformType;
+
+/** Create an image of 40 voxels of 1 mm in each dimension, that covers
+ * [0, 40] mm.
+ */
+ImageType::Pointer
+CreateImage( void )
+{
+  ImageType::SizeType    size;
+  ImageType::SpacingType spacing;
+  ImageType::PointType   origin;
+  size.Fill( 40 );
+  spacing.Fill( 1.0 );
+  origin.Fill( 0.5 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->Allocate();
+  image->FillBuffer( 0.0f );
+
+  return image;
+
+} // end CreateImage()
+
+
+/** Create a cubic B-spline with a control point spacing of 20 mm, whose
+ * valid region is [0, 40] mm, with the deformation amplitude * sin( f i ).
+ */
+BSplineTransformType::Pointer
+CreateGridBSplineTransform( const double amplitude, const double frequency )
+{
+  BSplineTransformType::OriginType    gridOrigin;
+  BSplineTransformType::SpacingType   gridSpacing;
+  BSplineTransformType::SizeType      gridSize;
+  BSplineTransformType::RegionType    gridRegion;
+  BSplineTransformType::DirectionType gridDirection;
+  gridOrigin.Fill( -20.0 );
+  gridSpacing.Fill( 20.0 );
+  gridSize.Fill( 5 );
+  gridRegion.SetSize( gridSize );
+  gridDirection.SetIdentity();
+
+  BSplineTransformType::Pointer transform = BSplineTransformType::New();
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridDirection( gridDirection );
+
+  ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = amplitude * std::sin( frequency * i );
+  }
+  transform->SetParametersByValue( parameters );
+
+  return transform;
+
+} // end CreateGridBSplineTransform()
+
+
+/** Create and initialize a bending energy penalty. */
+PenaltyType::Pointer
+CreatePenalty( ImageType * image, TransformType * transform, const bool useAnalyticBendingEnergy )
+{
+  PenaltyType::Pointer penalty = PenaltyType::New();
+  SetupMetric( penalty, image, image, transform, 1 );
+  penalty->SetUseAnalyticBendingEnergy( useAnalyticBendingEnergy );
+  penalty->Initialize();
+
+  return penalty;
+
+} // end CreatePenalty()
+
+
+/** Check that two evaluations are identical. */
+int
+CompareExactly( const std::string & name,
+  const MeasureType valueA, const MeasureType valueB,
+  const DerivativeType & derivativeA, const DerivativeType & derivativeB )
+{
+  std::cout << name << ": " << valueA << " / " << valueB << std::endl;
+  if( valueA != valueB || derivativeA != derivativeB )
+  {
+    std::cerr << "ERROR: " << name << ": the results differ." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end CompareExactly()
+
+
+/** Compare the derivative of the analytic mode to central finite differences. */
+int
+CheckFiniteDifferences( const PenaltyType * penalty, const ParametersType & parameters )
+{
+  MeasureType    value;
+  DerivativeType derivative;
+  penalty->GetValueAndDerivative( parameters, value, derivative );
+
+  const double   delta         = 1e-3;
+  const double   maxDerivative = derivative.inf_norm();
+  ParametersType perturbed     = parameters;
+  for( unsigned int i = 0; i < parameters.GetSize(); i += 7 )
+  {
+    perturbed[ i ] = parameters[ i ] + delta;
+    const MeasureType valuePlus = penalty->GetValue( perturbed );
+    perturbed[ i ] = parameters[ i ] - delta;
+    const MeasureType valueMinus = penalty->GetValue( perturbed );
+    perturbed[ i ] = parameters[ i ];
+
+    const double finiteDifference = ( valuePlus - valueMinus ) / ( 2.0 * delta );
+    if( std::abs( finiteDifference - derivative[ i ] ) > 1e-6 * maxDerivative )
+    {
+      std::cerr << "ERROR: the derivative " << derivative[ i ] << " of parameter " << i
+                << " differs from the finite difference " << finiteDifference << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Leave the transform at the original parameters. */
+  penalty->GetValue( parameters );
+
+  return EXIT_SUCCESS;
+
+} // end CheckFiniteDifferences()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( void )
+{
+  ImageType::Pointer            image      = CreateImage();
+  BSplineTransformType::Pointer bspline    = CreateGridBSplineTransform( 2.0, 0.37 );
+  const ParametersType          parameters = bspline->GetParameters();
+
+  try
+  {
+    /** The analytic mode against the default mode and finite differences. */
+    PenaltyType::Pointer analyticPenalty = CreatePenalty( image, bspline, true );
+    PenaltyType::Pointer sampledPenalty  = CreatePenalty( image, bspline, false );
+
+    MeasureType    analyticValue, sampledValue;
+    DerivativeType analyticDerivative, sampledDerivative;
+    analyticPenalty->GetValueAndDerivative( parameters, analyticValue, analyticDerivative );
+    sampledPenalty->GetValueAndDerivative( parameters, sampledValue, sampledDerivative );
+    if( CompareValueAndDerivative( "TransformBendingEnergyPenaltyTerm",
+      "analytic", "sampled", analyticValue, sampledValue,
+      analyticDerivative, sampledDerivative, 1e-2, 1e-2 ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+    if( analyticPenalty->GetValue( parameters ) != analyticValue )
+    {
+      std::cerr << "ERROR: GetValue() and GetValueAndDerivative() differ." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( CheckFiniteDifferences( analyticPenalty, parameters ) != EXIT_SUCCESS )
+    {
+      return EXIT_FAILURE;
+    }
+
+    /** Initial transforms. An added translation does not change the bending
+     * energy, so the analytic mode must give the result of the B-spline alone.
+     */
+    TranslationTransformType::Pointer          translation = TranslationTransformType::New();
+    TranslationTransformType::OutputVectorType offset;
+    offset.Fill( 3.0 );
+    translation->SetOffset( offset );
+    BSplineTransformType::Pointer initialBSpline = CreateGridBSplineTransform( 3.0, 0.23 );
+
+    const unsigned int numberOfCombinations = 3;
+    const char *       names[ numberOfCombinations ] = {
+      "added translation", "composed translation", "added B-spline"
+    };
+    TransformType * initialTransforms[ numberOfCombinations ] = {
+      translation.GetPointer(), translation.GetPointer(), initialBSpline.GetPointer()
+    };
+    const bool useAddition[ numberOfCombinations ] = { true, false, true };
+    for( unsigned int i = 0; i < numberOfCombinations; ++i )
+    {
+      CombinationTransformType::Pointer combination = CombinationTransformType::New();
+      combination->SetCurrentTransform( bspline );
+      combination->SetInitialTransform( initialTransforms[ i ] );
+      combination->SetUseAddition( useAddition[ i ] );
+
+      PenaltyType::Pointer combinationAnalyticPenalty = CreatePenalty( image, combination, true );
+      PenaltyType::Pointer combinationSampledPenalty  = CreatePenalty( image, combination, false );
+
+      MeasureType    combinationAnalyticValue, combinationSampledValue;
+      DerivativeType combinationAnalyticDerivative, combinationSampledDerivative;
+      combinationAnalyticPenalty->GetValueAndDerivative( parameters,
+        combinationAnalyticValue, combinationAnalyticDerivative );
+      combinationSampledPenalty->GetValueAndDerivative( parameters,
+        combinationSampledValue, combinationSampledDerivative );
+
+      int result = EXIT_SUCCESS;
+      if( i == 0 )
+      {
+        result = CompareExactly( names[ i ], analyticValue, combinationAnalyticValue,
+          analyticDerivative, combinationAnalyticDerivative );
+      }
+      else
+      {
+        result = CompareExactly( names[ i ], combinationSampledValue, combinationAnalyticValue,
+          combinationSampledDerivative, combinationAnalyticDerivative );
+      }
+      if( result != EXIT_SUCCESS )
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -0,0 +1,237 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkRecursiveBSplineTransform.h"
+#include "itkAdvancedEuler3DTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+
+#include "itkMultiThreader.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <vector>
+#include <string>
+
+/** This test checks that the batched, multi-threaded point transformation
+ * used by transformix gives exactly the same points as calling
+ * TransformPoint() for every point serially. It is run for the B-spline
+ * transforms and for combination transforms (composition and addition),
+ * with 1 and N threads, and for the in-place case (input == output buffer).
+ */
+
+//-------------------------------------------------------------------------------------
+
+const unsigned int Dimension   = 3;
+const unsigned int SplineOrder = 3;
+typedef double CoordinateRepresentationType;
+
+typedef itk::AdvancedTransform<
+  CoordinateRepresentationType, Dimension, Dimension >        AdvancedTransformType;
+typedef itk::AdvancedBSplineDeformableTransform<
+  CoordinateRepresentationType, Dimension, SplineOrder >      BSplineTransformType;
+typedef itk::RecursiveBSplineTransform<
+  CoordinateRepresentationType, Dimension, SplineOrder >      RecursiveBSplineTransformType;
+typedef itk::AdvancedEuler3DTransform<
+  CoordinateRepresentationType >                              EulerTransformType;
+typedef itk::AdvancedCombinationTransform<
+  CoordinateRepresentationType, Dimension >                   CombinationTransformType;
+
+typedef AdvancedTransformType::InputPointType           InputPointType;
+typedef AdvancedTransformType::OutputPointType          OutputPointType;
+typedef AdvancedTransformType::InputPointContainerType  InputPointContainerType;
+typedef AdvancedTransformType::OutputPointContainerType OutputPointContainerType;
+typedef AdvancedTransformType::ParametersType           ParametersType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator MersenneTwisterType;
+
+//-------------------------------------------------------------------------------------
+
+/** Setup a B-spline grid and random coefficients. */
+template< class TBSplineTransform >
+void
+SetupBSplineTransform( TBSplineTransform * transform, ParametersType & parameters )
+{
+  typename TBSplineTransform::RegionType    gridRegion;
+  typename TBSplineTransform::SizeType      gridSize;
+  typename TBSplineTransform::SpacingType   gridSpacing;
+  typename TBSplineTransform::OriginType    gridOrigin;
+  typename TBSplineTransform::DirectionType gridDirection;
+  gridSize[ 0 ]    = 14; gridSize[ 1 ] = 13; gridSize[ 2 ] = 11;
+  gridSpacing[ 0 ] = 10.78; gridSpacing[ 1 ] = 11.21; gridSpacing[ 2 ] = 11.86;
+  gridOrigin[ 0 ]  = -37.67; gridOrigin[ 1 ] = -39.94; gridOrigin[ 2 ] = -44.23;
+  gridRegion.SetSize( gridSize );
+  gridDirection.SetIdentity();
+  gridDirection( 0, 1 ) = 0.02; gridDirection( 1, 2 ) = 0.07; gridDirection( 2, 0 ) = 0.09;
+
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridDirection( gridDirection );
+
+  /** Random coefficients of a few millimeters. */
+  MersenneTwisterType::Pointer randomGenerator = MersenneTwisterType::New();
+  randomGenerator->Initialize( 121212 );
+  parameters.SetSize( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = randomGenerator->GetUniformVariate( -5.0, 5.0 );
+  }
+  transform->SetParameters( parameters );
+
+} // end SetupBSplineTransform()
+
+
+/** Compare the batched and multi-threaded transformation with the serial
+ * TransformPoint(), requiring exact equality.
+ */
+bool
+CompareTransformPoints( const AdvancedTransformType * transform,
+  const InputPointContainerType & inputPoints,
+  const itk::ThreadIdType numberOfThreads,
+  const std::string & name )
+{
+  const std::size_t numberOfPoints = inputPoints.size();
+
+  /** The ground truth: TransformPoint() on every point, serially. */
+  OutputPointContainerType serialPoints( numberOfPoints );
+  for( std::size_t i = 0; i < numberOfPoints; ++i )
+  {
+    serialPoints[ i ] = transform->TransformPoint( inputPoints[ i ] );
+  }
+
+  /** Multi-threaded, with 1 and N threads. */
+  itk::ThreadIdType threadCounts[ 2 ] = { 1, numberOfThreads };
+  for( unsigned int t = 0; t < 2; ++t )
+  {
+    OutputPointContainerType threadedPoints;
+    transform->TransformPointsMultiThreaded( inputPoints, threadedPoints, threadCounts[ t ] );
+    if( threadedPoints.size() != numberOfPoints )
+    {
+      std::cerr << "ERROR: " << name << ": wrong number of output points." << std::endl;
+      return false;
+    }
+    for( std::size_t i = 0; i < numberOfPoints; ++i )
+    {
+      if( threadedPoints[ i ] != serialPoints[ i ] )
+      {
+        std::cerr << "ERROR: " << name << ", " << threadCounts[ t ]
+                  << " threads: point " << i << " is " << threadedPoints[ i ]
+                  << " instead of " << serialPoints[ i ] << std::endl;
+        return false;
+      }
+    }
+  }
+
+  /** In place: input and output are the same buffer. */
+  OutputPointContainerType inPlacePoints( inputPoints.begin(), inputPoints.end() );
+  transform->TransformPoints( &inPlacePoints[ 0 ], &inPlacePoints[ 0 ], numberOfPoints );
+  for( std::size_t i = 0; i < numberOfPoints; ++i )
+  {
+    if( inPlacePoints[ i ] != serialPoints[ i ] )
+    {
+      std::cerr << "ERROR: " << name << ", in place: point " << i << " is "
+                << inPlacePoints[ i ] << " instead of " << serialPoints[ i ] << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << name << ": OK" << std::endl;
+  return true;
+
+} // end CompareTransformPoints()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** An odd number of points, so that the blocks per thread differ. Some
+   * points lie outside the valid region of the B-spline grid.
+   */
+  const std::size_t numberOfPoints = 10007;
+  MersenneTwisterType::Pointer randomGenerator = MersenneTwisterType::New();
+  randomGenerator->Initialize( 424242 );
+  InputPointContainerType inputPoints( numberOfPoints );
+  for( std::size_t i = 0; i < numberOfPoints; ++i )
+  {
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      inputPoints[ i ][ j ] = randomGenerator->GetUniformVariate( -50.0, 150.0 );
+    }
+  }
+
+  itk::ThreadIdType numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  if( numberOfThreads < 2 ) { numberOfThreads = 2; }
+  std::cout << "Number of threads: " << numberOfThreads << std::endl;
+
+  /** The B-spline transforms. */
+  ParametersType                 bsplineParameters;
+  BSplineTransformType::Pointer  bsplineTransform = BSplineTransformType::New();
+  SetupBSplineTransform( bsplineTransform.GetPointer(), bsplineParameters );
+
+  ParametersType                         recursiveParameters;
+  RecursiveBSplineTransformType::Pointer recursiveTransform = RecursiveBSplineTransformType::New();
+  SetupBSplineTransform( recursiveTransform.GetPointer(), recursiveParameters );
+
+  /** An initial transform for the combinations. */
+  EulerTransformType::Pointer eulerTransform = EulerTransformType::New();
+  EulerTransformType::InputPointType center;
+  center[ 0 ] = 30.0; center[ 1 ] = 20.0; center[ 2 ] = 10.0;
+  EulerTransformType::OutputVectorType translation;
+  translation[ 0 ] = 3.1; translation[ 1 ] = -2.2; translation[ 2 ] = 1.3;
+  eulerTransform->SetCenter( center );
+  eulerTransform->SetRotation( 0.05, -0.03, 0.1 );
+  eulerTransform->SetTranslation( translation );
+
+  CombinationTransformType::Pointer composition = CombinationTransformType::New();
+  composition->SetInitialTransform( eulerTransform );
+  composition->SetCurrentTransform( recursiveTransform );
+  composition->SetUseComposition( true );
+
+  CombinationTransformType::Pointer addition = CombinationTransformType::New();
+  addition->SetInitialTransform( eulerTransform );
+  addition->SetCurrentTransform( bsplineTransform );
+  addition->SetUseAddition( true );
+
+  /** A combination of combinations, as transformix builds for a chain of
+   * transform parameter files.
+   */
+  CombinationTransformType::Pointer chain = CombinationTransformType::New();
+  chain->SetInitialTransform( composition );
+  chain->SetCurrentTransform( bsplineTransform );
+  chain->SetUseComposition( true );
+
+  bool success = true;
+  success &= CompareTransformPoints( bsplineTransform, inputPoints, numberOfThreads,
+    "AdvancedBSplineDeformableTransform" );
+  success &= CompareTransformPoints( recursiveTransform, inputPoints, numberOfThreads,
+    "RecursiveBSplineTransform" );
+  success &= CompareTransformPoints( composition, inputPoints, numberOfThreads,
+    "AdvancedCombinationTransform (composition)" );
+  success &= CompareTransformPoints( addition, inputPoints, numberOfThreads,
+    "AdvancedCombinationTransform (addition)" );
+  success &= CompareTransformPoints( chain, inputPoints, numberOfThreads,
+    "AdvancedCombinationTransform (chain)" );
+
+  if( !success )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
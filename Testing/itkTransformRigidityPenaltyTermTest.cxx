@@ -0,0 +1,449 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMetricTestHelper.h"
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkNeighborhoodOperatorImageFilter.h"
+#include "vnl/vnl_det.h"
+#include "vnl/vnl_matrix_fixed.h"
+
+//-------------------------------------------------------------------------------------
+
+/** This test checks the fused, multi-threaded filtering of the
+ * TransformRigidityPenaltyTerm. The linearity, orthonormality and properness
+ * values are compared with an evaluation that filters the B-spline
+ * coefficients with a NeighborhoodOperatorImageFilter per 1D kernel of the
+ * operators of each condition. On a deformed B-spline with fixed and moving
+ * rigidity images, it also checks that the results are identical for 1 and
+ * N threads, with and without the worker thread pool, and that the gradient
+ * magnitude of a condition does not depend on whether it is calculated.
+ */
+
+using namespace MetricTestHelper;
+
+typedef itk::TransformRigidityPenaltyTerm< ImageType, double > PenaltyType;
+typedef PenaltyType::RigidityImageType                         RigidityImageType;
+typedef PenaltyType::NeighborhoodType                          NeighborhoodType;
+typedef BSplineTransformType::ImageType                        CoefficientImageType;
+
+/** The results of an evaluation. */
+struct ResultType
+{
+  MeasureType    m_Value;
+  MeasureType    m_ValueOnly;
+  MeasureType    m_ConditionValues[ 3 ];
+  MeasureType    m_GradientMagnitudes[ 3 ];
+  DerivativeType m_Derivative;
+};
+
+/** Create a rigidity image on the grid of the fixed image, with a smooth
+ * pattern of rigidity coefficients between 0 and 1.
+ */
+RigidityImageType::Pointer
+CreateRigidityImage( const ImageType * fixedImage, const double frequency )
+{
+  typedef itk::ImageRegionIteratorWithIndex< RigidityImageType > IteratorType;
+  RigidityImageType::Pointer image = RigidityImageType::New();
+  image->CopyInformation( fixedImage );
+  image->SetRegions( fixedImage->GetLargestPossibleRegion() );
+  image->Allocate();
+
+  IteratorType it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    RigidityImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double s = std::sin( frequency * point[ 0 ] ) * std::cos( frequency * point[ 1 ] );
+    it.Set( vnl_math_max( 0.0, s ) );
+  }
+
+  return image;
+
+} // end CreateRigidityImage()
+
+
+/** Create and initialize a penalty term, with rigidity images if given. */
+PenaltyType::Pointer
+CreatePenalty( ImageType * fixedImage, ImageType * movingImage, TransformType * transform,
+  RigidityImageType * fixedRigidityImage, RigidityImageType * movingRigidityImage )
+{
+  PenaltyType::Pointer penalty = PenaltyType::New();
+  SetupMetric( penalty, fixedImage, movingImage, transform, 1 );
+  if( fixedRigidityImage && movingRigidityImage )
+  {
+    penalty->SetFixedRigidityImage( fixedRigidityImage );
+    penalty->SetMovingRigidityImage( movingRigidityImage );
+    penalty->SetUseFixedRigidityImage( true );
+    penalty->SetUseMovingRigidityImage( true );
+  }
+  else
+  {
+    penalty->SetUseFixedRigidityImage( false );
+    penalty->SetUseMovingRigidityImage( false );
+  }
+  penalty->SetDilateRigidityImages( false );
+  penalty->SetLinearityConditionWeight( 1.0 );
+  penalty->SetOrthonormalityConditionWeight( 0.5 );
+  penalty->SetPropernessConditionWeight( 2.0 );
+  penalty->Initialize();
+
+  return penalty;
+
+} // end CreatePenalty()
+
+
+/** Evaluate a penalty term. */
+ResultType
+Evaluate( const PenaltyType * penalty, const ParametersType & parameters )
+{
+  ResultType result;
+  result.m_ValueOnly = penalty->GetValue( parameters );
+  penalty->GetValueAndDerivative( parameters, result.m_Value, result.m_Derivative );
+  result.m_ConditionValues[ 0 ]    = penalty->GetLinearityConditionValue();
+  result.m_ConditionValues[ 1 ]    = penalty->GetOrthonormalityConditionValue();
+  result.m_ConditionValues[ 2 ]    = penalty->GetPropernessConditionValue();
+  result.m_GradientMagnitudes[ 0 ] = penalty->GetLinearityConditionGradientMagnitude();
+  result.m_GradientMagnitudes[ 1 ] = penalty->GetOrthonormalityConditionGradientMagnitude();
+  result.m_GradientMagnitudes[ 2 ] = penalty->GetPropernessConditionGradientMagnitude();
+
+  return result;
+
+} // end Evaluate()
+
+
+/** Create the 1D kernels of one of the operators A to I. Along each
+ * dimension the kernel is the B-spline smoother 1/6 [1 4 1], except along
+ * the dimensions that the operator differentiates: A, B and C take the
+ * first derivative 1/2 [-1 0 1] along x, y and z, D, E and F the second
+ * derivative 1/2 [1 -2 1], and G, H and I the first derivative along xy, xz
+ * and yz.
+ */
+std::vector< NeighborhoodType >
+CreateSeparableOperator( const char name, const CoefficientImageType::SpacingType & s )
+{
+  std::vector< NeighborhoodType > kernels( Dimension );
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    NeighborhoodType::SizeType radius;
+    radius.Fill( 0 );
+    radius[ d ] = 1;
+    kernels[ d ].SetRadius( radius );
+    kernels[ d ][ 0 ] = 1.0 / 6.0; kernels[ d ][ 1 ] = 4.0 / 6.0; kernels[ d ][ 2 ] = 1.0 / 6.0;
+  }
+
+  int    first[ 2 ] = { -1, -1 };
+  int    second     = -1;
+  double scale      = 1.0;
+  switch( name )
+  {
+    case 'A': first[ 0 ] = 0; scale = 1.0 / s[ 0 ]; break;
+    case 'B': first[ 0 ] = 1; scale = 1.0 / s[ 1 ]; break;
+    case 'C': first[ 0 ] = 2; scale = 1.0 / s[ 2 ]; break;
+    case 'D': second = 0; scale = 1.0 / ( s[ 0 ] * s[ 0 ] ); break;
+    case 'E': second = 1; scale = 1.0 / ( s[ 1 ] * s[ 1 ] ); break;
+    case 'F': second = 2; scale = 1.0 / ( s[ 2 ] * s[ 2 ] ); break;
+    case 'G': first[ 0 ] = 0; first[ 1 ] = 1; scale = 1.0 / ( s[ 0 ] * s[ 1 ] ); break;
+    case 'H': first[ 0 ] = 0; first[ 1 ] = 2; scale = 1.0 / ( s[ 0 ] * s[ 2 ] ); break;
+    case 'I': first[ 0 ] = 1; first[ 1 ] = 2; scale = 1.0 / ( s[ 1 ] * s[ 2 ] ); break;
+  }
+  for( unsigned int j = 0; j < 2; ++j )
+  {
+    if( first[ j ] < 0 ) { continue; }
+    NeighborhoodType & kernel = kernels[ first[ j ] ];
+    kernel[ 0 ] = -0.5 * scale; kernel[ 1 ] = 0.0; kernel[ 2 ] = 0.5 * scale;
+  }
+  if( second >= 0 )
+  {
+    NeighborhoodType & kernel = kernels[ second ];
+    kernel[ 0 ] = 0.5 * scale; kernel[ 1 ] = -1.0 * scale; kernel[ 2 ] = 0.5 * scale;
+  }
+
+  return kernels;
+
+} // end CreateSeparableOperator()
+
+
+/** Filter an image with the 1D kernels of an operator, one dimension after
+ * another, with the zero flux Neumann boundary condition of the filter.
+ */
+CoefficientImageType::Pointer
+FilterSeparable( const CoefficientImageType * image, const std::vector< NeighborhoodType > & kernels )
+{
+  typedef itk::NeighborhoodOperatorImageFilter<
+    CoefficientImageType, CoefficientImageType > FilterType;
+
+  CoefficientImageType::Pointer filtered = const_cast< CoefficientImageType * >( image );
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetOperator( kernels[ d ] );
+    filter->SetInput( filtered );
+    filter->Update();
+    filtered = filter->GetOutput();
+    filtered->DisconnectPipeline();
+  }
+
+  return filtered;
+
+} // end FilterSeparable()
+
+
+/** Compute the linearity, orthonormality and properness values for rigidity
+ * coefficients that are all 1. With the matrix M = I + J, where the column p
+ * of the Jacobian J holds the coefficients filtered with operator A, B or C:
+ * - linearity: the sum of the squared coefficients filtered with D to I;
+ * - orthonormality: the sum of ( M'M - I )_pq^2 over p <= q;
+ * - properness: ( det M - 1 )^2.
+ */
+void
+ComputeReferenceConditionValues( const BSplineTransformType * transform,
+  MeasureType conditionValues[ 3 ] )
+{
+  const CoefficientImageType::Pointer *  coefficientImages = transform->GetCoefficientImages();
+  const CoefficientImageType::SpacingType spacing           = coefficientImages[ 0 ]->GetSpacing();
+  const itk::SizeValueType                numberOfCoefficients
+    = coefficientImages[ 0 ]->GetLargestPossibleRegion().GetNumberOfPixels();
+
+  const char operatorNames[ 9 ] = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I' };
+  std::vector< std::vector< CoefficientImageType::Pointer > > filtered( 9 );
+  for( unsigned int o = 0; o < 9; ++o )
+  {
+    const std::vector< NeighborhoodType > kernels = CreateSeparableOperator( operatorNames[ o ], spacing );
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      filtered[ o ].push_back( FilterSeparable( coefficientImages[ i ], kernels ) );
+    }
+  }
+
+  for( unsigned int c = 0; c < 3; ++c )
+  {
+    conditionValues[ c ] = 0.0;
+  }
+  for( itk::SizeValueType v = 0; v < numberOfCoefficients; ++v )
+  {
+    vnl_matrix_fixed< double, Dimension, Dimension > M;
+    for( unsigned int k = 0; k < Dimension; ++k )
+    {
+      for( unsigned int p = 0; p < Dimension; ++p )
+      {
+        M( k, p ) = ( k == p ? 1.0 : 0.0 ) + filtered[ p ][ k ]->GetBufferPointer()[ v ];
+      }
+      for( unsigned int o = 3; o < 9; ++o )
+      {
+        const double f = filtered[ o ][ k ]->GetBufferPointer()[ v ];
+        conditionValues[ 0 ] += f * f;
+      }
+    }
+    for( unsigned int p = 0; p < Dimension; ++p )
+    {
+      for( unsigned int q = p; q < Dimension; ++q )
+      {
+        double product = p == q ? -1.0 : 0.0;
+        for( unsigned int k = 0; k < Dimension; ++k )
+        {
+          product += M( k, p ) * M( k, q );
+        }
+        conditionValues[ 1 ] += product * product;
+      }
+    }
+    const double determinant = vnl_det( M ) - 1.0;
+    conditionValues[ 2 ] += determinant * determinant;
+  }
+
+  /** The condition values are normalized by the sum of the rigidity coefficients. */
+  for( unsigned int c = 0; c < 3; ++c )
+  {
+    conditionValues[ c ] /= static_cast< double >( numberOfCoefficients );
+  }
+
+} // end ComputeReferenceConditionValues()
+
+
+/** Check that the condition values equal the reference values. The fused
+ * filtering adds in another order, so only the last bits may differ.
+ */
+int
+CompareToReference( const MeasureType referenceValues[ 3 ], const ResultType & result )
+{
+  const char * conditionNames[ 3 ] = { "linearity", "orthonormality", "properness" };
+  for( unsigned int c = 0; c < 3; ++c )
+  {
+    const double tolerance = 1e-10 * ( 1.0 + std::abs( referenceValues[ c ] ) );
+    if( !( std::abs( referenceValues[ c ] - result.m_ConditionValues[ c ] ) <= tolerance ) )
+    {
+      std::cerr << "ERROR: the " << conditionNames[ c ] << " condition value "
+                << result.m_ConditionValues[ c ] << " differs from the reference "
+                << referenceValues[ c ] << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** The value is the weighted sum of the condition values. */
+  const MeasureType value = 1.0 * referenceValues[ 0 ]
+    + 0.5 * referenceValues[ 1 ] + 2.0 * referenceValues[ 2 ];
+  if( !( std::abs( value - result.m_Value ) <= 1e-10 * ( 1.0 + std::abs( value ) ) )
+    || result.m_ValueOnly != result.m_Value )
+  {
+    std::cerr << "ERROR: the value " << result.m_Value << " (GetValue(): "
+              << result.m_ValueOnly << ") differs from the reference " << value << "." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end CompareToReference()
+
+
+/** Check that two evaluations of the fused filtering are identical. */
+int
+CompareExactly( const std::string & label, const ResultType & serial, const ResultType & result )
+{
+  bool equal = serial.m_Value == result.m_Value
+    && serial.m_ValueOnly == result.m_ValueOnly
+    && serial.m_Derivative == result.m_Derivative;
+  for( unsigned int i = 0; i < 3; ++i )
+  {
+    equal &= serial.m_ConditionValues[ i ] == result.m_ConditionValues[ i ];
+    equal &= serial.m_GradientMagnitudes[ i ] == result.m_GradientMagnitudes[ i ];
+  }
+  if( !equal )
+  {
+    std::cerr << "ERROR: the results " << label
+              << " differ from the single-threaded results." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end CompareExactly()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify a 3D input image." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ImageType::Pointer fixedImage, movingImage;
+  if( !ReadTestImages( argv[ 1 ], LinearRemapping, fixedImage, movingImage ) )
+  {
+    return EXIT_FAILURE;
+  }
+  BSplineTransformType::Pointer transform = CreateBSplineTransform( fixedImage, 4.0 );
+  RigidityImageType::Pointer    fixedRigidityImage  = CreateRigidityImage( fixedImage, 0.05 );
+  RigidityImageType::Pointer    movingRigidityImage = CreateRigidityImage( fixedImage, 0.08 );
+
+  /** Two deformations, so that reusing the buffers between evaluations is
+   * checked too.
+   */
+  std::vector< ParametersType > parameters( 2, transform->GetParameters() );
+  for( unsigned int i = 0; i < parameters[ 1 ].GetSize(); ++i )
+  {
+    parameters[ 1 ][ i ] = 2.0 * std::cos( 0.21 * i );
+  }
+
+  try
+  {
+    /** Without rigidity images all rigidity coefficients are 1, so the
+     * condition values can be computed from the filtered coefficients alone.
+     */
+    PenaltyType::Pointer uniformPenalty
+      = CreatePenalty( fixedImage, movingImage, transform, NULL, NULL );
+    uniformPenalty->SetUseMultiThread( true );
+    uniformPenalty->SetNumberOfThreads( 4 );
+
+    /** The fused filtering single-threaded, with 1 and 4 threads, and with 4
+     * threads spawned by the metric threader instead of the pool.
+     */
+    const unsigned int numberOfPenalties = 4;
+    const char *       labels[ numberOfPenalties ] = {
+      "single-threaded", "with 1 thread", "with 4 threads", "with 4 threads without the pool"
+    };
+    std::vector< PenaltyType::Pointer > penalties( numberOfPenalties );
+    for( unsigned int i = 0; i < numberOfPenalties; ++i )
+    {
+      penalties[ i ] = CreatePenalty(
+        fixedImage, movingImage, transform, fixedRigidityImage, movingRigidityImage );
+    }
+    penalties[ 0 ]->SetUseMultiThread( false );
+    penalties[ 1 ]->SetUseMultiThread( true );
+    penalties[ 1 ]->SetNumberOfThreads( 1 );
+    penalties[ 2 ]->SetUseMultiThread( true );
+    penalties[ 2 ]->SetNumberOfThreads( 4 );
+    penalties[ 3 ]->SetUseMultiThread( true );
+    penalties[ 3 ]->SetNumberOfThreads( 4 );
+    penalties[ 3 ]->SetUseThreadPool( false );
+
+    /** A penalty that does not calculate the properness condition still
+     * reports its gradient magnitude.
+     */
+    PenaltyType::Pointer partialPenalty = CreatePenalty(
+      fixedImage, movingImage, transform, fixedRigidityImage, movingRigidityImage );
+    partialPenalty->SetUseMultiThread( false );
+    partialPenalty->SetUsePropernessCondition( false );
+    partialPenalty->SetCalculatePropernessCondition( false );
+
+    for( unsigned int p = 0; p < parameters.size(); ++p )
+    {
+      const ResultType uniformResult = Evaluate( uniformPenalty.GetPointer(), parameters[ p ] );
+      MeasureType      referenceValues[ 3 ];
+      transform->SetParameters( parameters[ p ] );
+      ComputeReferenceConditionValues( transform, referenceValues );
+      if( CompareToReference( referenceValues, uniformResult ) != EXIT_SUCCESS )
+      {
+        return EXIT_FAILURE;
+      }
+
+      const ResultType serialResult = Evaluate( penalties[ 0 ].GetPointer(), parameters[ p ] );
+      for( unsigned int i = 1; i < numberOfPenalties; ++i )
+      {
+        const ResultType result = Evaluate( penalties[ i ].GetPointer(), parameters[ p ] );
+        if( CompareExactly( labels[ i ], serialResult, result ) != EXIT_SUCCESS )
+        {
+          return EXIT_FAILURE;
+        }
+      }
+
+      const ResultType partialResult = Evaluate( partialPenalty.GetPointer(), parameters[ p ] );
+      if( partialResult.m_ConditionValues[ 2 ] != 0.0
+        || partialResult.m_GradientMagnitudes[ 2 ] != serialResult.m_GradientMagnitudes[ 2 ] )
+      {
+        std::cerr << "ERROR: the properness condition value "
+                  << partialResult.m_ConditionValues[ 2 ] << " is not 0, or its gradient magnitude "
+                  << partialResult.m_GradientMagnitudes[ 2 ] << " differs from "
+                  << serialResult.m_GradientMagnitudes[ 2 ]
+                  << " when the condition is not calculated." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
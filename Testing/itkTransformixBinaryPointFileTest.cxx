@@ -0,0 +1,241 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkTransformixBinaryPointFile.h"
+#include "itkTransformixInputPointFileReader.h"
+#include "itkPointSet.h"
+#include "itkDefaultStaticMeshTraits.h"
+
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+//-------------------------------------------------------------------------------------
+
+/** Write a binary point file, read it back with the memory mapped reader
+ * and with the transformix input point file reader, and compare.
+ */
+int
+WriteAndReadPoints( const std::string & fileName, const unsigned int componentSize )
+{
+  const unsigned int    Dimension      = 3;
+  const unsigned long   numberOfPoints = 100003;
+  std::vector< double > points( numberOfPoints * Dimension );
+  for( unsigned long i = 0; i < points.size(); ++i )
+  {
+    /** Values that are exactly representable as float. */
+    points[ i ] = static_cast< double >( i % 1024 ) * 0.25 - 100.0;
+  }
+
+  /** Write. */
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary );
+  itk::TransformixBinaryPointFile::WriteHeader(
+    file, Dimension, false, componentSize, numberOfPoints );
+  itk::TransformixBinaryPointFile::WritePoints(
+    file, &points[ 0 ], points.size(), componentSize );
+  file.close();
+
+  /** Read in chunks. */
+  if( !itk::TransformixBinaryPointFile::IsBinaryPointFile( fileName ) )
+  {
+    std::cerr << "ERROR: the written file is not recognized as binary point file." << std::endl;
+    return EXIT_FAILURE;
+  }
+  itk::TransformixBinaryPointFile::Pointer pointFile = itk::TransformixBinaryPointFile::New();
+  pointFile->Open( fileName );
+  if( pointFile->GetDimension() != Dimension
+    || pointFile->GetNumberOfPoints() != numberOfPoints
+    || pointFile->GetPointsAreIndices()
+    || pointFile->GetComponentSize() != componentSize )
+  {
+    std::cerr << "ERROR: the header is not read correctly." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const unsigned long   chunkSize = 1000;
+  std::vector< double > buffer( chunkSize * Dimension );
+  for( unsigned long first = 0; first < numberOfPoints; first += chunkSize )
+  {
+    const unsigned long count = std::min( chunkSize, numberOfPoints - first );
+    pointFile->ReadPoints( first, count, &buffer[ 0 ] );
+    for( unsigned long i = 0; i < count * Dimension; ++i )
+    {
+      if( buffer[ i ] != points[ first * Dimension + i ] )
+      {
+        std::cerr << "ERROR: point " << first + i / Dimension
+                  << " is not read correctly." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  /** Reading outside the file should throw. */
+  bool thrown = false;
+  try
+  {
+    pointFile->ReadPoints( numberOfPoints - 1, 2, &buffer[ 0 ] );
+  }
+  catch( itk::ExceptionObject & )
+  {
+    thrown = true;
+  }
+  pointFile->Close();
+  if( !thrown )
+  {
+    std::cerr << "ERROR: reading outside the file did not throw." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Read with the transformix input point file reader. */
+  typedef itk::DefaultStaticMeshTraits< bool, Dimension, Dimension, double > MeshTraitsType;
+  typedef itk::PointSet< bool, Dimension, MeshTraitsType >                   PointSetType;
+  typedef itk::TransformixInputPointFileReader< PointSetType >               ReaderType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName.c_str() );
+  reader->Update();
+  if( !reader->GetIsBinary() || reader->GetNumberOfPoints() != numberOfPoints
+    || reader->GetOutput()->GetNumberOfPoints() != numberOfPoints )
+  {
+    std::cerr << "ERROR: the reader did not read the binary file correctly." << std::endl;
+    return EXIT_FAILURE;
+  }
+  for( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    const PointSetType::PointType point = reader->GetOutput()->GetPoint( i );
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      if( point[ j ] != points[ i * Dimension + j ] )
+      {
+        std::cerr << "ERROR: the reader read point " << i << " incorrectly." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+
+} // end WriteAndReadPoints()
+
+
+/** Write a header with the given fields, followed by some coordinates, and
+ * check that opening it throws an exception instead of crashing.
+ */
+bool
+OpenMalformedFileThrows( const std::string & fileName, const std::string & description,
+  const unsigned int dimension, const unsigned int componentSize,
+  const unsigned long numberOfPoints )
+{
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary );
+  itk::TransformixBinaryPointFile::WriteHeader(
+    file, dimension, false, componentSize, numberOfPoints );
+  const std::vector< char > payload( 64, 0 );
+  file.write( &payload[ 0 ], payload.size() );
+  file.close();
+
+  itk::TransformixBinaryPointFile::Pointer pointFile = itk::TransformixBinaryPointFile::New();
+  bool thrown = false;
+  try
+  {
+    pointFile->Open( fileName );
+  }
+  catch( itk::ExceptionObject & )
+  {
+    thrown = true;
+  }
+  if( !thrown )
+  {
+    std::cerr << "ERROR: opening a file with " << description
+              << " did not throw." << std::endl;
+  }
+  return thrown;
+
+} // end OpenMalformedFileThrows()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify an output directory." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string fileName = std::string( argv[ 1 ] ) + "/TransformixBinaryPointFileTest.bin";
+
+  try
+  {
+    if( WriteAndReadPoints( fileName, 8 ) != EXIT_SUCCESS ) { return EXIT_FAILURE; }
+    if( WriteAndReadPoints( fileName, 4 ) != EXIT_SUCCESS ) { return EXIT_FAILURE; }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Malformed headers should be rejected by Open(). A dimension of 2^29
+   * with 8 byte coordinates makes the point size 2^32, which overflowed to
+   * zero in 32 bit arithmetic.
+   */
+  bool rejected = true;
+  rejected &= OpenMalformedFileThrows( fileName, "a point size of 2^32 bytes", 1u << 29, 8, 1 );
+  rejected &= OpenMalformedFileThrows( fileName, "dimension 0", 0, 8, 1 );
+  rejected &= OpenMalformedFileThrows( fileName, "dimension 17", 17, 4, 0 );
+  rejected &= OpenMalformedFileThrows( fileName, "component size 2", 3, 2, 1 );
+  rejected &= OpenMalformedFileThrows( fileName, "component size 0", 3, 0, 1 );
+  rejected &= OpenMalformedFileThrows( fileName, "too many points", 3, 8, 3 );
+  rejected &= OpenMalformedFileThrows( fileName, "4294967295 points", 3, 4, 4294967295ul );
+  if( !rejected ) { return EXIT_FAILURE; }
+
+  /** A file that is shorter than the header. */
+  std::ofstream truncatedFile( fileName.c_str(), std::ios::out | std::ios::binary );
+  truncatedFile.write( "ELXPOINT", 8 );
+  truncatedFile.close();
+  itk::TransformixBinaryPointFile::Pointer truncatedPointFile
+    = itk::TransformixBinaryPointFile::New();
+  bool thrown = false;
+  try
+  {
+    truncatedPointFile->Open( fileName );
+  }
+  catch( itk::ExceptionObject & )
+  {
+    thrown = true;
+  }
+  if( !thrown )
+  {
+    std::cerr << "ERROR: opening a truncated header did not throw." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** A text file should not be recognized as binary point file. */
+  std::ofstream textFile( fileName.c_str() );
+  textFile << "point\n1\n1.0 2.0 3.0\n";
+  textFile.close();
+  if( itk::TransformixBinaryPointFile::IsBinaryPointFile( fileName ) )
+  {
+    std::cerr << "ERROR: a text point file is recognized as binary." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
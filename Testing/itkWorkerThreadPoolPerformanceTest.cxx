@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkWorkerThreadPool.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itksys/SystemTools.hxx"
+
+// Report timings
+#include "itkTimeProbe.h"
+
+#include <vector>
+#include <iomanip>
+#include <algorithm>
+
+//-------------------------------------------------------------------------------------
+
+/** A job with a tunable amount of work per thread, mimicking a small-sample
+ * metric iteration: each thread sums a part of a vector.
+ */
+struct JobType
+{
+  std::vector< double > m_Data;
+  std::vector< double > m_ThreadSums;
+};
+
+ITK_THREAD_RETURN_TYPE
+JobThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  const itk::ThreadIdType threadID    = infoStruct->ThreadID;
+  const itk::ThreadIdType nrOfThreads = infoStruct->NumberOfThreads;
+  JobType *               job         = static_cast< JobType * >( infoStruct->UserData );
+
+  const std::size_t size    = job->m_Data.size();
+  const std::size_t subSize = ( size + nrOfThreads - 1 ) / nrOfThreads;
+  const std::size_t jmin    = threadID * subSize;
+  const std::size_t jmax    = std::min( size, ( threadID + 1 ) * subSize );
+
+  double sum = 0.0;
+  for( std::size_t j = jmin; j < jmax; ++j )
+  {
+    sum += job->m_Data[ j ];
+  }
+  job->m_ThreadSums[ threadID ] = sum;
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end JobThreaderCallback()
+
+
+/** Sum the per-thread results. */
+double
+GetJobSum( const JobType & job, const itk::ThreadIdType nrOfThreads )
+{
+  double sum = 0.0;
+  for( itk::ThreadIdType i = 0; i < nrOfThreads; ++i )
+  {
+    sum += job.m_ThreadSums[ i ];
+  }
+  return sum;
+
+} // end GetJobSum()
+
+
+/** A job that only finishes in time when all its thread ids run at the same
+ * time: every thread waits at a barrier until all threads have arrived.
+ * Serial execution of the thread ids therefore times out.
+ */
+struct BarrierJobType
+{
+  itk::SimpleFastMutexLock m_Lock;
+  itk::ThreadIdType        m_NumberOfArrivedThreads;
+  bool                     m_TimedOut;
+};
+
+ITK_THREAD_RETURN_TYPE
+BarrierThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  const itk::ThreadIdType nrOfThreads = infoStruct->NumberOfThreads;
+  BarrierJobType *        job         = static_cast< BarrierJobType * >( infoStruct->UserData );
+
+  job->m_Lock.Lock();
+  ++job->m_NumberOfArrivedThreads;
+  job->m_Lock.Unlock();
+
+  const double startTime = itksys::SystemTools::GetTime();
+  while( true )
+  {
+    job->m_Lock.Lock();
+    const bool allArrived = job->m_NumberOfArrivedThreads >= nrOfThreads;
+    job->m_Lock.Unlock();
+    if( allArrived ) { break; }
+    if( itksys::SystemTools::GetTime() - startTime > 10.0 )
+    {
+      job->m_Lock.Lock();
+      job->m_TimedOut = true;
+      job->m_Lock.Unlock();
+      break;
+    }
+    itksys::SystemTools::Delay( 1 );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end BarrierThreaderCallback()
+
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  std::cout << std::fixed << std::showpoint << std::setprecision( 4 );
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetUseThreadPool( false );
+  const itk::ThreadIdType nrOfThreads = threader->GetNumberOfThreads();
+
+  itk::WorkerThreadPool::Pointer pool = itk::WorkerThreadPool::GetInstance();
+
+  std::cout << "Number of threads: " << nrOfThreads << "\n" << std::endl;
+
+  /** Work per launch, and the number of launches, mimicking one optimizer
+   * iteration of 2000 ASGD iterations with a few threaded calls each.
+   */
+  std::vector< unsigned int > workSizes;
+  workSizes.push_back( 0 ); workSizes.push_back( 1e3 );
+  workSizes.push_back( 1e4 ); workSizes.push_back( 1e5 );
+  const unsigned int repetitions = 2000;
+
+  for( unsigned int s = 0; s < workSizes.size(); ++s )
+  {
+    JobType job;
+    job.m_Data.assign( workSizes[ s ], 1.0 );
+    job.m_ThreadSums.assign( nrOfThreads, 0.0 );
+    const double expectedSum = static_cast< double >( workSizes[ s ] );
+
+    itk::TimeProbe threaderProbe;
+    itk::TimeProbe poolProbe;
+
+    /** Time launching fresh threads at every call. */
+    threader->SetSingleMethod( JobThreaderCallback, &job );
+    for( unsigned int i = 0; i < repetitions; ++i )
+    {
+      threaderProbe.Start();
+      threader->SingleMethodExecute();
+      threaderProbe.Stop();
+    }
+    if( GetJobSum( job, nrOfThreads ) != expectedSum )
+    {
+      std::cerr << "ERROR: MultiThreader computed a wrong sum." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** Time the persistent pool. */
+    job.m_ThreadSums.assign( nrOfThreads, 0.0 );
+    for( unsigned int i = 0; i < repetitions; ++i )
+    {
+      poolProbe.Start();
+      pool->Execute( JobThreaderCallback, &job, nrOfThreads );
+      poolProbe.Stop();
+    }
+    if( GetJobSum( job, nrOfThreads ) != expectedSum )
+    {
+      std::cerr << "ERROR: WorkerThreadPool computed a wrong sum." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** Report the time per launch, in microseconds. */
+    std::cout << "Work size = " << workSizes[ s ]
+              << ", time per launch [us]:" << std::endl;
+    std::cout << "  MultiThreader:    "
+              << threaderProbe.GetMean() * 1.0e6 << std::endl;
+    std::cout << "  WorkerThreadPool: "
+              << poolProbe.GetMean() * 1.0e6 << std::endl;
+    std::cout << std::endl;
+  }
+
+  /** Check that the pool runs all thread ids concurrently. */
+  BarrierJobType barrierJob;
+  barrierJob.m_NumberOfArrivedThreads = 0;
+  barrierJob.m_TimedOut               = false;
+  pool->Execute( BarrierThreaderCallback, &barrierJob, nrOfThreads );
+  if( barrierJob.m_TimedOut )
+  {
+    std::cerr << "ERROR: WorkerThreadPool did not run the threads concurrently." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Check that a launch on a busy pool does not hang, and that it still
+   * runs on its own threads instead of serially on the caller. While thread 0
+   * of the outer job launches, the workers are claimed by the outer job.
+   */
+  JobType job;
+  job.m_Data.assign( 1000, 1.0 );
+  job.m_ThreadSums.assign( nrOfThreads, 0.0 );
+  barrierJob.m_NumberOfArrivedThreads = 0;
+  barrierJob.m_TimedOut               = false;
+  struct NestedType
+  {
+    static ITK_THREAD_RETURN_TYPE Callback( void * arg )
+    {
+      itk::MultiThreader::ThreadInfoStruct * infoStruct
+        = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+      if( infoStruct->ThreadID == 0 )
+      {
+        itk::WorkerThreadPool::GetInstance()->Execute(
+          BarrierThreaderCallback, infoStruct->UserData, infoStruct->NumberOfThreads );
+      }
+      return ITK_THREAD_RETURN_VALUE;
+    }
+  };
+  pool->Execute( NestedType::Callback, &barrierJob, nrOfThreads );
+  if( nrOfThreads > 1 && barrierJob.m_TimedOut )
+  {
+    std::cerr << "ERROR: a launch on a busy WorkerThreadPool was executed serially." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** The pool must still be usable afterwards. */
+  pool->Execute( JobThreaderCallback, &job, nrOfThreads );
+  if( GetJobSum( job, nrOfThreads ) != 1000.0 )
+  {
+    std::cerr << "ERROR: WorkerThreadPool computed a wrong sum after a nested launch." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main